@@ -24,6 +24,7 @@ check_include_file("netinet/in.h"           HAVE_NETINET_IN_H)
 check_include_file("netdb.h"                HAVE_NETDB_H)
 check_include_file("pwd.h"                  HAVE_PWD_H)
 check_include_file("sys/ioctl.h"            HAVE_SYS_IOCTL_H)
+check_include_file("sys/mman.h"             HAVE_SYS_MMAN_H)
 check_include_file("sys/select.h"           HAVE_SYS_SELECT_H)
 check_include_file("sys/socket.h"           HAVE_SYS_SOCKET_H)
 check_include_file("sys/sockio.h"           HAVE_SYS_SOCKIO_H)
@@ -31,6 +32,9 @@ check_include_file("sys/time.h"             HAVE_SYS_TIME_H)
 check_include_file("sys/utsname.h"          HAVE_SYS_UTSNAME_H)
 check_include_file("sys/wait.h"             HAVE_SYS_WAIT_H)
 check_include_file("unistd.h"               HAVE_UNISTD_H)
+if(ENABLE_USDT)
+	check_include_file("sys/sdt.h"        HAVE_SYS_SDT_H)
+endif()
 
 #
 # On Linux, check for some additional headers, which we need as a
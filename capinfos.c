@@ -1233,7 +1233,10 @@ process_cap_file(const char *filename, gboolean need_separator)
   num_ipv6_addresses = 0;
   num_decryption_secrets = 0;
 
-  /* Tally up data that we need to parse through the file to find */
+  /* Tally up data that we need to parse through the file to find;
+     we only look at the record metadata, so the packet data can be
+     skipped rather than read. */
+  wtap_set_skip_packet_data(cf_info.wth, TRUE);
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
   while (wtap_read(cf_info.wth, &rec, &buf, &err, &err_info, &data_offset))  {
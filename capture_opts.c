@@ -104,6 +104,8 @@ capture_opts_init(capture_options *capture_opts)
     capture_opts->file_packets                    = 0;
     capture_opts->has_ring_num_files              = FALSE;
     capture_opts->ring_num_files                  = RINGBUFFER_MIN_NUM_FILES;
+    capture_opts->ring_prealloc                   = 0;
+    capture_opts->ring_write_behind               = 0;
 
     capture_opts->has_autostop_files              = FALSE;
     capture_opts->autostop_files                  = 1;
@@ -119,6 +121,7 @@ capture_opts_init(capture_options *capture_opts)
     capture_opts->capture_child                   = FALSE;
     capture_opts->print_file_names                = FALSE;
     capture_opts->print_name_to                   = NULL;
+    capture_opts->update_interval                 = DEFAULT_UPDATE_INTERVAL; /* 500 ms */
     capture_opts->compress_type                   = NULL;
 }
 
@@ -253,6 +256,9 @@ capture_opts_log(const char *log_domain, GLogLevelFlags log_level, capture_optio
     g_log(log_domain, log_level, "FilePackets     (%u) : %u", capture_opts->has_file_packets, capture_opts->file_packets);
     g_log(log_domain, log_level, "RingNumFiles    (%u) : %u", capture_opts->has_ring_num_files, capture_opts->ring_num_files);
     g_log(log_domain, log_level, "RingPrintFiles  (%u) : %s", capture_opts->print_file_names, (capture_opts->print_file_names ? capture_opts->print_name_to : ""));
+    g_log(log_domain, log_level, "RingPrealloc        : %u (kB)", capture_opts->ring_prealloc);
+    g_log(log_domain, log_level, "RingWriteBehind     : %u (kB)", capture_opts->ring_write_behind);
+    g_log(log_domain, log_level, "UpdateInterval      : %u (ms)", capture_opts->update_interval);
 
     g_log(log_domain, log_level, "AutostopFiles   (%u) : %u", capture_opts->has_autostop_files, capture_opts->autostop_files);
     g_log(log_domain, log_level, "AutostopPackets (%u) : %u", capture_opts->has_autostop_packets, capture_opts->autostop_packets);
@@ -419,6 +425,10 @@ get_ring_arguments(capture_options *capture_opts, const char *arg)
     } else if (strcmp(arg,"printname") == 0) {
         capture_opts->print_file_names = TRUE;
         capture_opts->print_name_to = g_strdup(p);
+    } else if (strcmp(arg,"prealloc") == 0) {
+        capture_opts->ring_prealloc = get_nonzero_guint32(p, "ring buffer preallocation size");
+    } else if (strcmp(arg,"writebehind") == 0) {
+        capture_opts->ring_write_behind = get_nonzero_guint32(p, "ring buffer write-behind size");
     }
 
     *colonp = ':';    /* put the colon back */
@@ -997,6 +1007,9 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
         }
         capture_opts->compress_type = g_strdup(optarg_str_p);
         break;
+    case LONGOPT_UPDATE_INTERVAL:  /* capture update interval */
+        capture_opts->update_interval = get_positive_int(optarg_str_p, "update interval");
+        break;
     default:
         /* the caller is responsible to send us only the right opt's */
         g_assert_not_reached();
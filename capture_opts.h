@@ -47,6 +47,7 @@ extern "C" {
 #define LONGOPT_LIST_TSTAMP_TYPES LONGOPT_BASE_CAPTURE+2
 #define LONGOPT_SET_TSTAMP_TYPE   LONGOPT_BASE_CAPTURE+3
 #define LONGOPT_COMPRESS_TYPE     LONGOPT_BASE_CAPTURE+4
+#define LONGOPT_UPDATE_INTERVAL   LONGOPT_BASE_CAPTURE+5
 
 /*
  * Options for capturing common to all capturing programs.
@@ -88,7 +89,8 @@ extern "C" {
     {"linktype",              required_argument, NULL, 'y'}, \
     {"list-time-stamp-types", no_argument,       NULL, LONGOPT_LIST_TSTAMP_TYPES}, \
     {"time-stamp-type",       required_argument, NULL, LONGOPT_SET_TSTAMP_TYPE}, \
-    {"compress-type",         required_argument, NULL, LONGOPT_COMPRESS_TYPE},
+    {"compress-type",         required_argument, NULL, LONGOPT_COMPRESS_TYPE}, \
+    {"update-interval",       required_argument, NULL, LONGOPT_UPDATE_INTERVAL},
 
 
 #define OPTSTRING_CAPTURE_COMMON \
@@ -296,6 +298,10 @@ typedef struct capture_options_tag {
     int                file_packets;          /**< Switch file after n packets */
     gboolean           has_ring_num_files;    /**< TRUE if ring num_files specified */
     guint32            ring_num_files;        /**< Number of multiple buffer files */
+    guint32            ring_prealloc;         /**< kB to allocate for each next file
+                                                   ahead of time, or 0 */
+    guint32            ring_write_behind;     /**< kB to write between write-backs and
+                                                   page cache drops, or 0 */
 
     /* autostop conditions */
     gboolean           has_autostop_files;    /**< TRUE if maximum number of capture files
@@ -317,6 +323,10 @@ typedef struct capture_options_tag {
     gboolean           print_file_names;      /**< TRUE if printing names of completed
                                                    files as we close them */
     gchar             *print_name_to;         /**< output file name */
+    guint              update_interval;       /**< Time in milliseconds between the
+                                                   flushes of the capture file and the
+                                                   packet count updates sent to the
+                                                   parent */
 
     /* internally used (don't touch from outside) */
     gboolean           output_to_pipe;        /**< save_file is a pipe (named or stdout) */
@@ -379,6 +389,9 @@ capture_opts_free_interface_t(interface_t *device);
 /* Default capture buffer size in Mbytes. */
 #define DEFAULT_CAPTURE_BUFFER_SIZE 2
 
+/* Default interval in milliseconds between capture updates. */
+#define DEFAULT_UPDATE_INTERVAL 500
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -50,6 +50,20 @@ typedef enum {
   SD_BACKWARD
 } search_direction;
 
+/*
+ * Hit and miss counts of the record cache of a packet provider.
+ */
+typedef struct {
+  guint64 hits;
+  guint64 misses;
+  guint64 evictions;
+  gsize   bytes;                     /* Bytes held, bookkeeping included */
+  guint   records;                   /* Records held */
+} record_cache_stats_t;
+
+struct record_cache;
+struct first_pass_cache;
+
 /*
  * Packet provider for programs using a capture file.
  */
@@ -60,6 +74,7 @@ struct packet_provider_data {
   frame_data  *prev_cap;
   frame_data_sequence *frames;       /* Sequence of frames, if we're keeping that information */
   GTree       *frames_user_comments; /* BST with user comments for frames (key = frame_data) */
+  struct record_cache *rec_cache;    /* Recently read records, if enabled */
 };
 
 typedef struct _capture_file {
@@ -90,6 +105,7 @@ typedef struct _capture_file {
   dfilter_t                  *rfcode;               /* Compiled read filter program */
   dfilter_t                  *dfcode;               /* Compiled display filter program */
   gchar                      *dfilter;              /* Display filter string */
+  GSList                     *dfilter_results;      /* Per-frame results of recent display filters */
   gboolean                    redissecting;         /* TRUE if currently redissecting (cf_redissect_packets) */
   gboolean                    read_lock;            /* TRUE if currently processing a file (cf_read) */
   rescan_type                 redissection_queued;  /* Queued redissection type. */
@@ -123,6 +139,10 @@ typedef struct _capture_file {
 
   gpointer                    window;               /* Top-level window associated with file */
   gulong                      computed_elapsed;     /* Elapsed time to load the file (in msec). */
+  /* first pass */
+  struct first_pass_cache    *fp_cache;             /* On-disk cache of the first pass, if enabled */
+  gboolean                    first_pass_pending;   /* TRUE if the frames were loaded from it undissected */
+  guint32                     first_pass_frames;    /* Frames up to which the first pass has been caught up */
 
   guint32                     cum_bytes;
 } capture_file;
@@ -134,6 +154,22 @@ const char *cap_file_provider_get_interface_description(struct packet_provider_d
 const char *cap_file_provider_get_user_comment(struct packet_provider_data *prov, const frame_data *fd);
 void cap_file_provider_set_user_comment(struct packet_provider_data *prov, frame_data *fd, const char *new_comment);
 
+/*
+ * Records read at random with cap_file_provider_read_record() are kept in
+ * an LRU cache, keyed by frame number, so that dissecting the same frames
+ * again (selecting them, recoloring, following a stream, a tvbuff reading
+ * its bytes back) doesn't read them, and for compressed files inflate them,
+ * again.  The cache holds up to WIRESHARK_RECORD_CACHE_SIZE KiB, 16 MiB by
+ * default; a size of 0 turns it off.
+ *
+ * cap_file_provider_init_record_cache() must be called again, or the cache
+ * freed, whenever prov->wth is replaced.
+ */
+void cap_file_provider_init_record_cache(struct packet_provider_data *prov);
+void cap_file_provider_free_record_cache(struct packet_provider_data *prov);
+gboolean cap_file_provider_read_record(const struct packet_provider_data *prov, guint32 framenum, gint64 file_off, wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+gboolean cap_file_provider_get_record_cache_stats(const struct packet_provider_data *prov, record_cache_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
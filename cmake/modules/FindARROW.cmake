@@ -0,0 +1,62 @@
+#
+# - Find the Apache Arrow and Parquet GLib libraries
+#
+#  ARROW_INCLUDE_DIRS - where to find arrow-glib/arrow-glib.h, etc.
+#  ARROW_LIBRARIES    - List of libraries when using Arrow and Parquet
+#  ARROW_FOUND        - True if arrow-glib and parquet-glib were found
+
+if(NOT WIN32)
+  find_package(PkgConfig)
+  pkg_search_module(PC_ARROW_GLIB arrow-glib)
+  pkg_search_module(PC_PARQUET_GLIB parquet-glib)
+  pkg_search_module(PC_GIO_UNIX gio-unix-2.0)
+endif()
+
+find_path(ARROW_INCLUDE_DIR
+  NAMES arrow-glib/arrow-glib.h
+  HINTS ${PC_ARROW_GLIB_INCLUDE_DIRS}
+)
+
+find_path(PARQUET_GLIB_INCLUDE_DIR
+  NAMES parquet-glib/parquet-glib.h
+  HINTS ${PC_PARQUET_GLIB_INCLUDE_DIRS}
+)
+
+find_library(ARROW_LIBRARY
+  NAMES arrow-glib
+  HINTS ${PC_ARROW_LIBRARY_DIRS}
+)
+
+find_library(PARQUET_GLIB_LIBRARY
+  NAMES parquet-glib
+  HINTS ${PC_PARQUET_GLIB_LIBRARY_DIRS}
+)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(ARROW
+  REQUIRED_VARS ARROW_LIBRARY PARQUET_GLIB_LIBRARY ARROW_INCLUDE_DIR PARQUET_GLIB_INCLUDE_DIR
+  VERSION_VAR   PC_ARROW_GLIB_VERSION
+)
+
+if(ARROW_FOUND)
+  # The GLib bindings pull in arrow, parquet and gio; gio-unix provides
+  # the stream used to write to an already open file descriptor.
+  set(ARROW_INCLUDE_DIRS
+    ${ARROW_INCLUDE_DIR}
+    ${PARQUET_GLIB_INCLUDE_DIR}
+    ${PC_ARROW_GLIB_INCLUDE_DIRS}
+    ${PC_PARQUET_GLIB_INCLUDE_DIRS}
+    ${PC_GIO_UNIX_INCLUDE_DIRS}
+  )
+  list(REMOVE_DUPLICATES ARROW_INCLUDE_DIRS)
+  set(ARROW_LIBRARIES
+    ${ARROW_LIBRARY}
+    ${PARQUET_GLIB_LIBRARY}
+    ${PC_GIO_UNIX_LIBRARIES}
+  )
+else()
+  set(ARROW_INCLUDE_DIRS)
+  set(ARROW_LIBRARIES)
+endif()
+
+mark_as_advanced(ARROW_INCLUDE_DIRS ARROW_LIBRARIES)
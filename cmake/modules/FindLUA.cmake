@@ -17,11 +17,25 @@
 INCLUDE(FindWSWinLibs)
 FindWSWinLibs("lua-5*" "LUA_HINTS")
 
+# LuaJIT implements the Lua 5.1 API, so it is found the same way under its
+# own names.
+if(USE_LUAJIT)
+  set(_lua_include_suffixes include/luajit-2.1 include/luajit-2.0)
+  set(_lua_library_names luajit-5.1 luajit)
+else()
+  set(_lua_include_suffixes)
+  set(_lua_library_names)
+endif()
+
 if(NOT WIN32)
   find_package(PkgConfig)
-  pkg_search_module(LUA lua5.2 lua-5.2 lua52 lua5.1 lua-5.1 lua51)
-  if(NOT LUA_FOUND)
-      pkg_search_module(LUA "lua<=5.2.99")
+  if(USE_LUAJIT)
+    pkg_search_module(LUA luajit)
+  else()
+    pkg_search_module(LUA lua5.2 lua-5.2 lua52 lua5.1 lua-5.1 lua51)
+    if(NOT LUA_FOUND)
+        pkg_search_module(LUA "lua<=5.2.99")
+    endif()
   endif()
 endif()
 
@@ -30,7 +44,7 @@ FIND_PATH(LUA_INCLUDE_DIR lua.h
     "${LUA_INCLUDEDIR}"
     "$ENV{LUA_DIR}"
   ${LUA_HINTS}
-  PATH_SUFFIXES include/lua52 include/lua5.2 include/lua-5.2 include/lua51 include/lua5.1 include/lua-5.1 include/lua include
+  PATH_SUFFIXES ${_lua_include_suffixes} include/lua52 include/lua5.2 include/lua-5.2 include/lua51 include/lua5.1 include/lua-5.1 include/lua include
   PATHS
   ~/Library/Frameworks
   /Library/Frameworks
@@ -50,12 +64,12 @@ if(LUA_INCLUDE_DIR AND EXISTS "${LUA_INCLUDE_DIR}/lua.h")
   endif()
 endif()
 string( REGEX REPLACE ".*[/\\]lua(.+)$" "\\1" LUA_INC_SUFFIX "${LUA_INCLUDE_DIR}" )
-if ( LUA_INCLUDE_DIR STREQUAL LUA_INC_SUFFIX )
+if ( LUA_INCLUDE_DIR STREQUAL LUA_INC_SUFFIX OR USE_LUAJIT )
   set( LUA_INC_SUFFIX "")
 endif()
 
 FIND_LIBRARY(LUA_LIBRARY
-  NAMES lua${LUA_INC_SUFFIX} lua52 lua5.2 lua-5.2 lua51 lua5.1 lua-5.1 lua
+  NAMES ${_lua_library_names} lua${LUA_INC_SUFFIX} lua52 lua5.2 lua-5.2 lua51 lua5.1 lua-5.1 lua
   HINTS
     "${LUA_LIBDIR}"
     "$ENV{LUA_DIR}"
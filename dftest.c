@@ -1,5 +1,6 @@
 /* dftest.c
  * Shows display filter byte-code, for debugging dfilter routines.
+ * Optionally runs filters against a capture file and profiles them.
  *
  * Wireshark - Network traffic analyzer
  * By Gerald Combs <gerald@wireshark.org>
@@ -18,9 +19,25 @@
 
 #include <glib.h>
 
+/*
+ * If we have getopt_long() in the system library, include <getopt.h>.
+ * Otherwise, we're using our own getopt_long() (either because the
+ * system has getopt() but not getopt_long(), as with some UN*Xes,
+ * or because it doesn't even have getopt(), as with Windows), so
+ * include our getopt_long()'s header.
+ */
+#ifdef HAVE_GETOPT_LONG
+#include <getopt.h>
+#else
+#include <wsutil/wsgetopt.h>
+#endif
+
 #include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/frame_data.h>
 #include <epan/timestamp.h>
 #include <epan/prefs.h>
+#include <epan/tvbuff.h>
 #include <epan/dfilter/dfilter.h>
 
 #ifdef HAVE_PLUGINS
@@ -29,16 +46,221 @@
 #include <wsutil/filesystem.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
+#include <wsutil/buffer.h>
 
 #include <wiretap/wtap.h>
 
 #include "ui/util.h"
+#include "ui/clopts_common.h"
 #include "ui/cmdarg_err.h"
 #include "ui/failure_message.h"
 
 static void dftest_cmdarg_err(const char *fmt, va_list ap);
 static void dftest_cmdarg_err_cont(const char *fmt, va_list ap);
 
+/* A filter being run against a capture file */
+typedef struct {
+	const char	*text;
+	dfilter_t	*df;
+	guint64		disagreements;	/* packets on which it disagrees with the first filter */
+} bench_filter_t;
+
+/* Frames that the frame timestamp lookups can refer to */
+static const frame_data *ref;
+static frame_data ref_frame;
+static frame_data *prev_dis;
+static frame_data prev_dis_frame;
+
+static void
+print_usage(FILE *output)
+{
+	fprintf(output, "Usage: dftest [-r <infile> [-f <filter>] ... [-n <count>]] [--] <filter>\n");
+	fprintf(output, "\n");
+	fprintf(output, "Without -r, compiles the filter and shows its byte-code.\n");
+	fprintf(output, "\n");
+	fprintf(output, "  -r <infile>  apply the filter to every packet of this capture file and\n");
+	fprintf(output, "               show how long it took and which instructions it ran\n");
+	fprintf(output, "  -f <filter>  another filter to apply and compare, e.g. an equivalent\n");
+	fprintf(output, "               spelling of the first one; may be repeated\n");
+	fprintf(output, "  -n <count>   apply each filter count times to each packet (default 1)\n");
+}
+
+static const nstime_t *
+dftest_get_frame_ts(struct packet_provider_data *prov _U_, guint32 frame_num)
+{
+	if (ref && ref->num == frame_num)
+		return &ref->abs_ts;
+
+	if (prev_dis && prev_dis->num == frame_num)
+		return &prev_dis->abs_ts;
+
+	return NULL;
+}
+
+static epan_t *
+dftest_epan_new(void)
+{
+	static const struct packet_provider_funcs funcs = {
+		dftest_get_frame_ts,
+		NULL,
+		NULL,
+		NULL
+	};
+
+	return epan_new(NULL, &funcs);
+}
+
+static void
+print_insn_profile(const char *opcode, guint64 count, guint64 ns,
+    gpointer user_data _U_)
+{
+	printf("    %-18s %12" G_GUINT64_FORMAT " %14" G_GUINT64_FORMAT " %10.1f\n",
+	    opcode, count, ns, (double)ns / count);
+}
+
+static void
+print_profile(const bench_filter_t *filter, guint64 packets)
+{
+	const dfilter_profile_t *prof = dfilter_profile_get(filter->df);
+
+	printf("Filter: \"%s\"\n", filter->text);
+	printf("  Packets:                %" G_GUINT64_FORMAT "\n", packets);
+	printf("  Applications:           %" G_GUINT64_FORMAT "\n", prof->applies);
+	printf("  Matches:                %" G_GUINT64_FORMAT "\n", prof->matches);
+	printf("  Time:                   %" G_GUINT64_FORMAT " ns\n", prof->total_ns);
+	printf("  Time per application:   %.1f ns\n",
+	    prof->applies ? (double)prof->total_ns / prof->applies : 0.0);
+	printf("  Required field rejects: %" G_GUINT64_FORMAT "\n", prof->required_rejects);
+	printf("  READ_TREE:              %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT " misses, %" G_GUINT64_FORMAT " cached\n",
+	    prof->read_tree_hits, prof->read_tree_misses, prof->read_tree_cached);
+	printf("  Instructions:\n");
+	printf("    %-18s %12s %14s %10s\n", "Opcode", "Count", "Time (ns)", "ns/insn");
+	dfilter_profile_foreach_insn(filter->df, print_insn_profile, NULL);
+	printf("\n");
+}
+
+/*
+ * Dissects every packet of the capture file once, with a tree primed
+ * with the fields of all of the filters, and applies each filter to it
+ * count times.  Returns FALSE if the file couldn't be read.
+ */
+static gboolean
+bench_filters(const char *filename, GArray *filters, int count)
+{
+	wtap *wth;
+	wtap_rec rec;
+	Buffer buf;
+	int err = 0;
+	gchar *err_info = NULL;
+	gint64 data_offset;
+	epan_t *epan;
+	epan_dissect_t *edt;
+	nstime_t elapsed_time;
+	guint32 cum_bytes = 0;
+	guint32 framenum = 0;
+	guint i;
+	int pass;
+
+	wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+	if (wth == NULL) {
+		cfile_open_failure_message(filename, err, err_info);
+		return FALSE;
+	}
+
+	for (i = 0; i < filters->len; i++)
+		dfilter_profile_enable(g_array_index(filters, bench_filter_t, i).df, TRUE);
+
+	epan = dftest_epan_new();
+	edt = epan_dissect_new(epan, TRUE, FALSE);
+	nstime_set_zero(&elapsed_time);
+	ref = NULL;
+	prev_dis = NULL;
+
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+	while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+		frame_data fdata;
+		gboolean first_passed = FALSE;
+
+		if (rec.rec_type != REC_TYPE_PACKET)
+			continue;
+
+		frame_data_init(&fdata, ++framenum, &rec, data_offset, cum_bytes);
+		for (i = 0; i < filters->len; i++)
+			epan_dissect_prime_with_dfilter(edt, g_array_index(filters, bench_filter_t, i).df);
+
+		frame_data_set_before_dissect(&fdata, &elapsed_time, &ref, prev_dis);
+		if (ref == &fdata) {
+			ref_frame = fdata;
+			ref = &ref_frame;
+		}
+
+		epan_dissect_run(edt, wtap_file_type_subtype(wth), &rec,
+		    tvb_new_real_data(ws_buffer_start_ptr(&buf),
+			rec.rec_header.packet_header.caplen,
+			rec.rec_header.packet_header.len),
+		    &fdata, NULL);
+
+		for (i = 0; i < filters->len; i++) {
+			bench_filter_t *filter = &g_array_index(filters, bench_filter_t, i);
+			gboolean passed = FALSE;
+
+			for (pass = 0; pass < count; pass++)
+				passed = dfilter_apply_edt(filter->df, edt);
+			if (i == 0)
+				first_passed = passed;
+			else if (passed != first_passed)
+				filter->disagreements++;
+		}
+
+		frame_data_set_after_dissect(&fdata, &cum_bytes);
+		prev_dis_frame = fdata;
+		prev_dis = &prev_dis_frame;
+		epan_dissect_reset(edt);
+		frame_data_destroy(&fdata);
+	}
+	ws_buffer_free(&buf);
+	wtap_rec_cleanup(&rec);
+
+	epan_dissect_free(edt);
+	epan_free(epan);
+	wtap_close(wth);
+
+	if (err != 0) {
+		cfile_read_failure_message(filename, err, err_info);
+		return FALSE;
+	}
+
+	for (i = 0; i < filters->len; i++)
+		print_profile(&g_array_index(filters, bench_filter_t, i), framenum);
+
+	if (filters->len > 1) {
+		const dfilter_profile_t *first =
+		    dfilter_profile_get(g_array_index(filters, bench_filter_t, 0).df);
+
+		printf("Comparison:\n");
+		printf("  %-4s %14s %9s %12s  %s\n", "#", "ns/apply", "Relative", "Disagree", "Filter");
+		for (i = 0; i < filters->len; i++) {
+			bench_filter_t *filter = &g_array_index(filters, bench_filter_t, i);
+			const dfilter_profile_t *prof = dfilter_profile_get(filter->df);
+			double per_apply = prof->applies ? (double)prof->total_ns / prof->applies : 0.0;
+
+			printf("  %-4u %14.1f %8.2fx %12" G_GUINT64_FORMAT "  %s\n",
+			    i + 1, per_apply,
+			    first->total_ns ? (double)prof->total_ns / first->total_ns : 0.0,
+			    filter->disagreements, filter->text);
+		}
+		for (i = 1; i < filters->len; i++) {
+			if (g_array_index(filters, bench_filter_t, i).disagreements > 0) {
+				printf("\nWarning: not all of the filters matched the same packets.\n");
+				break;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -58,6 +280,13 @@ main(int argc, char **argv)
 	char		*text;
 	dfilter_t	*df;
 	gchar		*err_msg;
+	int		opt;
+	const char	*infile = NULL;
+	int		count = 1;
+	GPtrArray	*alt_texts;
+	GArray		*filters;
+	guint		i;
+	int		ret = 0;
 
 	cmdarg_err_init(dftest_cmdarg_err, dftest_cmdarg_err_cont);
 
@@ -114,14 +343,68 @@ main(int argc, char **argv)
 	line that its preferences have changed. */
 	prefs_apply_all();
 
+	/* Stop at the first filter, which may look like an option */
+	alt_texts = g_ptr_array_new();
+	while ((opt = getopt(argc, argv, "+f:hn:r:")) != -1) {
+		switch (opt) {
+		case 'f':
+			g_ptr_array_add(alt_texts, optarg);
+			break;
+		case 'h':
+			print_usage(stdout);
+			exit(0);
+		case 'n':
+			count = get_positive_int(optarg, "apply count");
+			break;
+		case 'r':
+			infile = optarg;
+			break;
+		default:
+			print_usage(stderr);
+			exit(1);
+		}
+	}
+
 	/* Check for filter on command line */
-	if (argc <= 1) {
-		fprintf(stderr, "Usage: dftest <filter>\n");
+	if (optind >= argc || (alt_texts->len > 0 && infile == NULL)) {
+		print_usage(stderr);
 		exit(1);
 	}
 
 	/* Get filter text */
-	text = get_args_as_string(argc, argv, 1);
+	text = get_args_as_string(argc, argv, optind);
+
+	if (infile != NULL) {
+		/* Compile them all, and then run them */
+		filters = g_array_new(FALSE, TRUE, sizeof(bench_filter_t));
+		g_ptr_array_insert(alt_texts, 0, text);
+		for (i = 0; i < alt_texts->len; i++) {
+			bench_filter_t filter = { (const char *)g_ptr_array_index(alt_texts, i), NULL, 0 };
+
+			if (!dfilter_compile(filter.text, &filter.df, &err_msg)) {
+				fprintf(stderr, "dftest: %s\n", err_msg);
+				g_free(err_msg);
+				ret = 2;
+				break;
+			}
+			if (filter.df == NULL) {
+				fprintf(stderr, "dftest: Filter \"%s\" is empty\n", filter.text);
+				ret = 2;
+				break;
+			}
+			g_array_append_val(filters, filter);
+		}
+		if (ret == 0 && !bench_filters(infile, filters, count))
+			ret = 2;
+		for (i = 0; i < filters->len; i++)
+			dfilter_free(g_array_index(filters, bench_filter_t, i).df);
+		g_array_free(filters, TRUE);
+		g_ptr_array_free(alt_texts, TRUE);
+		epan_cleanup();
+		g_free(text);
+		exit(ret);
+	}
+	g_ptr_array_free(alt_texts, TRUE);
 
 	printf("Filter: \"%s\"\n", text);
 
@@ -7,6 +7,10 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for sched_setaffinity() and sched_getcpu() */
+#endif
+
 #include <config.h>
 
 #include <stdio.h>
@@ -38,6 +42,12 @@
 #include <sys/utsname.h>
 #endif
 
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <linux/if_packet.h>
+#include <sched.h>
+#endif
+
 #include <signal.h>
 #include <errno.h>
 
@@ -87,6 +97,7 @@
 #include "wsutil/time_util.h"
 #include "wsutil/please_report_bug.h"
 #include "wsutil/glib-compat.h"
+#include "wsutil/ws_probes.h"
 
 #include "capture/ws80211_utils.h"
 
@@ -117,9 +128,6 @@ FILE *debug_log;   /* for logging debug messages to  */
                    /*  is defined                    */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static gint64 pcap_queue_bytes;
-static gint64 pcap_queue_packets;
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
 
@@ -186,6 +194,36 @@ typedef struct _pcapng_pipe_info {
 
 struct _loop_data; /* forward declaration so we can use it in the cap_pipe_dispatch function pointer */
 
+/*
+ * A slot of a capture queue; its data buffer is kept, and only grown,
+ * from one packet to the next.
+ */
+typedef struct _capture_queue_slot {
+    union {
+        struct pcap_pkthdr  phdr;
+        pcapng_block_header_t  bh;
+    } u;
+    guint64             ts;                     /**< time stamp in ns, for ordering; 0 for pcapng blocks */
+    u_char             *pd;
+    guint               pd_size;                /**< allocated size of pd */
+} capture_queue_slot;
+
+/*
+ * The queue between the capture thread of a source and the writer, with
+ * use_threads.  There's one producer and one consumer, so it's a ring of
+ * slots without a lock: the capture thread only advances "tail", after
+ * filling in a slot, and the writer only advances "head", after writing
+ * it out.
+ */
+typedef struct _capture_queue {
+    capture_queue_slot *slots;
+    guint               num_slots;              /**< a power of 2 */
+    volatile gint       head;                   /**< count of slots taken by the writer */
+    volatile gint       tail;                   /**< count of slots filled in by the capture thread */
+    volatile gint       bytes;                  /**< bytes of data in the filled-in slots */
+    guint               max_depth;              /**< most slots that were filled in at once */
+} capture_queue;
+
 /*
  * A source of packets from which we're capturing.
  */
@@ -199,7 +237,12 @@ typedef struct _capture_src {
 #endif
     gboolean                     pcap_err;
     guint                        interface_id;
+    gboolean                     fanout_member;          /**< TRUE if this is an extra PACKET_FANOUT socket of interface_id */
     GThread                     *tid;
+    int                          cpu;                    /**< CPU the capture thread is pinned to, or -1 */
+    int                          numa_node;              /**< NUMA node of the network interface, or -1 */
+    int                          last_cpu;               /**< CPU the capture thread last ran on, or -1 */
+    guint32                      migrations;             /**< Number of times it was seen on another CPU */
     int                          snaplen;
     int                          linktype;
     gboolean                     ts_nsec;                /**< TRUE if we're using nanosecond precision. */
@@ -218,6 +261,12 @@ typedef struct _capture_src {
     gboolean                     cap_pipe_modified;      /**< TRUE if data in the pipe uses modified pcap headers */
     char *                       cap_pipe_databuf;       /**< Pointer to the data buffer we've allocated */
     size_t                       cap_pipe_databuf_size;  /**< Current size of the data buffer */
+    char *                       cap_pipe_rabuf;         /**< Read-ahead buffer for pipes and sockets */
+    size_t                       cap_pipe_rabuf_len;     /**< Number of bytes in the read-ahead buffer */
+    size_t                       cap_pipe_rabuf_off;     /**< Offset of the first unconsumed byte in it */
+    guint64                      cap_pipe_read_bytes;    /**< Bytes read ahead from the pipe or socket */
+    guint32                      cap_pipe_reads;         /**< Number of reads ahead */
+    guint32                      cap_pipe_full_reads;    /**< Number of them that filled the read-ahead buffer */
     guint                        cap_pipe_max_pkt_size;  /**< Maximum packet size allowed */
 #if defined(_WIN32)
     char *                       cap_pipe_buf;           /**< Pointer to the buffer we read into */
@@ -230,6 +279,7 @@ typedef struct _capture_src {
     int (*cap_pipe_dispatch)(struct _loop_data *, struct _capture_src *, char *, size_t);
     cap_pipe_state_t cap_pipe_state;
     cap_pipe_err_t cap_pipe_err;
+    capture_queue                queue;                  /**< queue to the writer, with use_threads */
 
 #if defined(_WIN32)
     GMutex                      *cap_pipe_read_mtx;
@@ -275,14 +325,19 @@ typedef struct _loop_data {
     int      interval_s;
 } loop_data;
 
-typedef struct _pcap_queue_element {
-    capture_src        *pcap_src;
-    union {
-        struct pcap_pkthdr  phdr;
-        pcapng_block_header_t  bh;
-    } u;
-    u_char             *pd;
-} pcap_queue_element;
+/*
+ * The writer waits on this, with capture_queue_writer_waiting set, when
+ * all the capture queues are empty.
+ */
+static GMutex capture_queue_mtx;
+static GCond capture_queue_cond;
+static volatile gint capture_queue_writer_waiting;
+
+/* If no packet limit is given, queues have this many slots */
+#define CAPTURE_QUEUE_DEFAULT_SLOTS 8192
+
+/* Slots don't keep data buffers bigger than this for the next packet */
+#define CAPTURE_QUEUE_MAX_KEPT_SIZE 65536
 
 /*
  * This needs to be static, so that the SIGINT handler can clear the "go"
@@ -325,6 +380,11 @@ static gboolean need_timeout_workaround;
 
 #define WRITER_THREAD_TIMEOUT 100000 /* usecs */
 
+/*
+ * Size of the buffer into which we read ahead from pipes and sockets.
+ */
+#define CAP_PIPE_READAHEAD_SIZE (256 * 1024)
+
 static void
 console_log_handler(const char *log_domain, GLogLevelFlags log_level,
                     const char *message, gpointer user_data _U_);
@@ -334,6 +394,15 @@ static capture_options global_capture_opts;
 static gboolean quiet = FALSE;
 static gboolean use_threads = FALSE;
 static guint64 start_time;
+#ifdef PACKET_FANOUT
+static int fanout_sockets = 1;          /* --fanout: sockets per network interface */
+static gboolean fanout_cpu = FALSE;     /* --fanout: by receiving CPU, not by flow hash */
+#endif
+#ifdef __linux__
+static GArray *capture_cpus = NULL;     /* --capture-cpus: CPUs to pin capture threads to */
+static gboolean capture_cpus_local = FALSE; /* --capture-cpus local: those of each interface */
+static int writer_cpu = -1;             /* --writer-cpu: CPU to pin the writer to */
+#endif
 
 static void capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                                          const u_char *pd);
@@ -341,6 +410,7 @@ static void capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_p
                                          const u_char *pd);
 static void capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd);
 static void capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd);
+static void capture_queue_init(capture_queue *queue);
 static void capture_loop_get_errmsg(char *errmsg, size_t errmsglen,
                                     char *secondary_errmsg,
                                     size_t secondary_errmsglen,
@@ -352,6 +422,8 @@ static void WS_NORETURN exit_main(int err);
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
 static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name);
+static void report_pipe_stats(const capture_src *pcap_src, const gchar *name);
+static void report_thread_stats(const capture_src *pcap_src, const gchar *name);
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
@@ -396,6 +468,7 @@ print_usage(FILE *output)
     fprintf(output, "  -L, --list-data-link-types\n");
     fprintf(output, "                           print list of link-layer types of iface and exit\n");
     fprintf(output, "  --list-time-stamp-types  print list of timestamp types for iface and exit\n");
+    fprintf(output, "  --update-interval        interval between updates with new packets (def: %dms)\n", DEFAULT_UPDATE_INTERVAL);
     fprintf(output, "  -d                       print generated BPF code for capture filter\n");
     fprintf(output, "  -k <freq>,[<type>],[<center_freq1>],[<center_freq2>]\n");
     fprintf(output, "                           set channel on wifi interface\n");
@@ -433,6 +506,10 @@ print_usage(FILE *output)
     fprintf(output, "                                          an exact multiple of NUM secs\n");
     fprintf(output, "                          printname:FILE - print filename to FILE when written\n");
     fprintf(output, "                                           (can use 'stdout' or 'stderr')\n");
+    fprintf(output, "                           prealloc:NUM - create the next file and allocate\n");
+    fprintf(output, "                                          NUM kB for it in the background\n");
+    fprintf(output, "                        writebehind:NUM - write back and drop from the page\n");
+    fprintf(output, "                                          cache every NUM kB written\n");
     fprintf(output, "  -n                       use pcapng format instead of pcap (default)\n");
     fprintf(output, "  -P                       use libpcap format instead of pcapng\n");
     fprintf(output, "  --capture-comment <comment>\n");
@@ -444,6 +521,18 @@ print_usage(FILE *output)
     fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
     fprintf(output, "                           within dumpcap\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
+#ifdef PACKET_FANOUT
+    fprintf(output, "  --fanout <count>[,cpu]   capture on each interface with <count> threads,\n");
+    fprintf(output, "                           spreading its packets over them by flow hash\n");
+    fprintf(output, "                           or by receiving CPU\n");
+#endif
+#ifdef __linux__
+    fprintf(output, "  --capture-cpus <list>|local\n");
+    fprintf(output, "                           pin the capture threads to the CPUs in <list>\n");
+    fprintf(output, "                           (e.g. 2-5,8), or to those local to each\n");
+    fprintf(output, "                           interface's NUMA node\n");
+    fprintf(output, "  --writer-cpu <cpu>       pin the thread writing the capture file to <cpu>\n");
+#endif
     fprintf(output, "  -q                       don't report packet capture counts\n");
     fprintf(output, "  -v, --version            print version information and exit\n");
     fprintf(output, "  -h, --help               display this help and exit\n");
@@ -1433,6 +1522,58 @@ cap_pipe_close(int pipe_fd, gboolean from_socket)
 #endif
 }
 
+/** Refill the read-ahead buffer of a pipe or socket source, with one read
+ * of as much as it has to offer, rather than just what's left of the
+ * current record; a busy extcap or socket source then costs one read per
+ * CAP_PIPE_READAHEAD_SIZE bytes instead of two per record.
+ *
+ * Returns -1, 0 on EOF, or the number of bytes read, as read(2) does.
+ */
+static ssize_t
+cap_pipe_read_ahead(capture_src *pcap_src)
+{
+    ssize_t b;
+
+    if (pcap_src->cap_pipe_rabuf == NULL) {
+        pcap_src->cap_pipe_rabuf = (char *)g_malloc(CAP_PIPE_READAHEAD_SIZE);
+    }
+    pcap_src->cap_pipe_rabuf_len = 0;
+    pcap_src->cap_pipe_rabuf_off = 0;
+    b = cap_pipe_read(pcap_src->cap_pipe_fd, pcap_src->cap_pipe_rabuf, CAP_PIPE_READAHEAD_SIZE,
+                      pcap_src->from_cap_socket);
+    if (b > 0) {
+        pcap_src->cap_pipe_rabuf_len = b;
+        pcap_src->cap_pipe_read_bytes += b;
+        pcap_src->cap_pipe_reads++;
+        /* It had at least that much waiting, so it's ahead of us. */
+        if (b == CAP_PIPE_READAHEAD_SIZE)
+            pcap_src->cap_pipe_full_reads++;
+    }
+    return b;
+}
+
+/** Copy up to sz bytes from a pipe or socket source into buf, from what
+ * we've read ahead, reading ahead again if that's all been used.
+ *
+ * Returns -1, 0 on EOF, or the number of bytes copied, as read(2) does.
+ */
+static ssize_t
+cap_pipe_read_buffered(capture_src *pcap_src, char *buf, size_t sz)
+{
+    size_t avail;
+
+    if (pcap_src->cap_pipe_rabuf_off >= pcap_src->cap_pipe_rabuf_len) {
+        ssize_t b = cap_pipe_read_ahead(pcap_src);
+
+        if (b <= 0)
+            return b;
+    }
+    avail = MIN(pcap_src->cap_pipe_rabuf_len - pcap_src->cap_pipe_rabuf_off, sz);
+    memcpy(buf, pcap_src->cap_pipe_rabuf+pcap_src->cap_pipe_rabuf_off, avail);
+    pcap_src->cap_pipe_rabuf_off += avail;
+    return (ssize_t)avail;
+}
+
 /** Read bytes from a capture source, which is assumed to be a pipe or
  * socket.
  *
@@ -1457,6 +1598,17 @@ cap_pipe_read_data_bytes(capture_src *pcap_src, char *errmsg, size_t errmsgl)
 #endif
     sz = pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read;
     while (bytes_read < sz) {
+        if (pcap_src->cap_pipe_rabuf_off < pcap_src->cap_pipe_rabuf_len) {
+            /* Use what we've already read from the pipe first. */
+            b = (ssize_t)MIN(pcap_src->cap_pipe_rabuf_len - pcap_src->cap_pipe_rabuf_off,
+                             (size_t)(sz - bytes_read));
+            memcpy(pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read+bytes_read,
+                   pcap_src->cap_pipe_rabuf+pcap_src->cap_pipe_rabuf_off, b);
+            pcap_src->cap_pipe_rabuf_off += b;
+            bytes_read += b;
+            continue;
+        }
+
         if (fd == -1) {
             g_snprintf(errmsg, (gulong)errmsgl, "Invalid file descriptor.");
             pcap_src->cap_pipe_err = PIPNEXIST;
@@ -1470,8 +1622,7 @@ cap_pipe_read_data_bytes(capture_src *pcap_src, char *errmsg, size_t errmsgl)
             pcap_src->cap_pipe_err = PIPERR;
             return -1;
         } else if (sel_ret > 0) {
-            b = cap_pipe_read(fd, pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read+bytes_read,
-                              sz-bytes_read, pcap_src->from_cap_socket);
+            b = cap_pipe_read_ahead(pcap_src);
             if (b <= 0) {
                 if (b == 0) {
                     g_snprintf(errmsg, (gulong)errmsgl,
@@ -1496,7 +1647,6 @@ cap_pipe_read_data_bytes(capture_src *pcap_src, char *errmsg, size_t errmsgl)
                 }
                 return -1;
             }
-            bytes_read += b;
         }
     }
     pcap_src->cap_pipe_bytes_read += bytes_read;
@@ -2319,8 +2469,8 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd, ((char *)&pcap_info->rechdr)+pcap_src->cap_pipe_bytes_read,
-                 pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read, pcap_src->from_cap_socket);
+            b = cap_pipe_read_buffered(pcap_src, ((char *)&pcap_info->rechdr)+pcap_src->cap_pipe_bytes_read,
+                 pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read);
             if (b <= 0) {
                 if (b == 0)
                     result = PD_PIPE_EOF;
@@ -2374,10 +2524,9 @@ pcap_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t er
         if (pcap_src->from_cap_socket)
 #endif
         {
-            b = cap_pipe_read(pcap_src->cap_pipe_fd,
+            b = cap_pipe_read_buffered(pcap_src,
                               pcap_src->cap_pipe_databuf+pcap_src->cap_pipe_bytes_read,
-                              pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read,
-                              pcap_src->from_cap_socket);
+                              pcap_src->cap_pipe_bytes_to_read - pcap_src->cap_pipe_bytes_read);
             if (b <= 0) {
                 if (b == 0)
                     result = PD_PIPE_EOF;
@@ -2767,6 +2916,227 @@ pcapng_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t
     return -1;
 }
 
+#ifdef __linux__
+/*
+ * Parse a list of CPUs such as "2-5,8", the format of --capture-cpus and
+ * of the kernel's cpulist files, appending them to "cpus".  Returns FALSE
+ * if it isn't one.
+ */
+static gboolean
+parse_cpu_list(const char *str, GArray *cpus)
+{
+    const char *p = str;
+    guint32     first, last, cpu;
+    int         cpu_num;
+
+    for (;;) {
+        if (!g_ascii_isdigit(*p) || !ws_strtou32(p, &p, &first))
+            return FALSE;
+        last = first;
+        if (*p == '-') {
+            p++;
+            if (!g_ascii_isdigit(*p) || !ws_strtou32(p, &p, &last) || last < first)
+                return FALSE;
+        }
+        if (last >= CPU_SETSIZE)
+            return FALSE;
+        for (cpu = first; cpu <= last; cpu++) {
+            cpu_num = (int)cpu;
+            g_array_append_val(cpus, cpu_num);
+        }
+        if (*p != ',')
+            break;
+        p++;
+    }
+    return *p == '\0';
+}
+
+/*
+ * Get the CPUs local to the network interface "name", and its NUMA node,
+ * from sysfs.  Returns FALSE if it has none, as with virtual interfaces
+ * and pipes.
+ */
+static gboolean
+get_interface_cpus(const char *name, GArray *cpus, int *numa_node)
+{
+    char    *path;
+    char    *contents;
+    gint32   node;
+    gboolean ok;
+
+    *numa_node = -1;
+    path = g_strdup_printf("/sys/class/net/%s/device/numa_node", name);
+    if (g_file_get_contents(path, &contents, NULL, NULL)) {
+        if (ws_strtoi32(g_strstrip(contents), NULL, &node) && node >= 0)
+            *numa_node = node;
+        g_free(contents);
+    }
+    g_free(path);
+
+    path = g_strdup_printf("/sys/class/net/%s/device/local_cpulist", name);
+    ok = g_file_get_contents(path, &contents, NULL, NULL);
+    g_free(path);
+    if (!ok)
+        return FALSE;
+    ok = parse_cpu_list(g_strstrip(contents), cpus);
+    g_free(contents);
+    return ok;
+}
+
+/* Pin the calling thread to "cpu". */
+static gboolean
+set_thread_cpu(int cpu)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof set, &set) == 0;
+}
+
+/*
+ * For --capture-cpus, choose the CPU of the capture thread of "pcap_src",
+ * the last source in ld->pcaps, and move to it while the source is being
+ * opened, so that the kernel allocates the source's packet ring on that
+ * CPU's NUMA node.  capture_loop_start() moves the writer back afterwards.
+ */
+static void
+capture_loop_place_src(loop_data *ld, capture_src *pcap_src, const char *name)
+{
+    GArray *cpus = capture_cpus;
+    GArray *local_cpus;
+    guint   nth, i;
+
+    pcap_src->cpu = -1;
+    local_cpus = g_array_new(FALSE, FALSE, sizeof(int));
+    if (get_interface_cpus(name, local_cpus, &pcap_src->numa_node) && capture_cpus_local)
+        cpus = local_cpus;
+
+    if (capture_cpus_local) {
+        /* Spread the sources of each interface over its own CPUs */
+        nth = 0;
+        for (i = 0; i + 1 < ld->pcaps->len; i++) {
+            if (g_array_index(ld->pcaps, capture_src *, i)->interface_id == pcap_src->interface_id)
+                nth++;
+        }
+    } else {
+        nth = ld->pcaps->len - 1;
+    }
+    if (cpus != NULL && cpus->len > 0) {
+        pcap_src->cpu = g_array_index(cpus, int, nth % cpus->len);
+        if (!set_thread_cpu(pcap_src->cpu)) {
+            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_WARNING,
+                  "Could not open %s on CPU %d: %s", name, pcap_src->cpu, g_strerror(errno));
+        }
+    }
+    g_array_free(local_cpus, TRUE);
+}
+#endif
+
+#ifdef PACKET_FANOUT
+/*
+ * Join the packet socket of "pcap_h" to the PACKET_FANOUT group
+ * "group_id", so that the kernel hands each of the interface's packets
+ * to only one of the group's sockets instead of to all of them.
+ */
+static gboolean
+capture_loop_join_fanout(pcap_t *pcap_h, guint16 group_id,
+                         char *errmsg, size_t errmsg_len)
+{
+    int fanout_arg;
+
+    if (fanout_cpu)
+        fanout_arg = group_id | (PACKET_FANOUT_CPU << 16);
+    else
+        fanout_arg = group_id | ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+    if (setsockopt(pcap_fileno(pcap_h), SOL_PACKET, PACKET_FANOUT,
+                   &fanout_arg, sizeof fanout_arg) == -1) {
+        g_snprintf(errmsg, (gulong) errmsg_len,
+                   "Couldn't set up PACKET_FANOUT: %s.", g_strerror(errno));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * For --fanout, open the extra sockets of each network interface we're
+ * capturing on, and put them in one fanout group with its first socket.
+ * They're appended to ld->pcaps, after the sources of all interfaces,
+ * and they get their own capture threads; their packets are written
+ * with the IDB of the interface, so they all end up in one file.
+ */
+static gboolean
+capture_loop_open_fanout(capture_options *capture_opts, loop_data *ld,
+                         char *errmsg, size_t errmsg_len,
+                         char *secondary_errmsg, size_t secondary_errmsg_len)
+{
+    cap_device_open_err open_err;
+    gchar               open_err_str[PCAP_ERRBUF_SIZE];
+    interface_options  *interface_opts;
+    capture_src        *pcap_src;
+    capture_src        *member;
+    guint16             group_id;
+    guint               i, n_srcs;
+    int                 j;
+
+    n_srcs = ld->pcaps->len;
+    for (i = 0; i < n_srcs; i++) {
+        pcap_src = g_array_index(ld->pcaps, capture_src *, i);
+        if (pcap_src->from_cap_pipe)
+            continue;
+        interface_opts = &g_array_index(capture_opts->ifaces, interface_options, pcap_src->interface_id);
+
+        /* Fanout group IDs are system-wide. */
+        group_id = (guint16)(getpid() + i);
+        if (!capture_loop_join_fanout(pcap_src->pcap_h, group_id, errmsg, errmsg_len))
+            return FALSE;
+
+        for (j = 1; j < fanout_sockets; j++) {
+            member = g_new0(capture_src, 1);
+            member->interface_id = pcap_src->interface_id;
+            member->fanout_member = TRUE;
+            member->linktype = pcap_src->linktype;
+            member->cap_pipe_fd = -1;
+            member->cap_pipe_dispatch = pcap_pipe_dispatch;
+            member->cap_pipe_state = STATE_EXPECT_REC_HDR;
+            member->cap_pipe_err = PIPOK;
+            member->cpu = -1;
+            member->numa_node = -1;
+            /* Add it now, so that capture_loop_close_input() closes it */
+            g_array_append_val(ld->pcaps, member);
+            if (capture_cpus != NULL || capture_cpus_local)
+                capture_loop_place_src(ld, member, interface_opts->name);
+
+            member->pcap_h = open_capture_device(capture_opts, interface_opts,
+                CAP_READ_TIMEOUT, &open_err, &open_err_str);
+            if (member->pcap_h == NULL) {
+                get_capture_device_open_failure_messages(open_err,
+                                                         open_err_str,
+                                                         interface_opts->name,
+                                                         errmsg,
+                                                         errmsg_len,
+                                                         secondary_errmsg,
+                                                         secondary_errmsg_len);
+                return FALSE;
+            }
+            member->pcap_fd = pcap_get_selectable_fd(member->pcap_h);
+#ifdef HAVE_PCAP_SET_TSTAMP_PRECISION
+            member->ts_nsec = have_high_resolution_timestamp(member->pcap_h);
+#endif
+            if (!set_pcap_datalink(member->pcap_h, interface_opts->linktype,
+                                   interface_opts->name,
+                                   errmsg, errmsg_len,
+                                   secondary_errmsg, secondary_errmsg_len)) {
+                return FALSE;
+            }
+            if (!capture_loop_join_fanout(member->pcap_h, group_id, errmsg, errmsg_len))
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+#endif
+
 /** Open the capture input sources; each one is either a pcap device,
  *  a capture pipe, or a capture socket.
  *  Returns TRUE if it succeeds, FALSE otherwise. */
@@ -2823,6 +3193,8 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
         pcap_src->cap_pipe_dispatch = pcap_pipe_dispatch;
         pcap_src->cap_pipe_state = STATE_EXPECT_REC_HDR;
         pcap_src->cap_pipe_err = PIPOK;
+        pcap_src->cpu = -1;
+        pcap_src->numa_node = -1;
 #ifdef _WIN32
         pcap_src->cap_pipe_read_mtx = g_new(GMutex, 1);
         g_mutex_init(pcap_src->cap_pipe_read_mtx);
@@ -2832,6 +3204,10 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
         g_array_append_val(ld->pcaps, pcap_src);
 
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_open_input : %s", interface_opts->name);
+#ifdef __linux__
+        if (capture_cpus != NULL || capture_cpus_local)
+            capture_loop_place_src(ld, pcap_src, interface_opts->name);
+#endif
         pcap_src->pcap_h = open_capture_device(capture_opts, interface_opts,
             CAP_READ_TIMEOUT, &open_err, &open_err_str);
 
@@ -2952,6 +3328,14 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
         }
     }
 
+#ifdef PACKET_FANOUT
+    if (fanout_sockets > 1 &&
+        !capture_loop_open_fanout(capture_opts, ld, errmsg, errmsg_len,
+                                  secondary_errmsg, secondary_errmsg_len)) {
+        return FALSE;
+    }
+#endif
+
     /*
      * Are we capturing from one source that is providing pcapng
      * information?
@@ -3010,6 +3394,10 @@ static void capture_loop_close_input(loop_data *ld)
                 g_free(pcap_src->cap_pipe_databuf);
                 pcap_src->cap_pipe_databuf = NULL;
             }
+            g_free(pcap_src->cap_pipe_rabuf);
+            pcap_src->cap_pipe_rabuf = NULL;
+            pcap_src->cap_pipe_rabuf_len = 0;
+            pcap_src->cap_pipe_rabuf_off = 0;
             if (pcap_src->from_pcapng) {
                 g_array_free(pcap_src->cap_pipe_info.pcapng.src_iface_to_global, TRUE);
                 pcap_src->cap_pipe_info.pcapng.src_iface_to_global = NULL;
@@ -3273,9 +3661,10 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
         if (capture_opts->use_pcapng) {
             for (i = 0; i < global_ld.pcaps->len; i++) {
                 pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
-                if (!pcap_src->from_cap_pipe) {
+                if (!pcap_src->from_cap_pipe && !pcap_src->fanout_member) {
                     guint64 isb_ifrecv, isb_ifdrop;
                     struct pcap_stat stats;
+                    guint j;
 
                     if (pcap_stats(pcap_src->pcap_h, &stats) >= 0) {
                         isb_ifrecv = pcap_src->received;
@@ -3284,6 +3673,20 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
                         isb_ifrecv = G_MAXUINT64;
                         isb_ifdrop = G_MAXUINT64;
                     }
+                    /* The other sockets of the interface, if it's fanned out */
+                    for (j = i + 1; j < global_ld.pcaps->len && isb_ifrecv != G_MAXUINT64; j++) {
+                        capture_src *member = g_array_index(global_ld.pcaps, capture_src *, j);
+
+                        if (!member->fanout_member || member->interface_id != pcap_src->interface_id)
+                            continue;
+                        if (pcap_stats(member->pcap_h, &stats) >= 0) {
+                            isb_ifrecv += member->received;
+                            isb_ifdrop += stats.ps_drop + member->dropped + member->flushed;
+                        } else {
+                            isb_ifrecv = G_MAXUINT64;
+                            isb_ifdrop = G_MAXUINT64;
+                        }
+                    }
                     pcapng_write_interface_statistics_block(ld->pdh,
                                                             i,
                                                             &ld->bytes_written,
@@ -3338,7 +3741,12 @@ capture_loop_dispatch(loop_data *ld,
 #ifdef _WIN32
         if (pcap_src->from_cap_socket) {
 #endif
-            sel_ret = cap_pipe_select(pcap_src->cap_pipe_fd);
+            if (pcap_src->cap_pipe_rabuf_off < pcap_src->cap_pipe_rabuf_len) {
+                /* We've already read ahead; don't wait for the pipe. */
+                sel_ret = 1;
+            } else {
+                sel_ret = cap_pipe_select(pcap_src->cap_pipe_fd);
+            }
             if (sel_ret <= 0) {
                 if (sel_ret < 0 && errno != EINTR) {
                     g_snprintf(errmsg, errmsg_len,
@@ -3360,7 +3768,14 @@ capture_loop_dispatch(loop_data *ld,
             /*
              * "select()" says we can read from the pipe without blocking
              */
-            inpkts = pcap_src->cap_pipe_dispatch(ld, pcap_src, errmsg, errmsg_len);
+            do {
+                inpkts = pcap_src->cap_pipe_dispatch(ld, pcap_src, errmsg, errmsg_len);
+                /*
+                 * Drain whatever we've read ahead before going back to
+                 * select().
+                 */
+            } while (inpkts >= 0 && ld->go &&
+                     pcap_src->cap_pipe_rabuf_off < pcap_src->cap_pipe_rabuf_len);
             if (inpkts < 0) {
                 g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "%s: src %u pipe reached EOF or err, rcv: %u drop: %u flush: %u",
                       G_STRFUNC, pcap_src->interface_id, pcap_src->received, pcap_src->dropped, pcap_src->flushed);
@@ -3395,15 +3810,19 @@ capture_loop_dispatch(loop_data *ld,
                  * "select()" says we can read from it without blocking; go for
                  * it.
                  *
-                 * We don't have pcap_breakloop(), so we only process one packet
-                 * per pcap_dispatch() call, to allow a signal to stop the
-                 * processing immediately, rather than processing all packets
-                 * in a batch before quitting.
+                 * Process everything that's available, rather than one packet
+                 * per "select()"; with the memory-mapped TPACKET_V3 ring
+                 * libpcap uses on Linux, that hands us a whole block of the
+                 * ring per pcap_dispatch() call without any further system
+                 * calls, and doing a "select()" per packet was what limited
+                 * the capture rate on fast links.  capture_loop_stop() does
+                 * a pcap_breakloop(), which libpcap checks between packets,
+                 * so a signal still stops the processing promptly.
                  */
                 if (use_threads) {
-                    inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_queue_packet_cb, (u_char *)pcap_src);
+                    inpkts = pcap_dispatch(pcap_src->pcap_h, -1, capture_loop_queue_packet_cb, (u_char *)pcap_src);
                 } else {
-                    inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_write_packet_cb, (u_char *)pcap_src);
+                    inpkts = pcap_dispatch(pcap_src->pcap_h, -1, capture_loop_write_packet_cb, (u_char *)pcap_src);
                 }
                 if (inpkts < 0) {
                     if (inpkts == -1) {
@@ -3499,6 +3918,8 @@ capture_loop_dispatch(loop_data *ld,
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "capture_loop_dispatch: %d new packet%s", inpkts, plurality(inpkts, "", "s"));
 #endif
 
+    WS_PROBE1(capture_dispatch, ld->packets_captured - packet_count_before);
+
     return ld->packets_captured - packet_count_before;
 }
 
@@ -3594,6 +4015,8 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
                         return FALSE;
                     }
                 }
+                ringbuf_set_prealloc((gint64)capture_opts->ring_prealloc * 1000);
+                ringbuf_set_write_behind((gint64)capture_opts->ring_write_behind * 1000);
             } else {
                 /* Try to open/create the specified file for use as a capture buffer. */
                 *save_file_fd = ws_open(capfile_name, O_WRONLY|O_BINARY|O_TRUNC|O_CREAT,
@@ -3793,8 +4216,31 @@ pcap_read_handler(void* arg)
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Started thread for interface %d.",
           pcap_src->interface_id);
 
+#ifdef __linux__
+    if (pcap_src->cpu >= 0 && !set_thread_cpu(pcap_src->cpu)) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_WARNING,
+              "Could not pin the thread for interface %d to CPU %d: %s",
+              pcap_src->interface_id, pcap_src->cpu, g_strerror(errno));
+    }
+#endif
+    /*
+     * Set up the queue here rather than in the writer, so that its memory
+     * is first touched, and so allocated, on this thread's NUMA node.
+     */
+    capture_queue_init(&pcap_src->queue);
+
+    pcap_src->last_cpu = -1;
     /* If this is a pipe input it might finish early. */
     while (global_ld.go && pcap_src->cap_pipe_err == PIPOK) {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+
+        if (cpu != pcap_src->last_cpu) {
+            if (pcap_src->last_cpu != -1)
+                pcap_src->migrations++;
+            pcap_src->last_cpu = cpu;
+        }
+#endif
         /* dispatch incoming packets */
         capture_loop_dispatch(&global_ld, errmsg, sizeof(errmsg), pcap_src);
     }
@@ -3805,46 +4251,174 @@ pcap_read_handler(void* arg)
     return (NULL);
 }
 
-/* Try to pop an item off the packet queue and if it exists, write it */
+static void
+capture_queue_init(capture_queue *queue)
+{
+    guint num_slots;
+
+    num_slots = pcap_queue_packet_limit > 0 ? (guint)pcap_queue_packet_limit : CAPTURE_QUEUE_DEFAULT_SLOTS;
+    queue->num_slots = 1;
+    while (queue->num_slots < num_slots)
+        queue->num_slots <<= 1;
+    queue->slots = g_new0(capture_queue_slot, queue->num_slots);
+    queue->head = 0;
+    queue->tail = 0;
+    queue->bytes = 0;
+    queue->max_depth = 0;
+}
+
+static void
+capture_queue_free(capture_queue *queue)
+{
+    guint i;
+
+    for (i = 0; i < queue->num_slots; i++)
+        g_free(queue->slots[i].pd);
+    g_free(queue->slots);
+    queue->slots = NULL;
+}
+
+/* Get the number of packets and bytes in all the capture queues. */
+static void
+capture_queue_get_totals(gint64 *packets, gint64 *bytes)
+{
+    guint        i;
+    capture_src *pcap_src;
+
+    *packets = 0;
+    *bytes = 0;
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        *packets += (guint)g_atomic_int_get(&pcap_src->queue.tail) - (guint)g_atomic_int_get(&pcap_src->queue.head);
+        *bytes += g_atomic_int_get(&pcap_src->queue.bytes);
+    }
+}
+
+/*
+ * Get a slot for a new packet from the queue of "pcap_src", or NULL (after
+ * counting the packet as dropped) if we're at the queue limits.
+ */
+static capture_queue_slot *
+capture_queue_get_free_slot(capture_src *pcap_src, guint len)
+{
+    capture_queue *queue = &pcap_src->queue;
+    guint          depth;
+    gint64         queued_packets, queued_bytes;
+    capture_queue_slot *slot;
+
+    capture_queue_get_totals(&queued_packets, &queued_bytes);
+    depth = (guint)queue->tail - (guint)g_atomic_int_get(&queue->head);
+    if (depth >= queue->num_slots ||
+        ((pcap_queue_byte_limit > 0) && (queued_bytes >= pcap_queue_byte_limit)) ||
+        ((pcap_queue_packet_limit > 0) && (queued_packets >= pcap_queue_packet_limit))) {
+        pcap_src->dropped++;
+        return NULL;
+    }
+    slot = &queue->slots[(guint)queue->tail & (queue->num_slots - 1)];
+    if (slot->pd_size < len) {
+        g_free(slot->pd);
+        slot->pd = (u_char *)g_malloc(len);
+        slot->pd_size = len;
+    }
+    if (depth + 1 > queue->max_depth)
+        queue->max_depth = depth + 1;
+    return slot;
+}
+
+/* Hand the slot we got with capture_queue_get_free_slot() to the writer. */
+static void
+capture_queue_put_slot(capture_src *pcap_src, guint len)
+{
+    g_atomic_int_add(&pcap_src->queue.bytes, (gint)len);
+    g_atomic_int_set(&pcap_src->queue.tail, (gint)((guint)pcap_src->queue.tail + 1));
+    pcap_src->received++;
+
+    /* The atomic operations are full barriers, so the writer can't miss this */
+    if (g_atomic_int_get(&capture_queue_writer_waiting)) {
+        g_mutex_lock(&capture_queue_mtx);
+        g_cond_signal(&capture_queue_cond);
+        g_mutex_unlock(&capture_queue_mtx);
+    }
+}
+
+/*
+ * Of the sources with something in their queue, get the one whose next
+ * packet is the oldest, so packets from different sources are written
+ * in time stamp order as far as they've arrived, or NULL if all the
+ * queues are empty.
+ */
+static capture_src *
+capture_queue_get_oldest(void)
+{
+    guint        i;
+    capture_src *pcap_src;
+    capture_src *oldest = NULL;
+    guint64      oldest_ts = 0;
+    capture_queue_slot *slot;
+
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        if (pcap_src->queue.head == g_atomic_int_get(&pcap_src->queue.tail))
+            continue;
+        slot = &pcap_src->queue.slots[(guint)pcap_src->queue.head & (pcap_src->queue.num_slots - 1)];
+        if (oldest == NULL || slot->ts < oldest_ts) {
+            oldest = pcap_src;
+            oldest_ts = slot->ts;
+        }
+    }
+    return oldest;
+}
+
+/* Try to take a packet off the capture queues and if there is one, write it */
 static gboolean
 capture_loop_dequeue_packet(void) {
-    pcap_queue_element *queue_element;
+    capture_src        *pcap_src;
+    capture_queue_slot *slot;
+    guint               len;
 
-    g_async_queue_lock(pcap_queue);
-    queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-        } else {
-            pcap_queue_bytes -= queue_element->u.phdr.caplen;
+    pcap_src = capture_queue_get_oldest();
+    if (pcap_src == NULL) {
+        gint64 end_time = g_get_monotonic_time() + WRITER_THREAD_TIMEOUT;
+
+        g_mutex_lock(&capture_queue_mtx);
+        g_atomic_int_set(&capture_queue_writer_waiting, 1);
+        while ((pcap_src = capture_queue_get_oldest()) == NULL) {
+            if (!g_cond_wait_until(&capture_queue_cond, &capture_queue_mtx, end_time))
+                break;
         }
-        pcap_queue_packets -= 1;
+        g_atomic_int_set(&capture_queue_writer_waiting, 0);
+        g_mutex_unlock(&capture_queue_mtx);
+        if (pcap_src == NULL)
+            return FALSE;
     }
-    g_async_queue_unlock(pcap_queue);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                  "Dequeued a block of type 0x%08x of length %d captured on interface %d.",
-                  queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
-                  queue_element->pcap_src->interface_id);
 
-            capture_loop_write_pcapng_cb(queue_element->pcap_src,
-                                        &queue_element->u.bh,
-                                        queue_element->pd);
-        } else {
-            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                "Dequeued a packet of length %d captured on interface %d.",
-                queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
+    slot = &pcap_src->queue.slots[(guint)pcap_src->queue.head & (pcap_src->queue.num_slots - 1)];
+    if (pcap_src->from_pcapng) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+              "Dequeued a block of type 0x%08x of length %d captured on interface %d.",
+              slot->u.bh.block_type, slot->u.bh.block_total_length,
+              pcap_src->interface_id);
 
-            capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
-                                        &queue_element->u.phdr,
-                                        queue_element->pd);
-        }
-        g_free(queue_element->pd);
-        g_free(queue_element);
-        return TRUE;
+        capture_loop_write_pcapng_cb(pcap_src, &slot->u.bh, slot->pd);
+        len = slot->u.bh.block_total_length;
+    } else {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+            "Dequeued a packet of length %d captured on interface %d.",
+            slot->u.phdr.caplen, pcap_src->interface_id);
+
+        capture_loop_write_packet_cb((u_char *) pcap_src, &slot->u.phdr, slot->pd);
+        len = slot->u.phdr.caplen;
     }
-    return FALSE;
+
+    /* We're done with the slot; let the capture thread reuse it. */
+    if (slot->pd_size > CAPTURE_QUEUE_MAX_KEPT_SIZE) {
+        g_free(slot->pd);
+        slot->pd = NULL;
+        slot->pd_size = 0;
+    }
+    g_atomic_int_add(&pcap_src->queue.bytes, -(gint)len);
+    g_atomic_int_set(&pcap_src->queue.head, (gint)((guint)pcap_src->queue.head + 1));
+    return TRUE;
 }
 
 /*
@@ -3912,6 +4486,11 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     capture_src      *pcap_src;
     interface_options *interface_opts;
     guint             i, error_index        = 0;
+    gboolean          opened;
+#ifdef __linux__
+    cpu_set_t         main_cpus;
+    gboolean          main_cpus_saved;
+#endif
 
     *errmsg           = '\0';
     *secondary_errmsg = '\0';
@@ -3939,13 +4518,22 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     capture_opts_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, capture_opts);
 
     /* open the "input file" from network interface or capture pipe */
-    if (!capture_loop_open_input(capture_opts, &global_ld, errmsg, sizeof(errmsg),
-                                 secondary_errmsg, sizeof(secondary_errmsg))) {
+#ifdef __linux__
+    /* capture_loop_place_src() moves us to the CPU of each source it opens */
+    main_cpus_saved = sched_getaffinity(0, sizeof main_cpus, &main_cpus) == 0;
+#endif
+    opened = capture_loop_open_input(capture_opts, &global_ld, errmsg, sizeof(errmsg),
+                                     secondary_errmsg, sizeof(secondary_errmsg));
+#ifdef __linux__
+    if (main_cpus_saved)
+        sched_setaffinity(0, sizeof main_cpus, &main_cpus);
+#endif
+    if (!opened) {
         goto error;
     }
-    for (i = 0; i < capture_opts->ifaces->len; i++) {
+    for (i = 0; i < global_ld.pcaps->len; i++) {
         pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
-        interface_opts = &g_array_index(capture_opts->ifaces, interface_options, i);
+        interface_opts = &g_array_index(capture_opts->ifaces, interface_options, pcap_src->interface_id);
         /* init the input filter from the network interface (capture pipe will do nothing) */
         /*
          * When remote capturing WinPCap crashes when the capture filter
@@ -3961,7 +4549,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 
         case INITFILTER_BAD_FILTER:
             cfilter_error = TRUE;
-            error_index = i;
+            error_index = pcap_src->interface_id;
             g_snprintf(errmsg, sizeof(errmsg), "%s", pcap_geterr(pcap_src->pcap_h));
             goto error;
 
@@ -4037,15 +4625,23 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
-        pcap_queue_bytes = 0;
-        pcap_queue_packets = 0;
+        /*
+         * Each thread sets up its own queue.  Until it does, the queue is
+         * all zeroes, so head == tail and the writer doesn't look at it.
+         */
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             /* XXX - Add an interface name here? */
             pcap_src->tid = g_thread_new("Capture read", pcap_read_handler, pcap_src);
         }
     }
+#ifdef __linux__
+    /* After starting the capture threads, which would otherwise inherit it */
+    if (writer_cpu >= 0 && !set_thread_cpu(writer_cpu)) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_WARNING,
+              "Could not pin the writer to CPU %d: %s", writer_cpu, g_strerror(errno));
+    }
+#endif
     while (global_ld.go) {
         /* dispatch incoming packets */
         if (use_threads) {
@@ -4099,19 +4695,18 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             }
         } /* inpkts */
 
-        /* Only update once every 500ms so as not to overload slow displays.
-         * This also prevents too much context-switching between the dumpcap
-         * and wireshark processes.
+        /* Only update once every update_interval ms (500ms by default) so
+         * as not to overload slow displays.  This also prevents too much
+         * context-switching between the dumpcap and wireshark processes.
          */
-#define DUMPCAP_UPD_TIME 500
 
 #ifdef _WIN32
         cur_time = GetTickCount();  /* Note: wraps to 0 if sys runs for 49.7 days */
-        if ((cur_time - upd_time) > DUMPCAP_UPD_TIME) /* wrap just causes an extra update */
+        if ((cur_time - upd_time) > capture_opts->update_interval) /* wrap just causes an extra update */
 #else
         gettimeofday(&cur_time, NULL);
         if (((guint64)cur_time.tv_sec * 1000000 + cur_time.tv_usec) >
-            ((guint64)upd_time.tv_sec * 1000000 + upd_time.tv_usec + DUMPCAP_UPD_TIME*1000))
+            ((guint64)upd_time.tv_sec * 1000000 + upd_time.tv_usec + (guint64)capture_opts->update_interval*1000))
 #endif
         {
 
@@ -4179,6 +4774,13 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 fflush(global_ld.pdh);
             }
         }
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
+                  "Queue of source %u of interface %u: at most %u packets queued, %u dropped",
+                  i, pcap_src->interface_id, pcap_src->queue.max_depth, pcap_src->dropped);
+            capture_queue_free(&pcap_src->queue);
+        }
     }
 
 
@@ -4189,7 +4791,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         g_timer_destroy(autostop_duration_timer);
 
     /* did we have a pcap (input) error? */
-    for (i = 0; i < capture_opts->ifaces->len; i++) {
+    for (i = 0; i < global_ld.pcaps->len; i++) {
         pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
         if (pcap_src->pcap_err) {
             /* On Linux, if an interface goes down while you're capturing on it,
@@ -4224,7 +4826,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             char *primary_msg;
             char *secondary_msg;
 
-            interface_opts = &g_array_index(capture_opts->ifaces, interface_options, i);
+            interface_opts = &g_array_index(capture_opts->ifaces, interface_options, pcap_src->interface_id);
             cap_err_str = pcap_geterr(pcap_src->pcap_h);
             if (strcmp(cap_err_str, "The interface went down") == 0 ||
                 strcmp(cap_err_str, "recvfrom: Network is down") == 0) {
@@ -4348,27 +4950,50 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 
     /* get packet drop statistics from pcap */
     for (i = 0; i < capture_opts->ifaces->len; i++) {
-        guint32 received;
+        guint32 received = 0;
         guint32 pcap_dropped = 0;
+        guint32 dropped = 0;
+        guint32 flushed = 0;
+        guint32 ps_ifdrop = 0;
+        guint j;
 
-        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
         interface_opts = &g_array_index(capture_opts->ifaces, interface_options, i);
-        received = pcap_src->received;
-        if (pcap_src->pcap_h != NULL) {
-            g_assert(!pcap_src->from_cap_pipe);
-            /* Get the capture statistics, so we know how many packets were dropped. */
-            if (pcap_stats(pcap_src->pcap_h, stats) >= 0) {
-                *stats_known = TRUE;
-                /* Let the parent process know. */
-                pcap_dropped += stats->ps_drop;
-            } else {
-                g_snprintf(errmsg, sizeof(errmsg),
-                           "Can't get packet-drop statistics: %s",
-                           pcap_geterr(pcap_src->pcap_h));
-                report_capture_error(errmsg, please_report_bug());
+
+        /* Add up the counts of all the sources of this interface. */
+        for (j = 0; j < global_ld.pcaps->len; j++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, j);
+            if (pcap_src->interface_id != i)
+                continue;
+            received += pcap_src->received;
+            dropped += pcap_src->dropped;
+            flushed += pcap_src->flushed;
+            if (pcap_src->pcap_h != NULL) {
+                g_assert(!pcap_src->from_cap_pipe);
+                /* Get the capture statistics, so we know how many packets were dropped. */
+                if (pcap_stats(pcap_src->pcap_h, stats) >= 0) {
+                    *stats_known = TRUE;
+                    /* Let the parent process know. */
+                    pcap_dropped += stats->ps_drop;
+                    ps_ifdrop += stats->ps_ifdrop;
+                } else {
+                    g_snprintf(errmsg, sizeof(errmsg),
+                               "Can't get packet-drop statistics: %s",
+                               pcap_geterr(pcap_src->pcap_h));
+                    report_capture_error(errmsg, please_report_bug());
+                }
             }
         }
-        report_packet_drops(received, pcap_dropped, pcap_src->dropped, pcap_src->flushed, stats->ps_ifdrop, interface_opts->display_name);
+        report_packet_drops(received, pcap_dropped, dropped, flushed, ps_ifdrop, interface_opts->display_name);
+
+        for (j = 0; j < global_ld.pcaps->len; j++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, j);
+            if (pcap_src->interface_id != i)
+                continue;
+            if (pcap_src->from_cap_pipe)
+                report_pipe_stats(pcap_src, interface_opts->display_name);
+            if (use_threads)
+                report_thread_stats(pcap_src, interface_opts->display_name);
+        }
     }
 
     /* close the input file (pcap or capture pipe) */
@@ -4496,6 +5121,10 @@ capture_loop_wrote_one_packet(capture_src *pcap_src) {
         global_ld.go = FALSE;
         return;
     }
+    /* -b writebehind:NUM */
+    if (global_capture_opts.multi_files_on) {
+        ringbuf_write_behind((gint64)global_ld.bytes_written);
+    }
     /* check -b packets:NUM */
     if (global_capture_opts.has_file_packets && global_ld.packets_written >= global_capture_opts.file_packets) {
         do_file_switch_or_stop(&global_capture_opts);
@@ -4556,7 +5185,11 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
                                        bh->block_total_length,
                                        &global_ld.bytes_written, &err);
 
-        fflush(global_ld.pdh);
+        /*
+         * Don't flush after each block; the capture loop does that once
+         * per update interval, or after each batch of packets when
+         * writing to a pipe, as it does for packets from pcap.
+         */
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
@@ -4635,8 +5268,7 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                              const u_char *pd)
 {
     capture_src        *pcap_src = (capture_src *) (void *) pcap_src_p;
-    pcap_queue_element *queue_element;
-    gboolean            limit_reached;
+    capture_queue_slot *slot;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4646,57 +5278,28 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
-    if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
-        pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
+    slot = capture_queue_get_free_slot(pcap_src, phdr->caplen);
+    if (slot == NULL) {
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-              "Queued a packet of length %d captured on interface %u.",
-              phdr->caplen, pcap_src->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
+    slot->u.phdr = *phdr;
+    slot->ts = (guint64)phdr->ts.tv_sec * 1000000000 +
+               (guint64)phdr->ts.tv_usec * (pcap_src->ts_nsec ? 1 : 1000);
+    memcpy(slot->pd, pd, phdr->caplen);
+    capture_queue_put_slot(pcap_src, phdr->caplen);
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+          "Queued a packet of length %d captured on interface %u.",
+          phdr->caplen, pcap_src->interface_id);
 }
 
 /* one pcapng block was captured, queue it */
 static void
 capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd)
 {
-    pcap_queue_element *queue_element;
-    gboolean            limit_reached;
+    capture_queue_slot *slot;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4706,49 +5309,21 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
-    if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.bh = *bh;
-    queue_element->pd = (u_char *)g_malloc(bh->block_total_length);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, bh->block_total_length);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += bh->block_total_length;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
-        pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
+    slot = capture_queue_get_free_slot(pcap_src, bh->block_total_length);
+    if (slot == NULL) {
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-              "Queued a block of type 0x%08x of length %d captured on interface %u.",
-              bh->block_type, bh->block_total_length, pcap_src->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
+    slot->u.bh = *bh;
+    /* Blocks from pcapng pipes don't have a time stamp we can use easily. */
+    slot->ts = 0;
+    memcpy(slot->pd, pd, bh->block_total_length);
+    capture_queue_put_slot(pcap_src, bh->block_total_length);
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+          "Queued a block of type 0x%08x of length %d captured on interface %u.",
+          bh->block_type, bh->block_total_length, pcap_src->interface_id);
 }
 
 static int
@@ -4828,6 +5403,9 @@ get_dumpcap_runtime_info(GString *str)
 
 #define LONGOPT_IFNAME             LONGOPT_BASE_APPLICATION+1
 #define LONGOPT_IFDESCR            LONGOPT_BASE_APPLICATION+2
+#define LONGOPT_FANOUT             LONGOPT_BASE_APPLICATION+3
+#define LONGOPT_CAPTURE_CPUS       LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_WRITER_CPU         LONGOPT_BASE_APPLICATION+5
 
 /* And now our feature presentation... [ fade to music ] */
 int
@@ -4841,6 +5419,13 @@ main(int argc, char *argv[])
         LONGOPT_CAPTURE_COMMON
         {"ifname", required_argument, NULL, LONGOPT_IFNAME},
         {"ifdescr", required_argument, NULL, LONGOPT_IFDESCR},
+#ifdef PACKET_FANOUT
+        {"fanout", required_argument, NULL, LONGOPT_FANOUT},
+#endif
+#ifdef __linux__
+        {"capture-cpus", required_argument, NULL, LONGOPT_CAPTURE_CPUS},
+        {"writer-cpu", required_argument, NULL, LONGOPT_WRITER_CPU},
+#endif
         {0, 0, 0, 0 }
     };
 
@@ -5195,6 +5780,7 @@ main(int argc, char *argv[])
         case 'I':        /* Monitor mode */
 #endif
         case LONGOPT_COMPRESS_TYPE:        /* compress type */
+        case LONGOPT_UPDATE_INTERVAL:      /* capture update interval */
             status = capture_opts_add_opt(&global_capture_opts, opt, optarg, &start_capture);
             if (status != 0) {
                 exit_main(status);
@@ -5223,6 +5809,51 @@ main(int argc, char *argv[])
                 exit_main(1);
             }
             break;
+#ifdef PACKET_FANOUT
+        case LONGOPT_FANOUT:
+        {
+            const char *endp;
+
+            if (!ws_strtoi32(optarg, &endp, &fanout_sockets) ||
+                fanout_sockets < 1 || fanout_sockets > 256) {
+                cmdarg_err("The --fanout socket count must be between 1 and 256");
+                exit_main(1);
+            }
+            if (*endp == '\0' || strcmp(endp, ",hash") == 0) {
+                fanout_cpu = FALSE;
+            } else if (strcmp(endp, ",cpu") == 0) {
+                fanout_cpu = TRUE;
+            } else {
+                cmdarg_err("Invalid --fanout argument: %s", optarg);
+                exit_main(1);
+            }
+            break;
+        }
+#endif
+#ifdef __linux__
+        case LONGOPT_CAPTURE_CPUS:
+            if (strcmp(optarg, "local") == 0) {
+                capture_cpus_local = TRUE;
+            } else {
+                capture_cpus = g_array_new(FALSE, FALSE, sizeof(int));
+                if (!parse_cpu_list(optarg, capture_cpus)) {
+                    cmdarg_err("Invalid --capture-cpus list: %s", optarg);
+                    exit_main(1);
+                }
+            }
+            break;
+        case LONGOPT_WRITER_CPU:
+        {
+            guint32 cpu;
+
+            if (!ws_strtou32(optarg, NULL, &cpu) || cpu >= CPU_SETSIZE) {
+                cmdarg_err("Invalid --writer-cpu CPU: %s", optarg);
+                exit_main(1);
+            }
+            writer_cpu = (int)cpu;
+            break;
+        }
+#endif
         case 'Z':
             capture_child = TRUE;
 #ifdef _WIN32
@@ -5330,6 +5961,18 @@ main(int argc, char *argv[])
     if ((pcap_queue_byte_limit > 0) || (pcap_queue_packet_limit > 0)) {
         use_threads = TRUE;
     }
+#ifdef PACKET_FANOUT
+    if (fanout_sockets > 1) {
+        /* Each socket of an interface is read by its own thread. */
+        use_threads = TRUE;
+    }
+#endif
+#ifdef __linux__
+    if (capture_cpus != NULL || capture_cpus_local) {
+        /* There must be capture threads to pin. */
+        use_threads = TRUE;
+    }
+#endif
     if ((pcap_queue_byte_limit == 0) && (pcap_queue_packet_limit == 0)) {
         /* Use some default if the user hasn't specified some */
         /* XXX: Are these defaults good enough? */
@@ -5828,6 +6471,76 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
     }
 }
 
+/*
+ * How fast a pipe or socket source, such as an extcap, fed us, and how
+ * many of our reads found it a whole read-ahead buffer ahead.  If most
+ * of them did, dumpcap rather than the source is holding the capture
+ * back, and the source is probably blocking on writes to the pipe.
+ */
+static void
+report_pipe_stats(const capture_src *pcap_src, const gchar *name)
+{
+    guint64 elapsed_us = create_timestamp() - start_time;
+    /* bytes per microsecond are megabytes per second */
+    double mb_per_s = elapsed_us ? (double)pcap_src->cap_pipe_read_bytes / elapsed_us : 0.0;
+
+    /* Windows named pipes are read by a thread that we don't count */
+    if (pcap_src->cap_pipe_reads == 0)
+        return;
+
+    if (capture_child || quiet) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Pipe input on interface '%s': %" G_GUINT64_FORMAT " bytes in %u reads (%u full), %.1f MB/s",
+            name, pcap_src->cap_pipe_read_bytes, pcap_src->cap_pipe_reads,
+            pcap_src->cap_pipe_full_reads, mb_per_s);
+    } else {
+        fprintf(stderr,
+            "Pipe input on interface '%s': %" G_GUINT64_FORMAT " bytes in %u reads (%u full, %.1f%%), %.1f MB/s\n",
+            name, pcap_src->cap_pipe_read_bytes, pcap_src->cap_pipe_reads,
+            pcap_src->cap_pipe_full_reads,
+            100.0 * pcap_src->cap_pipe_full_reads / pcap_src->cap_pipe_reads, mb_per_s);
+        fflush(stderr);
+    }
+}
+
+/*
+ * Where the capture thread of a source ran and how its queue to the
+ * writer filled up, to check the placement asked for with --capture-cpus
+ * and --writer-cpu, and whether the queue limits are big enough.
+ */
+static void
+report_thread_stats(const capture_src *pcap_src, const gchar *name)
+{
+    GString *where = g_string_new(NULL);
+    gboolean placed = FALSE;
+
+#ifdef __linux__
+    placed = capture_cpus != NULL || capture_cpus_local || writer_cpu >= 0;
+#endif
+    if (pcap_src->cpu >= 0)
+        g_string_append_printf(where, "pinned to CPU %d", pcap_src->cpu);
+    else
+        g_string_append(where, "not pinned");
+    if (pcap_src->last_cpu >= 0)
+        g_string_append_printf(where, ", last on CPU %d, %u migrations",
+                               pcap_src->last_cpu, pcap_src->migrations);
+    if (pcap_src->numa_node >= 0)
+        g_string_append_printf(where, ", interface on node %d", pcap_src->numa_node);
+
+    if (capture_child || quiet || !placed) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Capture thread on interface '%s': %s; %u packets queued, at most %u at once, %u dropped",
+            name, where->str, pcap_src->received, pcap_src->queue.max_depth, pcap_src->dropped);
+    } else {
+        fprintf(stderr,
+            "Capture thread on interface '%s': %s; %u packets queued, at most %u of %u at once, %u dropped\n",
+            name, where->str, pcap_src->received, pcap_src->queue.max_depth,
+            pcap_src->queue.num_slots, pcap_src->dropped);
+        fflush(stderr);
+    }
+    g_string_free(where, TRUE);
+}
+
 
 /************************************************************************************************/
 /* signal_pipe handling */
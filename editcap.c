@@ -106,19 +106,33 @@ struct select_item {
 
 /*
  * Duplicate frame detection
+ *
+ * The frames in the window are kept in fd_hash[], a ring in the order in
+ * which they were seen, and each is also on a hash chain for its digest,
+ * so that looking for a duplicate doesn't mean comparing against every
+ * frame in the window.
  */
 typedef struct _fd_hash_t {
     guint8     digest[16];
     guint32    len;
     nstime_t   frame_time;
+    guint32    prev;            /* previous (newer) entry on the same chain */
+    guint32    next;            /* next (older) entry on the same chain */
 } fd_hash_t;
 
 #define DEFAULT_DUP_DEPTH       5   /* Used with -d */
-#define MAX_DUP_DEPTH     1000000   /* the maximum window (and actual size of fd_hash[]) for de-duplication */
-
-static fd_hash_t fd_hash[MAX_DUP_DEPTH];
-static int       dup_window    = DEFAULT_DUP_DEPTH;
-static int       cur_dup_entry = 0;
+#define MAX_DUP_DEPTH     1000000   /* the maximum window for de-duplication by packet count */
+#define FD_HASH_TIME_SIZE    4096   /* initial size of fd_hash[] for -w; it grows as needed */
+#define FD_HASH_NONE   G_MAXUINT32  /* no entry */
+
+static fd_hash_t *fd_hash;              /* ring of the frames in the window */
+static guint32    fd_hash_size;         /* number of entries in fd_hash[] */
+static guint32    fd_hash_oldest;       /* entry for the oldest frame in the window */
+static guint32    fd_hash_count;        /* number of frames in the window */
+static guint32   *fd_hash_chains;       /* newest entry on each hash chain */
+static guint32    fd_hash_chain_mask;   /* number of hash chains - 1 */
+static int        dup_window    = DEFAULT_DUP_DEPTH;
+static guint32    cur_dup_entry = 0;    /* entry for the current frame */
 
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
@@ -170,6 +184,7 @@ static nstime_t               starttime                 = NSTIME_INIT_ZERO;
 static gboolean               have_starttime            = FALSE;
 static nstime_t               stoptime                  = NSTIME_INIT_ZERO;
 static gboolean               have_stoptime             = FALSE;
+static gboolean               time_ordered              = FALSE;
 static gboolean               check_startstop           = FALSE;
 static gboolean               rem_vlan                  = FALSE;
 static gboolean               dup_detect                = FALSE;
@@ -590,15 +605,118 @@ remove_vlan_info(const wtap_packet_header *phdr, guint8* fd, guint32* len) {
     }
 }
 
+static void
+fd_hash_init(guint32 size)
+{
+    guint32 nchains;
+
+    fd_hash = g_new(fd_hash_t, size);
+    fd_hash_size = size;
+    fd_hash_oldest = 0;
+    fd_hash_count = 0;
+
+    /* No more frames than chains. */
+    for (nchains = 1; nchains < size; nchains <<= 1)
+        ;
+    fd_hash_chains = g_new(guint32, nchains);
+    memset(fd_hash_chains, 0xff, nchains * sizeof (guint32));  /* FD_HASH_NONE */
+    fd_hash_chain_mask = nchains - 1;
+}
+
+static void
+fd_hash_cleanup(void)
+{
+    g_free(fd_hash);
+    fd_hash = NULL;
+    g_free(fd_hash_chains);
+    fd_hash_chains = NULL;
+}
+
+static guint32
+fd_hash_chain(const fd_hash_t *entry)
+{
+    guint32 hash;
+
+    /* The digest is an MD5 hash, so any 32 bits of it will do. */
+    memcpy(&hash, entry->digest, sizeof hash);
+    return (hash ^ entry->len) & fd_hash_chain_mask;
+}
+
+/* Put entry i at the head of its chain */
+static void
+fd_hash_link(guint32 i)
+{
+    guint32 *head = &fd_hash_chains[fd_hash_chain(&fd_hash[i])];
+
+    fd_hash[i].prev = FD_HASH_NONE;
+    fd_hash[i].next = *head;
+    if (*head != FD_HASH_NONE)
+        fd_hash[*head].prev = i;
+    *head = i;
+}
+
+/* Drop the oldest frame from the window */
+static void
+fd_hash_remove_oldest(void)
+{
+    fd_hash_t *entry = &fd_hash[fd_hash_oldest];
+
+    if (entry->prev != FD_HASH_NONE)
+        fd_hash[entry->prev].next = entry->next;
+    else
+        fd_hash_chains[fd_hash_chain(entry)] = entry->next;
+    if (entry->next != FD_HASH_NONE)
+        fd_hash[entry->next].prev = entry->prev;
+
+    fd_hash_oldest = (fd_hash_oldest + 1) % fd_hash_size;
+    fd_hash_count--;
+}
+
+/* Double the size of fd_hash[], for a time window with more frames in it */
+static void
+fd_hash_grow(void)
+{
+    fd_hash_t *old_hash = fd_hash;
+    guint32 old_size = fd_hash_size;
+    guint32 old_oldest = fd_hash_oldest;
+    guint32 count = fd_hash_count;
+    guint32 i;
+
+    g_free(fd_hash_chains);
+    fd_hash_init(old_size * 2);
+    for (i = 0; i < count; i++) {
+        fd_hash[i] = old_hash[(old_oldest + i) % old_size];
+        fd_hash_link(i);
+    }
+    fd_hash_count = count;
+    g_free(old_hash);
+}
+
+/* Add the current frame to the window as cur_dup_entry, computing its digest */
+static fd_hash_t *
+fd_hash_add(const guint8 *fd, guint32 len, guint32 offset)
+{
+    fd_hash_t *entry;
+
+    cur_dup_entry = (fd_hash_oldest + fd_hash_count) % fd_hash_size;
+    entry = &fd_hash[cur_dup_entry];
+
+    /* Calculate our digest */
+    gcry_md_hash_buffer(GCRY_MD_MD5, entry->digest, &fd[offset], len - offset);
+    entry->len = len;
+    nstime_set_unset(&entry->frame_time);
+    return entry;
+}
+
 static gboolean
 is_duplicate(guint8* fd, guint32 len) {
-    int i;
     const struct ieee80211_radiotap_header* tap_header;
+    fd_hash_t *entry;
+    guint32 i;
+    gboolean dup = FALSE;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
 
     if (len <= ignored_bytes) {
         offset = 0;
@@ -612,102 +730,67 @@ is_duplicate(guint8* fd, guint32 len) {
             offset = 0;
     }
 
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
-
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
+    /* The window is the previous dup_window - 1 frames. */
+    if (fd_hash_count == fd_hash_size)
+        fd_hash_remove_oldest();
+    entry = fd_hash_add(fd, len, offset);
 
     /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
-
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
+    for (i = fd_hash_chains[fd_hash_chain(entry)]; i != FD_HASH_NONE; i = fd_hash[i].next) {
+        if (fd_hash[i].len == entry->len
+            && memcmp(fd_hash[i].digest, entry->digest, 16) == 0) {
+            dup = TRUE;
+            break;
         }
     }
 
-    return FALSE;
+    fd_hash_link(cur_dup_entry);
+    fd_hash_count++;
+    return dup;
 }
 
 static gboolean
 is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
-    int i;
+    fd_hash_t *entry;
+    nstime_t delta;
+    guint32 i;
+    gboolean dup = FALSE;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
 
     if (len <= ignored_bytes) {
         offset = 0;
     }
 
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
-
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
-    fd_hash[cur_dup_entry].frame_time.secs = current->secs;
-    fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
-
     /*
-     * Look for relative time related duplicates.
-     * This is hopefully a reasonably efficient mechanism for
-     * finding duplicates by rel time in the fd_hash[] cache.
-     * We check starting from the most recently added hash
-     * entries and work backwards towards older packets.
-     * This approach allows the dup test to be terminated
-     * when the relative time of a cached entry is found to
-     * be beyond the dup time window.
-     *
-     * Of course this assumes that the input trace file is
-     * "well-formed" in the sense that the packet timestamps are
-     * in strict chronologically increasing order (which is NOT
-     * always the case!!).
-     *
-     * The fd_hash[] table was deliberately created large (1,000,000).
-     * Looking for time related duplicates in large trace files with
-     * non-fractional dup time window values can potentially take
-     * a long time to complete.
+     * Drop the frames that are now more than the dup time window
+     * before the current one.  This assumes that the input trace file
+     * is "well-formed" in the sense that the packet timestamps are in
+     * strict chronologically increasing order (which is NOT always the
+     * case!!); a frame that arrived earlier than the oldest one in the
+     * window doesn't drop anything.
      */
-
-    for (i = cur_dup_entry - 1;; i--) {
-        nstime_t delta;
-        int cmp;
-
-        if (i < 0)
-            i = dup_window - 1;
-
-        if (i == cur_dup_entry) {
-            /*
-             * We've decremented back to where we started.
-             * Check no more!
-             */
+    while (fd_hash_count != 0) {
+        nstime_delta(&delta, current, &fd_hash[fd_hash_oldest].frame_time);
+        if (nstime_cmp(&delta, &relative_time_window) <= 0)
             break;
-        }
+        fd_hash_remove_oldest();
+    }
+    if (fd_hash_count == fd_hash_size)
+        fd_hash_grow();
 
-        if (nstime_is_unset(&(fd_hash[i].frame_time))) {
-            /*
-             * We've decremented to an unused fd_hash[] entry.
-             * Check no more!
-             */
-            break;
-        }
+    entry = fd_hash_add(fd, len, offset);
+    entry->frame_time = *current;
+
+    /*
+     * Look for relative time related duplicates, starting from the
+     * most recently added frames with the same digest.
+     */
+    for (i = fd_hash_chains[fd_hash_chain(entry)]; i != FD_HASH_NONE; i = fd_hash[i].next) {
+        if (fd_hash[i].len != entry->len
+            || memcmp(fd_hash[i].digest, entry->digest, 16) != 0)
+            continue;
 
         nstime_delta(&delta, current, &fd_hash[i].frame_time);
 
@@ -719,36 +802,27 @@ is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
              * situation since trace files usually have packets in
              * chronological order (oldest to newest).
              *
-             * There are several possible ways to deal with this:
-             * 1. 'continue' dup checking with the next cached frame.
-             * 2. 'break' from looking for a duplicate of the current frame.
-             * 3. Take the absolute value of the delta and see if that
-             * falls within the specifed dup time window.
-             *
-             * Currently this code does option 1.  But it would pretty
-             * easy to add yet-another-editcap-option to select one of
-             * the other behaviors for dealing with out-of-sequence
-             * packets.
+             * Keep looking at older cached frames.
              */
             continue;
         }
 
-        cmp = nstime_cmp(&delta, &relative_time_window);
-
-        if (cmp > 0) {
+        if (nstime_cmp(&delta, &relative_time_window) > 0) {
             /*
              * The delta time indicates that we are now looking at
              * cached packets beyond the specified dup time window.
              * Check no more!
              */
             break;
-        } else if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-                   && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
         }
+
+        dup = TRUE;
+        break;
     }
 
-    return FALSE;
+    fd_hash_link(cur_dup_entry);
+    fd_hash_count++;
+    return dup;
 }
 
 static void
@@ -769,6 +843,9 @@ print_usage(FILE *output)
     fprintf(output, "                         Time format for -A/-B options is\n");
     fprintf(output, "                         YYYY-MM-DDThh:mm:ss[.nnnnnnnnn][Z|+-hh:mm]\n");
     fprintf(output, "                         Unix epoch timestamps are also supported.\n");
+    fprintf(output, "  --time-ordered         assume packets are in time order; seek to the -A\n");
+    fprintf(output, "                         time and stop at the -B time rather than reading\n");
+    fprintf(output, "                         the whole file.\n");
     fprintf(output, "\n");
     fprintf(output, "Duplicate packet removal:\n");
     fprintf(output, "  --novlan               remove vlan info from packets before checking for duplicates.\n");
@@ -989,6 +1066,229 @@ editcap_cmdarg_err_cont(const char *msg_format, va_list ap)
     fprintf(stderr, "\n");
 }
 
+/*
+ * Reading ahead.  The input file is read, and decompressed if need be, by
+ * another thread, into a ring of slots, so that that overlaps with editing
+ * the records and writing them out.  Once the thread is running only it
+ * may use the wtap, so the IDBs and DSBs that were read along with each
+ * record are handed over along with it.
+ */
+#define READ_AHEAD_SLOTS    256
+
+typedef struct {
+    wtap_rec    rec;
+    Buffer      buf;
+    gboolean    got_record;     /* FALSE at EOF or on an error */
+    int         err;
+    gchar      *err_info;
+    gint64      data_offset;
+    GArray     *idbs;           /* IDBs read along with this record, or NULL */
+    GArray     *dsbs;           /* DSBs read along with this record, or NULL */
+} read_ahead_slot_t;
+
+typedef struct {
+    wtap       *wth;
+    GThread    *thread;
+    GMutex      mutex;
+    GCond       not_empty;
+    GCond       not_full;
+    guint       head;           /* first filled slot */
+    guint       count;          /* number of filled slots */
+    gboolean    stop;           /* TRUE if the thread should quit */
+    const GArray *in_dsbs;      /* the input file's DSBs, or NULL */
+    guint       dsbs_read;      /* number of in_dsbs seen by the thread */
+    GArray     *idbs;           /* IDBs not yet given to process_new_idbs() */
+    GArray     *dsbs;           /* the DSBs handed over so far */
+    read_ahead_slot_t slots[READ_AHEAD_SLOTS];
+} read_ahead_t;
+
+static read_ahead_t *read_ahead = NULL;
+
+static gpointer
+read_ahead_thread(gpointer data)
+{
+    read_ahead_t *ra = (read_ahead_t *)data;
+    read_ahead_slot_t *slot;
+    wtap_block_t if_data;
+    const GArray *in_dsb;
+    gboolean got_record;
+
+    do {
+        g_mutex_lock(&ra->mutex);
+        while (ra->count == READ_AHEAD_SLOTS && !ra->stop)
+            g_cond_wait(&ra->not_full, &ra->mutex);
+        if (ra->stop) {
+            g_mutex_unlock(&ra->mutex);
+            break;
+        }
+        slot = &ra->slots[(ra->head + ra->count) % READ_AHEAD_SLOTS];
+        g_mutex_unlock(&ra->mutex);
+
+        /* The slot isn't filled yet, so the main thread leaves it alone. */
+        got_record = wtap_read(ra->wth, &slot->rec, &slot->buf, &slot->err,
+                               &slot->err_info, &slot->data_offset);
+        slot->got_record = got_record;
+        while ((if_data = wtap_get_next_interface_description(ra->wth)) != NULL) {
+            if (slot->idbs == NULL)
+                slot->idbs = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
+            g_array_append_val(slot->idbs, if_data);
+        }
+        in_dsb = ra->in_dsbs;
+        if (in_dsb != NULL && in_dsb->len > ra->dsbs_read) {
+            slot->dsbs = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
+            g_array_append_vals(slot->dsbs,
+                                &g_array_index(in_dsb, wtap_block_t, ra->dsbs_read),
+                                in_dsb->len - ra->dsbs_read);
+            ra->dsbs_read = in_dsb->len;
+        }
+
+        g_mutex_lock(&ra->mutex);
+        ra->count++;
+        g_cond_signal(&ra->not_empty);
+        g_mutex_unlock(&ra->mutex);
+    } while (got_record);
+
+    return NULL;
+}
+
+/*
+ * Start reading ahead from wth, whose DSBs are in_dsbs; from now on the
+ * dumpers must get the DSBs from read_ahead->dsbs instead.
+ */
+static void
+read_ahead_start(wtap *wth, const GArray *in_dsbs)
+{
+    read_ahead_t *ra;
+    guint i;
+
+    ra = g_new0(read_ahead_t, 1);
+    ra->wth = wth;
+    ra->in_dsbs = in_dsbs;
+    g_mutex_init(&ra->mutex);
+    g_cond_init(&ra->not_empty);
+    g_cond_init(&ra->not_full);
+    for (i = 0; i < READ_AHEAD_SLOTS; i++) {
+        wtap_rec_init(&ra->slots[i].rec);
+        ws_buffer_init(&ra->slots[i].buf, 1514);
+    }
+    ra->idbs = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
+    ra->dsbs = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
+
+    ra->thread = g_thread_try_new("editcap read-ahead", read_ahead_thread,
+                                  ra, NULL);
+    if (ra->thread == NULL) {
+        /* No thread; just read the file ourselves. */
+        for (i = 0; i < READ_AHEAD_SLOTS; i++) {
+            wtap_rec_cleanup(&ra->slots[i].rec);
+            ws_buffer_free(&ra->slots[i].buf);
+        }
+        g_array_free(ra->idbs, TRUE);
+        g_array_free(ra->dsbs, TRUE);
+        g_cond_clear(&ra->not_full);
+        g_cond_clear(&ra->not_empty);
+        g_mutex_clear(&ra->mutex);
+        g_free(ra);
+        return;
+    }
+    read_ahead = ra;
+}
+
+/*
+ * Stop reading ahead, if we are, and throw away whatever was read that
+ * we didn't use.  This must be done before closing the wtap, and after
+ * closing the last dumper, as that may refer to the DSBs.
+ */
+static void
+read_ahead_stop(void)
+{
+    read_ahead_t *ra = read_ahead;
+    guint i;
+
+    if (ra == NULL)
+        return;
+
+    g_mutex_lock(&ra->mutex);
+    ra->stop = TRUE;
+    g_cond_signal(&ra->not_full);
+    g_mutex_unlock(&ra->mutex);
+    g_thread_join(ra->thread);
+
+    for (i = 0; i < ra->count; i++)
+        g_free(ra->slots[(ra->head + i) % READ_AHEAD_SLOTS].err_info);
+    for (i = 0; i < READ_AHEAD_SLOTS; i++) {
+        wtap_rec_cleanup(&ra->slots[i].rec);
+        ws_buffer_free(&ra->slots[i].buf);
+        if (ra->slots[i].idbs != NULL)
+            g_array_free(ra->slots[i].idbs, TRUE);
+        if (ra->slots[i].dsbs != NULL)
+            g_array_free(ra->slots[i].dsbs, TRUE);
+    }
+    g_array_free(ra->idbs, TRUE);
+    g_array_free(ra->dsbs, TRUE);
+    g_cond_clear(&ra->not_full);
+    g_cond_clear(&ra->not_empty);
+    g_mutex_clear(&ra->mutex);
+    g_free(ra);
+    read_ahead = NULL;
+}
+
+/*
+ * Read the next record, from the read-ahead thread if there is one;
+ * returns what wtap_read() would.
+ */
+static gboolean
+editcap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+             gchar **err_info, gint64 *data_offset)
+{
+    read_ahead_t *ra = read_ahead;
+    read_ahead_slot_t *slot;
+    wtap_rec tmp_rec;
+    Buffer tmp_buf;
+
+    if (ra == NULL)
+        return wtap_read(wth, rec, buf, err, err_info, data_offset);
+
+    g_mutex_lock(&ra->mutex);
+    while (ra->count == 0)
+        g_cond_wait(&ra->not_empty, &ra->mutex);
+    slot = &ra->slots[ra->head];
+    g_mutex_unlock(&ra->mutex);
+
+    /*
+     * Swap the record and its data with the caller's, which the thread
+     * can read a later record into.
+     */
+    tmp_rec = *rec;
+    *rec = slot->rec;
+    slot->rec = tmp_rec;
+    tmp_buf = *buf;
+    *buf = slot->buf;
+    slot->buf = tmp_buf;
+
+    *err = slot->err;
+    *err_info = slot->err_info;
+    slot->err_info = NULL;
+    *data_offset = slot->data_offset;
+    if (slot->idbs != NULL) {
+        g_array_append_vals(ra->idbs, slot->idbs->data, slot->idbs->len);
+        g_array_free(slot->idbs, TRUE);
+        slot->idbs = NULL;
+    }
+    if (slot->dsbs != NULL) {
+        g_array_append_vals(ra->dsbs, slot->dsbs->data, slot->dsbs->len);
+        g_array_free(slot->dsbs, TRUE);
+        slot->dsbs = NULL;
+    }
+
+    g_mutex_lock(&ra->mutex);
+    ra->head = (ra->head + 1) % READ_AHEAD_SLOTS;
+    ra->count--;
+    g_cond_signal(&ra->not_full);
+    g_mutex_unlock(&ra->mutex);
+
+    return slot->got_record;
+}
+
 static wtap_dumper *
 editcap_dump_open(const char *filename, const wtap_dump_params *params,
                   GArray *idbs_seen, int *err, gchar **err_info)
@@ -1040,8 +1340,20 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, GArray *idbs_seen,
                  int *err, gchar **err_info)
 {
     wtap_block_t if_data;
+    guint idb_idx = 0;
+
+    for (;;) {
+        if (read_ahead != NULL) {
+            /* The read-ahead thread has already fetched them. */
+            if (idb_idx == read_ahead->idbs->len)
+                break;
+            if_data = g_array_index(read_ahead->idbs, wtap_block_t, idb_idx++);
+        } else {
+            if_data = wtap_get_next_interface_description(wth);
+            if (if_data == NULL)
+                break;
+        }
 
-    while ((if_data = wtap_get_next_interface_description(wth)) != NULL) {
         /*
          * Only add interface blocks if the output file supports (meaning
          * *requires*) them.
@@ -1069,6 +1381,8 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, GArray *idbs_seen,
             g_array_append_val(idbs_seen, if_data_copy);
         }
     }
+    if (read_ahead != NULL)
+        g_array_set_size(read_ahead->idbs, 0);
     return TRUE;
 }
 
@@ -1100,6 +1414,7 @@ main(int argc, char *argv[])
 #define LONGOPT_DISCARD_ALL_SECRETS  LONGOPT_BASE_APPLICATION+5
 #define LONGOPT_CAPTURE_COMMENT      LONGOPT_BASE_APPLICATION+6
 #define LONGOPT_DISCARD_CAPTURE_COMMENT LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_TIME_ORDERED         LONGOPT_BASE_APPLICATION+8
 
     static const struct option long_options[] = {
         {"novlan", no_argument, NULL, LONGOPT_NO_VLAN},
@@ -1111,6 +1426,7 @@ main(int argc, char *argv[])
         {"version", no_argument, NULL, 'V'},
         {"capture-comment", required_argument, NULL, LONGOPT_CAPTURE_COMMENT},
         {"discard-capture-comment", no_argument, NULL, LONGOPT_DISCARD_CAPTURE_COMMENT},
+        {"time-ordered", no_argument, NULL, LONGOPT_TIME_ORDERED},
         {0, 0, 0, 0 }
     };
 
@@ -1266,6 +1582,12 @@ main(int argc, char *argv[])
             break;
         }
 
+        case LONGOPT_TIME_ORDERED:
+        {
+            time_ordered = TRUE;
+            break;
+        }
+
         case 'a':
         {
             guint frame_number;
@@ -1482,7 +1804,6 @@ main(int argc, char *argv[])
         case 'w':
             dup_detect = FALSE;
             dup_detect_by_time = TRUE;
-            dup_window = MAX_DUP_DEPTH;
             if (!set_rel_time(optarg)) {
                 ret = INVALID_OPTION;
                 goto clean_exit;
@@ -1687,15 +2008,21 @@ main(int argc, char *argv[])
         if (add_selection(argv[i], &max_packet_number) == FALSE)
             break;
 
+    if (time_ordered && max_selected != 0) {
+        /* Seeking loses track of the packet numbers. */
+        fprintf(stderr, "editcap: --time-ordered can't be used with packet selections\n");
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+
     if (!keep_em)
         max_packet_number = G_MAXUINT;
 
-    if (dup_detect || dup_detect_by_time) {
-        for (i = 0; i < dup_window; i++) {
-            memset(&fd_hash[i].digest, 0, 16);
-            fd_hash[i].len = 0;
-            nstime_set_unset(&fd_hash[i].frame_time);
-        }
+    if (dup_detect) {
+        /* A window of 0 packets finds no duplicates, just like 1. */
+        fd_hash_init(dup_window > 0 ? dup_window : 1);
+    } else if (dup_detect_by_time) {
+        fd_hash_init(FD_HASH_TIME_SIZE);
     }
 
     /* Set up an array of all IDBs seen */
@@ -1704,7 +2031,21 @@ main(int argc, char *argv[])
     /* Read all of the packets in turn */
     wtap_rec_init(&read_rec);
     ws_buffer_init(&read_buf, 1514);
-    while (wtap_read(wth, &read_rec, &read_buf, &read_err, &read_err_info, &data_offset)) {
+    if (time_ordered && have_starttime &&
+        !wtap_seek_time(wth, &starttime, &read_err, &read_err_info)) {
+        if (read_err != 0) {
+            cfile_read_failure_message(argv[optind], read_err, read_err_info);
+            ret = INVALID_FILE;
+            goto clean_exit;
+        }
+        /* Can't seek in this file; just read up to the start time. */
+    }
+    read_ahead_start(wth, params.dsbs_growing);
+    if (read_ahead != NULL && params.dsbs_growing != NULL) {
+        /* Only the read-ahead thread may look at the input's DSBs now. */
+        params.dsbs_growing = read_ahead->dsbs;
+    }
+    while (editcap_read(wth, &read_rec, &read_buf, &read_err, &read_err_info, &data_offset)) {
         /*
          * XXX - what about non-packet records in the file after this?
          * We can *probably* ignore IDBs after this point, as they
@@ -1840,6 +2181,10 @@ main(int argc, char *argv[])
              * If the packet has no time stamp, the answer is "no".
              */
             if (rec->presence_flags & WTAP_HAS_TS) {
+                /* With time order, nothing after this is wanted. */
+                if (time_ordered && have_stoptime &&
+                    nstime_cmp(&rec->ts, &stoptime) >= 0)
+                    break;
                 if (have_starttime && have_stoptime) {
                     ts_okay = nstime_cmp(&rec->ts, &starttime) >= 0 &&
                               nstime_cmp(&rec->ts, &stoptime) < 0;
@@ -2244,6 +2589,15 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
     g_free(filename);
+    read_ahead_stop();
+
+    if (verbose) {
+        guint64 rec_allocs = wtap_get_rec_allocation_count(wth);
+
+        fprintf(stderr, "%u record%s read, with %" G_GUINT64_FORMAT " allocation%s made while reading them.\n",
+                read_count, plurality(read_count, "", "s"), rec_allocs,
+                plurality(rec_allocs, "", "s"));
+    }
 
     if (frames_user_comments) {
         g_tree_destroy(frames_user_comments);
@@ -2262,6 +2616,8 @@ main(int argc, char *argv[])
     }
 
 clean_exit:
+    read_ahead_stop();
+    fd_hash_cleanup();
     if (dsb_filenames) {
         g_array_free(dsb_types, TRUE);
         g_ptr_array_free(dsb_filenames, TRUE);
@@ -219,6 +219,8 @@ struct cb_serv_data {
 // Maps guint -> hashmanuf_t*
 static wmem_map_t *manuf_hashtable = NULL;
 static wmem_map_t *wka_hashtable = NULL;
+/* Bit N set if there's a well-known address range with an N-bit mask */
+static guint64 wka_mask_lengths = 0;
 static wmem_map_t *eth_hashtable = NULL;
 // Maps guint -> serv_port_t*
 static wmem_map_t *serv_port_hashtable = NULL;
@@ -1573,13 +1575,15 @@ manuf_hash_new_entry(const guint8 *addr, char* name, char* longname)
 }
 
 static void
-wka_hash_new_entry(const guint8 *addr, char* name)
+wka_hash_new_entry(const guint8 *addr, const unsigned int mask, char* name)
 {
     guint8 *wka_key;
 
     wka_key = (guint8 *)wmem_alloc(wmem_epan_scope(), 6);
     memcpy(wka_key, addr, 6);
 
+    wka_mask_lengths |= G_GUINT64_CONSTANT(1) << mask;
+
     wmem_map_insert(wka_hashtable, wka_key, wmem_strdup(wmem_epan_scope(), name));
 }
 
@@ -1600,7 +1604,7 @@ add_manuf_name(const guint8 *addr, unsigned int mask, gchar *name, gchar *longna
 
     default:
         /* This is a range of well-known addresses; add it to the well-known-address table */
-        wka_hash_new_entry(addr, name);
+        wka_hash_new_entry(addr, mask, name);
         break;
     }
 } /* add_manuf_name */
@@ -1657,6 +1661,14 @@ wka_name_lookup(const guint8 *addr, const unsigned int mask)
     if (wka_hashtable == NULL) {
         return NULL;
     }
+    /*
+     * Address resolution tries every mask length in turn, but only
+     * a handful of them are used by the ranges we know about, so
+     * don't bother hashing the address for the others.
+     */
+    if (!(wka_mask_lengths & (G_GUINT64_CONSTANT(1) << mask))) {
+        return NULL;
+    }
     /* Get the part of the address covered by the mask. */
     for (i = 0, num = mask; num >= 8; i++, num -= 8)
         masked_addr[i] = addr[i];   /* copy octets entirely covered by the mask */
@@ -1709,6 +1721,7 @@ initialize_ethers(void)
 
     /* hash table initialization */
     wka_hashtable   = wmem_map_new(wmem_epan_scope(), eth_addr_hash, eth_addr_cmp);
+    wka_mask_lengths = 0;
     manuf_hashtable = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
     eth_hashtable   = wmem_map_new(wmem_epan_scope(), eth_addr_hash, eth_addr_cmp);
 
@@ -2913,22 +2926,12 @@ disable_name_resolution(void) {
     gbl_resolv_flags.ss7pc_name                         = FALSE;
 }
 
-gboolean
-host_name_lookup_process(void) {
+/* Send queued asynchronous requests, up to the concurrency limit */
+static void
+process_async_dns_queue(void) {
     async_dns_queue_msg_t *caqm;
-    struct timeval tv = { 0, 0 };
-    int nfds;
-    fd_set rfds, wfds;
-    gboolean nro = new_resolved_objects;
     wmem_list_frame_t* head;
 
-    new_resolved_objects = FALSE;
-    nro |= maxmind_db_lookup_process();
-
-    if (!async_dns_initialized)
-        /* c-ares not initialized. Bail out and cancel timers. */
-        return nro;
-
     head = wmem_list_head(async_dns_queue_head);
 
     while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
@@ -2946,6 +2949,23 @@ host_name_lookup_process(void) {
 
         head = wmem_list_head(async_dns_queue_head);
     }
+}
+
+gboolean
+host_name_lookup_process(void) {
+    struct timeval tv = { 0, 0 };
+    int nfds;
+    fd_set rfds, wfds;
+    gboolean nro = new_resolved_objects;
+
+    new_resolved_objects = FALSE;
+    nro |= maxmind_db_lookup_process();
+
+    if (!async_dns_initialized)
+        /* c-ares not initialized. Bail out and cancel timers. */
+        return nro;
+
+    process_async_dns_queue();
 
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
@@ -2964,6 +2984,43 @@ host_name_lookup_process(void) {
     return nro;
 }
 
+void
+host_name_lookup_wait(void) {
+    struct timeval tv;
+    int nfds;
+    fd_set rfds, wfds;
+
+    if (!async_dns_initialized)
+        return;
+
+    while (wmem_list_count(async_dns_queue_head) != 0 || async_dns_in_flight != 0) {
+        process_async_dns_queue();
+
+        /*
+         * Wait for replies to show up; c-ares handles its own
+         * timeouts and retries when ares_process() is called, so
+         * every request eventually completes, one way or another.
+         * See wait_for_sync_resolv() for why the timeout is reset
+         * each time.
+         */
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        nfds = ares_fds(ghba_chan, &rfds, &wfds);
+        if (nfds <= 0)
+            break;
+        if (select(nfds, &rfds, &wfds, NULL, &tv) == -1) { /* call to select() failed */
+            /* If it's interrupted by a signal, no need to put out a message */
+            if (errno != EINTR)
+                fprintf(stderr, "Warning: call to select() failed, error is %s\n", g_strerror(errno));
+            return;
+        }
+        ares_process(ghba_chan, &rfds, &wfds);
+    }
+}
+
 static void
 _host_name_lookup_cleanup(void) {
     async_dns_queue_head = NULL;
@@ -194,6 +194,17 @@ WS_DLL_PUBLIC void disable_name_resolution(void);
  */
 WS_DLL_PUBLIC gboolean host_name_lookup_process(void);
 
+/*
+ * host_name_lookup_wait() sends all the queued asynchronous address-to-name
+ * requests, at most "name_resolve_concurrency" of them at a time, and waits
+ * until all of them have completed.
+ *
+ *  This is called by TShark between the two passes of a two-pass analysis,
+ *  so that every address seen in the first pass is resolved in bulk before
+ *  the second pass prints anything.
+ */
+WS_DLL_PUBLIC void host_name_lookup_wait(void);
+
 /* get_hostname returns the host name or "%d.%d.%d.%d" if not found */
 WS_DLL_PUBLIC const gchar *get_hostname(const guint addr);
 
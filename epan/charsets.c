@@ -11,8 +11,13 @@
 #include "config.h"
 
 #include <errno.h>
+#include <string.h>
 #include <glib.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <epan/proto.h>
 #include <epan/wmem/wmem.h>
 
@@ -24,6 +29,67 @@
 /* REPLACEMENT CHARACTER */
 #define UNREPL 0xFFFD
 
+/*
+ * Return the number of octets at the start of the string of bytes
+ * referred to by the pointer and length that have the high-order bit
+ * clear, checking 16 (with SSE2) or 8 octets at a time.
+ */
+static inline gint
+ascii_run_length(const guint8 *ptr, gint length)
+{
+    gint i = 0;
+
+#ifdef __SSE2__
+    while (i + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(ptr + i));
+        if (_mm_movemask_epi8(chunk) != 0)
+            break;
+        i += 16;
+    }
+#endif
+    while (i + 8 <= length) {
+        guint64 word;
+
+        memcpy(&word, ptr + i, sizeof word);
+        if (word & G_GUINT64_CONSTANT(0x8080808080808080))
+            break;
+        i += 8;
+    }
+    while (i < length && ptr[i] < 0x80)
+        i++;
+    return i;
+}
+
+/*
+ * Append a run of octets with the high-order bit clear.
+ * wmem_strbuf_append_len() ignores strings that start with a NUL, so
+ * leading NULs are appended one at a time, as they were before.
+ */
+static inline void
+append_ascii_run(wmem_strbuf_t *str, const guint8 *ptr, gint length)
+{
+    while (length > 0 && *ptr == '\0') {
+        wmem_strbuf_append_c(str, '\0');
+        ptr++;
+        length--;
+    }
+    if (length > 0)
+        wmem_strbuf_append_len(str, (const gchar *)ptr, length);
+}
+
+/*
+ * Copy a string of bytes that needs no conversion.
+ */
+static guint8 *
+copy_unconverted_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
+{
+    guint8 *buf = (guint8 *)wmem_alloc(scope, length + 1);
+
+    memcpy(buf, ptr, length);
+    buf[length] = '\0';
+    return buf;
+}
+
 /*
  * Wikipedia's "Character encoding" template, giving a pile of character
  * encodings and Wikipedia pages for them:
@@ -68,18 +134,25 @@ guint8 *
 get_ascii_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
     wmem_strbuf_t *str;
+    gint run;
+
+    /* The usual case: nothing to replace. */
+    run = ascii_run_length(ptr, length);
+    if (length >= 0 && run == length)
+        return copy_unconverted_string(scope, ptr, length);
 
     str = wmem_strbuf_sized_new(scope, length+1, 0);
 
     while (length > 0) {
-        guint8 ch = *ptr;
-
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else
+        run = ascii_run_length(ptr, length);
+        append_ascii_run(str, ptr, run);
+        ptr += run;
+        length -= run;
+        if (length > 0) {
             wmem_strbuf_append_unichar(str, UNREPL);
-        ptr++;
-        length--;
+            ptr++;
+            length--;
+        }
     }
 
     return (guint8 *) wmem_strbuf_finalize(str);
@@ -106,9 +179,29 @@ get_utf_8_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
     wmem_strbuf_t *str;
     guint8 ch;
     const guint8 *prev;
+    const gchar *valid_end;
+    gint run;
+
+    if (length <= 0)
+        return copy_unconverted_string(scope, ptr, 0);
+
+    /*
+     * Anything g_utf8_validate() accepts is well-formed by the rules
+     * below as well, so the valid prefix (usually the whole string)
+     * can be copied as it is. It stops at the first NUL.
+     */
+    if (g_utf8_validate((const gchar *)ptr, length, &valid_end))
+        return copy_unconverted_string(scope, ptr, length);
 
     str = wmem_strbuf_sized_new(scope, length+1, 0);
 
+    run = (gint)(valid_end - (const gchar *)ptr);
+    if (run > 0) {
+        wmem_strbuf_append_len(str, (const gchar *)ptr, run);
+        ptr += run;
+        length -= run;
+    }
+
     /* See the Unicode Standard conformance chapter at
      * https://www.unicode.org/versions/Unicode13.0.0/ch03.pdf especially
      * Table 3-7 "Well-Formed UTF-8 Byte Sequences" and
@@ -118,7 +211,11 @@ get_utf_8_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
         ch = *ptr;
 
         if (ch < 0x80) {
-            wmem_strbuf_append_c(str, ch);
+            run = ascii_run_length(ptr, length);
+            append_ascii_run(str, ptr, run);
+            ptr += run;
+            length -= run;
+            continue;
         } else if (ch < 0xc2 || ch > 0xf4) {
             wmem_strbuf_append_unichar(str, UNREPL);
         } else {
@@ -274,15 +371,24 @@ guint8 *
 get_8859_1_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
     wmem_strbuf_t *str;
+    gint run;
+
+    run = ascii_run_length(ptr, length);
+    if (length >= 0 && run == length)
+        return copy_unconverted_string(scope, ptr, length);
 
     str = wmem_strbuf_sized_new(scope, length+1, 0);
 
     while (length > 0) {
         guint8 ch = *ptr;
 
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else {
+        if (ch < 0x80) {
+            run = ascii_run_length(ptr, length);
+            append_ascii_run(str, ptr, run);
+            ptr += run;
+            length -= run;
+            continue;
+        } else {
             /*
              * Note: we assume here that the code points
              * 0x80-0x9F are used for C1 control characters,
@@ -822,7 +928,10 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
         }else{
             uchar = pletoh16(ptr + i);
         }
-        wmem_strbuf_append_unichar(strbuf, uchar);
+        if (uchar < 0x80)
+            wmem_strbuf_append_c(strbuf, (gchar)uchar);
+        else
+            wmem_strbuf_append_unichar(strbuf, uchar);
     }
 
     /*
@@ -909,7 +1018,10 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
                 /*
                  * Non-surrogate; just append it.
                  */
-                wmem_strbuf_append_unichar(strbuf, uchar2);
+                if (uchar2 < 0x80)
+                    wmem_strbuf_append_c(strbuf, (gchar)uchar2);
+                else
+                    wmem_strbuf_append_unichar(strbuf, uchar2);
             }
         }
     }
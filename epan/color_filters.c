@@ -21,6 +21,7 @@
 
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
+#include <wsutil/startup_profile.h>
 
 #include <epan/packet.h>
 #include "color_filters.h"
@@ -51,6 +52,20 @@ static gboolean filters_enabled = TRUE;
  */
 static gboolean tmp_colors_set = FALSE;
 
+/* The fields referenced by the enabled filters in 'color_filter_list',
+ * without duplicates, so that the tree can be primed in one pass.
+ * Built on first use and dropped whenever the list changes. */
+static GArray *color_filter_primed_hfids = NULL;
+
+static void
+color_filters_reset_primed_hfids(void)
+{
+    if (color_filter_primed_hfids != NULL) {
+        g_array_free(color_filter_primed_hfids, TRUE);
+        color_filter_primed_hfids = NULL;
+    }
+}
+
 /* Create a new filter */
 color_filter_t *
 color_filter_new(const gchar *name,          /* The name of the filter to create */
@@ -190,6 +205,7 @@ color_filters_set_tmp(guint8 filt_nr, const gchar *filter, gboolean disabled, gc
                 /* Remember that there are now temporary coloring filters set */
                 if( filter )
                     tmp_colors_set = TRUE;
+                color_filters_reset_primed_hfids();
             }
         }
         g_free(name);
@@ -345,11 +361,17 @@ color_filters_get(gchar** err_msg, color_filter_add_cb_func add_cb)
 gboolean
 color_filters_init(gchar** err_msg, color_filter_add_cb_func add_cb)
 {
+    guint profile_phase = startup_profile_begin("color_filters_init");
+    gboolean ret;
+
     /* delete all currently existing filters */
     color_filter_list_delete(&color_filter_list);
+    color_filters_reset_primed_hfids();
 
     /* now try to construct the filters list */
-    return color_filters_get(err_msg, add_cb);
+    ret = color_filters_get(err_msg, add_cb);
+    startup_profile_end(profile_phase);
+    return ret;
 }
 
 gboolean
@@ -359,6 +381,7 @@ color_filters_reload(gchar** err_msg, color_filter_add_cb_func add_cb)
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
+    color_filters_reset_primed_hfids();
 
     /* now try to construct the filters list */
     return color_filters_get(err_msg, add_cb);
@@ -453,6 +476,7 @@ color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl, gchar** err_msg)
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
+    color_filters_reset_primed_hfids();
 
     /* clone all list entries from tmp/edit to normal list */
     color_filter_valid_list = NULL;
@@ -490,15 +514,33 @@ tmp_color_filters_used(void)
     return tmp_colors_set;
 }
 
-/* prepare the epan_dissect_t for the filter */
+typedef struct _color_prime_data
+{
+    GArray     *hfids;
+    GHashTable *seen;
+} color_prime_data_t;
+
+static gboolean
+collect_primed_hfid(header_field_info *hfinfo, gpointer user_data)
+{
+    color_prime_data_t *prime_data = (color_prime_data_t *)user_data;
+
+    if (!g_hash_table_contains(prime_data->seen, GINT_TO_POINTER(hfinfo->id))) {
+        g_hash_table_add(prime_data->seen, GINT_TO_POINTER(hfinfo->id));
+        g_array_append_val(prime_data->hfids, hfinfo->id);
+    }
+    return TRUE;
+}
+
+/* collect the fields of one filter, skipping the disabled ones as
+ * color_filters_colorize_packet() never applies them */
 static void
-prime_edt(gpointer data, gpointer user_data)
+collect_primed_hfids(gpointer data, gpointer user_data)
 {
     color_filter_t *colorf = (color_filter_t *)data;
-    epan_dissect_t *edt    = (epan_dissect_t *)user_data;
 
-    if (colorf->c_colorfilter != NULL)
-        epan_dissect_prime_with_dfilter(edt, colorf->c_colorfilter);
+    if (!colorf->disabled && colorf->c_colorfilter != NULL)
+        dfilter_check_interesting_fields(colorf->c_colorfilter, collect_primed_hfid, user_data);
 }
 
 /* Prime the epan_dissect_t with all the compiler
@@ -506,8 +548,20 @@ prime_edt(gpointer data, gpointer user_data)
 void
 color_filters_prime_edt(epan_dissect_t *edt)
 {
-    if (color_filters_used())
-        g_slist_foreach(color_filter_list, prime_edt, edt);
+    color_prime_data_t prime_data;
+
+    if (!color_filters_used())
+        return;
+
+    if (color_filter_primed_hfids == NULL) {
+        prime_data.hfids = g_array_new(FALSE, FALSE, sizeof(int));
+        prime_data.seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_slist_foreach(color_filter_list, collect_primed_hfids, &prime_data);
+        g_hash_table_destroy(prime_data.seen);
+        color_filter_primed_hfids = prime_data.hfids;
+    }
+
+    epan_dissect_prime_with_hfid_array(edt, color_filter_primed_hfids);
 }
 
 /* * Return the color_t for later use */
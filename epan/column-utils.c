@@ -308,6 +308,31 @@ col_clear(column_info *cinfo, const gint el)
     col_item->col_data = col_item->col_buf;         \
   }
 
+/*
+ * Append "str" to the column buffer "buf", which holds a string of "len"
+ * bytes, truncating the result to fit in "max_len" bytes; returns the new
+ * length of the string.  Unlike g_strlcat() this doesn't rescan the string
+ * already in the buffer, and unlike g_strlcpy() it doesn't scan the part
+ * of "str" that doesn't fit, which matters for long Info columns that are
+ * built up from many small appends.
+ */
+static inline size_t
+col_buf_append(gchar *buf, size_t len, const size_t max_len, const gchar *str)
+{
+  const gchar *end;
+  size_t n;
+
+  if (len + 1 >= max_len)
+    return len;
+
+  end = (const gchar *)memchr(str, '\0', max_len - len - 1);
+  n = end ? (size_t)(end - str) : max_len - len - 1;
+  memcpy(&buf[len], str, n);
+  len += n;
+  buf[len] = '\0';
+  return len;
+}
+
 #define COL_CHECK_REF_TIME(fd, buf)         \
   if (fd->ref_time) {                 \
     g_strlcpy(buf, "*REF*", COL_MAX_LEN );  \
@@ -404,7 +429,7 @@ col_append_lstr(column_info *cinfo, const gint el, const gchar *str1, ...)
       COL_CHECK_APPEND(col_item, max_len);
 
       pos = strlen(col_item->col_buf);
-      if (pos >= max_len)
+      if (pos + 1 >= max_len)
          return;
 
       va_start(ap, str1);
@@ -413,9 +438,9 @@ col_append_lstr(column_info *cinfo, const gint el, const gchar *str1, ...)
          if (G_UNLIKELY(str == NULL))
              str = "(null)";
 
-         pos += g_strlcpy(&col_item->col_buf[pos], str, max_len - pos);
+         pos = col_buf_append(col_item->col_buf, pos, max_len, str);
 
-      } while (pos < max_len && (str = va_arg(ap, const char *)) != COL_ADD_LSTR_TERMINATOR);
+      } while (pos + 1 < max_len && (str = va_arg(ap, const char *)) != COL_ADD_LSTR_TERMINATOR);
       va_end(ap);
     }
   }
@@ -490,11 +515,10 @@ col_do_append_fstr(column_info *cinfo, const int el, const char *separator, cons
        * If we have a separator, append it if the column isn't empty.
        */
       if (sep_len != 0 && len != 0) {
-        g_strlcat(col_item->col_buf, separator, max_len);
-        len += sep_len;
+        len = col_buf_append(col_item->col_buf, len, max_len, separator);
       }
 
-      if (len < max_len) {
+      if (len + 1 < max_len) {
         va_list ap2;
 
         G_VA_COPY(ap2, ap);
@@ -751,9 +775,9 @@ col_add_lstr(column_info *cinfo, const gint el, const gchar *str1, ...)
          if (G_UNLIKELY(str == NULL))
              str = "(null)";
 
-         pos += g_strlcpy(&col_item->col_buf[pos], str, max_len - pos);
+         pos = col_buf_append(col_item->col_buf, pos, max_len, str);
 
-      } while (pos < max_len && (str = va_arg(ap, const char *)) != COL_ADD_LSTR_TERMINATOR);
+      } while (pos + 1 < max_len && (str = va_arg(ap, const char *)) != COL_ADD_LSTR_TERMINATOR);
       va_end(ap);
     }
   }
@@ -819,17 +843,17 @@ col_do_append_str(column_info *cinfo, const gint el, const gchar* separator,
        */
       COL_CHECK_APPEND(col_item, max_len);
 
-      len = col_item->col_buf[0];
+      len = strlen(col_item->col_buf);
 
       /*
        * If we have a separator, append it if the column isn't empty.
        */
       if (separator != NULL) {
         if (len != 0) {
-          g_strlcat(col_item->col_buf, separator, max_len);
+          len = col_buf_append(col_item->col_buf, len, max_len, separator);
         }
       }
-      g_strlcat(col_item->col_buf, str, max_len);
+      col_buf_append(col_item->col_buf, len, max_len, str);
     }
   }
 }
@@ -40,6 +40,7 @@ struct conversation_key {
 	endpoint_type etype;
 	guint32	port1;
 	guint32	port2;
+	guint	hash;	/* hash value for the table the key is in */
 };
 
 /*
@@ -65,6 +66,16 @@ static wmem_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
 
 static guint32 new_index;
 
+/*
+ * Functions to call for a protocol's data when a conversation is expired.
+ */
+typedef struct {
+	int proto;
+	conversation_expire_func func;
+} conversation_expire_entry_t;
+
+static wmem_array_t *conversation_expire_funcs = NULL;
+
 /*
  * Placeholder for address-less conversations.
  */
@@ -168,33 +179,41 @@ conversation_create_from_template(conversation_t *conversation, const address *a
 }
 
 /*
- * Compute the hash value for two given address/port pairs if the match
- * is to be exact.
+ * The conversation hash values are built up one field at a time, in the
+ * order address 1, port 1, address 2, port 2, leaving out the fields the
+ * table wildcards, so find_conversation() can hash the address/port pairs
+ * once and extend the result for each table it probes rather than
+ * starting over for every lookup.
  */
 /* https://web.archive.org/web/20070615045827/http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
  * (formerly at http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing)
  * One-at-a-Time hash
  */
-guint
-conversation_hash_exact(gconstpointer v)
+static inline guint
+conversation_hash_add_address(guint hash_val, const address *addr)
+{
+	return addr != NULL ? add_address_to_hash(hash_val, addr) : hash_val;
+}
+
+static inline guint
+conversation_hash_add_port(guint hash_val, guint32 port)
 {
-	const conversation_key_t key = (const conversation_key_t)v;
-	guint hash_val;
 	address tmp_addr;
 
-	hash_val = 0;
 	tmp_addr.len  = 4;
+	tmp_addr.data = &port;
+	return add_address_to_hash(hash_val, &tmp_addr);
+}
 
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val = add_address_to_hash(hash_val, &key->addr2);
-
-	tmp_addr.data = &key->port2;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+static inline guint
+conversation_hash_start(const address *addr1, const guint32 port1)
+{
+	return conversation_hash_add_port(conversation_hash_add_address(0, addr1), port1);
+}
 
+static inline guint
+conversation_hash_finish(guint hash_val)
+{
 	hash_val += ( hash_val << 3 );
 	hash_val ^= ( hash_val >> 11 );
 	hash_val += ( hash_val << 15 );
@@ -202,6 +221,35 @@ conversation_hash_exact(gconstpointer v)
 	return hash_val;
 }
 
+/*
+ * The hash tables store the hash value in the key when it's inserted,
+ * and lookups fill it in from what find_conversation() computed.
+ */
+static guint
+conversation_key_hash(gconstpointer v)
+{
+	const conversation_key_t key = (const conversation_key_t)v;
+
+	return key->hash;
+}
+
+/*
+ * Compute the hash value for two given address/port pairs if the match
+ * is to be exact.
+ */
+guint
+conversation_hash_exact(gconstpointer v)
+{
+	const conversation_key_t key = (const conversation_key_t)v;
+	guint hash_val;
+
+	hash_val = conversation_hash_start(&key->addr1, key->port1);
+	hash_val = conversation_hash_add_address(hash_val, &key->addr2);
+	hash_val = conversation_hash_add_port(hash_val, key->port2);
+
+	return conversation_hash_finish(hash_val);
+}
+
 /*
  * Compare two conversation keys for an exact match.
  */
@@ -263,24 +311,11 @@ conversation_hash_no_addr2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
 
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	tmp_addr.data = &key->port2;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+	hash_val = conversation_hash_start(&key->addr1, key->port1);
+	hash_val = conversation_hash_add_port(hash_val, key->port2);
 
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -328,23 +363,11 @@ conversation_hash_no_port2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
-
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
 
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
+	hash_val = conversation_hash_start(&key->addr1, key->port1);
+	hash_val = conversation_hash_add_address(hash_val, &key->addr2);
 
-	hash_val = add_address_to_hash(hash_val, &key->addr2);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -392,21 +415,9 @@ conversation_hash_no_addr2_or_port2(gconstpointer v)
 {
 	const conversation_key_t key = (const conversation_key_t)v;
 	guint hash_val;
-	address tmp_addr;
 
-	hash_val = 0;
-	tmp_addr.len  = 4;
-
-	hash_val = add_address_to_hash(hash_val, &key->addr1);
-
-	tmp_addr.data = &key->port1;
-	hash_val = add_address_to_hash(hash_val, &tmp_addr);
-
-	hash_val += ( hash_val << 3 );
-	hash_val ^= ( hash_val >> 11 );
-	hash_val += ( hash_val << 15 );
-
-	return hash_val;
+	hash_val = conversation_hash_start(&key->addr1, key->port1);
+	return conversation_hash_finish(hash_val);
 }
 
 /*
@@ -458,16 +469,16 @@ conversation_init(void)
 	 * above.
 	 */
 	conversation_hashtable_exact =
-	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_exact,
+	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_key_hash,
 	      conversation_match_exact);
 	conversation_hashtable_no_addr2 =
-	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_addr2,
+	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_key_hash,
 	      conversation_match_no_addr2);
 	conversation_hashtable_no_port2 =
-	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_port2,
+	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_key_hash,
 	      conversation_match_no_port2);
 	conversation_hashtable_no_addr2_or_port2 =
-	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_no_addr2_or_port2,
+	    wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_key_hash,
 	      conversation_match_no_addr2_or_port2);
 
 }
@@ -494,6 +505,15 @@ conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 {
 	conversation_t *chain_head, *chain_tail, *cur, *prev;
 
+	if (hashtable == conversation_hashtable_exact)
+		conv->key_ptr->hash = conversation_hash_exact(conv->key_ptr);
+	else if (hashtable == conversation_hashtable_no_addr2)
+		conv->key_ptr->hash = conversation_hash_no_addr2(conv->key_ptr);
+	else if (hashtable == conversation_hashtable_no_port2)
+		conv->key_ptr->hash = conversation_hash_no_port2(conv->key_ptr);
+	else
+		conv->key_ptr->hash = conversation_hash_no_addr2_or_port2(conv->key_ptr);
+
 	chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
 
 	if (NULL==chain_head) {
@@ -839,11 +859,12 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
 
 /*
  * Search a particular hash table for a conversation with the specified
- * {addr1, port1, addr2, port2} and set up before frame_num.
+ * {addr1, port1, addr2, port2} and set up before frame_num.  "hash" is
+ * the key's hash value for that table.
  */
 static conversation_t *
 conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, const address *addr1, const address *addr2,
-    const endpoint_type etype, const guint32 port1, const guint32 port2)
+    const endpoint_type etype, const guint32 port1, const guint32 port2, const guint hash)
 {
 	conversation_t* convo=NULL;
 	conversation_t* match=NULL;
@@ -867,14 +888,19 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
 	key.etype = etype;
 	key.port1 = port1;
 	key.port2 = port2;
+	key.hash = hash;
 
 	chain_head = (conversation_t *)wmem_map_lookup(hashtable, &key);
 
 	if (chain_head && (chain_head->setup_frame <= frame_num)) {
 		match = chain_head;
 
-		if ((chain_head->last)&&(chain_head->last->setup_frame<=frame_num))
-			return chain_head->last;
+		if ((chain_head->last)&&(chain_head->last->setup_frame<=frame_num)) {
+			match = chain_head->last;
+			if (frame_num > match->last_frame)
+				match->last_frame = frame_num;
+			return match;
+		}
 
 		if ((chain_head->latest_found)&&(chain_head->latest_found->setup_frame<=frame_num))
 			match = chain_head->latest_found;
@@ -886,8 +912,12 @@ conversation_lookup_hashtable(wmem_map_t *hashtable, const guint32 frame_num, co
 		}
 	}
 
-	if (match)
+	if (match) {
 		chain_head->latest_found = match;
+		/* Keep track of the last frame for conversation_expire(). */
+		if (frame_num > match->last_frame)
+			match->last_frame = frame_num;
+	}
 
 	return match;
 }
@@ -934,6 +964,16 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
     const guint32 port_a, const guint32 port_b, const guint options)
 {
 	conversation_t *conversation;
+	guint hash_a, hash_b, hash_ab, hash_ba;
+
+	/*
+	 * Hash each address/port pair once; the hash value for each
+	 * table we probe extends one of these.
+	 */
+	hash_a = conversation_hash_start(addr_a, port_a);
+	hash_b = conversation_hash_start(addr_b, port_b);
+	hash_ab = conversation_hash_add_address(hash_a, addr_b);
+	hash_ba = conversation_hash_add_address(hash_b, addr_a);
 
 	DINSTR(gchar *addr_a_str = address_to_str(NULL, addr_a));
 	DINSTR(gchar *addr_b_str = address_to_str(NULL, addr_b));
@@ -950,7 +990,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		conversation =
 		    conversation_lookup_hashtable(conversation_hashtable_exact,
 			frame_num, addr_a, addr_b, etype,
-			port_a, port_b);
+			port_a, port_b,
+			conversation_hash_finish(conversation_hash_add_port(hash_ab, port_b)));
 		/* Didn't work, try the other direction */
 		if (conversation == NULL) {
 			DPRINT(("trying exact match: %s:%d -> %s:%d",
@@ -958,7 +999,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_exact,
 				frame_num, addr_b, addr_a, etype,
-				port_b, port_a);
+				port_b, port_a,
+				conversation_hash_finish(conversation_hash_add_port(hash_ba, port_a)));
 		}
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
@@ -969,7 +1011,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_exact,
 				frame_num, addr_b, addr_a, etype,
-				port_a, port_b);
+				port_a, port_b,
+				conversation_hash_finish(conversation_hash_add_port(conversation_hash_add_address(conversation_hash_start(addr_b, port_a), addr_a), port_b)));
 		}
 		DPRINT(("exact match %sfound",conversation?"":"not "));
 		if (conversation != NULL)
@@ -994,7 +1037,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		    addr_a_str, port_a, port_b));
 		conversation =
 		    conversation_lookup_hashtable(conversation_hashtable_no_addr2,
-			frame_num, addr_a, addr_b, etype, port_a, port_b);
+			frame_num, addr_a, addr_b, etype, port_a, port_b,
+			conversation_hash_finish(conversation_hash_add_port(hash_a, port_b)));
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
 			 * TCP/UDP ports are in TCP/IP.
@@ -1004,7 +1048,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_addr2,
 				frame_num, addr_b, addr_a, etype,
-				port_a, port_b);
+				port_a, port_b,
+				conversation_hash_finish(conversation_hash_add_port(conversation_hash_start(addr_b, port_a), port_b)));
 		}
 		if (conversation != NULL) {
 			/*
@@ -1049,7 +1094,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			    addr_b_str, port_b, port_a));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_addr2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, addr_b, addr_a, etype, port_b, port_a,
+				conversation_hash_finish(conversation_hash_add_port(hash_b, port_a)));
 			if (conversation != NULL) {
 				/*
 				 * If this is for a connection-oriented
@@ -1094,7 +1140,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 		    addr_a_str, port_a, addr_b_str));
 		conversation =
 		    conversation_lookup_hashtable(conversation_hashtable_no_port2,
-			frame_num, addr_a, addr_b, etype, port_a, port_b);
+			frame_num, addr_a, addr_b, etype, port_a, port_b,
+			conversation_hash_finish(hash_ab));
 		if ((conversation == NULL) && (addr_a->type == AT_FC)) {
 			/* In Fibre channel, OXID & RXID are never swapped as
 			 * TCP/UDP ports are in TCP/IP
@@ -1102,7 +1149,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			DPRINT(("trying wildcarded match: %s:%d -> %s:*", addr_b_str, port_a, addr_a_str));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_port2,
-				frame_num, addr_b, addr_a, etype, port_a, port_b);
+				frame_num, addr_b, addr_a, etype, port_a, port_b,
+				conversation_hash_finish(conversation_hash_add_address(conversation_hash_start(addr_b, port_a), addr_a)));
 		}
 		if (conversation != NULL) {
 			/*
@@ -1147,7 +1195,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			    addr_b_str, port_b, addr_a_str));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_port2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, addr_b, addr_a, etype, port_b, port_a,
+				conversation_hash_finish(hash_ba));
 			if (conversation != NULL) {
 				/*
 				 * If this is for a connection-oriented
@@ -1186,7 +1235,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 	DPRINT(("trying wildcarded match: %s:%d -> *:*", addr_a_str, port_a));
 	conversation =
 	    conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-		frame_num, addr_a, addr_b, etype, port_a, port_b);
+		frame_num, addr_a, addr_b, etype, port_a, port_b,
+		conversation_hash_finish(hash_a));
 	if (conversation != NULL) {
 		/*
 		 * If this is for a connection-oriented protocol:
@@ -1241,13 +1291,15 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
 			    addr_b_str, port_a));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-				frame_num, addr_b, addr_a, etype, port_a, port_b);
+				frame_num, addr_b, addr_a, etype, port_a, port_b,
+				conversation_hash_finish(conversation_hash_start(addr_b, port_a)));
 		} else {
 			DPRINT(("trying wildcarded match: %s:%d -> *:*",
 			    addr_b_str, port_b));
 			conversation =
 			    conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
-				frame_num, addr_b, addr_a, etype, port_b, port_a);
+				frame_num, addr_b, addr_a, etype, port_b, port_a,
+				conversation_hash_finish(hash_b));
 		}
 		if (conversation != NULL) {
 			/*
@@ -1321,6 +1373,91 @@ conversation_delete_proto_data(conversation_t *conv, const int proto)
 		wmem_tree_remove32(conv->data_list, proto);
 }
 
+void
+conversation_register_expire_func(const int proto, conversation_expire_func func)
+{
+	conversation_expire_entry_t entry;
+
+	if (conversation_expire_funcs == NULL)
+		conversation_expire_funcs = wmem_array_new(wmem_epan_scope(), sizeof(conversation_expire_entry_t));
+
+	entry.proto = proto;
+	entry.func = func;
+	wmem_array_append_one(conversation_expire_funcs, entry);
+}
+
+typedef struct {
+	guint32 frame_num;
+	GSList *idle;
+} conversation_expire_data_t;
+
+static void
+conversation_collect_idle(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	conversation_expire_data_t *data = (conversation_expire_data_t *)user_data;
+	conversation_t *conv;
+
+	for (conv = (conversation_t *)value; conv; conv = conv->next) {
+		if (conv->last_frame < data->frame_num)
+			data->idle = g_slist_prepend(data->idle, conv);
+	}
+}
+
+static void
+conversation_expire_data(conversation_t *conv)
+{
+	conversation_expire_entry_t *entry;
+	void *proto_data;
+	guint i, num_funcs;
+
+	if (conv->data_list == NULL)
+		return;
+
+	num_funcs = conversation_expire_funcs ? wmem_array_get_count(conversation_expire_funcs) : 0;
+	for (i = 0; i < num_funcs; i++) {
+		entry = (conversation_expire_entry_t *)wmem_array_index(conversation_expire_funcs, i);
+		proto_data = wmem_tree_lookup32(conv->data_list, entry->proto);
+		if (proto_data != NULL)
+			entry->func(conv, proto_data);
+	}
+	wmem_tree_destroy(conv->data_list, FALSE, FALSE);
+	conv->data_list = NULL;
+}
+
+guint
+conversation_expire(const guint32 frame_num)
+{
+	wmem_map_t *hashtables[] = {
+		conversation_hashtable_exact,
+		conversation_hashtable_no_addr2,
+		conversation_hashtable_no_port2,
+		conversation_hashtable_no_addr2_or_port2
+	};
+	conversation_expire_data_t data;
+	GSList *item;
+	guint i, expired = 0;
+
+	data.frame_num = frame_num;
+	for (i = 0; i < G_N_ELEMENTS(hashtables); i++) {
+		/* Collect them first, as the chains change as they're removed. */
+		data.idle = NULL;
+		wmem_map_foreach(hashtables[i], conversation_collect_idle, &data);
+		for (item = data.idle; item; item = item->next) {
+			conversation_t *conv = (conversation_t *)item->data;
+
+			conversation_remove_from_hashtable(hashtables[i], conv);
+			conv->next = NULL;
+			conv->last = NULL;
+			conv->latest_found = NULL;
+			conversation_expire_data(conv);
+			expired++;
+		}
+		g_slist_free(data.idle);
+	}
+
+	return expired;
+}
+
 void
 conversation_set_dissector_from_frame_number(conversation_t *conversation,
 	const guint32 starting_frame_num, const dissector_handle_t handle)
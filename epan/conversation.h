@@ -197,6 +197,40 @@ WS_DLL_PUBLIC void conversation_add_proto_data(conversation_t *conv, const int p
 WS_DLL_PUBLIC void *conversation_get_proto_data(const conversation_t *conv, const int proto);
 WS_DLL_PUBLIC void conversation_delete_proto_data(conversation_t *conv, const int proto);
 
+/**
+ * Function called with a protocol's data for a conversation when the
+ * conversation is expired by conversation_expire().
+ */
+typedef void (*conversation_expire_func)(conversation_t *conv, void *proto_data);
+
+/**
+ * Register a function to be called with the data a protocol has attached
+ * to a conversation with conversation_add_proto_data() when the
+ * conversation is expired, so that the protocol can free it and anything
+ * it holds.  Once this has been called nothing will pass that data to the
+ * protocol's dissector again.
+ *
+ * @param proto the protocol ID
+ * @param func the function to call
+ */
+WS_DLL_PUBLIC void conversation_register_expire_func(const int proto,
+    conversation_expire_func func);
+
+/**
+ * Expire every conversation that has seen no frame since before frame_num,
+ * for long-running single-pass dissection where nothing will look at the
+ * frames of such a conversation again.  The conversations are taken out
+ * of the conversation tables, so that a later frame between the same
+ * endpoints starts a new one, and the functions registered with
+ * conversation_register_expire_func() are called for their data.  The
+ * conversations themselves stay allocated, as other state may still
+ * point to them, until the file scope is freed.
+ *
+ * @param frame_num the first frame number that keeps a conversation
+ * @return the number of conversations expired
+ */
+WS_DLL_PUBLIC guint conversation_expire(const guint32 frame_num);
+
 WS_DLL_PUBLIC void conversation_set_dissector(conversation_t *conversation,
     const dissector_handle_t handle);
 
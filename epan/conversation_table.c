@@ -196,16 +196,15 @@ static guint
 conversation_hash(gconstpointer v)
 {
     const conv_key_t *key = (const conv_key_t *)v;
-    guint hash_val;
+    guint hash_val1, hash_val2;
 
-    hash_val = 0;
-    hash_val = add_address_to_hash(hash_val, &key->addr1);
-    hash_val += key->port1;
-    hash_val = add_address_to_hash(hash_val, &key->addr2);
-    hash_val += key->port2;
-    hash_val ^= key->conv_id;
+    /* Combine the two endpoints symmetrically, like conversation_equal()
+     * matches them, so that both directions hash to the same bucket and
+     * a single lookup finds the conversation. */
+    hash_val1 = add_address_to_hash(0, &key->addr1) + key->port1;
+    hash_val2 = add_address_to_hash(0, &key->addr2) + key->port2;
 
-    return hash_val;
+    return (hash_val1 + hash_val2) ^ key->conv_id;
 }
 
 /** Compare two conversation keys for an exact match.
@@ -266,8 +265,13 @@ reset_conversation_table_data(conv_hash_t *ch)
         g_hash_table_destroy(ch->hashtable);
     }
 
+    if (ch->conv_id_table != NULL) {
+        g_hash_table_destroy(ch->conv_id_table);
+    }
+
     ch->conv_array=NULL;
     ch->hashtable=NULL;
+    ch->conv_id_table=NULL;
 }
 
 void reset_hostlist_table_data(conv_hash_t *ch)
@@ -592,31 +596,46 @@ add_conversation_table_data_with_conv_id(
                                               g_free,             /* key_destroy_func */
                                               NULL);              /* value_destroy_func */
 
+        ch->conv_id_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+
     } else { /* try to find it among the existing known conversations */
-        /* first, check in the fwd conversations */
-        conv_key_t existing_key;
         gpointer conversation_idx_hash_val;
 
-        existing_key.addr1 = *src;
-        existing_key.addr2 = *dst;
-        existing_key.port1 = src_port;
-        existing_key.port2 = dst_port;
-        existing_key.conv_id = conv_id;
-        if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
-            conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
+        /* Dissectors that track streams pass their stream index as the
+         * conversation ID, which is much cheaper to look up than the
+         * addresses. It is only a hint, so check that the endpoints match. */
+        if (conv_id != CONV_ID_UNSET &&
+            g_hash_table_lookup_extended(ch->conv_id_table, GUINT_TO_POINTER(conv_id), NULL, &conversation_idx_hash_val)) {
+            conv_item_t *id_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
+
+            if (id_item->src_port == src_port && id_item->dst_port == dst_port &&
+                addresses_equal(&id_item->src_address, src) && addresses_equal(&id_item->dst_address, dst)) {
+                conv_item = id_item;
+            } else if (id_item->src_port == dst_port && id_item->dst_port == src_port &&
+                addresses_equal(&id_item->src_address, dst) && addresses_equal(&id_item->dst_address, src)) {
+                conv_item = id_item;
+            }
         }
+
         if (conv_item == NULL) {
-            /* then, check in the rev conversations if not found in 'fwd' */
-            existing_key.addr1 = *dst;
-            existing_key.addr2 = *src;
-            existing_key.port1 = dst_port;
-            existing_key.port2 = src_port;
+            /* conversation_equal() matches either direction */
+            conv_key_t existing_key;
+
+            existing_key.addr1 = *src;
+            existing_key.addr2 = *dst;
+            existing_key.port1 = src_port;
+            existing_key.port2 = dst_port;
+            existing_key.conv_id = conv_id;
             if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
                 conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
             }
-        } else {
-            /* a conversation was found in this same fwd direction */
-            is_fwd_direction = TRUE;
+        }
+
+        if (conv_item != NULL) {
+            is_fwd_direction = conv_item->src_port == src_port &&
+                               addresses_equal(&conv_item->src_address, src) &&
+                               conv_item->dst_port == dst_port &&
+                               addresses_equal(&conv_item->dst_address, dst);
         }
     }
 
@@ -660,6 +679,9 @@ add_conversation_table_data_with_conv_id(
         new_key->port2 = dst_port;
         new_key->conv_id = conv_id;
         g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
+        if (conv_id != CONV_ID_UNSET) {
+            g_hash_table_insert(ch->conv_id_table, GUINT_TO_POINTER(conv_id), GUINT_TO_POINTER(conversation_idx));
+        }
 
         /* update the conversation struct */
         conv_item->tx_frames += num_frames;
@@ -2712,6 +2712,7 @@ Dot11DecryptRsnaPwd2PskStep(
     UCHAR *output)
 {
     UCHAR digest[MAX_SSID_LENGTH+4] = { 0 };  /* SSID plus 4 bytes of count */
+    gcry_md_hd_t hmac_handle;
     INT i, j;
 
     if (ssidLength > MAX_SSID_LENGTH) {
@@ -2719,23 +2720,33 @@ Dot11DecryptRsnaPwd2PskStep(
         return DOT11DECRYPT_RET_UNSUCCESS;
     }
 
+    /* The HMAC key (the passphrase) is the same for every iteration, so set
+     * it up once and only reset the handle between iterations instead of
+     * opening and keying a new one 4096 times. */
+    if (gcry_md_open(&hmac_handle, GCRY_MD_SHA1, GCRY_MD_FLAG_HMAC)) {
+        return DOT11DECRYPT_RET_UNSUCCESS;
+    }
+    if (gcry_md_setkey(hmac_handle, ppBytes, ppLength)) {
+        gcry_md_close(hmac_handle);
+        return DOT11DECRYPT_RET_UNSUCCESS;
+    }
+
     /* U1 = PRF(P, S || INT(i)) */
     memcpy(digest, ssid, ssidLength);
     digest[ssidLength] = (UCHAR)((count>>24) & 0xff);
     digest[ssidLength+1] = (UCHAR)((count>>16) & 0xff);
     digest[ssidLength+2] = (UCHAR)((count>>8) & 0xff);
     digest[ssidLength+3] = (UCHAR)(count & 0xff);
-    if (ws_hmac_buffer(GCRY_MD_SHA1, digest, digest, (guint32) ssidLength + 4, ppBytes, ppLength)) {
-      return DOT11DECRYPT_RET_UNSUCCESS;
-    }
+    gcry_md_write(hmac_handle, digest, ssidLength + 4);
+    memcpy(digest, gcry_md_read(hmac_handle, 0), HASH_SHA1_LENGTH);
 
     /* output = U1 */
     memcpy(output, digest, 20);
     for (i = 1; i < iterations; i++) {
         /* Un = PRF(P, Un-1) */
-        if (ws_hmac_buffer(GCRY_MD_SHA1, digest, digest, HASH_SHA1_LENGTH, ppBytes, ppLength)) {
-          return DOT11DECRYPT_RET_UNSUCCESS;
-        }
+        gcry_md_reset(hmac_handle);
+        gcry_md_write(hmac_handle, digest, HASH_SHA1_LENGTH);
+        memcpy(digest, gcry_md_read(hmac_handle, 0), HASH_SHA1_LENGTH);
 
         /* output = output xor Un */
         for (j = 0; j < 20; j++) {
@@ -2743,9 +2754,34 @@ Dot11DecryptRsnaPwd2PskStep(
         }
     }
 
+    gcry_md_close(hmac_handle);
     return DOT11DECRYPT_RET_SUCCESS;
 }
 
+/*
+ * Derived PSKs, keyed by SHA-256(passphrase) followed by the SSID. Deriving
+ * a PSK costs 8192 HMAC-SHA1 operations, and the same passphrase/SSID pairs
+ * come back every time the keys are reset (each redissection) and for every
+ * EAPOL frame tried against a wildcard SSID key, so remember them for the
+ * lifetime of the process. Only a hash of the passphrase is kept.
+ */
+#define DOT11DECRYPT_PSK_CACHE_MAX_ENTRIES 4096
+
+static GHashTable *psk_cache = NULL;
+
+static GBytes *
+Dot11DecryptPskCacheKey(
+    const GByteArray *pp_ba,
+    const CHAR *ssid,
+    const size_t ssidLength)
+{
+    guint8 key[HASH_SHA2_256_LENGTH + MAX_SSID_LENGTH];
+
+    gcry_md_hash_buffer(GCRY_MD_SHA256, key, pp_ba->data, pp_ba->len);
+    memcpy(key + HASH_SHA2_256_LENGTH, ssid, ssidLength);
+    return g_bytes_new(key, HASH_SHA2_256_LENGTH + ssidLength);
+}
+
 static INT
 Dot11DecryptRsnaPwd2Psk(
     const CHAR *passphrase,
@@ -2755,18 +2791,46 @@ Dot11DecryptRsnaPwd2Psk(
 {
     UCHAR m_output[40] = { 0 };
     GByteArray *pp_ba = g_byte_array_new();
+    GBytes *cache_key;
+    const UCHAR *cached;
 
     if (!uri_str_to_bytes(passphrase, pp_ba)) {
         g_byte_array_free(pp_ba, TRUE);
         return 0;
     }
 
+    if (ssidLength > MAX_SSID_LENGTH) {
+        /* This "should not happen" */
+        g_byte_array_free(pp_ba, TRUE);
+        return 0;
+    }
+
+    if (psk_cache == NULL) {
+        psk_cache = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+                                          (GDestroyNotify)g_bytes_unref, g_free);
+    }
+    cache_key = Dot11DecryptPskCacheKey(pp_ba, ssid, ssidLength);
+    cached = (const UCHAR *)g_hash_table_lookup(psk_cache, cache_key);
+    if (cached) {
+        memcpy(output, cached, DOT11DECRYPT_WPA_PWD_PSK_LEN);
+        g_bytes_unref(cache_key);
+        g_byte_array_free(pp_ba, TRUE);
+        return 0;
+    }
+
     Dot11DecryptRsnaPwd2PskStep(pp_ba->data, pp_ba->len, ssid, ssidLength, 4096, 1, m_output);
     Dot11DecryptRsnaPwd2PskStep(pp_ba->data, pp_ba->len, ssid, ssidLength, 4096, 2, &m_output[20]);
 
     memcpy(output, m_output, DOT11DECRYPT_WPA_PWD_PSK_LEN);
     g_byte_array_free(pp_ba, TRUE);
 
+    /* Keep the cache bounded for captures with very many SSIDs. */
+    if (g_hash_table_size(psk_cache) >= DOT11DECRYPT_PSK_CACHE_MAX_ENTRIES) {
+        g_hash_table_remove_all(psk_cache);
+    }
+    g_hash_table_insert(psk_cache, cache_key,
+                        g_memdup2(m_output, DOT11DECRYPT_WPA_PWD_PSK_LEN));
+
     return 0;
 }
 
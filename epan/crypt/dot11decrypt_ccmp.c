@@ -72,6 +72,38 @@ static void ccmp_construct_nonce(
 	nonce[12] = (UINT8)(pn >> 0);
 }
 
+/* The handle of the last decryption is kept open, so that frames protected
+ * with the same temporal key don't need a new handle and key schedule each.
+ * 32 bytes is enough for the 256 bit variant. */
+static gcry_cipher_hd_t ccmp_handle = NULL;
+static guint8 ccmp_key[32];
+static int ccmp_key_len = 0;
+
+static gcry_cipher_hd_t ccmp_get_handle(const guint8 *TK1, int tk_len)
+{
+	if (tk_len <= 0 || tk_len > (int)sizeof(ccmp_key)) {
+		return NULL;
+	}
+	if (ccmp_handle == NULL) {
+		if (gcry_cipher_open(&ccmp_handle, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_CCM, 0)) {
+			ccmp_handle = NULL;
+			return NULL;
+		}
+		ccmp_key_len = 0;
+	}
+	if (ccmp_key_len != tk_len || memcmp(ccmp_key, TK1, tk_len) != 0) {
+		if (gcry_cipher_setkey(ccmp_handle, TK1, tk_len)) {
+			ccmp_key_len = 0;
+			return NULL;
+		}
+		memcpy(ccmp_key, TK1, tk_len);
+		ccmp_key_len = tk_len;
+	}
+	/* Drop the state of the previous frame, keeping the key */
+	gcry_cipher_reset(ccmp_handle);
+	return ccmp_handle;
+}
+
 int Dot11DecryptCcmpDecrypt(
 	guint8 *m,
 	int mac_header_len,
@@ -102,12 +134,10 @@ int Dot11DecryptCcmpDecrypt(
 	ccmp_construct_nonce(wh, pn, nonce);
 	dot11decrypt_construct_aad(wh, aad, &aad_len);
 
-	if (gcry_cipher_open(&handle, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_CCM, 0)) {
+	handle = ccmp_get_handle(TK1, tk_len);
+	if (handle == NULL) {
 		return 1;
 	}
-	if (gcry_cipher_setkey(handle, TK1, tk_len)) {
-		goto err_out;
-	}
 	if (gcry_cipher_setiv(handle, nonce, sizeof(nonce))) {
 		goto err_out;
 	}
@@ -132,9 +162,7 @@ int Dot11DecryptCcmpDecrypt(
 	/* TODO replay check	(IEEE 802.11i-2004, pg. 62)			*/
 	/* TODO PN must be incremental (IEEE 802.11i-2004, pg. 62)		*/
 
-	gcry_cipher_close(handle);
 	return 0;
 err_out:
-	gcry_cipher_close(handle);
 	return 1;
 }
@@ -52,6 +52,37 @@ gcmp_construct_nonce(
 	nonce[11] = (guint8)(pn >> 0);
 }
 
+/* Handle of the last GCMP key, reused as long as the key stays the same
+ * (see dot11decrypt_ccmp.c) */
+static gcry_cipher_hd_t gcmp_handle = NULL;
+static guint8 gcmp_key[32];
+static int gcmp_key_len = 0;
+
+static gcry_cipher_hd_t gcmp_get_handle(const guint8 *TK1, int tk_len)
+{
+	if (tk_len <= 0 || tk_len > (int)sizeof(gcmp_key)) {
+		return NULL;
+	}
+	if (gcmp_handle == NULL) {
+		if (gcry_cipher_open(&gcmp_handle, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_GCM, 0)) {
+			gcmp_handle = NULL;
+			return NULL;
+		}
+		gcmp_key_len = 0;
+	}
+	if (gcmp_key_len != tk_len || memcmp(gcmp_key, TK1, tk_len) != 0) {
+		if (gcry_cipher_setkey(gcmp_handle, TK1, tk_len)) {
+			gcmp_key_len = 0;
+			return NULL;
+		}
+		memcpy(gcmp_key, TK1, tk_len);
+		gcmp_key_len = tk_len;
+	}
+	/* Drop the state of the previous frame, keeping the key */
+	gcry_cipher_reset(gcmp_handle);
+	return gcmp_handle;
+}
+
 int Dot11DecryptGcmpDecrypt(
 	guint8 *m,
 	int mac_header_len,
@@ -81,12 +112,10 @@ int Dot11DecryptGcmpDecrypt(
 	gcmp_construct_nonce(wh, pn, nonce);
 	dot11decrypt_construct_aad(wh, aad, &aad_len);
 
-	if (gcry_cipher_open(&handle, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_GCM, 0)) {
+	handle = gcmp_get_handle(TK1, tk_len);
+	if (handle == NULL) {
 		return 1;
 	}
-	if (gcry_cipher_setkey(handle, TK1, tk_len)) {
-		goto err_out;
-	}
 	if (gcry_cipher_setiv(handle, nonce, sizeof(nonce))) {
 		goto err_out;
 	}
@@ -103,9 +132,7 @@ int Dot11DecryptGcmpDecrypt(
 	/* TODO replay check	(IEEE 802.11i-2004, pg. 62)			*/
 	/* TODO PN must be incremental (IEEE 802.11i-2004, pg. 62)		*/
 
-	gcry_cipher_close(handle);
 	return 0;
 err_out:
-	gcry_cipher_close(handle);
 	return 1;
 }
@@ -24,9 +24,13 @@ struct epan_dfilter {
 	GList		**registers;
 	gboolean	*attempted_load;
 	gboolean	*owns_memory;
+	wmem_allocator_t	*function_scope;	/* results of functions, emptied after each run */
 	int		*interesting_fields;
 	int		num_interesting_fields;
+	header_field_info	**required_fields;
+	int		num_required_fields;
 	GPtrArray	*deprecated;
+	struct dfvm_profile	*profile;	/* NULL unless profiling is enabled */
 };
 
 typedef struct {
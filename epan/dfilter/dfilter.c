@@ -132,6 +132,7 @@ dfilter_free(dfilter_t *df)
 	}
 
 	g_free(df->interesting_fields);
+	g_free(df->required_fields);
 
 	/* Clear registers with constant values (as set by dfvm_init_const).
 	 * Other registers were cleared on RETURN by free_register_overhead. */
@@ -150,6 +151,9 @@ dfilter_free(dfilter_t *df)
 	g_free(df->registers);
 	g_free(df->attempted_load);
 	g_free(df->owns_memory);
+	if (df->function_scope)
+		wmem_destroy_allocator(df->function_scope);
+	g_free(df->profile);
 	g_free(df);
 }
 
@@ -345,6 +349,8 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		dfw->consts = NULL;
 		dfilter->interesting_fields = dfw_interesting_fields(dfw,
 			&dfilter->num_interesting_fields);
+		dfilter->required_fields = dfw_required_fields(dfw,
+			&dfilter->num_required_fields);
 
 		/* Initialize run-time space */
 		dfilter->num_registers = dfw->first_constant;
@@ -427,6 +433,43 @@ dfilter_has_interesting_fields(const dfilter_t *df)
 	return (df->num_interesting_fields > 0);
 }
 
+gboolean
+dfilter_is_frame_only(const dfilter_t *df)
+{
+	int proto_frame;
+	int i;
+	header_field_info *hfinfo;
+
+	proto_frame = proto_get_id_by_filter_name("frame");
+	for (i = 0; i < df->num_interesting_fields; i++) {
+		hfinfo = proto_registrar_get_nth(df->interesting_fields[i]);
+		if (hfinfo->id != proto_frame && hfinfo->parent != proto_frame)
+			return FALSE;
+		/*
+		 * These are filled in from the results of the rest of
+		 * the dissection, not from the frame metadata.
+		 */
+		if (strcmp(hfinfo->abbrev, "frame.protocols") == 0 ||
+		    g_str_has_prefix(hfinfo->abbrev, "frame.coloring_rule."))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+gboolean
+dfilter_check_interesting_fields(const dfilter_t *df,
+    gboolean (*func)(header_field_info *hfinfo, gpointer user_data),
+    gpointer user_data)
+{
+	int i;
+
+	for (i = 0; i < df->num_interesting_fields; i++) {
+		if (!func(proto_registrar_get_nth(df->interesting_fields[i]), user_data))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
@@ -453,6 +496,41 @@ dfilter_dump(dfilter_t *df)
 	}
 }
 
+void
+dfilter_profile_enable(dfilter_t *df, gboolean enable)
+{
+	if (enable) {
+		g_free(df->profile);
+		df->profile = g_new0(dfvm_profile_t, 1);
+	}
+	if (df->profile != NULL)
+		df->profile->enabled = enable;
+}
+
+const dfilter_profile_t *
+dfilter_profile_get(const dfilter_t *df)
+{
+	if (df->profile == NULL)
+		return NULL;
+	return &df->profile->counts;
+}
+
+void
+dfilter_profile_foreach_insn(const dfilter_t *df,
+    dfilter_profile_insn_func func, gpointer user_data)
+{
+	int op;
+
+	if (df->profile == NULL)
+		return;
+	for (op = 0; op < DFVM_NUM_OPCODES; op++) {
+		if (df->profile->insn_count[op] > 0)
+			func(dfvm_opcode_tostr((dfvm_opcode_t)op),
+			    df->profile->insn_count[op], df->profile->insn_ns[op],
+			    user_data);
+	}
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
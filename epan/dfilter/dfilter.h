@@ -72,6 +72,21 @@ dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
 gboolean
 dfilter_has_interesting_fields(const dfilter_t *df);
 
+/* Check if dfilter only refers to fields of the "frame" protocol that
+ * are filled in from the frame metadata, so it can be applied to a tree
+ * built without dissecting the rest of the packet. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_is_frame_only(const dfilter_t *df);
+
+/* Check if func returns TRUE for every field and protocol that dfilter
+ * refers to; stops at the first one for which it returns FALSE. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_check_interesting_fields(const dfilter_t *df,
+    gboolean (*func)(header_field_info *hfinfo, gpointer user_data),
+    gpointer user_data);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
@@ -81,6 +96,42 @@ WS_DLL_PUBLIC
 void
 dfilter_dump(dfilter_t *df);
 
+/* Counts and times kept for a dfilter while profiling is enabled on it
+ * with dfilter_profile_enable(). */
+typedef struct dfilter_profile {
+	guint64		applies;		/* times the filter was applied */
+	guint64		matches;		/* times it matched */
+	guint64		total_ns;		/* time spent applying it */
+	guint64		required_rejects;	/* rejected without running, for lack of a required field */
+	guint64		read_tree_hits;		/* READ_TREEs that found the field in the tree */
+	guint64		read_tree_misses;	/* READ_TREEs that didn't */
+	guint64		read_tree_cached;	/* READ_TREEs answered by an earlier one in the same run */
+} dfilter_profile_t;
+
+typedef void (*dfilter_profile_insn_func)(const char *opcode, guint64 count,
+    guint64 ns, gpointer user_data);
+
+/* Start or stop counting and timing the applications of a dfilter.
+ * Enabling profiling again resets the counts. While profiling is on,
+ * every instruction is timed, which makes the filter noticeably slower;
+ * compare profiled filters with each other, not with unprofiled ones. */
+WS_DLL_PUBLIC
+void
+dfilter_profile_enable(dfilter_t *df, gboolean enable);
+
+/* Get the counts of a dfilter, or NULL if profiling was never enabled
+ * on it. */
+WS_DLL_PUBLIC
+const dfilter_profile_t *
+dfilter_profile_get(const dfilter_t *df);
+
+/* Call func with the number of instructions executed, and the time
+ * spent in them, for each opcode that the dfilter executed. */
+WS_DLL_PUBLIC
+void
+dfilter_profile_foreach_insn(const dfilter_t *df,
+    dfilter_profile_insn_func func, gpointer user_data);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -19,93 +19,113 @@
 #include <ftypes/ftypes.h>
 #include <epan/exceptions.h>
 
+/* Results live in the scope of the run of the filter, so they are
+ * never freed on their own: the string of an FT_STRING result is set
+ * directly instead of being copied by fvalue_set_string(). */
+static fvalue_t *
+scope_fvalue_new_string(wmem_allocator_t *scope, gchar *s)
+{
+    fvalue_t *fv = wmem_new(scope, fvalue_t);
+
+    fvalue_init(fv, FT_STRING);
+    fv->value.string = s;
+    return fv;
+}
+
+static fvalue_t *
+scope_fvalue_new_uinteger(wmem_allocator_t *scope, guint32 value)
+{
+    fvalue_t *fv = wmem_new(scope, fvalue_t);
+
+    fvalue_init(fv, FT_UINT32);
+    fvalue_set_uinteger(fv, value);
+    return fv;
+}
+
 /* Convert an FT_STRING using a callback function */
 static gboolean
-string_walk(GList* arg1list, GList **retval, gchar(*conv_func)(gchar))
+string_walk(wmem_allocator_t *scope, GList* arg1list, GList **retval, gchar(*conv_func)(gchar))
 {
     GList       *arg1;
     fvalue_t    *arg_fvalue;
-    fvalue_t    *new_ft_string;
-    char *s, *c;
+    const char  *s;
+    char        *c;
+    size_t       len, i;
 
     arg1 = arg1list;
     while (arg1) {
         arg_fvalue = (fvalue_t *)arg1->data;
         /* XXX - it would be nice to handle FT_TVBUFF, too */
         if (IS_FT_STRING(fvalue_type_ftenum(arg_fvalue))) {
-            s = (char *)wmem_strdup(NULL, (gchar *)fvalue_get(arg_fvalue));
-            for (c = s; *c; c++) {
-                    *c = conv_func(*c);
+            s = (const char *)fvalue_get(arg_fvalue);
+            len = strlen(s);
+            c = (char *)wmem_alloc(scope, len + 1);
+            for (i = 0; i < len; i++) {
+                    c[i] = conv_func(s[i]);
             }
+            c[len] = '\0';
 
-            new_ft_string = fvalue_new(FT_STRING);
-            fvalue_set_string(new_ft_string, s);
-            wmem_free(NULL, s);
-            *retval = g_list_append(*retval, new_ft_string);
+            *retval = g_list_prepend(*retval, scope_fvalue_new_string(scope, c));
         }
         arg1 = arg1->next;
     }
+    *retval = g_list_reverse(*retval);
 
     return TRUE;
 }
 
 /* dfilter function: lower() */
 static gboolean
-df_func_lower(GList* arg1list, GList *arg2junk _U_, GList **retval)
+df_func_lower(wmem_allocator_t *scope, GList* arg1list, GList *arg2junk _U_, GList **retval)
 {
-    return string_walk(arg1list, retval, g_ascii_tolower);
+    return string_walk(scope, arg1list, retval, g_ascii_tolower);
 }
 
 /* dfilter function: upper() */
 static gboolean
-df_func_upper(GList* arg1list, GList *arg2junk _U_, GList **retval)
+df_func_upper(wmem_allocator_t *scope, GList* arg1list, GList *arg2junk _U_, GList **retval)
 {
-    return string_walk(arg1list, retval, g_ascii_toupper);
+    return string_walk(scope, arg1list, retval, g_ascii_toupper);
 }
 
 /* dfilter function: len() */
 static gboolean
-df_func_len(GList* arg1list, GList *arg2junk _U_, GList **retval)
+df_func_len(wmem_allocator_t *scope, GList* arg1list, GList *arg2junk _U_, GList **retval)
 {
     GList       *arg1;
     fvalue_t    *arg_fvalue;
-    fvalue_t    *ft_len;
 
     arg1 = arg1list;
     while (arg1) {
         arg_fvalue = (fvalue_t *)arg1->data;
-        ft_len = fvalue_new(FT_UINT32);
-        fvalue_set_uinteger(ft_len, fvalue_length(arg_fvalue));
-        *retval = g_list_append(*retval, ft_len);
+        *retval = g_list_prepend(*retval,
+                scope_fvalue_new_uinteger(scope, fvalue_length(arg_fvalue)));
         arg1 = arg1->next;
     }
+    *retval = g_list_reverse(*retval);
 
     return TRUE;
 }
 
 /* dfilter function: count() */
 static gboolean
-df_func_count(GList* arg1list, GList *arg2junk _U_, GList **retval)
+df_func_count(wmem_allocator_t *scope, GList* arg1list, GList *arg2junk _U_, GList **retval)
 {
-    fvalue_t *ft_ret;
     guint32   num_items;
 
     num_items = (guint32)g_list_length(arg1list);
 
-    ft_ret = fvalue_new(FT_UINT32);
-    fvalue_set_uinteger(ft_ret, num_items);
-    *retval = g_list_append(*retval, ft_ret);
+    *retval = g_list_append(*retval, scope_fvalue_new_uinteger(scope, num_items));
 
     return TRUE;
 }
 
 /* dfilter function: string() */
 static gboolean
-df_func_string(GList* arg1list, GList *arg2junk _U_, GList **retval)
+df_func_string(wmem_allocator_t *scope, GList* arg1list, GList *arg2junk _U_, GList **retval)
 {
     GList    *arg1 = arg1list;
     fvalue_t *arg_fvalue;
-    fvalue_t *new_ft_string;
     char     *s;
 
     while (arg1) {
@@ -144,19 +164,16 @@ df_func_string(GList* arg1list, GList *arg2junk _U_, GList **retval)
         case FT_FCWWN:
         case FT_IEEE_11073_SFLOAT:
         case FT_IEEE_11073_FLOAT:
-            s = fvalue_to_string_repr(NULL, arg_fvalue, FTREPR_DFILTER, BASE_NONE);
+            s = fvalue_to_string_repr(scope, arg_fvalue, FTREPR_DFILTER, BASE_NONE);
             /* Ensure we have an allocated string here */
             if (!s)
-                s = wmem_strdup(NULL, "");
+                s = wmem_strdup(scope, "");
             break;
         default:
             return TRUE;
         }
 
-        new_ft_string = fvalue_new(FT_STRING);
-        fvalue_set_string(new_ft_string, s);
-        wmem_free(NULL, s);
-        *retval = g_list_append(*retval, new_ft_string);
+        *retval = g_list_append(*retval, scope_fvalue_new_string(scope, s));
 
         arg1 = arg1->next;
     }
@@ -331,6 +348,16 @@ df_func_lookup(char *name)
     return NULL;
 }
 
+DFCaseConvType
+df_func_case_conv(const df_func_def_t *funcdef)
+{
+    if (funcdef->function == df_func_lower)
+        return g_ascii_tolower;
+    if (funcdef->function == df_func_upper)
+        return g_ascii_toupper;
+    return NULL;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
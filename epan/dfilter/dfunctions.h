@@ -13,8 +13,10 @@
 #include <ftypes/ftypes.h>
 #include "syntax-tree.h"
 
-/* The run-time logic of the dfilter function */
-typedef gboolean (*DFFuncType)(GList *arg1list, GList *arg2list, GList **retval);
+/* The run-time logic of the dfilter function. Values in retval are
+ * allocated in scope, which is emptied after each run of the filter. */
+typedef gboolean (*DFFuncType)(wmem_allocator_t *scope, GList *arg1list,
+                               GList *arg2list, GList **retval);
 
 /* The semantic check for the dfilter function */
 typedef void (*DFSemCheckType)(dfwork_t *dfw, int param_num, stnode_t *st_node);
@@ -39,4 +41,10 @@ typedef struct {
 /* Return the function definition record for a function of named "name" */
 df_func_def_t* df_func_lookup(char *name);
 
+/* For lower() and upper(), return the function that converts each
+ * character of the result; NULL for other functions */
+typedef gchar (*DFCaseConvType)(gchar);
+
+DFCaseConvType df_func_case_conv(const df_func_def_t *funcdef);
+
 #endif
@@ -10,7 +10,12 @@
 
 #include "dfvm.h"
 
+#include <string.h>
+
 #include <ftypes/ftypes-int.h>
+#include <epan/exceptions.h>
+#include <wsutil/time_util.h>
+#include <wsutil/ws_probes.h>
 
 dfvm_insn_t*
 dfvm_insn_new(dfvm_opcode_t op)
@@ -26,6 +31,9 @@ dfvm_insn_new(dfvm_opcode_t op)
 	return insn;
 }
 
+static void
+dfvm_patterns_free(dfvm_patterns_t *patterns);
+
 static void
 dfvm_value_free(dfvm_value_t *v)
 {
@@ -39,6 +47,15 @@ dfvm_value_free(dfvm_value_t *v)
 		case PCRE:
 			g_regex_unref(v->value.pcre);
 			break;
+		case FVALUE_SET:
+			g_array_free(v->value.fvalue_set, TRUE);
+			break;
+		case PATTERNS:
+			dfvm_patterns_free(v->value.patterns);
+			break;
+		case LITERAL:
+			g_free(v->value.literal);
+			break;
 		default:
 			/* nothing */
 			;
@@ -75,6 +92,564 @@ dfvm_value_new(dfvm_value_type_t type)
 	return v;
 }
 
+/* The class of values that can be compared directly by ANY_CMP_*. */
+static dfvm_opcode_t
+cmp_const_opcode(ftenum_t ftype)
+{
+	switch (ftype) {
+		case FT_CHAR:
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_FRAMENUM:
+			return ANY_CMP_UINT;
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+			return ANY_CMP_SINT;
+		case FT_IPv4:
+			return ANY_CMP_IPV4;
+		default:
+			return RETURN;
+	}
+}
+
+dfvm_insn_t*
+dfvm_insn_new_cmp_const(dfvm_opcode_t op, int reg, header_field_info *hfinfo,
+		const fvalue_t *fv)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2, *val3, *val4;
+	dfvm_opcode_t	cmp_op;
+
+	if (op < ANY_EQ || op > ANY_LE) {
+		return NULL;
+	}
+	cmp_op = cmp_const_opcode(fv->ftype->ftype);
+	if (cmp_op == RETURN) {
+		return NULL;
+	}
+
+	/* Every field of this name must hold the same kind of value. */
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+	for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+		if (cmp_const_opcode(hfinfo->type) != cmp_op) {
+			return NULL;
+		}
+	}
+
+	insn = dfvm_insn_new(cmp_op);
+	val1 = dfvm_value_new(REGISTER);
+	val1->value.numeric = reg;
+	insn->arg1 = val1;
+	val2 = dfvm_value_new(INTEGER);
+	val3 = dfvm_value_new(INTEGER);
+	if (cmp_op == ANY_CMP_IPV4) {
+		val2->value.numeric = fv->value.ipv4.addr;
+		val3->value.numeric = fv->value.ipv4.nmask;
+		val4 = dfvm_value_new(INTEGER);
+		val4->value.numeric = op;
+		insn->arg4 = val4;
+	} else {
+		val2->value.numeric = fv->value.uinteger;
+		val3->value.numeric = op;
+	}
+	insn->arg2 = val2;
+	insn->arg3 = val3;
+	return insn;
+}
+
+dfvm_insn_t*
+dfvm_insn_new_cmp_nocase(dfvm_opcode_t op, const df_func_def_t *funcdef,
+		const fvalue_t *fv)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val;
+	DFCaseConvType	conv;
+	const gchar	*s, *c;
+
+	if (op != ANY_EQ && op != ANY_CONTAINS) {
+		return NULL;
+	}
+	conv = df_func_case_conv(funcdef);
+	if (conv == NULL || !IS_FT_STRING(fv->ftype->ftype)) {
+		return NULL;
+	}
+	s = fv->value.string;
+	/* "contains" never matches an empty string. */
+	if (op == ANY_CONTAINS && *s == '\0') {
+		return NULL;
+	}
+	/* Nothing converted can match a constant with letters of the other
+	 * case; leave that to the function. */
+	for (c = s; *c; c++) {
+		if (conv(*c) != *c) {
+			return NULL;
+		}
+	}
+
+	insn = dfvm_insn_new(ANY_CMP_NOCASE);
+	insn->arg1 = dfvm_value_new(REGISTER);
+	val = dfvm_value_new(LITERAL);
+	val->value.literal = g_ascii_strdown(s, -1);
+	insn->arg2 = val;
+	val = dfvm_value_new(INTEGER);
+	val->value.numeric = op;
+	insn->arg3 = val;
+	return insn;
+}
+
+static const char *
+cmp_op_name(dfvm_opcode_t op)
+{
+	switch (op) {
+		case ANY_CONTAINS:	return "contains";
+		case ANY_EQ:	return "==";
+		case ANY_NE:	return "!=";
+		case ANY_GT:	return ">";
+		case ANY_GE:	return ">=";
+		case ANY_LT:	return "<";
+		case ANY_LE:	return "<=";
+		default:	return "?";
+	}
+}
+
+/* An inclusive range of keys; single values have low == high. */
+typedef struct {
+	guint64		low;
+	guint64		high;
+} fvalue_set_range_t;
+
+/* Maps a value onto the key range it matches for ANY_EQ. Only types whose
+ * cmp_eq is a plain comparison of the stored integer qualify; IPv4 values
+ * cover every address in their subnet. */
+static gboolean
+fvalue_set_key(const fvalue_t *fv, fvalue_set_range_t *range)
+{
+	switch (fv->ftype->ftype) {
+		case FT_CHAR:
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+		case FT_FRAMENUM:
+		case FT_IPXNET:
+			range->low = range->high = fv->value.uinteger;
+			return TRUE;
+
+		case FT_UINT40:
+		case FT_UINT48:
+		case FT_UINT56:
+		case FT_UINT64:
+		case FT_INT40:
+		case FT_INT48:
+		case FT_INT56:
+		case FT_INT64:
+		case FT_EUI64:
+			range->low = range->high = fv->value.uinteger64;
+			return TRUE;
+
+		case FT_IPv4:
+			range->low = fv->value.ipv4.addr & fv->value.ipv4.nmask;
+			range->high = range->low | (~fv->value.ipv4.nmask & 0xffffffff);
+			return TRUE;
+
+		default:
+			return FALSE;
+	}
+}
+
+GArray*
+dfvm_fvalue_set_new(void)
+{
+	return g_array_new(FALSE, FALSE, sizeof(fvalue_set_range_t));
+}
+
+gboolean
+dfvm_fvalue_set_add(GArray *set, const fvalue_t *fv)
+{
+	fvalue_set_range_t	range;
+
+	if (!fvalue_set_key(fv, &range)) {
+		return FALSE;
+	}
+	g_array_append_val(set, range);
+	return TRUE;
+}
+
+static gint
+fvalue_set_range_compare(gconstpointer a, gconstpointer b)
+{
+	const fvalue_set_range_t *range_a = (const fvalue_set_range_t *)a;
+	const fvalue_set_range_t *range_b = (const fvalue_set_range_t *)b;
+
+	if (range_a->low != range_b->low) {
+		return range_a->low < range_b->low ? -1 : 1;
+	}
+	return 0;
+}
+
+void
+dfvm_fvalue_set_finish(GArray *set)
+{
+	fvalue_set_range_t	*ranges, *last;
+	guint			i;
+
+	if (set->len == 0) {
+		return;
+	}
+
+	g_array_sort(set, fvalue_set_range_compare);
+
+	/* Merge overlapping ranges so that at most one can hold a key. */
+	ranges = (fvalue_set_range_t *)(void *)set->data;
+	last = &ranges[0];
+	for (i = 1; i < set->len; i++) {
+		if (ranges[i].low <= last->high) {
+			if (ranges[i].high > last->high) {
+				last->high = ranges[i].high;
+			}
+		} else {
+			*++last = ranges[i];
+		}
+	}
+	g_array_set_size(set, (guint)(last - ranges) + 1);
+}
+
+static gboolean
+fvalue_set_contains(const GArray *set, const fvalue_t *fv)
+{
+	const fvalue_set_range_t	*ranges;
+	fvalue_set_range_t	key;
+	guint			low, high, mid;
+
+	if (!fvalue_set_key(fv, &key) || key.low != key.high) {
+		return FALSE;
+	}
+
+	/* Find the last range starting at or before the key. */
+	ranges = (const fvalue_set_range_t *)(const void *)set->data;
+	low = 0;
+	high = set->len;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (ranges[mid].low <= key.low) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low > 0 && key.low <= ranges[low - 1].high;
+}
+
+
+/* Gets the bytes that "contains" and "matches" search through for a value
+ * of a string, bytes or protocol type. Returns FALSE if there are none, in
+ * which case the value must be handled by the ftype functions themselves. */
+static gboolean
+fvalue_get_subject(const fvalue_t *fv, const guint8 **data, guint *len)
+{
+	tvbuff_t		*tvb;
+	const guint8 * volatile	ptr = NULL;
+	volatile guint		length = 0;
+	volatile gboolean	ok = FALSE;
+
+	switch (fv->ftype->ftype) {
+		case FT_STRING:
+		case FT_STRINGZ:
+		case FT_UINT_STRING:
+		case FT_STRINGZPAD:
+		case FT_STRINGZTRUNC:
+			*data = (const guint8 *)fv->value.string;
+			*len = (guint)strlen(fv->value.string);
+			return TRUE;
+
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+		case FT_OID:
+		case FT_REL_OID:
+		case FT_SYSTEM_ID:
+			*data = fv->value.bytes->data;
+			*len = fv->value.bytes->len;
+			return TRUE;
+
+		case FT_AX25:
+		case FT_VINES:
+		case FT_ETHER:
+		case FT_FCWWN:
+			/* Not necessarily in a GByteArray; see ftype-bytes.c */
+			*data = (const guint8 *)fvalue_get((fvalue_t *)fv);
+			*len = fvalue_length((fvalue_t *)fv);
+			return TRUE;
+
+		case FT_PROTOCOL:
+			tvb = fv->value.protocol.tvb;
+			if (tvb == NULL) {
+				return FALSE;
+			}
+			TRY {
+				length = tvb_captured_length(tvb);
+				ptr = tvb_get_ptr(tvb, 0, length);
+				ok = TRUE;
+			}
+			CATCH_ALL {
+				ok = FALSE;
+			}
+			ENDTRY;
+			*data = ptr;
+			*len = length;
+			return ok;
+
+		default:
+			return FALSE;
+	}
+}
+
+/* A trie node; node 0 is the root. Children are kept in a singly linked
+ * list, except for those of the root, which are looked up in a table. */
+typedef struct {
+	guint32		child;
+	guint32		sibling;
+	guint32		fail;
+	guint8		byte;
+	gboolean	match;
+} pattern_node_t;
+
+struct _dfvm_patterns_t {
+	ftenum_t	ftype;
+	GPtrArray	*fvalues;
+	GArray		*nodes;
+	guint32		root_next[256];
+};
+
+static void
+pattern_fvalue_free(gpointer data)
+{
+	fvalue_t *fv = (fvalue_t *)data;
+	FVALUE_FREE(fv);
+}
+
+dfvm_patterns_t*
+dfvm_patterns_new(void)
+{
+	dfvm_patterns_t	*patterns;
+	pattern_node_t	root = { 0, 0, 0, 0, FALSE };
+
+	patterns = g_new0(dfvm_patterns_t, 1);
+	patterns->ftype = FT_NONE;
+	patterns->fvalues = g_ptr_array_new_with_free_func(pattern_fvalue_free);
+	patterns->nodes = g_array_new(FALSE, FALSE, sizeof(pattern_node_t));
+	g_array_append_val(patterns->nodes, root);
+	return patterns;
+}
+
+static void
+dfvm_patterns_free(dfvm_patterns_t *patterns)
+{
+	g_ptr_array_free(patterns->fvalues, TRUE);
+	g_array_free(patterns->nodes, TRUE);
+	g_free(patterns);
+}
+
+gboolean
+dfvm_patterns_accepts(const fvalue_t *fv)
+{
+	const guint8	*data;
+	guint		len;
+
+	return fvalue_get_subject(fv, &data, &len) && len > 0;
+}
+
+static guint32
+pattern_child(const dfvm_patterns_t *patterns, guint32 node, guint8 byte)
+{
+	const pattern_node_t	*nodes = (const pattern_node_t *)(const void *)patterns->nodes->data;
+	guint32			child;
+
+	if (node == 0) {
+		return patterns->root_next[byte];
+	}
+	for (child = nodes[node].child; child != 0; child = nodes[child].sibling) {
+		if (nodes[child].byte == byte) {
+			return child;
+		}
+	}
+	return 0;
+}
+
+void
+dfvm_patterns_add(dfvm_patterns_t *patterns, fvalue_t *fv)
+{
+	const guint8	*data;
+	guint		len, i;
+	guint32		node = 0, child;
+	pattern_node_t	new_node = { 0, 0, 0, 0, FALSE };
+
+	if (!fvalue_get_subject(fv, &data, &len) || len == 0) {
+		g_assert_not_reached();
+	}
+	g_assert(patterns->ftype == FT_NONE || patterns->ftype == fv->ftype->ftype);
+	patterns->ftype = fv->ftype->ftype;
+	g_ptr_array_add(patterns->fvalues, fv);
+
+	for (i = 0; i < len; i++) {
+		child = pattern_child(patterns, node, data[i]);
+		if (child == 0) {
+			child = patterns->nodes->len;
+			new_node.byte = data[i];
+			if (node == 0) {
+				patterns->root_next[data[i]] = child;
+			} else {
+				new_node.sibling = g_array_index(patterns->nodes, pattern_node_t, node).child;
+				g_array_index(patterns->nodes, pattern_node_t, node).child = child;
+			}
+			g_array_append_val(patterns->nodes, new_node);
+			new_node.sibling = 0;
+		}
+		node = child;
+	}
+	g_array_index(patterns->nodes, pattern_node_t, node).match = TRUE;
+}
+
+void
+dfvm_patterns_finish(dfvm_patterns_t *patterns)
+{
+	pattern_node_t	*nodes = (pattern_node_t *)(void *)patterns->nodes->data;
+	GArray		*queue;
+	guint		head, c;
+	guint32		node, child, fail, next;
+
+	/* Compute the failure links breadth first, so that those of the
+	 * shallower nodes are known when they are needed. */
+	queue = g_array_new(FALSE, FALSE, sizeof(guint32));
+	for (c = 0; c < 256; c++) {
+		if (patterns->root_next[c] != 0) {
+			g_array_append_val(queue, patterns->root_next[c]);
+		}
+	}
+	for (head = 0; head < queue->len; head++) {
+		node = g_array_index(queue, guint32, head);
+		for (child = nodes[node].child; child != 0; child = nodes[child].sibling) {
+			fail = nodes[node].fail;
+			while ((next = pattern_child(patterns, fail, nodes[child].byte)) == 0 && fail != 0) {
+				fail = nodes[fail].fail;
+			}
+			nodes[child].fail = next;
+			/* Any pattern ending at the failure node ends here too. */
+			if (nodes[next].match) {
+				nodes[child].match = TRUE;
+			}
+			g_array_append_val(queue, child);
+		}
+	}
+	g_array_free(queue, TRUE);
+}
+
+static gboolean
+patterns_search(const dfvm_patterns_t *patterns, const guint8 *data, guint len)
+{
+	const pattern_node_t	*nodes = (const pattern_node_t *)(const void *)patterns->nodes->data;
+	guint32			state = 0, next;
+	guint			i;
+
+	for (i = 0; i < len; i++) {
+		while ((next = pattern_child(patterns, state, data[i])) == 0 && state != 0) {
+			state = nodes[state].fail;
+		}
+		state = next;
+		if (nodes[state].match) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+patterns_contained(const dfvm_patterns_t *patterns, const fvalue_t *fv)
+{
+	const guint8	*data;
+	guint		len, i;
+
+	if (fv->ftype->ftype == patterns->ftype &&
+			fvalue_get_subject(fv, &data, &len)) {
+		return patterns_search(patterns, data, len);
+	}
+
+	/* Leave anything else to the ftype, one pattern at a time. */
+	for (i = 0; i < patterns->fvalues->len; i++) {
+		if (fvalue_contains(fv, (fvalue_t *)g_ptr_array_index(patterns->fvalues, i))) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* Looks for a literal that was lowercased at compile time, ignoring the
+ * case of ASCII letters like the (caseless) regex it was taken from. */
+static gboolean
+literal_find(const guint8 *data, guint len, const gchar *literal)
+{
+	guint	literal_len = (guint)strlen(literal);
+	guint	i, j;
+
+	for (i = 0; i + literal_len <= len; i++) {
+		for (j = 0; j < literal_len; j++) {
+			if (g_ascii_tolower(data[i + j]) != literal[j]) {
+				break;
+			}
+		}
+		if (j == literal_len) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+const char *
+dfvm_opcode_tostr(dfvm_opcode_t code)
+{
+	static const char *names[DFVM_NUM_OPCODES] = {
+		"IF_TRUE_GOTO",
+		"IF_FALSE_GOTO",
+		"CHECK_EXISTS",
+		"NOT",
+		"RETURN",
+		"READ_TREE",
+		"PUT_FVALUE",
+		"PUT_PCRE",
+		"ANY_EQ",
+		"ANY_NE",
+		"ANY_GT",
+		"ANY_GE",
+		"ANY_LT",
+		"ANY_LE",
+		"ANY_BITWISE_AND",
+		"ANY_CONTAINS",
+		"ANY_MATCHES",
+		"MK_RANGE",
+		"CALL_FUNCTION",
+		"ANY_IN_RANGE",
+		"ANY_IN_SET",
+		"ANY_CONTAINS_ANY",
+		"ANY_CMP_UINT",
+		"ANY_CMP_SINT",
+		"ANY_CMP_IPV4",
+		"ANY_CMP_NOCASE"
+	};
+
+	if ((unsigned)code >= DFVM_NUM_OPCODES)
+		return "(unknown)";
+	return names[code];
+}
 
 void
 dfvm_dump(FILE *f, dfilter_t *df)
@@ -128,6 +703,12 @@ dfvm_dump(FILE *f, dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case ANY_IN_SET:
+			case ANY_CONTAINS_ANY:
+			case ANY_CMP_UINT:
+			case ANY_CMP_SINT:
+			case ANY_CMP_IPV4:
+			case ANY_CMP_NOCASE:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -138,6 +719,13 @@ dfvm_dump(FILE *f, dfilter_t *df)
 		}
 	}
 
+	if (df->num_required_fields > 0) {
+		fprintf(f, "\nRequired fields:\n");
+		for (id = 0; id < df->num_required_fields; id++) {
+			fprintf(f, "\t%s\n", df->required_fields[id]->abbrev);
+		}
+	}
+
 	fprintf(f, "\nInstructions:\n");
 	/* Now dump the operations */
 	length = df->insns->len;
@@ -263,8 +851,12 @@ dfvm_dump(FILE *f, dfilter_t *df)
 				break;
 
 			case ANY_MATCHES:
-				fprintf(f, "%05d ANY_MATCHES\treg#%u matches reg#%u\n",
+				fprintf(f, "%05d ANY_MATCHES\treg#%u matches reg#%u",
 					id, arg1->value.numeric, arg2->value.numeric);
+				if (arg3) {
+					fprintf(f, " (requires \"%s\")", arg3->value.literal);
+				}
+				fprintf(f, "\n");
 				break;
 
 			case ANY_IN_RANGE:
@@ -273,6 +865,46 @@ dfvm_dump(FILE *f, dfilter_t *df)
 					arg3->value.numeric);
 				break;
 
+			case ANY_IN_SET:
+				fprintf(f, "%05d ANY_IN_SET\treg#%u in set of %u range(s)\n",
+					id, arg1->value.numeric,
+					arg2->value.fvalue_set->len);
+				break;
+
+			case ANY_CONTAINS_ANY:
+				fprintf(f, "%05d ANY_CONTAINS_ANY\treg#%u contains any of %u pattern(s)\n",
+					id, arg1->value.numeric,
+					arg2->value.patterns->fvalues->len);
+				break;
+
+			case ANY_CMP_UINT:
+				fprintf(f, "%05d ANY_CMP_UINT\treg#%u %s %u\n",
+					id, arg1->value.numeric,
+					cmp_op_name((dfvm_opcode_t)arg3->value.numeric),
+					arg2->value.numeric);
+				break;
+
+			case ANY_CMP_SINT:
+				fprintf(f, "%05d ANY_CMP_SINT\treg#%u %s %d\n",
+					id, arg1->value.numeric,
+					cmp_op_name((dfvm_opcode_t)arg3->value.numeric),
+					(gint32)arg2->value.numeric);
+				break;
+
+			case ANY_CMP_IPV4:
+				fprintf(f, "%05d ANY_CMP_IPV4\treg#%u %s 0x%08x/0x%08x\n",
+					id, arg1->value.numeric,
+					cmp_op_name((dfvm_opcode_t)arg4->value.numeric),
+					arg2->value.numeric, arg3->value.numeric);
+				break;
+
+			case ANY_CMP_NOCASE:
+				fprintf(f, "%05d ANY_CMP_NOCASE\treg#%u %s \"%s\"\n",
+					id, arg1->value.numeric,
+					cmp_op_name((dfvm_opcode_t)arg3->value.numeric),
+					arg2->value.literal);
+				break;
+
 			case NOT:
 				fprintf(f, "%05d NOT\n", id);
 				break;
@@ -311,6 +943,8 @@ read_tree(dfilter_t *df, proto_tree *tree, header_field_info *hfinfo, int reg)
 
 	/* Already loaded in this run of the dfilter? */
 	if (df->attempted_load[reg]) {
+		if (G_UNLIKELY(df->profile != NULL))
+			df->profile->counts.read_tree_cached++;
 		if (df->registers[reg]) {
 			return TRUE;
 		}
@@ -340,6 +974,13 @@ read_tree(dfilter_t *df, proto_tree *tree, header_field_info *hfinfo, int reg)
 		hfinfo = hfinfo->same_name_next;
 	}
 
+	if (G_UNLIKELY(df->profile != NULL)) {
+		if (found_something)
+			df->profile->counts.read_tree_hits++;
+		else
+			df->profile->counts.read_tree_misses++;
+	}
+
 	if (!found_something) {
 		return FALSE;
 	}
@@ -393,14 +1034,23 @@ any_test(dfilter_t *df, FvalueCmpFunc cmp, int reg1, int reg2)
 	return FALSE;
 }
 
+/* If literal is not NULL, it is a string that every match of the regex
+ * contains; values that lack it are rejected without running the regex. */
 static gboolean
-any_matches(dfilter_t *df, int reg1, int reg2)
+any_matches(dfilter_t *df, int reg1, int reg2, const gchar *literal)
 {
 	GList	*list_a, *list_b;
+	const guint8	*data;
+	guint	len;
 
 	list_a = df->registers[reg1];
 
 	while (list_a) {
+		if (literal && fvalue_get_subject((fvalue_t *)list_a->data, &data, &len) &&
+				!literal_find(data, len, literal)) {
+			list_a = g_list_next(list_a);
+			continue;
+		}
 		list_b = df->registers[reg2];
 		while (list_b) {
 			if (fvalue_matches((fvalue_t *)list_a->data, (GRegex *)list_b->data)) {
@@ -413,6 +1063,122 @@ any_matches(dfilter_t *df, int reg1, int reg2)
 	return FALSE;
 }
 
+/* The ANY_CMP_* instructions: like any_test() with the cmp_* function of
+ * the ftype, but reading the values directly. */
+static gboolean
+any_cmp_uint(dfilter_t *df, int reg1, guint32 c, dfvm_opcode_t op)
+{
+	GList	*list1;
+	guint32	v;
+
+	for (list1 = df->registers[reg1]; list1; list1 = g_list_next(list1)) {
+		v = ((const fvalue_t *)list1->data)->value.uinteger;
+		switch (op) {
+			case ANY_EQ:	if (v == c) return TRUE; break;
+			case ANY_NE:	if (v != c) return TRUE; break;
+			case ANY_GT:	if (v > c) return TRUE; break;
+			case ANY_GE:	if (v >= c) return TRUE; break;
+			case ANY_LT:	if (v < c) return TRUE; break;
+			case ANY_LE:	if (v <= c) return TRUE; break;
+			default:	g_assert_not_reached();
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+any_cmp_sint(dfilter_t *df, int reg1, gint32 c, dfvm_opcode_t op)
+{
+	GList	*list1;
+	gint32	v;
+
+	for (list1 = df->registers[reg1]; list1; list1 = g_list_next(list1)) {
+		v = ((const fvalue_t *)list1->data)->value.sinteger;
+		switch (op) {
+			case ANY_EQ:	if (v == c) return TRUE; break;
+			case ANY_NE:	if (v != c) return TRUE; break;
+			case ANY_GT:	if (v > c) return TRUE; break;
+			case ANY_GE:	if (v >= c) return TRUE; break;
+			case ANY_LT:	if (v < c) return TRUE; break;
+			case ANY_LE:	if (v <= c) return TRUE; break;
+			default:	g_assert_not_reached();
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+any_cmp_ipv4(dfilter_t *df, int reg1, guint32 addr, guint32 nmask, dfvm_opcode_t op)
+{
+	GList	*list1;
+	const ipv4_addr_and_mask *v;
+	guint32	mask, a, b;
+
+	for (list1 = df->registers[reg1]; list1; list1 = g_list_next(list1)) {
+		v = &((const fvalue_t *)list1->data)->value.ipv4;
+		/* As in ftype-ipv4.c, compare only the bits in both netmasks. */
+		mask = MIN(v->nmask, nmask);
+		a = v->addr & mask;
+		b = addr & mask;
+		switch (op) {
+			case ANY_EQ:	if (a == b) return TRUE; break;
+			case ANY_NE:	if (a != b) return TRUE; break;
+			case ANY_GT:	if (a > b) return TRUE; break;
+			case ANY_GE:	if (a >= b) return TRUE; break;
+			case ANY_LT:	if (a < b) return TRUE; break;
+			case ANY_LE:	if (a <= b) return TRUE; break;
+			default:	g_assert_not_reached();
+		}
+	}
+	return FALSE;
+}
+
+/* lower() or upper() of a string field compared with a constant, which was
+ * lowercased at compile time: each value is compared ignoring the case of
+ * its ASCII letters, so that no converted copy of it is needed. */
+static gboolean
+any_cmp_nocase(dfilter_t *df, int reg1, const gchar *literal, dfvm_opcode_t op)
+{
+	GList		*list1;
+	const fvalue_t	*fv;
+	const gchar	*s;
+
+	for (list1 = df->registers[reg1]; list1; list1 = g_list_next(list1)) {
+		fv = (const fvalue_t *)list1->data;
+		/* The functions skip values that aren't strings. */
+		if (!IS_FT_STRING(fv->ftype->ftype)) {
+			continue;
+		}
+		s = fv->value.string;
+		switch (op) {
+			case ANY_EQ:
+				if (g_ascii_strcasecmp(s, literal) == 0)
+					return TRUE;
+				break;
+			case ANY_CONTAINS:
+				if (literal_find((const guint8 *)s, (guint)strlen(s), literal))
+					return TRUE;
+				break;
+			default:
+				g_assert_not_reached();
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+any_contains_any(dfilter_t *df, int reg1, const dfvm_patterns_t *patterns)
+{
+	GList	*list1;
+
+	for (list1 = df->registers[reg1]; list1; list1 = g_list_next(list1)) {
+		if (patterns_contained(patterns, (fvalue_t *)list1->data)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 static gboolean
 any_in_range(dfilter_t *df, int reg1, int reg2, int reg3)
 {
@@ -444,6 +1210,19 @@ any_in_range(dfilter_t *df, int reg1, int reg2, int reg3)
 	return FALSE;
 }
 
+static gboolean
+any_in_set(dfilter_t *df, int reg1, const GArray *set)
+{
+	GList	*list1;
+
+	for (list1 = df->registers[reg1]; list1; list1 = g_list_next(list1)) {
+		if (fvalue_set_contains(set, (fvalue_t *)list1->data)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 
 static void
 free_owned_register(gpointer data, gpointer user_data _U_)
@@ -453,12 +1232,16 @@ free_owned_register(gpointer data, gpointer user_data _U_)
 }
 
 /* Clear registers that were populated during evaluation (leaving constants
- * intact). If we created the values, then these will be freed as well. */
+ * intact). If we created the values, then these will be freed as well;
+ * the results of functions go all at once with their scope. */
 static void
 free_register_overhead(dfilter_t* df)
 {
 	guint i;
 
+	if (df->function_scope)
+		wmem_free_all(df->function_scope);
+
 	for (i = 0; i < df->num_registers; i++) {
 		df->attempted_load[i] = FALSE;
 		if (df->registers[i]) {
@@ -502,6 +1285,44 @@ mk_range(dfilter_t *df, int from_reg, int to_reg, drange_t *d_range)
 
 
 
+/* Checks whether any field with the name of hfinfo (which must be the first
+ * one of that name) is in the tree. */
+static gboolean
+check_exists(proto_tree *tree, header_field_info *hfinfo)
+{
+	while (hfinfo) {
+		if (proto_check_for_protocol_or_field(tree, hfinfo->id)) {
+			return TRUE;
+		}
+		hfinfo = hfinfo->same_name_next;
+	}
+	return FALSE;
+}
+
+/* Charge the time since the previous instruction started to its opcode,
+ * and start timing the next one; next_op is -1 at the end of the run. */
+static void
+prof_next_insn(dfvm_profile_t *prof, int *op, guint64 *start_ns, int next_op)
+{
+	guint64 now = get_monotonic_ns();
+
+	if (*op >= 0)
+		prof->insn_ns[*op] += now - *start_ns;
+	if (next_op >= 0)
+		prof->insn_count[next_op]++;
+	*op = next_op;
+	*start_ns = now;
+}
+
+static void
+prof_end_apply(dfvm_profile_t *prof, guint64 apply_start_ns, gboolean matched)
+{
+	prof->counts.applies++;
+	if (matched)
+		prof->counts.matches++;
+	prof->counts.total_ns += get_monotonic_ns() - apply_start_ns;
+}
+
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree)
 {
@@ -512,12 +1333,34 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	dfvm_value_t	*arg2;
 	dfvm_value_t	*arg3 = NULL;
 	dfvm_value_t	*arg4 = NULL;
-	header_field_info	*hfinfo;
 	GList		*param1;
 	GList		*param2;
+	dfvm_profile_t	*prof = NULL;
+	guint64		apply_start_ns = 0;
+	guint64		insn_start_ns = 0;
+	int		prof_op = -1;
 
 	g_assert(tree);
 
+	WS_PROBE1(dfvm_apply_begin, df->insns->len);
+
+	if (G_UNLIKELY(df->profile != NULL && df->profile->enabled)) {
+		prof = df->profile;
+		apply_start_ns = get_monotonic_ns();
+	}
+
+	/* Reject trees that lack a field the filter cannot match without */
+	for (id = 0; id < df->num_required_fields; id++) {
+		if (!check_exists(tree, df->required_fields[id])) {
+			if (prof != NULL) {
+				prof->counts.required_rejects++;
+				prof_end_apply(prof, apply_start_ns, FALSE);
+			}
+			WS_PROBE1(dfvm_apply_end, FALSE);
+			return FALSE;
+		}
+	}
+
 	length = df->insns->len;
 
 	for (id = 0; id < length; id++) {
@@ -527,19 +1370,12 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 		arg1 = insn->arg1;
 		arg2 = insn->arg2;
 
+		if (G_UNLIKELY(prof != NULL))
+			prof_next_insn(prof, &prof_op, &insn_start_ns, insn->op);
+
 		switch (insn->op) {
 			case CHECK_EXISTS:
-				hfinfo = arg1->value.hfinfo;
-				while(hfinfo) {
-					accum = proto_check_for_protocol_or_field(tree,
-							hfinfo->id);
-					if (accum) {
-						break;
-					}
-					else {
-						hfinfo = hfinfo->same_name_next;
-					}
-				}
+				accum = check_exists(tree, arg1->value.hfinfo);
 				break;
 
 			case READ_TREE:
@@ -558,10 +1394,14 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				if (arg4) {
 					param2 = df->registers[arg4->value.numeric];
 				}
-				accum = arg1->value.funcdef->function(param1, param2,
+				if (df->function_scope == NULL) {
+					df->function_scope = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+				}
+				accum = arg1->value.funcdef->function(df->function_scope,
+						param1, param2,
 						&df->registers[arg2->value.numeric]);
-				// functions create a new value, so own it.
-				df->owns_memory[arg2->value.numeric] = TRUE;
+				// the new values belong to the function scope.
+				df->owns_memory[arg2->value.numeric] = FALSE;
 				break;
 
 			case MK_RANGE:
@@ -612,8 +1452,10 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				break;
 
 			case ANY_MATCHES:
+				arg3 = insn->arg3;
 				accum = any_matches(df,
-						arg1->value.numeric, arg2->value.numeric);
+						arg1->value.numeric, arg2->value.numeric,
+						arg3 ? arg3->value.literal : NULL);
 				break;
 
 			case ANY_IN_RANGE:
@@ -623,12 +1465,56 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 						arg3->value.numeric);
 				break;
 
+			case ANY_IN_SET:
+				accum = any_in_set(df, arg1->value.numeric,
+						arg2->value.fvalue_set);
+				break;
+
+			case ANY_CONTAINS_ANY:
+				accum = any_contains_any(df, arg1->value.numeric,
+						arg2->value.patterns);
+				break;
+
+			case ANY_CMP_UINT:
+				arg3 = insn->arg3;
+				accum = any_cmp_uint(df, arg1->value.numeric,
+						arg2->value.numeric,
+						(dfvm_opcode_t)arg3->value.numeric);
+				break;
+
+			case ANY_CMP_SINT:
+				arg3 = insn->arg3;
+				accum = any_cmp_sint(df, arg1->value.numeric,
+						(gint32)arg2->value.numeric,
+						(dfvm_opcode_t)arg3->value.numeric);
+				break;
+
+			case ANY_CMP_IPV4:
+				arg3 = insn->arg3;
+				arg4 = insn->arg4;
+				accum = any_cmp_ipv4(df, arg1->value.numeric,
+						arg2->value.numeric, arg3->value.numeric,
+						(dfvm_opcode_t)arg4->value.numeric);
+				break;
+
+			case ANY_CMP_NOCASE:
+				arg3 = insn->arg3;
+				accum = any_cmp_nocase(df, arg1->value.numeric,
+						arg2->value.literal,
+						(dfvm_opcode_t)arg3->value.numeric);
+				break;
+
 			case NOT:
 				accum = !accum;
 				break;
 
 			case RETURN:
 				free_register_overhead(df);
+				if (prof != NULL) {
+					prof_next_insn(prof, &prof_op, &insn_start_ns, -1);
+					prof_end_apply(prof, apply_start_ns, accum);
+				}
+				WS_PROBE1(dfvm_apply_end, accum);
 				return accum;
 
 			case IF_TRUE_GOTO:
@@ -710,6 +1596,12 @@ dfvm_init_const(dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case ANY_IN_SET:
+			case ANY_CONTAINS_ANY:
+			case ANY_CMP_UINT:
+			case ANY_CMP_SINT:
+			case ANY_CMP_IPV4:
+			case ANY_CMP_NOCASE:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
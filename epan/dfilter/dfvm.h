@@ -24,9 +24,14 @@ typedef enum {
 	INTEGER,
 	DRANGE,
 	FUNCTION_DEF,
-	PCRE
+	PCRE,
+	FVALUE_SET,
+	PATTERNS,
+	LITERAL
 } dfvm_value_type_t;
 
+typedef struct _dfvm_patterns_t dfvm_patterns_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -37,6 +42,9 @@ typedef struct {
 		header_field_info	*hfinfo;
 		df_func_def_t		*funcdef;
 		GRegex			*pcre;
+		GArray			*fvalue_set;
+		dfvm_patterns_t		*patterns;
+		gchar			*literal;
 	} value;
 
 } dfvm_value_t;
@@ -63,10 +71,26 @@ typedef enum {
 	ANY_MATCHES,
 	MK_RANGE,
 	CALL_FUNCTION,
-	ANY_IN_RANGE
+	ANY_IN_RANGE,
+	ANY_IN_SET,
+	ANY_CONTAINS_ANY,
+	ANY_CMP_UINT,
+	ANY_CMP_SINT,
+	ANY_CMP_IPV4,
+	ANY_CMP_NOCASE
 
 } dfvm_opcode_t;
 
+#define DFVM_NUM_OPCODES	(ANY_CMP_NOCASE + 1)
+
+/* Kept by dfvm_apply() while profiling is enabled on a dfilter */
+typedef struct dfvm_profile {
+	gboolean		enabled;
+	dfilter_profile_t	counts;
+	guint64			insn_count[DFVM_NUM_OPCODES];
+	guint64			insn_ns[DFVM_NUM_OPCODES];
+} dfvm_profile_t;
+
 typedef struct {
 	int		id;
 	dfvm_opcode_t	op;
@@ -85,9 +109,66 @@ dfvm_insn_free(dfvm_insn_t *insn);
 dfvm_value_t*
 dfvm_value_new(dfvm_value_type_t type);
 
+/* Returns an instruction that compares the values of the field in reg
+ * against the constant fv directly, instead of calling the ftype function
+ * for each value, or NULL if the fields of this name or the constant have
+ * no such fast path. op is one of ANY_EQ through ANY_LE. */
+dfvm_insn_t*
+dfvm_insn_new_cmp_const(dfvm_opcode_t op, int reg, header_field_info *hfinfo,
+		const fvalue_t *fv);
+
+/* Returns an instruction that compares lower() or upper() of the string
+ * values of a field against the constant fv, ignoring the case of ASCII
+ * letters in the values instead of converting them, or NULL if funcdef is
+ * another function or the comparison can't be done that way. op is ANY_EQ
+ * or ANY_CONTAINS. The register of the field (arg1) is left for the caller
+ * to fill in. */
+dfvm_insn_t*
+dfvm_insn_new_cmp_nocase(dfvm_opcode_t op, const df_func_def_t *funcdef,
+		const fvalue_t *fv);
+
+/* A set of constant integer or IPv4 values (IPv4 values may be subnets),
+ * kept as sorted, merged ranges so that a membership test is a single
+ * binary search instead of a series of ANY_EQ instructions. */
+GArray*
+dfvm_fvalue_set_new(void);
+
+/* Adds a constant value to the set. Returns FALSE, leaving the set
+ * untouched, if values of this type cannot be kept in a set. */
+gboolean
+dfvm_fvalue_set_add(GArray *set, const fvalue_t *fv);
+
+/* Sorts and merges the set; must be called once all of the values have
+ * been added and before it is used by ANY_IN_SET. */
+void
+dfvm_fvalue_set_finish(GArray *set);
+
+/* A group of constant "contains" operands for the same field, searched
+ * for all at once with an Aho-Corasick automaton by ANY_CONTAINS_ANY. */
+dfvm_patterns_t*
+dfvm_patterns_new(void);
+
+/* Returns TRUE if the value can be searched for as a plain, non-empty
+ * sequence of bytes, i.e. if it can be passed to dfvm_patterns_add(). */
+gboolean
+dfvm_patterns_accepts(const fvalue_t *fv);
+
+/* Adds a pattern, taking ownership of it. All of the patterns must have
+ * the same type. */
+void
+dfvm_patterns_add(dfvm_patterns_t *patterns, fvalue_t *fv);
+
+/* Builds the automaton; must be called once all of the patterns have
+ * been added and before it is used by ANY_CONTAINS_ANY. */
+void
+dfvm_patterns_finish(dfvm_patterns_t *patterns);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df);
 
+const char *
+dfvm_opcode_tostr(dfvm_opcode_t code);
+
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree);
 
@@ -8,6 +8,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "dfilter-int.h"
 #include "gencode.h"
 #include "dfvm.h"
@@ -279,8 +281,45 @@ gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg1, stnode_t *st_ar
 	dfvm_value_t	*jmp1 = NULL, *jmp2 = NULL;
 	int		reg1 = -1, reg2 = -1;
 
-	/* Create code for the LHS and RHS of the relation */
-	reg1 = gen_entity(dfw, st_arg1, &jmp1);
+	/* A field compared with a constant may be done without the ftype
+	 * functions, and without loading the constant in a register. */
+	if (stnode_type_id(st_arg1) == STTYPE_FIELD &&
+			stnode_type_id(st_arg2) == STTYPE_FVALUE) {
+		dfvm_insn_t	*insn;
+
+		reg1 = gen_entity(dfw, st_arg1, &jmp1);
+		insn = dfvm_insn_new_cmp_const(op, reg1,
+				(header_field_info *)stnode_data(st_arg1),
+				(const fvalue_t *)stnode_data(st_arg2));
+		if (insn) {
+			dfw_append_insn(dfw, insn);
+			jmp1->value.numeric = dfw->next_insn_id;
+			return;
+		}
+	} else if (stnode_type_id(st_arg1) == STTYPE_FUNCTION &&
+			stnode_type_id(st_arg2) == STTYPE_FVALUE) {
+		/* lower() or upper() of a field compared with a constant can
+		 * ignore the case of the field instead of calling the function. */
+		GSList		*params = sttype_function_params(st_arg1);
+		dfvm_insn_t	*insn;
+
+		insn = dfvm_insn_new_cmp_nocase(op,
+				sttype_function_funcdef(st_arg1),
+				(const fvalue_t *)stnode_data(st_arg2));
+		if (insn) {
+			g_assert(params && stnode_type_id((stnode_t *)params->data) == STTYPE_FIELD);
+			reg1 = gen_entity(dfw, (stnode_t *)params->data, &jmp1);
+			insn->arg1->value.numeric = reg1;
+			dfw_append_insn(dfw, insn);
+			jmp1->value.numeric = dfw->next_insn_id;
+			return;
+		}
+		reg1 = gen_entity(dfw, st_arg1, &jmp1);
+	} else {
+		reg1 = gen_entity(dfw, st_arg1, &jmp1);
+	}
+
+	/* Create code for the RHS of the relation */
 	reg2 = gen_entity(dfw, st_arg2, &jmp2);
 
 	/* Then combine them in a DFVM insruction */
@@ -297,6 +336,90 @@ gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg1, stnode_t *st_ar
 	}
 }
 
+/* Returns the longest run of literal characters at the start of a pattern
+ * (after an optional '^') that every match must contain, lowercased, or
+ * NULL if there is none worth looking for before running the regex. This
+ * is deliberately conservative; anything unusual ends the run. */
+static gchar *
+regex_required_literal(const char *pattern)
+{
+	GString		*literal;
+	const char	*p = pattern;
+
+	/* An alternative could match without the literal. */
+	if (strchr(pattern, '|')) {
+		return NULL;
+	}
+
+	literal = g_string_new(NULL);
+	if (*p == '^') {
+		p++;
+	}
+	for (; *p != '\0'; p++) {
+		if (*p == '\\' && p[1] != '\0' && (guchar)p[1] < 0x80 &&
+				!g_ascii_isalnum(p[1])) {
+			/* An escaped punctuation or space character */
+			p++;
+		} else if ((guchar)*p >= 0x80 || strchr("\\^$.[]()?*+{}", *p)) {
+			break;
+		}
+		g_string_append_c(literal, g_ascii_tolower(*p));
+	}
+
+	/* A quantifier may make the last character optional. */
+	if ((*p == '?' || *p == '*' || *p == '{') && literal->len > 0) {
+		g_string_truncate(literal, literal->len - 1);
+	}
+
+	if (literal->len < 2) {
+		g_string_free(literal, TRUE);
+		return NULL;
+	}
+	return g_string_free(literal, FALSE);
+}
+
+/* Generate the code for the matches operator, with a check for a literal
+ * from the regex that gets values without it rejected cheaply. */
+static void
+gen_relation_matches(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2, *val3;
+	dfvm_value_t	*jmp1 = NULL, *jmp2 = NULL;
+	gchar		*literal = NULL;
+	int		reg1, reg2;
+
+	if (stnode_type_id(st_arg2) == STTYPE_PCRE) {
+		literal = regex_required_literal(
+				g_regex_get_pattern((GRegex *)stnode_data(st_arg2)));
+	}
+
+	reg1 = gen_entity(dfw, st_arg1, &jmp1);
+	reg2 = gen_entity(dfw, st_arg2, &jmp2);
+
+	insn = dfvm_insn_new(ANY_MATCHES);
+	val1 = dfvm_value_new(REGISTER);
+	val1->value.numeric = reg1;
+	val2 = dfvm_value_new(REGISTER);
+	val2->value.numeric = reg2;
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	if (literal) {
+		val3 = dfvm_value_new(LITERAL);
+		val3->value.literal = literal;
+		insn->arg3 = val3;
+	}
+	dfw_append_insn(dfw, insn);
+
+	if (jmp1) {
+		jmp1->value.numeric = dfw->next_insn_id;
+	}
+
+	if (jmp2) {
+		jmp2->value.numeric = dfw->next_insn_id;
+	}
+}
+
 static void
 fixup_jumps(gpointer data, gpointer user_data)
 {
@@ -308,6 +431,46 @@ fixup_jumps(gpointer data, gpointer user_data)
 	}
 }
 
+/* Sets with fewer constant values than this are tested with a series of
+ * ANY_EQ instructions; larger ones use a single ANY_IN_SET lookup. */
+#define IN_SET_MIN_VALUES	8
+
+/* Put the constant values of the set that can be looked up through
+ * ANY_IN_SET into *p_set, and return the list of the other elements (in the
+ * same node pairs format). If there are too few of them to be worth it, the
+ * whole list is returned and *p_set is NULL. */
+static GSList *
+gen_relation_in_split(GSList *nodelist, GArray **p_set)
+{
+	GArray		*set = dfvm_fvalue_set_new();
+	GSList		*rest = NULL;
+	stnode_t	*node1, *node2;
+
+	while (nodelist) {
+		node1 = (stnode_t*)nodelist->data;
+		nodelist = g_slist_next(nodelist);
+		node2 = (stnode_t*)nodelist->data;
+		nodelist = g_slist_next(nodelist);
+
+		if (node2 || stnode_type_id(node1) != STTYPE_FVALUE ||
+				!dfvm_fvalue_set_add(set, (fvalue_t *)stnode_data(node1))) {
+			rest = g_slist_prepend(rest, node1);
+			rest = g_slist_prepend(rest, node2);
+		}
+	}
+
+	if (set->len < IN_SET_MIN_VALUES) {
+		g_array_free(set, TRUE);
+		g_slist_free(rest);
+		*p_set = NULL;
+		return NULL;
+	}
+
+	dfvm_fvalue_set_finish(set);
+	*p_set = set;
+	return g_slist_reverse(rest);
+}
+
 /* Generate the code for the in operator.  It behaves much like an OR-ed
  * series of == tests, but without the redundant existence checks. */
 static void
@@ -318,14 +481,36 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 	dfvm_value_t	*jmp1 = NULL, *jmp2 = NULL, *jmp3 = NULL;
 	int		reg1;
 	stnode_t	*node1, *node2;
-	GSList		*nodelist_head, *nodelist;
+	GSList		*nodelist_head, *nodelist, *rest;
 	GSList		*jumplist = NULL;
+	GArray		*set;
 
 	/* Create code for the LHS of the relation */
 	reg1 = gen_entity(dfw, st_arg1, &jmp1);
 
 	/* Create code for the set on the RHS of the relation */
-	nodelist_head = nodelist = (GSList*)stnode_steal_data(st_arg2);
+	nodelist_head = (GSList*)stnode_steal_data(st_arg2);
+	rest = gen_relation_in_split(nodelist_head, &set);
+	nodelist = set ? rest : nodelist_head;
+	if (set) {
+		/* Test all of the constant values at once. */
+		insn = dfvm_insn_new(ANY_IN_SET);
+		val1 = dfvm_value_new(REGISTER);
+		val1->value.numeric = reg1;
+		val2 = dfvm_value_new(FVALUE_SET);
+		val2->value.fvalue_set = set;
+		insn->arg1 = val1;
+		insn->arg2 = val2;
+		dfw_append_insn(dfw, insn);
+
+		if (nodelist) {
+			insn = dfvm_insn_new(IF_TRUE_GOTO);
+			val1 = dfvm_value_new(INSN_NUMBER);
+			insn->arg1 = val1;
+			dfw_append_insn(dfw, insn);
+			jumplist = g_slist_prepend(jumplist, val1);
+		}
+	}
 	while (nodelist) {
 		node1 = (stnode_t*)nodelist->data;
 		nodelist = g_slist_next(nodelist);
@@ -390,9 +575,290 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 
 	/* Clean up */
 	g_slist_free(jumplist);
+	g_slist_free(rest);
 	set_nodelist_free(nodelist_head);
 }
 
+/* Rough relative costs of evaluating parts of a test, used to order the
+ * operands of "and" and "or" so that cheap tests can decide the result
+ * before expensive ones have to run. */
+#define COST_EXISTS		1
+#define COST_COMPARE		1
+#define COST_FIELD_SCALAR	1
+#define COST_FIELD_STRING	2
+#define COST_RANGE		3
+#define COST_FUNCTION		4
+#define COST_CONTAINS		4
+#define COST_MATCHES		8
+
+static guint
+gen_entity_cost(stnode_t *st_arg)
+{
+	header_field_info	*hfinfo;
+
+	switch (stnode_type_id(st_arg)) {
+		case STTYPE_FIELD:
+			hfinfo = (header_field_info*)stnode_data(st_arg);
+			if (IS_FT_STRING(hfinfo->type) || hfinfo->type == FT_BYTES ||
+					hfinfo->type == FT_UINT_BYTES || hfinfo->type == FT_PROTOCOL) {
+				return COST_FIELD_STRING;
+			}
+			return COST_FIELD_SCALAR;
+		case STTYPE_RANGE:
+			return COST_RANGE;
+		case STTYPE_FUNCTION:
+			return COST_FUNCTION;
+		default:
+			/* Constants are loaded before the filter runs. */
+			return 0;
+	}
+}
+
+static guint
+gen_test_cost(stnode_t *st_node)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST) {
+		return 0;
+	}
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case TEST_OP_EXISTS:
+			return COST_EXISTS;
+		case TEST_OP_NOT:
+			return gen_test_cost(st_arg1);
+		case TEST_OP_AND:
+		case TEST_OP_OR:
+			return gen_test_cost(st_arg1) + gen_test_cost(st_arg2);
+		case TEST_OP_CONTAINS:
+			return COST_CONTAINS + gen_entity_cost(st_arg1);
+		case TEST_OP_MATCHES:
+			return COST_MATCHES + gen_entity_cost(st_arg1);
+		case TEST_OP_IN:
+			/* The set is made of constants. */
+			return COST_COMPARE + gen_entity_cost(st_arg1);
+		default:
+			return COST_COMPARE + gen_entity_cost(st_arg1) +
+				gen_entity_cost(st_arg2);
+	}
+}
+
+static void
+gen_collect(stnode_t *st_node, test_op_t op, GPtrArray *tests)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) == STTYPE_TEST) {
+		sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+		if (st_op == op) {
+			gen_collect(st_arg1, op, tests);
+			gen_collect(st_arg2, op, tests);
+			return;
+		}
+	}
+	g_ptr_array_add(tests, st_node);
+}
+
+static gint
+gen_test_cost_compare(gconstpointer a, gconstpointer b)
+{
+	guint cost_a = gen_test_cost(*(stnode_t * const *)a);
+	guint cost_b = gen_test_cost(*(stnode_t * const *)b);
+
+	if (cost_a != cost_b) {
+		return cost_a < cost_b ? -1 : 1;
+	}
+	return 0;
+}
+
+/* Generate the code for a series of AND-ed tests, cheapest first, exiting
+ * as soon as one is false. Tests have no side effects, so their order only
+ * matters for speed. */
+static void
+gen_and(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	GPtrArray	*tests;
+	GSList		*jumplist = NULL;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1;
+	guint		i;
+
+	tests = g_ptr_array_new();
+	gen_collect(st_arg1, TEST_OP_AND, tests);
+	gen_collect(st_arg2, TEST_OP_AND, tests);
+	/* g_ptr_array_sort() is stable, so equal costs keep the filter order. */
+	g_ptr_array_sort(tests, gen_test_cost_compare);
+
+	for (i = 0; i < tests->len; i++) {
+		gencode(dfw, (stnode_t *)g_ptr_array_index(tests, i));
+
+		if (i + 1 < tests->len) {
+			insn = dfvm_insn_new(IF_FALSE_GOTO);
+			val1 = dfvm_value_new(INSN_NUMBER);
+			insn->arg1 = val1;
+			dfw_append_insn(dfw, insn);
+			jumplist = g_slist_prepend(jumplist, val1);
+		}
+	}
+	g_slist_foreach(jumplist, fixup_jumps, dfw);
+
+	g_slist_free(jumplist);
+	g_ptr_array_free(tests, TRUE);
+}
+
+/* An operand of a series of OR-ed tests. "contains" tests of the same
+ * field against constants of the same type are grouped together. */
+typedef struct {
+	header_field_info	*hfinfo;
+	ftenum_t		ftype;
+	GPtrArray		*tests;
+} or_operand_t;
+
+/* Returns the field of a "field contains constant" test that can be
+ * searched for along with others, or NULL. */
+static header_field_info *
+gen_or_contains_field(stnode_t *st_node, ftenum_t *ftype)
+{
+	test_op_t		st_op;
+	stnode_t		*st_arg1, *st_arg2;
+	header_field_info	*hfinfo;
+	fvalue_t		*fv;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST) {
+		return NULL;
+	}
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	if (st_op != TEST_OP_CONTAINS ||
+			stnode_type_id(st_arg1) != STTYPE_FIELD ||
+			stnode_type_id(st_arg2) != STTYPE_FVALUE) {
+		return NULL;
+	}
+	fv = (fvalue_t *)stnode_data(st_arg2);
+	if (!dfvm_patterns_accepts(fv)) {
+		return NULL;
+	}
+
+	/* Rewind to find the first field of this name, as READ_TREE does. */
+	hfinfo = (header_field_info*)stnode_data(st_arg1);
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+	*ftype = fvalue_type_ftenum(fv);
+	return hfinfo;
+}
+
+/* Generate one ANY_CONTAINS_ANY for a group of "contains" tests. */
+static void
+gen_contains_any(dfwork_t *dfw, GPtrArray *tests)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2;
+	dfvm_value_t	*jmp1 = NULL;
+	dfvm_patterns_t	*patterns;
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	guint		i;
+	int		reg1;
+
+	sttype_test_get((stnode_t *)g_ptr_array_index(tests, 0), &st_op, &st_arg1, &st_arg2);
+	reg1 = gen_entity(dfw, st_arg1, &jmp1);
+
+	patterns = dfvm_patterns_new();
+	for (i = 0; i < tests->len; i++) {
+		sttype_test_get((stnode_t *)g_ptr_array_index(tests, i), &st_op, &st_arg1, &st_arg2);
+		dfvm_patterns_add(patterns, (fvalue_t *)stnode_steal_data(st_arg2));
+	}
+	dfvm_patterns_finish(patterns);
+
+	insn = dfvm_insn_new(ANY_CONTAINS_ANY);
+	val1 = dfvm_value_new(REGISTER);
+	val1->value.numeric = reg1;
+	val2 = dfvm_value_new(PATTERNS);
+	val2->value.patterns = patterns;
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	dfw_append_insn(dfw, insn);
+
+	if (jmp1) {
+		jmp1->value.numeric = dfw->next_insn_id;
+	}
+}
+
+/* Generate the code for a series of OR-ed tests, cheapest first, exiting
+ * as soon as one is true. "contains" tests of the same field are done
+ * together, in a single pass over its values. */
+static void
+gen_or(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	GPtrArray	*tests, *operands;
+	or_operand_t	*operand;
+	header_field_info	*hfinfo;
+	ftenum_t	ftype = FT_NONE;
+	GSList		*jumplist = NULL;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1;
+	guint		i, j;
+
+	tests = g_ptr_array_new();
+	gen_collect(st_arg1, TEST_OP_OR, tests);
+	gen_collect(st_arg2, TEST_OP_OR, tests);
+	g_ptr_array_sort(tests, gen_test_cost_compare);
+
+	operands = g_ptr_array_new();
+	for (i = 0; i < tests->len; i++) {
+		stnode_t *st_node = (stnode_t *)g_ptr_array_index(tests, i);
+
+		operand = NULL;
+		hfinfo = gen_or_contains_field(st_node, &ftype);
+		if (hfinfo) {
+			for (j = 0; j < operands->len; j++) {
+				or_operand_t *other = (or_operand_t *)g_ptr_array_index(operands, j);
+				if (other->hfinfo == hfinfo && other->ftype == ftype) {
+					operand = other;
+					break;
+				}
+			}
+		}
+		if (!operand) {
+			operand = g_new(or_operand_t, 1);
+			operand->hfinfo = hfinfo;
+			operand->ftype = ftype;
+			operand->tests = g_ptr_array_new();
+			g_ptr_array_add(operands, operand);
+		}
+		g_ptr_array_add(operand->tests, st_node);
+	}
+
+	for (i = 0; i < operands->len; i++) {
+		operand = (or_operand_t *)g_ptr_array_index(operands, i);
+		if (operand->tests->len > 1) {
+			gen_contains_any(dfw, operand->tests);
+		} else {
+			gencode(dfw, (stnode_t *)g_ptr_array_index(operand->tests, 0));
+		}
+
+		/* Exit as soon as one of the tests is true */
+		if (i + 1 < operands->len) {
+			insn = dfvm_insn_new(IF_TRUE_GOTO);
+			val1 = dfvm_value_new(INSN_NUMBER);
+			insn->arg1 = val1;
+			dfw_append_insn(dfw, insn);
+			jumplist = g_slist_prepend(jumplist, val1);
+		}
+		g_ptr_array_free(operand->tests, TRUE);
+		g_free(operand);
+	}
+	g_slist_foreach(jumplist, fixup_jumps, dfw);
+
+	g_slist_free(jumplist);
+	g_ptr_array_free(operands, TRUE);
+	g_ptr_array_free(tests, TRUE);
+}
+
 /* Parse an entity, returning the reg that it gets put into.
  * p_jmp will be set if it has to be set by the calling code; it should
  * be set to the place to jump to, to return to the calling code,
@@ -477,33 +943,28 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case TEST_OP_NOT:
+			if (stnode_type_id(st_arg1) == STTYPE_TEST) {
+				test_op_t	inner_op;
+				stnode_t	*inner_arg1, *inner_arg2;
+
+				sttype_test_get(st_arg1, &inner_op, &inner_arg1, &inner_arg2);
+				if (inner_op == TEST_OP_NOT) {
+					/* "not not x" is just "x" */
+					gencode(dfw, inner_arg1);
+					break;
+				}
+			}
 			gencode(dfw, st_arg1);
 			insn = dfvm_insn_new(NOT);
 			dfw_append_insn(dfw, insn);
 			break;
 
 		case TEST_OP_AND:
-			gencode(dfw, st_arg1);
-
-			insn = dfvm_insn_new(IF_FALSE_GOTO);
-			val1 = dfvm_value_new(INSN_NUMBER);
-			insn->arg1 = val1;
-			dfw_append_insn(dfw, insn);
-
-			gencode(dfw, st_arg2);
-			val1->value.numeric = dfw->next_insn_id;
+			gen_and(dfw, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_OR:
-			gencode(dfw, st_arg1);
-
-			insn = dfvm_insn_new(IF_TRUE_GOTO);
-			val1 = dfvm_value_new(INSN_NUMBER);
-			insn->arg1 = val1;
-			dfw_append_insn(dfw, insn);
-
-			gencode(dfw, st_arg2);
-			val1->value.numeric = dfw->next_insn_id;
+			gen_or(dfw, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_EQ:
@@ -539,7 +1000,7 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case TEST_OP_MATCHES:
-			gen_relation(dfw, ANY_MATCHES, st_arg1, st_arg2);
+			gen_relation_matches(dfw, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_IN:
@@ -689,6 +1150,88 @@ dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields)
 	return hki.fields;
 }
 
+
+static void
+add_required_field(stnode_t *st_arg, GPtrArray *fields)
+{
+	header_field_info	*hfinfo;
+	guint			i;
+
+	if (stnode_type_id(st_arg) != STTYPE_FIELD) {
+		return;
+	}
+
+	/* Rewind to find the first field of this name. */
+	hfinfo = (header_field_info*)stnode_data(st_arg);
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+
+	for (i = 0; i < fields->len; i++) {
+		if (g_ptr_array_index(fields, i) == hfinfo) {
+			return;
+		}
+	}
+	g_ptr_array_add(fields, hfinfo);
+}
+
+/* Collect the fields that must be present for the test to be true: those
+ * that are tested or compared outside of any "not" or "or". */
+static void
+collect_required_fields(stnode_t *st_node, GPtrArray *fields)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST) {
+		return;
+	}
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case TEST_OP_UNINITIALIZED:
+		case TEST_OP_NOT:
+		case TEST_OP_OR:
+			break;
+
+		case TEST_OP_AND:
+			collect_required_fields(st_arg1, fields);
+			collect_required_fields(st_arg2, fields);
+			break;
+
+		case TEST_OP_EXISTS:
+			add_required_field(st_arg1, fields);
+			break;
+
+		default:
+			/* A relation is false if a field in it is missing. */
+			add_required_field(st_arg1, fields);
+			if (st_arg2) {
+				add_required_field(st_arg2, fields);
+			}
+			break;
+	}
+}
+
+/* Returns the fields (each the first one of its name) of which at least
+ * one instance must be in a tree for the filter to match it, so that
+ * dfvm_apply() can reject trees that lack one before running the code. */
+header_field_info**
+dfw_required_fields(dfwork_t *dfw, int *caller_num_fields)
+{
+	GPtrArray	*fields;
+
+	fields = g_ptr_array_new();
+	collect_required_fields(dfw->st_root, fields);
+
+	*caller_num_fields = fields->len;
+	if (fields->len == 0) {
+		g_ptr_array_free(fields, TRUE);
+		return NULL;
+	}
+	return (header_field_info **)g_ptr_array_free(fields, FALSE);
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -206,6 +206,18 @@ static int      last_length_offset;
 static int      last_length_len;
 static gboolean last_ind;
 
+/* Lengths of indefinite length encodings found so far in the current packet,
+ * keyed by tvb and offset of the length octet.  Finding one means walking all
+ * of the contents up to the EOC, and each nested indefinite length element is
+ * walked again when it is dissected, so without this the cost grows with the
+ * square of the nesting depth. */
+typedef struct {
+    const tvbuff_t *tvb;
+    int             offset;
+} ber_indef_key_t;
+
+static wmem_map_t *ber_indef_lengths = NULL;
+
 static const value_string ber_class_codes[] = {
     { BER_CLASS_UNI,    "UNIVERSAL" },
     { BER_CLASS_APP,    "APPLICATION" },
@@ -1256,6 +1268,31 @@ dissect_ber_identifier(packet_info *pinfo _U_, proto_tree *tree, tvbuff_t *tvb,
     return offset;
 }
 
+static guint
+ber_indef_key_hash(gconstpointer k)
+{
+    const ber_indef_key_t *key = (const ber_indef_key_t *)k;
+
+    return g_direct_hash(key->tvb) ^ g_int_hash(&key->offset);
+}
+
+static gboolean
+ber_indef_key_equal(gconstpointer k1, gconstpointer k2)
+{
+    const ber_indef_key_t *key1 = (const ber_indef_key_t *)k1;
+    const ber_indef_key_t *key2 = (const ber_indef_key_t *)k2;
+
+    return key1->tvb == key2->tvb && key1->offset == key2->offset;
+}
+
+static gboolean
+ber_indef_lengths_free_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_, void *user_data _U_)
+{
+    ber_indef_lengths = NULL;
+    /* Registered again along with the next packet's map. */
+    return FALSE;
+}
+
 /** Try to get the length octets of the BER TLV.
  * Only (TAGs and) LENGTHs that fit inside 32 bit integers are supported.
  *
@@ -1300,6 +1337,19 @@ try_get_ber_length(tvbuff_t *tvb, int offset, guint32 *length, gboolean *ind, gi
             }
         } else {
             /* 8.1.3.6 */
+            ber_indef_key_t key;
+            guint32         *cached;
+
+            key.tvb = tvb;
+            key.offset = offset;
+            if (ber_indef_lengths &&
+                (cached = (guint32 *)wmem_map_lookup(ber_indef_lengths, &key)) != NULL) {
+                if (length)
+                    *length = *cached;
+                if (ind)
+                    *ind = TRUE;
+                return offset;
+            }
 
             tmp_offset = offset;
             /* ok in here we can traverse the BER to find the length, this will fix most indefinite length issues */
@@ -1327,6 +1377,19 @@ try_get_ber_length(tvbuff_t *tvb, int offset, guint32 *length, gboolean *ind, gi
     if (tmp_length > (guint32)G_MAXINT32)
         tmp_length = (guint32)G_MAXINT32;
 
+    if (tmp_ind) {
+        ber_indef_key_t *key;
+
+        if (!ber_indef_lengths) {
+            ber_indef_lengths = wmem_map_new(wmem_packet_scope(), ber_indef_key_hash, ber_indef_key_equal);
+            wmem_register_callback(wmem_packet_scope(), ber_indef_lengths_free_cb, NULL);
+        }
+        key = wmem_new(wmem_packet_scope(), ber_indef_key_t);
+        key->tvb = tvb;
+        key->offset = offset;
+        wmem_map_insert(ber_indef_lengths, key, wmem_memdup(wmem_packet_scope(), &tmp_length, sizeof tmp_length));
+    }
+
     if (length)
         *length = tmp_length;
     if (ind)
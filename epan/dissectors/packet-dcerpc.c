@@ -1835,29 +1835,44 @@ dcerpc_auth_context_hash(gconstpointer k)
 /*
  * To keep track of callid mappings.  Should really use some generic
  * conversation support instead.
+ *
+ * Calls are keyed by the index of their conversation rather than by a
+ * pointer to it, which keeps the keys small.  Connection oriented calls
+ * are only kept here until their response (or fault) is complete; after
+ * that, their frames find them in dcerpc_matched.
  */
 static wmem_map_t *dcerpc_cn_calls = NULL;
 static wmem_map_t *dcerpc_dg_calls = NULL;
 
 typedef struct _dcerpc_cn_call_key {
-    conversation_t *conv;
+    guint32 conv_index;
     guint32 call_id;
     guint64 transport_salt;
 } dcerpc_cn_call_key;
 
 typedef struct _dcerpc_dg_call_key {
-    conversation_t *conv;
+    guint32         conv_index;
     guint32         seqnum;
     e_guid_t        act_id ;
 } dcerpc_dg_call_key;
 
+/* Mixes a 64 bit value into a hash; cheap, but spreads consecutive
+ * call IDs and conversation indexes over the whole table. */
+static inline guint
+dcerpc_hash_mix(guint64 h)
+{
+    h ^= h >> 33;
+    h *= G_GUINT64_CONSTANT(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    return (guint)h;
+}
 
 static gint
 dcerpc_cn_call_equal(gconstpointer k1, gconstpointer k2)
 {
     const dcerpc_cn_call_key *key1 = (const dcerpc_cn_call_key *)k1;
     const dcerpc_cn_call_key *key2 = (const dcerpc_cn_call_key *)k2;
-    return ((key1->conv == key2->conv)
+    return ((key1->conv_index == key2->conv_index)
             && (key1->call_id == key2->call_id)
             && (key1->transport_salt == key2->transport_salt));
 }
@@ -1867,7 +1882,7 @@ dcerpc_dg_call_equal(gconstpointer k1, gconstpointer k2)
 {
     const dcerpc_dg_call_key *key1 = (const dcerpc_dg_call_key *)k1;
     const dcerpc_dg_call_key *key2 = (const dcerpc_dg_call_key *)k2;
-    return ((key1->conv == key2->conv)
+    return ((key1->conv_index == key2->conv_index)
             && (key1->seqnum == key2->seqnum)
             && ((memcmp(&key1->act_id, &key2->act_id, sizeof (e_guid_t)) == 0)));
 }
@@ -1876,27 +1891,22 @@ static guint
 dcerpc_cn_call_hash(gconstpointer k)
 {
     const dcerpc_cn_call_key *key = (const dcerpc_cn_call_key *)k;
-    guint hash;
-
-    hash = GPOINTER_TO_UINT(key->conv);
-    hash += key->call_id;
-    /* sizeof(guint) might be smaller than sizeof(guint64) */
-    hash += (guint)key->transport_salt;
-    hash += (guint)(key->transport_salt << sizeof(guint));
 
-    return hash;
+    return dcerpc_hash_mix((((guint64)key->conv_index << 32) | key->call_id)
+                           ^ key->transport_salt);
 }
 
 static guint
 dcerpc_dg_call_hash(gconstpointer k)
 {
     const dcerpc_dg_call_key *key = (const dcerpc_dg_call_key *)k;
-    return (GPOINTER_TO_UINT(key->conv) + key->seqnum + key->act_id.data1
+    return dcerpc_hash_mix(((guint64)key->conv_index << 32) | key->seqnum)
+            + key->act_id.data1
             + (key->act_id.data2 << 16)    + key->act_id.data3
             + (key->act_id.data4[0] << 24) + (key->act_id.data4[1] << 16)
             + (key->act_id.data4[2] << 8)  + (key->act_id.data4[3] << 0)
             + (key->act_id.data4[4] << 24) + (key->act_id.data4[5] << 16)
-            + (key->act_id.data4[6] << 8)  + (key->act_id.data4[7] << 0));
+            + (key->act_id.data4[6] << 8)  + (key->act_id.data4[7] << 0);
 }
 
 /* to keep track of matched calls/responses
@@ -1926,7 +1936,92 @@ static guint
 dcerpc_matched_hash(gconstpointer k)
 {
     const dcerpc_matched_key *key = (const dcerpc_matched_key *)k;
-    return key->frame;
+    return dcerpc_hash_mix(((guint64)key->frame << 32) | key->call_id);
+}
+
+/*
+ * There is a call value and a matched key for every call, and a matched key
+ * for every fragment of its request and response, all of which live as long
+ * as the file; rather than allocating each of them on its own, they are
+ * carved out of larger blocks.  Keys of calls in progress are given back
+ * when the call is complete, and reused for later calls.
+ */
+#define DCERPC_POOL_BLOCK_ITEMS 256
+
+typedef struct _dcerpc_pool {
+    guint8 *next;       /* unused part of the current block */
+    guint   left;       /* items that still fit in it */
+    void   *free_list;  /* items given back, linked through their first bytes */
+} dcerpc_pool_t;
+
+static dcerpc_pool_t dcerpc_call_value_pool;
+static dcerpc_pool_t dcerpc_cn_call_key_pool;
+static dcerpc_pool_t dcerpc_dg_call_key_pool;
+static dcerpc_pool_t dcerpc_matched_key_pool;
+
+static void *
+dcerpc_pool_alloc(dcerpc_pool_t *pool, size_t size)
+{
+    void *item;
+
+    if (pool->free_list) {
+        item = pool->free_list;
+        pool->free_list = *(void **)item;
+        return item;
+    }
+    if (pool->left == 0) {
+        pool->next = (guint8 *)wmem_alloc(wmem_file_scope(), size * DCERPC_POOL_BLOCK_ITEMS);
+        pool->left = DCERPC_POOL_BLOCK_ITEMS;
+    }
+    item = pool->next;
+    pool->next += size;
+    pool->left--;
+    return item;
+}
+
+static void
+dcerpc_pool_free(dcerpc_pool_t *pool, void *item)
+{
+    *(void **)item = pool->free_list;
+    pool->free_list = item;
+}
+
+#define dcerpc_pool_new(pool, type) ((type *)dcerpc_pool_alloc((pool), sizeof(type)))
+
+static void
+dcerpc_call_pools_cleanup(void)
+{
+    /* The blocks go with the file scope. */
+    memset(&dcerpc_call_value_pool, 0, sizeof(dcerpc_pool_t));
+    memset(&dcerpc_cn_call_key_pool, 0, sizeof(dcerpc_pool_t));
+    memset(&dcerpc_dg_call_key_pool, 0, sizeof(dcerpc_pool_t));
+    memset(&dcerpc_matched_key_pool, 0, sizeof(dcerpc_pool_t));
+}
+
+static void
+dcerpc_add_matched(guint32 frame, guint32 call_id, dcerpc_call_value *call_value)
+{
+    dcerpc_matched_key *key;
+
+    key = dcerpc_pool_new(&dcerpc_matched_key_pool, dcerpc_matched_key);
+    key->frame = frame;
+    key->call_id = call_id;
+    wmem_map_insert(dcerpc_matched, key, call_value);
+}
+
+/* Forgets a connection oriented call once its response or fault is complete
+ * in the first pass, if it is still the call in the table under that key. */
+static void
+dcerpc_cn_call_expire(const dcerpc_cn_call_key *call_key, dcerpc_call_value *call_value)
+{
+    const void *orig_key;
+    void       *value;
+
+    if (wmem_map_lookup_extended(dcerpc_cn_calls, call_key, &orig_key, &value) &&
+            value == call_value) {
+        wmem_map_remove(dcerpc_cn_calls, call_key);
+        dcerpc_pool_free(&dcerpc_cn_call_key_pool, (void *)orig_key);
+    }
 }
 
 static gboolean
@@ -4608,7 +4703,7 @@ dissect_dcerpc_cn_rqst(tvbuff_t *tvb, gint offset, packet_info *pinfo,
     if (!conv)
         show_stub_data(pinfo, tvb, offset, dcerpc_tree, &auth_info, TRUE);
     else {
-        dcerpc_matched_key matched_key, *new_matched_key;
+        dcerpc_matched_key matched_key;
         dcerpc_call_value *value;
 
         /* !!! we can NOT check visited here since this will interact
@@ -4632,36 +4727,37 @@ dissect_dcerpc_cn_rqst(tvbuff_t *tvb, gint offset, packet_info *pinfo,
                     dcerpc_cn_call_key call_key;
                     dcerpc_call_value *call_value;
 
-                    call_key.conv = conv;
+                    call_key.conv_index = conv->conv_index;
                     call_key.call_id = hdr->call_id;
                     call_key.transport_salt = dcerpc_get_transport_salt(pinfo);
                     if ((call_value = (dcerpc_call_value *)wmem_map_lookup(dcerpc_cn_calls, &call_key))) {
-                        new_matched_key = wmem_new(wmem_file_scope(), dcerpc_matched_key);
-                        *new_matched_key = matched_key;
-                        wmem_map_insert(dcerpc_matched, new_matched_key, call_value);
+                        dcerpc_add_matched(matched_key.frame, matched_key.call_id, call_value);
                         value = call_value;
                     }
                 } else {
                     dcerpc_cn_call_key *call_key;
                     dcerpc_call_value *call_value;
+                    const void *old_key;
+                    void *old_value;
 
                     /* We found the binding and it is the first fragment
                        (or a complete PDU) of a dcerpc pdu so just add
                        the call to both the call table and the
                        matched table
                     */
-                    call_key = wmem_new(wmem_file_scope(), dcerpc_cn_call_key);
-                    call_key->conv = conv;
+                    call_key = dcerpc_pool_new(&dcerpc_cn_call_key_pool, dcerpc_cn_call_key);
+                    call_key->conv_index = conv->conv_index;
                     call_key->call_id = hdr->call_id;
                     call_key->transport_salt = dcerpc_get_transport_salt(pinfo);
 
                     /* if there is already a matching call in the table
                        remove it so it is replaced with the new one */
-                    if (wmem_map_lookup(dcerpc_cn_calls, call_key)) {
+                    if (wmem_map_lookup_extended(dcerpc_cn_calls, call_key, &old_key, &old_value)) {
                         wmem_map_remove(dcerpc_cn_calls, call_key);
+                        dcerpc_pool_free(&dcerpc_cn_call_key_pool, (void *)old_key);
                     }
 
-                    call_value = wmem_new(wmem_file_scope(), dcerpc_call_value);
+                    call_value = dcerpc_pool_new(&dcerpc_call_value_pool, dcerpc_call_value);
                     call_value->uuid = bind_value->uuid;
                     call_value->ver = bind_value->ver;
                     call_value->object_uuid = obj_id;
@@ -4680,9 +4776,7 @@ dissect_dcerpc_cn_rqst(tvbuff_t *tvb, gint offset, packet_info *pinfo,
 
                     wmem_map_insert(dcerpc_cn_calls, call_key, call_value);
 
-                    new_matched_key = wmem_new(wmem_file_scope(), dcerpc_matched_key);
-                    *new_matched_key = matched_key;
-                    wmem_map_insert(dcerpc_matched, new_matched_key, call_value);
+                    dcerpc_add_matched(matched_key.frame, matched_key.call_id, call_value);
                     value = call_value;
                 }
             }
@@ -4774,7 +4868,7 @@ dissect_dcerpc_cn_resp(tvbuff_t *tvb, gint offset, packet_info *pinfo,
         /* no point in creating one here, really */
         show_stub_data(pinfo, tvb, offset, dcerpc_tree, &auth_info, TRUE);
     } else {
-        dcerpc_matched_key matched_key, *new_matched_key;
+        dcerpc_matched_key matched_key;
 
         /* !!! we can NOT check visited here since this will interact
            badly with when SMB handles (i.e. calls the subdissector)
@@ -4788,7 +4882,7 @@ dissect_dcerpc_cn_resp(tvbuff_t *tvb, gint offset, packet_info *pinfo,
             dcerpc_cn_call_key call_key;
             dcerpc_call_value *call_value;
 
-            call_key.conv = conv;
+            call_key.conv_index = conv->conv_index;
             call_key.call_id = hdr->call_id;
             call_key.transport_salt = dcerpc_get_transport_salt(pinfo);
 
@@ -4796,13 +4890,14 @@ dissect_dcerpc_cn_resp(tvbuff_t *tvb, gint offset, packet_info *pinfo,
                 /* extra sanity check,  only match them if the reply
                    came after the request */
                 if (call_value->req_frame<pinfo->num) {
-                    new_matched_key = wmem_new(wmem_file_scope(), dcerpc_matched_key);
-                    *new_matched_key = matched_key;
-                    wmem_map_insert(dcerpc_matched, new_matched_key, call_value);
+                    dcerpc_add_matched(matched_key.frame, matched_key.call_id, call_value);
                     value = call_value;
                     if (call_value->rep_frame == 0) {
                         call_value->rep_frame = pinfo->num;
                     }
+                    if ((hdr->flags&PFC_LAST_FRAG) && !pinfo->fd->visited) {
+                        dcerpc_cn_call_expire(&call_key, call_value);
+                    }
                 }
             }
         }
@@ -4941,7 +5036,7 @@ dissect_dcerpc_cn_fault(tvbuff_t *tvb, gint offset, packet_info *pinfo,
     if (!conv) {
         /* no point in creating one here, really */
     } else {
-        dcerpc_matched_key matched_key, *new_matched_key;
+        dcerpc_matched_key matched_key;
 
         /* !!! we can NOT check visited here since this will interact
            badly with when SMB handles (i.e. calls the subdissector)
@@ -4955,19 +5050,20 @@ dissect_dcerpc_cn_fault(tvbuff_t *tvb, gint offset, packet_info *pinfo,
             dcerpc_cn_call_key call_key;
             dcerpc_call_value *call_value;
 
-            call_key.conv = conv;
+            call_key.conv_index = conv->conv_index;
             call_key.call_id = hdr->call_id;
             call_key.transport_salt = dcerpc_get_transport_salt(pinfo);
 
             if ((call_value = (dcerpc_call_value *)wmem_map_lookup(dcerpc_cn_calls, &call_key))) {
-                new_matched_key = wmem_new(wmem_file_scope(), dcerpc_matched_key);
-                *new_matched_key = matched_key;
-                wmem_map_insert(dcerpc_matched, new_matched_key, call_value);
+                dcerpc_add_matched(matched_key.frame, matched_key.call_id, call_value);
 
                 value = call_value;
                 if (call_value->rep_frame == 0) {
                     call_value->rep_frame = pinfo->num;
                 }
+                if ((hdr->flags&PFC_LAST_FRAG) && !pinfo->fd->visited) {
+                    dcerpc_cn_call_expire(&call_key, call_value);
+                }
 
             }
         }
@@ -6199,7 +6295,7 @@ dissect_dcerpc_dg_rqst(tvbuff_t *tvb, int offset, packet_info *pinfo,
 {
     dcerpc_info        *di;
     dcerpc_call_value  *value;
-    dcerpc_matched_key  matched_key, *new_matched_key;
+    dcerpc_matched_key  matched_key;
     proto_item         *pi;
     proto_item         *parent_pi;
 
@@ -6207,12 +6303,12 @@ dissect_dcerpc_dg_rqst(tvbuff_t *tvb, int offset, packet_info *pinfo,
         dcerpc_call_value *call_value;
         dcerpc_dg_call_key *call_key;
 
-        call_key = wmem_new(wmem_file_scope(), dcerpc_dg_call_key);
-        call_key->conv = conv;
+        call_key = dcerpc_pool_new(&dcerpc_dg_call_key_pool, dcerpc_dg_call_key);
+        call_key->conv_index = conv->conv_index;
         call_key->seqnum = hdr->seqnum;
         call_key->act_id = hdr->act_id;
 
-        call_value = wmem_new(wmem_file_scope(), dcerpc_call_value);
+        call_value = dcerpc_pool_new(&dcerpc_call_value_pool, dcerpc_call_value);
         call_value->uuid = hdr->if_id;
         call_value->ver = hdr->if_ver;
         call_value->object_uuid = hdr->obj_id;
@@ -6229,10 +6325,7 @@ dissect_dcerpc_dg_rqst(tvbuff_t *tvb, int offset, packet_info *pinfo,
 
         wmem_map_insert(dcerpc_dg_calls, call_key, call_value);
 
-        new_matched_key = wmem_new(wmem_file_scope(), dcerpc_matched_key);
-        new_matched_key->frame = pinfo->num;
-        new_matched_key->call_id = hdr->seqnum;
-        wmem_map_insert(dcerpc_matched, new_matched_key, call_value);
+        dcerpc_add_matched(pinfo->num, hdr->seqnum, call_value);
     }
 
     matched_key.frame = pinfo->num;
@@ -6278,7 +6371,7 @@ dissect_dcerpc_dg_resp(tvbuff_t *tvb, int offset, packet_info *pinfo,
 {
     dcerpc_info        *di;
     dcerpc_call_value  *value;
-    dcerpc_matched_key  matched_key, *new_matched_key;
+    dcerpc_matched_key  matched_key;
     proto_item         *pi;
     proto_item         *parent_pi;
 
@@ -6286,15 +6379,12 @@ dissect_dcerpc_dg_resp(tvbuff_t *tvb, int offset, packet_info *pinfo,
         dcerpc_call_value *call_value;
         dcerpc_dg_call_key call_key;
 
-        call_key.conv = conv;
+        call_key.conv_index = conv->conv_index;
         call_key.seqnum = hdr->seqnum;
         call_key.act_id = hdr->act_id;
 
         if ((call_value = (dcerpc_call_value *)wmem_map_lookup(dcerpc_dg_calls, &call_key))) {
-            new_matched_key = wmem_new(wmem_file_scope(), dcerpc_matched_key);
-            new_matched_key->frame = pinfo->num;
-            new_matched_key->call_id = hdr->seqnum;
-            wmem_map_insert(dcerpc_matched, new_matched_key, call_value);
+            dcerpc_add_matched(pinfo->num, hdr->seqnum, call_value);
             if (call_value->rep_frame == 0) {
                 call_value->rep_frame = pinfo->num;
             }
@@ -6348,7 +6438,7 @@ dissect_dcerpc_dg_ping_ack(tvbuff_t *tvb, int offset, packet_info *pinfo,
     dcerpc_call_value  *call_value;
     dcerpc_dg_call_key  call_key;
 
-    call_key.conv = conv;
+    call_key.conv_index = conv->conv_index;
     call_key.seqnum = hdr->seqnum;
     call_key.act_id = hdr->act_id;
 
@@ -7181,6 +7271,7 @@ proto_register_dcerpc(void)
     dcerpc_matched = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), dcerpc_matched_hash, dcerpc_matched_equal);
 
     register_init_routine(decode_dcerpc_inject_bindings);
+    register_cleanup_routine(dcerpc_call_pools_cleanup);
 
     dcerpc_module = prefs_register_protocol(proto_dcerpc, NULL);
     prefs_register_bool_preference(dcerpc_module,
@@ -139,8 +139,11 @@ struct _diam_avp_t {
 #define VND_AVP_VS_LEN(v)  (wmem_array_get_count((v)->vs_avps))
 #define VND_CMD_VS(v)      ((value_string *)(void *)(wmem_array_get_raw((v)->vs_cmds)))
 
+/* Key of diam_dictionary_t.avps */
+#define DIAM_AVP_KEY(vendorid, code) (((guint64)(vendorid) << 32) | (code))
+
 typedef struct _diam_dictionary_t {
-	wmem_tree_t *avps;
+	wmem_map_t *avps; /* diam_avp_t by DIAM_AVP_KEY() */
 	wmem_tree_t *vnds;
 	value_string_ext *applications;
 	value_string *commands;
@@ -791,7 +794,7 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	guint32 flags_bits_idx = (len & 0xE0000000) >> 29;
 	guint32 flags_bits     = (len & 0xFF000000) >> 24;
 	guint32 vendorid       = vendor_flag ? tvb_get_ntohl(tvb,offset+8) : 0 ;
-	wmem_tree_key_t k[3];
+	guint64 avp_key        = DIAM_AVP_KEY(vendorid, code);
 	diam_avp_t *a;
 	proto_item *pi, *avp_item;
 	proto_tree *avp_tree, *save_tree;
@@ -801,16 +804,7 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	const char *avp_str = NULL;
 	guint8 pad_len;
 
-	k[0].length = 1;
-	k[0].key = &code;
-
-	k[1].length = 1;
-	k[1].key = &vendorid;
-
-	k[2].length = 0;
-	k[2].key = NULL;
-
-	a = (diam_avp_t *)wmem_tree_lookup32_array(dictionary.avps,k);
+	a = (diam_avp_t *)wmem_map_lookup(dictionary.avps,&avp_key);
 
 	len &= 0x00ffffff;
 	pad_len =  (len % 4) ? 4 - (len % 4) : 0 ;
@@ -2092,7 +2086,7 @@ dictionary_load(void)
 	build_dict.avps = g_hash_table_new(strcase_hash,strcase_equal);
 
 	dictionary.vnds = wmem_tree_new(wmem_epan_scope());
-	dictionary.avps = wmem_tree_new(wmem_epan_scope());
+	dictionary.avps = wmem_map_new(wmem_epan_scope(), wmem_int64_hash, g_int64_equal);
 
 	unknown_vendor.vs_cmds = wmem_array_new(wmem_epan_scope(), sizeof(value_string));
 	wmem_array_set_null_terminator(unknown_vendor.vs_cmds);
@@ -2311,16 +2305,10 @@ dictionary_load(void)
 			g_hash_table_insert(build_dict.avps, a->name, avp);
 
 			{
-				wmem_tree_key_t k[3];
-
-				k[0].length = 1;
-				k[0].key	= &(a->code);
-				k[1].length = 1;
-				k[1].key	= &(vnd->code);
-				k[2].length = 0;
-				k[2].key	= NULL;
+				guint64 *avp_key = wmem_new(wmem_epan_scope(), guint64);
 
-				wmem_tree_insert32_array(dictionary.avps,k,avp);
+				*avp_key = DIAM_AVP_KEY(vnd->code, a->code);
+				wmem_map_insert(dictionary.avps,avp_key,avp);
 			}
 		}
 	}
@@ -2575,7 +2563,7 @@ proto_register_diameter(void)
 	register_dissector("diameter_avps", dissect_diameter_avps, proto_diameter);
 
 	/* Delay registration of Diameter fields */
-	proto_register_prefix("diameter", register_diameter_fields);
+	proto_register_protocol_prefix(proto_diameter, register_diameter_fields);
 
 	/* Register dissector table(s) to do sub dissection of AVPs (OctetStrings) */
 	diameter_dissector_table = register_dissector_table("diameter.base", "Diameter Base AVP", proto_diameter, FT_UINT32, BASE_DEC);
@@ -1399,18 +1399,19 @@ expand_dns_name(tvbuff_t *tvb, int offset, int max_len, int dns_data_offset,
         else {
           maxname--;
         }
-        while (component_len > 0) {
-          if (max_len && offset - start_offset > max_len - 1) {
-            THROW(ReportedBoundsError);
-          }
-          if (maxname > 0) {
-            *np++ = tvb_get_guint8(tvb, offset);
-            (*name_len)++;
-            maxname--;
-          }
-          component_len--;
-          offset++;
+        /* Copy the whole label at once rather than byte by byte; only the
+           part that still fits in the name buffer is fetched. */
+        if (max_len && offset + component_len - 1 - start_offset > max_len - 1) {
+          THROW(ReportedBoundsError);
+        }
+        if (maxname > 0) {
+          int copy_len = MIN(component_len, maxname);
+          tvb_memcpy(tvb, np, offset, copy_len);
+          np += copy_len;
+          *name_len += copy_len;
+          maxname -= copy_len;
         }
+        offset += component_len;
         break;
 
       case 0x40:
@@ -4069,6 +4070,15 @@ dissect_dso_data(tvbuff_t *tvb, int offset, packet_info *pinfo _U_, proto_tree *
   return offset - start_offset;
 }
 
+static void
+dns_conversation_expire(conversation_t *conv _U_, void *proto_data)
+{
+  dns_conv_info_t *dns_info = (dns_conv_info_t *)proto_data;
+
+  wmem_tree_destroy(dns_info->pdus, FALSE, TRUE);
+  wmem_free(wmem_file_scope(), dns_info);
+}
+
 static void
 dissect_dns_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     enum DnsTransport transport, gboolean is_mdns, gboolean is_llmnr)
@@ -6392,6 +6402,8 @@ proto_register_dns(void)
   expert_dns = expert_register_protocol(proto_dns);
   expert_register_field_array(expert_dns, ei, array_length(ei));
 
+  conversation_register_expire_func(proto_dns, dns_conversation_expire);
+
   dns_module = prefs_register_protocol(proto_dns, NULL);
 
   prefs_register_bool_preference(dns_module, "desegment_dns_messages",
@@ -26,6 +26,7 @@
 #include <epan/sequence_analysis.h>
 #include <wiretap/wtap.h>
 #include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
 #include <epan/expert.h>
 #include <wsutil/wsgcrypt.h>
 #include <wsutil/str_util.h>
@@ -627,6 +628,8 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 			proto_tree_add_int(fh_tree, hf_frame_wtap_encap, tvb, 0, 0, pinfo->rec->rec_header.packet_header.pkt_encap);
 
 		if (pinfo->presence_flags & PINFO_HAS_TS) {
+			nstime_t shift_offset;
+
 			proto_tree_add_time(fh_tree, hf_frame_arrival_time, tvb,
 					    0, 0, &(pinfo->abs_ts));
 			if (pinfo->abs_ts.nsecs < 0 || pinfo->abs_ts.nsecs >= 1000000000) {
@@ -635,8 +638,9 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 								  " the valid range is 0-1000000000",
 								  (long) pinfo->abs_ts.nsecs);
 			}
+			frame_data_get_shift_offset(pinfo->fd, &shift_offset);
 			item = proto_tree_add_time(fh_tree, hf_frame_shift_offset, tvb,
-					    0, 0, &(pinfo->fd->shift_offset));
+					    0, 0, &shift_offset);
 			proto_item_set_generated(item);
 
 			if (generate_epoch_time) {
@@ -738,6 +742,12 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 		return tvb_captured_length(tvb);
 	}
 
+	if (pinfo->flags.frame_only) {
+		/* Only the frame metadata was asked for, stop handling here */
+		tap_queue_packet(frame_tap, pinfo, NULL);
+		return tvb_captured_length(tvb);
+	}
+
 	/* Portable Exception Handling to trap Wireshark specific exceptions like BoundsError exceptions */
 	TRY {
 #ifdef _MSC_VER
@@ -991,9 +1001,127 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 	return tvb_captured_length(tvb);
 }
 
+/* Dissector profiling statistics, see dissector_profiling_enable() */
+typedef enum
+{
+	PROF_DISSECTOR_COLUMN = 0,
+	PROF_TYPE_COLUMN,
+	PROF_CALLS_COLUMN,
+	PROF_INCLUSIVE_COLUMN,
+	PROF_EXCLUSIVE_COLUMN,
+	PROF_PER_CALL_COLUMN
+} prof_stat_columns;
+
+static stat_tap_table_item prof_stat_fields[] = {
+	{TABLE_ITEM_STRING, TAP_ALIGN_LEFT, "Dissector", "%-24s"},
+	{TABLE_ITEM_STRING, TAP_ALIGN_LEFT, "Type", "%-10s"},
+	{TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Calls", "%u"},
+	{TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Inclusive (ms)", "%.3f"},
+	{TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Exclusive (ms)", "%.3f"},
+	{TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Exclusive (ns/call)", "%.0f"}
+};
+
+static void prof_stat_init(stat_tap_table_ui* new_stat)
+{
+	const char *table_name = "Dissector Profile";
+	int num_fields = sizeof(prof_stat_fields)/sizeof(stat_tap_table_item);
+	stat_tap_table *table;
+
+	table = stat_tap_find_table(new_stat, table_name);
+	if (table) {
+		if (new_stat->stat_tap_reset_table_cb) {
+			new_stat->stat_tap_reset_table_cb(table);
+		}
+		return;
+	}
+
+	table = stat_tap_init_table(table_name, num_fields, 0, NULL);
+	stat_tap_add_table(new_stat, table);
+
+	/* Rows are added as dissectors get called */
+	dissector_profiling_reset();
+	dissector_profiling_enable(TRUE);
+}
+
+static void
+prof_stat_fill_row(guint idx, const dissector_profile_t *profile, gpointer user_data)
+{
+	stat_tap_table *table = (stat_tap_table *)user_data;
+	stat_tap_table_item_type items[sizeof(prof_stat_fields)/sizeof(stat_tap_table_item)];
+
+	items[PROF_DISSECTOR_COLUMN].type = TABLE_ITEM_STRING;
+	items[PROF_DISSECTOR_COLUMN].value.string_value = profile->name;
+	items[PROF_TYPE_COLUMN].type = TABLE_ITEM_STRING;
+	items[PROF_TYPE_COLUMN].value.string_value = profile->heuristic ? "heuristic" : "dissector";
+	items[PROF_CALLS_COLUMN].type = TABLE_ITEM_UINT;
+	items[PROF_CALLS_COLUMN].value.uint_value = (guint)profile->calls;
+	items[PROF_INCLUSIVE_COLUMN].type = TABLE_ITEM_FLOAT;
+	items[PROF_INCLUSIVE_COLUMN].value.float_value = profile->inclusive_ns / 1000000.0;
+	items[PROF_EXCLUSIVE_COLUMN].type = TABLE_ITEM_FLOAT;
+	items[PROF_EXCLUSIVE_COLUMN].value.float_value = profile->exclusive_ns / 1000000.0;
+	items[PROF_PER_CALL_COLUMN].type = TABLE_ITEM_FLOAT;
+	items[PROF_PER_CALL_COLUMN].value.float_value =
+		profile->calls ? (double)profile->exclusive_ns / profile->calls : 0.0;
+
+	stat_tap_init_table_row(table, idx, table->num_fields, items);
+}
+
+static tap_packet_status
+prof_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *data _U_)
+{
+	stat_data_t* stat_data = (stat_data_t*)tapdata;
+	stat_tap_table* table;
+
+	/* The profile is kept by packet.c; copy it into the table */
+	table = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table*, 0);
+	dissector_profiling_foreach(prof_stat_fill_row, table);
+
+	return TAP_PACKET_REDRAW;
+}
+
+static void
+prof_stat_reset(stat_tap_table* table)
+{
+	guint element;
+	stat_tap_table_item_type* item_data;
+
+	dissector_profiling_reset();
+	for (element = 0; element < table->num_elements; element++)
+	{
+		item_data = stat_tap_get_field_data(table, element, PROF_CALLS_COLUMN);
+		item_data->value.uint_value = 0;
+		item_data = stat_tap_get_field_data(table, element, PROF_INCLUSIVE_COLUMN);
+		item_data->value.float_value = 0.0;
+		item_data = stat_tap_get_field_data(table, element, PROF_EXCLUSIVE_COLUMN);
+		item_data->value.float_value = 0.0;
+		item_data = stat_tap_get_field_data(table, element, PROF_PER_CALL_COLUMN);
+		item_data->value.float_value = 0.0;
+	}
+}
+
 void
 proto_register_frame(void)
 {
+	static tap_param prof_stat_params[] = {
+		{ PARAM_FILTER, "filter", "Filter", NULL, TRUE }
+	};
+
+	static stat_tap_table_ui prof_stat_table = {
+		REGISTER_STAT_GROUP_GENERIC,
+		"Dissector Profile",
+		"frame",
+		"prof,dissectors",
+		prof_stat_init,
+		prof_stat_packet,
+		prof_stat_reset,
+		NULL,
+		NULL,
+		sizeof(prof_stat_fields)/sizeof(stat_tap_table_item), prof_stat_fields,
+		sizeof(prof_stat_params)/sizeof(tap_param), prof_stat_params,
+		NULL,
+		0
+	};
+
 	static hf_register_info hf[] = {
 		{ &hf_frame_arrival_time,
 		  { "Arrival Time", "frame.time",
@@ -1303,6 +1431,8 @@ proto_register_frame(void)
 	    &disable_packet_size_limited_in_summary);
 
 	frame_tap=register_tap("frame");
+
+	register_stat_tap_table_ui(&prof_stat_table);
 }
 
 void
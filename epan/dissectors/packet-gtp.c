@@ -2411,79 +2411,100 @@ GHashTable* session_table;
 /* Relation between <teid,ip> -> frame */
 wmem_tree_t* frame_tree;
 
-typedef struct {
+/*
+ * frame_tree maps an IP address (as a string) to a map of TEID -> chain of
+ * gtp_info_t, newest first. The chain keeps older <teid,frame> pairs so that
+ * removing the newest one exposes the previous one, as the per-IP lists did.
+ * Two reverse indexes make removals cheap:
+ *  - frame -> list of the gtp_info_t created by that frame, so that
+ *    remove_frame_info() does not have to walk every IP and TEID, and
+ *  - session -> list of frames, so that fill_map() does not have to walk the
+ *    whole session_table to find the frames of a session.
+ */
+static wmem_map_t* frame_info_map;
+static wmem_map_t* session_frames_map;
+
+typedef struct _gtp_info_t {
     guint32 teid;
     guint32 frame;
+    wmem_map_t *teid_map;       /* per-IP map that holds this entry */
+    struct _gtp_info_t *next;   /* older entry for the same <teid,ip> */
 } gtp_info_t;
 
 /* GTP Session funcs*/
 guint32
 get_frame(address ip, guint32 teid, guint32 *frame) {
-    gboolean found = FALSE;
-    wmem_list_frame_t *elem;
+    wmem_map_t *teid_map;
     gtp_info_t *info;
-    wmem_list_t *info_list;
     gchar *ip_str;
 
-    /* First we get the teid list*/
+    /* First we get the teid map*/
     ip_str = address_to_str(wmem_packet_scope(), &ip);
-    info_list = (wmem_list_t*)wmem_tree_lookup_string(frame_tree, ip_str, 0);
-    if (info_list != NULL) {
-        elem = wmem_list_head(info_list);
-        while (!found && elem) {
-            info = (gtp_info_t*)wmem_list_frame_data(elem);
-            if (teid == info->teid) {
-                *frame = info->frame;
-                return 1;
-            }
-            elem = wmem_list_frame_next(elem);
+    teid_map = (wmem_map_t*)wmem_tree_lookup_string(frame_tree, ip_str, 0);
+    if (teid_map != NULL) {
+        info = (gtp_info_t*)wmem_map_lookup(teid_map, GUINT_TO_POINTER(teid));
+        if (info) {
+            *frame = info->frame;
+            return 1;
         }
     }
     return 0;
 }
 
-static gboolean
-call_foreach_ip(const void *key _U_, void *value, void *data){
-    wmem_list_frame_t * elem;
-    wmem_list_t *info_list = (wmem_list_t *)value;
-    gtp_info_t *info;
-    guint32* frame = (guint32*)data;
-
-    /* We loop over the <teid, frame> list */
-    elem = wmem_list_head(info_list);
-    while (elem) {
-        info = (gtp_info_t*)wmem_list_frame_data(elem);
-        if (info->frame == *frame) {
-            wmem_list_frame_t * del = elem;
-            /* proceed to next request */
-            elem = wmem_list_frame_next(elem);
-            /* If we find the frame we remove its information from the list */
-            wmem_list_remove_frame(info_list, del);
-            wmem_free(wmem_file_scope(), info);
-        }
-        else {
-            elem = wmem_list_frame_next(elem);
+static void
+unlink_gtp_info(gtp_info_t *info)
+{
+    gtp_info_t *head, **link;
+
+    head = (gtp_info_t*)wmem_map_lookup(info->teid_map, GUINT_TO_POINTER(info->teid));
+    for (link = &head; *link; link = &(*link)->next) {
+        if (*link == info) {
+            *link = info->next;
+            break;
         }
     }
-
-    return FALSE;
+    if (head) {
+        wmem_map_insert(info->teid_map, GUINT_TO_POINTER(info->teid), head);
+    } else {
+        wmem_map_remove(info->teid_map, GUINT_TO_POINTER(info->teid));
+    }
 }
 
 void
 remove_frame_info(guint32 *f) {
-    /* For each ip node */
-    wmem_tree_foreach(frame_tree, call_foreach_ip, (void *)f);
+    wmem_list_t *infos;
+    wmem_list_frame_t *elem;
+
+    /* Remove every <teid,frame> pair this frame added, on any ip */
+    infos = (wmem_list_t*)wmem_map_remove(frame_info_map, GUINT_TO_POINTER(*f));
+    if (infos == NULL) {
+        return;
+    }
+    for (elem = wmem_list_head(infos); elem; elem = wmem_list_frame_next(elem)) {
+        gtp_info_t *info = (gtp_info_t*)wmem_list_frame_data(elem);
+        unlink_gtp_info(info);
+        wmem_free(wmem_file_scope(), info);
+    }
+    wmem_destroy_list(infos);
 }
 
 void
 add_gtp_session(guint32 frame, guint32 session) {
     guint32 *f, *session_count;
+    wmem_list_t *frames;
 
     f = wmem_new0(wmem_file_scope(), guint32);
     session_count = wmem_new0(wmem_file_scope(), guint32);
     *f = frame;
     *session_count = session;
     g_hash_table_insert(session_table, f, session_count);
+
+    frames = (wmem_list_t*)wmem_map_lookup(session_frames_map, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        frames = wmem_list_new(wmem_file_scope());
+        wmem_map_insert(session_frames_map, GUINT_TO_POINTER(session), frames);
+    }
+    wmem_list_prepend(frames, GUINT_TO_POINTER(frame));
 }
 
 gboolean
@@ -2516,67 +2537,75 @@ ip_exists(address ip, wmem_list_t *ip_list) {
     return found;
 }
 
-static gboolean
-info_exists(gtp_info_t *wanted, wmem_list_t *info_list) {
+/* Remove the <teid,frame> information of every frame in a session */
+static void
+remove_session_info(guint32 session)
+{
+    wmem_list_t *frames;
     wmem_list_frame_t *elem;
-    gtp_info_t *info;
-    gboolean found;
-    found = FALSE;
-    elem = wmem_list_head(info_list);
-    while (!found && elem) {
-        info = (gtp_info_t*)wmem_list_frame_data(elem);
-        found = wanted->teid == info->teid;
-        elem = wmem_list_frame_next(elem);
+
+    frames = (wmem_list_t*)wmem_map_lookup(session_frames_map, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        return;
+    }
+    for (elem = wmem_list_head(frames); elem; elem = wmem_list_frame_next(elem)) {
+        guint32 fr = GPOINTER_TO_UINT(wmem_list_frame_data(elem));
+        guint32 *session_count = (guint32 *)g_hash_table_lookup(session_table, &fr);
+
+        /* Skip frames that were moved to another session since */
+        if (session_count && *session_count == session) {
+            remove_frame_info(&fr);
+        }
     }
-    return found;
 }
 
 void
 fill_map(wmem_list_t *teid_list, wmem_list_t *ip_list, guint32 frame) {
     wmem_list_frame_t *elem_ip, *elem_teid;
     gtp_info_t *gtp_info;
-    wmem_list_t * info_list; /* List of <teids,frames>*/
-    guint32 *f, *session, *fr, *session_count;
-    GHashTableIter iter;
+    wmem_map_t *teid_map; /* Map of teid -> <teid,frame> chain */
+    wmem_list_t *infos;
+    guint32 *session;
     guint32 teid;
     gchar *ip;
 
     elem_ip = wmem_list_head(ip_list);
     while (elem_ip) {
-        ip = address_to_str(wmem_file_scope(), (address*)wmem_list_frame_data(elem_ip));
-        /* We check if a teid list exists for this ip */
-        info_list = (wmem_list_t*)wmem_tree_lookup_string(frame_tree, ip, 0);
-        if (info_list == NULL) {
-            info_list = wmem_list_new(wmem_file_scope());
+        ip = address_to_str(wmem_packet_scope(), (address*)wmem_list_frame_data(elem_ip));
+        /* We check if a teid map exists for this ip */
+        teid_map = (wmem_map_t*)wmem_tree_lookup_string(frame_tree, ip, 0);
+        if (teid_map == NULL) {
+            teid_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+            wmem_tree_insert_string(frame_tree, ip, teid_map, 0);
         }
         /* We loop over the teid list */
         elem_teid = wmem_list_head(teid_list);
         while (elem_teid) {
             teid = *(guint32*)wmem_list_frame_data(elem_teid);
-            f = wmem_new0(wmem_file_scope(), guint32);
-            *f = frame;
-            gtp_info = wmem_new0(wmem_file_scope(), gtp_info_t);
-            gtp_info->teid = teid;
-            gtp_info->frame = *f;
-            if (info_exists(gtp_info, info_list)) {
+            if (wmem_map_contains(teid_map, GUINT_TO_POINTER(teid))) {
                 /* If the teid and ip already existed, that means that we need to remove old info about that session */
                 /* We look for its session ID */
-                session = (guint32 *)g_hash_table_lookup(session_table, f);
+                session = (guint32 *)g_hash_table_lookup(session_table, &frame);
                 if (session) {
-                    g_hash_table_iter_init(&iter, session_table);
-                    while (g_hash_table_iter_next(&iter, (gpointer*)&fr, (gpointer*)&session_count)) {
-                        /* If the msg has the same session ID and it's not the upd req we have to remove its info */
-                        if (*session_count == *session) {
-                            /* If it's the session we are looking for, we remove all the frame information */
-                            remove_frame_info(fr);
-                        }
-                    }
+                    /* If it's the session we are looking for, we remove all the frame information */
+                    remove_session_info(*session);
                 }
             }
-            wmem_list_prepend(info_list, gtp_info);
+            gtp_info = wmem_new0(wmem_file_scope(), gtp_info_t);
+            gtp_info->teid = teid;
+            gtp_info->frame = frame;
+            gtp_info->teid_map = teid_map;
+            gtp_info->next = (gtp_info_t*)wmem_map_lookup(teid_map, GUINT_TO_POINTER(teid));
+            wmem_map_insert(teid_map, GUINT_TO_POINTER(teid), gtp_info);
+
+            infos = (wmem_list_t*)wmem_map_lookup(frame_info_map, GUINT_TO_POINTER(frame));
+            if (infos == NULL) {
+                infos = wmem_list_new(wmem_file_scope());
+                wmem_map_insert(frame_info_map, GUINT_TO_POINTER(frame), infos);
+            }
+            wmem_list_prepend(infos, gtp_info);
             elem_teid = wmem_list_frame_next(elem_teid);
         }
-        wmem_tree_insert_string(frame_tree, ip, info_list, 0);
         elem_ip = wmem_list_frame_next(elem_ip);
     }
 }
@@ -10180,6 +10209,8 @@ gtp_init(void)
     gtp_session_count = 1;
     session_table = g_hash_table_new(g_int_hash, g_int_equal);
     frame_tree = wmem_tree_new(wmem_file_scope());
+    frame_info_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    session_frames_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
 }
 
 static void
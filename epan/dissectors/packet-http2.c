@@ -1151,9 +1151,9 @@ get_stream_info(http2_session_t *http2_session)
 
     http2_stream_info_t *stream_info = (http2_stream_info_t *)wmem_map_lookup(stream_map, GINT_TO_POINTER(stream_id));
     if (stream_info == NULL) {
+        /* stream_header_list is created on the first header block in
+           each direction; many streams never carry headers one way. */
         stream_info = wmem_new0(wmem_file_scope(), http2_stream_info_t);
-        stream_info->oneway_stream_info[0].header_stream_info.stream_header_list = wmem_list_new(wmem_file_scope());
-        stream_info->oneway_stream_info[1].header_stream_info.stream_header_list = wmem_list_new(wmem_file_scope());
         stream_info->stream_id = stream_id;
         stream_info->reassembly_mode = HTTP2_DATA_REASSEMBLY_MODE_END_STREAM;
         wmem_map_insert(stream_map, GINT_TO_POINTER(stream_id), stream_info);
@@ -1460,15 +1460,13 @@ process_http2_header_repr_info(wmem_array_t *headers,
 
         if(header_repr_info->complete) {
             if(header_repr_info->type == HTTP2_HD_HEADER_TABLE_SIZE_UPDATE) {
-                http2_header_t *out;
+                http2_header_t out;
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                out.type = header_repr_info->type;
+                out.length = i - start;
+                out.table.header_table_size = header_repr_info->integer;
 
-                out->type = header_repr_info->type;
-                out->length = i - start;
-                out->table.header_table_size = header_repr_info->integer;
-
-                wmem_array_append(headers, out, 1);
+                wmem_array_append(headers, &out, 1);
 
                 reset_http2_header_repr_info(header_repr_info);
                 /* continue to decode header table size update or
@@ -1836,7 +1834,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                 char *cached_pstr;
                 guint32 len;
                 guint datalen = (guint)(4 + nv.namelen + 4 + nv.valuelen);
-                http2_header_t *out;
+                http2_header_t out;
 
                 if (decompressed_bytes + datalen >= MAX_HTTP2_HEADER_SIZE) {
                     header_data->header_size_reached = decompressed_bytes;
@@ -1844,13 +1842,14 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                     break;
                 }
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
-
-                out->type = header_repr_info->type;
-                out->length = rv;
-                out->table.data.idx = header_repr_info->integer;
+                /* The headers array stores a copy, so build the entry on
+                   the stack rather than leaking a file scoped one per
+                   header line. */
+                out.type = header_repr_info->type;
+                out.length = rv;
+                out.table.data.idx = header_repr_info->integer;
 
-                out->table.data.datalen = datalen;
+                out.table.data.datalen = datalen;
                 decompressed_bytes += datalen;
 
                 /* Prepare buffer... with the following format
@@ -1859,7 +1858,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                    value length (uint32)
                    value (string)
                 */
-                http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, out->table.data.datalen);
+                http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, out.table.data.datalen);
 
                 /* nv.namelen and nv.valuelen are of size_t.  In order
                    to get length in 4 bytes, we have to copy it to
@@ -1874,14 +1873,14 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
 
                 cached_pstr = (char *)wmem_map_lookup(http2_hdrcache_map, http2_header_pstr);
                 if (cached_pstr) {
-                    out->table.data.data = cached_pstr;
+                    out.table.data.data = cached_pstr;
                 } else {
                     wmem_map_insert(http2_hdrcache_map, http2_header_pstr, http2_header_pstr);
-                    out->table.data.data = http2_header_pstr;
+                    out.table.data.data = http2_header_pstr;
                     http2_header_pstr = NULL;
                 }
 
-                wmem_array_append(headers, out, 1);
+                wmem_array_append(headers, &out, 1);
 
                 reset_http2_header_repr_info(header_repr_info);
             }
@@ -1904,6 +1903,9 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
         /* add this packet headers to stream header list */
         header_stream_info = get_header_stream_info(pinfo, h2session, FALSE);
         if (header_stream_info) {
+            if (!header_stream_info->stream_header_list) {
+                header_stream_info->stream_header_list = wmem_list_new(wmem_file_scope());
+            }
             wmem_list_append(header_stream_info->stream_header_list, headers);
         }
 
@@ -2858,7 +2860,7 @@ http2_get_header_value(packet_info *pinfo, const gchar* name, gboolean the_other
 
     conversation_t* conversation = find_or_create_conversation(pinfo);
     header_stream_info = get_header_stream_info(pinfo, get_http2_session(pinfo, conversation), the_other_direction);
-    if (!header_stream_info) {
+    if (!header_stream_info || !header_stream_info->stream_header_list) {
         return NULL;
     }
 
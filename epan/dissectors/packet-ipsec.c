@@ -199,6 +199,8 @@ typedef struct {
   gchar *authentication_key_string;
   gchar *authentication_key;
   gint authentication_key_length;
+
+  guint32 spi_key;                /* spi as a number, if it has no wildcards */
 } uat_esp_sa_record_t;
 
 static uat_esp_sa_record_t *uat_esp_sa_records = NULL;
@@ -213,6 +215,7 @@ typedef struct extra_esp_sa_records_t {
 static extra_esp_sa_records_t extra_esp_sa_records;
 
 static uat_t * esp_uat = NULL;
+static uat_index_t * esp_sa_index = NULL;   /* UAT records by SPI */
 static guint num_sa_uat = 0;
 
 /*
@@ -352,6 +355,7 @@ static gboolean uat_esp_sa_record_update_cb(void* r, char** err) {
      is not sufficient */
 
   /* TODO: check format of spi */
+  rec->spi_key = rec->spi ? (guint32)strtoul(rec->spi, NULL, 0) : 0;
 
   /* Return TRUE only if *err has not been set by checking code. */
   return *err == NULL;
@@ -1037,6 +1041,46 @@ filter_spi_match(guint spi, gchar *filter)
                                       *cipher_hd and set this to TRUE.
 
 */
+typedef struct {
+  gint protocol_typ;
+  gchar *src;
+  gchar *dst;
+  guint spi;
+} esp_sa_match_t;
+
+/* The SPI an SA record is indexed by, or NULL if it has wildcards. */
+static gconstpointer
+esp_sa_record_spi_key(const void *r)
+{
+  const uat_esp_sa_record_t *record = (const uat_esp_sa_record_t *)r;
+  unsigned long spi;
+
+  if (!record->spi || strchr(record->spi, IPSEC_SA_WILDCARDS_ANY) != NULL)
+    return NULL;
+  /* Too big to match anything as a number; leave it to filter_spi_match() */
+  spi = strtoul(record->spi, NULL, 0);
+  if (spi != (guint32)spi)
+    return NULL;
+  return &record->spi_key;
+}
+
+/* Whether an SA record applies to a packet and has usable keys. */
+static gboolean
+esp_sa_record_match(const void *r, void *user_data)
+{
+  const uat_esp_sa_record_t *record = (const uat_esp_sa_record_t *)r;
+  const esp_sa_match_t *match = (const esp_sa_match_t *)user_data;
+
+  /* Bad keys; XXX - report this */
+  if (record->authentication_key_length == -1 || record->encryption_key_length == -1)
+    return FALSE;
+
+  return (match->protocol_typ == record->protocol)
+      && filter_address_match(match->src, record->srcIP, match->protocol_typ)
+      && filter_address_match(match->dst, record->dstIP, match->protocol_typ)
+      && filter_spi_match(match->spi, record->spi);
+}
+
 static gboolean
 get_esp_sa(gint protocol_typ, gchar *src,  gchar *dst,  guint spi,
            gint *encryption_algo,
@@ -1049,66 +1093,44 @@ get_esp_sa(gint protocol_typ, gchar *src,  gchar *dst,  guint spi,
            gboolean **cipher_hd_created
   )
 {
-  gboolean found = FALSE;
-  guint i, j;
+  esp_sa_match_t match = { protocol_typ, src, dst, spi };
+  uat_esp_sa_record_t *record = NULL;
+  guint j;
 
   *cipher_hd = NULL;
   *cipher_hd_created = NULL;
 
-  /* Check each known SA in turn */
-  for (i = 0, j=0; (found == FALSE) && ((i < num_sa_uat) || (j < extra_esp_sa_records.num_records)); )
+  /* Extra ones checked first */
+  for (j = 0; record == NULL && j < extra_esp_sa_records.num_records; j++)
   {
-    /* Get the next record to try */
-    uat_esp_sa_record_t *record;
-    if (j < extra_esp_sa_records.num_records) {
-      /* Extra ones checked first */
-      record = &extra_esp_sa_records.records[j++];
-    }
-    else {
-      /* Then UAT ones */
-      record = &uat_esp_sa_records[i++];
-    }
+    if (esp_sa_record_match(&extra_esp_sa_records.records[j], &match))
+      record = &extra_esp_sa_records.records[j];
+  }
 
-    if((protocol_typ == record->protocol)
-       && filter_address_match(src, record->srcIP, protocol_typ)
-       && filter_address_match(dst, record->dstIP, protocol_typ)
-       && filter_spi_match(spi, record->spi))
-    {
-      found = TRUE;
+  /* Then UAT ones, of which there may be many, so only those that have
+     this SPI or wildcards */
+  if (record == NULL && num_sa_uat > 0)
+  {
+    record = (uat_esp_sa_record_t *)uat_index_lookup(esp_sa_index, &spi, esp_sa_record_match, &match);
+  }
 
-      *encryption_algo = record->encryption_algo;
-      *authentication_algo = record->authentication_algo;
-      *authentication_key = record->authentication_key;
-      if (record->authentication_key_length == -1)
-      {
-        /* Bad key; XXX - report this */
-        *authentication_key_len = 0;
-        found = FALSE;
-      }
-      else {
-        *authentication_key_len = record->authentication_key_length;
-      }
+  if (record == NULL)
+    return FALSE;
 
-      *encryption_key = record->encryption_key;
-      if (record->encryption_key_length == -1)
-      {
-        /* Bad key; XXX - report this */
-        *encryption_key_len = 0;
-        found = FALSE;
-      }
-      else {
-        *encryption_key_len = record->encryption_key_length;
-      }
+  *encryption_algo = record->encryption_algo;
+  *authentication_algo = record->authentication_algo;
+  *authentication_key = record->authentication_key;
+  *authentication_key_len = record->authentication_key_length;
+  *encryption_key = record->encryption_key;
+  *encryption_key_len = record->encryption_key_length;
 
-      /* Tell the caller whether cipher_hd has been created yet and a pointer.
-         Pass pointer to created flag so that caller can set if/when
-         it opens the cipher_hd. */
-      *cipher_hd = &record->cipher_hd;
-      *cipher_hd_created = &record->cipher_hd_created;
-    }
-  }
+  /* Tell the caller whether cipher_hd has been created yet and a pointer.
+     Pass pointer to created flag so that caller can set if/when
+     it opens the cipher_hd. */
+  *cipher_hd = &record->cipher_hd;
+  *cipher_hd_created = &record->cipher_hd_created;
 
-  return found;
+  return TRUE;
 }
 
 static void ah_prompt(packet_info *pinfo, gchar *result)
@@ -2465,6 +2487,7 @@ proto_register_ipsec(void)
             NULL,                           /* post update callback */
             NULL,                           /* reset callback */
             esp_uat_flds);                  /* UAT field definitions */
+  esp_sa_index = uat_index_new(esp_uat, esp_sa_record_spi_key, g_int_hash, g_int_equal);
 
   prefs_register_uat_preference(esp_module,
                                 "sa_table",
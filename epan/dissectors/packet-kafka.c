@@ -19,6 +19,7 @@
 #include <epan/expert.h>
 #include <epan/prefs.h>
 #include <epan/proto_data.h>
+#include <epan/crc32-tvb.h>
 #ifdef HAVE_SNAPPY
 #include <snappy-c.h>
 #endif
@@ -705,6 +706,31 @@ static const value_string election_types[] = {
  * by default */
 static gboolean kafka_show_string_bytes_lengths = FALSE;
 
+/*
+ * Decompressed record batches, so that a batch is only decompressed once
+ * rather than on every pass and every redissection.  Entries are keyed by
+ * the frame and the position of the batch in the tvb, and carry a CRC of
+ * the compressed data in case two PDUs in one frame start at the same tvb
+ * offset.  Batches are no longer cached once the budget is used up.
+ */
+#define KAFKA_DECOMPRESSION_CACHE_MAX_BYTES (64 * 1024 * 1024)
+
+typedef struct {
+    guint32 frame;
+    int     offset;
+    guint32 length;
+    guint32 crc;
+    int     codec;
+} kafka_decompressed_key_t;
+
+typedef struct {
+    guint8  *data;
+    guint32  length;
+} kafka_decompressed_t;
+
+static wmem_map_t *kafka_decompressed_batches = NULL;
+static guint32     kafka_decompressed_bytes = 0;
+
 typedef struct _kafka_query_response_t {
     kafka_api_key_t     api_key;
     kafka_api_version_t api_version;
@@ -1864,16 +1890,31 @@ decompress_zstd(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, guint32 l
 }
 #endif /* HAVE_ZSTD */
 
+static guint
+kafka_decompressed_key_hash(gconstpointer k)
+{
+    const kafka_decompressed_key_t *key = (const kafka_decompressed_key_t *)k;
+
+    return key->frame ^ ((guint)key->offset << 16) ^ key->crc;
+}
+
+static gboolean
+kafka_decompressed_key_equal(gconstpointer k1, gconstpointer k2)
+{
+    const kafka_decompressed_key_t *key1 = (const kafka_decompressed_key_t *)k1;
+    const kafka_decompressed_key_t *key2 = (const kafka_decompressed_key_t *)k2;
+
+    return key1->frame == key2->frame && key1->offset == key2->offset &&
+           key1->length == key2->length && key1->crc == key2->crc &&
+           key1->codec == key2->codec;
+}
+
 // Max is currently 2^22 in
 // https://github.com/apache/kafka/blob/trunk/clients/src/main/java/org/apache/kafka/common/record/KafkaLZ4BlockOutputStream.java
 #define MAX_DECOMPRESSION_SIZE (1 << 22)
 static gboolean
-decompress(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, int codec, tvbuff_t **decompressed_tvb, int *decompressed_offset)
+decompress_codec(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, int codec, tvbuff_t **decompressed_tvb, int *decompressed_offset)
 {
-    if (length > MAX_DECOMPRESSION_SIZE) {
-        expert_add_info(pinfo, NULL, &ei_kafka_bad_decompression_length);
-        return FALSE;
-    }
     switch (codec) {
         case KAFKA_MESSAGE_CODEC_SNAPPY:
             return decompress_snappy(tvb, pinfo, offset, length, decompressed_tvb, decompressed_offset);
@@ -1891,6 +1932,50 @@ decompress(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, int co
     }
 }
 
+static gboolean
+decompress(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, int codec, tvbuff_t **decompressed_tvb, int *decompressed_offset)
+{
+    kafka_decompressed_key_t key, *new_key;
+    kafka_decompressed_t *batch;
+    guint32 batch_length;
+
+    if (length > MAX_DECOMPRESSION_SIZE) {
+        expert_add_info(pinfo, NULL, &ei_kafka_bad_decompression_length);
+        return FALSE;
+    }
+    if (codec == KAFKA_MESSAGE_CODEC_NONE || !tvb_bytes_exist(tvb, offset, length)) {
+        return decompress_codec(tvb, pinfo, offset, length, codec, decompressed_tvb, decompressed_offset);
+    }
+
+    key.frame = pinfo->num;
+    key.offset = offset;
+    key.length = length;
+    key.crc = crc32_ccitt_tvb_offset(tvb, offset, length);
+    key.codec = codec;
+    batch = (kafka_decompressed_t *)wmem_map_lookup(kafka_decompressed_batches, &key);
+    if (batch) {
+        *decompressed_tvb = tvb_new_child_real_data(tvb, batch->data, batch->length, batch->length);
+        *decompressed_offset = 0;
+        return TRUE;
+    }
+
+    if (!decompress_codec(tvb, pinfo, offset, length, codec, decompressed_tvb, decompressed_offset)) {
+        return FALSE;
+    }
+
+    batch_length = tvb_captured_length_remaining(*decompressed_tvb, *decompressed_offset);
+    if (batch_length <= KAFKA_DECOMPRESSION_CACHE_MAX_BYTES - kafka_decompressed_bytes) {
+        new_key = wmem_new(wmem_file_scope(), kafka_decompressed_key_t);
+        *new_key = key;
+        batch = wmem_new(wmem_file_scope(), kafka_decompressed_t);
+        batch->data = (guint8 *)tvb_memdup(wmem_file_scope(), *decompressed_tvb, *decompressed_offset, batch_length);
+        batch->length = batch_length;
+        wmem_map_insert(kafka_decompressed_batches, new_key, batch);
+        kafka_decompressed_bytes += batch_length;
+    }
+    return TRUE;
+}
+
 /*
  * Function: dissect_kafka_message_old
  * ---------------------------------------------------
@@ -10261,6 +10346,13 @@ proto_register_kafka_expert_module(const int proto) {
     expert_register_field_array(expert_kafka, ei, array_length(ei));
 }
 
+static void
+kafka_init(void)
+{
+    kafka_decompressed_batches = wmem_map_new(wmem_file_scope(), kafka_decompressed_key_hash, kafka_decompressed_key_equal);
+    kafka_decompressed_bytes = 0;
+}
+
 static void
 proto_register_kafka_preferences(const int proto)
 {
@@ -10292,6 +10384,8 @@ proto_register_kafka(void)
     proto_register_kafka_expert_module(protocol_handle);
     proto_register_kafka_preferences(protocol_handle);
 
+    register_init_routine(kafka_init);
+
     proto_kafka = protocol_handle;
 
 }
@@ -167,7 +167,7 @@ dissect_mount_dirpath_call(tvbuff_t *tvb, packet_info *pinfo,
 				ptr += len_field;
 				*ptr = 0;
 
-				nfs_name_snoop_add_name(civ->xid, tvb, -1, name_len, 0, 0, name);
+				nfs_name_snoop_add_name(pinfo, civ->xid, tvb, -1, name_len, 0, 0, name);
 			}
 		}
 	}
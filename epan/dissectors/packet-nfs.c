@@ -981,6 +981,7 @@ static dissector_table_t nfs_fhandle_table;
 typedef struct nfs_fhandle_data {
 	int len;
 	const unsigned char *fh;
+	guint hash;		/* nfs_fhandle_digest() of fh */
 } nfs_fhandle_data_t;
 
 /* For dissector helpers which take a "levels" argument to indicate how
@@ -1000,9 +1001,18 @@ static wmem_tree_t *nfs_fhandle_frame_table = NULL;
 /* file name snooping */
 gboolean nfs_file_name_snooping = FALSE;
 static gboolean nfs_file_name_full_snooping = FALSE;
+static guint nfs_name_snoop_timeout = 60;
+static guint nfs_name_snoop_max_names = 0;
+
+typedef struct nfs_name_snoop_key {
+	int key;
+	int fh_length;
+	const unsigned char *fh;
+	guint hash;		/* nfs_fhandle_digest() of fh */
+} nfs_name_snoop_key_t;
+
 typedef struct nfs_name_snoop {
-	int	       fh_length;
-	unsigned char *fh;
+	nfs_name_snoop_key_t fh_key;	/* fh is NULL until the reply is seen */
 	int	       name_len;
 	char	      *name;
 	int	       parent_len;
@@ -1010,20 +1020,21 @@ typedef struct nfs_name_snoop {
 	int	       full_name_len;
 	char	      *full_name;
 	bool	       fs_cycle;
+	time_t	       request_time;	/* to forget requests without a reply */
+	GList	       lru_link;	/* in nfs_name_snoop_lru, once matched */
 } nfs_name_snoop_t;
 
-typedef struct nfs_name_snoop_key {
-	int key;
-	int fh_length;
-	const unsigned char *fh;
-} nfs_name_snoop_key_t;
-
+/* Requests, by XID, waiting for the reply with their file handle */
 static GHashTable *nfs_name_snoop_unmatched = NULL;
+static time_t nfs_name_snoop_last_expiry;
 
+/* Names by file handle, least recently seen first in nfs_name_snoop_lru */
 static GHashTable *nfs_name_snoop_matched = NULL;
+static GQueue nfs_name_snoop_lru = G_QUEUE_INIT;
 
-static wmem_tree_t *nfs_name_snoop_known = NULL;
-static wmem_tree_t *nfs_file_handles = NULL;
+/* The matched names that have been shown, by file handle */
+static wmem_map_t *nfs_name_snoop_known = NULL;
+static wmem_map_t *nfs_file_handles = NULL;
 
 static gboolean nfs_display_v4_tag = TRUE;
 static gboolean display_major_nfs4_ops = TRUE;
@@ -1046,9 +1057,38 @@ static void nfs_prompt(packet_info *pinfo _U_, gchar* result)
 	g_snprintf(result, MAX_DECODE_AS_PROMPT_LEN, "Decode NFS file handles as");
 }
 
-/* This function will store one nfs filehandle in our global tree of
+/* A fixed-width digest of a file handle, which can be up to 128 bytes
+ * long, computed once so that the tables keyed by file handles only
+ * compare whole handles when their digests match.
+ */
+static guint
+nfs_fhandle_digest(const unsigned char *fh, int len)
+{
+	return wmem_strong_hash(fh, len);
+}
+
+static guint
+nfs_fhandle_data_hash(gconstpointer k)
+{
+	const nfs_fhandle_data_t *fhd = (const nfs_fhandle_data_t *)k;
+
+	return fhd->hash;
+}
+
+static gboolean
+nfs_fhandle_data_equal(gconstpointer k1, gconstpointer k2)
+{
+	const nfs_fhandle_data_t *fhd1 = (const nfs_fhandle_data_t *)k1;
+	const nfs_fhandle_data_t *fhd2 = (const nfs_fhandle_data_t *)k2;
+
+	return (fhd1->hash == fhd2->hash)
+	     &&(fhd1->len == fhd2->len)
+	     &&(!memcmp(fhd1->fh, fhd2->fh, fhd1->len));
+}
+
+/* This function will store one nfs filehandle in our global table of
  * filehandles.
- * We store all filehandles we see in this tree so that every unique
+ * We store all filehandles we see in this table so that every unique
  * filehandle is only stored once with a unique pointer.
  * We need to store pointers to filehandles in several of our other
  * structures and this is a way to make sure we don't keep any redundant
@@ -1062,38 +1102,20 @@ static void nfs_prompt(packet_info *pinfo _U_, gchar* result)
 static nfs_fhandle_data_t *
 store_nfs_file_handle(nfs_fhandle_data_t *nfs_fh)
 {
-	guint32		    fhlen;
-	guint32		   *fhdata;
-	wmem_tree_key_t	    fhkey[3];
 	nfs_fhandle_data_t *new_nfs_fh;
 
-	fhlen = nfs_fh->len/4;
-	/* align the file handle data */
-	fhdata = (guint32 *)g_memdup2(nfs_fh->fh, fhlen*4);
-	fhkey[0].length = 1;
-	fhkey[0].key	= &fhlen;
-	fhkey[1].length = fhlen;
-	fhkey[1].key	= fhdata;
-	fhkey[2].length = 0;
-
-	new_nfs_fh = (nfs_fhandle_data_t *)wmem_tree_lookup32_array(nfs_file_handles, &fhkey[0]);
+	nfs_fh->hash = nfs_fhandle_digest(nfs_fh->fh, nfs_fh->len);
+	new_nfs_fh = (nfs_fhandle_data_t *)wmem_map_lookup(nfs_file_handles, nfs_fh);
 	if (new_nfs_fh) {
-		g_free(fhdata);
 		return new_nfs_fh;
 	}
 
 	new_nfs_fh = wmem_new(wmem_file_scope(), nfs_fhandle_data_t);
 	new_nfs_fh->len = nfs_fh->len;
 	new_nfs_fh->fh = (const unsigned char *)wmem_memdup(wmem_file_scope(), nfs_fh->fh, nfs_fh->len);
-	fhlen = nfs_fh->len/4;
-	fhkey[0].length = 1;
-	fhkey[0].key	= &fhlen;
-	fhkey[1].length = fhlen;
-	fhkey[1].key	= fhdata;
-	fhkey[2].length = 0;
-	wmem_tree_insert32_array(nfs_file_handles, &fhkey[0], new_nfs_fh);
-
-	g_free(fhdata);
+	new_nfs_fh->hash = nfs_fh->hash;
+	wmem_map_insert(nfs_file_handles, new_nfs_fh, new_nfs_fh);
+
 	return new_nfs_fh;
 }
 
@@ -1104,7 +1126,8 @@ nfs_name_snoop_matched_equal(gconstpointer k1, gconstpointer k2)
 	const nfs_name_snoop_key_t *key1 = (const nfs_name_snoop_key_t *)k1;
 	const nfs_name_snoop_key_t *key2 = (const nfs_name_snoop_key_t *)k2;
 
-	return (key1->key == key2->key)
+	return (key1->hash == key2->hash)
+	     &&(key1->key == key2->key)
 	     &&(key1->fh_length == key2->fh_length)
 	     &&(!memcmp(key1->fh, key2->fh, key1->fh_length));
 }
@@ -1114,14 +1137,18 @@ static guint
 nfs_name_snoop_matched_hash(gconstpointer k)
 {
 	const nfs_name_snoop_key_t *key = (const nfs_name_snoop_key_t *)k;
-	int i;
-	guint hash;
 
-	hash = key->key;
-	for (i=0; i<key->fh_length; i++)
-		hash ^= key->fh[i];
+	return key->hash ^ key->key;
+}
+
 
-	return hash;
+static void
+nfs_name_snoop_set_key(nfs_name_snoop_key_t *key, const unsigned char *fh, int fh_length)
+{
+	key->key = 0;
+	key->fh_length = fh_length;
+	key->fh = fh;
+	key->hash = nfs_fhandle_digest(fh, fh_length);
 }
 
 
@@ -1152,11 +1179,58 @@ nfs_name_snoop_value_destroy(gpointer value)
 	g_free((gpointer)nns->name);
 	g_free((gpointer)nns->full_name);
 	wmem_free(NULL, nns->parent);
-	wmem_free(NULL, nns->fh);
+	wmem_free(NULL, (gpointer)nns->fh_key.fh);
 	g_free(nns);
 }
 
 
+/* Make a matched name the most recently seen one */
+static void
+nfs_name_snoop_touch(nfs_name_snoop_t *nns)
+{
+	g_queue_unlink(&nfs_name_snoop_lru, &nns->lru_link);
+	g_queue_push_tail_link(&nfs_name_snoop_lru, &nns->lru_link);
+}
+
+
+/* Remove a matched name from the matched and known names, and free it */
+static void
+nfs_name_snoop_forget(nfs_name_snoop_t *nns)
+{
+	g_queue_unlink(&nfs_name_snoop_lru, &nns->lru_link);
+	if (wmem_map_lookup(nfs_name_snoop_known, &nns->fh_key) == nns)
+		wmem_map_remove(nfs_name_snoop_known, &nns->fh_key);
+	g_hash_table_remove(nfs_name_snoop_matched, &nns->fh_key);
+}
+
+
+static gboolean
+nfs_name_snoop_expired(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	const nfs_name_snoop_t *nns = (const nfs_name_snoop_t *)value;
+
+	return nns->request_time < *(const time_t *)user_data;
+}
+
+
+/* Forget the requests that have waited too long for their reply, looking
+ * for them at most once per timeout so that this is cheap per request. */
+static void
+nfs_name_snoop_expire(time_t now)
+{
+	time_t cutoff;
+
+	if (nfs_name_snoop_timeout == 0)
+		return;
+	if (now >= nfs_name_snoop_last_expiry &&
+	    now - nfs_name_snoop_last_expiry < (time_t)nfs_name_snoop_timeout)
+		return;
+	nfs_name_snoop_last_expiry = now;
+	cutoff = now - (time_t)nfs_name_snoop_timeout;
+	g_hash_table_foreach_remove(nfs_name_snoop_unmatched, nfs_name_snoop_expired, &cutoff);
+}
+
+
 static void
 nfs_name_snoop_init(void)
 {
@@ -1168,6 +1242,7 @@ nfs_name_snoop_init(void)
 		g_hash_table_new_full(nfs_name_snoop_matched_hash,
 		nfs_name_snoop_matched_equal,
 		NULL, nfs_name_snoop_value_destroy);
+	nfs_name_snoop_last_expiry = 0;
 }
 
 static void
@@ -1175,12 +1250,14 @@ nfs_name_snoop_cleanup(void)
 {
 	g_hash_table_destroy(nfs_name_snoop_unmatched);
 	g_hash_table_destroy(nfs_name_snoop_matched);
+	/* The links were in the names just freed */
+	g_queue_init(&nfs_name_snoop_lru);
 }
 
 
 void
-nfs_name_snoop_add_name(int xid, tvbuff_t *tvb, int name_offset, int name_len, int parent_offset,
-			int parent_len, const char *name)
+nfs_name_snoop_add_name(packet_info *pinfo, int xid, tvbuff_t *tvb, int name_offset, int name_len,
+			int parent_offset, int parent_len, const char *name)
 {
 	nfs_name_snoop_t *nns;
 	const char	 *ptr;
@@ -1209,10 +1286,11 @@ nfs_name_snoop_add_name(int xid, tvbuff_t *tvb, int name_offset, int name_len, i
 		}
 	}
 
-	nns = g_new(nfs_name_snoop_t, 1);
+	nfs_name_snoop_expire(pinfo->abs_ts.secs);
 
-	nns->fh_length = 0;
-	nns->fh = NULL;
+	nns = g_new0(nfs_name_snoop_t, 1);
+	nns->request_time = pinfo->abs_ts.secs;
+	nns->lru_link.data = nns;
 
 	if (parent_len) {
 		nns->parent_len = parent_len;
@@ -1246,7 +1324,7 @@ nfs_name_snoop_add_fh(int xid, tvbuff_t *tvb, int fh_offset, int fh_length)
 {
 	unsigned char	     *fh;
 	nfs_name_snoop_t     *nns;
-	nfs_name_snoop_key_t *key;
+	nfs_name_snoop_t     *old_nns;
 
 	/* find which request we correspond to */
 	nns = (nfs_name_snoop_t *)g_hash_table_lookup(nfs_name_snoop_unmatched, GINT_TO_POINTER(xid));
@@ -1256,22 +1334,28 @@ nfs_name_snoop_add_fh(int xid, tvbuff_t *tvb, int fh_offset, int fh_length)
 	}
 
 	/* if we have already seen this response earlier */
-	if (nns->fh) {
+	if (nns->fh_key.fh) {
 		return;
 	}
 
 	/* oki, we have a new entry */
 	fh = (unsigned char *)tvb_memdup(NULL, tvb, fh_offset, fh_length);
-	nns->fh = fh;
-	nns->fh_length = fh_length;
-
-	key = wmem_new(wmem_file_scope(), nfs_name_snoop_key_t);
-	key->key = 0;
-	key->fh_length = nns->fh_length;
-	key->fh = nns->fh;
+	nfs_name_snoop_set_key(&nns->fh_key, fh, fh_length);
 
 	g_hash_table_steal(nfs_name_snoop_unmatched, GINT_TO_POINTER(xid));
-	g_hash_table_replace(nfs_name_snoop_matched, key, nns);
+
+	/* it replaces any name we had for the file handle */
+	old_nns = (nfs_name_snoop_t *)g_hash_table_lookup(nfs_name_snoop_matched, &nns->fh_key);
+	if (old_nns) {
+		nfs_name_snoop_forget(old_nns);
+	}
+	g_hash_table_insert(nfs_name_snoop_matched, &nns->fh_key, nns);
+	g_queue_push_tail_link(&nfs_name_snoop_lru, &nns->lru_link);
+
+	while (nfs_name_snoop_max_names &&
+	       g_hash_table_size(nfs_name_snoop_matched) > nfs_name_snoop_max_names) {
+		nfs_name_snoop_forget((nfs_name_snoop_t *)nfs_name_snoop_lru.head->data);
+	}
 }
 
 #define NFS_MAX_FS_DEPTH 100
@@ -1299,13 +1383,14 @@ nfs_full_name_snoop(packet_info *pinfo, nfs_name_snoop_t *nns, int *len, char **
 		return;
 	}
 
-	key.key = 0;
-	key.fh_length = nns->parent_len;
-	key.fh = nns->parent;
+	nfs_name_snoop_set_key(&key, nns->parent, nns->parent_len);
 
 	parent_nns = (nfs_name_snoop_t *)g_hash_table_lookup(nfs_name_snoop_matched, &key);
 
 	if (parent_nns) {
+		/* directories in use are kept as long as their files */
+		nfs_name_snoop_touch(parent_nns);
+
 		unsigned fs_depth = p_get_proto_depth(pinfo, proto_nfs);
 		if (++fs_depth >= NFS_MAX_FS_DEPTH) {
 			nns->fs_cycle = true;
@@ -1335,28 +1420,20 @@ nfs_name_snoop_fh(packet_info *pinfo, proto_tree *tree, tvbuff_t *tvb, int fh_of
 	nfs_name_snoop_key_t  key;
 	nfs_name_snoop_t     *nns = NULL;
 
+	nfs_name_snoop_set_key(&key, (const unsigned char *)tvb_get_ptr(tvb, fh_offset, fh_length),
+			       fh_length);
+
 	/* if this is a new packet, see if we can register the mapping */
 	if (!pinfo->fd->visited) {
-		key.key = 0;
-		key.fh_length = fh_length;
-		key.fh = (const unsigned char *)tvb_get_ptr(tvb, fh_offset, fh_length);
-
 		nns = (nfs_name_snoop_t *)g_hash_table_lookup(nfs_name_snoop_matched, &key);
 		if (nns) {
-			guint32 fhlen;
-			guint32 *fhdata;
-			wmem_tree_key_t fhkey[3];
-
-			fhlen = nns->fh_length;
-			/* align it */
-			fhdata = (guint32 *)g_memdup2(nns->fh, fhlen);
-			fhkey[0].length = 1;
-			fhkey[0].key	= &fhlen;
-			fhkey[1].length = fhlen/4;
-			fhkey[1].key	= fhdata;
-			fhkey[2].length = 0;
-			wmem_tree_insert32_array(nfs_name_snoop_known, &fhkey[0], nns);
-			g_free(fhdata);
+			nfs_name_snoop_touch(nns);
+			/* a known name is keyed by its own file handle, so that
+			   nfs_name_snoop_forget() can remove it */
+			if (wmem_map_lookup(nfs_name_snoop_known, &nns->fh_key) != nns) {
+				wmem_map_remove(nfs_name_snoop_known, &nns->fh_key);
+				wmem_map_insert(nfs_name_snoop_known, &nns->fh_key, nns);
+			}
 
 			if (nfs_file_name_full_snooping) {
 				char *name = NULL, *pos = NULL;
@@ -1364,6 +1441,7 @@ nfs_name_snoop_fh(packet_info *pinfo, proto_tree *tree, tvbuff_t *tvb, int fh_of
 
 				nfs_full_name_snoop(pinfo, nns, &len, &name, &pos);
 				if (name) {
+					g_free(nns->full_name);
 					nns->full_name = name;
 					nns->full_name_len = len;
 				}
@@ -1373,20 +1451,7 @@ nfs_name_snoop_fh(packet_info *pinfo, proto_tree *tree, tvbuff_t *tvb, int fh_of
 
 	/* see if we know this mapping */
 	if (!nns) {
-		guint32 fhlen;
-		guint32 *fhdata;
-		wmem_tree_key_t fhkey[3];
-
-		fhlen = fh_length;
-		/* align it */
-		fhdata = (guint32 *)tvb_memdup(wmem_packet_scope(), tvb, fh_offset, fh_length);
-		fhkey[0].length = 1;
-		fhkey[0].key	= &fhlen;
-		fhkey[1].length = fhlen/4;
-		fhkey[1].key	= fhdata;
-		fhkey[2].length = 0;
-
-		nns = (nfs_name_snoop_t *)wmem_tree_lookup32_array(nfs_name_snoop_known, &fhkey[0]);
+		nns = (nfs_name_snoop_t *)wmem_map_lookup(nfs_name_snoop_known, &key);
 	}
 
 	/* if we know the mapping, print the filename */
@@ -3000,7 +3065,7 @@ dissect_diropargs(tvbuff_t *tvb, int offset, packet_info *pinfo, proto_tree *tre
 		  &&(civ->request)
 		  &&((civ->proc == 4)||(civ->proc == 9)||(civ->proc == 14))
 		) {
-			nfs_name_snoop_add_name(civ->xid, tvb,
+			nfs_name_snoop_add_name(pinfo, civ->xid, tvb,
 				offset+36, tvb_get_ntohl(tvb, offset+32),
 				offset, 32, NULL);
 		}
@@ -4384,7 +4449,7 @@ dissect_diropargs3(tvbuff_t *tvb, int offset, packet_info *pinfo, proto_tree *tr
 		  &&(civ->request)
 		  &&((civ->proc == 3)||(civ->proc == 8)||(civ->proc == 9))
 		) {
-			nfs_name_snoop_add_name(civ->xid, tvb,
+			nfs_name_snoop_add_name(pinfo, civ->xid, tvb,
 				name_offset, name_len,
 				parent_offset, parent_len, NULL);
 		}
@@ -5648,7 +5713,7 @@ dissect_nfs3_entryplus(tvbuff_t *tvb, int offset, packet_info *pinfo,
 		  &&(!civ->request)
 		  &&((civ->proc == 17))
 		) {
-			nfs_name_snoop_add_name(civ->xid, tvb, 0, 0,
+			nfs_name_snoop_add_name(pinfo, civ->xid, tvb, 0, 0,
 				0/*parent offset*/, 0/*parent len*/,
 				name);
 		}
@@ -7660,7 +7725,7 @@ dissect_nfs4_open_claim(tvbuff_t *tvb, int offset, packet_info *pinfo _U_,
 			name_offset = offset+4;
 			name_len = tvb_get_ntohl(tvb, offset);
 
-			nfs_name_snoop_add_name(civ->xid, tvb,
+			nfs_name_snoop_add_name(pinfo, civ->xid, tvb,
 				name_offset, name_len, 0, 0, NULL);
 		}
 	}
@@ -10023,7 +10088,7 @@ dissect_nfs4_request_op(tvbuff_t *tvb, int offset, packet_info *pinfo, proto_tre
 			/*name_offset = offset;*/
 			offset = dissect_nfs_utf8string(tvb, offset, newftree, hf_nfs4_component, &name);
 			if (nfs_file_name_snooping) {
-				nfs_name_snoop_add_name(civ->xid, tvb,
+				nfs_name_snoop_add_name(pinfo, civ->xid, tvb,
 										/*name_offset, strlen(name), */
 										0, 0,
 										0, 0, name);
@@ -14573,6 +14638,16 @@ proto_register_nfs(void)
 				       "Whether the dissector should snoop the full pathname"
 				       " for files for matching FH's",
 				       &nfs_file_name_full_snooping);
+	prefs_register_uint_preference(nfs_module, "file_name_snooping_timeout",
+				       "Snooping request timeout (seconds)",
+				       "How long to wait for the reply to a request that gives a"
+				       " file name before forgetting the request (0 waits forever)",
+				       10, &nfs_name_snoop_timeout);
+	prefs_register_uint_preference(nfs_module, "file_name_snooping_max_names",
+				       "Maximum snooped file names",
+				       "How many FH to filename mappings to keep, forgetting the"
+				       " least recently seen ones beyond that (0 keeps them all)",
+				       10, &nfs_name_snoop_max_names);
 	prefs_register_bool_preference(nfs_module, "fhandle_find_both_reqrep",
 				       "Fhandle filters finds both request/response",
 				       "With this option display filters for nfs fhandles"
@@ -14593,8 +14668,10 @@ proto_register_nfs(void)
 
 	prefs_register_obsolete_preference(nfs_module, "default_fhandle_type");
 
-	nfs_name_snoop_known    = wmem_tree_new_autoreset(wmem_epan_scope(), wmem_file_scope());
-	nfs_file_handles        = wmem_tree_new_autoreset(wmem_epan_scope(), wmem_file_scope());
+	nfs_name_snoop_known    = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+						     nfs_name_snoop_matched_hash, nfs_name_snoop_matched_equal);
+	nfs_file_handles        = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+						     nfs_fhandle_data_hash, nfs_fhandle_data_equal);
 	nfs_fhandle_frame_table = wmem_tree_new_autoreset(wmem_epan_scope(), wmem_file_scope());
 	register_init_routine(nfs_name_snoop_init);
 	register_cleanup_routine(nfs_name_snoop_cleanup);
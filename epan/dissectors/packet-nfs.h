@@ -200,8 +200,8 @@
 #define NL4_NETADDR 3
 
 extern gboolean nfs_file_name_snooping;
-extern void nfs_name_snoop_add_name(int xid, tvbuff_t *tvb, int name_offset, int name_len,
-	                                int parent_offset, int parent_len, const char *name);
+extern void nfs_name_snoop_add_name(packet_info *pinfo, int xid, tvbuff_t *tvb, int name_offset,
+	                                int name_len, int parent_offset, int parent_len, const char *name);
 extern gboolean nfs_fhandle_reqrep_matching;
 extern int dissect_fhandle(tvbuff_t *tvb, int offset, packet_info *pinfo, proto_tree *tree,
                            const char *name, guint32 *hash, rpc_call_info_value *civ);
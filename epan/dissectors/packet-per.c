@@ -25,6 +25,7 @@ proper helper routines
 #include <epan/asn1.h>
 #include <epan/expert.h>
 #include <wsutil/str_util.h>
+#include <wsutil/bits_ctz.h>
 #include "packet-per.h"
 
 void proto_register_per(void);
@@ -293,8 +294,6 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 	guint32 len;
 	proto_item *pi;
 	int num_bits;
-	int i, bit, str_length, str_index;
-	gboolean tmp;
 
 	if(!length){
 		length=&len;
@@ -309,56 +308,35 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 		byte=tvb_get_guint8(tvb, offset>>3);
 		offset+=8;
 	}else{
-		char *str;
+		char *str = NULL;
 		guint32 val;
+		guint32 start_offset = offset;
 
-		val = 0;
-
-		/* prepare the string (max number of bits + quartet separators + prepended space) */
-		str_length = 256+64+1;
-		str=(char *)wmem_alloc(wmem_packet_scope(), str_length+1);
-		str_index = 0;
-
-		str_length = g_snprintf(str, str_length+1, " ");
-		for(bit=0;bit<((int)(offset&0x07));bit++){
-			if(bit&&(!(bit%4))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			if (str_index < str_length) str[str_index++] = '.';
+		/* Read the leading bits as a whole rather than one bit at a time.
+		 * The first two bits tell how long the determinant is; only those
+		 * are read for the (undecoded) unconstrained case so that no bits
+		 * beyond what is used are fetched. */
+		actx->created_item = NULL;
+		val = tvb_get_bits8(tvb, offset, 2);
+		if (val == 3 && !is_fragmented) { /* bits 8 and 7 both 1, so unconstrained */
+			*length = 0;
+			dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "10.9 Unconstrained");
+			return offset + 2;
+		}
+		if (val == 3) {
+			num_bits = 8;
+			*is_fragmented = TRUE;
+		} else if (val & 0x2) { /* bit 8 is 1, so not a single byte length */
+			num_bits = 16;
+		} else {
+			num_bits = 8;
 		}
-		/* read the bits for the int */
-		num_bits = 8;
-		for(i=0;i<num_bits;i++){
-			if(bit&&(!(bit%4))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			if(bit&&(!(bit%8))){
-				if (str_index < str_length) str[str_index++] = ' ';
-			}
-			bit++;
-			offset=dissect_per_boolean(tvb, offset, actx, tree, -1, &tmp);
-			val<<=1;
-			if(tmp){
-				val|=1;
-				if (str_index < str_length) str[str_index++] = '1';
-				if (i==0) { /* bit 8 is 1, so not a single byte length */
-					num_bits = 16;
-				}
-				else if (i==1 && val==3) { /* bits 8 and 7 both 1, so unconstrained */
-					if (!is_fragmented) {
-						*length = 0;
-						dissect_per_not_decoded_yet(tree, actx->pinfo, tvb, "10.9 Unconstrained");
-						return offset;
-					} else {
-						num_bits = 8;
-						*is_fragmented = TRUE;
-					}
-				}
-			} else {
-				if (str_index < str_length) str[str_index++] = '0';
-			}
+		val = tvb_get_bits32(tvb, offset, num_bits, ENC_BIG_ENDIAN);
+		offset += num_bits;
+
+		if (display_internal_per_fields) {
+			str = decode_bits_in_field(start_offset & 0x07, num_bits, val);
 		}
-		str[str_index] = '\0'; /* Terminate string */
 		if(is_fragmented && *is_fragmented==TRUE){
 			*length = val&0x3f;
 			if (*length>4 || *length==0) {
@@ -454,7 +432,7 @@ dissect_per_length_determinant(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx _
 static guint32
 dissect_per_normally_small_nonnegative_whole_number(tvbuff_t *tvb, guint32 offset, asn1_ctx_t *actx, proto_tree *tree, int hf_index, guint32 *length)
 {
-	gboolean small_number, length_bit;
+	gboolean small_number;
 	guint32 len, length_determinant;
 	proto_item *pi;
 
@@ -466,16 +444,10 @@ DEBUG_ENTRY("dissect_per_normally_small_nonnegative_whole_number");
 	offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_small_number_bit, &small_number);
 	if (!display_internal_per_fields) proto_item_set_hidden(actx->created_item);
 	if(!small_number){
-		int i;
 		/* 10.6.1 */
-		*length=0;
-		for(i=0;i<6;i++){
-			offset=dissect_per_boolean(tvb, offset, actx, tree, -1, &length_bit);
-			*length<<=1;
-			if (length_bit) {
-				*length|=1;
-			}
-		}
+		*length = tvb_get_bits8(tvb, offset, 6);
+		offset += 6;
+		actx->created_item = NULL;
 		if(hf_index!=-1){
 			pi = proto_tree_add_uint(tree, hf_index, tvb, (offset-6)>>3, (offset%8<6)?2:1, *length);
 			if (!display_internal_per_fields) proto_item_set_hidden(pi);
@@ -1309,21 +1281,14 @@ DEBUG_ENTRY("dissect_per_constrained_integer");
 		 * number of bits necessary to represent the range.
 		 */
 		char *str;
-		int i, length;
-		guint32 mask,mask2;
-		/* We only handle 32 bit integers */
-		mask  = 0x80000000;
-		mask2 = 0x7fffffff;
-		i = 32;
-		while ((range & mask)== 0){
-			i = i - 1;
-			mask = mask>>1;
-			mask2 = mask2>>1;
-		}
-		if ((range & mask2) == 0)
-			i = i-1;
+		int length;
+		/* We only handle 32 bit integers. The minimum number of bits
+		 * for the range: the position of its highest set bit, one less
+		 * if the range is an exact power of two. */
+		num_bits = ws_ilog2(range) + 1;
+		if ((range & (range - 1)) == 0)
+			num_bits--;
 
-		num_bits = i;
 		length=(num_bits+7)>>3;
 		if(range<=2){
 			num_bits=1;
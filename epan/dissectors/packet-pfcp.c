@@ -941,9 +941,21 @@ GHashTable* pfcp_session_table;
 /* Relation between <seid,ip> -> frame */
 wmem_tree_t* pfcp_frame_tree;
 
+/*
+ * pfcp_frame_tree maps an IP address (as a string) to a map of SEID -> chain
+ * of pfcp_info_t, newest first, so that removing the newest <seid,frame> pair
+ * exposes the previous one. The reverse indexes frame -> entries and
+ * session -> frames let removals touch only the affected entries.
+ */
+static wmem_map_t* pfcp_frame_info_map;
+static wmem_map_t* pfcp_session_frames_map;
+
 typedef struct pfcp_info {
     guint64 seid;
     guint32 frame;
+    wmem_map_t *seid_map;       /* per-IP map that holds this entry */
+    const guint64 *seid_key;    /* key of this entry's chain in seid_map */
+    struct pfcp_info *next;     /* older entry for the same <seid,ip> */
 } pfcp_info_t;
 
 
@@ -1477,71 +1489,74 @@ static value_string_ext pfcp_ie_type_ext = VALUE_STRING_EXT_INIT(pfcp_ie_type);
 /* PFCP Session funcs*/
 static guint32
 pfcp_get_frame(address ip, guint64 seid, guint32 *frame) {
-    gboolean found = FALSE;
-    wmem_list_frame_t *elem;
+    wmem_map_t *seid_map;
     pfcp_info_t *info;
-    wmem_list_t *info_list;
     gchar *ip_str;
 
-    /* First we get the seid list*/
+    /* First we get the seid map*/
     ip_str = address_to_str(wmem_packet_scope(), &ip);
-    info_list = (wmem_list_t*)wmem_tree_lookup_string(pfcp_frame_tree, ip_str, 0);
-    if (info_list != NULL) {
-        elem = wmem_list_head(info_list);
-        while (!found && elem) {
-            info = (pfcp_info_t*)wmem_list_frame_data(elem);
-            if (seid == info->seid) {
-                *frame = info->frame;
-                return 1;
-            }
-            elem = wmem_list_frame_next(elem);
+    seid_map = (wmem_map_t*)wmem_tree_lookup_string(pfcp_frame_tree, ip_str, 0);
+    if (seid_map != NULL) {
+        info = (pfcp_info_t*)wmem_map_lookup(seid_map, &seid);
+        if (info) {
+            *frame = info->frame;
+            return 1;
         }
     }
     return 0;
 }
 
-static gboolean
-pfcp_call_foreach_ip(const void *key _U_, void *value, void *data){
-    wmem_list_frame_t * elem;
-    wmem_list_t *info_list = (wmem_list_t *)value;
-    pfcp_info_t *info;
-    guint32* frame = (guint32*)data;
-
-    /* We loop over the <seid, frame> list */
-    elem = wmem_list_head(info_list);
-    while (elem) {
-        info = (pfcp_info_t*)wmem_list_frame_data(elem);
-        if (info->frame == *frame) {
-            wmem_list_frame_t * del = elem;
-            /* proceed to next request */
-            elem = wmem_list_frame_next(elem);
-            /* If we find the frame we remove its information from the list */
-            wmem_list_remove_frame(info_list, del);
-            wmem_free(wmem_file_scope(), info);
-        }
-        else {
-            elem = wmem_list_frame_next(elem);
+static void
+pfcp_unlink_info(pfcp_info_t *info)
+{
+    pfcp_info_t *head, **link;
+
+    head = (pfcp_info_t*)wmem_map_lookup(info->seid_map, info->seid_key);
+    for (link = &head; *link; link = &(*link)->next) {
+        if (*link == info) {
+            *link = info->next;
+            break;
         }
     }
-
-    return FALSE;
+    /* The key stays in the map (with a NULL chain) so it can be reused */
+    wmem_map_insert(info->seid_map, info->seid_key, head);
 }
 
 static void
 pfcp_remove_frame_info(guint32 *f) {
-    /* For each ip node */
-    wmem_tree_foreach(pfcp_frame_tree, pfcp_call_foreach_ip, (void *)f);
+    wmem_list_t *infos;
+    wmem_list_frame_t *elem;
+
+    /* Remove every <seid,frame> pair this frame added, on any ip */
+    infos = (wmem_list_t*)wmem_map_remove(pfcp_frame_info_map, GUINT_TO_POINTER(*f));
+    if (infos == NULL) {
+        return;
+    }
+    for (elem = wmem_list_head(infos); elem; elem = wmem_list_frame_next(elem)) {
+        pfcp_info_t *info = (pfcp_info_t*)wmem_list_frame_data(elem);
+        pfcp_unlink_info(info);
+        wmem_free(wmem_file_scope(), info);
+    }
+    wmem_destroy_list(infos);
 }
 
 static void
 pfcp_add_session(guint32 frame, guint32 session) {
     guint32 *f, *session_count;
+    wmem_list_t *frames;
 
     f = wmem_new0(wmem_file_scope(), guint32);
     session_count = wmem_new0(wmem_file_scope(), guint32);
     *f = frame;
     *session_count = session;
     g_hash_table_insert(pfcp_session_table, f, session_count);
+
+    frames = (wmem_list_t*)wmem_map_lookup(pfcp_session_frames_map, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        frames = wmem_list_new(wmem_file_scope());
+        wmem_map_insert(pfcp_session_frames_map, GUINT_TO_POINTER(session), frames);
+    }
+    wmem_list_prepend(frames, GUINT_TO_POINTER(frame));
 }
 
 static gboolean
@@ -1574,71 +1589,85 @@ pfcp_ip_exists(address ip, wmem_list_t *ip_list) {
     return found;
 }
 
-static gboolean
-pfcp_info_exists(pfcp_info_t *wanted, wmem_list_t *info_list) {
+/* Remove the <seid,frame> information of every frame in a session */
+static void
+pfcp_remove_session_info(guint32 session)
+{
+    wmem_list_t *frames;
     wmem_list_frame_t *elem;
-    pfcp_info_t *info;
-    gboolean found;
-    found = FALSE;
-    elem = wmem_list_head(info_list);
-    while (!found && elem) {
-        info = (pfcp_info_t*)wmem_list_frame_data(elem);
-        found = wanted->seid == info->seid;
-        elem = wmem_list_frame_next(elem);
+
+    frames = (wmem_list_t*)wmem_map_lookup(pfcp_session_frames_map, GUINT_TO_POINTER(session));
+    if (frames == NULL) {
+        return;
+    }
+    for (elem = wmem_list_head(frames); elem; elem = wmem_list_frame_next(elem)) {
+        guint32 fr = GPOINTER_TO_UINT(wmem_list_frame_data(elem));
+        guint32 *session_count = (guint32 *)g_hash_table_lookup(pfcp_session_table, &fr);
+
+        /* Skip frames that were moved to another session since */
+        if (session_count && *session_count == session) {
+            pfcp_remove_frame_info(&fr);
+        }
     }
-    return found;
 }
 
 static void
 pfcp_fill_map(wmem_list_t *seid_list, wmem_list_t *ip_list, guint32 frame) {
     wmem_list_frame_t *elem_ip, *elem_seid;
     pfcp_info_t *pfcp_info;
-    wmem_list_t * info_list; /* List of <seids,frames>*/
-    guint32 *f, *session, *fr, *session_count;
-    GHashTableIter iter;
+    wmem_map_t *seid_map; /* Map of seid -> <seid,frame> chain */
+    wmem_list_t *infos;
+    guint32 *session;
     guint64 seid;
+    gpointer orig_key, head;
     gchar *ip;
 
     elem_ip = wmem_list_head(ip_list);
 
     while (elem_ip) {
-        ip = address_to_str(wmem_file_scope(), (address*)wmem_list_frame_data(elem_ip));
-        /* We check if a seid list exists for this ip */
-        info_list = (wmem_list_t*)wmem_tree_lookup_string(pfcp_frame_tree, ip, 0);
-        if (info_list == NULL) {
-            info_list = wmem_list_new(wmem_file_scope());
+        ip = address_to_str(wmem_packet_scope(), (address*)wmem_list_frame_data(elem_ip));
+        /* We check if a seid map exists for this ip */
+        seid_map = (wmem_map_t*)wmem_tree_lookup_string(pfcp_frame_tree, ip, 0);
+        if (seid_map == NULL) {
+            seid_map = wmem_map_new(wmem_file_scope(), wmem_int64_hash, g_int64_equal);
+            wmem_tree_insert_string(pfcp_frame_tree, ip, seid_map, 0);
         }
 
         /* We loop over the seid list */
         elem_seid = wmem_list_head(seid_list);
         while (elem_seid) {
             seid = *(guint64*)wmem_list_frame_data(elem_seid);
-            f = wmem_new0(wmem_file_scope(), guint32);
-            *f = frame;
-            pfcp_info = wmem_new0(wmem_file_scope(), pfcp_info_t);
-            pfcp_info->seid = seid;
-            pfcp_info->frame = *f;
 
-            if (pfcp_info_exists(pfcp_info, info_list)) {
+            if (wmem_map_lookup(seid_map, &seid)) {
                 /* If the seid and ip already existed, that means that we need to remove old info about that session */
                 /* We look for its session ID */
-                session = (guint32 *)g_hash_table_lookup(pfcp_session_table, f);
+                session = (guint32 *)g_hash_table_lookup(pfcp_session_table, &frame);
                 if (session) {
-                    g_hash_table_iter_init(&iter, pfcp_session_table);
-
-                    while (g_hash_table_iter_next(&iter, (gpointer*)&fr, (gpointer*)&session_count)) {
-                        /* If the msg has the same session ID and it's not the upd req we have to remove its info */
-                        if (*session_count == *session) {
-                            /* If it's the session we are looking for, we remove all the frame information */
-                            pfcp_remove_frame_info(fr);
-                        }
-                    }
+                    /* If it's the session we are looking for, we remove all the frame information */
+                    pfcp_remove_session_info(*session);
                 }
             }
-            wmem_list_prepend(info_list, pfcp_info);
+
+            if (!wmem_map_lookup_extended(seid_map, &seid, (const void **)&orig_key, &head)) {
+                orig_key = wmem_memdup(wmem_file_scope(), &seid, sizeof(seid));
+                head = NULL;
+            }
+            pfcp_info = wmem_new0(wmem_file_scope(), pfcp_info_t);
+            pfcp_info->seid = seid;
+            pfcp_info->frame = frame;
+            pfcp_info->seid_map = seid_map;
+            pfcp_info->seid_key = (const guint64 *)orig_key;
+            pfcp_info->next = (pfcp_info_t*)head;
+            wmem_map_insert(seid_map, orig_key, pfcp_info);
+
+            infos = (wmem_list_t*)wmem_map_lookup(pfcp_frame_info_map, GUINT_TO_POINTER(frame));
+            if (infos == NULL) {
+                infos = wmem_list_new(wmem_file_scope());
+                wmem_map_insert(pfcp_frame_info_map, GUINT_TO_POINTER(frame), infos);
+            }
+            wmem_list_prepend(infos, pfcp_info);
             elem_seid = wmem_list_frame_next(elem_seid);
         }
-        wmem_tree_insert_string(pfcp_frame_tree, ip, info_list, 0);
         elem_ip = wmem_list_frame_next(elem_ip);
     }
 }
@@ -9140,6 +9169,8 @@ pfcp_init(void)
     pfcp_session_count = 1;
     pfcp_session_table = g_hash_table_new(g_int_hash, g_int_equal);
     pfcp_frame_tree = wmem_tree_new(wmem_file_scope());
+    pfcp_frame_info_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    pfcp_session_frames_map = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -399,6 +399,7 @@ static wmem_map_t *quic_client_connections, *quic_server_connections;
 static wmem_map_t *quic_initial_connections;    /* Initial.DCID -> connection */
 static wmem_list_t *quic_connections;   /* All unique connections. */
 static guint32 quic_cid_lengths;        /* Bitmap of CID lengths. */
+static gboolean quic_cids_collided;     /* A CID was used by both client and server. */
 static guint quic_connections_count;
 
 /* Returns the QUIC draft version or 0 if not applicable. */
@@ -871,6 +872,12 @@ static void
 quic_cids_insert(quic_cid_t *cid, quic_info_data_t *conn, gboolean from_server)
 {
     wmem_map_t *connections = from_server ? quic_server_connections : quic_client_connections;
+    wmem_map_t *other = from_server ? quic_client_connections : quic_server_connections;
+    // Remember whether the same CID was ever chosen by both sides, so that
+    // lookups only have to consult the other map when that happened.
+    if (!quic_cids_collided && wmem_map_contains(other, cid)) {
+        quic_cids_collided = TRUE;
+    }
     // Replace any previous CID key with the new one.
     wmem_map_remove(connections, cid);
     wmem_map_insert(connections, cid, conn);
@@ -929,7 +936,9 @@ quic_connection_find_dcid(packet_info *pinfo, const quic_cid_t *dcid, gboolean *
             // On collision (both client and server choose the same CID), check
             // the port to learn about the side.
             // This is required for supporting draft -10 which has a single CID.
-            check_ports = !!wmem_map_lookup(quic_server_connections, dcid);
+            // Such collisions are rare, skip the second lookup unless one was
+            // seen.
+            check_ports = quic_cids_collided && !!wmem_map_lookup(quic_server_connections, dcid);
         } else {
             conn = (quic_info_data_t *) wmem_map_lookup(quic_server_connections, dcid);
             if (conn) {
@@ -3732,6 +3741,7 @@ quic_init(void)
     quic_client_connections = wmem_map_new(wmem_file_scope(), quic_connection_hash, quic_connection_equal);
     quic_server_connections = wmem_map_new(wmem_file_scope(), quic_connection_hash, quic_connection_equal);
     quic_cid_lengths = 0;
+    quic_cids_collided = FALSE;
 }
 
 /** Release QUIC dissection state on closing a capture file. */
@@ -2871,7 +2871,7 @@ proto_register_radius(void)
 	prefs_register_obsolete_preference(radius_module, "request_ttl");
 
 	radius_tap = register_tap("radius");
-	proto_register_prefix("radius", register_radius_fields);
+	proto_register_protocol_prefix(proto_radius, register_radius_fields);
 
 	dict = g_new(radius_dictionary_t, 1);
 	/*
@@ -429,7 +429,15 @@ typedef struct _infodata_t {
   guint16 direction;
 } infodata_t;
 
-static wmem_list_t *assoc_info_list = NULL;
+/*
+ * Associations are indexed two ways, with each entry a list of the
+ * matching assoc_info_t, newest first: by the unordered pair of their
+ * ports, which sctp_assoc_vtag_cmp() always requires to match, and by
+ * each of their non-zero tags, which are all that's compared for frames
+ * that have already been visited.
+ */
+static wmem_map_t *assoc_info_by_ports = NULL;
+static wmem_map_t *assoc_info_by_tag = NULL;
 static guint num_assocs = 0;
 
 UAT_CSTRING_CB_DEF(type_fields, type_name, type_field_t)
@@ -582,87 +590,157 @@ static gint sctp_assoc_vtag_cmp(const assoc_info_t *a, const assoc_info_t *b)
 }
 #undef RETURN_DIRECTION
 
+static gpointer
+assoc_ports_key(guint16 port1, guint16 port2)
+{
+  if (port1 > port2)
+    return GUINT_TO_POINTER(((guint)port2 << 16) | port1);
+  return GUINT_TO_POINTER(((guint)port1 << 16) | port2);
+}
+
+static void
+assoc_index_add(wmem_map_t *map, gpointer key, assoc_info_t *info)
+{
+  wmem_list_t *list = (wmem_list_t *)wmem_map_lookup(map, key);
+
+  if (list == NULL) {
+    list = wmem_list_new(wmem_file_scope());
+    wmem_map_insert(map, key, list);
+  } else if (wmem_list_frame_data(wmem_list_head(list)) == info) {
+    return;
+  }
+  wmem_list_prepend(list, info);
+}
+
+static void
+assoc_index_tag(assoc_info_t *info, guint32 tag)
+{
+  /* Entries for tags the association no longer has are harmless, as
+   * every candidate is compared in full. */
+  if (tag != 0)
+    assoc_index_add(assoc_info_by_tag, GUINT_TO_POINTER(tag), info);
+}
+
+static gboolean
+assoc_visited_match(const assoc_info_t *tmpinfo, const assoc_info_t *info, infodata_t *inf)
+{
+  if ((tmpinfo->initiate_tag != 0 && tmpinfo->initiate_tag == info->initiate_tag) ||
+      (tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag1) ||
+      (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag2)) {
+    inf->assoc_index = info->assoc_index;
+    inf->direction = info->direction;
+    return TRUE;
+  } else if ((tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag2) ||
+             (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag1) ||
+             (tmpinfo->verification_tag1 == 0 && tmpinfo->initiate_tag != 0 &&
+             tmpinfo->initiate_tag == info->verification_tag1)) {
+    inf->assoc_index = info->assoc_index;
+    if (info->direction == 1)
+      inf->direction = 2;
+    else
+      inf->direction = 1;
+    return TRUE;
+  }
+  return FALSE;
+}
+
 static infodata_t
 find_assoc_index(assoc_info_t* tmpinfo, gboolean visited)
 {
   assoc_info_t *info = NULL;
+  wmem_list_t *list;
   wmem_list_frame_t *elem;
   gboolean cmp = FALSE;
   infodata_t inf;
   inf.assoc_index = -1;
   inf.direction = 1;
 
-  if (assoc_info_list == NULL) {
-    assoc_info_list = wmem_list_new(wmem_file_scope());
+  if (assoc_info_by_ports == NULL) {
+    assoc_info_by_ports = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    assoc_info_by_tag = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
   }
 
-  for (elem = wmem_list_head(assoc_info_list); elem; elem = wmem_list_frame_next(elem))
+  if (visited) {
+    /*
+     * The first match among all associations, newest first, is the one
+     * with the highest index among those sharing a tag with this packet.
+     */
+    guint32 tags[3] = { tmpinfo->initiate_tag, tmpinfo->verification_tag1, tmpinfo->verification_tag2 };
+    const assoc_info_t *found = NULL;
+    infodata_t match;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+      if (tags[i] == 0)
+        continue;
+      list = (wmem_list_t *)wmem_map_lookup(assoc_info_by_tag, GUINT_TO_POINTER(tags[i]));
+      if (list == NULL)
+        continue;
+      for (elem = wmem_list_head(list); elem; elem = wmem_list_frame_next(elem))
+      {
+        info = (assoc_info_t*) wmem_list_frame_data(elem);
+        if (found && info->assoc_index <= found->assoc_index)
+          continue;
+        if (assoc_visited_match(tmpinfo, info, &match)) {
+          found = info;
+          inf = match;
+        }
+      }
+    }
+    return inf;
+  }
+
+  list = (wmem_list_t *)wmem_map_lookup(assoc_info_by_ports, assoc_ports_key(tmpinfo->sport, tmpinfo->dport));
+  for (elem = list ? wmem_list_head(list) : NULL; elem; elem = wmem_list_frame_next(elem))
   {
     info = (assoc_info_t*) wmem_list_frame_data(elem);
 
-    if (!visited) {
-      cmp = sctp_assoc_vtag_cmp(tmpinfo, info);
-      if (cmp < ASSOC_NOT_FOUND) {
-        switch (cmp)
-        {
-          case FORWARD_ADD_FORWARD_VTAG:
-          case BACKWARD_ADD_FORWARD_VTAG:
-            info->verification_tag1 = tmpinfo->verification_tag1;
-            break;
-          case BACKWARD_ADD_BACKWARD_VTAG:
-            info->verification_tag2 = tmpinfo->verification_tag1;
-            info->direction = 1;
-            inf.assoc_index = info->assoc_index;
-            inf.direction = 2;
-            return inf;
-          case BACKWARD_STREAM:
-            inf.assoc_index = info->assoc_index;
-            inf.direction = 2;
-            return inf;
-        }
-        if (cmp == FORWARD_STREAM || cmp == FORWARD_ADD_FORWARD_VTAG) {
+    cmp = sctp_assoc_vtag_cmp(tmpinfo, info);
+    if (cmp < ASSOC_NOT_FOUND) {
+      switch (cmp)
+      {
+        case FORWARD_ADD_FORWARD_VTAG:
+        case BACKWARD_ADD_FORWARD_VTAG:
+          info->verification_tag1 = tmpinfo->verification_tag1;
+          assoc_index_tag(info, info->verification_tag1);
+          break;
+        case BACKWARD_ADD_BACKWARD_VTAG:
+          info->verification_tag2 = tmpinfo->verification_tag1;
+          assoc_index_tag(info, info->verification_tag2);
           info->direction = 1;
-        } else {
-          info->direction = 2;
-        }
-        inf.assoc_index = info->assoc_index;
-        inf.direction = info->direction;
-        return inf;
-      }
-    } else {
-      if ((tmpinfo->initiate_tag != 0 && tmpinfo->initiate_tag == info->initiate_tag) ||
-          (tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag1) ||
-          (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag2)) {
-        inf.assoc_index = info->assoc_index;
-        inf.direction = info->direction;
-        return inf;
-      } else if ((tmpinfo->verification_tag1 != 0 && tmpinfo->verification_tag1 == info->verification_tag2) ||
-                 (tmpinfo->verification_tag2 != 0 && tmpinfo->verification_tag2 == info->verification_tag1) ||
-                 (tmpinfo->verification_tag1 == 0 && tmpinfo->initiate_tag != 0 &&
-                 tmpinfo->initiate_tag == info->verification_tag1)) {
-        inf.assoc_index = info->assoc_index;
-        if (info->direction == 1)
+          inf.assoc_index = info->assoc_index;
           inf.direction = 2;
-        else
-          inf.direction = 1;
-        return inf;
+          return inf;
+        case BACKWARD_STREAM:
+          inf.assoc_index = info->assoc_index;
+          inf.direction = 2;
+          return inf;
+      }
+      if (cmp == FORWARD_STREAM || cmp == FORWARD_ADD_FORWARD_VTAG) {
+        info->direction = 1;
+      } else {
+        info->direction = 2;
       }
+      inf.assoc_index = info->assoc_index;
+      inf.direction = info->direction;
+      return inf;
     }
   }
 
-  if (!elem && !visited) {
-    info = wmem_new0(wmem_file_scope(), assoc_info_t);
-    info->assoc_index = num_assocs;
-    info->sport = tmpinfo->sport;
-    info->dport = tmpinfo->dport;
-    info->verification_tag1 = tmpinfo->verification_tag1;
-    info->verification_tag2 = tmpinfo->verification_tag2;
-    info->initiate_tag = tmpinfo->initiate_tag;
-    num_assocs++;
-    wmem_list_prepend(assoc_info_list, info);
-    inf.assoc_index = info->assoc_index;
-    inf.direction = 1;
-  }
+  info = wmem_new0(wmem_file_scope(), assoc_info_t);
+  info->assoc_index = num_assocs;
+  info->sport = tmpinfo->sport;
+  info->dport = tmpinfo->dport;
+  info->verification_tag1 = tmpinfo->verification_tag1;
+  info->verification_tag2 = tmpinfo->verification_tag2;
+  info->initiate_tag = tmpinfo->initiate_tag;
+  num_assocs++;
+  assoc_index_add(assoc_info_by_ports, assoc_ports_key(info->sport, info->dport), info);
+  assoc_index_tag(info, info->initiate_tag);
+  assoc_index_tag(info, info->verification_tag1);
+  assoc_index_tag(info, info->verification_tag2);
+  inf.assoc_index = info->assoc_index;
+  inf.direction = 1;
 
   return inf;
 }
@@ -2618,7 +2696,8 @@ sctp_init(void)
   frag_table = g_hash_table_new_full(frag_hash, frag_equal,
       (GDestroyNotify)g_free, (GDestroyNotify)frag_free_msgs);
   num_assocs = 0;
-  assoc_info_list = NULL;
+  assoc_info_by_ports = NULL;
+  assoc_info_by_tag = NULL;
 }
 
 static void
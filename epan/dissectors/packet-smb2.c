@@ -89,6 +89,9 @@ void proto_reg_handoff_smb2(void);
 #define SMB2_COMP_HEADER 0xFC
 
 static wmem_map_t *smb2_sessions = NULL;
+/* File names of the FIDs seen so far; FIDs opened with the same name
+ * share the one copy. */
+static wmem_map_t *smb2_fid_names = NULL;
 
 static const char smb_header_label[] = "SMB2 Header";
 static const char smb_transform_header_label[] = "SMB2 Transform Header";
@@ -1484,6 +1487,18 @@ smb2_conv_destroy(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
 	return FALSE;
 }
 
+static char *
+smb2_fid_name_intern(const char *name)
+{
+	char *interned = (char *)wmem_map_lookup(smb2_fid_names, name);
+
+	if (!interned) {
+		interned = wmem_strdup(wmem_file_scope(), name);
+		wmem_map_insert(smb2_fid_names, interned, interned);
+	}
+	return interned;
+}
+
 static smb2_sesid_info_t *
 smb2_get_session(smb2_conv_info_t *conv _U_, guint64 id, packet_info *pinfo, smb2_info_t *si)
 {
@@ -2358,15 +2373,16 @@ dissect_smb2_fid(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int offset
 			sfi->frame_end = G_MAXUINT32;
 
 			if (si->saved && si->saved->extra_info_type == SMB2_EI_FILENAME) {
-				sfi->name = wmem_strdup(wmem_file_scope(), (char *)si->saved->extra_info);
+				sfi->name = smb2_fid_name_intern((char *)si->saved->extra_info);
 			} else {
-				sfi->name = wmem_strdup_printf(wmem_file_scope(), "[unknown]");
+				sfi->name = smb2_fid_name_intern("[unknown]");
 			}
 
+			/* dcerpc_store_polhnd_name() keeps its own copy */
 			if (si->saved && si->saved->extra_info_type == SMB2_EI_FILENAME) {
-				fid_name = wmem_strdup_printf(wmem_file_scope(), "File: %s", (char *)si->saved->extra_info);
+				fid_name = wmem_strdup_printf(wmem_packet_scope(), "File: %s", (char *)si->saved->extra_info);
 			} else {
-				fid_name = wmem_strdup_printf(wmem_file_scope(), "File: ");
+				fid_name = wmem_strdup_printf(wmem_packet_scope(), "File: ");
 			}
 			dcerpc_store_polhnd_name(&policy_hnd, pinfo,
 						  fid_name);
@@ -13921,6 +13937,7 @@ proto_register_smb2(void)
 
 	register_srt_table(proto_smb2, NULL, 1, smb2stat_packet, smb2stat_init, NULL);
 	smb2_sessions = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), smb2_sesid_info_hash, smb2_sesid_info_equal);
+	smb2_fid_names = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_str_hash, g_str_equal);
 }
 
 void
@@ -1917,30 +1917,34 @@ pdu_store_window_scale_option(guint8 ws, struct tcp_analysis *tcpd)
 static void
 tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean createflag, struct tcp_analysis *tcpd)
 {
-
-    wmem_tree_key_t key[4];
-
-    key[0].length = 1;
-    key[0].key = &frame;
-
-    key[1].length = 1;
-    key[1].key = &seq;
-
-    key[2].length = 1;
-    key[2].key = &ack;
-
-    key[3].length = 0;
-    key[3].key = NULL;
+    struct tcp_acked *head, *ta;
 
     if (!tcpd) {
         return;
     }
 
-    tcpd->ta = (struct tcp_acked *)wmem_tree_lookup32_array(tcpd->acked_table, key);
-    if((!tcpd->ta) && createflag) {
-        tcpd->ta = wmem_new0(wmem_file_scope(), struct tcp_acked);
-        wmem_tree_insert32_array(tcpd->acked_table, key, (void *)tcpd->ta);
+    /* A single-level tree keyed by frame costs one node per segment,
+     * where keying by (frame, seq, ack) cost a subtree per key part.
+     */
+    head = (struct tcp_acked *)wmem_tree_lookup32(tcpd->acked_table, frame);
+    for (ta = head; ta; ta = ta->next) {
+        if (ta->seq == seq && ta->ack == ack) {
+            break;
+        }
     }
+
+    if((!ta) && createflag) {
+        ta = wmem_new0(wmem_file_scope(), struct tcp_acked);
+        ta->seq = seq;
+        ta->ack = ack;
+        if (head) {
+            ta->next = head->next;
+            head->next = ta;
+        } else {
+            wmem_tree_insert32(tcpd->acked_table, frame, (void *)ta);
+        }
+    }
+    tcpd->ta = ta;
 }
 
 
@@ -7265,6 +7269,53 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     return tvb_captured_length(tvb);
 }
 
+static gboolean
+tcp_free_acked(const void *key _U_, void *value, void *userdata _U_)
+{
+    struct tcp_acked *ta, *next;
+
+    for (ta = (struct tcp_acked *)value; ta; ta = next) {
+        next = ta->next;
+        wmem_free(wmem_file_scope(), ta);
+    }
+    return FALSE;
+}
+
+static void
+tcp_free_flow(tcp_flow_t *flow)
+{
+    tcp_unacked_t *ual, *next;
+
+    wmem_tree_destroy(flow->multisegment_pdus, FALSE, TRUE);
+    flow->multisegment_pdus = wmem_tree_new(wmem_file_scope());
+
+    if (flow->tcp_analyze_seq_info) {
+        for (ual = flow->tcp_analyze_seq_info->segments; ual; ual = next) {
+            next = ual->next;
+            wmem_free(wmem_file_scope(), ual);
+        }
+        flow->tcp_analyze_seq_info->segments = NULL;
+        flow->tcp_analyze_seq_info->segment_count = 0;
+    }
+}
+
+/* Hand back the per-segment state of an expired conversation.  The
+ * tcp_analysis itself is kept, as MPTCP may still refer to it.
+ */
+static void
+tcp_conversation_expire(conversation_t *conv _U_, void *proto_data)
+{
+    struct tcp_analysis *tcpd = (struct tcp_analysis *)proto_data;
+
+    wmem_tree_foreach(tcpd->acked_table, tcp_free_acked, NULL);
+    wmem_tree_destroy(tcpd->acked_table, FALSE, FALSE);
+    tcpd->acked_table = wmem_tree_new(wmem_file_scope());
+    tcpd->ta = NULL;
+
+    tcp_free_flow(&tcpd->flow1);
+    tcp_free_flow(&tcpd->flow2);
+}
+
 static void
 tcp_init(void)
 {
@@ -8342,6 +8393,7 @@ proto_register_tcp(void)
         &tcp_display_process_info);
 
     register_init_routine(tcp_init);
+    conversation_register_expire_func(proto_tcp, tcp_conversation_expire);
     reassembly_table_register(&tcp_reassembly_table,
                           &addresses_ports_reassembly_table_functions);
 
@@ -154,18 +154,26 @@ typedef struct _tcp_unacked_t {
 	nstime_t ts;
 } tcp_unacked_t;
 
+/* Per-segment analysis results. There is one of these for every analyzed
+ * segment, so the members are ordered to avoid padding. Segments are looked
+ * up by frame number; the rare frames carrying more than one segment of the
+ * same conversation are chained through "next" and told apart by seq/ack.
+ */
 struct tcp_acked {
-	guint32 frame_acked;
+	struct tcp_acked *next;	/* next segment in the same frame */
 	nstime_t ts;
 
-	guint32  rto_frame;
 	nstime_t rto_ts;	/* Time since previous packet for
 				   retransmissions. */
-	guint16 flags; /* see TCP_A_* in packet-tcp.c */
+	guint32 seq;
+	guint32 ack;
+	guint32 frame_acked;
+	guint32  rto_frame;
 	guint32 dupack_num;	/* dup ack number */
 	guint32 dupack_frame;	/* dup ack to frame # */
 	guint32 bytes_in_flight; /* number of bytes in flight */
 	guint32 push_bytes_sent; /* bytes since the last PSH flag */
+	guint16 flags; /* see TCP_A_* in packet-tcp.c */
 };
 
 /* One instance of this structure is created for each pdu that spans across
@@ -4801,12 +4801,16 @@ ssl_decrypt_record(SslDecryptSession *ssl, SslDecoder *decoder, guint8 ct, guint
         return -1;
     }
 
-    /* ensure we have enough storage space for decrypted data */
+    /* ensure we have enough storage space for decrypted data. The buffer
+     * is shared by all sessions, so size it for the largest record that can
+     * appear on the wire (plaintext limit plus expansion allowance) right
+     * away instead of growing it step by step as larger records show up. */
     if (inl > out_str->data_len)
     {
+        guint alloc_len = MAX((guint)inl, TLS_MAX_RECORD_LENGTH + 2048) + 32;
         ssl_debug_printf("ssl_decrypt_record: allocating %d bytes for decrypt data (old len %d)\n",
-                inl + 32, out_str->data_len);
-        ssl_data_realloc(out_str, inl + 32);
+                alloc_len, out_str->data_len);
+        ssl_data_realloc(out_str, alloc_len);
     }
 
     /* AEAD ciphers (GenericAEADCipher in TLS 1.2; TLS 1.3) have no padding nor
@@ -5861,79 +5865,100 @@ tls13_key_update(SslDecryptSession *ssl, gboolean is_from_server)
 
 /** SSL keylog file handling. {{{ */
 
-static GRegex *
-ssl_compile_keyfile_regex(void)
-{
-#define OCTET "(?:[[:xdigit:]]{2})"
-    const gchar *pattern =
-        "(?:"
-        /* Matches Client Hellos having this Client Random */
-        "PMS_CLIENT_RANDOM (?<client_random_pms>" OCTET "{32}) "
-        /* Matches first part of encrypted RSA pre-master secret */
-        "|RSA (?<encrypted_pmk>" OCTET "{8}) "
-        /* Pre-Master-Secret is given, it is 48 bytes for RSA,
-           but it can be of any length for DHE */
-        ")(?<pms>" OCTET "+)"
-        "|(?:"
-        /* Matches Server Hellos having a Session ID */
-        "RSA Session-ID:(?<session_id>" OCTET "+) Master-Key:"
-        /* Matches Client Hellos having this Client Random */
-        "|CLIENT_RANDOM (?<client_random>" OCTET "{32}) "
-        /* Master-Secret is given, its length is fixed */
-        ")(?<master_secret>" OCTET "{" G_STRINGIFY(SSL_MASTER_SECRET_LENGTH) "})"
-        "|(?"
-        /* TLS 1.3 Client Random to Derived Secrets mapping. */
-        ":CLIENT_EARLY_TRAFFIC_SECRET (?<client_early>" OCTET "{32})"
-        "|CLIENT_HANDSHAKE_TRAFFIC_SECRET (?<client_handshake>" OCTET "{32})"
-        "|SERVER_HANDSHAKE_TRAFFIC_SECRET (?<server_handshake>" OCTET "{32})"
-        "|CLIENT_TRAFFIC_SECRET_0 (?<client_appdata>" OCTET "{32})"
-        "|SERVER_TRAFFIC_SECRET_0 (?<server_appdata>" OCTET "{32})"
-        "|EARLY_EXPORTER_SECRET (?<early_exporter>" OCTET "{32})"
-        "|EXPORTER_SECRET (?<exporter>" OCTET "{32})"
-        ") (?<derived_secret>" OCTET "+)";
-#undef OCTET
-    static GRegex *regex = NULL;
-    GError *gerr = NULL;
-
-    if (!regex) {
-        regex = g_regex_new(pattern,
-                (GRegexCompileFlags)(G_REGEX_OPTIMIZE | G_REGEX_ANCHORED | G_REGEX_RAW),
-                G_REGEX_MATCH_ANCHORED, &gerr);
-        if (gerr) {
-            ssl_debug_printf("%s failed to compile regex: %s\n", G_STRFUNC,
-                             gerr->message);
-            g_error_free(gerr);
-            regex = NULL;
+/*
+ * The key log formats.  Each line is a label, then a key in hex, then
+ * "key_end", then a secret in hex; with "octets" 0, any number of hex
+ * octets (at least one) is taken.  Anything after the secret is ignored.
+ */
+typedef struct {
+    const char *label;
+    const char *name;           /* for the debug log */
+    guint       key_octets;
+    const char *key_end;
+    guint       secret_octets;
+    size_t      map_offset;     /* of the GHashTable in ssl_master_key_map_t */
+} tls_keylog_format_t;
+
+static const tls_keylog_format_t tls_keylog_formats[] = {
+    { "PMS_CLIENT_RANDOM ", "client_random_pms", 32, " ", 0, offsetof(ssl_master_key_map_t, pms) },
+    { "RSA Session-ID:", "session_id", 0, " Master-Key:", SSL_MASTER_SECRET_LENGTH, offsetof(ssl_master_key_map_t, session) },
+    { "RSA ", "encrypted_pmk", 8, " ", 0, offsetof(ssl_master_key_map_t, pre_master) },
+    { "CLIENT_RANDOM ", "client_random", 32, " ", SSL_MASTER_SECRET_LENGTH, offsetof(ssl_master_key_map_t, crandom) },
+    /* TLS 1.3 map from Client Random to derived secret. */
+    { "CLIENT_EARLY_TRAFFIC_SECRET ", "client_early", 32, " ", 0, offsetof(ssl_master_key_map_t, tls13_client_early) },
+    { "CLIENT_HANDSHAKE_TRAFFIC_SECRET ", "client_handshake", 32, " ", 0, offsetof(ssl_master_key_map_t, tls13_client_handshake) },
+    { "SERVER_HANDSHAKE_TRAFFIC_SECRET ", "server_handshake", 32, " ", 0, offsetof(ssl_master_key_map_t, tls13_server_handshake) },
+    { "CLIENT_TRAFFIC_SECRET_0 ", "client_appdata", 32, " ", 0, offsetof(ssl_master_key_map_t, tls13_client_appdata) },
+    { "SERVER_TRAFFIC_SECRET_0 ", "server_appdata", 32, " ", 0, offsetof(ssl_master_key_map_t, tls13_server_appdata) },
+    { "EARLY_EXPORTER_SECRET ", "early_exporter", 32, " ", 0, offsetof(ssl_master_key_map_t, tls13_early_exporter) },
+    { "EXPORTER_SECRET ", "exporter", 32, " ", 0, offsetof(ssl_master_key_map_t, tls13_exporter) },
+};
+
+/* Number of hex digits at the start of [p, end). */
+static gsize
+tls_keylog_hex_len(const char *p, const char *end)
+{
+    const char *start = p;
+
+    while (p < end && g_ascii_isxdigit(*p))
+        p++;
+    return p - start;
+}
+
+/*
+ * Match a key log line against the formats.  Returns the format, and sets
+ * the hex key and secret, or returns NULL if the line isn't a key.
+ */
+static const tls_keylog_format_t *
+tls_keylog_parse_line(const char *line, gsize linelen,
+                      const char **key, gsize *key_len,
+                      const char **secret, gsize *secret_len)
+{
+    const char *end = line + linelen;
+
+    for (unsigned i = 0; i < G_N_ELEMENTS(tls_keylog_formats); i++) {
+        const tls_keylog_format_t *f = &tls_keylog_formats[i];
+        gsize label_len = strlen(f->label);
+        gsize key_end_len = strlen(f->key_end);
+        const char *p;
+        gsize len;
+
+        if (linelen < label_len || memcmp(line, f->label, label_len) != 0)
+            continue;
+
+        p = line + label_len;
+        len = tls_keylog_hex_len(p, end);
+        /* the key is followed by a separator, not more hex */
+        if (len < 2 || (len & 1) || (f->key_octets && len != 2 * f->key_octets))
+            continue;
+        if ((gsize)(end - (p + len)) < key_end_len || memcmp(p + len, f->key_end, key_end_len) != 0)
+            continue;
+        *key = p;
+        *key_len = len;
+
+        p += len + key_end_len;
+        len = tls_keylog_hex_len(p, end);
+        if (f->secret_octets) {
+            if (len < 2 * f->secret_octets)
+                continue;
+            len = 2 * f->secret_octets;
+        } else {
+            if (len < 2)
+                continue;
+            len &= ~(gsize)1;
         }
+        *secret = p;
+        *secret_len = len;
+        return f;
     }
 
-    return regex;
+    return NULL;
 }
 
-typedef struct ssl_master_key_match_group {
-    const char *re_group_name;
-    GHashTable *master_key_ht;
-} ssl_master_key_match_group_t;
-
 void
 tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data, guint datalen)
 {
-    ssl_master_key_match_group_t mk_groups[] = {
-        { "encrypted_pmk",  mk_map->pre_master },
-        { "session_id",     mk_map->session },
-        { "client_random",  mk_map->crandom },
-        { "client_random_pms",  mk_map->pms },
-        /* TLS 1.3 map from Client Random to derived secret. */
-        { "client_early",       mk_map->tls13_client_early },
-        { "client_handshake",   mk_map->tls13_client_handshake },
-        { "server_handshake",   mk_map->tls13_server_handshake },
-        { "client_appdata",     mk_map->tls13_client_appdata },
-        { "server_appdata",     mk_map->tls13_server_appdata },
-        { "early_exporter",     mk_map->tls13_early_exporter },
-        { "exporter",           mk_map->tls13_exporter },
-    };
-
-    /* The format of the file is a series of records with one of the following formats:
+        /* The format of the file is a series of records with one of the following formats:
      *   - "RSA xxxx yyyy"
      *     Where xxxx are the first 8 bytes of the encrypted pre-master secret (hex-encoded)
      *     Where yyyy is the cleartext pre-master secret (hex-encoded)
@@ -5971,10 +5996,6 @@ tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data,
      *     handshake or master secrets. (This format is introduced with TLS 1.3
      *     and supported by BoringSSL, OpenSSL, etc. See bug 12779.)
      */
-    GRegex *regex = ssl_compile_keyfile_regex();
-    if (!regex)
-        return;
-
     const char *next_line = (const char *)data;
     const char *line_end = next_line + datalen;
     while (next_line && next_line < line_end) {
@@ -5993,55 +6014,24 @@ tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data,
         }
 
         ssl_debug_printf("  checking keylog line: %.*s\n", (int)linelen, line);
-        GMatchInfo *mi;
-        if (g_regex_match_full(regex, line, linelen, 0, G_REGEX_MATCH_ANCHORED, &mi, NULL)) {
-            gchar *hex_key, *hex_pre_ms_or_ms;
+        const tls_keylog_format_t *format;
+        const char *hex_key, *hex_secret;
+        gsize hex_key_len, hex_secret_len;
+        format = tls_keylog_parse_line(line, linelen, &hex_key, &hex_key_len, &hex_secret, &hex_secret_len);
+        if (format) {
             StringInfo *key = wmem_new(wmem_file_scope(), StringInfo);
-            StringInfo *pre_ms_or_ms = NULL;
-            GHashTable *ht = NULL;
-
-            /* Is the PMS being supplied with the PMS_CLIENT_RANDOM
-             * otherwise we will use the Master Secret
-             */
-            hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "master_secret");
-            if (hex_pre_ms_or_ms == NULL || !*hex_pre_ms_or_ms) {
-                g_free(hex_pre_ms_or_ms);
-                hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "pms");
-            }
-            if (hex_pre_ms_or_ms == NULL || !*hex_pre_ms_or_ms) {
-                g_free(hex_pre_ms_or_ms);
-                hex_pre_ms_or_ms = g_match_info_fetch_named(mi, "derived_secret");
-            }
-            /* There is always a match, otherwise the regex is wrong. */
-            DISSECTOR_ASSERT(hex_pre_ms_or_ms && strlen(hex_pre_ms_or_ms));
+            StringInfo *pre_ms_or_ms = wmem_new(wmem_file_scope(), StringInfo);
+            GHashTable *ht = *(GHashTable * const *)((const char *)mk_map + format->map_offset);
 
+            ssl_debug_printf("    matched %s\n", format->name);
             /* convert from hex to bytes and save to hashtable */
-            pre_ms_or_ms = wmem_new(wmem_file_scope(), StringInfo);
-            from_hex(pre_ms_or_ms, hex_pre_ms_or_ms, strlen(hex_pre_ms_or_ms));
-            g_free(hex_pre_ms_or_ms);
-
-            /* Find a master key from any format (CLIENT_RANDOM, SID, ...) */
-            for (unsigned i = 0; i < G_N_ELEMENTS(mk_groups); i++) {
-                ssl_master_key_match_group_t *g = &mk_groups[i];
-                hex_key = g_match_info_fetch_named(mi, g->re_group_name);
-                if (hex_key && *hex_key) {
-                    ssl_debug_printf("    matched %s\n", g->re_group_name);
-                    ht = g->master_key_ht;
-                    from_hex(key, hex_key, strlen(hex_key));
-                    g_free(hex_key);
-                    break;
-                }
-                g_free(hex_key);
-            }
-            DISSECTOR_ASSERT(ht); /* Cannot be reached, or regex is wrong. */
-
+            from_hex(key, hex_key, hex_key_len);
+            from_hex(pre_ms_or_ms, hex_secret, hex_secret_len);
             g_hash_table_insert(ht, key, pre_ms_or_ms);
 
         } else if (linelen > 0 && line[0] != '#') {
             ssl_debug_printf("    unrecognized line\n");
         }
-        /* always free match info even if there is no match. */
-        g_match_info_free(mi);
     }
 }
 
@@ -6056,11 +6046,6 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
         return;
     }
 
-    /* Validate regexes before even trying to use it. */
-    if (!ssl_compile_keyfile_regex()) {
-        return;
-    }
-
     ssl_debug_printf("trying to use TLS keylog in %s\n", tls_keylog_filename);
 
     /* if the keylog file was deleted/overwritten, re-open it */
@@ -6071,15 +6056,21 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
     }
 
     if (*keylog_file == NULL) {
-        *keylog_file = ws_fopen(tls_keylog_filename, "r");
+        /* binary, so that we can seek back over a partial line */
+        *keylog_file = ws_fopen(tls_keylog_filename, "rb");
         if (!*keylog_file) {
             ssl_debug_printf("%s failed to open SSL keylog\n", G_STRFUNC);
             return;
         }
     }
 
+    /*
+     * Carry on from where the last call stopped, so that only lines
+     * appended since then are parsed.
+     */
     for (;;) {
         char buf[1110], *line;
+        size_t len;
         line = fgets(buf, sizeof(buf), *keylog_file);
         if (!line) {
             if (feof(*keylog_file)) {
@@ -6092,7 +6083,18 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
             }
             break;
         }
-        tls_keylog_process_lines(mk_map, (guint8 *)line, (int)strlen(line));
+        len = strlen(line);
+        if (len < sizeof(buf) - 1 && line[len - 1] != '\n' && feof(*keylog_file)) {
+            /*
+             * The last line is still being written; leave it to read
+             * whole next time.
+             */
+            if (fseek(*keylog_file, -(long)len, SEEK_CUR) == 0) {
+                clearerr(*keylog_file);
+                break;
+            }
+        }
+        tls_keylog_process_lines(mk_map, (guint8 *)line, (int)len);
     }
 }
 /** SSL keylog file handling. }}} */
@@ -21,6 +21,7 @@
 
 #include <version_info.h>
 #include <wsutil/report_message.h>
+#include <wsutil/startup_profile.h>
 
 #include <epan/exceptions.h>
 
@@ -35,6 +36,7 @@
 #include "conversation.h"
 #include "except.h"
 #include "packet.h"
+#include "proto_data.h"
 #include "prefs.h"
 #include "column-utils.h"
 #include "tap.h"
@@ -57,6 +59,7 @@
 #include "stats_tree.h"
 #include "secrets.h"
 #include "funnel.h"
+#include "app_mem_usage.h"
 #include <dtd.h>
 
 #ifdef HAVE_PLUGINS
@@ -201,6 +204,29 @@ int epan_plugins_supported(void)
 #endif
 }
 
+static gsize
+epan_wmem_stats_fetch(wmem_allocator_t *allocator)
+{
+	const wmem_stats_t *stats = wmem_stats_get(allocator);
+
+	return stats ? (gsize)stats->bytes : 0;
+}
+
+static gsize
+epan_wmem_epan_scope_fetch(void)
+{
+	return epan_wmem_stats_fetch(wmem_epan_scope());
+}
+
+static gsize
+epan_wmem_file_scope_fetch(void)
+{
+	return epan_wmem_stats_fetch(wmem_file_scope());
+}
+
+static const ws_mem_usage_t wmem_epan_scope_usage = { "wmem epan scope", epan_wmem_epan_scope_fetch, NULL };
+static const ws_mem_usage_t wmem_file_scope_usage = { "wmem file scope", epan_wmem_file_scope_fetch, NULL };
+
 static void epan_plugin_register_all_tap_listeners(gpointer data, gpointer user_data _U_)
 {
 	epan_plugin *plug = (epan_plugin *)data;
@@ -212,6 +238,8 @@ gboolean
 epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 {
 	volatile gboolean status = TRUE;
+	guint profile_phase = startup_profile_begin("epan_init");
+	volatile guint profile_subphase;
 
 	/* Get the value of some environment variables and set corresponding globals for performance reasons*/
 	/* If the WIRESHARK_ABORT_ON_DISSECTOR_BUG environment variable is set,
@@ -239,6 +267,12 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 	/* initialize memory allocation subsystem */
 	wmem_init();
 
+	/* report the wmem scopes in the memory usage if their sizes are known */
+	if (wmem_stats_enabled()) {
+		memory_usage_component_register(&wmem_epan_scope_usage);
+		memory_usage_component_register(&wmem_file_scope_usage);
+	}
+
 	/* initialize the GUID to name mapping table */
 	guids_init();
 
@@ -249,10 +283,13 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 
 	if (load_plugins) {
 #ifdef HAVE_PLUGINS
+		profile_subphase = startup_profile_begin("load_plugins");
 		libwireshark_plugins = plugins_init(WS_PLUGIN_EPAN);
+		startup_profile_end(profile_subphase);
 #endif
 	}
 
+	profile_subphase = startup_profile_begin("library_init");
 	/* initialize libgcrypt (beware, it won't be thread-safe) */
 	gcry_check_version(NULL);
 #if defined(_WIN32)
@@ -272,8 +309,10 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 	// We might receive a SIGPIPE due to maxmind_db.
 	signal(SIGPIPE, SIG_IGN);
 #endif
+	startup_profile_end(profile_subphase);
 
 	TRY {
+		profile_subphase = startup_profile_begin("core_init");
 		tap_init();
 		prefs_init();
 		expert_init();
@@ -283,16 +322,21 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 		capture_dissector_init();
 		reassembly_tables_init();
 		g_slist_foreach(epan_plugins, epan_plugin_init, NULL);
+		startup_profile_end(profile_subphase);
 		proto_init(epan_plugin_register_all_procotols, epan_plugin_register_all_handoffs, cb, client_data);
 		g_slist_foreach(epan_plugins, epan_plugin_register_all_tap_listeners, NULL);
+		profile_subphase = startup_profile_begin("final_registration");
 		packet_cache_proto_handles();
 		dfilter_init();
 		final_registration_all_protocols();
 		print_cache_field_handles();
 		expert_packet_init();
 		export_pdu_init();
+		startup_profile_end(profile_subphase);
 #ifdef HAVE_LUA
+		profile_subphase = startup_profile_begin("wslua_init");
 		wslua_init(cb, client_data);
+		startup_profile_end(profile_subphase);
 #endif
 	}
 	CATCH(DissectorError) {
@@ -314,6 +358,7 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 		status = FALSE;
 	}
 	ENDTRY;
+	startup_profile_end(profile_phase);
 	return status;
 }
 
@@ -324,18 +369,27 @@ e_prefs *
 epan_load_settings(void)
 {
 	e_prefs *prefs_p;
+	guint profile_phase = startup_profile_begin("epan_load_settings");
+	guint profile_subphase;
 
 	/* load the decode as entries of the current profile */
+	profile_subphase = startup_profile_begin("load_decode_as_entries");
 	load_decode_as_entries();
+	startup_profile_end(profile_subphase);
 
+	profile_subphase = startup_profile_begin("read_prefs");
 	prefs_p = read_prefs();
+	startup_profile_end(profile_subphase);
 
 	/*
 	 * Read the files that enable and disable protocols and heuristic
 	 * dissectors.
 	 */
+	profile_subphase = startup_profile_begin("read_enabled_and_disabled_lists");
 	read_enabled_and_disabled_lists();
+	startup_profile_end(profile_subphase);
 
+	startup_profile_end(profile_phase);
 	return prefs_p;
 }
 
@@ -530,6 +584,7 @@ epan_dissect_init(epan_dissect_t *edt, epan_t *session, const gboolean create_pr
 	}
 
 	edt->tvb = NULL;
+	edt->frame_only = FALSE;
 
 	g_slist_foreach(epan_plugins, epan_plugin_dissect_init, edt);
 }
@@ -542,7 +597,6 @@ epan_dissect_reset(epan_dissect_t *edt)
 
 	g_assert(edt);
 
-	g_slist_free(edt->pi.proto_data);
 	g_slist_free(edt->pi.dependent_frames);
 
 	/* Free the data sources list. */
@@ -582,6 +636,13 @@ epan_dissect_fake_protocols(epan_dissect_t *edt, const gboolean fake_protocols)
 		proto_tree_set_fake_protocols(edt->tree, fake_protocols);
 }
 
+void
+epan_dissect_set_frame_only(epan_dissect_t *edt, const gboolean frame_only)
+{
+	if (edt)
+		edt->frame_only = frame_only;
+}
+
 void
 epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, tvbuff_t *tvb, frame_data *fd,
@@ -645,7 +706,6 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 
 	g_slist_foreach(epan_plugins, epan_plugin_dissect_cleanup, edt);
 
-	g_slist_free(edt->pi.proto_data);
 	g_slist_free(edt->pi.dependent_frames);
 
 	/* Free the data sources list. */
@@ -815,6 +875,14 @@ epan_get_compiled_version_info(GString *str)
 	g_string_append(str, "without brotli");
 #endif /* HAVE_BROTLI */
 
+	/* Apache Arrow */
+	g_string_append(str, ", ");
+#ifdef HAVE_ARROW
+	g_string_append(str, "with Apache Arrow");
+#else
+	g_string_append(str, "without Apache Arrow");
+#endif /* HAVE_ARROW */
+
 	/* LZ4 */
 	g_string_append(str, ", ");
 #ifdef HAVE_LZ4
@@ -202,6 +202,14 @@ WS_DLL_PUBLIC
 void
 epan_dissect_fake_protocols(epan_dissect_t *edt, const gboolean fake_protocols);
 
+/** Indicate whether only the frame metadata should be dissected, without
+ * calling the dissector for the packet's encapsulation, postdissectors or
+ * coloring rules. Only useful when all the fields wanted from the tree
+ * are frame fields, e.g. see dfilter_is_frame_only(). */
+WS_DLL_PUBLIC
+void
+epan_dissect_set_frame_only(epan_dissect_t *edt, const gboolean frame_only);
+
 /** run a single packet dissection */
 WS_DLL_PUBLIC
 void
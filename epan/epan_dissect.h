@@ -30,6 +30,7 @@ struct epan_dissect {
 	tvbuff_t	*tvb;
 	proto_tree	*tree;
 	packet_info	pi;
+	gboolean	frame_only;
 };
 
 #ifdef __cplusplus
@@ -216,6 +216,52 @@ exp_pdu_data_item_t exp_pdu_data_src_port = {exp_pdu_data_port_size, exp_pdu_dat
 exp_pdu_data_item_t exp_pdu_data_dst_port = {exp_pdu_data_port_size, exp_pdu_data_dst_port_populate_data, NULL};
 exp_pdu_data_item_t exp_pdu_data_orig_frame_num = {exp_pdu_data_orig_frame_num_size, exp_pdu_data_orig_frame_num_populate_data, NULL};
 
+/*
+ * The common tags of the PDUs of a conversation differ only in the original
+ * frame number, which is the last item, so they are kept for each protocol
+ * and conversation and only the frame number is filled in again. The cache
+ * is direct-mapped; a conversation replaces whichever one was in its slot.
+ */
+#define EXP_PDU_COMMON_TAGS_CACHE_SIZE	256
+
+typedef struct _exp_pdu_common_tags_t {
+	gchar		*proto_name;	/* NULL if the slot is unused */
+	guint16		tag_type;
+	address		src;
+	address		dst;
+	port_type	ptype;
+	guint32		srcport;
+	guint32		destport;
+	guint8		*tlv_buffer;
+	guint		tlv_buffer_len;
+} exp_pdu_common_tags_t;
+
+static exp_pdu_common_tags_t *common_tags_cache = NULL;
+
+static void
+common_tags_clear(exp_pdu_common_tags_t *entry)
+{
+	g_free(entry->proto_name);
+	entry->proto_name = NULL;
+	free_address(&entry->src);
+	free_address(&entry->dst);
+	wmem_free(NULL, entry->tlv_buffer);
+	entry->tlv_buffer = NULL;
+}
+
+static gboolean
+common_tags_match(const exp_pdu_common_tags_t *entry, packet_info *pinfo, const char *proto_name, guint16 tag_type)
+{
+	return entry->proto_name != NULL &&
+		entry->tag_type == tag_type &&
+		entry->ptype == pinfo->ptype &&
+		entry->srcport == pinfo->srcport &&
+		entry->destport == pinfo->destport &&
+		addresses_equal(&entry->src, &pinfo->net_src) &&
+		addresses_equal(&entry->dst, &pinfo->net_dst) &&
+		strcmp(entry->proto_name, proto_name) == 0;
+}
+
 exp_pdu_data_t *export_pdu_create_common_tags(packet_info *pinfo, const char *proto_name, guint16 tag_type)
 {
 	const exp_pdu_data_item_t *common_exp_pdu_items[] = {
@@ -227,8 +273,52 @@ exp_pdu_data_t *export_pdu_create_common_tags(packet_info *pinfo, const char *pr
 		&exp_pdu_data_orig_frame_num,
 		NULL
 	};
+	exp_pdu_common_tags_t *entry;
+	exp_pdu_data_t *exp_pdu_data;
+	guint8 *fno;
+	guint hash;
+
+	DISSECTOR_ASSERT(proto_name != NULL);
 
-	return export_pdu_create_tags(pinfo, proto_name, tag_type, common_exp_pdu_items);
+	if (common_tags_cache == NULL) {
+		common_tags_cache = g_new0(exp_pdu_common_tags_t, EXP_PDU_COMMON_TAGS_CACHE_SIZE);
+	}
+
+	hash = g_str_hash(proto_name) ^ tag_type;
+	hash = add_address_to_hash(hash, &pinfo->net_src);
+	hash = add_address_to_hash(hash, &pinfo->net_dst);
+	hash ^= (pinfo->srcport << 16) ^ pinfo->destport ^ ((guint)pinfo->ptype << 8);
+	hash ^= hash >> 16;
+	entry = &common_tags_cache[hash % EXP_PDU_COMMON_TAGS_CACHE_SIZE];
+
+	if (!common_tags_match(entry, pinfo, proto_name, tag_type)) {
+		exp_pdu_data = export_pdu_create_tags(pinfo, proto_name, tag_type, common_exp_pdu_items);
+
+		common_tags_clear(entry);
+		entry->proto_name = g_strdup(proto_name);
+		entry->tag_type = tag_type;
+		copy_address(&entry->src, &pinfo->net_src);
+		copy_address(&entry->dst, &pinfo->net_dst);
+		entry->ptype = pinfo->ptype;
+		entry->srcport = pinfo->srcport;
+		entry->destport = pinfo->destport;
+		entry->tlv_buffer = (guint8 *)wmem_memdup(NULL, exp_pdu_data->tlv_buffer, exp_pdu_data->tlv_buffer_len);
+		entry->tlv_buffer_len = exp_pdu_data->tlv_buffer_len;
+		return exp_pdu_data;
+	}
+
+	exp_pdu_data = wmem_new(wmem_packet_scope(), exp_pdu_data_t);
+	exp_pdu_data->tlv_buffer = (guint8 *)wmem_memdup(wmem_packet_scope(), entry->tlv_buffer, entry->tlv_buffer_len);
+	exp_pdu_data->tlv_buffer_len = entry->tlv_buffer_len;
+
+	/* The frame number comes just before the end of options. */
+	fno = exp_pdu_data->tlv_buffer + exp_pdu_data->tlv_buffer_len - 4 - EXP_PDU_TAG_ORIG_FNO_LEN;
+	fno[0] = (pinfo->num & 0xff000000) >> 24;
+	fno[1] = (pinfo->num & 0x00ff0000) >> 16;
+	fno[2] = (pinfo->num & 0x0000ff00) >> 8;
+	fno[3] = (pinfo->num & 0x000000ff);
+
+	return exp_pdu_data;
 }
 
 /**
@@ -322,7 +412,17 @@ void export_pdu_init(void)
 
 void export_pdu_cleanup(void)
 {
+	int i;
+
 	g_slist_free_full(export_pdu_tap_name_list, g_free);
+
+	if (common_tags_cache) {
+		for (i = 0; i < EXP_PDU_COMMON_TAGS_CACHE_SIZE; i++) {
+			common_tags_clear(&common_tags_cache[i]);
+		}
+		g_free(common_tags_cache);
+		common_tags_cache = NULL;
+	}
 }
 
 /*
@@ -210,6 +210,164 @@ follow_tvb_tap_listener(void *tapdata, packet_info *pinfo,
     return TAP_PACKET_DONT_REDRAW;
 }
 
+typedef struct {
+    guint64 key;            /* stream << 32 | sub_stream */
+    guint stream;
+    guint sub_stream;
+    follow_info_t *follow_info;
+    GList *counted;         /* newest payload entry already in "buffered" */
+    guint buffered;         /* payload bytes not yet written */
+} follow_multi_stream_t;
+
+struct _follow_multi {
+    register_follow_t *follower;
+    guint max_buffered;
+    follow_multi_write_func write_func;
+    void *user_data;
+    GHashTable *stream_table;   /* key -> follow_multi_stream_t */
+    GPtrArray *streams;         /* follow_multi_stream_t, in order of appearance */
+};
+
+follow_multi_t *
+follow_multi_new(register_follow_t *follower, guint max_buffered,
+                 follow_multi_write_func write_func, void *user_data)
+{
+    follow_multi_t *multi = g_new0(follow_multi_t, 1);
+
+    multi->follower = follower;
+    multi->max_buffered = max_buffered;
+    multi->write_func = write_func;
+    multi->user_data = user_data;
+    multi->stream_table = g_hash_table_new(g_int64_hash, g_int64_equal);
+    multi->streams = g_ptr_array_new();
+    return multi;
+}
+
+static void
+follow_multi_flush_stream(follow_multi_t *multi, follow_multi_stream_t *entry)
+{
+    follow_info_t *follow_info = entry->follow_info;
+    GList *records, *cur;
+
+    if (follow_info->payload == NULL)
+        return;
+
+    records = g_list_reverse(follow_info->payload);
+    follow_info->payload = NULL;
+    entry->counted = NULL;
+    entry->buffered = 0;
+
+    multi->write_func(entry->stream, entry->sub_stream, follow_info, records, multi->user_data);
+
+    for (cur = records; cur; cur = g_list_next(cur)) {
+        follow_record_t *follow_record = (follow_record_t *)cur->data;
+
+        g_byte_array_free(follow_record->data, TRUE);
+        g_free(follow_record);
+    }
+    g_list_free(records);
+}
+
+static tap_packet_status
+follow_multi_tap_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data)
+{
+    follow_multi_t *multi = (follow_multi_t *)tapdata;
+    follow_multi_stream_t *entry;
+    guint stream = 0, sub_stream = 0;
+    guint64 key;
+    gchar *filter;
+    GList *cur;
+
+    /* The conversation filter is the only per-follower way of telling
+     * which stream a packet belongs to. */
+    filter = multi->follower->conv_filter(edt, pinfo, &stream, &sub_stream);
+    if (filter == NULL)
+        return TAP_PACKET_DONT_REDRAW;
+
+    key = ((guint64)stream << 32) | sub_stream;
+    entry = (follow_multi_stream_t *)g_hash_table_lookup(multi->stream_table, &key);
+    if (entry == NULL) {
+        entry = g_new0(follow_multi_stream_t, 1);
+        entry->key = key;
+        entry->stream = stream;
+        entry->sub_stream = sub_stream;
+        entry->follow_info = g_new0(follow_info_t, 1);
+        entry->follow_info->filter_out_filter = filter;
+        filter = NULL;
+        g_hash_table_insert(multi->stream_table, &entry->key, entry);
+        g_ptr_array_add(multi->streams, entry);
+    }
+    g_free(filter);
+
+    multi->follower->tap_handler(entry->follow_info, pinfo, edt, data);
+
+    /* New records are prepended; count the ones added by this packet. */
+    for (cur = entry->follow_info->payload; cur != entry->counted; cur = g_list_next(cur))
+        entry->buffered += ((follow_record_t *)cur->data)->data->len;
+    entry->counted = entry->follow_info->payload;
+
+    if (entry->buffered > multi->max_buffered)
+        follow_multi_flush_stream(multi, entry);
+
+    return TAP_PACKET_DONT_REDRAW;
+}
+
+GString *
+follow_multi_register_tap_listener(follow_multi_t *multi, const char *filter,
+                                   tap_draw_cb draw_cb, tap_finish_cb finish_cb)
+{
+    return register_tap_listener(multi->follower->tap_listen_str, multi, filter, 0,
+                                 NULL, follow_multi_tap_packet, draw_cb, finish_cb);
+}
+
+void
+follow_multi_flush(follow_multi_t *multi)
+{
+    guint i;
+
+    for (i = 0; i < multi->streams->len; i++)
+        follow_multi_flush_stream(multi, (follow_multi_stream_t *)g_ptr_array_index(multi->streams, i));
+}
+
+guint
+follow_multi_num_streams(follow_multi_t *multi)
+{
+    return multi->streams->len;
+}
+
+void *
+follow_multi_get_user_data(follow_multi_t *multi)
+{
+    return multi->user_data;
+}
+
+follow_info_t *
+follow_multi_get_stream(follow_multi_t *multi, guint idx, guint *stream, guint *sub_stream)
+{
+    follow_multi_stream_t *entry = (follow_multi_stream_t *)g_ptr_array_index(multi->streams, idx);
+
+    *stream = entry->stream;
+    *sub_stream = entry->sub_stream;
+    return entry->follow_info;
+}
+
+void
+follow_multi_free(follow_multi_t *multi)
+{
+    guint i;
+
+    for (i = 0; i < multi->streams->len; i++) {
+        follow_multi_stream_t *entry = (follow_multi_stream_t *)g_ptr_array_index(multi->streams, i);
+
+        multi->write_func(entry->stream, entry->sub_stream, entry->follow_info, NULL, multi->user_data);
+        follow_info_free(entry->follow_info);
+        g_free(entry);
+    }
+    g_ptr_array_free(multi->streams, TRUE);
+    g_hash_table_destroy(multi->stream_table);
+    g_free(multi);
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -203,6 +203,85 @@ WS_DLL_PUBLIC void follow_reset_stream(follow_info_t* info);
  */
 WS_DLL_PUBLIC void follow_info_free(follow_info_t* follow_info);
 
+/*
+ * Following every stream of a follower at once.
+ *
+ * A follow_multi_t is a single tap listener that keeps a follow_info_t
+ * for each stream it sees, rather than for one stream chosen beforehand.
+ * Once more than "max_buffered" bytes of a stream's payload are held, they
+ * are handed to the write function and freed, so memory use depends on
+ * the number of streams, not on their length.
+ */
+typedef struct _follow_multi follow_multi_t;
+
+/** Called with the payload of one stream, oldest chunk first. Called a last
+ * time with NULL records when the stream is freed, so that anything hung
+ * off follow_info->gui_data can be released.
+ *
+ * @param stream [in] stream index
+ * @param sub_stream [in] sub-stream index (HTTP/2 and QUIC), otherwise 0
+ * @param follow_info [in] the stream's follower info
+ * @param records [in] "follow_record_t" entries, freed after the call
+ * @param user_data [in] as given to follow_multi_new()
+ */
+typedef void (*follow_multi_write_func)(guint stream, guint sub_stream, follow_info_t *follow_info, GList *records, void *user_data);
+
+/** Create a follow_multi_t
+ *
+ * @param follower [in] Registered follower
+ * @param max_buffered [in] payload bytes held per stream before writing
+ * @param write_func [in] receives the payload
+ * @param user_data [in] passed to write_func
+ * @return a new follow_multi_t, to be freed with follow_multi_free()
+ */
+WS_DLL_PUBLIC follow_multi_t *follow_multi_new(register_follow_t *follower, guint max_buffered,
+                                               follow_multi_write_func write_func, void *user_data);
+
+/** Register the tap listener of a follow_multi_t. The tap data passed to
+ * draw_cb and finish_cb is the follow_multi_t.
+ *
+ * @param multi [in] follow_multi_t
+ * @param filter [in] display filter selecting the packets (and so the streams) to follow, or NULL
+ * @return NULL on success, otherwise an error string as returned by register_tap_listener()
+ */
+WS_DLL_PUBLIC GString *follow_multi_register_tap_listener(follow_multi_t *multi, const char *filter,
+                                                         tap_draw_cb draw_cb, tap_finish_cb finish_cb);
+
+/** Write out the payload that is still held for every stream.
+ *
+ * @param multi [in] follow_multi_t
+ */
+WS_DLL_PUBLIC void follow_multi_flush(follow_multi_t *multi);
+
+/** The number of streams seen so far
+ *
+ * @param multi [in] follow_multi_t
+ */
+WS_DLL_PUBLIC guint follow_multi_num_streams(follow_multi_t *multi);
+
+/** The user_data given to follow_multi_new()
+ *
+ * @param multi [in] follow_multi_t
+ */
+WS_DLL_PUBLIC void *follow_multi_get_user_data(follow_multi_t *multi);
+
+/** Get a stream, in the order they were first seen
+ *
+ * @param multi [in] follow_multi_t
+ * @param idx [in] 0 to follow_multi_num_streams() - 1
+ * @param stream [out] stream index
+ * @param sub_stream [out] sub-stream index
+ * @return the stream's follower info
+ */
+WS_DLL_PUBLIC follow_info_t *follow_multi_get_stream(follow_multi_t *multi, guint idx, guint *stream, guint *sub_stream);
+
+/** Free a follow_multi_t. Payload that hasn't been flushed is discarded.
+ * The tap listener, if registered, must have been removed already.
+ *
+ * @param multi [in] follow_multi_t
+ */
+WS_DLL_PUBLIC void follow_multi_free(follow_multi_t *multi);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -16,9 +16,59 @@
 #include <epan/epan.h>
 #include <wiretap/wtap.h>
 #include <epan/frame_data.h>
+#include <epan/proto_data.h>
 #include <epan/column-utils.h>
 #include <epan/timestamp.h>
 
+/*
+ * Time shift offsets of the frames that have one, keyed by frame_data
+ * pointer.  Shifting is rare, so this saves an nstime_t in every frame.
+ * Most shifts move all frames by the same amount, so frames with the
+ * same offset share one reference counted copy of it, kept in
+ * shift_offset_values, rather than allocating one each.
+ */
+static GHashTable *shift_offsets = NULL;
+static GHashTable *shift_offset_values = NULL;
+
+typedef struct {
+  nstime_t offset;      /* first, so that it's the key in shift_offset_values */
+  guint    refs;
+} shift_offset_t;
+
+static guint
+shift_offset_hash(gconstpointer key)
+{
+  const nstime_t *offset = (const nstime_t *)key;
+
+  return (guint)offset->secs ^ (guint)offset->nsecs;
+}
+
+static gboolean
+shift_offset_equal(gconstpointer key1, gconstpointer key2)
+{
+  return nstime_cmp((const nstime_t *)key1, (const nstime_t *)key2) == 0;
+}
+
+static void
+shift_offset_unref(shift_offset_t *so)
+{
+  if (--so->refs == 0)
+    g_hash_table_remove(shift_offset_values, &so->offset);
+}
+
+static void
+frame_data_remove_shift_offset(frame_data *fdata)
+{
+  shift_offset_t *so;
+
+  so = (shift_offset_t *)g_hash_table_lookup(shift_offsets, fdata);
+  if (so) {
+    g_hash_table_remove(shift_offsets, fdata);
+    shift_offset_unref(so);
+  }
+  fdata->has_shift_offset = 0;
+}
+
 #define COMPARE_FRAME_NUM()     ((fdata1->num < fdata2->num) ? -1 : \
                                  (fdata1->num > fdata2->num) ? 1 : \
                                  0)
@@ -211,8 +261,7 @@ frame_data_init(frame_data *fdata, guint32 num, const wtap_rec *rec,
   fdata->has_user_comment = 0;
   fdata->need_colorize = 0;
   fdata->color_filter = NULL;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
+  fdata->has_shift_offset = 0;
   fdata->frame_ref_num = 0;
   fdata->prev_dis_num = 0;
 }
@@ -274,7 +323,7 @@ frame_data_reset(frame_data *fdata)
   fdata->subnum = 0;
 
   if (fdata->pfd) {
-    g_slist_free(fdata->pfd);
+    p_free_proto_data_list(fdata->pfd);
     fdata->pfd = NULL;
   }
 }
@@ -283,9 +332,59 @@ void
 frame_data_destroy(frame_data *fdata)
 {
   if (fdata->pfd) {
-    g_slist_free(fdata->pfd);
+    p_free_proto_data_list(fdata->pfd);
     fdata->pfd = NULL;
   }
+
+  if (fdata->has_shift_offset)
+    frame_data_remove_shift_offset(fdata);
+}
+
+void
+frame_data_get_shift_offset(const frame_data *fdata, nstime_t *shift_offset)
+{
+  const shift_offset_t *so;
+
+  if (fdata->has_shift_offset &&
+      (so = (const shift_offset_t *)g_hash_table_lookup(shift_offsets, fdata)) != NULL) {
+    nstime_copy(shift_offset, &so->offset);
+  } else {
+    nstime_set_zero(shift_offset);
+  }
+}
+
+void
+frame_data_set_shift_offset(frame_data *fdata, const nstime_t *shift_offset)
+{
+  shift_offset_t *so;
+  shift_offset_t *old_so = NULL;
+
+  if (shift_offset->secs == 0 && shift_offset->nsecs == 0) {
+    if (fdata->has_shift_offset)
+      frame_data_remove_shift_offset(fdata);
+    return;
+  }
+
+  if (shift_offsets == NULL) {
+    shift_offsets = g_hash_table_new(g_direct_hash, g_direct_equal);
+    shift_offset_values = g_hash_table_new_full(shift_offset_hash, shift_offset_equal, NULL, g_free);
+  }
+
+  so = (shift_offset_t *)g_hash_table_lookup(shift_offset_values, shift_offset);
+  if (so == NULL) {
+    so = g_new(shift_offset_t, 1);
+    nstime_copy(&so->offset, shift_offset);
+    so->refs = 0;
+    g_hash_table_insert(shift_offset_values, &so->offset, so);
+  }
+  so->refs++;
+
+  if (fdata->has_shift_offset)
+    old_so = (shift_offset_t *)g_hash_table_lookup(shift_offsets, fdata);
+  g_hash_table_insert(shift_offsets, fdata, so);
+  fdata->has_shift_offset = 1;
+  if (old_so)
+    shift_offset_unref(old_so);
 }
 
 /*
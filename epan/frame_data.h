@@ -23,6 +23,7 @@ extern "C" {
 
 struct _packet_info;
 struct epan_session;
+struct _proto_data_list;
 
 #define PINFO_FD_VISITED(pinfo)   ((pinfo)->fd->visited)
 
@@ -70,7 +71,7 @@ typedef struct _frame_data {
   /* These two are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
      LLP64 (64-bit Windows) platforms.  Put them here, one after the
      other, so they don't require padding between them. */
-  GSList      *pfd;          /**< Per frame proto data */
+  struct _proto_data_list *pfd; /**< Per frame proto data */
   const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
   guint16      subnum;       /**< subframe number, for protocols that require this */
   /* Keep the bitfields below to 16 bits, so this plus the previous field
@@ -88,8 +89,8 @@ typedef struct _frame_data {
   unsigned int has_user_comment : 1; /** 1 = user set (also deleted) comment for this packet */
   unsigned int need_colorize    : 1; /**< 1 = need to (re-)calculate packet color */
   unsigned int tsprec           : 4; /**< Time stamp precision -2^tsprec gives up to femtoseconds */
+  unsigned int has_shift_offset : 1; /**< 1 = abs_ts is shifted; see frame_data_get_shift_offset() */
   nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
   guint32      frame_ref_num; /**< Previous reference frame (0 if this is one) */
   guint32      prev_dis_num; /**< Previous displayed frame (0 if first one) */
 } frame_data;
@@ -119,6 +120,21 @@ WS_DLL_PUBLIC void frame_data_set_before_dissect(frame_data *fdata,
 WS_DLL_PUBLIC void frame_data_set_after_dissect(frame_data *fdata,
                 guint32 *cum_bytes);
 
+/**
+ * Gets how much the time stamp of a frame has been shifted.  Few frames
+ * are ever shifted, so the offsets are kept in a side table rather than
+ * in every frame_data.
+ */
+WS_DLL_PUBLIC void frame_data_get_shift_offset(const frame_data *fdata,
+                nstime_t *shift_offset);
+
+/**
+ * Sets how much the time stamp of a frame has been shifted.  This doesn't
+ * change abs_ts itself.
+ */
+WS_DLL_PUBLIC void frame_data_set_shift_offset(frame_data *fdata,
+                const nstime_t *shift_offset);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -18,16 +18,41 @@
 
 #define CMP_MATCHES cmp_matches
 
+/*
+ * Fixed-length addresses set from packet data are kept in the fvalue
+ * itself rather than in a GByteArray, so that adding one to the tree
+ * doesn't allocate anything.  Values parsed from a filter can be shorter
+ * than the address and are still kept in a GByteArray.
+ */
+#define bytes_are_fixed	fvalue_gboolean1
+
+static inline const guint8 *
+fv_bytes_data(const fvalue_t *fv)
+{
+	return fv->bytes_are_fixed ? fv->value.fixed_bytes.data : fv->value.bytes->data;
+}
+
+static inline guint
+fv_bytes_len(const fvalue_t *fv)
+{
+	return fv->bytes_are_fixed ? fv->value.fixed_bytes.len : fv->value.bytes->len;
+}
+
 static void
 bytes_fvalue_new(fvalue_t *fv)
 {
 	fv->value.bytes = NULL;
+	fv->bytes_are_fixed = FALSE;
 }
 
 static void
 bytes_fvalue_free(fvalue_t *fv)
 {
-	if (fv->value.bytes) {
+	if (fv->bytes_are_fixed) {
+		fv->bytes_are_fixed = FALSE;
+		fv->value.bytes = NULL;
+	}
+	else if (fv->value.bytes) {
 		g_byte_array_free(fv->value.bytes, TRUE);
 		fv->value.bytes=NULL;
 	}
@@ -46,14 +71,14 @@ bytes_fvalue_set(fvalue_t *fv, GByteArray *value)
 static int
 bytes_repr_len(fvalue_t *fv, ftrepr_t rtype, int field_display _U_)
 {
-	if (fv->value.bytes->len == 0) {
+	if (fv_bytes_len(fv) == 0) {
 		/* An empty array of bytes is represented as "" in a
 		   display filter and as an empty string otherwise. */
 		return (rtype == FTREPR_DFILTER) ? 2 : 0;
 	} else {
 		/* 3 bytes for each byte of the byte "NN<separator character>" minus 1 byte
 		 * as there's no trailing "<separator character>". */
-		return fv->value.bytes->len * 3 - 1;
+		return fv_bytes_len(fv) * 3 - 1;
 	}
 }
 
@@ -146,8 +171,8 @@ bytes_to_repr(fvalue_t *fv, ftrepr_t rtype, int field_display, char *buf, unsign
 		break;
 	}
 
-	if (fv->value.bytes->len) {
-		buf = bytes_to_hexstr_punct(buf, fv->value.bytes->data, fv->value.bytes->len, separator);
+	if (fv_bytes_len(fv)) {
+		buf = bytes_to_hexstr_punct(buf, fv_bytes_data(fv), fv_bytes_len(fv), separator);
 	}
 	else {
 		if (rtype == FTREPR_DFILTER) {
@@ -165,8 +190,10 @@ common_fvalue_set(fvalue_t *fv, const guint8* data, guint len)
 	/* Free up the old value, if we have one */
 	bytes_fvalue_free(fv);
 
-	fv->value.bytes = g_byte_array_new();
-	g_byte_array_append(fv->value.bytes, data, len);
+	g_assert(len <= sizeof fv->value.fixed_bytes.data);
+	memcpy(fv->value.fixed_bytes.data, data, len);
+	fv->value.fixed_bytes.len = len;
+	fv->bytes_are_fixed = TRUE;
 }
 
 static void
@@ -214,7 +241,7 @@ system_id_fvalue_set(fvalue_t *fv, GByteArray *value)
 static gpointer
 value_get(fvalue_t *fv)
 {
-	return fv->value.bytes->data;
+	return (gpointer)fv_bytes_data(fv);
 }
 
 static gboolean
@@ -503,15 +530,15 @@ fcwwn_from_unparsed(fvalue_t *fv, const char *s, gboolean allow_partial_value _U
 static guint
 len(fvalue_t *fv)
 {
-	return fv->value.bytes->len;
+	return fv_bytes_len(fv);
 }
 
 static void
 slice(fvalue_t *fv, GByteArray *bytes, guint offset, guint length)
 {
-	guint8* data;
+	const guint8* data;
 
-	data = fv->value.bytes->data + offset;
+	data = fv_bytes_data(fv) + offset;
 
 	g_byte_array_append(bytes, data, length);
 }
@@ -520,114 +547,125 @@ slice(fvalue_t *fv, GByteArray *bytes, guint offset, guint length)
 static gboolean
 cmp_eq(const fvalue_t *fv_a, const fvalue_t *fv_b)
 {
-	GByteArray	*a = fv_a->value.bytes;
-	GByteArray	*b = fv_b->value.bytes;
+	const guint8	*a = fv_bytes_data(fv_a);
+	const guint8	*b = fv_bytes_data(fv_b);
+	guint		a_len = fv_bytes_len(fv_a);
+	guint		b_len = fv_bytes_len(fv_b);
 
-	if (a->len != b->len) {
+	if (a_len != b_len) {
 		return FALSE;
 	}
 
-	return (memcmp(a->data, b->data, a->len) == 0);
+	return (memcmp(a, b, a_len) == 0);
 }
 
 
 static gboolean
 cmp_ne(const fvalue_t *fv_a, const fvalue_t *fv_b)
 {
-	GByteArray	*a = fv_a->value.bytes;
-	GByteArray	*b = fv_b->value.bytes;
+	const guint8	*a = fv_bytes_data(fv_a);
+	const guint8	*b = fv_bytes_data(fv_b);
+	guint		a_len = fv_bytes_len(fv_a);
+	guint		b_len = fv_bytes_len(fv_b);
 
-	if (a->len != b->len) {
+	if (a_len != b_len) {
 		return TRUE;
 	}
 
-	return (memcmp(a->data, b->data, a->len) != 0);
+	return (memcmp(a, b, a_len) != 0);
 }
 
 
 static gboolean
 cmp_gt(const fvalue_t *fv_a, const fvalue_t *fv_b)
 {
-	GByteArray	*a = fv_a->value.bytes;
-	GByteArray	*b = fv_b->value.bytes;
+	const guint8	*a = fv_bytes_data(fv_a);
+	const guint8	*b = fv_bytes_data(fv_b);
+	guint		a_len = fv_bytes_len(fv_a);
+	guint		b_len = fv_bytes_len(fv_b);
 
-	if (a->len > b->len) {
+	if (a_len > b_len) {
 		return TRUE;
 	}
 
-	if (a->len < b->len) {
+	if (a_len < b_len) {
 		return FALSE;
 	}
 
-	return (memcmp(a->data, b->data, a->len) > 0);
+	return (memcmp(a, b, a_len) > 0);
 }
 
 static gboolean
 cmp_ge(const fvalue_t *fv_a, const fvalue_t *fv_b)
 {
-	GByteArray	*a = fv_a->value.bytes;
-	GByteArray	*b = fv_b->value.bytes;
+	const guint8	*a = fv_bytes_data(fv_a);
+	const guint8	*b = fv_bytes_data(fv_b);
+	guint		a_len = fv_bytes_len(fv_a);
+	guint		b_len = fv_bytes_len(fv_b);
 
-	if (a->len > b->len) {
+	if (a_len > b_len) {
 		return TRUE;
 	}
 
-	if (a->len < b->len) {
+	if (a_len < b_len) {
 		return FALSE;
 	}
 
-	return (memcmp(a->data, b->data, a->len) >= 0);
+	return (memcmp(a, b, a_len) >= 0);
 }
 
 static gboolean
 cmp_lt(const fvalue_t *fv_a, const fvalue_t *fv_b)
 {
-	GByteArray	*a = fv_a->value.bytes;
-	GByteArray	*b = fv_b->value.bytes;
+	const guint8	*a = fv_bytes_data(fv_a);
+	const guint8	*b = fv_bytes_data(fv_b);
+	guint		a_len = fv_bytes_len(fv_a);
+	guint		b_len = fv_bytes_len(fv_b);
 
-	if (a->len < b->len) {
+	if (a_len < b_len) {
 		return TRUE;
 	}
 
-	if (a->len > b->len) {
+	if (a_len > b_len) {
 		return FALSE;
 	}
 
-	return (memcmp(a->data, b->data, a->len) < 0);
+	return (memcmp(a, b, a_len) < 0);
 }
 
 static gboolean
 cmp_le(const fvalue_t *fv_a, const fvalue_t *fv_b)
 {
-	GByteArray	*a = fv_a->value.bytes;
-	GByteArray	*b = fv_b->value.bytes;
+	const guint8	*a = fv_bytes_data(fv_a);
+	const guint8	*b = fv_bytes_data(fv_b);
+	guint		a_len = fv_bytes_len(fv_a);
+	guint		b_len = fv_bytes_len(fv_b);
 
-	if (a->len < b->len) {
+	if (a_len < b_len) {
 		return TRUE;
 	}
 
-	if (a->len > b->len) {
+	if (a_len > b_len) {
 		return FALSE;
 	}
 
-	return (memcmp(a->data, b->data, a->len) <= 0);
+	return (memcmp(a, b, a_len) <= 0);
 }
 
 static gboolean
 cmp_bitwise_and(const fvalue_t *fv_a, const fvalue_t *fv_b)
 {
-	GByteArray	*a = fv_a->value.bytes;
-	GByteArray	*b = fv_b->value.bytes;
+	const guint8	*a = fv_bytes_data(fv_a);
+	const guint8	*b = fv_bytes_data(fv_b);
+	guint		a_len = fv_bytes_len(fv_a);
+	guint		b_len = fv_bytes_len(fv_b);
 	guint i = 0;
-	unsigned char *p_a, *p_b;
 
-	if (b->len != a->len) {
+	if (b_len != a_len) {
 		return FALSE;
 	}
-	p_a = a->data;
-	p_b = b->data;
-	while (i < b->len) {
-		if (p_a[i] & p_b[i])
+	while (i < b_len) {
+		if (a[i] & b[i])
 			return TRUE;
 		else
 			i++;
@@ -638,10 +676,12 @@ cmp_bitwise_and(const fvalue_t *fv_a, const fvalue_t *fv_b)
 static gboolean
 cmp_contains(const fvalue_t *fv_a, const fvalue_t *fv_b)
 {
-	GByteArray	*a = fv_a->value.bytes;
-	GByteArray	*b = fv_b->value.bytes;
+	const guint8	*a = fv_bytes_data(fv_a);
+	const guint8	*b = fv_bytes_data(fv_b);
+	guint		a_len = fv_bytes_len(fv_a);
+	guint		b_len = fv_bytes_len(fv_b);
 
-	if (epan_memmem(a->data, a->len, b->data, b->len)) {
+	if (epan_memmem(a, a_len, b, b_len)) {
 		return TRUE;
 	}
 	else {
@@ -652,12 +692,10 @@ cmp_contains(const fvalue_t *fv_a, const fvalue_t *fv_b)
 static gboolean
 cmp_matches(const fvalue_t *fv, const GRegex *regex)
 {
-	GByteArray *a = fv->value.bytes;
-
 	return g_regex_match_full(
 		regex,			/* Compiled PCRE */
-		(char *)a->data,	/* The data to check for the pattern... */
-		(int)a->len,		/* ... and its length */
+		(const char *)fv_bytes_data(fv),	/* The data to check for the pattern... */
+		(int)fv_bytes_len(fv),	/* ... and its length */
 		0,			/* Start offset within data */
 		(GRegexMatchFlags)0,	/* GRegexMatchFlags */
 		NULL,			/* We are not interested in the match information */
@@ -234,6 +234,12 @@ typedef struct _fvalue_t {
 		gchar			*string;
 		guchar			*ustring;
 		GByteArray		*bytes;
+		struct {
+			/* FT_AX25, FT_VINES, FT_ETHER and FT_FCWWN
+			 * values set from packet data; see ftype-bytes.c */
+			guint8		data[FT_FCWWN_LEN];
+			guint		len;
+		} fixed_bytes;
 		ipv4_addr_and_mask	ipv4;
 		ipv6_addr_and_prefix	ipv6;
 		e_guid_t		guid;
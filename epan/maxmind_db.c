@@ -64,9 +64,13 @@ typedef struct _mmdbr_response_t {
     mmdb_lookup_t mmdb_val;
 } mmdb_response_t;
 
+// The maps are only touched by the main thread; responses reach them
+// through mmdbr_response_q, so lookups don't need a lock.
 static wmem_map_t *mmdb_ipv4_map;
 static wmem_map_t *mmdb_ipv6_map;
 static GAsyncQueue *mmdbr_response_q; // g_allocated mmdbr_response_t *
+// Requests sent that we haven't popped a response for. Main thread only.
+static guint mmdbr_pending;
 static GThread *read_mmdbr_stdout_thread;
 
 // Interned strings
@@ -101,6 +105,10 @@ static GPtrArray *mmdb_file_arr; // .mmdb files
 
 static gboolean resolve_synchronously = FALSE;
 
+// How long to wait for mmdbresolve to answer before giving up on the
+// outstanding requests.
+#define MMDB_RESPONSE_TIMEOUT (5 * G_USEC_PER_SEC)
+
 #if 0
 #define MMDB_DEBUG(...) { \
     char *MMDB_DEBUG_MSG = g_strdup_printf(__VA_ARGS__); \
@@ -188,25 +196,53 @@ write_mmdbr_stdin_worker(gpointer sifd_data) {
             continue;
         }
 
-        MMDB_DEBUG("write %s ql %d", request, g_async_queue_length(mmdbr_request_q));
-        ssize_t req_status = ws_write(stdin_fd, request, (unsigned int)strlen(request));
+        // Send everything that has been queued up in the meantime along
+        // with this request, e.g. the addresses of a whole batch of
+        // packets, so that we don't do a write for every address.
+        GString *batch = g_string_new(request);
+        g_free(request);
+        while ((request = (char *) g_async_queue_try_pop(mmdbr_request_q)) != NULL) {
+            if (strcmp(request, mmdbr_stop_sentinel) == 0) {
+                g_free(request);
+                break;
+            }
+            g_string_append(batch, request);
+            g_free(request);
+        }
+
+        MMDB_DEBUG("write %zu bytes ql %d", batch->len, g_async_queue_length(mmdbr_request_q));
+        ssize_t req_status = ws_write(stdin_fd, batch->str, (unsigned int)batch->len);
+        g_string_free(batch, TRUE);
         if (req_status < 0) {
             MMDB_DEBUG("write error %s. exiting thread.", g_strerror(errno));
             return NULL;
         }
-        g_free(request);
     }
     return NULL;
 }
 
+// Read ahead buffer. Read worker only.
+#define MMDBR_READ_BUF_SIZE 4096
+static char mmdbr_read_buf[MMDBR_READ_BUF_SIZE];
+static size_t mmdbr_read_pos;
+static size_t mmdbr_read_len;
+
 static ssize_t mmdbr_pipe_read_one(char *ch_p) {
-    ssize_t status = -1;
-    g_rw_lock_reader_lock(&mmdbr_pipe_mtx);
-    if (ws_pipe_valid(&mmdbr_pipe) && ws_pipe_data_available(mmdbr_pipe.stdout_fd)) {
-        status = ws_read(mmdbr_pipe.stdout_fd, ch_p, 1);
+    if (mmdbr_read_pos == mmdbr_read_len) {
+        ssize_t status = -1;
+        g_rw_lock_reader_lock(&mmdbr_pipe_mtx);
+        if (ws_pipe_valid(&mmdbr_pipe) && ws_pipe_data_available(mmdbr_pipe.stdout_fd)) {
+            status = ws_read(mmdbr_pipe.stdout_fd, mmdbr_read_buf, MMDBR_READ_BUF_SIZE);
+        }
+        g_rw_lock_reader_unlock(&mmdbr_pipe_mtx);
+        if (status < 1) {
+            return status;
+        }
+        mmdbr_read_pos = 0;
+        mmdbr_read_len = status;
     }
-    g_rw_lock_reader_unlock(&mmdbr_pipe_mtx);
-    return status;
+    *ch_p = mmdbr_read_buf[mmdbr_read_pos++];
+    return 1;
 }
 
 // We need to read a series of lines from mmdbresolve's stdout. Trying to
@@ -215,9 +251,10 @@ static ssize_t mmdbr_pipe_read_one(char *ch_p) {
 // thread calls fclose while fgets is blocking, it will block as well. The
 // same happens for plain close+read.
 //
-// Read our input one character at a time and only after we've ensured
-// that data is available. If this is too inefficient we could try one
-// of the following:
+// Read whatever input is available, but only after we've ensured that
+// there is some, and hand it out one character at a time from
+// mmdbr_read_buf. If this is too inefficient we could try one of the
+// following:
 // - Use overlapped I/O, which implies adding ws_pipe_set_nonblock and
 //   ws_pipe_read_nonblock routines.
 // - Stash our worker thread handles on Windows and call CancelSynchronousIo
@@ -235,6 +272,7 @@ read_mmdbr_stdout_worker(gpointer data _U_) {
     char cur_addr[WS_INET6_ADDRSTRLEN] = { 0 };
 
     MMDB_DEBUG("starting read worker");
+    mmdbr_read_pos = mmdbr_read_len = 0;
 
     while (1) { // Start of line
         char ch;
@@ -348,15 +386,12 @@ read_mmdbr_stdout_worker(gpointer data _U_) {
                 g_async_queue_push(mmdbr_response_q, response); // Will be freed by maxmind_db_lookup_process.
                 response = g_new0(mmdb_response_t, 1);
             } else if (strcmp(cur_addr, "init") != 0) {
-                if (resolve_synchronously) {
-                    // Synchronous lookups expect a 1-in 1-out resolution.
-                    MMDB_DEBUG("Pushing not-found result due to bad address");
-                    g_async_queue_push(mmdbr_response_q, response); // Will be freed by maxmind_db_lookup_process.
-                    response = g_new0(mmdb_response_t, 1);
-                }
-                else {
-                    MMDB_DEBUG("Discarded previous values due to bad address");
-                }
+                // Every request gets a response so that the main thread
+                // can tell when all of them have been answered.
+                MMDB_DEBUG("Pushing not-found result");
+                response->mmdb_val.found = FALSE;
+                g_async_queue_push(mmdbr_response_q, response); // Will be freed by maxmind_db_lookup_process.
+                response = g_new0(mmdb_response_t, 1);
             }
             cur_addr[0] = '\0';
             init_lookup(&response->mmdb_val);
@@ -420,6 +455,7 @@ static void mmdb_resolve_stop(void) {
         g_free(response);
         MMDB_DEBUG("cleaned response %p", response);
     }
+    mmdbr_pending = 0;
 }
 
 /**
@@ -619,6 +655,17 @@ void maxmind_db_pref_cleanup(void)
 
 static void maxmind_db_pop_response(mmdb_response_t *response)
 {
+    if (mmdbr_pending > 0) {
+        mmdbr_pending--;
+    }
+
+    if (!response->mmdb_val.found) {
+        // The address keeps the mmdb_not_found entry it was given when
+        // it was requested.
+        g_free(response);
+        return;
+    }
+
     mmdb_lookup_t *mmdb_val = (mmdb_lookup_t *) g_memdup2(&response->mmdb_val, sizeof(mmdb_lookup_t));
     if (response->mmdb_val.country_iso) {
         char *country_iso = (char *) response->mmdb_val.country_iso;
@@ -650,16 +697,29 @@ static void maxmind_db_pop_response(mmdb_response_t *response)
     g_free(response);
 }
 
-static void maxmind_db_await_response(void)
+/**
+ * Wait until every request sent so far has been answered. Requests
+ * are pipelined, so this costs one round trip however many there are.
+ */
+static void maxmind_db_await_responses(void)
 {
     mmdb_response_t *response;
 
-    if (mmdbr_response_q != NULL) {
-        MMDB_DEBUG("entering blocking wait for response");
-        response = (mmdb_response_t *) g_async_queue_pop(mmdbr_response_q);
-        MMDB_DEBUG("exiting blocking wait for response");
+    if (mmdbr_response_q == NULL) {
+        return;
+    }
+
+    MMDB_DEBUG("entering blocking wait for %u responses", mmdbr_pending);
+    while (mmdbr_pending > 0) {
+        response = (mmdb_response_t *) g_async_queue_timeout_pop(mmdbr_response_q, MMDB_RESPONSE_TIMEOUT);
+        if (!response) {
+            MMDB_DEBUG("timed out waiting for responses");
+            mmdbr_pending = 0;
+            break;
+        }
         maxmind_db_pop_response(response);
     }
+    MMDB_DEBUG("exiting blocking wait for responses");
 }
 
 /**
@@ -692,8 +752,9 @@ maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
             ws_inet_ntop4(addr, addr_str, WS_INET_ADDRSTRLEN);
             MMDB_DEBUG("looking up %s", addr_str);
             g_async_queue_push(mmdbr_request_q, g_strdup_printf("%s\n", addr_str));
+            mmdbr_pending++;
             if (resolve_synchronously) {
-                maxmind_db_await_response();
+                maxmind_db_await_responses();
                 result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
             }
         }
@@ -715,8 +776,9 @@ maxmind_db_lookup_ipv6(const ws_in6_addr *addr) {
             ws_inet_ntop6(addr, addr_str, WS_INET6_ADDRSTRLEN);
             MMDB_DEBUG("looking up %s", addr_str);
             g_async_queue_push(mmdbr_request_q, g_strdup_printf("%s\n", addr_str));
+            mmdbr_pending++;
             if (resolve_synchronously) {
-                maxmind_db_await_response();
+                maxmind_db_await_responses();
                 result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
             }
         }
@@ -751,6 +813,13 @@ maxmind_db_get_paths(void) {
 
 void
 maxmind_db_set_synchrony(gboolean synchronous) {
+    if (synchronous && !resolve_synchronously) {
+        // Lookups made so far, e.g. every address seen in TShark's
+        // first pass, were queued up asynchronously. Collect all of
+        // their results now, so that they are there for the next pass
+        // instead of arriving after its packets have been printed.
+        maxmind_db_await_responses();
+    }
     resolve_synchronously = synchronous;
 }
 
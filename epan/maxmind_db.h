@@ -87,7 +87,9 @@ static inline gboolean maxmind_db_has_coords(const mmdb_lookup_t *result)
 
 /**
  * Select whether lookups should be performed synchronously.
- * Default is asynchronous lookups.
+ * Default is asynchronous lookups. Switching to synchronous lookups
+ * first waits for the results of any asynchronous lookups that are
+ * still outstanding.
  *
  * @param synchronous Whether maxmind lookups should be synchronous.
  *
@@ -100,11 +100,111 @@ static void prepopulate_oids(void) {
 
 
 
+/*
+ * Cache of what encoded (absolute) OIDs resolve to.  Certificates and SNMP
+ * polling bring the same few hundred OIDs over and over again, so their
+ * subids, best match, and resolved and numeric strings are kept once they
+ * have been worked out.  Adding an OID may change how others resolve, so
+ * it empties the cache; so does the cache filling up.
+ */
+#define OID_CACHE_MAX_ENTRIES	4096
+#define OID_CACHE_MAX_OID_LEN	64
+
+typedef struct _oid_cache_key_t {
+	const guint8 *oid;
+	guint oid_len;
+} oid_cache_key_t;
+
+typedef struct _oid_cache_entry_t {
+	oid_cache_key_t key;	/* first, for the hash table */
+	guint32 *subids;
+	guint subids_len;
+	oid_info_t *oid_info;
+	guint matched;
+	guint left;
+	gchar *resolved;
+	gchar *numeric;
+} oid_cache_entry_t;
+
+static GHashTable *oid_cache = NULL;
+
+static guint oid_cache_hash(gconstpointer k) {
+	const oid_cache_key_t *key = (const oid_cache_key_t *)k;
+	guint hash = 2166136261U;
+	guint i;
+
+	for (i = 0; i < key->oid_len; i++) {
+		hash = (hash ^ key->oid[i]) * 16777619U;
+	}
+	return hash;
+}
+
+static gboolean oid_cache_equal(gconstpointer k1, gconstpointer k2) {
+	const oid_cache_key_t *key1 = (const oid_cache_key_t *)k1;
+	const oid_cache_key_t *key2 = (const oid_cache_key_t *)k2;
+
+	return key1->oid_len == key2->oid_len &&
+		memcmp(key1->oid, key2->oid, key1->oid_len) == 0;
+}
+
+static void oid_cache_entry_free(gpointer p) {
+	oid_cache_entry_t *entry = (oid_cache_entry_t *)p;
+
+	g_free((guint8 *)entry->key.oid);
+	wmem_free(NULL, entry->subids);
+	wmem_free(NULL, entry->resolved);
+	wmem_free(NULL, entry->numeric);
+	g_free(entry);
+}
+
+static void oid_cache_clear(void) {
+	if (oid_cache) {
+		g_hash_table_remove_all(oid_cache);
+	}
+}
+
+/* Returns the cache entry for an encoded OID, working it out if it isn't
+ * there yet, or NULL if OIDs of this length aren't cached. */
+static const oid_cache_entry_t *oid_cache_get(const guint8 *oid, gint oid_len) {
+	oid_cache_key_t key;
+	oid_cache_entry_t *entry;
+
+	if (oid_len <= 0 || oid_len > OID_CACHE_MAX_OID_LEN) {
+		return NULL;
+	}
+
+	key.oid = oid;
+	key.oid_len = (guint)oid_len;
+	if (oid_cache) {
+		entry = (oid_cache_entry_t *)g_hash_table_lookup(oid_cache, &key);
+		if (entry) {
+			return entry;
+		}
+		if (g_hash_table_size(oid_cache) >= OID_CACHE_MAX_ENTRIES) {
+			oid_cache_clear();
+		}
+	} else {
+		oid_cache = g_hash_table_new_full(oid_cache_hash, oid_cache_equal, NULL, oid_cache_entry_free);
+	}
+
+	entry = g_new(oid_cache_entry_t, 1);
+	entry->key.oid = (const guint8 *)g_memdup2(oid, (gsize)oid_len);
+	entry->key.oid_len = (guint)oid_len;
+	entry->subids_len = oid_encoded2subid(NULL, oid, oid_len, &entry->subids);
+	entry->oid_info = oid_get(entry->subids_len, entry->subids, &entry->matched, &entry->left);
+	entry->resolved = oid_resolved(NULL, entry->subids_len, entry->subids);
+	entry->numeric = oid_subid2string(NULL, entry->subids, entry->subids_len);
+	g_hash_table_insert(oid_cache, entry, entry);
+
+	return entry;
+}
+
 static oid_info_t* add_oid(const char* name, oid_kind_t kind, const oid_value_type_t* type, oid_key_t* key, guint oid_len, guint32 *subids) {
 	guint i = 0;
 	oid_info_t* c = &oid_root;
 
 	prepopulate_oids();
+	oid_cache_clear();
 	oid_len--;
 
 	do {
@@ -847,6 +947,10 @@ void oids_init(void) {
 }
 
 void oids_cleanup(void) {
+	if (oid_cache) {
+		g_hash_table_destroy(oid_cache);
+		oid_cache = NULL;
+	}
 #ifdef HAVE_LIBSMI
 	unregister_mibs();
 #else
@@ -1053,7 +1157,18 @@ done:
 
 
 oid_info_t* oid_get_from_encoded(wmem_allocator_t *scope, const guint8 *bytes, gint byteslen, guint32** subids_p, guint* matched_p, guint* left_p) {
-	guint subids_len = oid_encoded2subid(scope, bytes, byteslen, subids_p);
+	const oid_cache_entry_t *entry = oid_cache_get(bytes, byteslen);
+	guint subids_len;
+
+	if (entry) {
+		*subids_p = entry->subids ?
+			(guint32 *)wmem_memdup(scope, entry->subids, sizeof(guint32) * entry->subids_len) : NULL;
+		*matched_p = entry->matched;
+		*left_p = entry->left;
+		return entry->oid_info;
+	}
+
+	subids_len = oid_encoded2subid(scope, bytes, byteslen, subids_p);
 	return oid_get(subids_len, *subids_p, matched_p, left_p);
 }
 
@@ -1063,10 +1178,16 @@ oid_info_t* oid_get_from_string(wmem_allocator_t *scope, const gchar *oid_str, g
 }
 
 gchar *oid_resolved_from_encoded(wmem_allocator_t *scope, const guint8 *oid, gint oid_len) {
+	const oid_cache_entry_t *entry = oid_cache_get(oid, oid_len);
 	guint32 *subid_oid = NULL;
 	gchar * ret;
-	guint subid_oid_length = oid_encoded2subid(NULL, oid, oid_len, &subid_oid);
+	guint subid_oid_length;
+
+	if (entry) {
+		return wmem_strdup(scope, entry->resolved);
+	}
 
+	subid_oid_length = oid_encoded2subid(NULL, oid, oid_len, &subid_oid);
 	ret = oid_resolved(scope, subid_oid_length, subid_oid);
 	wmem_free(NULL, subid_oid);
 	return ret;
@@ -1139,9 +1260,16 @@ guint oid_subid2encoded(wmem_allocator_t *scope, guint subids_len, guint32* subi
 }
 
 gchar* oid_encoded2string(wmem_allocator_t *scope, const guint8* encoded, guint len) {
+	const oid_cache_entry_t *entry = oid_cache_get(encoded, (gint)len);
 	guint32* subids = NULL;
 	gchar* ret;
-	guint subids_len = oid_encoded2subid(NULL, encoded, len, &subids);
+	guint subids_len;
+
+	if (entry) {
+		return wmem_strdup(scope, entry->subids_len ? entry->numeric : "");
+	}
+
+	subids_len = oid_encoded2subid(NULL, encoded, len, &subids);
 
 	if (subids_len) {
 		ret = oid_subid2string(scope, subids,subids_len);
@@ -1233,8 +1361,17 @@ extern void oid_both(wmem_allocator_t *scope, guint oid_len, guint32 *subids, gc
 }
 
 extern void oid_both_from_encoded(wmem_allocator_t *scope, const guint8 *oid, gint oid_len, gchar** resolved_p, gchar** numeric_p) {
+	const oid_cache_entry_t *entry = oid_cache_get(oid, oid_len);
 	guint32* subids = NULL;
-	guint subids_len = oid_encoded2subid(NULL, oid, oid_len, &subids);
+	guint subids_len;
+
+	if (entry) {
+		*resolved_p = wmem_strdup(scope, entry->resolved);
+		*numeric_p = wmem_strdup(scope, entry->numeric);
+		return;
+	}
+
+	subids_len = oid_encoded2subid(NULL, oid, oid_len, &subids);
 	*resolved_p = oid_resolved(scope, subids_len,subids);
 	*numeric_p = oid_subid2string(scope, subids,subids_len);
 	wmem_free(NULL, subids);
@@ -456,6 +456,33 @@ oids_test_add_string(void)
     wmem_free(NULL, oid);
 }
 
+/* OIDS TESTING FUNCTIONS (/oids/cache/) */
+
+static void
+oids_test_cache_encoded(void)
+{
+    gchar* first;
+    gchar* second;
+    guint32 subids[] = { 2, 1, 2 };
+
+    /* The second lookup comes from the cache, and must give the same. */
+    first = oid_resolved_from_encoded(NULL, ex1.encoded, ex1.encoded_len);
+    second = oid_resolved_from_encoded(NULL, ex1.encoded, ex1.encoded_len);
+    g_assert_cmpstr(first, ==, second);
+    g_assert_true(first != second);
+    wmem_free(NULL, first);
+    wmem_free(NULL, second);
+
+    /* Adding an OID empties the cache. */
+    first = oid_resolved_from_encoded(NULL, (const guint8 *)"\x51\x02", 2);
+    oid_add("joint-iso-itu-t.asn1.ber-derived", 3, subids);
+    second = oid_resolved_from_encoded(NULL, (const guint8 *)"\x51\x02", 2);
+    g_assert_cmpstr(first, !=, second);
+    g_assert_cmpstr(second, ==, "joint-iso-itu-t.asn1.ber-derived");
+    wmem_free(NULL, first);
+    wmem_free(NULL, second);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -509,6 +536,9 @@ main(int argc, char **argv)
     g_test_add_func("/oids/add/encoded",   oids_test_add_encoded);
     g_test_add_func("/oids/add/string",   oids_test_add_string);
 
+    /* /oids/cache */
+    g_test_add_func("/oids/cache/encoded",   oids_test_cache_encoded);
+
     wmem_init();
     test_scope = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
     oids_init();
@@ -37,9 +37,12 @@
 #include <epan/expert.h>
 #include <epan/prefs.h>
 #include <epan/range.h>
+#include <epan/conversation.h>
 
 #include <wsutil/str_util.h>
+#include <wsutil/time_util.h>
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
+#include <wsutil/ws_probes.h>
 
 static gint proto_malformed = -1;
 static dissector_handle_t frame_handle = NULL;
@@ -89,8 +92,21 @@ struct dissector_table {
 	protocol_t	*protocol;
 	GHashFunc	hash_func;
 	gboolean	supports_decode_as;
+	dtbl_entry_t	***uint_index;	/* direct index of a FT_UINT8 or FT_UINT16 table, or NULL */
+	guint32		uint_index_max;	/* largest value in uint_index */
 };
 
+/*
+ * FT_UINT8 and FT_UINT16 dissector tables also get a direct index of their
+ * entries, so that looking up a port number, an Ethertype or the like
+ * is two loads rather than a hash table lookup.  It's split into pages of
+ * UINT_INDEX_PAGE_SIZE entries, which are only allocated once they have
+ * something in them.  The hash table stays authoritative; everything that
+ * changes it also calls uint_index_set() or uint_index_rebuild().
+ */
+#define UINT_INDEX_PAGE_SHIFT	8
+#define UINT_INDEX_PAGE_SIZE	(1U << UINT_INDEX_PAGE_SHIFT)
+
 /*
  * Dissector tables. const char * -> dissector_table *
  */
@@ -183,11 +199,65 @@ destroy_heuristic_dissector_list(void *data)
 	g_slice_free(struct heur_dissector_list, dissector_list);
 }
 
+static void
+uint_index_set(dissector_table_t sub_dissectors, const guint32 pattern,
+	       dtbl_entry_t *dtbl_entry)
+{
+	dtbl_entry_t **page;
+
+	if (sub_dissectors->uint_index == NULL ||
+	    pattern > sub_dissectors->uint_index_max)
+		return;
+
+	page = sub_dissectors->uint_index[pattern >> UINT_INDEX_PAGE_SHIFT];
+	if (page == NULL) {
+		if (dtbl_entry == NULL)
+			return;
+		page = g_new0(dtbl_entry_t *, UINT_INDEX_PAGE_SIZE);
+		sub_dissectors->uint_index[pattern >> UINT_INDEX_PAGE_SHIFT] = page;
+	}
+	page[pattern & (UINT_INDEX_PAGE_SIZE - 1)] = dtbl_entry;
+}
+
+static void
+uint_index_clear(dissector_table_t sub_dissectors)
+{
+	guint32 i;
+
+	for (i = 0; i <= sub_dissectors->uint_index_max >> UINT_INDEX_PAGE_SHIFT; i++) {
+		g_free(sub_dissectors->uint_index[i]);
+		sub_dissectors->uint_index[i] = NULL;
+	}
+}
+
+static void
+uint_index_rebuild_func(gpointer key, gpointer value, gpointer user_data)
+{
+	uint_index_set((dissector_table_t)user_data, GPOINTER_TO_UINT(key),
+		       (dtbl_entry_t *)value);
+}
+
+/* Recreate the index after entries were removed with g_hash_table_foreach_remove(). */
+static void
+uint_index_rebuild(dissector_table_t sub_dissectors)
+{
+	if (sub_dissectors->uint_index == NULL)
+		return;
+
+	uint_index_clear(sub_dissectors);
+	g_hash_table_foreach(sub_dissectors->hash_table, uint_index_rebuild_func,
+			     sub_dissectors);
+}
+
 static void
 destroy_dissector_table(void *data)
 {
 	struct dissector_table *table = (struct dissector_table *)data;
 
+	if (table->uint_index != NULL) {
+		uint_index_clear(table);
+		g_free(table->uint_index);
+	}
 	g_hash_table_destroy(table->hash_table);
 	g_slist_free(table->dissector_handles);
 	g_slice_free(struct dissector_table, data);
@@ -247,6 +317,151 @@ call_routine(gpointer routine, gpointer dummy _U_)
 	(*func)();
 }
 
+/*
+ * Dissector profiling, see dissector_profiling_enable().
+ *
+ * Each dissector call that's being timed has a frame on prof_stack; the
+ * time spent in the dissectors it calls is added to its frame, so that
+ * it can be taken off its own time.  A dissector that throws an exception
+ * leaves its frame behind; it is closed when its caller's frame is, or
+ * when the next packet starts, as if the dissector ran until then.
+ */
+typedef struct {
+	dissector_profile_t profile;
+	guint idx;
+	guint active;          /* number of calls in progress, for recursion */
+} dissector_prof_entry_t;
+
+typedef struct {
+	dissector_prof_entry_t *entry;
+	guint64 start_ns;
+	guint64 child_ns;
+} dissector_prof_frame_t;
+
+static gboolean dissector_profiling = FALSE;
+static GHashTable *prof_dissectors = NULL;  /* name -> dissector_prof_entry_t* */
+static GHashTable *prof_heuristics = NULL;  /* short name -> dissector_prof_entry_t* */
+static GPtrArray *prof_entries = NULL;      /* dissector_prof_entry_t*, by idx */
+static GArray *prof_stack = NULL;           /* dissector_prof_frame_t */
+
+void
+dissector_profiling_enable(gboolean enable)
+{
+	if (enable && prof_entries == NULL) {
+		prof_dissectors = g_hash_table_new(g_str_hash, g_str_equal);
+		prof_heuristics = g_hash_table_new(g_str_hash, g_str_equal);
+		prof_entries = g_ptr_array_new_with_free_func(g_free);
+		prof_stack = g_array_new(FALSE, FALSE, sizeof(dissector_prof_frame_t));
+	}
+	if (prof_stack != NULL)
+		g_array_set_size(prof_stack, 0);
+	dissector_profiling = enable;
+}
+
+gboolean
+dissector_profiling_enabled(void)
+{
+	return dissector_profiling;
+}
+
+void
+dissector_profiling_reset(void)
+{
+	guint i;
+
+	if (prof_entries == NULL)
+		return;
+	for (i = 0; i < prof_entries->len; i++) {
+		dissector_prof_entry_t *entry = (dissector_prof_entry_t *)g_ptr_array_index(prof_entries, i);
+
+		entry->profile.calls = 0;
+		entry->profile.inclusive_ns = 0;
+		entry->profile.exclusive_ns = 0;
+	}
+}
+
+void
+dissector_profiling_foreach(dissector_profile_func func, gpointer user_data)
+{
+	guint i;
+
+	if (prof_entries == NULL)
+		return;
+	for (i = 0; i < prof_entries->len; i++) {
+		dissector_prof_entry_t *entry = (dissector_prof_entry_t *)g_ptr_array_index(prof_entries, i);
+
+		func(entry->idx, &entry->profile, user_data);
+	}
+}
+
+static void
+dissector_prof_free(void)
+{
+	if (prof_entries == NULL)
+		return;
+	g_hash_table_destroy(prof_dissectors);
+	g_hash_table_destroy(prof_heuristics);
+	g_ptr_array_free(prof_entries, TRUE);
+	g_array_free(prof_stack, TRUE);
+	prof_dissectors = NULL;
+	prof_heuristics = NULL;
+	prof_entries = NULL;
+	prof_stack = NULL;
+	dissector_profiling = FALSE;
+}
+
+/* Start timing a dissector call; returns the depth to pass to dissector_prof_leave() */
+static guint
+dissector_prof_enter(const char *name, gboolean heuristic)
+{
+	GHashTable *table = heuristic ? prof_heuristics : prof_dissectors;
+	dissector_prof_entry_t *entry;
+	dissector_prof_frame_t frame;
+	guint depth = prof_stack->len;
+
+	entry = (dissector_prof_entry_t *)g_hash_table_lookup(table, name);
+	if (entry == NULL) {
+		/* Lua dissectors can go away with their names; keep a copy */
+		name = g_intern_string(name);
+		entry = g_new0(dissector_prof_entry_t, 1);
+		entry->profile.name = name;
+		entry->profile.heuristic = heuristic;
+		entry->idx = prof_entries->len;
+		g_ptr_array_add(prof_entries, entry);
+		g_hash_table_insert(table, (gpointer)name, entry);
+	}
+	entry->profile.calls++;
+	entry->active++;
+
+	frame.entry = entry;
+	frame.child_ns = 0;
+	frame.start_ns = get_monotonic_ns();
+	g_array_append_val(prof_stack, frame);
+	return depth;
+}
+
+/* Stop timing the call at depth, and any that an exception left above it */
+static void
+dissector_prof_leave(guint depth)
+{
+	guint64 now = get_monotonic_ns();
+
+	while (prof_stack->len > depth) {
+		dissector_prof_frame_t *frame =
+			&g_array_index(prof_stack, dissector_prof_frame_t, prof_stack->len - 1);
+		dissector_prof_entry_t *entry = frame->entry;
+		guint64 elapsed = now - frame->start_ns;
+
+		entry->profile.exclusive_ns += elapsed > frame->child_ns ? elapsed - frame->child_ns : 0;
+		/* Only count the outermost of recursive calls in the inclusive time */
+		if (--entry->active == 0)
+			entry->profile.inclusive_ns += elapsed;
+		g_array_set_size(prof_stack, prof_stack->len - 1);
+		if (prof_stack->len > 0)
+			g_array_index(prof_stack, dissector_prof_frame_t, prof_stack->len - 1).child_ns += elapsed;
+	}
+}
+
 void
 packet_cleanup(void)
 {
@@ -269,6 +484,7 @@ packet_cleanup(void)
 		}
 		g_array_free(postdissectors, TRUE);
 	}
+	dissector_prof_free();
 }
 
 /*
@@ -309,6 +525,20 @@ register_shutdown_routine(void (*func)(void))
 }
 
 /* Initialize all data structures used for dissection. */
+static void
+reset_heur_counts(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	struct heur_dissector_list *sub_dissectors = (struct heur_dissector_list *)value;
+	GSList *entry;
+
+	for (entry = sub_dissectors->dissectors; entry != NULL; entry = g_slist_next(entry)) {
+		heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+
+		hdtbl_entry->tries = 0;
+		hdtbl_entry->matches = 0;
+	}
+}
+
 void
 init_dissection(void)
 {
@@ -332,6 +562,9 @@ init_dissection(void)
 
 	/* Initialize the expert infos */
 	expert_packet_init();
+
+	/* Start counting heuristic dissector matches afresh. */
+	g_hash_table_foreach(heur_dissector_lists, reset_heur_counts, NULL);
 }
 
 void
@@ -379,22 +612,40 @@ void
 add_new_data_source(packet_info *pinfo, tvbuff_t *tvb, const char *name)
 {
 	struct data_source *src;
+	GSList *link;
 
 	src = wmem_new(pinfo->pool, struct data_source);
 	src->tvb = tvb;
 	src->name = wmem_strdup(pinfo->pool, name);
+
+	/* The list links come from the packet pool as well, so that they
+	 * are freed along with the sources they point to. */
+	link = wmem_new(pinfo->pool, GSList);
+	link->data = src;
+	link->next = NULL;
 	/* This could end up slow, but we should never have that many data
 	 * sources so it probably doesn't matter */
-	pinfo->data_src = g_slist_append(pinfo->data_src, src);
+	if (pinfo->data_src == NULL)
+		pinfo->data_src = link;
+	else
+		g_slist_last(pinfo->data_src)->next = link;
 }
 
 void
 remove_last_data_source(packet_info *pinfo)
 {
+	GSList *prev = NULL;
 	GSList *last;
 
-	last = g_slist_last(pinfo->data_src);
-	pinfo->data_src = g_slist_delete_link(pinfo->data_src, last);
+	if (pinfo->data_src == NULL)
+		return;
+
+	for (last = pinfo->data_src; last->next != NULL; last = last->next)
+		prev = last;
+	if (prev == NULL)
+		pinfo->data_src = NULL;
+	else
+		prev->next = NULL;
 }
 
 char*
@@ -435,10 +686,8 @@ get_data_source_tvb_by_name(packet_info *pinfo, const char *name)
 void
 free_data_sources(packet_info *pinfo)
 {
-	if (pinfo->data_src) {
-		g_slist_free(pinfo->data_src);
-		pinfo->data_src = NULL;
-	}
+	/* The links are in pinfo->pool; see add_new_data_source(). */
+	pinfo->data_src = NULL;
 }
 
 void
@@ -521,9 +770,15 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 	edt->pi.epan = edt->session;
 	/* edt->pi.pool created in epan_dissect_init() */
 	edt->pi.current_proto = "<Missing Protocol Name>";
+	/* An exception may have left the tag of a previous packet's dissector */
+	wmem_stats_set_tag(NULL);
+	/* ... or its profiling frames */
+	if (G_UNLIKELY(dissector_profiling))
+		dissector_prof_leave(0);
 	edt->pi.cinfo = cinfo;
 	edt->pi.presence_flags = 0;
 	edt->pi.num = fd->num;
+	edt->pi.flags.frame_only = edt->frame_only;
 	/*
 	 * XXX - this doesn't check the wtap_rec because, for
 	 * some capture files, time stamps are supplied only
@@ -583,6 +838,8 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 	frame_dissector_data.file_type_subtype = file_type_subtype;
 	frame_dissector_data.color_edt = edt; /* Used strictly for "coloring rules" */
 
+	WS_PROBE2(dissect_record_begin, fd->num, fd->pkt_len);
+
 	TRY {
 		/* Add this tvbuffer into the data_src list */
 		add_new_data_source(&edt->pi, edt->tvb, record_type);
@@ -603,6 +860,8 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 	}
 	ENDTRY;
 
+	WS_PROBE1(dissect_record_end, fd->num);
+
 	fd->visited = 1;
 }
 
@@ -692,6 +951,16 @@ struct dissector_handle {
 	protocol_t	*protocol;
 };
 
+static const char *
+dissector_prof_handle_name(dissector_handle_t handle)
+{
+	if (handle->name != NULL)
+		return handle->name;
+	if (handle->protocol != NULL)
+		return proto_get_protocol_filter_name(proto_get_id(handle->protocol));
+	return "<unnamed>";
+}
+
 /* This function will return
  * old style dissector :
  *   length of the payload or 1 of the payload is empty
@@ -707,6 +976,8 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			      packet_info *pinfo, proto_tree *tree, void *data)
 {
 	const char *saved_proto;
+	const char *saved_tag = NULL;
+	guint       prof_depth = 0;
 	int         len;
 
 	saved_proto = pinfo->current_proto;
@@ -716,6 +987,13 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			proto_get_protocol_short_name(handle->protocol);
 	}
 
+	/* Account the memory allocated by the dissector to its protocol */
+	if (G_UNLIKELY(wmem_stats_enabled()))
+		saved_tag = wmem_stats_set_tag(pinfo->current_proto);
+
+	if (G_UNLIKELY(dissector_profiling))
+		prof_depth = dissector_prof_enter(dissector_prof_handle_name(handle), FALSE);
+
 	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
 		len = ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
 	}
@@ -727,6 +1005,12 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 	}
 	pinfo->current_proto = saved_proto;
 
+	if (G_UNLIKELY(dissector_profiling))
+		dissector_prof_leave(prof_depth);
+
+	if (G_UNLIKELY(wmem_stats_enabled()))
+		wmem_stats_set_tag(saved_tag);
+
 	return len;
 }
 
@@ -761,12 +1045,17 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 	guint        saved_layers_len = 0;
 	guint        saved_tree_count = tree ? tree->tree_data->count : 0;
 
-	if (handle->protocol != NULL &&
-	    !proto_is_protocol_enabled(handle->protocol)) {
+	if (handle->protocol != NULL) {
+		if (!proto_is_protocol_enabled(handle->protocol)) {
+			/*
+			 * The protocol isn't enabled.
+			 */
+			return 0;
+		}
 		/*
-		 * The protocol isn't enabled.
+		 * Register the protocol's fields if that was put off.
 		 */
-		return 0;
+		proto_initialize_protocol_prefix(handle->protocol);
 	}
 
 	saved_proto = pinfo->current_proto;
@@ -804,6 +1093,10 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 		}
 	}
 
+	WS_PROBE3(call_dissector, pinfo->num,
+	    handle->protocol != NULL ? proto_get_id(handle->protocol) : -1,
+	    tvb_reported_length(tvb));
+
 	if (pinfo->flags.in_error_pkt) {
 		len = call_dissector_work_error(handle, tvb, pinfo, tree, data);
 	} else {
@@ -973,6 +1266,13 @@ find_dissector_table(const char *name)
 static dtbl_entry_t *
 find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 {
+	if (sub_dissectors->uint_index != NULL &&
+	    pattern <= sub_dissectors->uint_index_max) {
+		dtbl_entry_t **page = sub_dissectors->uint_index[pattern >> UINT_INDEX_PAGE_SHIFT];
+
+		return page != NULL ? page[pattern & (UINT_INDEX_PAGE_SIZE - 1)] : NULL;
+	}
+
 	switch (sub_dissectors->type) {
 
 	case FT_UINT8:
@@ -1022,12 +1322,15 @@ dissector_add_uint_sanity_check(const char *name, guint32 pattern, dissector_han
 }
 #endif
 
-/* Add an entry to a uint dissector table. */
-void
-dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t handle)
+/*
+ * Look up a uint dissector table to add entries for "handle" to, making
+ * sure the handle and the dissector table exist; returns NULL if they
+ * don't.
+ */
+static dissector_table_t
+dissector_add_uint_find_table(const char *name, dissector_handle_t handle)
 {
 	dissector_table_t  sub_dissectors;
-	dtbl_entry_t      *dtbl_entry;
 
 	sub_dissectors = find_dissector_table(name);
 
@@ -1039,7 +1342,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 		    name);
 		if (wireshark_abort_on_dissector_bug)
 			abort();
-		return;
+		return NULL;
 	}
 	if (sub_dissectors == NULL) {
 		fprintf(stderr, "OOPS: dissector table \"%s\" doesn't exist\n",
@@ -1048,7 +1351,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 		    proto_get_protocol_long_name(handle->protocol));
 		if (wireshark_abort_on_dissector_bug)
 			abort();
-		return;
+		return NULL;
 	}
 
 	switch (sub_dissectors->type) {
@@ -1070,8 +1373,18 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 		g_assert_not_reached();
 	}
 
+	return sub_dissectors;
+}
+
+/* Add an entry to a uint dissector table that's already been looked up. */
+static void
+dissector_add_uint_entry(dissector_table_t sub_dissectors, const guint32 pattern,
+			 dissector_handle_t handle)
+{
+	dtbl_entry_t      *dtbl_entry;
+
 #if 0
-	dissector_add_uint_sanity_check(name, pattern, handle, sub_dissectors);
+	dissector_add_uint_sanity_check(sub_dissectors->ui_name, pattern, handle, sub_dissectors);
 #endif
 
 	dtbl_entry = g_new(dtbl_entry_t, 1);
@@ -1081,6 +1394,20 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	uint_index_set(sub_dissectors, pattern, dtbl_entry);
+}
+
+/* Add an entry to a uint dissector table. */
+void
+dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t handle)
+{
+	dissector_table_t  sub_dissectors;
+
+	sub_dissectors = dissector_add_uint_find_table(name, handle);
+	if (sub_dissectors == NULL)
+		return;
+
+	dissector_add_uint_entry(sub_dissectors, pattern, handle);
 
 	/*
 	 * Now, if this table supports "Decode As", add this handle
@@ -1111,11 +1438,22 @@ void dissector_add_uint_range(const char *name, range_t *range,
 				dissector_add_for_decode_as(name, handle);
 		}
 		else {
+			/*
+			 * Look up the table, and add the handle for
+			 * Decode As, once for the whole range rather
+			 * than once per value; a port range can have
+			 * thousands of values.
+			 */
+			sub_dissectors = dissector_add_uint_find_table(name, handle);
+			if (sub_dissectors == NULL)
+				return;
 			for (i = 0; i < range->nranges; i++) {
 				for (j = range->ranges[i].low; j < range->ranges[i].high; j++)
-					dissector_add_uint(name, j, handle);
-				dissector_add_uint(name, range->ranges[i].high, handle);
+					dissector_add_uint_entry(sub_dissectors, j, handle);
+				dissector_add_uint_entry(sub_dissectors, range->ranges[i].high, handle);
 			}
+			if (sub_dissectors->supports_decode_as)
+				dissector_add_for_decode_as(name, handle);
 		}
 	}
 }
@@ -1242,6 +1580,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		 */
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		uint_index_set(sub_dissectors, pattern, NULL);
 	}
 }
 
@@ -1283,6 +1622,7 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	g_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	uint_index_rebuild(sub_dissectors);
 }
 
 static void
@@ -1292,6 +1632,7 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	g_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	uint_index_rebuild(sub_dissectors);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 }
 
@@ -1337,6 +1678,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	uint_index_set(sub_dissectors, pattern, dtbl_entry);
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1365,6 +1707,7 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	} else {
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		uint_index_set(sub_dissectors, pattern, NULL);
 	}
 }
 
@@ -2499,6 +2842,23 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 		g_error("The dissector table %s (%s) is registering an unsupported type - are you using a buggy plugin?", name, ui_name);
 		g_assert_not_reached();
 	}
+	switch (type) {
+
+	case FT_UINT8:
+		sub_dissectors->uint_index_max = G_MAXUINT8;
+		sub_dissectors->uint_index = g_new0(dtbl_entry_t **, (G_MAXUINT8 >> UINT_INDEX_PAGE_SHIFT) + 1);
+		break;
+
+	case FT_UINT16:
+		sub_dissectors->uint_index_max = G_MAXUINT16;
+		sub_dissectors->uint_index = g_new0(dtbl_entry_t **, (G_MAXUINT16 >> UINT_INDEX_PAGE_SHIFT) + 1);
+		break;
+
+	default:
+		sub_dissectors->uint_index_max = 0;
+		sub_dissectors->uint_index = NULL;
+		break;
+	}
 	sub_dissectors->dissector_handles = NULL;
 	sub_dissectors->ui_name = ui_name;
 	sub_dissectors->type    = type;
@@ -2532,6 +2892,8 @@ dissector_table_t register_custom_dissector_table(const char *name,
 	sub_dissectors->ui_name = ui_name;
 	sub_dissectors->type    = FT_BYTES; /* Consider key a "blob" of data, no need to really create new type */
 	sub_dissectors->param   = BASE_NONE;
+	sub_dissectors->uint_index = NULL;
+	sub_dissectors->uint_index_max = 0;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
 	g_hash_table_insert(dissector_tables, (gpointer)name, (gpointer) sub_dissectors);
@@ -2701,6 +3063,8 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->short_name = g_strdup(internal_name);
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->tries     = 0;
+	hdtbl_entry->matches   = 0;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -2755,6 +3119,157 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 	}
 }
 
+/*
+ * Heuristic dissectors that matched in a conversation, so that later
+ * packets of that conversation try them first, for heuristic dissectors
+ * that don't call conversation_set_dissector() themselves.  Maps a
+ * conversation_t * to a list of heur_conv_match_t.
+ *
+ * Only matches are remembered: a heuristic that rejects a packet may well
+ * accept a later one of the same conversation (once it's seen a handshake,
+ * for example), so a rejection says nothing definite about the flow.
+ */
+typedef struct heur_conv_match {
+	heur_dissector_list_t    list;
+	heur_dtbl_entry_t       *hdtbl_entry;
+	struct heur_conv_match  *next;
+} heur_conv_match_t;
+
+static wmem_map_t *heur_conv_matches = NULL;
+
+static conversation_t *
+heur_find_conversation(packet_info *pinfo)
+{
+	/*
+	 * Like find_conversation_pinfo(), but without updating the
+	 * conversation's last frame; we're only looking.  Packets whose
+	 * dissector chose its own conversation endpoint aren't handled.
+	 */
+	if (pinfo->use_endpoint || pinfo->ptype == PT_NONE)
+		return NULL;
+	return find_conversation(pinfo->num, &pinfo->src, &pinfo->dst,
+				 conversation_pt_to_endpoint_type(pinfo->ptype), pinfo->srcport,
+				 pinfo->destport, 0);
+}
+
+static heur_conv_match_t *
+heur_conv_match_lookup(conversation_t *conversation, heur_dissector_list_t sub_dissectors)
+{
+	heur_conv_match_t *match;
+
+	if (heur_conv_matches == NULL)
+		return NULL;
+
+	for (match = (heur_conv_match_t *)wmem_map_lookup(heur_conv_matches, conversation);
+	     match != NULL; match = match->next) {
+		if (match->list == sub_dissectors)
+			return match;
+	}
+	return NULL;
+}
+
+static void
+heur_conv_match_set(conversation_t *conversation, heur_dissector_list_t sub_dissectors,
+		    heur_dtbl_entry_t *hdtbl_entry)
+{
+	heur_conv_match_t *match = heur_conv_match_lookup(conversation, sub_dissectors);
+
+	if (match != NULL) {
+		match->hdtbl_entry = hdtbl_entry;
+		return;
+	}
+
+	if (heur_conv_matches == NULL)
+		heur_conv_matches = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),
+							   g_direct_hash, g_direct_equal);
+
+	match = wmem_new(wmem_file_scope(), heur_conv_match_t);
+	match->list = sub_dissectors;
+	match->hdtbl_entry = hdtbl_entry;
+	match->next = (heur_conv_match_t *)wmem_map_lookup(heur_conv_matches, conversation);
+	wmem_map_insert(heur_conv_matches, conversation, match);
+}
+
+static gboolean
+heur_entry_enabled(const heur_dtbl_entry_t *hdtbl_entry)
+{
+	return hdtbl_entry->protocol == NULL ||
+		(proto_is_protocol_enabled(hdtbl_entry->protocol) && hdtbl_entry->enabled);
+}
+
+/*
+ * Call one heuristic dissector, adding its protocol to the layers and
+ * taking it back off if the dissector rejected the packet or added
+ * nothing to the tree.
+ */
+static int
+call_heur_dtbl_entry(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb, packet_info *pinfo,
+		     proto_tree *tree, void *data, guint16 saved_can_desegment,
+		     guint saved_layers_len, guint saved_tree_count)
+{
+	int proto_id;
+	int len;
+
+	/* XXX - why set this now and above? */
+	pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
+
+	if (hdtbl_entry->protocol != NULL) {
+		proto_initialize_protocol_prefix(hdtbl_entry->protocol);
+		proto_id = proto_get_id(hdtbl_entry->protocol);
+		/* do NOT change this behavior - wslua uses the protocol short name set here in order
+		   to determine which Lua-based heurisitc dissector to call */
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		pinfo->curr_layer_num++;
+		wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
+	}
+
+	pinfo->heur_list_name = hdtbl_entry->list_name;
+
+	hdtbl_entry->tries++;
+	if (G_UNLIKELY(wmem_stats_enabled() || dissector_profiling)) {
+		const char *saved_tag = wmem_stats_set_tag(pinfo->current_proto);
+		guint prof_depth = 0;
+
+		if (dissector_profiling)
+			prof_depth = dissector_prof_enter(hdtbl_entry->short_name, TRUE);
+		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+		if (dissector_profiling)
+			dissector_prof_leave(prof_depth);
+		wmem_stats_set_tag(saved_tag);
+	} else {
+		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	}
+	if (hdtbl_entry->protocol != NULL &&
+		(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
+		/*
+		 * We added a protocol layer above. The dissector
+		 * didn't accept the packet or it didn't add any
+		 * items to the tree so remove it from the list.
+		 */
+		while (wmem_list_count(pinfo->layers) > saved_layers_len) {
+			if (len == 0) {
+				/*
+				 * Only reduce the layer number if the dissector
+				 * rejected the data. Since tree can be NULL on
+				 * the first pass, we cannot check it or it will
+				 * break dissectors that rely on a stable value.
+				 */
+				pinfo->curr_layer_num--;
+			}
+			wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
+		}
+	}
+	if (len)
+		hdtbl_entry->matches++;
+	return len;
+}
+
 gboolean
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **heur_dtbl_entry, void *data)
@@ -2767,8 +3282,9 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
-	int                proto_id;
-	int                len;
+	heur_dtbl_entry_t *conv_hdtbl_entry = NULL;
+	conversation_t    *conversation;
+	heur_conv_match_t *conv_match;
 	guint              saved_tree_count = tree ? tree->tree_data->count : 0;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
@@ -2793,65 +3309,53 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 	DISSECTOR_ASSERT(saved_layers_len < PINFO_LAYER_MAX_RECURSION_DEPTH);
 
-	for (entry = sub_dissectors->dissectors; entry != NULL;
+	/*
+	 * If a heuristic dissector in this list has matched before in this
+	 * conversation, try it first; only walk the list if it doesn't
+	 * accept this packet.
+	 */
+	conversation = heur_find_conversation(pinfo);
+	conv_match = conversation ? heur_conv_match_lookup(conversation, sub_dissectors) : NULL;
+	if (conv_match != NULL && heur_entry_enabled(conv_match->hdtbl_entry)) {
+		conv_hdtbl_entry = conv_match->hdtbl_entry;
+		if (call_heur_dtbl_entry(conv_hdtbl_entry, tvb, pinfo, tree, data,
+					 saved_can_desegment, saved_layers_len, saved_tree_count)) {
+			*heur_dtbl_entry = conv_hdtbl_entry;
+			status = TRUE;
+		}
+	}
+
+	for (entry = sub_dissectors->dissectors; !status && entry != NULL;
 	    entry = g_slist_next(entry)) {
-		/* XXX - why set this now and above? */
-		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
 
-		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
+		if (hdtbl_entry == conv_hdtbl_entry || !heur_entry_enabled(hdtbl_entry)) {
 			/*
-			 * No - don't try this dissector.
+			 * No - don't try this dissector (again).
 			 */
+			prev_entry = entry;
 			continue;
 		}
 
-		if (hdtbl_entry->protocol != NULL) {
-			proto_id = proto_get_id(hdtbl_entry->protocol);
-			/* do NOT change this behavior - wslua uses the protocol short name set here in order
-			   to determine which Lua-based heurisitc dissector to call */
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
-
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			pinfo->curr_layer_num++;
-			wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
-		}
-
-		pinfo->heur_list_name = hdtbl_entry->list_name;
+		if (call_heur_dtbl_entry(hdtbl_entry, tvb, pinfo, tree, data,
+					 saved_can_desegment, saved_layers_len, saved_tree_count)) {
+			*heur_dtbl_entry = hdtbl_entry;
+			if (conversation != NULL)
+				heur_conv_match_set(conversation, sub_dissectors, hdtbl_entry);
 
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
-		if (hdtbl_entry->protocol != NULL &&
-			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
 			/*
-			 * We added a protocol layer above. The dissector
-			 * didn't accept the packet or it didn't add any
-			 * items to the tree so remove it from the list.
+			 * Move the matched entry up one place if it has now
+			 * matched more often than the one before it, so that
+			 * the list ends up ordered by the number of matches
+			 * and the heuristics that match most get tried first.
+			 * Unlike moving it straight to the top, this doesn't
+			 * keep reshuffling the list when the traffic
+			 * alternates between protocols.
 			 */
-			while (wmem_list_count(pinfo->layers) > saved_layers_len) {
-				if (len == 0) {
-					/*
-					 * Only reduce the layer number if the dissector
-					 * rejected the data. Since tree can be NULL on
-					 * the first pass, we cannot check it or it will
-					 * break dissectors that rely on a stable value.
-					 */
-					pinfo->curr_layer_num--;
-				}
-				wmem_list_remove_frame(pinfo->layers, wmem_list_tail(pinfo->layers));
-			}
-		}
-		if (len) {
-			*heur_dtbl_entry = hdtbl_entry;
-
-			/* Bubble the matched entry to the top for faster search next time. */
-			if (prev_entry != NULL) {
-				sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
-				sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
+			if (prev_entry != NULL &&
+			    hdtbl_entry->matches > ((heur_dtbl_entry_t *)prev_entry->data)->matches) {
+				entry->data = prev_entry->data;
+				prev_entry->data = hdtbl_entry;
 			}
 			status = TRUE;
 			break;
@@ -3277,8 +3781,11 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 {
 	const char        *saved_curr_proto;
 	const char        *saved_heur_list_name;
+	const char        *saved_tag = NULL;
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
+	guint              prof_depth = 0;
+	gboolean           accepted;
 
 	DISSECTOR_ASSERT(heur_dtbl_entry);
 
@@ -3308,6 +3815,7 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 	}
 
 	if (heur_dtbl_entry->protocol != NULL) {
+		proto_initialize_protocol_prefix(heur_dtbl_entry->protocol);
 		/* do NOT change this behavior - wslua uses the protocol short name set here in order
 			to determine which Lua-based heuristic dissector to call */
 		pinfo->current_proto = proto_get_protocol_short_name(heur_dtbl_entry->protocol);
@@ -3317,8 +3825,19 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 
 	pinfo->heur_list_name = heur_dtbl_entry->list_name;
 
+	if (G_UNLIKELY(wmem_stats_enabled()))
+		saved_tag = wmem_stats_set_tag(pinfo->current_proto);
+
+	if (G_UNLIKELY(dissector_profiling))
+		prof_depth = dissector_prof_enter(heur_dtbl_entry->short_name, TRUE);
+
 	/* call the dissector, in case of failure call data handle (might happen with exported PDUs) */
-	if (!(*heur_dtbl_entry->dissector)(tvb, pinfo, tree, data)) {
+	accepted = (*heur_dtbl_entry->dissector)(tvb, pinfo, tree, data);
+
+	if (G_UNLIKELY(dissector_profiling))
+		dissector_prof_leave(prof_depth);
+
+	if (!accepted) {
 		call_dissector_work(data_handle, tvb, pinfo, tree, TRUE, NULL);
 
 		/*
@@ -3337,6 +3856,9 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 	pinfo->current_proto = saved_curr_proto;
 	pinfo->heur_list_name = saved_heur_list_name;
 
+	if (G_UNLIKELY(wmem_stats_enabled()))
+		wmem_stats_set_tag(saved_tag);
+
 }
 
 static gint
@@ -440,6 +440,8 @@ typedef struct heur_dtbl_entry {
 	const gchar *display_name;     /* the string used to present heuristic to user */
 	gchar *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	gboolean enabled;
+	guint64 tries;         /* number of times dissector_try_heuristic() called it, since the file was opened */
+	guint64 matches;       /* number of those times it accepted the packet */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
@@ -615,6 +617,44 @@ WS_DLL_PUBLIC int call_dissector_only(dissector_handle_t handle, tvbuff_t *tvb,
 WS_DLL_PUBLIC void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tvb,
     packet_info *pinfo, proto_tree *tree, void *data);
 
+/** Time spent in one dissector, or one heuristic dissector, while
+ * dissector profiling is enabled. */
+typedef struct dissector_profile {
+	const char *name;      /* dissector name, or heuristic short name */
+	gboolean heuristic;    /* TRUE if called by dissector_try_heuristic() */
+	guint64 calls;         /* number of times it was called */
+	guint64 inclusive_ns;  /* time spent in it and the dissectors it called */
+	guint64 exclusive_ns;  /* time spent in it, without the dissectors it called */
+} dissector_profile_t;
+
+typedef void (*dissector_profile_func)(guint idx, const dissector_profile_t *profile,
+    gpointer user_data);
+
+/** Start or stop timing the dissectors called through handles and the
+ * heuristic dissectors.  While profiling is off, the only cost is a
+ * branch in each dissector call.
+ *
+ * @param enable TRUE to start timing, FALSE to stop
+ */
+WS_DLL_PUBLIC void dissector_profiling_enable(gboolean enable);
+
+/** Return TRUE if dissector profiling is enabled. */
+WS_DLL_PUBLIC gboolean dissector_profiling_enabled(void);
+
+/** Set the counts and times of all dissectors back to zero. */
+WS_DLL_PUBLIC void dissector_profiling_reset(void);
+
+/** Call a function for the profile of each dissector that has been
+ * called since profiling was enabled.  Dissectors keep the index they
+ * are given the first time they are seen, counting from 0, so it can be
+ * used as a row number.
+ *
+ * @param[in] func The function to call for each dissector.
+ * @param[in] user_data User data to pass to the function.
+ */
+WS_DLL_PUBLIC void dissector_profiling_foreach(dissector_profile_func func,
+    gpointer user_data);
+
 /* This is opaque outside of "packet.c". */
 struct depend_dissector_list;
 typedef struct depend_dissector_list *depend_dissector_list_t;
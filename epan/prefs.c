@@ -33,6 +33,8 @@
 #include "print.h"
 #include <wsutil/file_util.h>
 #include <wsutil/report_message.h>
+#include <wsutil/startup_profile.h>
+#include <wsutil/time_util.h>
 
 #include <epan/prefs-int.h>
 #include <epan/uat-int.h>
@@ -919,8 +921,11 @@ call_apply_cb(const void *key _U_, void *value, void *data _U_)
     if (module->obsolete)
         return FALSE;
     if (module->prefs_changed_flags) {
-        if (module->apply_cb != NULL)
+        if (module->apply_cb != NULL) {
+            guint64 start_ns = get_monotonic_ns();
             (*module->apply_cb)();
+            startup_profile_item("prefs_apply", module->name, get_monotonic_ns() - start_ns);
+        }
         module->prefs_changed_flags = 0;
     }
     if (module->submodules)
@@ -937,7 +942,10 @@ call_apply_cb(const void *key _U_, void *value, void *data _U_)
 void
 prefs_apply_all(void)
 {
+    guint profile_phase = startup_profile_begin("prefs_apply_all");
+
     wmem_tree_foreach(prefs_modules, call_apply_cb, NULL);
+    startup_profile_end(profile_phase);
 }
 
 /*
@@ -3727,6 +3735,13 @@ prefs_register_modules(void)
             "without menu path (only the part of the name after last '/' character.)",
             &prefs.st_sort_showfullname);
 
+    prefs_register_uint_preference(stats_module, "st_max_children",
+            "Maximum number of items under a stats_tree node",
+            "Limits how many distinct child items (hosts, URIs, etc.) a stats_tree "
+            "node keeps. Once the limit is reached, values not seen before are "
+            "counted in a single \"" STAT_TREE_OTHERS "\" item. 0 means no limit.",
+            10,&prefs.st_max_children);
+
     /* Protocols */
     protocols_module = prefs_register_module(NULL, "protocols", "Protocols",
                                              "Protocols", NULL, TRUE);
@@ -4262,6 +4277,7 @@ pre_init_prefs(void)
     prefs.st_sort_defcolflag = ST_SORT_COL_COUNT;
     prefs.st_sort_defdescending = TRUE;
     prefs.st_sort_showfullname = FALSE;
+    prefs.st_max_children = 0;
     prefs.display_hidden_proto_items = FALSE;
     prefs.display_byte_fields_with_spaces = FALSE;
 }
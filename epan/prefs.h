@@ -237,6 +237,7 @@ typedef struct _e_prefs {
   gint         st_sort_defcolflag;
   gboolean     st_sort_defdescending;
   gboolean     st_sort_showfullname;
+  guint        st_max_children;
   gboolean     extcap_save_on_start;
 } e_prefs;
 
@@ -33,6 +33,17 @@
 #include <wsutil/utf8_entities.h>
 #include <ftypes/ftypes-int.h>
 
+#ifdef HAVE_ARROW
+#include <arrow-glib/arrow-glib.h>
+#include <parquet-glib/parquet-glib.h>
+#ifdef _WIN32
+#include <io.h>
+#include <gio/gwin32outputstream.h>
+#else
+#include <gio/gunixoutputstream.h>
+#endif
+#endif
+
 #define PDML_VERSION "0"
 #define PSML_VERSION "0"
 
@@ -68,8 +79,12 @@ typedef struct {
 typedef struct {
     output_fields_t *fields;
     epan_dissect_t  *edt;
+    gint             remaining; /* field occurrences still to find, or -1 if unknown */
 } write_field_data_t;
 
+/* Write the buffered "-T fields" and "-T ek" output once it is at least this large */
+#define OUTPUT_FLUSH_SIZE (64 * 1024)
+
 struct _output_fields {
     gboolean      print_bom;
     gboolean      print_header;
@@ -78,9 +93,12 @@ struct _output_fields {
     gchar         aggregator;
     GPtrArray    *fields;
     GHashTable   *field_indicies;
+    GHashTable   *field_ids;      /* hfid -> field index + 1 */
+    GArray       *field_hfids;    /* every hfid in field_ids */
     GPtrArray   **field_values;
     gchar         quote;
     gboolean      includes_col_fields;
+    GString      *out_buf;
 };
 
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
@@ -98,7 +116,7 @@ static void write_specified_fields(fields_format format,
                                    FILE *fh,
                                    json_dumper *dumper);
 static void print_escaped_xml(FILE *fh, const char *unescaped_string);
-static void print_escaped_csv(FILE *fh, const char *unescaped_string);
+static void append_escaped_csv(GString *buf, const char *unescaped_string);
 
 typedef void (*proto_node_value_writer)(proto_node *, write_json_data *);
 static void write_json_index(json_dumper *dumper, epan_dissect_t *edt);
@@ -127,6 +145,20 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data);
 static int proto_data = -1;
 static int proto_frame = -1;
 
+/* Buffered "-T ek" output, see write_ek_flush() */
+static GString *ek_out_buf = NULL;
+
+/*
+ * EK attribute names, computed once per field: ek_name_cache and
+ * ek_raw_name_cache map an hfid to the "<parent>_<abbrev>" name written
+ * for it (with "_raw" appended in the latter), and ek_attr_key_cache maps
+ * a (tree parent hfid, hfid) pair to the interned key used to group the
+ * instances of a field under one attribute.
+ */
+static GHashTable *ek_name_cache = NULL;
+static GHashTable *ek_raw_name_cache = NULL;
+static GHashTable *ek_attr_key_cache = NULL;
+
 void print_cache_field_handles(void)
 {
     proto_data = proto_get_id_by_short_name("Data");
@@ -351,8 +383,12 @@ write_ek_proto_tree(output_fields_t* fields,
 
     write_json_data data;
 
+    /* Formatted into ek_out_buf, which is written out in large chunks */
+    if (ek_out_buf == NULL)
+        ek_out_buf = g_string_sized_new(OUTPUT_FLUSH_SIZE + 4096);
+
     json_dumper dumper = {
-        .output_file = fh,
+        .output_string = ek_out_buf,
         .flags = JSON_DUMPER_DOT_TO_UNDERSCORE
     };
 
@@ -396,6 +432,26 @@ write_ek_proto_tree(output_fields_t* fields,
     }
     json_dumper_end_object(&dumper);
     json_dumper_finish(&dumper);
+
+    if (ek_out_buf->len >= OUTPUT_FLUSH_SIZE)
+        write_ek_flush(fh);
+}
+
+void
+write_ek_flush(FILE *fh)
+{
+    g_assert(fh);
+
+    if (ek_out_buf != NULL && ek_out_buf->len != 0) {
+        fwrite(ek_out_buf->str, 1, ek_out_buf->len, fh);
+        g_string_truncate(ek_out_buf, 0);
+    }
+}
+
+void
+write_ek_finale(FILE *fh)
+{
+    write_ek_flush(fh);
 }
 
 void
@@ -406,6 +462,19 @@ write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_inf
 
     /* Create the output */
     write_specified_fields(FORMAT_CSV, fields, edt, cinfo, fh, NULL);
+    write_fields_flush(fields, fh);
+}
+
+void
+write_fields_proto_tree_buffered(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh)
+{
+    g_assert(edt);
+    g_assert(fh);
+
+    write_specified_fields(FORMAT_CSV, fields, edt, cinfo, fh, NULL);
+    g_string_append_c(fields->out_buf, '\n');
+    if (fields->out_buf->len >= OUTPUT_FLUSH_SIZE)
+        write_fields_flush(fields, fh);
 }
 
 /* Indent to the correct level */
@@ -1140,18 +1209,52 @@ write_ek_summary(column_info *cinfo, write_json_data* pdata)
     for (i = 0; i < cinfo->num_cols; i++) {
         if (!get_column_visible(i))
             continue;
-        json_dumper_set_member_name(pdata->dumper, g_ascii_strdown(cinfo->columns[i].col_title, -1));
+        gchar *name = g_ascii_strdown(cinfo->columns[i].col_title, -1);
+
+        json_dumper_set_member_name(pdata->dumper, name);
+        g_free(name);
         json_dumper_value_string(pdata->dumper, cinfo->columns[i].col_data);
     }
 }
 
+/*
+ * Return the key grouping the instances of hfinfo below a node for parent
+ * (NULL at the top level).  Keys are interned, so equal names compare
+ * equal as pointers.
+ */
+static const gchar *
+ek_attr_key(header_field_info *parent, header_field_info *hfinfo)
+{
+    gint64       pair;
+    const gchar *key;
+
+    pair = (gint64)(((guint64)(guint32)(parent != NULL ? parent->id : -1) << 32) | (guint32)hfinfo->id);
+
+    if (ek_attr_key_cache == NULL)
+        ek_attr_key_cache = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+
+    key = (const gchar *)g_hash_table_lookup(ek_attr_key_cache, &pair);
+    if (key == NULL) {
+        gchar *name;
+
+        if (parent == NULL)
+            name = g_strdup(hfinfo->abbrev);
+        else
+            name = g_strconcat(parent->abbrev, "_", hfinfo->abbrev, NULL);
+        key = g_intern_string(name);
+        g_free(name);
+        g_hash_table_insert(ek_attr_key_cache, g_memdup2(&pair, sizeof pair), (gpointer)key);
+    }
+    return key;
+}
+
 /* Write out a tree's data, and any child nodes, as JSON for EK */
 static void
 ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write_json_data *pdata)
 {
     field_info *fi         = NULL;
     field_info *fi_parent  = NULL;
-    gchar *node_name       = NULL;
+    const gchar *node_name = NULL;
     GSList *attr_instances = NULL;
 
     proto_node *current_node = node->first_child;
@@ -1162,11 +1265,7 @@ ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write
         /* dissection with an invisible proto tree? */
         g_assert(fi);
 
-        if (fi_parent == NULL) {
-            node_name = g_strdup(fi->hfinfo->abbrev);
-        } else {
-            node_name = g_strconcat(fi_parent->hfinfo->abbrev, "_", fi->hfinfo->abbrev, NULL);
-        }
+        node_name = ek_attr_key(fi_parent != NULL ? fi_parent->hfinfo : NULL, fi->hfinfo);
 
         attr_instances = (GSList *) g_hash_table_lookup(attr_table, node_name);
         // First time we encounter this attr
@@ -1178,7 +1277,7 @@ ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write
         }
 
         // Update instance list for this attr in hash table
-        g_hash_table_insert(attr_table, node_name, attr_instances);
+        g_hash_table_insert(attr_table, (gpointer)node_name, attr_instances);
 
         /* Field, recurse through children*/
         if (fi->hfinfo->type != FT_PROTOCOL && current_node->first_child != NULL) {
@@ -1212,20 +1311,26 @@ ek_fill_attr(proto_node *node, GSList **attr_list, GHashTable *attr_table, write
 }
 
 static void
-ek_write_name(proto_node *pnode, gchar* suffix, write_json_data* pdata)
+ek_write_name(proto_node *pnode, gboolean raw, write_json_data* pdata)
 {
-    field_info *fi = PNODE_FINFO(pnode);
-    gchar      *str;
+    field_info  *fi = PNODE_FINFO(pnode);
+    GHashTable **cache = raw ? &ek_raw_name_cache : &ek_name_cache;
+    gchar       *str;
 
-    if (fi->hfinfo->parent != -1) {
-        header_field_info* parent = proto_registrar_get_nth(fi->hfinfo->parent);
-        str = g_strdup_printf("%s_%s%s", parent->abbrev, fi->hfinfo->abbrev, suffix ? suffix : "");
-        json_dumper_set_member_name(pdata->dumper, str);
-    } else {
-        str = g_strdup_printf("%s%s", fi->hfinfo->abbrev, suffix ? suffix : "");
-        json_dumper_set_member_name(pdata->dumper, str);
+    if (*cache == NULL)
+        *cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+    str = (gchar *)g_hash_table_lookup(*cache, GINT_TO_POINTER(fi->hfinfo->id));
+    if (str == NULL) {
+        if (fi->hfinfo->parent != -1) {
+            header_field_info* parent = proto_registrar_get_nth(fi->hfinfo->parent);
+            str = g_strdup_printf("%s_%s%s", parent->abbrev, fi->hfinfo->abbrev, raw ? "_raw" : "");
+        } else {
+            str = g_strdup_printf("%s%s", fi->hfinfo->abbrev, raw ? "_raw" : "");
+        }
+        g_hash_table_insert(*cache, GINT_TO_POINTER(fi->hfinfo->id), str);
     }
-    g_free(str);
+    json_dumper_set_member_name(pdata->dumper, str);
 }
 
 static void
@@ -1356,7 +1461,7 @@ ek_write_attr_hex(GSList *attr_instances, write_json_data *pdata)
     field_info *fi       = NULL;
 
     // Raw name
-    ek_write_name(pnode, "_raw", pdata);
+    ek_write_name(pnode, TRUE, pdata);
 
     if (g_slist_length(attr_instances) > 1) {
         json_dumper_begin_array(pdata->dumper);
@@ -1390,7 +1495,7 @@ ek_write_attr(GSList *attr_instances, write_json_data *pdata)
     }
 
     // Print attr name
-    ek_write_name(pnode, NULL, pdata);
+    ek_write_name(pnode, FALSE, pdata);
 
     if (g_slist_length(attr_instances) > 1) {
         json_dumper_begin_array(pdata->dumper);
@@ -1457,7 +1562,7 @@ static void
 proto_tree_write_node_ek(proto_node *node, write_json_data *pdata)
 {
     GSList *attr_list  = NULL;
-    GHashTable *attr_table  = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GHashTable *attr_table  = g_hash_table_new(g_direct_hash, g_direct_equal);
 
     ek_fill_attr(node, &attr_list, attr_table, pdata);
 
@@ -1818,35 +1923,43 @@ print_escaped_xml(FILE *fh, const char *unescaped_string)
 }
 
 static void
-print_escaped_csv(FILE *fh, const char *unescaped_string)
+append_escaped_csv(GString *buf, const char *unescaped_string)
 {
     const char *p;
+    const char *run;
 
-    if (fh == NULL || unescaped_string == NULL) {
+    if (buf == NULL || unescaped_string == NULL) {
         return;
     }
 
-    for (p = unescaped_string; *p != '\0'; p++) {
+    /* Copy runs of characters that need no escaping in one go */
+    for (run = p = unescaped_string; *p != '\0'; p++) {
+        const char *escaped;
+
         switch (*p) {
         case '\b':
-            fputs("\\b", fh);
+            escaped = "\\b";
             break;
         case '\f':
-            fputs("\\f", fh);
+            escaped = "\\f";
             break;
         case '\n':
-            fputs("\\n", fh);
+            escaped = "\\n";
             break;
         case '\r':
-            fputs("\\r", fh);
+            escaped = "\\r";
             break;
         case '\t':
-            fputs("\\t", fh);
+            escaped = "\\t";
             break;
         default:
-            fputc(*p, fh);
+            continue;
         }
+        g_string_append_len(buf, run, p - run);
+        g_string_append_len(buf, escaped, 2);
+        run = p + 1;
     }
+    g_string_append_len(buf, run, p - run);
 }
 
 static void
@@ -2092,6 +2205,11 @@ void output_fields_free(output_fields_t* fields)
             g_hash_table_destroy(fields->field_indicies);
         }
 
+        if (NULL != fields->field_ids) {
+            g_hash_table_destroy(fields->field_ids);
+            g_array_free(fields->field_hfids, TRUE);
+        }
+
         if (NULL != fields->field_values) {
             g_free(fields->field_values);
         }
@@ -2103,6 +2221,10 @@ void output_fields_free(output_fields_t* fields)
         g_ptr_array_free(fields->fields, TRUE);
     }
 
+    if (NULL != fields->out_buf) {
+        g_string_free(fields->out_buf, TRUE);
+    }
+
     g_free(fields);
 }
 
@@ -2387,6 +2509,7 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     write_field_data_t *call_data;
     field_info *fi;
     gpointer    field_index;
+    proto_node *child;
 
     call_data = (write_field_data_t *)data;
     fi = PNODE_FINFO(node);
@@ -2394,20 +2517,98 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     /* dissection with an invisible proto tree? */
     g_assert(fi);
 
-    field_index = g_hash_table_lookup(call_data->fields->field_indicies, fi->hfinfo->abbrev);
+    field_index = g_hash_table_lookup(call_data->fields->field_ids, GINT_TO_POINTER(fi->hfinfo->id));
     if (NULL != field_index) {
         format_field_values(call_data->fields, field_index,
                             get_node_field_value(fi, call_data->edt) /* g_ alloc'd string */
             );
+        if (call_data->remaining > 0)
+            call_data->remaining--;
     }
 
-    /* Recurse here. */
-    if (node->first_child != NULL) {
-        proto_tree_children_foreach(node, proto_tree_get_node_field_values,
-                                    call_data);
+    /* Recurse here, unless every wanted field has already been found. */
+    for (child = node->first_child; child != NULL && call_data->remaining != 0; child = child->next) {
+        proto_tree_get_node_field_values(child, call_data);
+    }
+}
+
+/*
+ * Build the lookup tables from field abbreviation and from hfid to the
+ * field's index; the hfid table covers every field registered with the
+ * same abbreviation, so that the tree walk needs no string lookups.
+ */
+static void output_fields_prepare(output_fields_t *fields)
+{
+    gsize i;
+
+    if (NULL != fields->field_indicies)
+        return;
+
+    fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
+    fields->field_ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+    fields->field_hfids = g_array_new(FALSE, FALSE, sizeof(int));
+
+    i = 0;
+    while (i < fields->fields->len) {
+        gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+        header_field_info *hfinfo;
+
+        /* Store field indicies +1 so that zero is not a valid value,
+         * and can be distinguished from NULL as a pointer.
+         */
+        ++i;
+        g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
+
+        hfinfo = proto_registrar_get_byname(field);
+        if (NULL == hfinfo)
+            continue;
+        while (hfinfo->same_name_prev_id != -1)
+            hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+        for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+            if (NULL == g_hash_table_lookup(fields->field_ids, GINT_TO_POINTER(hfinfo->id)))
+                g_array_append_val(fields->field_hfids, hfinfo->id);
+            g_hash_table_insert(fields->field_ids, GINT_TO_POINTER(hfinfo->id), GUINT_TO_POINTER(i));
+        }
     }
 }
 
+void output_fields_prime_edt(output_fields_t *fields, epan_dissect_t *edt)
+{
+    g_assert(fields);
+    g_assert(edt);
+
+    if (NULL == fields->fields)
+        return;
+
+    output_fields_prepare(fields);
+    if (fields->field_hfids->len != 0)
+        epan_dissect_prime_with_hfid_array(edt, fields->field_hfids);
+}
+
+/*
+ * Return the number of occurrences of the wanted fields in the tree, or
+ * -1 if that can't be known because a field was not primed before the
+ * packet was dissected.
+ */
+static gint output_fields_count_occurrences(output_fields_t *fields, epan_dissect_t *edt)
+{
+    gint  count = 0;
+    guint i;
+
+    for (i = 0; i < fields->field_hfids->len; i++) {
+        int hfid = g_array_index(fields->field_hfids, int, i);
+        header_field_info *hfinfo = proto_registrar_get_nth(hfid);
+        GPtrArray *finfos;
+
+        if (hfinfo->ref_type != HF_REF_TYPE_DIRECT)
+            return -1;
+        finfos = proto_get_finfo_ptr_array(edt->tree, hfid);
+        if (finfos != NULL)
+            count += finfos->len;
+    }
+    return count;
+}
+
 static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh, json_dumper *dumper)
 {
     gsize     i;
@@ -2427,23 +2628,11 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
         g_assert(fh && !dumper);
     }
 
+    output_fields_prepare(fields);
+
     data.fields = fields;
     data.edt = edt;
-
-    if (NULL == fields->field_indicies) {
-        /* Prepare a lookup table from string abbreviation for field to its index. */
-        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
-
-        i = 0;
-        while (i < fields->fields->len) {
-            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
-            /* Store field indicies +1 so that zero is not a valid value,
-             * and can be distinguished from NULL as a pointer.
-             */
-            ++i;
-            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
-        }
-    }
+    data.remaining = output_fields_count_occurrences(fields, edt);
 
     /* Array buffer to store values for this packet              */
     /*  Allocate an array for the 'GPtrarray *' the first time   */
@@ -2454,8 +2643,13 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     if (NULL == fields->field_values)
         fields->field_values = g_new0(GPtrArray*, fields->fields->len);  /* free'd in output_fields_free() */
 
-    proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
-                                &data);
+    if (edt->tree != NULL) {
+        proto_node *node;
+
+        for (node = edt->tree->first_child; node != NULL && data.remaining != 0; node = node->next) {
+            proto_tree_get_node_field_values(node, &data);
+        }
+    }
 
     /* Add columns to fields */
     if (fields->includes_col_fields) {
@@ -2475,9 +2669,12 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
 
     switch (format) {
     case FORMAT_CSV:
+        /* Formatted into fields->out_buf; the caller writes it out */
+        if (NULL == fields->out_buf)
+            fields->out_buf = g_string_sized_new(OUTPUT_FLUSH_SIZE + 4096);
         for(i = 0; i < fields->fields->len; ++i) {
             if (0 != i) {
-                fputc(fields->separator, fh);
+                g_string_append_c(fields->out_buf, fields->separator);
             }
             if (NULL != fields->field_values[i]) {
                 GPtrArray *fv_p;
@@ -2485,17 +2682,17 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
                 gsize j;
                 fv_p = fields->field_values[i];
                 if (fields->quote != '\0') {
-                    fputc(fields->quote, fh);
+                    g_string_append_c(fields->out_buf, fields->quote);
                 }
 
                 /* Output the array of (partial) field values */
                 for (j = 0; j < g_ptr_array_len(fv_p); j++ ) {
                     str = (gchar *)g_ptr_array_index(fv_p, j);
-                    print_escaped_csv(fh, str);
+                    append_escaped_csv(fields->out_buf, str);
                     g_free(str);
                 }
                 if (fields->quote != '\0') {
-                    fputc(fields->quote, fh);
+                    g_string_append_c(fields->out_buf, fields->quote);
                 }
                 g_ptr_array_free(fv_p, TRUE);  /* get ready for the next packet */
                 fields->field_values[i] = NULL;
@@ -2591,10 +2788,515 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     }
 }
 
-void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
+void write_fields_flush(output_fields_t* fields, FILE *fh)
+{
+    g_assert(fields);
+    g_assert(fh);
+
+    if (NULL != fields->out_buf && fields->out_buf->len != 0) {
+        fwrite(fields->out_buf->str, 1, fields->out_buf->len, fh);
+        g_string_truncate(fields->out_buf, 0);
+    }
+}
+
+void write_fields_finale(output_fields_t* fields, FILE *fh)
+{
+    write_fields_flush(fields, fh);
+}
+
+#ifdef HAVE_ARROW
+/* Number of packets per record batch (and Parquet row group) by default */
+#define ARROW_DEFAULT_BATCH_ROWS 65536
+
+typedef enum {
+    ARROW_COLUMN_STRING,        /* utf8: the -T fields representation */
+    ARROW_COLUMN_BOOLEAN,
+    ARROW_COLUMN_UINT32,
+    ARROW_COLUMN_UINT64,
+    ARROW_COLUMN_INT32,
+    ARROW_COLUMN_INT64,
+    ARROW_COLUMN_DOUBLE,
+    ARROW_COLUMN_TIMESTAMP,     /* timestamp[ns, UTC] */
+    ARROW_COLUMN_DURATION,      /* int64 nanoseconds */
+    ARROW_COLUMN_IPV4,          /* binary, 4 bytes in network order */
+    ARROW_COLUMN_IPV6,          /* binary, 16 bytes */
+    ARROW_COLUMN_BYTES          /* binary */
+} arrow_column_type_e;
+
+typedef struct {
+    arrow_column_type_e  type;
+    GArray              *hfids;     /* every hfid with the column's abbreviation */
+    const gchar         *col_title; /* for "_ws.col." fields, else NULL */
+    GArrowDataType      *data_type;
+    GArrowArrayBuilder  *builder;
+} arrow_column_t;
+
+struct _arrow_writer {
+    output_fields_t         *fields;
+    arrow_format_e           format;
+    guint                    batch_rows;
+    guint                    n_rows;     /* rows in the current batch */
+    guint                    n_columns;
+    arrow_column_t          *columns;
+    GArrowSchema            *schema;
+    GOutputStream           *raw;
+    GArrowOutputStream      *sink;
+    GArrowRecordBatchWriter *ipc_writer;
+    GParquetArrowFileWriter *parquet_writer;
+};
+
+static arrow_column_type_e
+arrow_column_type(enum ftenum type)
+{
+    if (IS_FT_UINT32(type) || type == FT_IPXNET)
+        return ARROW_COLUMN_UINT32;
+    if (IS_FT_UINT64(type))
+        return ARROW_COLUMN_UINT64;
+    if (IS_FT_INT32(type))
+        return ARROW_COLUMN_INT32;
+    if (IS_FT_INT64(type))
+        return ARROW_COLUMN_INT64;
+
+    switch (type) {
+    case FT_BOOLEAN:
+        return ARROW_COLUMN_BOOLEAN;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        return ARROW_COLUMN_DOUBLE;
+    case FT_ABSOLUTE_TIME:
+        return ARROW_COLUMN_TIMESTAMP;
+    case FT_RELATIVE_TIME:
+        return ARROW_COLUMN_DURATION;
+    case FT_IPv4:
+        return ARROW_COLUMN_IPV4;
+    case FT_IPv6:
+        return ARROW_COLUMN_IPV6;
+    case FT_ETHER:
+    case FT_BYTES:
+    case FT_UINT_BYTES:
+        return ARROW_COLUMN_BYTES;
+    default:
+        return ARROW_COLUMN_STRING;
+    }
+}
+
+static GArrowDataType *
+arrow_column_data_type(arrow_column_type_e type)
+{
+    switch (type) {
+    case ARROW_COLUMN_BOOLEAN:
+        return GARROW_DATA_TYPE(garrow_boolean_data_type_new());
+    case ARROW_COLUMN_UINT32:
+        return GARROW_DATA_TYPE(garrow_uint32_data_type_new());
+    case ARROW_COLUMN_UINT64:
+        return GARROW_DATA_TYPE(garrow_uint64_data_type_new());
+    case ARROW_COLUMN_INT32:
+        return GARROW_DATA_TYPE(garrow_int32_data_type_new());
+    case ARROW_COLUMN_INT64:
+    case ARROW_COLUMN_DURATION:
+        return GARROW_DATA_TYPE(garrow_int64_data_type_new());
+    case ARROW_COLUMN_DOUBLE:
+        return GARROW_DATA_TYPE(garrow_double_data_type_new());
+    case ARROW_COLUMN_TIMESTAMP:
+    {
+        GArrowDataType *data_type;
+#if GARROW_VERSION_CHECK(16, 0, 0)
+        GTimeZone *utc = g_time_zone_new_utc();
+
+        data_type = GARROW_DATA_TYPE(garrow_timestamp_data_type_new(GARROW_TIME_UNIT_NANO, utc));
+        g_time_zone_unref(utc);
+#else
+        data_type = GARROW_DATA_TYPE(garrow_timestamp_data_type_new(GARROW_TIME_UNIT_NANO));
+#endif
+        return data_type;
+    }
+    case ARROW_COLUMN_IPV4:
+    case ARROW_COLUMN_IPV6:
+    case ARROW_COLUMN_BYTES:
+        return GARROW_DATA_TYPE(garrow_binary_data_type_new());
+    case ARROW_COLUMN_STRING:
+    default:
+        return GARROW_DATA_TYPE(garrow_string_data_type_new());
+    }
+}
+
+static GArrowArrayBuilder *
+arrow_column_builder_new(arrow_column_t *column)
+{
+    switch (column->type) {
+    case ARROW_COLUMN_BOOLEAN:
+        return GARROW_ARRAY_BUILDER(garrow_boolean_array_builder_new());
+    case ARROW_COLUMN_UINT32:
+        return GARROW_ARRAY_BUILDER(garrow_uint32_array_builder_new());
+    case ARROW_COLUMN_UINT64:
+        return GARROW_ARRAY_BUILDER(garrow_uint64_array_builder_new());
+    case ARROW_COLUMN_INT32:
+        return GARROW_ARRAY_BUILDER(garrow_int32_array_builder_new());
+    case ARROW_COLUMN_INT64:
+    case ARROW_COLUMN_DURATION:
+        return GARROW_ARRAY_BUILDER(garrow_int64_array_builder_new());
+    case ARROW_COLUMN_DOUBLE:
+        return GARROW_ARRAY_BUILDER(garrow_double_array_builder_new());
+    case ARROW_COLUMN_TIMESTAMP:
+        return GARROW_ARRAY_BUILDER(garrow_timestamp_array_builder_new(GARROW_TIMESTAMP_DATA_TYPE(column->data_type)));
+    case ARROW_COLUMN_IPV4:
+    case ARROW_COLUMN_IPV6:
+    case ARROW_COLUMN_BYTES:
+        return GARROW_ARRAY_BUILDER(garrow_binary_array_builder_new());
+    case ARROW_COLUMN_STRING:
+    default:
+        return GARROW_ARRAY_BUILDER(garrow_string_array_builder_new());
+    }
+}
+
+/*
+ * Set up a column for the field with the given abbreviation.  A field
+ * registered more than once with different kinds of types is written
+ * as a string.
+ */
+static void
+arrow_column_init(arrow_column_t *column, const gchar *field)
+{
+    header_field_info *hfinfo;
+
+    column->type = ARROW_COLUMN_STRING;
+    column->hfids = g_array_new(FALSE, FALSE, sizeof(int));
+    column->col_title = NULL;
+
+    if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER))) {
+        column->col_title = field + strlen(COLUMN_FIELD_FILTER);
+    } else if ((hfinfo = proto_registrar_get_byname(field)) != NULL) {
+        while (hfinfo->same_name_prev_id != -1)
+            hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+        column->type = arrow_column_type(hfinfo->type);
+        for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+            if (arrow_column_type(hfinfo->type) != column->type)
+                column->type = ARROW_COLUMN_STRING;
+            g_array_append_val(column->hfids, hfinfo->id);
+        }
+    }
+
+    column->data_type = arrow_column_data_type(column->type);
+    column->builder = arrow_column_builder_new(column);
+}
+
+/*
+ * Find the occurrence of the column's field selected by "-E occurrence";
+ * with more than one occurrence, "a" (all) selects the first one.
+ */
+static field_info *
+arrow_column_find_finfo(arrow_column_t *column, gchar occurrence, epan_dissect_t *edt)
+{
+    field_info *found = NULL;
+    guint       i;
+
+    for (i = 0; i < column->hfids->len; i++) {
+        int hfid = g_array_index(column->hfids, int, i);
+        gboolean primed = proto_registrar_get_nth(hfid)->ref_type == HF_REF_TYPE_DIRECT;
+        GPtrArray *finfos;
+
+        if (primed)
+            finfos = proto_get_finfo_ptr_array(edt->tree, hfid);
+        else if (occurrence == 'l')
+            finfos = proto_find_finfo(edt->tree, hfid);
+        else
+            finfos = proto_find_first_finfo(edt->tree, hfid);
+
+        if (finfos != NULL && finfos->len != 0)
+            found = (field_info *)g_ptr_array_index(finfos, occurrence == 'l' ? finfos->len - 1 : 0);
+        if (!primed && finfos != NULL)
+            g_ptr_array_free(finfos, TRUE);
+        if (found != NULL && occurrence != 'l')
+            break;
+    }
+    return found;
+}
+
+static gboolean
+arrow_column_append(arrow_column_t *column, field_info *fi, epan_dissect_t *edt, GError **error)
+{
+    GArrowArrayBuilder *builder = column->builder;
+    nstime_t   *ts;
+    guint32     ipv4;
+    gchar      *str;
+    gboolean    ok;
+
+    if (fi == NULL)
+        return garrow_array_builder_append_null(builder, error);
+
+    switch (column->type) {
+    case ARROW_COLUMN_BOOLEAN:
+        return garrow_boolean_array_builder_append_value(GARROW_BOOLEAN_ARRAY_BUILDER(builder),
+                fvalue_get_uinteger64(&fi->value) != 0, error);
+    case ARROW_COLUMN_UINT32:
+        return garrow_uint32_array_builder_append_value(GARROW_UINT32_ARRAY_BUILDER(builder),
+                fvalue_get_uinteger(&fi->value), error);
+    case ARROW_COLUMN_UINT64:
+        return garrow_uint64_array_builder_append_value(GARROW_UINT64_ARRAY_BUILDER(builder),
+                fvalue_get_uinteger64(&fi->value), error);
+    case ARROW_COLUMN_INT32:
+        return garrow_int32_array_builder_append_value(GARROW_INT32_ARRAY_BUILDER(builder),
+                fvalue_get_sinteger(&fi->value), error);
+    case ARROW_COLUMN_INT64:
+        return garrow_int64_array_builder_append_value(GARROW_INT64_ARRAY_BUILDER(builder),
+                fvalue_get_sinteger64(&fi->value), error);
+    case ARROW_COLUMN_DOUBLE:
+        return garrow_double_array_builder_append_value(GARROW_DOUBLE_ARRAY_BUILDER(builder),
+                fvalue_get_floating(&fi->value), error);
+    case ARROW_COLUMN_TIMESTAMP:
+        ts = (nstime_t *)fvalue_get(&fi->value);
+        return garrow_timestamp_array_builder_append_value(GARROW_TIMESTAMP_ARRAY_BUILDER(builder),
+                (gint64)ts->secs * 1000000000 + ts->nsecs, error);
+    case ARROW_COLUMN_DURATION:
+        ts = (nstime_t *)fvalue_get(&fi->value);
+        return garrow_int64_array_builder_append_value(GARROW_INT64_ARRAY_BUILDER(builder),
+                (gint64)ts->secs * 1000000000 + ts->nsecs, error);
+    case ARROW_COLUMN_IPV4:
+        ipv4 = g_htonl(fvalue_get_uinteger(&fi->value));
+        return garrow_binary_array_builder_append_value(GARROW_BINARY_ARRAY_BUILDER(builder),
+                (const guint8 *)&ipv4, 4, error);
+    case ARROW_COLUMN_IPV6:
+        return garrow_binary_array_builder_append_value(GARROW_BINARY_ARRAY_BUILDER(builder),
+                (const guint8 *)fvalue_get(&fi->value), 16, error);
+    case ARROW_COLUMN_BYTES:
+        return garrow_binary_array_builder_append_value(GARROW_BINARY_ARRAY_BUILDER(builder),
+                (const guint8 *)fvalue_get(&fi->value), fvalue_length(&fi->value), error);
+    case ARROW_COLUMN_STRING:
+    default:
+        str = get_node_field_value(fi, edt);
+        ok = garrow_string_array_builder_append_string(GARROW_STRING_ARRAY_BUILDER(builder), str, error);
+        g_free(str);
+        return ok;
+    }
+}
+
+/* Turn the rows accumulated in the builders into a record batch and write it */
+static gboolean
+arrow_writer_flush_batch(arrow_writer_t *writer, GError **error)
+{
+    GList             *arrays = NULL;
+    GArrowRecordBatch *batch = NULL;
+    GArrowTable       *table;
+    gboolean           ok = TRUE;
+    guint              i;
+
+    if (writer->n_rows == 0)
+        return TRUE;
+
+    for (i = writer->n_columns; i > 0; i--) {
+        GArrowArray *array = garrow_array_builder_finish(writer->columns[i - 1].builder, error);
+
+        if (array == NULL) {
+            ok = FALSE;
+            break;
+        }
+        arrays = g_list_prepend(arrays, array);
+    }
+
+    if (ok) {
+        batch = garrow_record_batch_new(writer->schema, writer->n_rows, arrays, error);
+        ok = batch != NULL;
+    }
+
+    if (ok) {
+        if (writer->format == ARROW_FORMAT_PARQUET) {
+            table = garrow_table_new_record_batches(writer->schema, &batch, 1, error);
+            ok = table != NULL &&
+                 gparquet_arrow_file_writer_write_table(writer->parquet_writer, table, writer->n_rows, error);
+            if (table != NULL)
+                g_object_unref(table);
+        } else {
+            ok = garrow_record_batch_writer_write_record_batch(writer->ipc_writer, batch, error);
+        }
+    }
+
+    if (batch != NULL)
+        g_object_unref(batch);
+    g_list_free_full(arrays, g_object_unref);
+    writer->n_rows = 0;
+    return ok;
+}
+
+static void
+arrow_writer_free(arrow_writer_t *writer)
+{
+    guint i;
+
+    if (writer->ipc_writer != NULL)
+        g_object_unref(writer->ipc_writer);
+    if (writer->parquet_writer != NULL)
+        g_object_unref(writer->parquet_writer);
+    if (writer->sink != NULL)
+        g_object_unref(writer->sink);
+    if (writer->raw != NULL)
+        g_object_unref(writer->raw);
+    if (writer->schema != NULL)
+        g_object_unref(writer->schema);
+    for (i = 0; i < writer->n_columns; i++) {
+        g_array_free(writer->columns[i].hfids, TRUE);
+        g_object_unref(writer->columns[i].builder);
+        g_object_unref(writer->columns[i].data_type);
+    }
+    g_free(writer->columns);
+    g_free(writer);
+}
+
+static gboolean
+arrow_set_err_msg(GError *error, gchar **err_msg)
+{
+    if (err_msg != NULL)
+        *err_msg = g_strdup(error != NULL ? error->message : "Unknown Arrow error");
+    if (error != NULL)
+        g_error_free(error);
+    return FALSE;
+}
+
+arrow_writer_t *
+write_arrow_preamble(output_fields_t* fields, arrow_format_e format, guint batch_rows, FILE *fh, gchar **err_msg)
+{
+    arrow_writer_t *writer;
+    GList          *schema_fields = NULL;
+    GError         *error = NULL;
+    guint           i;
+
+    g_assert(fields);
+    g_assert(fields->fields);
+    g_assert(fh);
+
+    writer = g_new0(arrow_writer_t, 1);
+    writer->fields = fields;
+    writer->format = format;
+    writer->batch_rows = batch_rows != 0 ? batch_rows : ARROW_DEFAULT_BATCH_ROWS;
+    writer->n_columns = fields->fields->len;
+    writer->columns = g_new0(arrow_column_t, writer->n_columns);
+
+    for (i = writer->n_columns; i > 0; i--) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i - 1);
+
+        arrow_column_init(&writer->columns[i - 1], field);
+        schema_fields = g_list_prepend(schema_fields,
+                                       garrow_field_new(field, writer->columns[i - 1].data_type));
+    }
+    writer->schema = garrow_schema_new(schema_fields);
+    g_list_free_full(schema_fields, g_object_unref);
+
+    /* Anything already written with stdio must come first */
+    fflush(fh);
+#ifdef _WIN32
+    writer->raw = g_win32_output_stream_new((void *)_get_osfhandle(_fileno(fh)), FALSE);
+#else
+    writer->raw = g_unix_output_stream_new(fileno(fh), FALSE);
+#endif
+    writer->sink = GARROW_OUTPUT_STREAM(garrow_gio_output_stream_new(writer->raw));
+
+    if (format == ARROW_FORMAT_PARQUET) {
+        writer->parquet_writer = gparquet_arrow_file_writer_new_arrow(writer->schema, writer->sink, NULL, &error);
+        if (writer->parquet_writer == NULL)
+            goto fail;
+    } else {
+        writer->ipc_writer = GARROW_RECORD_BATCH_WRITER(
+                garrow_record_batch_stream_writer_new(writer->sink, writer->schema, &error));
+        if (writer->ipc_writer == NULL)
+            goto fail;
+    }
+    return writer;
+
+fail:
+    arrow_set_err_msg(error, err_msg);
+    arrow_writer_free(writer);
+    return NULL;
+}
+
+gboolean
+write_arrow_proto_tree(arrow_writer_t *writer, epan_dissect_t *edt, column_info *cinfo, gchar **err_msg)
 {
-    /* Nothing to do */
+    GError *error = NULL;
+    guint   i;
+
+    g_assert(writer);
+    g_assert(edt);
+
+    for (i = 0; i < writer->n_columns; i++) {
+        arrow_column_t *column = &writer->columns[i];
+        gboolean ok;
+
+        if (column->col_title != NULL) {
+            const gchar *col_data = NULL;
+            gint col;
+
+            for (col = 0; col < cinfo->num_cols; col++) {
+                if (get_column_visible(col) &&
+                    strcmp(cinfo->columns[col].col_title, column->col_title) == 0) {
+                    col_data = cinfo->columns[col].col_data;
+                    break;
+                }
+            }
+            if (col_data != NULL)
+                ok = garrow_string_array_builder_append_string(GARROW_STRING_ARRAY_BUILDER(column->builder), col_data, &error);
+            else
+                ok = garrow_array_builder_append_null(column->builder, &error);
+        } else {
+            ok = arrow_column_append(column,
+                                     arrow_column_find_finfo(column, writer->fields->occurrence, edt),
+                                     edt, &error);
+        }
+        if (!ok)
+            return arrow_set_err_msg(error, err_msg);
+    }
+
+    if (++writer->n_rows >= writer->batch_rows) {
+        if (!arrow_writer_flush_batch(writer, &error))
+            return arrow_set_err_msg(error, err_msg);
+    }
+    return TRUE;
+}
+
+gboolean
+write_arrow_finale(arrow_writer_t *writer, gchar **err_msg)
+{
+    GError  *error = NULL;
+    gboolean ok;
+
+    g_assert(writer);
+
+    ok = arrow_writer_flush_batch(writer, &error);
+    if (ok) {
+        if (writer->format == ARROW_FORMAT_PARQUET)
+            ok = gparquet_arrow_file_writer_close(writer->parquet_writer, &error);
+        else
+            ok = garrow_record_batch_writer_close(writer->ipc_writer, &error);
+    }
+    if (ok)
+        ok = garrow_file_close(GARROW_FILE(writer->sink), &error);
+    if (!ok)
+        arrow_set_err_msg(error, err_msg);
+
+    arrow_writer_free(writer);
+    return ok;
+}
+#else /* HAVE_ARROW */
+arrow_writer_t *
+write_arrow_preamble(output_fields_t* fields _U_, arrow_format_e format _U_, guint batch_rows _U_, FILE *fh _U_, gchar **err_msg)
+{
+    if (err_msg != NULL)
+        *err_msg = g_strdup("This version of Wireshark was built without Apache Arrow support");
+    return NULL;
+}
+
+gboolean
+write_arrow_proto_tree(arrow_writer_t *writer _U_, epan_dissect_t *edt _U_, column_info *cinfo _U_, gchar **err_msg _U_)
+{
+    g_assert_not_reached();
+    return FALSE;
+}
+
+gboolean
+write_arrow_finale(arrow_writer_t *writer _U_, gchar **err_msg _U_)
+{
+    g_assert_not_reached();
+    return FALSE;
 }
+#endif /* HAVE_ARROW */
 
 /* Returns an g_malloced string */
 gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt)
@@ -71,6 +71,14 @@ WS_DLL_PUBLIC gboolean output_fields_set_option(output_fields_t* info, gchar* op
 WS_DLL_PUBLIC void output_fields_list_options(FILE *fh);
 WS_DLL_PUBLIC gboolean output_fields_has_cols(output_fields_t* info);
 
+/*
+ * Prime an epan_dissect_t with the fields in info, so that the fields
+ * writers can stop walking the protocol tree as soon as every occurrence
+ * of the requested fields has been seen.  Must be called before each
+ * packet is dissected.
+ */
+WS_DLL_PUBLIC void output_fields_prime_edt(output_fields_t* info, epan_dissect_t *edt);
+
 /*
  * Higher-level packet-printing code.
  */
@@ -111,6 +119,13 @@ WS_DLL_PUBLIC void write_ek_proto_tree(output_fields_t* fields,
                                        pf_flags protocolfilter_flags,
                                        epan_dissect_t *edt,
                                        column_info *cinfo, FILE *fh);
+/*
+ * write_ek_proto_tree() keeps its output in a buffer that is written to
+ * fh only once it is full; write_ek_flush() and write_ek_finale() write
+ * out whatever is left.
+ */
+WS_DLL_PUBLIC void write_ek_flush(FILE *fh);
+WS_DLL_PUBLIC void write_ek_finale(FILE *fh);
 
 WS_DLL_PUBLIC void write_psml_preamble(column_info *cinfo, FILE *fh);
 WS_DLL_PUBLIC void write_psml_columns(epan_dissect_t *edt, FILE *fh, gboolean use_color);
@@ -123,8 +138,35 @@ WS_DLL_PUBLIC void write_carrays_hex_data(guint32 num, FILE *fh, epan_dissect_t
 
 WS_DLL_PUBLIC void write_fields_preamble(output_fields_t* fields, FILE *fh);
 WS_DLL_PUBLIC void write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
+/*
+ * Like write_fields_proto_tree(), but terminates the record with a newline
+ * and keeps it in an output buffer owned by fields; the buffer is written
+ * to fh only once it is full, or by write_fields_flush() or
+ * write_fields_finale().
+ */
+WS_DLL_PUBLIC void write_fields_proto_tree_buffered(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
+WS_DLL_PUBLIC void write_fields_flush(output_fields_t* fields, FILE *fh);
 WS_DLL_PUBLIC void write_fields_finale(output_fields_t* fields, FILE *fh);
 
+/*
+ * Write the fields specified with output_fields_add() as typed columns
+ * (integers, timestamps, addresses as binary, ...) in record batches of
+ * batch_rows packets (0 for the default).  Only available if Wireshark
+ * was built with Apache Arrow support; otherwise write_arrow_preamble()
+ * fails.
+ */
+typedef enum {
+    ARROW_FORMAT_IPC_STREAM,    /* Arrow IPC streaming format */
+    ARROW_FORMAT_PARQUET        /* Parquet */
+} arrow_format_e;
+
+struct _arrow_writer;
+typedef struct _arrow_writer arrow_writer_t;
+
+WS_DLL_PUBLIC arrow_writer_t *write_arrow_preamble(output_fields_t* fields, arrow_format_e format, guint batch_rows, FILE *fh, gchar **err_msg);
+WS_DLL_PUBLIC gboolean write_arrow_proto_tree(arrow_writer_t *writer, epan_dissect_t *edt, column_info *cinfo, gchar **err_msg);
+WS_DLL_PUBLIC gboolean write_arrow_finale(arrow_writer_t *writer, gchar **err_msg);
+
 WS_DLL_PUBLIC gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt);
 
 extern void print_cache_field_handles(void);
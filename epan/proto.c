@@ -21,6 +21,7 @@
 #include <wsutil/sign_ext.h>
 #include <wsutil/utf8_entities.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/startup_profile.h>
 
 #include <ftypes/ftypes-int.h>
 
@@ -125,6 +126,7 @@ struct ptvcursor {
 			    && (hfinfo->type != FT_PROTOCOL ||		\
 				PTREE_DATA(tree)->fake_protocols)) {	\
 				free_block;				\
+				tree_items_faked++;			\
 				/* just return tree back to the caller */\
 				return tree;				\
 			}						\
@@ -335,6 +337,11 @@ static void register_string_errors(void);
 
 static int proto_register_field_init(header_field_info *hfinfo, const int parent);
 
+/* Number of items added to trees, and of items not added because nothing
+   referenced them; see proto_tree_get_item_counts(). */
+static guint64 tree_items_added;
+static guint64 tree_items_faked;
+
 /* special-case header field used within proto.c */
 static header_field_info hfi_text_only =
 	{ "Text item",	"text", FT_NONE, BASE_NONE, NULL, 0x0, NULL, HFILL };
@@ -355,6 +362,7 @@ struct _protocol {
                                        can be added to a dissector table, but use the
                                        parent_proto_id for things like enable/disable */
 	GList      *heur_list;          /* Heuristic dissectors associated with this protocol */
+	prefix_initializer_t prefix_init; /* Delayed initializer, if it hasn't been called yet */
 };
 
 /* List of all protocols */
@@ -410,6 +418,16 @@ static header_field_info *same_name_hfinfo;
 /* Hash table protocol aliases. const char * -> const char * */
 static GHashTable *gpa_protocol_aliases = NULL;
 
+/*
+ * Plain value_strings with more entries than this get a sorted copy,
+ * looked up with a value_string_ext, the first time a field using one
+ * of them is displayed; smaller ones are just searched linearly.
+ */
+#define HF_VALS_LINEAR_MAX 16
+
+/* Hash table of sorted value_string copies. const value_string * -> value_string_ext * */
+static GHashTable *hf_vals_index = NULL;
+
 /*
  * We're called repeatedly with the same field name when sorting a column.
  * Cache our last gpa_name_map hit for faster lookups.
@@ -487,6 +505,9 @@ proto_init(GSList *register_all_plugin_protocols_list,
 	   register_cb cb,
 	   gpointer client_data)
 {
+	guint profile_phase = startup_profile_begin("proto_init");
+	guint profile_subphase;
+
 	proto_cleanup_base();
 
 	proto_names        = g_hash_table_new(g_str_hash, g_str_equal);
@@ -522,9 +543,12 @@ proto_init(GSList *register_all_plugin_protocols_list,
 	   dissector tables, and dissectors to be called through a
 	   handle, and do whatever one-time initialization it needs to
 	   do. */
+	profile_subphase = startup_profile_begin("register_protocols");
 	register_all_protocols(cb, client_data);
+	startup_profile_end(profile_subphase);
 
 	/* Now call the registration routines for all epan plugins. */
+	profile_subphase = startup_profile_begin("register_plugin_protocols");
 	for (GSList *l = register_all_plugin_protocols_list; l != NULL; l = l->next) {
 		((void (*)(register_cb, gpointer))l->data)(cb, client_data);
 	}
@@ -533,14 +557,18 @@ proto_init(GSList *register_all_plugin_protocols_list,
 	if (cb)
 		(*cb)(RA_PLUGIN_REGISTER, NULL, client_data);
 	g_slist_foreach(dissector_plugins, call_plugin_register_protoinfo, NULL);
+	startup_profile_end(profile_subphase);
 
 	/* Now call the "handoff registration" routines of all built-in
 	   dissectors; those routines register the dissector in other
 	   dissectors' handoff tables, and fetch any dissector handles
 	   they need. */
+	profile_subphase = startup_profile_begin("register_handoffs");
 	register_all_protocol_handoffs(cb, client_data);
+	startup_profile_end(profile_subphase);
 
 	/* Now do the same with epan plugins. */
+	profile_subphase = startup_profile_begin("register_plugin_handoffs");
 	for (GSList *l = register_all_plugin_handoffs_list; l != NULL; l = l->next) {
 		((void (*)(register_cb, gpointer))l->data)(cb, client_data);
 	}
@@ -549,6 +577,7 @@ proto_init(GSList *register_all_plugin_protocols_list,
 	if (cb)
 		(*cb)(RA_PLUGIN_HANDOFF, NULL, client_data);
 	g_slist_foreach(dissector_plugins, call_plugin_register_handoff, NULL);
+	startup_profile_end(profile_subphase);
 
 	/* sort the protocols by protocol name */
 	protocols = g_list_sort(protocols, proto_compare_name);
@@ -556,6 +585,8 @@ proto_init(GSList *register_all_plugin_protocols_list,
 	/* We've assigned all the subtree type values; allocate the array
 	   for them, and zero it out. */
 	tree_is_expanded = g_new0(guint32, (num_tree_types/32)+1);
+
+	startup_profile_end(profile_phase);
 }
 
 static void
@@ -573,6 +604,10 @@ proto_cleanup_base(void)
 		g_hash_table_destroy(gpa_protocol_aliases);
 		gpa_protocol_aliases = NULL;
 	}
+	if (hf_vals_index) {
+		g_hash_table_destroy(hf_vals_index);
+		hf_vals_index = NULL;
+	}
 	g_free(last_field_name);
 	last_field_name = NULL;
 
@@ -740,14 +775,23 @@ free_GPtrArray_value(gpointer key, gpointer value, gpointer user_data _U_)
 	g_ptr_array_free(ptrs, TRUE);
 }
 
+/*
+ * The nodes and field_infos themselves are allocated from the packet
+ * scope and go away with it, so there's no need to walk the tree to free
+ * them; only the values that hold memory of their own need freeing, and
+ * new_field_info() keeps a list of those.
+ */
 static void
-proto_tree_free_node(proto_node *node, gpointer data _U_)
+proto_tree_free_values(tree_data_t *tree_data)
 {
-	field_info *finfo  = PNODE_FINFO(node);
+	GPtrArray *fvalues_to_free = tree_data->fvalues_to_free;
 
-	proto_tree_children_foreach(node, proto_tree_free_node, NULL);
+	for (guint i = 0; i < fvalues_to_free->len; i++) {
+		field_info *finfo = (field_info *)g_ptr_array_index(fvalues_to_free, i);
 
-	FVALUE_CLEANUP(&finfo->value);
+		FVALUE_CLEANUP(&finfo->value);
+	}
+	g_ptr_array_set_size(fvalues_to_free, 0);
 }
 
 void
@@ -755,7 +799,7 @@ proto_tree_reset(proto_tree *tree)
 {
 	tree_data_t *tree_data = PTREE_DATA(tree);
 
-	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
+	proto_tree_free_values(tree_data);
 
 	/* free tree data */
 	if (tree_data->interesting_hfids) {
@@ -779,7 +823,8 @@ proto_tree_free(proto_tree *tree)
 {
 	tree_data_t *tree_data = PTREE_DATA(tree);
 
-	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
+	proto_tree_free_values(tree_data);
+	g_ptr_array_free(tree_data->fvalues_to_free, TRUE);
 
 	/* free tree data */
 	if (tree_data->interesting_hfids) {
@@ -816,6 +861,13 @@ proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols)
 	PTREE_DATA(tree)->fake_protocols = fake_protocols;
 }
 
+void
+proto_tree_get_item_counts(guint64 *added, guint64 *faked)
+{
+	*added = tree_items_added;
+	*faked = tree_items_faked;
+}
+
 /* Assume dissector set only its protocol fields.
    This function is called by dissectors and allows the speeding up of filtering
    in wireshark; if this function returns FALSE it is safe to reset tree to NULL
@@ -914,9 +966,48 @@ proto_register_prefix(const char *prefix, prefix_initializer_t pi ) {
 	g_hash_table_insert(prefixes, (gpointer)prefix, (gpointer)pi);
 }
 
+/* If a prefix belongs to a protocol, note that its initializer has been called */
+static void
+protocol_prefix_initialized(const char *prefix, prefix_initializer_t pi) {
+	protocol_t *protocol;
+
+	if (!proto_filter_names)
+		return;
+
+	protocol = (protocol_t *)g_hash_table_lookup(proto_filter_names, prefix);
+	if (protocol && protocol->prefix_init == pi)
+		protocol->prefix_init = NULL;
+}
+
+/* Register a delayed initializer for all of a protocol's fields */
+void
+proto_register_protocol_prefix(const int proto_id, prefix_initializer_t pi) {
+	protocol_t *protocol = find_protocol_by_id(proto_id);
+
+	DISSECTOR_ASSERT(protocol != NULL);
+
+	protocol->prefix_init = pi;
+	proto_register_prefix(protocol->filter_name, pi);
+}
+
+/* Call a protocol's delayed initializer, if it hasn't been called yet */
+void
+proto_initialize_protocol_prefix(protocol_t *protocol) {
+	prefix_initializer_t pi = protocol->prefix_init;
+
+	if (G_LIKELY(pi == NULL))
+		return;
+
+	protocol->prefix_init = NULL;
+	if (prefixes)
+		g_hash_table_remove(prefixes, protocol->filter_name);
+	pi(protocol->filter_name);
+}
+
 /* helper to call all prefix initializers */
 static gboolean
 initialize_prefix(gpointer k, gpointer v, gpointer u _U_) {
+	protocol_prefix_initialized((const char *)k, (prefix_initializer_t)v);
 	((prefix_initializer_t)v)((const char *)k);
 	return TRUE;
 }
@@ -938,6 +1029,7 @@ proto_registrar_get_byname(const char *field_name)
 {
 	header_field_info    *hfinfo;
 	prefix_initializer_t  pi;
+	gpointer              prefix, value;
 
 	if (!field_name)
 		return NULL;
@@ -958,7 +1050,9 @@ proto_registrar_get_byname(const char *field_name)
 	if (!prefixes)
 		return NULL;
 
-	if ((pi = (prefix_initializer_t)g_hash_table_lookup(prefixes, field_name) ) != NULL) {
+	if (g_hash_table_lookup_extended(prefixes, field_name, &prefix, &value)) {
+		pi = (prefix_initializer_t)value;
+		protocol_prefix_initialized((const char *)prefix, pi);
 		pi(field_name);
 		g_hash_table_remove(prefixes, field_name);
 	} else {
@@ -5888,6 +5982,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 
 	pnode = wmem_new(PNODE_POOL(tree), proto_node);
 	PROTO_NODE_INIT(pnode);
+	tree_items_added++;
 	pnode->parent = tnode;
 	PNODE_FINFO(pnode) = fi;
 	pnode->tree_data = PTREE_DATA(tree);
@@ -6227,6 +6322,8 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 	if (!PTREE_DATA(tree)->visible)
 		FI_SET_FLAG(fi, FI_HIDDEN);
 	fvalue_init(&fi->value, fi->hfinfo->type);
+	if (fi->value.ftype->free_value)
+		g_ptr_array_add(PTREE_DATA(tree)->fvalues_to_free, fi);
 	fi->rep        = NULL;
 
 	/* add the data source tvbuff */
@@ -7134,6 +7231,8 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
+	pnode->tree_data->fvalues_to_free = g_ptr_array_new();
+
 	return (proto_tree *)pnode;
 }
 
@@ -7383,6 +7482,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->can_toggle = TRUE;
 	protocol->parent_proto_id = -1;
 	protocol->heur_list = NULL;
+	protocol->prefix_init = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -7442,6 +7542,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 
 	protocol->parent_proto_id = parent_proto;
 	protocol->heur_list = NULL;
+	protocol->prefix_init = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -8080,6 +8181,8 @@ void proto_free_field_strings (ftenum_t field_type, unsigned int field_display,
 				}
 			} else {
 				value_string *vs = (value_string *)field_strings;
+				if (hf_vals_index)
+					g_hash_table_remove(hf_vals_index, vs);
 				while (vs->strptr) {
 					g_free((gchar *)vs->strptr);
 					vs++;
@@ -9378,6 +9481,80 @@ fill_label_boolean(field_info *fi, gchar *label_str)
 	label_fill(label_str, bitfield_byte_length, hfinfo, tfs_get_string(!!value, tfstring));
 }
 
+static void
+hf_vals_index_free(gpointer data)
+{
+	value_string_ext *vse = (value_string_ext *)data;
+
+	g_free((value_string *)VALUE_STRING_EXT_VS_P(vse));
+	value_string_ext_free(vse);
+}
+
+static gint
+hf_vals_index_compare(gconstpointer a, gconstpointer b, gpointer user_data _U_)
+{
+	guint32 value_a = ((const value_string *)a)->value;
+	guint32 value_b = ((const value_string *)b)->value;
+
+	if (value_a < value_b)
+		return -1;
+	return value_a > value_b ? 1 : 0;
+}
+
+/*
+ * Get the sorted copy of a large value_string, building it if necessary.
+ * Only the first entry for each value is kept, as that's the one a linear
+ * search would find.
+ */
+static value_string_ext *
+hf_vals_index_get(const value_string *vs)
+{
+	value_string_ext *vse;
+	value_string *sorted;
+	guint num_entries, i, j;
+
+	if (G_UNLIKELY(hf_vals_index == NULL))
+		hf_vals_index = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, hf_vals_index_free);
+
+	vse = (value_string_ext *)g_hash_table_lookup(hf_vals_index, vs);
+	if (vse)
+		return vse;
+
+	for (num_entries = 0; vs[num_entries].strptr; num_entries++)
+		;
+	sorted = (value_string *)g_memdup2(vs, (num_entries + 1) * sizeof(value_string));
+	/* g_qsort_with_data() is stable, so duplicates stay in table order */
+	g_qsort_with_data(sorted, num_entries, sizeof(value_string), hf_vals_index_compare, NULL);
+	for (i = j = 0; i < num_entries; i++) {
+		if (j == 0 || sorted[i].value != sorted[j - 1].value)
+			sorted[j++] = sorted[i];
+	}
+	sorted[j].value = 0;
+	sorted[j].strptr = NULL;
+
+	vse = value_string_ext_new(sorted, j + 1, "hf_vals_index");
+	g_hash_table_insert(hf_vals_index, (gpointer)vs, vse);
+	return vse;
+}
+
+static const char *
+hf_try_vals_to_str(guint32 value, const value_string *vs)
+{
+	guint i;
+
+	if (vs == NULL)
+		return NULL;
+
+	for (i = 0; i < HF_VALS_LINEAR_MAX; i++) {
+		if (vs[i].strptr == NULL)
+			return NULL;
+		if (vs[i].value == value)
+			return vs[i].strptr;
+	}
+
+	return try_val_to_str_ext(value, hf_vals_index_get(vs));
+}
+
 static const char *
 hf_try_val_to_str(guint32 value, const header_field_info *hfinfo)
 {
@@ -9397,7 +9574,7 @@ hf_try_val_to_str(guint32 value, const header_field_info *hfinfo)
 	if (hfinfo->display & BASE_UNIT_STRING)
 		return unit_name_string_get_value(value, (const struct unit_name_string*) hfinfo->strings);
 
-	return try_val_to_str(value, (const value_string *) hfinfo->strings);
+	return hf_try_vals_to_str(value, (const value_string *) hfinfo->strings);
 }
 
 static const char *
@@ -10401,8 +10578,8 @@ proto_check_for_protocol_or_field(const proto_tree* tree, const int id)
 /* Return GPtrArray* of field_info pointers for all hfindex that appear in tree.
  * This only works if the hfindex was "primed" before the dissection
  * took place, as we just pass back the already-created GPtrArray*.
- * The caller should *not* free the GPtrArray*; proto_tree_free_node()
- * handles that. */
+ * The caller should *not* free the GPtrArray*; proto_tree_reset() and
+ * proto_tree_free() handle that. */
 GPtrArray *
 proto_get_finfo_ptr_array(const proto_tree *tree, const int id)
 {
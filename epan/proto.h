@@ -861,6 +861,7 @@ typedef struct {
     gboolean             fake_protocols;
     guint                count;
     struct _packet_info *pinfo;
+    GPtrArray           *fvalues_to_free;  /**< field_infos whose values need freeing when the tree is reset */
 } tree_data_t;
 
 /** Each proto_tree, proto_item is one of these. */
@@ -1176,6 +1177,14 @@ proto_tree_set_visible(proto_tree *tree, gboolean visible);
 extern void
 proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols);
 
+/** Get the number of items added to protocol trees so far, and the
+ number that weren't because the tree isn't visible and no filter,
+ field or tap referenced them.
+ @param added set to the number of items added
+ @param faked set to the number of items not added */
+WS_DLL_PUBLIC void
+proto_tree_get_item_counts(guint64 *added, guint64 *faked);
+
 /** Mark a field/protocol ID as "interesting".
  @param tree the tree to be set (currently ignored)
  @param hfid the interesting field id
@@ -2453,6 +2462,25 @@ typedef void (*prefix_initializer_t)(const char* match);
 WS_DLL_PUBLIC void
 proto_register_prefix(const char *prefix,  prefix_initializer_t initializer);
 
+/** Register a delayed initializer for all the fields of a protocol, using
+    the protocol's filter name as the prefix.  Unlike with
+    proto_register_prefix(), the initializer is also called before any of
+    the protocol's dissectors is first called through a handle or as a
+    heuristic dissector, so those dissectors needn't call it themselves;
+    this lets a protocol that has to build large tables put that work
+    off until the protocol is actually needed.
+@param proto_id the protocol whose fields are to be initialized
+@param initializer function that will initialize the protocol's fields */
+WS_DLL_PUBLIC void
+proto_register_protocol_prefix(const int proto_id, prefix_initializer_t initializer);
+
+/** Call the delayed initializer registered with
+    proto_register_protocol_prefix() for a protocol, if it hasn't been
+    called yet.
+@param protocol the protocol */
+WS_DLL_PUBLIC void
+proto_initialize_protocol_prefix(protocol_t *protocol);
+
 /** Initialize every remaining uninitialized prefix. */
 WS_DLL_PUBLIC void proto_initialize_all_prefixes(void);
 
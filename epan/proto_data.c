@@ -10,6 +10,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/wmem/wmem.h>
@@ -26,18 +28,28 @@ typedef struct _proto_data {
   void *proto_data;
 } proto_data_t;
 
+/* The protocol data of a frame or packet, kept in an array sorted by
+   protocol index and key so that lookups are a binary search over
+   contiguous memory rather than a walk down a linked list.  Of several
+   items with the same protocol index and key, the most recently added
+   one comes first. */
+struct _proto_data_list {
+  guint         count;
+  guint         size;
+  proto_data_t *items;
+};
+
+#define PROTO_DATA_LIST_INITIAL_SIZE 4
+
 static gint
-p_compare(gconstpointer a, gconstpointer b)
+p_compare(const proto_data_t *ap, int proto, guint32 key)
 {
-  const proto_data_t *ap = (const proto_data_t *)a;
-  const proto_data_t *bp = (const proto_data_t *)b;
-
-  if (ap -> proto > bp -> proto) {
+  if (ap -> proto > proto) {
     return 1;
-  } else if (ap -> proto == bp -> proto) {
-    if (ap->key > bp->key){
+  } else if (ap -> proto == proto) {
+    if (ap->key > key){
       return 1;
-    } else if (ap -> key == bp -> key) {
+    } else if (ap -> key == key) {
       return 0;
     }
     return -1;
@@ -46,55 +58,86 @@ p_compare(gconstpointer a, gconstpointer b)
   }
 }
 
-void
-p_add_proto_data(wmem_allocator_t *tmp_scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data)
+static proto_data_list_t **
+p_get_proto_list(wmem_allocator_t *scope, struct _packet_info* pinfo)
 {
-  proto_data_t     *p1;
-  GSList          **proto_list;
-  wmem_allocator_t *scope;
-
-  if (tmp_scope == pinfo->pool) {
-    scope = tmp_scope;
-    proto_list = &pinfo->proto_data;
-  } else if (tmp_scope == wmem_file_scope()) {
-    scope = wmem_file_scope();
-    proto_list = &pinfo->fd->pfd;
+  if (scope == pinfo->pool) {
+    return &pinfo->proto_data;
+  } else if (scope == wmem_file_scope()) {
+    return &pinfo->fd->pfd;
   } else {
     DISSECTOR_ASSERT(!"invalid wmem scope");
   }
+  return NULL;
+}
 
-  p1 = wmem_new(scope, proto_data_t);
+/* Index of the first item that doesn't sort before {proto, key}. */
+static guint
+p_lower_bound(const proto_data_list_t *list, int proto, guint32 key)
+{
+  guint low = 0, high = list->count;
 
-  p1->proto = proto;
-  p1->key = key;
-  p1->proto_data = proto_data;
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
 
-  /* Add it to the GSLIST */
-  *proto_list = g_slist_prepend(*proto_list, p1);
+    if (p_compare(&list->items[mid], proto, key) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+void
+p_add_proto_data(wmem_allocator_t *tmp_scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data)
+{
+  proto_data_list_t **proto_list = p_get_proto_list(tmp_scope, pinfo);
+  proto_data_list_t  *list = *proto_list;
+  guint               idx;
+
+  /* The list of packet data is taken from the packet pool, so that
+     most packets don't need any allocation or freeing of their own;
+     the list of a frame lives as long as the frame. */
+  if (list == NULL) {
+    if (tmp_scope == pinfo->pool) {
+      list = wmem_new(pinfo->pool, proto_data_list_t);
+      list->items = wmem_alloc_array(pinfo->pool, proto_data_t, PROTO_DATA_LIST_INITIAL_SIZE);
+    } else {
+      list = g_new(proto_data_list_t, 1);
+      list->items = g_new(proto_data_t, PROTO_DATA_LIST_INITIAL_SIZE);
+    }
+    list->count = 0;
+    list->size = PROTO_DATA_LIST_INITIAL_SIZE;
+    *proto_list = list;
+  } else if (list->count == list->size) {
+    list->size *= 2;
+    if (tmp_scope == pinfo->pool)
+      list->items = (proto_data_t *)wmem_realloc(pinfo->pool, list->items, list->size * sizeof (proto_data_t));
+    else
+      list->items = g_renew(proto_data_t, list->items, list->size);
+  }
+
+  idx = p_lower_bound(list, proto, key);
+  memmove(&list->items[idx + 1], &list->items[idx],
+          (list->count - idx) * sizeof (proto_data_t));
+  list->items[idx].proto = proto;
+  list->items[idx].key = key;
+  list->items[idx].proto_data = proto_data;
+  list->count++;
 }
 
 void *
 p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key)
 {
-  proto_data_t  temp, *p1;
-  GSList       *item;
+  const proto_data_list_t *list = *p_get_proto_list(scope, pinfo);
+  guint                    idx;
 
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
+  if (list == NULL)
+    return NULL;
 
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
-
-  if (item) {
-    p1 = (proto_data_t *)item->data;
-    return p1->proto_data;
-  }
+  idx = p_lower_bound(list, proto, key);
+  if (idx < list->count && p_compare(&list->items[idx], proto, key) == 0)
+    return list->items[idx].proto_data;
 
   return NULL;
 }
@@ -102,44 +145,49 @@ p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto,
 void
 p_remove_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key)
 {
-  proto_data_t  temp;
-  GSList       *item;
-  GSList      **proto_list;
+  proto_data_list_t *list = *p_get_proto_list(scope, pinfo);
+  guint              idx;
 
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
+  if (list == NULL)
+    return;
 
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-    proto_list = &pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-    proto_list = &pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
+  idx = p_lower_bound(list, proto, key);
+  if (idx < list->count && p_compare(&list->items[idx], proto, key) == 0) {
+    list->count--;
+    memmove(&list->items[idx], &list->items[idx + 1],
+            (list->count - idx) * sizeof (proto_data_t));
   }
+}
 
-  if (item) {
-    *proto_list = g_slist_remove(*proto_list, item->data);
-  }
+guint
+p_get_proto_data_count(wmem_allocator_t *scope, struct _packet_info* pinfo)
+{
+  const proto_data_list_t *list = *p_get_proto_list(scope, pinfo);
+
+  return list != NULL ? list->count : 0;
 }
 
 gchar *
 p_get_proto_name_and_key(wmem_allocator_t *scope, struct _packet_info* pinfo, guint pfd_index){
-  proto_data_t  *temp;
+  const proto_data_list_t *list = *p_get_proto_list(scope, pinfo);
+  const proto_data_t      *temp;
 
-  if (scope == pinfo->pool) {
-    temp = (proto_data_t *)g_slist_nth_data(pinfo->proto_data, pfd_index);
-  } else if (scope == wmem_file_scope()) {
-    temp = (proto_data_t *)g_slist_nth_data(pinfo->fd->pfd, pfd_index);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  DISSECTOR_ASSERT(list != NULL && pfd_index < list->count);
+  temp = &list->items[pfd_index];
 
   return wmem_strdup_printf(wmem_packet_scope(),"[%s, key %u]",proto_get_protocol_name(temp->proto), temp->key);
 }
 
+void
+p_free_proto_data_list(proto_data_list_t *list)
+{
+  if (list == NULL)
+    return;
+
+  g_free(list->items);
+  g_free(list);
+}
+
 #define PROTO_DEPTH_KEY 0x3c233fb5 // printf "0x%02x%02x\n" ${RANDOM} ${RANDOM}
 
 void p_set_proto_depth(struct _packet_info *pinfo, int proto, unsigned depth) {
@@ -26,11 +26,16 @@ extern "C" {
  * @{
  */
 
+typedef struct _proto_data_list proto_data_list_t;
+
 /* Allocator should be either pinfo->pool or wmem_file_scope() */
 WS_DLL_PUBLIC void p_add_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data);
 WS_DLL_PUBLIC void *p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key);
 WS_DLL_PUBLIC void p_remove_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key);
+guint p_get_proto_data_count(wmem_allocator_t *scope, struct _packet_info* pinfo);
 gchar *p_get_proto_name_and_key(wmem_allocator_t *scope, struct _packet_info* pinfo, guint pfd_index);
+/* Frees the list of a frame; the list of a packet is in pinfo->pool. */
+void p_free_proto_data_list(proto_data_list_t *list);
 
 /**
  * Initialize or update a per-protocol and per-packet check for recursion, nesting, cycling, etc.
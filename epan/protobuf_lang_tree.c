@@ -493,11 +493,13 @@ pbl_field_descriptor_type(const pbl_field_descriptor_t* field)
         node = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_ENUM);
         if (node) {
             ((pbl_field_descriptor_t*)field)->type = PROTOBUF_TYPE_ENUM;
+            ((pbl_field_descriptor_t*)field)->type_node = node;
         } else {
             /* try to lookup as MESSAGE */
             node = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_MESSAGE);
             if (node) {
                 ((pbl_field_descriptor_t*)field)->type = PROTOBUF_TYPE_MESSAGE;
+                ((pbl_field_descriptor_t*)field)->type_node = node;
             }
         }
     }
@@ -562,7 +564,12 @@ pbl_field_descriptor_message_type(const pbl_field_descriptor_t* field)
 {
     const pbl_node_t* n;
     if (field->type == PROTOBUF_TYPE_MESSAGE || field->type == PROTOBUF_TYPE_GROUP) {
-        n = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_MESSAGE);
+        /* the name lookup is expensive, so remember the result */
+        if (field->type_node == NULL) {
+            ((pbl_field_descriptor_t*)field)->type_node =
+                pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_MESSAGE);
+        }
+        n = field->type_node;
         return n ? (const pbl_message_descriptor_t*)n : NULL;
     }
     return NULL;
@@ -574,7 +581,11 @@ pbl_field_descriptor_enum_type(const pbl_field_descriptor_t* field)
 {
     const pbl_node_t* n;
     if (field->type == PROTOBUF_TYPE_ENUM) {
-        n = pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_ENUM);
+        if (field->type_node == NULL) {
+            ((pbl_field_descriptor_t*)field)->type_node =
+                pbl_find_node_in_context(((pbl_node_t*)field)->parent, field->type_name, PBL_ENUM);
+        }
+        n = field->type_node;
         return n ? (const pbl_enum_descriptor_t*)n : NULL;
     }
     return NULL;
@@ -102,6 +102,7 @@ typedef struct {
     int number;
     int type; /* refer to PROTOBUF_TYPE_XXX of protobuf-helper.h */
     gchar* type_name;
+    const pbl_node_t* type_node; /* message or enum node of type_name, resolved on first use */
     pbl_node_t* options_node;
     gboolean is_repeated;
     gboolean is_required;
@@ -397,6 +397,18 @@ free_fragments(gpointer data, gpointer user_data _U_)
 	g_slice_free(fragment_item, fd_head);
 }
 
+/*
+ * Default limit on the fragment data held for incomplete reassemblies,
+ * per table, from WIRESHARK_REASSEMBLY_MAX_BYTES; 0 means no limit.
+ */
+static guint64 reassembly_default_max_bytes = 0;
+
+/*
+ * How many new reassemblies a table starts between checks of how much
+ * fragment data it holds; adding it up means walking the whole table.
+ */
+#define REASSEMBLY_BUDGET_CHECK_INTERVAL 256
+
 typedef struct register_reassembly_table {
 	reassembly_table *table;
 	const reassembly_table_functions *funcs;
@@ -532,6 +544,110 @@ reassembly_table_destroy(reassembly_table *table)
 	}
 }
 
+void
+reassembly_table_set_max_bytes(reassembly_table *table, guint64 max_bytes)
+{
+	table->max_bytes = max_bytes;
+}
+
+typedef struct {
+	gpointer key;
+	fragment_head *fd_head;
+	guint64 bytes;
+} fragment_budget_entry_t;
+
+typedef struct {
+	GArray *entries;
+	guint64 bytes_held;
+	guint32 current_frame;
+} fragment_budget_t;
+
+static void
+fragment_budget_gather(gpointer key, gpointer value, gpointer user_data)
+{
+	fragment_budget_t *budget = (fragment_budget_t *)user_data;
+	fragment_head *fd_head = (fragment_head *)value;
+	fragment_item *fd;
+	fragment_budget_entry_t entry;
+
+	/*
+	 * Completed reassemblies stay in the fragment table for some
+	 * callers, and are needed when the packets are dissected again.
+	 */
+	if (fd_head->flags & FD_DEFRAGMENTED)
+		return;
+
+	entry.key = key;
+	entry.fd_head = fd_head;
+	entry.bytes = 0;
+	for (fd = fd_head->next; fd != NULL; fd = fd->next) {
+		if (fd->tvb_data && !(fd->flags & FD_SUBSET_TVB))
+			entry.bytes += tvb_captured_length(fd->tvb_data);
+	}
+	budget->bytes_held += entry.bytes;
+
+	/* Don't discard anything the current frame added to. */
+	if (fd_head->frame < budget->current_frame)
+		g_array_append_val(budget->entries, entry);
+}
+
+static gint
+fragment_budget_compare(gconstpointer a, gconstpointer b)
+{
+	const fragment_budget_entry_t *entry_a = (const fragment_budget_entry_t *)a;
+	const fragment_budget_entry_t *entry_b = (const fragment_budget_entry_t *)b;
+
+	if (entry_a->fd_head->frame != entry_b->fd_head->frame)
+		return entry_a->fd_head->frame < entry_b->fd_head->frame ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Called before a new reassembly is started in the table.  Every
+ * REASSEMBLY_BUDGET_CHECK_INTERVAL new reassemblies, add up the
+ * fragment data held for incomplete reassemblies and, if that's over
+ * the table's limit, discard the ones whose latest fragment is oldest
+ * until the table is back down to three quarters of the limit, so that
+ * it's not right back at the limit after the next few fragments.
+ *
+ * This is only done on the first pass; on later passes the reassemblies
+ * are looked up, not started, and must come out the same way.
+ */
+static void
+fragment_check_budget(reassembly_table *table, const packet_info *pinfo)
+{
+	guint64 max_bytes = table->max_bytes ? table->max_bytes : reassembly_default_max_bytes;
+	fragment_budget_t budget;
+	guint i;
+
+	if (max_bytes == 0 || PINFO_FD_VISITED(pinfo))
+		return;
+
+	if (++table->heads_since_check < REASSEMBLY_BUDGET_CHECK_INTERVAL)
+		return;
+	table->heads_since_check = 0;
+
+	budget.entries = g_array_new(FALSE, FALSE, sizeof(fragment_budget_entry_t));
+	budget.bytes_held = 0;
+	budget.current_frame = pinfo->num;
+	g_hash_table_foreach(table->fragment_table, fragment_budget_gather, &budget);
+
+	if (budget.bytes_held > max_bytes) {
+		g_array_sort(budget.entries, fragment_budget_compare);
+		for (i = 0; i < budget.entries->len && budget.bytes_held > max_bytes / 4 * 3; i++) {
+			fragment_budget_entry_t *entry = &g_array_index(budget.entries, fragment_budget_entry_t, i);
+
+			/* Removing the entry frees the key, but not the fragments. */
+			g_hash_table_remove(table->fragment_table, entry->key);
+			free_all_fragments(NULL, entry->fd_head, NULL);
+			budget.bytes_held -= entry->bytes;
+			table->evicted++;
+		}
+	}
+	table->bytes_held = budget.bytes_held;
+	g_array_free(budget.entries, TRUE);
+}
+
 /*
  * Look up an fd_head in the fragment table, optionally returning the key
  * for it.
@@ -942,8 +1058,20 @@ LINK_FRAG(fragment_head *fd_head,fragment_item *fd)
 {
 	fragment_item *fd_i;
 
-	/* add fragment to list, keep list sorted */
-	for(fd_i= fd_head; fd_i->next;fd_i=fd_i->next) {
+	/* add fragment to list, keep list sorted.
+	 * Everything up to the end of the contiguous run has an offset no
+	 * larger than that of the run's last fragment, so a fragment that
+	 * doesn't start before it can be linked in from there; in-order
+	 * data is then appended without walking the list.
+	 */
+	fd_i = fd_head->contiguous_end;
+	if (fd_i == NULL || fd->offset < fd_i->offset) {
+		/* It goes into the run; it has to be recomputed */
+		fd_i = fd_head;
+		fd_head->contiguous_end = NULL;
+		fd_head->contiguous_len = 0;
+	}
+	for(; fd_i->next;fd_i=fd_i->next) {
 		if (fd->offset < fd_i->next->offset )
 			break;
 	}
@@ -951,6 +1079,32 @@ LINK_FRAG(fragment_head *fd_head,fragment_item *fd)
 	fd_i->next=fd;
 }
 
+/*
+ * Compute the amount of contiguous data that's available in a fragment_add()
+ * reassembly, continuing from where the last call left off.
+ *
+ * The list is sorted and the head is faked, so a fragment extends the run
+ * only if it doesn't start past the end of it (i.e. there is no gap between
+ * it and the previous fragments); the first fragment that does start past
+ * the end ends the run, and so do all the fragments after it.
+ */
+static guint32
+fragment_contiguous_len(fragment_head *fd_head)
+{
+	fragment_item *fd_i;
+	guint32 max = fd_head->contiguous_len;
+
+	fd_i = fd_head->contiguous_end ? fd_head->contiguous_end : fd_head;
+	for (fd_i = fd_i->next; fd_i && fd_i->offset <= max; fd_i = fd_i->next) {
+		if ((fd_i->offset+fd_i->len) > max) {
+			max = fd_i->offset+fd_i->len;
+		}
+		fd_head->contiguous_end = fd_i;
+	}
+	fd_head->contiguous_len = max;
+	return max;
+}
+
 static void
 MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 {
@@ -1146,35 +1300,32 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 		g_slice_free(fragment_item, fd);
 		THROW(BoundsError);
 	}
-	fd->tvb_data = tvb_clone_offset_len(tvb, offset, fd->len);
-	LINK_FRAG(fd_head,fd);
-
-
 	if( !(fd_head->flags & FD_DATALEN_SET) ){
 		/* if we don't know the datalen, there are still missing
 		 * packets. Cheaper than the check below.
 		 */
+		fd->tvb_data = tvb_clone_offset_len(tvb, offset, fd->len);
+		LINK_FRAG(fd_head,fd);
 		return FALSE;
 	}
 
+	/*
+	 * This fragment may complete the datagram, in which case its
+	 * data is only needed until it has been copied into the
+	 * reassembled buffer below; refer to it in place, and only
+	 * make a copy if it has to be kept.
+	 */
+	fd->tvb_data = tvb_new_subset_length(tvb, offset, fd->len);
+	fd->flags |= FD_SUBSET_TVB;
+	LINK_FRAG(fd_head,fd);
 
 	/*
 	 * Check if we have received the entire fragment.
-	 * This is easy since the list is sorted and the head is faked.
 	 *
 	 * First, we compute the amount of contiguous data that's
-	 * available.  (The check for fd_i->offset <= max rules out
-	 * fragments that don't start before or at the end of the
-	 * previous fragment, i.e. fragments that have a gap between
-	 * them and the previous fragment.)
+	 * available.
 	 */
-	max = 0;
-	for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
-		if ( ((fd_i->offset)<=max) &&
-			((fd_i->offset+fd_i->len)>max) ){
-			max = fd_i->offset+fd_i->len;
-		}
-	}
+	max = fragment_contiguous_len(fd_head);
 
 	if (max < (fd_head->datalen)) {
 		/*
@@ -1182,6 +1333,8 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 		 * amount of data we're trying to reassemble, so we haven't
 		 * received all packets yet.
 		 */
+		fd->flags &= ~FD_SUBSET_TVB;
+		fd->tvb_data = tvb_clone_offset_len(tvb, offset, fd->len);
 		return FALSE;
 	}
 
@@ -1198,7 +1351,7 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	for (dfpos=0,fd_i=fd_head;fd_i;fd_i=fd_i->next) {
 		if (fd_i->len) {
 			/*
-			 * The loop above that calculates max also
+			 * fragment_contiguous_len() above also
 			 * ensures that the only gaps that exist here
 			 * are ones where a fragment starts past the
 			 * end of the reassembled datagram, and there's
@@ -1505,6 +1658,7 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		/*
 		 * Insert it into the hash table.
 		 */
+		fragment_check_budget(table, pinfo);
 		insert_fd_head(table, fd_head, pinfo, id, data);
 	}
 
@@ -1581,6 +1735,7 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		/*
 		 * Save the key, for unhashing it later.
 		 */
+		fragment_check_budget(table, pinfo);
 		orig_key = insert_fd_head(table, fd_head, pinfo, id, data);
 	}
 
@@ -1997,6 +2152,7 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 			return fd_head;
 		}
 
+		fragment_check_budget(table, pinfo);
 		orig_key = insert_fd_head(table, fd_head, pinfo, id, data);
 		if (orig_keyp != NULL)
 			*orig_keyp = orig_key;
@@ -2888,6 +3044,11 @@ reassembly_table_cleanup_reg_tables(void)
 
 void reassembly_tables_init(void)
 {
+	const char *max_bytes = g_getenv("WIRESHARK_REASSEMBLY_MAX_BYTES");
+
+	if (max_bytes != NULL)
+		reassembly_default_max_bytes = g_ascii_strtoull(max_bytes, NULL, 10);
+
 	register_init_routine(&reassembly_table_init_reg_tables);
 	register_cleanup_routine(&reassembly_table_cleanup_reg_tables);
 }
@@ -83,6 +83,15 @@ typedef struct _fragment_item {
 	 * reassembly and for the fragments in a reassembly.
 	 */
 	const char *error;
+	/**
+	 * Only used in the reassembly head of a fragment_add() reassembly:
+	 * the last fragment of the run that is contiguous from offset 0
+	 * (NULL if not yet known), and the number of bytes that run covers.
+	 * This lets new fragments be linked in, and the reassembly be checked
+	 * for completeness, without walking the whole list every time.
+	 */
+	struct _fragment_item *contiguous_end;
+	guint32 contiguous_len;
 } fragment_item, fragment_head;
 
 
@@ -130,8 +139,23 @@ typedef struct {
 	fragment_temporary_key temporary_key_func;
 	fragment_persistent_key persistent_key_func;
 	GDestroyNotify free_temporary_key_func;		/* temporary key destruction function */
+	guint64 max_bytes;		/* limit on fragment data of incomplete reassemblies, 0 for the default */
+	guint64 bytes_held;		/* fragment data of incomplete reassemblies at the last check */
+	guint heads_since_check;	/* reassemblies started since the last check */
+	guint32 evicted;		/* incomplete reassemblies discarded to stay under max_bytes */
 } reassembly_table;
 
+/*
+ * Limit the fragment data a reassembly table holds for reassemblies
+ * that haven't completed yet, in bytes; 0 means use the default, which
+ * is unlimited unless the WIRESHARK_REASSEMBLY_MAX_BYTES environment
+ * variable is set.  When the limit is exceeded, the incomplete
+ * reassemblies that have gone longest without a new fragment are
+ * discarded.
+ */
+WS_DLL_PUBLIC void
+reassembly_table_set_max_bytes(reassembly_table *table, guint64 max_bytes);
+
 /*
  * Table of functions for a reassembly table.
  */
@@ -12,6 +12,8 @@
 #include "ws_attributes.h"
 
 #include <glib.h>
+#include <wsutil/startup_profile.h>
+#include <wsutil/time_util.h>
 #include "epan/dissectors/dissectors.h"
 
 static const char *cur_cb_name = NULL;
@@ -28,13 +30,29 @@ static void set_cb_name(const char *proto) {
     g_mutex_unlock(&cur_cb_name_mtx);
 }
 
+/* Calls each routine in "reg", timing it if the startup is being profiled. */
+static void
+call_reg_funcs(const dissector_reg_t *reg, gulong count, const char *category)
+{
+    gboolean profile = startup_profile_enabled();
+    guint64 start_ns;
+
+    for (gulong i = 0; i < count; i++) {
+        set_cb_name(reg[i].cb_name);
+        if (profile) {
+            start_ns = get_monotonic_ns();
+            reg[i].cb_func();
+            startup_profile_item(category, reg[i].cb_name, get_monotonic_ns() - start_ns);
+        } else {
+            reg[i].cb_func();
+        }
+    }
+}
+
 static void *
 register_all_protocols_worker(void *arg _U_)
 {
-    for (gulong i = 0; i < dissector_reg_proto_count; i++) {
-        set_cb_name(dissector_reg_proto[i].cb_name);
-        dissector_reg_proto[i].cb_func();
-    }
+    call_reg_funcs(dissector_reg_proto, dissector_reg_proto_count, "register");
 
     g_async_queue_push(register_cb_done_q, GINT_TO_POINTER(TRUE));
     return NULL;
@@ -67,10 +85,7 @@ register_all_protocols(register_cb cb, gpointer cb_data)
 static void *
 register_all_protocol_handoffs_worker(void *arg _U_)
 {
-    for (gulong i = 0; i < dissector_reg_handoff_count; i++) {
-        set_cb_name(dissector_reg_handoff[i].cb_name);
-        dissector_reg_handoff[i].cb_func();
-    }
+    call_reg_funcs(dissector_reg_handoff, dissector_reg_handoff_count, "handoff");
 
     g_async_queue_push(register_cb_done_q, GINT_TO_POINTER(TRUE));
     return NULL;
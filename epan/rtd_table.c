@@ -84,10 +84,12 @@ register_rtd_table(const int proto_id, const char* tap_listener, guint num_table
 
 void free_rtd_table(rtd_stat_table* table)
 {
-    guint i;
+    guint i, j;
 
     for (i = 0; i < table->num_rtds; i++)
     {
+        for (j = 0; j < table->time_stats[i].num_timestat; j++)
+            time_stat_free(&table->time_stats[i].rtd[j]);
         g_free(table->time_stats[i].rtd);
     }
     g_free(table->time_stats);
@@ -97,10 +99,14 @@ void free_rtd_table(rtd_stat_table* table)
 
 void reset_rtd_table(rtd_stat_table* table)
 {
-    guint i = 0;
+    guint i = 0, j;
 
     for (i = 0; i < table->num_rtds; i++)
-        memset(table->time_stats[i].rtd, 0, sizeof(timestat_t)*table->time_stats[i].num_timestat);
+        for (j = 0; j < table->time_stats[i].num_timestat; j++)
+        {
+            time_stat_free(&table->time_stats[i].rtd[j]);
+            time_stat_init_histogram(&table->time_stats[i].rtd[j]);
+        }
 }
 
 register_rtd_t* get_rtd_table_by_name(const char* name)
@@ -138,7 +144,7 @@ void rtd_table_get_filter(register_rtd_t* rtd, const char *opt_arg, const char *
 
 void rtd_table_dissector_init(register_rtd_t* rtd, rtd_stat_table* table, rtd_gui_init_cb gui_callback, void *callback_data)
 {
-    guint i;
+    guint i, j;
 
     table->num_rtds = rtd->num_tables;
     table->time_stats = g_new0(rtd_timestat, rtd->num_tables);
@@ -147,6 +153,8 @@ void rtd_table_dissector_init(register_rtd_t* rtd, rtd_stat_table* table, rtd_gu
     {
         table->time_stats[i].num_timestat = rtd->num_timestats;
         table->time_stats[i].rtd = g_new0(timestat_t, rtd->num_timestats);
+        for (j = 0; j < rtd->num_timestats; j++)
+            time_stat_init_histogram(&table->time_stats[i].rtd[j]);
     }
 
     if (gui_callback)
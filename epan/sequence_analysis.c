@@ -243,30 +243,46 @@ sequence_analysis_list_free(seq_analysis_info_t *sainfo)
     sequence_analysis_free_nodes(sainfo);
 }
 
+static guint
+node_address_hash(gconstpointer key)
+{
+    return add_address_to_hash(0, (const address *)key);
+}
+
+static gboolean
+node_address_equal(gconstpointer a, gconstpointer b)
+{
+    return addresses_equal((const address *)a, (const address *)b);
+}
+
 /* Return the index array if the node is in the array. Return -1 if there is room in the array
  * and Return -2 if the array is full
+ * node_map maps the addresses in sainfo->nodes to their index + 1, so that
+ * every item doesn't have to be compared against all the nodes.
  */
 /****************************************************************************/
-static guint add_or_get_node(seq_analysis_info_t *sainfo, address *node) {
+static guint add_or_get_node(seq_analysis_info_t *sainfo, GHashTable *node_map, address *node) {
     guint i;
 
     if (node->type == AT_NONE) return NODE_OVERFLOW;
 
-    for (i=0; i<MAX_NUM_NODES && i < sainfo->num_nodes ; i++) {
-        if ( cmp_address(&(sainfo->nodes[i]), node) == 0 ) return i; /* it is in the array */
-    }
+    i = GPOINTER_TO_UINT(g_hash_table_lookup(node_map, node));
+    if (i > 0) return i - 1; /* it is in the array */
 
+    i = sainfo->num_nodes;
     if (i >= MAX_NUM_NODES) {
         return  NODE_OVERFLOW;
     } else {
         sainfo->num_nodes++;
         copy_address(&(sainfo->nodes[i]), node);
+        g_hash_table_insert(node_map, &(sainfo->nodes[i]), GUINT_TO_POINTER(i + 1));
         return i;
     }
 }
 
 struct sainfo_counter {
     seq_analysis_info_t *sainfo;
+    GHashTable *node_map;
     int num_items;
 };
 
@@ -276,8 +292,8 @@ static void sequence_analysis_get_nodes_item_proc(gpointer data, gpointer user_d
     struct sainfo_counter *sc = (struct sainfo_counter *)user_data;
     if (gai->display) {
         (sc->num_items)++;
-        gai->src_node = add_or_get_node(sc->sainfo, &(gai->src_addr));
-        gai->dst_node = add_or_get_node(sc->sainfo, &(gai->dst_addr));
+        gai->src_node = add_or_get_node(sc->sainfo, sc->node_map, &(gai->src_addr));
+        gai->dst_node = add_or_get_node(sc->sainfo, sc->node_map, &(gai->dst_addr));
     }
 }
 
@@ -286,11 +302,18 @@ static void sequence_analysis_get_nodes_item_proc(gpointer data, gpointer user_d
 int
 sequence_analysis_get_nodes(seq_analysis_info_t *sainfo)
 {
-    struct sainfo_counter sc = {sainfo, 0};
+    struct sainfo_counter sc = {sainfo, NULL, 0};
+    guint i;
+
+    sc.node_map = g_hash_table_new(node_address_hash, node_address_equal);
+    for (i = 0; i < sainfo->num_nodes && i < MAX_NUM_NODES; i++) {
+        g_hash_table_insert(sc.node_map, &(sainfo->nodes[i]), GUINT_TO_POINTER(i + 1));
+    }
 
     /* Fill the node array */
     g_queue_foreach(sainfo->items, sequence_analysis_get_nodes_item_proc, &sc);
 
+    g_hash_table_destroy(sc.node_map);
     return sc.num_items;
 }
 
@@ -67,6 +67,7 @@ free_srt_table_data(srt_stat_table *rst)
     for(i=0;i<rst->num_procs;i++){
         g_free(rst->procedures[i].procedure);
         rst->procedures[i].procedure=NULL;
+        time_stat_free(&rst->procedures[i].stats);
     }
     g_free(rst->filter_string);
     rst->filter_string=NULL;
@@ -101,7 +102,8 @@ static void reset_srt_table_data(srt_stat_table *rst)
     int i;
 
     for(i=0;i<rst->num_procs;i++){
-        time_stat_init(&rst->procedures[i].stats);
+        time_stat_free(&rst->procedures[i].stats);
+        time_stat_init_histogram(&rst->procedures[i].stats);
     }
 }
 
@@ -212,7 +214,7 @@ init_srt_table(const char *name, const char *short_name, GArray *srt_array, int
     table->num_procs=num_procs;
     table->procedures=g_new(srt_procedure_t, num_procs);
     for(i=0;i<num_procs;i++){
-        time_stat_init(&table->procedures[i].stats);
+        time_stat_init_histogram(&table->procedures[i].stats);
         table->procedures[i].proc_index = 0;
         table->procedures[i].procedure = NULL;
     }
@@ -235,7 +237,7 @@ init_srt_table_row(srt_stat_table *rst, int indx, const char *procedure)
         rst->num_procs=indx+1;
         rst->procedures=(srt_procedure_t *)g_realloc(rst->procedures, sizeof(srt_procedure_t)*(rst->num_procs));
         for(i=old_num_procs;i<rst->num_procs;i++){
-            time_stat_init(&rst->procedures[i].stats);
+            time_stat_init_histogram(&rst->procedures[i].stats);
             rst->procedures[i].proc_index = i;
             rst->procedures[i].procedure=NULL;
         }
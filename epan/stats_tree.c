@@ -215,6 +215,7 @@ stats_tree_reinit(void *p)
     }
 
     st->root.children = NULL;
+    st->root.last_child = NULL;
     st->root.counter = 0;
     switch (st->root.datatype)
     {
@@ -463,7 +464,6 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
 {
 
     stat_node *node = g_new0(stat_node, 1);
-    stat_node *last_chld = NULL;
 
     node->datatype = datatype;
     switch (datatype)
@@ -508,17 +508,12 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
 
     if (node->parent->children) {
         /* insert as last child */
-
-        for (last_chld = node->parent->children;
-             last_chld->next;
-             last_chld = last_chld->next ) ;
-
-        last_chld->next = node;
-
+        node->parent->last_child->next = node;
     } else {
         /* insert as first child */
         node->parent->children = node;
     }
+    node->parent->last_child = node;
 
     if(node->parent->hash) {
         g_hash_table_replace(node->parent->hash,node->name,node);
@@ -534,6 +529,41 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
 }
 /***/
 
+/*
+ * Looks up the child of parent called name, creating it if it doesn't
+ * exist yet. If the stats_tree preference limiting the number of children
+ * is set and parent already has that many, new names are instead counted
+ * in a single "Others" child so that trees keyed by values such as host
+ * names or URIs don't grow without bounds.
+ */
+static stat_node*
+get_or_new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node *parent,
+          stat_node_datatype datatype, gboolean with_hash)
+{
+    stat_node *node;
+
+    if (parent->hash) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if (node != NULL)
+        return node;
+
+    if (parent->hash && prefs.st_max_children > 0 &&
+            g_hash_table_size(parent->hash) >= (guint) prefs.st_max_children) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,STAT_TREE_OTHERS);
+        if (node == NULL) {
+            /* May have children of its own if the values it replaces do */
+            node = new_stat_node(st,STAT_TREE_OTHERS,parent_id,datatype,TRUE,TRUE);
+        }
+        return node;
+    }
+
+    return new_stat_node(st,name,parent_id,datatype,with_hash,with_hash);
+}
+
 extern int
 stats_tree_create_node(stats_tree *st, const gchar *name, int parent_id, stat_node_datatype datatype, gboolean with_hash)
 {
@@ -657,14 +687,7 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
 
     parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
 
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
-
-    if ( node == NULL )
-        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
+    node = get_or_new_stat_node(st,name,parent_id,parent,STAT_DT_INT,with_hash);
 
     switch (mode) {
         case MN_INCREASE:
@@ -719,15 +742,7 @@ stats_tree_manip_node_float(manip_node_mode mode, stats_tree *st, const char *na
 
     parent = (stat_node *)g_ptr_array_index(st->parents, parent_id);
 
-    if (parent->hash) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash, name);
-    }
-    else {
-        node = (stat_node *)g_hash_table_lookup(st->names, name);
-    }
-
-    if (node == NULL)
-        node = new_stat_node(st, name, parent_id, STAT_DT_FLOAT, with_hash, with_hash);
+    node = get_or_new_stat_node(st, name, parent_id, parent, STAT_DT_FLOAT, with_hash);
 
     switch (mode) {
     case MN_AVERAGE:
@@ -23,6 +23,8 @@ extern "C" {
 #endif /* __cplusplus */
 
 #define STAT_TREE_ROOT "root"
+/* Name of the node collecting values beyond the "st_max_children" preference */
+#define STAT_TREE_OTHERS "Others"
 
 #define ST_FLG_AVERAGE      0x10000000  /* Calculate averages for nodes, rather than totals */
 #define ST_FLG_ROOTCHILD    0x20000000  /* This node is a direct child of the root node */
@@ -90,6 +90,7 @@ struct _stat_node {
 	/** relatives */
 	stat_node		*parent;
 	stat_node		*children;
+	stat_node		*last_child;	/**< for appending without walking children */
 	stat_node		*next;
 
 	/** used to check if value is within range */
@@ -1361,7 +1361,7 @@ xml_escape(const gchar *unescaped)
 /* Return the first occurrence of needle in haystack.
  * If not found, return NULL.
  * If either haystack or needle has 0 length, return NULL.
- * Algorithm copied from GNU's glibc 2.3.2 memmem() under LGPL 2.1+ */
+ * Algorithm adapted from GNU's glibc 2.3.2 memmem() under LGPL 2.1+ */
 const guint8 *
 epan_memmem(const guint8 *haystack, guint haystack_len,
         const guint8 *needle, guint needle_len)
@@ -1377,10 +1377,15 @@ epan_memmem(const guint8 *haystack, guint haystack_len,
         return NULL;
     }
 
+    /*
+     * Let memchr(), which the C library usually vectorizes, skip ahead
+     * to each possible match.
+     */
     for (begin = haystack ; begin <= last_possible; ++begin) {
-        if (begin[0] == needle[0] &&
-                !memcmp(&begin[1], needle + 1,
-                    needle_len - 1)) {
+        begin = (const guint8 *)memchr(begin, needle[0], last_possible - begin + 1);
+        if (begin == NULL)
+            break;
+        if (!memcmp(&begin[1], needle + 1, needle_len - 1)) {
             return begin;
         }
     }
@@ -25,6 +25,7 @@
 #include <epan/packet_info.h>
 #include <epan/dfilter/dfilter.h>
 #include <epan/tap.h>
+#include <wsutil/ws_probes.h>
 
 static gboolean tapping_is_active=FALSE;
 
@@ -84,6 +85,12 @@ typedef struct _tap_listener_t {
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	/* An earlier listener in the queue with the same filter string,
+	 * whose filter result is reused instead of applying our own. */
+	struct _tap_listener_t *filter_twin;
+	guint filter_generation;	/* packet the result below is for */
+	gboolean filter_passed;
+	GArray *wanted_hfids;
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
@@ -93,6 +100,15 @@ typedef struct _tap_listener_t {
 
 static tap_listener_t *tap_listener_queue=NULL;
 
+/* Set to FALSE whenever a listener or filter is added, changed or
+ * removed, so that the filter_twin links get rebuilt. */
+static gboolean tap_filter_twins_valid=FALSE;
+
+/* Incremented for every dissected packet pushed to the listeners;
+ * a listener's cached filter result is only valid for the generation
+ * it was computed in. */
+static guint tap_filter_generation=0;
+
 static GSList *tap_plugins = NULL;
 
 #ifdef HAVE_PLUGINS
@@ -258,6 +274,48 @@ tap_queue_packet(int tap_id, packet_info *pinfo, const void *tap_specific_data)
  * Functions used by file.c to drive the tap subsystem
  * ********************************************************************** */
 
+/* Many listeners are often registered with the same filter (e.g. several
+ * "-z" statistics limited to the same traffic). Link each listener to the
+ * first one in the queue with an identical filter string so that the
+ * filter is only primed and applied once per packet.
+ */
+static void
+update_tap_filter_twins(void)
+{
+	tap_listener_t *tl, *tl2;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		tl->filter_twin=NULL;
+		tl->filter_generation=0;
+		if(!tl->code || !tl->fstring){
+			continue;
+		}
+		for(tl2=tap_listener_queue;tl2!=tl;tl2=tl2->next){
+			if(tl2->code && !tl2->filter_twin && tl2->fstring &&
+			   strcmp(tl2->fstring, tl->fstring) == 0){
+				tl->filter_twin=tl2;
+				break;
+			}
+		}
+	}
+	tap_filter_twins_valid=TRUE;
+}
+
+/* Returns whether the packet in edt passes the listener's filter, applying
+ * it at most once per packet for all listeners sharing the same filter.
+ */
+static gboolean
+tap_listener_filter_passed(tap_listener_t *tl, epan_dissect_t *edt)
+{
+	tap_listener_t *src = tl->filter_twin ? tl->filter_twin : tl;
+
+	if(src->filter_generation != tap_filter_generation){
+		src->filter_passed = dfilter_apply_edt(src->code, edt);
+		src->filter_generation = tap_filter_generation;
+	}
+	return src->filter_passed;
+}
+
 void tap_build_interesting (epan_dissect_t *edt)
 {
 	tap_listener_t *tl;
@@ -267,12 +325,19 @@ void tap_build_interesting (epan_dissect_t *edt)
 		return;
 	}
 
+	if(!tap_filter_twins_valid){
+		update_tap_filter_twins();
+	}
+
 	/* loop over all tap listeners and build the list of all
 	   interesting hf_fields */
 	for(tl=tap_listener_queue;tl;tl=tl->next){
-		if(tl->code){
+		if(tl->code && !tl->filter_twin){
 			epan_dissect_prime_with_dfilter(edt, tl->code);
 		}
+		if(tl->wanted_hfids){
+			epan_dissect_prime_with_hfid_array(edt, tl->wanted_hfids);
+		}
 	}
 }
 
@@ -317,6 +382,17 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	WS_PROBE2(tap_push, tap_packet_array[0].pinfo->num, tap_packet_index);
+
+	if(!tap_filter_twins_valid){
+		update_tap_filter_twins();
+	}
+
+	/* invalidate the filter results cached for the previous packet */
+	if(++tap_filter_generation == 0){
+		tap_filter_generation=1;
+	}
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
@@ -347,7 +423,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					 * packet passes.
 					 */
 					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+						if (!tap_listener_filter_passed(tl, edt)){
 							/* The packet didn't
 							 * pass the filter. */
 							continue;
@@ -516,6 +592,9 @@ free_tap_listener(tap_listener_t *tl)
 		tl->finish(tl->tapdata);
 	}
 	dfilter_free(tl->code);
+	if (tl->wanted_hfids) {
+		g_array_free(tl->wanted_hfids, TRUE);
+	}
 	g_free(tl->fstring);
 	g_free(tl);
 }
@@ -571,6 +650,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->next=tap_listener_queue;
 
 	tap_listener_queue=tl;
+	tap_filter_twins_valid=FALSE;
 
 	return NULL;
 }
@@ -602,6 +682,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 	}
 
 	if(tl){
+		tap_filter_twins_valid=FALSE;
 		if(tl->code){
 			dfilter_free(tl->code);
 			tl->code=NULL;
@@ -626,6 +707,30 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 	return NULL;
 }
 
+/* this function tells the tap system which fields a tap listener reads
+ * out of the protocol tree, so that a tree with just those fields can be
+ * built rather than the full one.
+ */
+void
+set_tap_listener_wanted_hfids(void *tapdata, GArray *wanted_hfids)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			if(tl->wanted_hfids){
+				g_array_free(tl->wanted_hfids, TRUE);
+			}
+			tl->wanted_hfids=wanted_hfids;
+			tl->needs_redraw=TRUE;
+			return;
+		}
+	}
+	if(wanted_hfids){
+		g_array_free(wanted_hfids, TRUE);
+	}
+}
+
 /* this function recompiles dfilter for all registered tap listeners
  */
 void
@@ -653,6 +758,7 @@ tap_listeners_dfilter_recompile(void)
 		}
 		tl->code=code;
 	}
+	tap_filter_twins_valid=FALSE;
 }
 
 /* this function removes a tap listener
@@ -684,6 +790,7 @@ remove_tap_listener(void *tapdata)
 		}
 	}
 	free_tap_listener(tl);
+	tap_filter_twins_valid=FALSE;
 }
 
 /*
@@ -731,7 +838,7 @@ have_filtering_tap_listeners(void)
 	tap_listener_t *tl;
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
-		if(tl->code)
+		if(tl->code || tl->wanted_hfids)
 			return TRUE;
 	}
 	return FALSE;
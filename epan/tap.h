@@ -229,6 +229,20 @@ WS_DLL_PUBLIC GString *register_tap_listener(const char *tapname, void *tapdata,
 /** This function sets a new dfilter to a tap listener */
 WS_DLL_PUBLIC GString *set_tap_dfilter(void *tapdata, const char *fstring);
 
+/**
+ * Tell the tap system which fields a tap listener reads from edt->tree.
+ *
+ * A listener that only needs a handful of fields can register with
+ * TL_REQUIRES_NOTHING and list them here instead of asking for
+ * TL_REQUIRES_PROTO_TREE; the tree is then built only far enough to hold
+ * those fields, and not at all if no listener wants any.
+ *
+ * @param tapdata      the tapdata pointer the listener was registered with.
+ * @param wanted_hfids a GArray of int hf ids, or NULL to clear the list.
+ *                     The tap system takes ownership of the array.
+ */
+WS_DLL_PUBLIC void set_tap_listener_wanted_hfids(void *tapdata, GArray *wanted_hfids);
+
 /** This function recompiles dfilter for all registered tap listeners */
 WS_DLL_PUBLIC void tap_listeners_dfilter_recompile(void);
 
@@ -244,7 +258,10 @@ WS_DLL_PUBLIC gboolean tap_listeners_require_dissection(void);
 /** Returns TRUE there is an active tap listener for the specified tap id. */
 WS_DLL_PUBLIC gboolean have_tap_listener(int tap_id);
 
-/** Return TRUE if we have any tap listeners with filters, FALSE otherwise. */
+/**
+ * Return TRUE if we have any tap listeners with filters or wanted fields,
+ * FALSE otherwise.
+ */
 WS_DLL_PUBLIC gboolean have_filtering_tap_listeners(void);
 
 /**
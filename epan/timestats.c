@@ -13,6 +13,55 @@
 
 #include "timestats.h"
 
+/*
+ * Histogram buckets in microseconds. Values below TS_HIST_LINEAR each have
+ * their own bucket; above that every power of two is split into
+ * TS_HIST_SUB_BUCKETS buckets, up to 2^TS_HIST_MAX_LOG2 us (about 12
+ * days), which larger values are clamped to.
+ */
+#define TS_HIST_SUB_BITS	3
+#define TS_HIST_SUB_BUCKETS	(1 << TS_HIST_SUB_BITS)
+#define TS_HIST_LINEAR		(2 * TS_HIST_SUB_BUCKETS)
+#define TS_HIST_MIN_LOG2	(TS_HIST_SUB_BITS + 1)
+#define TS_HIST_MAX_LOG2	40
+#define TS_HIST_NUM_BUCKETS	(TS_HIST_LINEAR + (TS_HIST_MAX_LOG2 - TS_HIST_MIN_LOG2) * TS_HIST_SUB_BUCKETS)
+
+static guint
+time_stat_bucket(guint64 usecs)
+{
+	guint log2 = 0;
+
+	if (usecs < TS_HIST_LINEAR)
+		return (guint)usecs;
+
+	if (usecs >= G_GUINT64_CONSTANT(1) << TS_HIST_MAX_LOG2)
+		return TS_HIST_NUM_BUCKETS - 1;
+
+	while ((usecs >> log2) > 1)
+		log2++;
+
+	return TS_HIST_LINEAR + (log2 - TS_HIST_MIN_LOG2) * TS_HIST_SUB_BUCKETS +
+		(guint)((usecs >> (log2 - TS_HIST_SUB_BITS)) & (TS_HIST_SUB_BUCKETS - 1));
+}
+
+/* Lowest value and width of a bucket, in microseconds */
+static void
+time_stat_bucket_range(guint bucket, guint64 *low, guint64 *width)
+{
+	guint log2;
+
+	if (bucket < TS_HIST_LINEAR) {
+		*low = bucket;
+		*width = 1;
+		return;
+	}
+
+	bucket -= TS_HIST_LINEAR;
+	log2 = TS_HIST_MIN_LOG2 + bucket / TS_HIST_SUB_BUCKETS;
+	*width = G_GUINT64_CONSTANT(1) << (log2 - TS_HIST_SUB_BITS);
+	*low = (G_GUINT64_CONSTANT(1) << log2) + (bucket % TS_HIST_SUB_BUCKETS) * *width;
+}
+
 /* Initialize a timestat_t struct */
 void
 time_stat_init(timestat_t *stats)
@@ -24,6 +73,22 @@ time_stat_init(timestat_t *stats)
 	nstime_set_zero(&stats->max);
 	nstime_set_zero(&stats->tot);
 	stats->variance = 0.0;
+	stats->want_histogram = FALSE;
+	stats->histogram = NULL;
+}
+
+void
+time_stat_init_histogram(timestat_t *stats)
+{
+	time_stat_init(stats);
+	stats->want_histogram = TRUE;
+}
+
+void
+time_stat_free(timestat_t *stats)
+{
+	g_free(stats->histogram);
+	stats->histogram = NULL;
 }
 
 /* Update a timestat_t struct with a new sample */
@@ -53,6 +118,17 @@ time_stat_update(timestat_t *stats, const nstime_t *delta, packet_info *pinfo)
 
 	nstime_add(&stats->tot, delta);
 
+	if (stats->want_histogram) {
+		guint64 usecs = 0;
+
+		if (delta->secs >= 0 && delta->nsecs >= 0)
+			usecs = (guint64)delta->secs * 1000000 + (guint64)delta->nsecs / 1000;
+
+		if (!stats->histogram)
+			stats->histogram = g_new0(guint32, TS_HIST_NUM_BUCKETS);
+		stats->histogram[time_stat_bucket(usecs)]++;
+	}
+
 	stats->num++;
 }
 
@@ -77,6 +153,43 @@ gdouble get_average(const nstime_t *sum, guint32 num)
 	return average;
 }
 
+gdouble
+time_stat_percentile(const timestat_t *stats, gdouble percentile)
+{
+	guint64 rank, seen = 0;
+	guint64 low, width;
+	gdouble value, min_ms, max_ms;
+	guint i;
+
+	if (!stats->histogram || stats->num == 0)
+		return 0;
+
+	/* The sample at this 1-based rank is the percentile */
+	rank = (guint64)(percentile / 100.0 * stats->num + 0.5);
+	if (rank < 1)
+		rank = 1;
+	if (rank > stats->num)
+		rank = stats->num;
+
+	for (i = 0; i < TS_HIST_NUM_BUCKETS - 1; i++) {
+		seen += stats->histogram[i];
+		if (seen >= rank)
+			break;
+	}
+
+	/* Use the middle of the bucket, but never beyond the exact extremes */
+	time_stat_bucket_range(i, &low, &width);
+	value = (low + width / 2.0) / 1000.0;
+	min_ms = nstime_to_msec(&stats->min);
+	max_ms = nstime_to_msec(&stats->max);
+	if (value < min_ms)
+		value = min_ms;
+	if (value > max_ms)
+		value = max_ms;
+
+	return value;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -29,6 +29,8 @@ typedef struct _timestat_t {
 	nstime_t max;
 	nstime_t tot;
 	gdouble variance;
+	gboolean want_histogram; /* keep a histogram for percentiles */
+	guint32 *histogram;	 /* log-scale sample counts, allocated on first update */
 } timestat_t;
 
 /* functions */
@@ -36,11 +38,25 @@ typedef struct _timestat_t {
 /* Initialize a timestat_t struct */
 WS_DLL_PUBLIC void time_stat_init(timestat_t *stats);
 
+/* Initialize a timestat_t struct that also keeps a histogram of its
+ * samples so that time_stat_percentile() can be used. The histogram uses
+ * a fixed number of logarithmic buckets (about 6% relative error), so its
+ * size doesn't depend on the number of samples. It must be released with
+ * time_stat_free(). */
+WS_DLL_PUBLIC void time_stat_init_histogram(timestat_t *stats);
+
+/* Free the histogram of a timestat_t struct, if any */
+WS_DLL_PUBLIC void time_stat_free(timestat_t *stats);
+
 /* Update a timestat_t struct with a new sample */
 WS_DLL_PUBLIC void time_stat_update(timestat_t *stats, const nstime_t *delta, packet_info *pinfo);
 
 WS_DLL_PUBLIC gdouble get_average(const nstime_t *sum, guint32 num);
 
+/* Returns an estimate of the given percentile (0.0 - 100.0) of the samples
+ * in milliseconds, or 0 if the struct doesn't keep a histogram. */
+WS_DLL_PUBLIC gdouble time_stat_percentile(const timestat_t *stats, gdouble percentile);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -759,6 +759,20 @@ display_signed_time(gchar *buf, int buflen, const gint64 sec, gint32 frac,
  */
 #define TIME_SECS_LEN	(10+1+4+2+2+5+2+2+7+2+2+7+4)
 
+/*
+ * Append "<value> <unit>", pluralized and preceded by a comma if requested.
+ */
+static void
+time_secs_append_unit(wmem_strbuf_t *buf, const gboolean do_comma,
+    const guint32 value, const char *unit)
+{
+	wmem_strbuf_append(buf, COMMA(do_comma));
+	wmem_strbuf_append_uint(buf, value);
+	wmem_strbuf_append_c(buf, ' ');
+	wmem_strbuf_append(buf, unit);
+	wmem_strbuf_append(buf, PLURALIZE(value));
+}
+
 /*
  * Convert an unsigned value in seconds and fractions of a second to a string,
  * giving time in days, hours, minutes, and seconds, and put the result
@@ -781,15 +795,15 @@ unsigned_time_secs_to_str_buf(guint32 time_val, const guint32 frac,
 	time_val /= 24;
 
 	if (time_val != 0) {
-		wmem_strbuf_append_printf(buf, "%u day%s", time_val, PLURALIZE(time_val));
+		time_secs_append_unit(buf, FALSE, time_val, "day");
 		do_comma = TRUE;
 	}
 	if (hours != 0) {
-		wmem_strbuf_append_printf(buf, "%s%u hour%s", COMMA(do_comma), hours, PLURALIZE(hours));
+		time_secs_append_unit(buf, do_comma, hours, "hour");
 		do_comma = TRUE;
 	}
 	if (mins != 0) {
-		wmem_strbuf_append_printf(buf, "%s%u minute%s", COMMA(do_comma), mins, PLURALIZE(mins));
+		time_secs_append_unit(buf, do_comma, mins, "minute");
 		do_comma = TRUE;
 	}
 	if (secs != 0 || frac != 0) {
@@ -799,7 +813,7 @@ unsigned_time_secs_to_str_buf(guint32 time_val, const guint32 frac,
 			else
 				wmem_strbuf_append_printf(buf, "%s%u.%03u seconds", COMMA(do_comma), secs, frac);
 		} else
-			wmem_strbuf_append_printf(buf, "%s%u second%s", COMMA(do_comma), secs, PLURALIZE(secs));
+			time_secs_append_unit(buf, do_comma, secs, "second");
 	}
 }
 
@@ -61,6 +61,8 @@ struct epan_uat {
     uat_rep_free_cb_t free_rep;
     gboolean loaded;
     gboolean from_global;
+    guint generation;   /**< Changed whenever user_data is, so that indexes know to rebuild. */
+    GSList* indexes;    /**< uat_index_t's built on user_data. */
 };
 
 WS_DLL_PUBLIC
@@ -134,7 +136,7 @@ char *uat_fld_tostr(void *rec, uat_field_t *f);
  * Exposes the array of valid records to the UAT consumer (dissectors), updating
  * the contents of 'data_ptr' and 'num_items_ptr' (see 'uat_new').
  */
-#define UAT_UPDATE(uat) do { *((uat)->user_ptr) = (void*)((uat)->user_data->data); *((uat)->nrows_p) = (uat)->user_data->len; } while(0)
+#define UAT_UPDATE(uat) do { *((uat)->user_ptr) = (void*)((uat)->user_data->data); *((uat)->nrows_p) = (uat)->user_data->len; (uat)->generation++; } while(0)
 /**
  * Get a record from the array of all UAT entries, whether they are semantically
  * valid or not. This memory must only be used internally in the UAT core and
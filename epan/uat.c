@@ -25,6 +25,8 @@
 #include <wsutil/file_util.h>
 #include <wsutil/str_util.h>
 #include <wsutil/report_message.h>
+#include <wsutil/startup_profile.h>
+#include <wsutil/time_util.h>
 
 #include <wsutil/filesystem.h>
 #include <epan/packet.h>
@@ -90,6 +92,8 @@ uat_t* uat_new(const char* name,
     uat->changed = FALSE;
     uat->loaded = FALSE;
     uat->from_global = FALSE;
+    uat->generation = 0;
+    uat->indexes = NULL;
     uat->rep = NULL;
     uat->free_rep = NULL;
     uat->help = g_strdup(help);
@@ -471,12 +475,111 @@ void uat_clear(uat_t* uat) {
 
     *((uat)->user_ptr) = NULL;
     *((uat)->nrows_p) = 0;
+    uat->generation++;
 
     if (uat->reset_cb) {
         uat->reset_cb();
     }
 }
 
+struct _uat_index {
+    uat_t *uat;
+    uat_index_key_cb_t key_cb;
+    guint generation;       /* of the UAT, when the index was built */
+    gboolean built;
+    GHashTable *by_key;     /* key -> GArray of record numbers, ascending */
+    GArray *unkeyed;        /* numbers of the records without a key, ascending */
+};
+
+static void uat_index_free_records(gpointer data) {
+    g_array_free((GArray *)data, TRUE);
+}
+
+uat_index_t *uat_index_new(uat_t *uat, uat_index_key_cb_t key_cb,
+                           GHashFunc hash_func, GEqualFunc equal_func) {
+    uat_index_t *index = g_new0(uat_index_t, 1);
+
+    index->uat = uat;
+    index->key_cb = key_cb;
+    index->by_key = g_hash_table_new_full(hash_func, equal_func, NULL, uat_index_free_records);
+    index->unkeyed = g_array_new(FALSE, FALSE, sizeof(guint));
+    uat->indexes = g_slist_prepend(uat->indexes, index);
+
+    return index;
+}
+
+static void uat_index_free(gpointer data) {
+    uat_index_t *index = (uat_index_t *)data;
+
+    g_hash_table_destroy(index->by_key);
+    g_array_free(index->unkeyed, TRUE);
+    g_free(index);
+}
+
+static void uat_index_build(uat_index_t *index) {
+    uat_t *uat = index->uat;
+    guint i;
+
+    g_hash_table_remove_all(index->by_key);
+    g_array_set_size(index->unkeyed, 0);
+
+    for (i = 0; i < uat->user_data->len; i++) {
+        gconstpointer key = index->key_cb(UAT_USER_INDEX_PTR(uat, i));
+
+        if (key) {
+            GArray *records = (GArray *)g_hash_table_lookup(index->by_key, key);
+
+            if (!records) {
+                records = g_array_sized_new(FALSE, FALSE, sizeof(guint), 1);
+                g_hash_table_insert(index->by_key, (gpointer)key, records);
+            }
+            g_array_append_val(records, i);
+        } else {
+            g_array_append_val(index->unkeyed, i);
+        }
+    }
+
+    index->generation = uat->generation;
+    index->built = TRUE;
+}
+
+void *uat_index_lookup(uat_index_t *index, gconstpointer key,
+                       uat_index_match_cb_t match_cb, void *user_data) {
+    uat_t *uat = index->uat;
+    GArray *keyed;
+    guint k = 0, u = 0;
+
+    if (!index->built || index->generation != uat->generation) {
+        uat_index_build(index);
+    }
+
+    keyed = (GArray *)g_hash_table_lookup(index->by_key, key);
+
+    /* Merge the records with the key and those without, in table order. */
+    for (;;) {
+        guint k_rec = (keyed && k < keyed->len) ? g_array_index(keyed, guint, k) : G_MAXUINT;
+        guint u_rec = (u < index->unkeyed->len) ? g_array_index(index->unkeyed, guint, u) : G_MAXUINT;
+        guint rec;
+        void *record;
+
+        if (k_rec == G_MAXUINT && u_rec == G_MAXUINT) {
+            return NULL;
+        }
+        if (k_rec < u_rec) {
+            rec = k_rec;
+            k++;
+        } else {
+            rec = u_rec;
+            u++;
+        }
+
+        record = UAT_USER_INDEX_PTR(uat, rec);
+        if (match_cb(record, user_data)) {
+            return record;
+        }
+    }
+}
+
 void uat_unload_all(void) {
     guint i;
 
@@ -504,6 +607,7 @@ void uat_cleanup(void) {
         g_array_free(uat->user_data, TRUE);
         g_array_free(uat->raw_data, TRUE);
         g_array_free(uat->valid_data, TRUE);
+        g_slist_free_full(uat->indexes, uat_index_free);
         for (j = 0; uat->fields[j].title; j++)
             g_free(uat->fields[j].priv);
         g_free(uat);
@@ -523,18 +627,24 @@ void uat_foreach_table(uat_cb_t cb,void* user_data) {
 void uat_load_all(void) {
     guint i;
     gchar* err;
+    guint64 start_ns;
+    guint profile_phase = startup_profile_begin("uat_load_all");
 
     for (i=0; i < all_uats->len; i++) {
         uat_t* u = (uat_t *)g_ptr_array_index(all_uats,i);
 
         if (!u->loaded) {
             err = NULL;
+            start_ns = get_monotonic_ns();
             if (!uat_load(u, NULL, &err)) {
                 report_failure("Error loading table '%s': %s",u->name,err);
                 g_free(err);
             }
+            startup_profile_item("uat", u->name, get_monotonic_ns() - start_ns);
         }
     }
+
+    startup_profile_end(profile_phase);
 }
 
 
@@ -331,6 +331,59 @@ uat_t *uat_find(gchar *name);
 WS_DLL_PUBLIC
 uat_t* uat_get_table_by_name(const char* name);
 
+/*
+ * Indexes of the records of a UAT, for dissectors that look records up
+ * for every packet in tables that may have tens of thousands of them.
+ *
+ * A record's key is given by a callback, and compared with the hash and
+ * equality functions given; records that can't be put under one key (that
+ * have wildcards, say) are checked for every lookup.  The index is rebuilt
+ * on the first lookup after the records change, so it needs no updating
+ * from the update or post-update callbacks.
+ */
+typedef struct _uat_index uat_index_t;
+
+/**
+ * Key callback: return a pointer to the key of a record, which must stay
+ * valid as long as the record does, or NULL if the record has no single
+ * key.
+ */
+typedef gconstpointer (*uat_index_key_cb_t)(const void *record);
+
+/**
+ * Match callback: return TRUE if a record is the one looked for.
+ */
+typedef gboolean (*uat_index_match_cb_t)(const void *record, void *user_data);
+
+/** Create an index of a UAT.  It's freed with the UAT.
+ *
+ * @param uat The UAT to index.
+ * @param key_cb Gives the key of a record.
+ * @param hash_func Hashes keys.
+ * @param equal_func Compares keys.
+ *
+ * @return The index.
+ */
+WS_DLL_PUBLIC
+uat_index_t *uat_index_new(uat_t *uat, uat_index_key_cb_t key_cb,
+                           GHashFunc hash_func, GEqualFunc equal_func);
+
+/** Find the first record, in table order, that has the key, or no key,
+ * and that match_cb accepts; the same one a scan of the whole table with
+ * match_cb would find.
+ *
+ * @param index The index.
+ * @param key The key to look up.
+ * @param match_cb Called on the candidate records, in table order, until
+ * it returns TRUE.
+ * @param user_data Passed to match_cb.
+ *
+ * @return The record, or NULL if there's none.
+ */
+WS_DLL_PUBLIC
+void *uat_index_lookup(uat_index_t *index, gconstpointer key,
+                       uat_index_match_cb_t match_cb, void *user_data);
+
 /*
  * Some common uat_fld_chk_cbs
  */
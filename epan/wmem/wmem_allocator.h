@@ -20,6 +20,7 @@ extern "C" {
 #endif /* __cplusplus */
 
 struct _wmem_user_cb_container_t;
+struct _wmem_allocator_stats_t;
 
 /* See section "4. Internal Design" of doc/README.wmem for details
  * on this structure */
@@ -37,6 +38,9 @@ struct _wmem_allocator_t {
     /* Callback List */
     struct _wmem_user_cb_container_t *callbacks;
 
+    /* Allocation statistics, if enabled (see wmem_stats_enable()) */
+    struct _wmem_allocator_stats_t *stats;
+
     /* Implementation details */
     void                        *private_data;
     enum _wmem_allocator_type_t  type;
@@ -9,15 +9,23 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#include "config.h"
+
 #include <stdio.h>
 #include <string.h>
 
 #include <glib.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include "wmem_core.h"
 #include "wmem_allocator.h"
 #include "wmem_allocator_block.h"
 
+#include <wsutil/ws_probes.h>
+
 /* This has turned into a very interesting excercise in algorithms and data
  * structures.
  *
@@ -141,6 +149,11 @@
  * also a nice power of two, of course. */
 #define WMEM_BLOCK_SIZE (8 * 1024 * 1024)
 
+/* With huge pages enabled, blocks are mapped aligned to this, which is the
+ * size of a transparent huge page on x86-64 and most other platforms that
+ * have them. Erring on the large side only costs some address space. */
+#define WMEM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
 /* The header for an entire OS-level 'block' of memory */
 typedef struct _wmem_block_hdr_t {
     struct _wmem_block_hdr_t *prev, *next;
@@ -199,6 +212,10 @@ typedef struct _wmem_block_allocator_t {
     wmem_block_hdr_t   *block_list;
     wmem_block_chunk_t *master_head;
     wmem_block_chunk_t *recycler_head;
+
+    /* blocks are mmapped with huge pages, see
+     * wmem_block_allocator_set_huge_pages() */
+    gboolean            huge_pages;
 } wmem_block_allocator_t;
 
 /* DEBUG AND TEST */
@@ -755,6 +772,55 @@ wmem_block_init_block(wmem_block_allocator_t *allocator,
     wmem_block_push_master(allocator, chunk);
 }
 
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS)
+/* Maps a block aligned to a huge page, so that the kernel can back all of it
+ * with huge pages. */
+static wmem_block_hdr_t *
+wmem_block_map_block(void)
+{
+    guint8 *map, *block;
+    size_t  head;
+
+    /* map a huge page more than needed, then trim it to an aligned block */
+    map = (guint8 *)mmap(NULL, WMEM_BLOCK_SIZE + WMEM_HUGE_PAGE_SIZE,
+            PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        g_error("%s: failed to map %u bytes", G_STRLOC,
+                WMEM_BLOCK_SIZE + WMEM_HUGE_PAGE_SIZE);
+    }
+
+    block = (guint8 *)(((guintptr)map + WMEM_HUGE_PAGE_SIZE - 1) &
+            ~(guintptr)(WMEM_HUGE_PAGE_SIZE - 1));
+    head  = block - map;
+    if (head) {
+        munmap(map, head);
+    }
+    munmap(block + WMEM_BLOCK_SIZE, WMEM_HUGE_PAGE_SIZE - head);
+
+#ifdef MADV_HUGEPAGE
+    madvise(block, WMEM_BLOCK_SIZE, MADV_HUGEPAGE);
+#endif
+
+    return (wmem_block_hdr_t *)block;
+}
+#endif
+
+/* Returns a block that is entirely unused to the OS. */
+static void
+wmem_block_free_block(wmem_block_allocator_t *allocator,
+                      wmem_block_hdr_t *block)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS)
+    if (allocator->huge_pages) {
+        munmap(block, WMEM_BLOCK_SIZE);
+        return;
+    }
+#else
+    (void)allocator;
+#endif
+    wmem_free(NULL, block);
+}
+
 /* Creates a new block, and initializes it. */
 static void
 wmem_block_new_block(wmem_block_allocator_t *allocator)
@@ -762,8 +828,15 @@ wmem_block_new_block(wmem_block_allocator_t *allocator)
     wmem_block_hdr_t *block;
 
     /* allocate the new block and add it to the block list */
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS)
+    if (allocator->huge_pages) {
+        block = wmem_block_map_block();
+    }
+    else
+#endif
     block = (wmem_block_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
     wmem_block_add_to_block_list(allocator, block);
+    WS_PROBE1(wmem_block_new, WMEM_BLOCK_SIZE);
 
     /* initialize it */
     wmem_block_init_block(allocator, block);
@@ -785,6 +858,7 @@ wmem_block_alloc_jumbo(wmem_block_allocator_t *allocator, const size_t size)
 
     /* add it to the block list */
     wmem_block_add_to_block_list(allocator, block);
+    WS_PROBE1(wmem_block_new, size + WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
 
     /* the new block contains a single jumbo chunk */
     chunk = WMEM_BLOCK_TO_CHUNK(block);
@@ -1022,6 +1096,17 @@ wmem_block_free_all(void *private_data)
             wmem_free(NULL, WMEM_CHUNK_TO_BLOCK(chunk));
         }
         else {
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_DONTNEED)
+            /* Give the pages back to the OS right away; they are faulted
+             * back in, zeroed, as the block is reused. The block header
+             * lives inside the block, so save the link first. */
+            if (allocator->huge_pages) {
+                wmem_block_hdr_t saved = *cur;
+
+                madvise(cur, WMEM_BLOCK_SIZE, MADV_DONTNEED);
+                *cur = saved;
+            }
+#endif
             wmem_block_init_block(allocator, cur);
             cur = cur->next;
         }
@@ -1067,7 +1152,7 @@ wmem_block_gc(void *private_data)
             else if (allocator->master_head == chunk) {
                 allocator->master_head = free_chunk->next;
             }
-            wmem_free(NULL, cur);
+            wmem_block_free_block(allocator, cur);
         }
         else {
             /* part of this block is used, so add it to the new block list */
@@ -1109,6 +1194,29 @@ wmem_block_allocator_init(wmem_allocator_t *allocator)
     block_allocator->block_list    = NULL;
     block_allocator->master_head   = NULL;
     block_allocator->recycler_head = NULL;
+    block_allocator->huge_pages    = FALSE;
+}
+
+void
+wmem_block_allocator_set_huge_pages(wmem_allocator_t *allocator,
+                                    gboolean huge_pages)
+{
+    wmem_block_allocator_t *block_allocator;
+
+    if (allocator->type != WMEM_ALLOCATOR_BLOCK) {
+        return;
+    }
+
+    block_allocator = (wmem_block_allocator_t*) allocator->private_data;
+
+    /* existing blocks would be freed the wrong way */
+    g_assert(block_allocator->block_list == NULL);
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS)
+    block_allocator->huge_pages = huge_pages;
+#else
+    (void)huge_pages;
+#endif
 }
 
 /*
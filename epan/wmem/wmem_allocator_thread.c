@@ -0,0 +1,379 @@
+/* wmem_allocator_thread.c
+ * Wireshark Memory Manager Thread-Caching Allocator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "wmem_core.h"
+#include "wmem_allocator.h"
+#include "wmem_allocator_thread.h"
+
+/* This allocator can be shared by several threads that allocate from it at
+ * the same time. It works like the fast block allocator, except that every
+ * thread serves its allocations out of its own blocks, so allocating takes
+ * no lock:
+ *
+ *  - Each thread that uses the allocator gets a cache holding the blocks it
+ *    carves allocations from. Threads find their cache through a short
+ *    thread-local list, keyed by a unique id of the allocator.
+ *  - A lock is taken only when a thread runs out of space and needs another
+ *    block, which it takes from a pool of blocks released by free_all, and
+ *    the first time a thread uses the allocator.
+ *  - Freeing is a no-op, as with the fast block allocator, so memory can be
+ *    "returned" from any thread without synchronization. Reallocations that
+ *    grow copy into the calling thread's cache.
+ *
+ * free_all, gc and destroying the allocator must not run concurrently with
+ * any other use of it; they are the points at which all threads are expected
+ * to have finished with the memory anyway.
+ */
+
+/* https://mail.gnome.org/archives/gtk-devel-list/2004-December/msg00091.html
+ * The 2*sizeof(size_t) alignment here is borrowed from GNU libc, so it should
+ * be good most everywhere. It is more conservative than is needed on some
+ * 64-bit platforms, but ia64 does require a 16-byte alignment. The SIMD
+ * extensions for x86 and ppc32 would want a larger alignment than this, but
+ * we don't need to do better than malloc.
+ */
+#define WMEM_ALIGN_AMOUNT (2 * sizeof (gsize))
+#define WMEM_ALIGN_SIZE(SIZE) ((~(WMEM_ALIGN_AMOUNT-1)) & \
+        ((SIZE) + (WMEM_ALIGN_AMOUNT-1)))
+
+#define WMEM_CHUNK_TO_DATA(CHUNK) ((void*)((guint8*)(CHUNK) + WMEM_CHUNK_HEADER_SIZE))
+#define WMEM_DATA_TO_CHUNK(DATA) ((wmem_thread_chunk_t*)((guint8*)(DATA) - WMEM_CHUNK_HEADER_SIZE))
+
+#define WMEM_BLOCK_MAX_ALLOC_SIZE (WMEM_BLOCK_SIZE - (WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE))
+
+/* Each thread holds at least one block of this size, so it is smaller than
+ * the blocks of the other allocators to keep mostly idle threads cheap. */
+#define WMEM_BLOCK_SIZE (1024 * 1024)
+
+/* The header for an entire OS-level 'block' of memory */
+typedef struct _wmem_thread_block_hdr {
+    struct _wmem_thread_block_hdr *next;
+
+    gint32 pos;
+} wmem_thread_block_hdr_t;
+#define WMEM_BLOCK_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_thread_block_hdr_t))
+
+typedef struct {
+    guint32 len;
+} wmem_thread_chunk_t;
+#define WMEM_CHUNK_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_thread_chunk_t))
+
+#define JUMBO_MAGIC 0xFFFFFFFF
+typedef struct _wmem_thread_jumbo {
+    struct _wmem_thread_jumbo *next;
+    size_t len;
+} wmem_thread_jumbo_t;
+#define WMEM_JUMBO_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_thread_jumbo_t))
+
+/* The blocks one thread allocates from */
+typedef struct _wmem_thread_cache {
+    struct _wmem_thread_cache *next;    /* all caches of the allocator */
+    wmem_thread_block_hdr_t   *block_list;
+    wmem_thread_jumbo_t       *jumbo_list;
+} wmem_thread_cache_t;
+
+typedef struct {
+    guint                    id;
+    GMutex                   lock;       /* protects caches and free_blocks */
+    wmem_thread_cache_t     *caches;
+    wmem_thread_block_hdr_t *free_blocks;
+} wmem_thread_allocator_t;
+
+/* The thread-local list of the caches a thread has, most recently used first.
+ * Entries of destroyed allocators are never matched again, since ids aren't
+ * reused, and are only freed when the thread exits. */
+typedef struct _wmem_thread_cache_ref {
+    struct _wmem_thread_cache_ref *next;
+    guint                          allocator_id;
+    wmem_thread_cache_t           *cache;
+} wmem_thread_cache_ref_t;
+
+static void
+wmem_thread_free_cache_refs(gpointer data)
+{
+    wmem_thread_cache_ref_t *ref = (wmem_thread_cache_ref_t *)data;
+    wmem_thread_cache_ref_t *next;
+
+    while (ref) {
+        next = ref->next;
+        wmem_free(NULL, ref);
+        ref = next;
+    }
+}
+
+static GPrivate thread_cache_refs = G_PRIVATE_INIT(wmem_thread_free_cache_refs);
+
+static gint next_allocator_id = 1;
+
+/* Returns the calling thread's cache, creating it on first use. */
+static inline wmem_thread_cache_t *
+wmem_thread_get_cache(wmem_thread_allocator_t *allocator)
+{
+    wmem_thread_cache_ref_t *refs, *ref, *prev;
+    wmem_thread_cache_t     *cache;
+
+    refs = (wmem_thread_cache_ref_t *)g_private_get(&thread_cache_refs);
+    if (G_LIKELY(refs && refs->allocator_id == allocator->id)) {
+        return refs->cache;
+    }
+
+    for (prev = refs, ref = refs ? refs->next : NULL; ref; prev = ref, ref = ref->next) {
+        if (ref->allocator_id == allocator->id) {
+            /* move it to the front for the next lookup */
+            prev->next = ref->next;
+            ref->next  = refs;
+            g_private_set(&thread_cache_refs, ref);
+            return ref->cache;
+        }
+    }
+
+    cache = wmem_new0(NULL, wmem_thread_cache_t);
+
+    g_mutex_lock(&allocator->lock);
+    cache->next       = allocator->caches;
+    allocator->caches = cache;
+    g_mutex_unlock(&allocator->lock);
+
+    ref = wmem_new(NULL, wmem_thread_cache_ref_t);
+    ref->allocator_id = allocator->id;
+    ref->cache        = cache;
+    ref->next         = refs;
+    g_private_set(&thread_cache_refs, ref);
+
+    return cache;
+}
+
+/* Gives a thread a fresh block, reusing one released earlier if possible. */
+static void
+wmem_thread_new_block(wmem_thread_allocator_t *allocator,
+                      wmem_thread_cache_t *cache)
+{
+    wmem_thread_block_hdr_t *block;
+
+    g_mutex_lock(&allocator->lock);
+    block = allocator->free_blocks;
+    if (block) {
+        allocator->free_blocks = block->next;
+    }
+    g_mutex_unlock(&allocator->lock);
+
+    if (block == NULL) {
+        block = (wmem_thread_block_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    }
+
+    block->pos  = WMEM_BLOCK_HEADER_SIZE;
+    block->next = cache->block_list;
+
+    cache->block_list = block;
+}
+
+/* API */
+
+static void *
+wmem_thread_alloc(void *private_data, const size_t size)
+{
+    wmem_thread_allocator_t *allocator = (wmem_thread_allocator_t*) private_data;
+    wmem_thread_cache_t     *cache;
+    wmem_thread_chunk_t     *chunk;
+    gint32 real_size;
+
+    cache = wmem_thread_get_cache(allocator);
+
+    if (size > WMEM_BLOCK_MAX_ALLOC_SIZE) {
+        wmem_thread_jumbo_t *block;
+
+        /* allocate/initialize a new block of the necessary size */
+        block = (wmem_thread_jumbo_t *)wmem_alloc(NULL,
+                size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+
+        block->next = cache->jumbo_list;
+        block->len  = size;
+        cache->jumbo_list = block;
+
+        chunk = ((wmem_thread_chunk_t*)((guint8*)(block) + WMEM_JUMBO_HEADER_SIZE));
+        chunk->len = JUMBO_MAGIC;
+
+        return WMEM_CHUNK_TO_DATA(chunk);
+    }
+
+    real_size = (gint32)(WMEM_ALIGN_SIZE(size) + WMEM_CHUNK_HEADER_SIZE);
+
+    /* Allocate a new block if necessary. */
+    if (!cache->block_list ||
+            (WMEM_BLOCK_SIZE - cache->block_list->pos) < real_size) {
+        wmem_thread_new_block(allocator, cache);
+    }
+
+    chunk = (wmem_thread_chunk_t *) ((guint8 *) cache->block_list + cache->block_list->pos);
+    /* safe to cast, size smaller than WMEM_BLOCK_MAX_ALLOC_SIZE */
+    chunk->len = (guint32) size;
+
+    cache->block_list->pos += real_size;
+
+    /* and return the user's pointer */
+    return WMEM_CHUNK_TO_DATA(chunk);
+}
+
+static void
+wmem_thread_free(void *private_data _U_, void *ptr _U_)
+{
+    /* free is NOP, which makes it safe from any thread */
+}
+
+static void *
+wmem_thread_realloc(void *private_data, void *ptr, const size_t size)
+{
+    wmem_thread_chunk_t *chunk;
+    size_t               len;
+
+    chunk = WMEM_DATA_TO_CHUNK(ptr);
+
+    if (chunk->len == JUMBO_MAGIC) {
+        /* the jumbo block may be in another thread's list, so it can't be
+         * reallocated in place; copy it like any other chunk */
+        len = ((wmem_thread_jumbo_t*)((guint8*)(chunk) - WMEM_JUMBO_HEADER_SIZE))->len;
+    }
+    else {
+        len = chunk->len;
+    }
+
+    if (len < size) {
+        /* grow */
+        void *newptr;
+
+        /* need to alloc and copy; free is no-op, so don't call it */
+        newptr = wmem_thread_alloc(private_data, size);
+        memcpy(newptr, ptr, len);
+
+        return newptr;
+    }
+
+    /* shrink or same space - great we can do nothing */
+    return ptr;
+}
+
+static void
+wmem_thread_free_all(void *private_data)
+{
+    wmem_thread_allocator_t *allocator = (wmem_thread_allocator_t*) private_data;
+    wmem_thread_cache_t     *cache;
+    wmem_thread_block_hdr_t *cur, *nxt;
+    wmem_thread_jumbo_t     *cur_jum, *nxt_jum;
+
+    g_mutex_lock(&allocator->lock);
+
+    /* move every thread's blocks to the pool, where any thread can pick them
+     * up again, and free the jumbo blocks */
+    for (cache = allocator->caches; cache; cache = cache->next) {
+        cur = cache->block_list;
+        while (cur) {
+            nxt = cur->next;
+            cur->next = allocator->free_blocks;
+            allocator->free_blocks = cur;
+            cur = nxt;
+        }
+        cache->block_list = NULL;
+
+        cur_jum = cache->jumbo_list;
+        while (cur_jum) {
+            nxt_jum = cur_jum->next;
+            wmem_free(NULL, cur_jum);
+            cur_jum = nxt_jum;
+        }
+        cache->jumbo_list = NULL;
+    }
+
+    g_mutex_unlock(&allocator->lock);
+}
+
+static void
+wmem_thread_gc(void *private_data)
+{
+    wmem_thread_allocator_t *allocator = (wmem_thread_allocator_t*) private_data;
+    wmem_thread_block_hdr_t *cur, *nxt;
+
+    /* return the pooled blocks to the OS */
+    g_mutex_lock(&allocator->lock);
+    cur = allocator->free_blocks;
+    allocator->free_blocks = NULL;
+    g_mutex_unlock(&allocator->lock);
+
+    while (cur) {
+        nxt = cur->next;
+        wmem_free(NULL, cur);
+        cur = nxt;
+    }
+}
+
+static void
+wmem_thread_allocator_cleanup(void *private_data)
+{
+    wmem_thread_allocator_t *allocator = (wmem_thread_allocator_t*) private_data;
+    wmem_thread_cache_t     *cache, *nxt;
+
+    /* wmem guarantees that free_all() is called directly before this, so
+     * every block is in the pool and gc returns them all to the OS */
+    wmem_thread_gc(private_data);
+
+    /* the threads' references to these caches are never matched again */
+    cache = allocator->caches;
+    while (cache) {
+        nxt = cache->next;
+        wmem_free(NULL, cache);
+        cache = nxt;
+    }
+
+    g_mutex_clear(&allocator->lock);
+
+    /* then just free the allocator structs */
+    wmem_free(NULL, private_data);
+}
+
+void
+wmem_thread_allocator_init(wmem_allocator_t *allocator)
+{
+    wmem_thread_allocator_t *thread_allocator;
+
+    thread_allocator = wmem_new(NULL, wmem_thread_allocator_t);
+
+    allocator->walloc   = &wmem_thread_alloc;
+    allocator->wrealloc = &wmem_thread_realloc;
+    allocator->wfree    = &wmem_thread_free;
+
+    allocator->free_all = &wmem_thread_free_all;
+    allocator->gc       = &wmem_thread_gc;
+    allocator->cleanup  = &wmem_thread_allocator_cleanup;
+
+    allocator->private_data = (void*) thread_allocator;
+
+    thread_allocator->id          = (guint)g_atomic_int_add(&next_allocator_id, 1);
+    thread_allocator->caches      = NULL;
+    thread_allocator->free_blocks = NULL;
+    g_mutex_init(&thread_allocator->lock);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -22,12 +22,129 @@
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_block_fast.h"
 #include "wmem_allocator_strict.h"
+#include "wmem_allocator_thread.h"
 
 /* Set according to the WIRESHARK_DEBUG_WMEM_OVERRIDE environment variable in
  * wmem_init. Should not be set again. */
 static gboolean do_override = FALSE;
 static wmem_allocator_type_t override_type;
 
+/* Allocation statistics, see wmem_stats_enable() */
+struct _wmem_allocator_stats_t {
+    wmem_stats_t  totals;
+    GHashTable   *tags; /* tag -> wmem_stats_t* */
+};
+
+static guint       stats_sample_interval = 0;
+static guint       stats_sample_count;
+static const char *stats_tag;
+
+static void
+wmem_stats_add(wmem_stats_t *stats, guint64 size)
+{
+    stats->allocs++;
+    stats->bytes += size;
+    stats->total_bytes += size;
+    if (stats->bytes > stats->peak_bytes) {
+        stats->peak_bytes = stats->bytes;
+    }
+}
+
+static void
+wmem_stats_record(wmem_allocator_t *allocator, const size_t size)
+{
+    struct _wmem_allocator_stats_t *stats;
+    wmem_stats_t *tag_stats;
+
+    /* the statistics aren't thread-safe */
+    if (allocator->type == WMEM_ALLOCATOR_THREAD) {
+        return;
+    }
+
+    if (++stats_sample_count < stats_sample_interval) {
+        return;
+    }
+    stats_sample_count = 0;
+
+    stats = allocator->stats;
+    if (stats == NULL) {
+        stats = g_new0(struct _wmem_allocator_stats_t, 1);
+        stats->tags = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+        allocator->stats = stats;
+    }
+
+    tag_stats = (wmem_stats_t *)g_hash_table_lookup(stats->tags, stats_tag);
+    if (tag_stats == NULL) {
+        tag_stats = g_new0(wmem_stats_t, 1);
+        tag_stats->tag = stats_tag;
+        g_hash_table_insert(stats->tags, (gpointer)stats_tag, tag_stats);
+    }
+
+    /* a sampled allocation stands for the ones that weren't */
+    wmem_stats_add(&stats->totals, (guint64)size * stats_sample_interval);
+    wmem_stats_add(tag_stats, (guint64)size * stats_sample_interval);
+    tag_stats->allocs += stats_sample_interval - 1;
+    stats->totals.allocs += stats_sample_interval - 1;
+}
+
+static void
+wmem_stats_reset_tag(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+    ((wmem_stats_t *)value)->bytes = 0;
+}
+
+static void
+wmem_stats_free_all(wmem_allocator_t *allocator)
+{
+    allocator->stats->totals.bytes = 0;
+    g_hash_table_foreach(allocator->stats->tags, wmem_stats_reset_tag, NULL);
+}
+
+void
+wmem_stats_enable(guint sample_interval)
+{
+    stats_sample_interval = sample_interval;
+    stats_sample_count = 0;
+}
+
+gboolean
+wmem_stats_enabled(void)
+{
+    return stats_sample_interval != 0;
+}
+
+const char *
+wmem_stats_set_tag(const char *tag)
+{
+    const char *prev = stats_tag;
+
+    stats_tag = tag;
+    return prev;
+}
+
+const wmem_stats_t *
+wmem_stats_get(wmem_allocator_t *allocator)
+{
+    return allocator->stats ? &allocator->stats->totals : NULL;
+}
+
+void
+wmem_stats_foreach_tag(wmem_allocator_t *allocator,
+        void (*func)(const wmem_stats_t *stats, void *user_data), void *user_data)
+{
+    GHashTableIter iter;
+    gpointer value;
+
+    if (allocator->stats == NULL) {
+        return;
+    }
+
+    g_hash_table_iter_init(&iter, allocator->stats->tags);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        func((const wmem_stats_t *)value, user_data);
+    }
+}
+
 void *
 wmem_alloc(wmem_allocator_t *allocator, const size_t size)
 {
@@ -41,6 +158,10 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
+    if (G_UNLIKELY(stats_sample_interval)) {
+        wmem_stats_record(allocator, size);
+    }
+
     return allocator->walloc(allocator->private_data, size);
 }
 
@@ -93,6 +214,10 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
 
     g_assert(allocator->in_scope);
 
+    if (G_UNLIKELY(stats_sample_interval)) {
+        wmem_stats_record(allocator, size);
+    }
+
     return allocator->wrealloc(allocator->private_data, ptr, size);
 }
 
@@ -102,6 +227,10 @@ wmem_free_all_real(wmem_allocator_t *allocator, gboolean final)
     wmem_call_callbacks(allocator,
             final ? WMEM_CB_DESTROY_EVENT : WMEM_CB_FREE_EVENT);
     allocator->free_all(allocator->private_data);
+
+    if (allocator->stats) {
+        wmem_stats_free_all(allocator);
+    }
 }
 
 void
@@ -122,6 +251,10 @@ wmem_destroy_allocator(wmem_allocator_t *allocator)
 
     wmem_free_all_real(allocator, TRUE);
     allocator->cleanup(allocator->private_data);
+    if (allocator->stats) {
+        g_hash_table_destroy(allocator->stats->tags);
+        g_free(allocator->stats);
+    }
     wmem_free(NULL, allocator);
 }
 
@@ -131,7 +264,7 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     wmem_allocator_t      *allocator;
     wmem_allocator_type_t  real_type;
 
-    if (do_override) {
+    if (do_override && type != WMEM_ALLOCATOR_THREAD) {
         real_type = override_type;
     }
     else {
@@ -141,6 +274,7 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator = wmem_new(NULL, wmem_allocator_t);
     allocator->type      = real_type;
     allocator->callbacks = NULL;
+    allocator->stats     = NULL;
     allocator->in_scope  = TRUE;
 
     switch (real_type) {
@@ -156,6 +290,9 @@ wmem_allocator_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_THREAD:
+            wmem_thread_allocator_init(allocator);
+            break;
         default:
             g_assert_not_reached();
             /* This is necessary to squelch MSVC errors; is there
@@ -171,6 +308,7 @@ void
 wmem_init(void)
 {
     const char *override_env;
+    const char *stats_env;
 
     /* Our valgrind script uses this environment variable to override the
      * usual allocator choice so that everything goes through system-level
@@ -201,6 +339,12 @@ wmem_init(void)
         }
     }
 
+    /* Collect allocation statistics, recording one in this many allocations */
+    stats_env = getenv("WIRESHARK_WMEM_STATS");
+    if (stats_env != NULL) {
+        wmem_stats_enable((guint)strtoul(stats_env, NULL, 10));
+    }
+
     wmem_init_scopes();
     wmem_init_hashing();
 }
@@ -54,11 +54,18 @@ typedef enum _wmem_allocator_type_t {
                 memory usage via things like canaries and scrubbing freed
                 memory. Valgrind is the better choice on platforms that support
                 it. */
-    WMEM_ALLOCATOR_BLOCK_FAST /**< A block allocator like WMEM_ALLOCATOR_BLOCK
+    WMEM_ALLOCATOR_BLOCK_FAST, /**< A block allocator like WMEM_ALLOCATOR_BLOCK
                 but even faster by tracking absolutely minimal metadata and
                 making 'free' a no-op. Useful only for very short-lived scopes
                 where there's no reason to free individual allocations because
                 the next free_all is always just around the corner. */
+    WMEM_ALLOCATOR_THREAD /**< A block allocator like WMEM_ALLOCATOR_BLOCK_FAST
+                that can be used by several threads at once. Each thread
+                allocates from its own blocks without locking, and free is a
+                no-op. Only free_all, gc and destroying it must not overlap
+                with other uses. Never replaced by
+                WIRESHARK_DEBUG_WMEM_OVERRIDE, since the other allocators
+                aren't thread-safe. */
 } wmem_allocator_type_t;
 
 /** Allocate the requested amount of memory in the given pool.
@@ -195,6 +202,66 @@ WS_DLL_PUBLIC
 wmem_allocator_t *
 wmem_allocator_new(const wmem_allocator_type_t type);
 
+/** Allocation statistics of an allocator, either as a whole or for one tag.
+ * Allocators don't know the size of individual blocks when they are freed,
+ * so "bytes" counts what was allocated since the last wmem_free_all(); in
+ * the long-lived scopes, where individual frees are rare, this is close to
+ * the amount of memory in use. Reallocations count as allocations of the
+ * new size.
+ */
+typedef struct _wmem_stats_t {
+    const char *tag;         /**< The tag, NULL for untagged allocations
+                                  or for the totals of the allocator */
+    guint64     allocs;      /**< Number of allocations */
+    guint64     bytes;       /**< Bytes allocated since the last free_all */
+    guint64     peak_bytes;  /**< The highest value "bytes" has had */
+    guint64     total_bytes; /**< Bytes allocated since the allocator was created */
+} wmem_stats_t;
+
+/** Turns the collection of allocation statistics on or off. Only allocations
+ * made while it is on are counted. With a sample interval of N, only one in N
+ * allocations is recorded, and counted N times, which keeps the overhead low
+ * at the cost of precision. The WIRESHARK_WMEM_STATS environment variable can
+ * also be set to the sample interval to turn it on from wmem_init().
+ *
+ * @param sample_interval Record one in this many allocations, 0 to turn the
+ * statistics off.
+ */
+WS_DLL_PUBLIC
+void
+wmem_stats_enable(guint sample_interval);
+
+/** Returns TRUE if allocation statistics are being collected. */
+WS_DLL_PUBLIC
+gboolean
+wmem_stats_enabled(void);
+
+/** Sets the tag that subsequent allocations are accounted to, for example
+ * the name of the protocol being dissected. The tag must remain valid for as
+ * long as the statistics are used; it is compared by address.
+ *
+ * @param tag The new tag, or NULL.
+ * @return The previous tag, so that it can be restored.
+ */
+WS_DLL_PUBLIC
+const char *
+wmem_stats_set_tag(const char *tag);
+
+/** Returns the totals of the statistics of an allocator, or NULL if none
+ * were collected.
+ */
+WS_DLL_PUBLIC
+const wmem_stats_t *
+wmem_stats_get(wmem_allocator_t *allocator);
+
+/** Calls func for the statistics of each tag that allocated memory with an
+ * allocator, in no particular order.
+ */
+WS_DLL_PUBLIC
+void
+wmem_stats_foreach_tag(wmem_allocator_t *allocator,
+        void (*func)(const wmem_stats_t *stats, void *user_data), void *user_data);
+
 /** Initialize the wmem subsystem. This must be called before any other wmem
  * function, usually at the very beginning of your program.
  */
@@ -35,10 +35,15 @@ wmem_init_hashing(void)
     postseed = g_random_int();
 }
 
+/* The map uses open addressing with Robin Hood hashing: the items are stored
+ * inline in the table, and on a collision the item that is furthest from its
+ * preferred slot gets to stay. This keeps probe sequences short and lets
+ * lookups of absent keys stop early. Removal shifts the following items back
+ * instead of leaving tombstones. */
 typedef struct _wmem_map_item_t {
     const void *key;
     void *value;
-    struct _wmem_map_item_t *next;
+    guint32 hash; /* the (mixed) hash of the key, or 0 if the slot is empty */
 } wmem_map_item_t;
 
 struct _wmem_map_t {
@@ -50,7 +55,11 @@ struct _wmem_map_t {
      * logarithms is expensive. */
     size_t capacity;
 
-    wmem_map_item_t **table;
+    /* The base-2 logarithm of the size with which the table is created, as
+     * set by wmem_map_reserve(). */
+    size_t min_capacity;
+
+    wmem_map_item_t *table;
 
     GHashFunc  hash_func;
     GEqualFunc eql_func;
@@ -66,22 +75,44 @@ struct _wmem_map_t {
  * the base-2 logarithm, meaning the actual default capacity is 2^5 = 32 */
 #define WMEM_MAP_DEFAULT_CAPACITY 5
 
+/* The hash is 32 bits wide, so is the largest table we can address */
+#define WMEM_MAP_MAX_CAPACITY 31
+
 /* Macro for calculating the real capacity of the map by using a left-shift to
  * do the 2^x operation. */
 #define CAPACITY(MAP) (((size_t)1) << (MAP)->capacity)
 
+#define MASK(MAP) (CAPACITY(MAP) - 1)
+
+/* The number of items a table with the given (base-2 logarithm) capacity holds
+ * before it is grown; a load factor of 7/8. */
+#define MAX_COUNT(CAP) ((((size_t)1) << (CAP)) - ((((size_t)1) << (CAP)) >> 3))
+
+/* The slot an item with the given hash would preferably be stored in; the
+ * high bits of the hash are the well-mixed ones. */
+#define SLOT(MAP, HASH) ((size_t)((HASH) >> (32 - (MAP)->capacity)))
+
+/* How far slot I is from the preferred slot of an item with the given hash */
+#define DISTANCE(MAP, HASH, I) (((I) - SLOT(MAP, HASH)) & MASK(MAP))
+
 /* Efficient universal integer hashing:
  * https://en.wikipedia.org/wiki/Universal_hashing#Avoiding_modular_arithmetic
+ * 0 marks empty slots, so it is never returned.
  */
-#define HASH(MAP, KEY) \
-    ((guint32)(((MAP)->hash_func(KEY) * x) >> (32 - (MAP)->capacity)))
+static inline guint32
+wmem_map_hash(wmem_map_t *map, const void *key)
+{
+    guint32 hash = (guint32)map->hash_func(key) * x;
+
+    return hash ? hash : 1;
+}
 
 static void
 wmem_map_init_table(wmem_map_t *map)
 {
     map->count     = 0;
-    map->capacity  = WMEM_MAP_DEFAULT_CAPACITY;
-    map->table     = wmem_alloc0_array(map->data_allocator, wmem_map_item_t*, CAPACITY(map));
+    map->capacity  = map->min_capacity;
+    map->table     = wmem_alloc0_array(map->data_allocator, wmem_map_item_t, CAPACITY(map));
 }
 
 wmem_map_t *
@@ -97,6 +128,7 @@ wmem_map_new(wmem_allocator_t *allocator,
     map->metadata_allocator    = allocator;
     map->data_allocator = allocator;
     map->count = 0;
+    map->min_capacity = WMEM_MAP_DEFAULT_CAPACITY;
     map->table = NULL;
 
     return map;
@@ -143,6 +175,7 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     map->metadata_allocator = metadata_scope;
     map->data_allocator = data_scope;
     map->count = 0;
+    map->min_capacity = WMEM_MAP_DEFAULT_CAPACITY;
     map->table = NULL;
 
     map->metadata_scope_cb_id = wmem_register_callback(metadata_scope, wmem_map_destroy_cb, map);
@@ -151,31 +184,58 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     return map;
 }
 
-static inline void
-wmem_map_grow(wmem_map_t *map)
+/* Stores an item that is known not to be in the table yet */
+static void
+wmem_map_place(wmem_map_t *map, const void *key, void *value, guint32 hash)
+{
+    wmem_map_item_t  cur, tmp;
+    wmem_map_item_t *item;
+    size_t           i, dist, item_dist;
+
+    cur.key   = key;
+    cur.value = value;
+    cur.hash  = hash;
+
+    i = SLOT(map, hash);
+    for (dist = 0; ; dist++) {
+        item = &map->table[i];
+        if (item->hash == 0) {
+            *item = cur;
+            return;
+        }
+
+        /* take the slot from an item that is closer to its preferred slot
+         * than we are to ours, and carry on placing that one instead */
+        item_dist = DISTANCE(map, item->hash, i);
+        if (item_dist < dist) {
+            tmp   = *item;
+            *item = cur;
+            cur   = tmp;
+            dist  = item_dist;
+        }
+
+        i = (i + 1) & MASK(map);
+    }
+}
+
+static void
+wmem_map_grow(wmem_map_t *map, size_t capacity)
 {
-    wmem_map_item_t **old_table, *cur, *nxt;
-    size_t            old_cap, i;
-    guint             slot;
+    wmem_map_item_t *old_table;
+    size_t           old_cap, i;
 
     /* store the old table and capacity */
     old_table = map->table;
     old_cap   = CAPACITY(map);
 
-    /* double the size (capacity is base-2 logarithm, so this just means
-     * increment it) and allocate new table */
-    map->capacity++;
-    map->table = wmem_alloc0_array(map->data_allocator, wmem_map_item_t*, CAPACITY(map));
+    /* allocate the new table */
+    map->capacity = capacity;
+    map->table = wmem_alloc0_array(map->data_allocator, wmem_map_item_t, CAPACITY(map));
 
     /* copy all the elements over from the old table */
     for (i=0; i<old_cap; i++) {
-        cur = old_table[i];
-        while (cur) {
-            nxt              = cur->next;
-            slot             = HASH(map, cur->key);
-            cur->next        = map->table[slot];
-            map->table[slot] = cur;
-            cur              = nxt;
+        if (old_table[i].hash != 0) {
+            wmem_map_place(map, old_table[i].key, old_table[i].value, old_table[i].hash);
         }
     }
 
@@ -183,10 +243,78 @@ wmem_map_grow(wmem_map_t *map)
     wmem_free(map->data_allocator, old_table);
 }
 
+static wmem_map_item_t *
+wmem_map_find(wmem_map_t *map, const void *key, guint32 hash)
+{
+    wmem_map_item_t *item;
+    size_t           i, dist;
+
+    i = SLOT(map, hash);
+    for (dist = 0; ; dist++) {
+        item = &map->table[i];
+
+        /* If we reach an empty slot, or an item that is closer to its
+         * preferred slot than the key would be, the key would have been
+         * stored before this point. The table is never full, so this ends. */
+        if (item->hash == 0 || DISTANCE(map, item->hash, i) < dist) {
+            return NULL;
+        }
+        if (item->hash == hash && map->eql_func(key, item->key)) {
+            return item;
+        }
+
+        i = (i + 1) & MASK(map);
+    }
+}
+
+/* Empties a slot, shifting back the items after it that are not in their
+ * preferred slot */
+static void
+wmem_map_erase(wmem_map_t *map, wmem_map_item_t *item)
+{
+    size_t i, next;
+
+    i = item - map->table;
+    for (;;) {
+        next = (i + 1) & MASK(map);
+        if (map->table[next].hash == 0 ||
+                DISTANCE(map, map->table[next].hash, next) == 0) {
+            break;
+        }
+        map->table[i] = map->table[next];
+        i = next;
+    }
+
+    map->table[i].key   = NULL;
+    map->table[i].value = NULL;
+    map->table[i].hash  = 0;
+
+    map->count--;
+}
+
+void
+wmem_map_reserve(wmem_map_t *map, guint count)
+{
+    size_t capacity = WMEM_MAP_DEFAULT_CAPACITY;
+
+    while (count > MAX_COUNT(capacity) && capacity < WMEM_MAP_MAX_CAPACITY) {
+        capacity++;
+    }
+
+    if (capacity > map->min_capacity) {
+        map->min_capacity = capacity;
+    }
+
+    if (map->table != NULL && map->min_capacity > map->capacity) {
+        wmem_map_grow(map, map->min_capacity);
+    }
+}
+
 void *
 wmem_map_insert(wmem_map_t *map, const void *key, void *value)
 {
-    wmem_map_item_t **item;
+    wmem_map_item_t *item;
+    guint32 hash;
     void *old_val;
 
     /* Make sure we have a table */
@@ -194,34 +322,26 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
         wmem_map_init_table(map);
     }
 
-    /* get a pointer to the slot */
-    item = &(map->table[HASH(map, key)]);
+    hash = wmem_map_hash(map, key);
 
-    /* check existing items in that slot */
-    while (*item) {
-        if (map->eql_func(key, (*item)->key)) {
-            /* replace and return old value for this key */
-            old_val = (*item)->value;
-            (*item)->value = value;
-            return old_val;
-        }
-        item = &((*item)->next);
+    /* check for an existing item */
+    item = wmem_map_find(map, key, hash);
+    if (item) {
+        /* replace and return old value for this key */
+        old_val = item->value;
+        item->value = value;
+        return old_val;
     }
 
-    /* insert new item */
-    (*item) = wmem_new(map->data_allocator, wmem_map_item_t);
-
-    (*item)->key   = key;
-    (*item)->value = value;
-    (*item)->next  = NULL;
+    /* increase size if we would be over-full */
+    if (map->count >= MAX_COUNT(map->capacity) && map->capacity < WMEM_MAP_MAX_CAPACITY) {
+        wmem_map_grow(map, map->capacity + 1);
+    }
 
+    /* insert new item */
+    wmem_map_place(map, key, value, hash);
     map->count++;
 
-    /* increase size if we are over-full */
-    if (map->count >= CAPACITY(map)) {
-        wmem_map_grow(map);
-    }
-
     /* no previous entry, return NULL */
     return NULL;
 }
@@ -229,25 +349,12 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
 gboolean
 wmem_map_contains(wmem_map_t *map, const void *key)
 {
-    wmem_map_item_t *item;
-
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
     }
 
-    /* find correct slot */
-    item = map->table[HASH(map, key)];
-
-    /* scan list of items in this slot for the correct value */
-    while (item) {
-        if (map->eql_func(key, item->key)) {
-            return TRUE;
-        }
-        item = item->next;
-    }
-
-    return FALSE;
+    return wmem_map_find(map, key, wmem_map_hash(map, key)) != NULL;
 }
 
 void *
@@ -260,18 +367,9 @@ wmem_map_lookup(wmem_map_t *map, const void *key)
         return NULL;
     }
 
-    /* find correct slot */
-    item = map->table[HASH(map, key)];
+    item = wmem_map_find(map, key, wmem_map_hash(map, key));
 
-    /* scan list of items in this slot for the correct value */
-    while (item) {
-        if (map->eql_func(key, item->key)) {
-            return item->value;
-        }
-        item = item->next;
-    }
-
-    return NULL;
+    return item ? item->value : NULL;
 }
 
 gboolean
@@ -284,30 +382,24 @@ wmem_map_lookup_extended(wmem_map_t *map, const void *key, const void **orig_key
         return FALSE;
     }
 
-    /* find correct slot */
-    item = map->table[HASH(map, key)];
-
-    /* scan list of items in this slot for the correct value */
-    while (item) {
-        if (map->eql_func(key, item->key)) {
-            if (orig_key) {
-                *orig_key = item->key;
-            }
-            if (value) {
-                *value = item->value;
-            }
-            return TRUE;
-        }
-        item = item->next;
+    item = wmem_map_find(map, key, wmem_map_hash(map, key));
+    if (item == NULL) {
+        return FALSE;
     }
 
-    return FALSE;
+    if (orig_key) {
+        *orig_key = item->key;
+    }
+    if (value) {
+        *value = item->value;
+    }
+    return TRUE;
 }
 
 void *
 wmem_map_remove(wmem_map_t *map, const void *key)
 {
-    wmem_map_item_t **item, *tmp;
+    wmem_map_item_t *item;
     void *value;
 
     /* Make sure we have a table */
@@ -315,61 +407,41 @@ wmem_map_remove(wmem_map_t *map, const void *key)
         return NULL;
     }
 
-    /* get a pointer to the slot */
-    item = &(map->table[HASH(map, key)]);
-
-    /* check the items in that slot */
-    while (*item) {
-        if (map->eql_func(key, (*item)->key)) {
-            /* found it */
-            tmp     = (*item);
-            value   = tmp->value;
-            (*item) = tmp->next;
-            wmem_free(map->data_allocator, tmp);
-            map->count--;
-            return value;
-        }
-        item = &((*item)->next);
+    item = wmem_map_find(map, key, wmem_map_hash(map, key));
+    if (item == NULL) {
+        /* didn't find it */
+        return NULL;
     }
 
-    /* didn't find it */
-    return NULL;
+    value = item->value;
+    wmem_map_erase(map, item);
+    return value;
 }
 
 gboolean
 wmem_map_steal(wmem_map_t *map, const void *key)
 {
-    wmem_map_item_t **item, *tmp;
+    wmem_map_item_t *item;
 
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
     }
 
-    /* get a pointer to the slot */
-    item = &(map->table[HASH(map, key)]);
-
-    /* check the items in that slot */
-    while (*item) {
-        if (map->eql_func(key, (*item)->key)) {
-            /* found it */
-            tmp     = (*item);
-            (*item) = tmp->next;
-            map->count--;
-            return TRUE;
-        }
-        item = &((*item)->next);
+    item = wmem_map_find(map, key, wmem_map_hash(map, key));
+    if (item == NULL) {
+        /* didn't find it */
+        return FALSE;
     }
 
-    /* didn't find it */
-    return FALSE;
+    wmem_map_erase(map, item);
+    return TRUE;
 }
 
 wmem_list_t*
 wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
 {
     size_t capacity, i;
-    wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
     if (map->table != NULL) {
@@ -377,10 +449,8 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
 
         /* copy all the elements into the list over from table */
         for (i=0; i<capacity; i++) {
-            cur = map->table[i];
-            while (cur) {
-                wmem_list_prepend(list, (void*)cur->key);
-                cur = cur->next;
+            if (map->table[i].hash != 0) {
+                wmem_list_prepend(list, (void*)map->table[i].key);
             }
         }
     }
@@ -392,7 +462,7 @@ void
 wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, gpointer user_data)
 {
     wmem_map_item_t *cur;
-    unsigned i;
+    size_t i;
 
     /* Make sure we have a table */
     if (map->table == NULL) {
@@ -400,10 +470,9 @@ wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, gpointer user_data)
     }
 
     for (i = 0; i < CAPACITY(map); i++) {
-        cur = map->table[i];
-        while (cur) {
+        cur = &map->table[i];
+        if (cur->hash != 0) {
             foreach_func((gpointer)cur->key, (gpointer)cur->value, user_data);
-            cur = cur->next;
         }
     }
 }
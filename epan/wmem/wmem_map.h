@@ -76,6 +76,17 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
         GHashFunc hash_func, GEqualFunc eql_func)
 G_GNUC_MALLOC;
 
+/** Makes room in the map for at least the given number of items, so that
+ * inserting them doesn't require growing the table along the way. The
+ * reservation is kept when an auto-reset map is emptied.
+ *
+ * @param map The map to reserve space in.
+ * @param count The number of items the map should be able to hold.
+ */
+WS_DLL_PUBLIC
+void
+wmem_map_reserve(wmem_map_t *map, guint count);
+
 /** Inserts a value into the map.
  *
  * @param map The map to insert into.
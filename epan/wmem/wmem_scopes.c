@@ -9,11 +9,14 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#include <stdlib.h>
+
 #include <glib.h>
 
 #include "wmem_core.h"
 #include "wmem_scopes.h"
 #include "wmem_allocator.h"
+#include "wmem_allocator_block.h"
 
 /* One of the supposed benefits of wmem over the old emem was going to be that
  * the scoping of the various memory pools would be obvious, since they would
@@ -70,6 +73,31 @@ wmem_leave_packet_scope(void)
     packet_scope->in_scope = FALSE;
 }
 
+/* Per-Thread Packet Scope */
+
+static void
+wmem_thread_packet_scope_destroy(gpointer data)
+{
+    wmem_destroy_allocator((wmem_allocator_t *)data);
+}
+
+static GPrivate thread_packet_scope = G_PRIVATE_INIT(wmem_thread_packet_scope_destroy);
+
+wmem_allocator_t *
+wmem_thread_packet_scope(void)
+{
+    wmem_allocator_t *allocator;
+
+    allocator = (wmem_allocator_t *)g_private_get(&thread_packet_scope);
+    if (allocator == NULL) {
+        /* only this thread ever sees it, so it needn't be thread-safe */
+        allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+        g_private_set(&thread_packet_scope, allocator);
+    }
+
+    return allocator;
+}
+
 /* File Scope */
 
 wmem_allocator_t *
@@ -127,6 +155,12 @@ wmem_init_scopes(void)
     file_scope   = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
     epan_scope   = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
 
+    /* The file scope can grow to many gigabytes, and is freed as a whole
+     * when the file is closed, which suits huge pages. */
+    if (getenv("WIRESHARK_WMEM_HUGE_PAGES") != NULL) {
+        wmem_block_allocator_set_huge_pages(file_scope, TRUE);
+    }
+
     /* Scopes are initialized to TRUE by default on creation */
     packet_scope->in_scope = FALSE;
     file_scope->in_scope   = FALSE;
@@ -146,6 +180,9 @@ wmem_cleanup_scopes(void)
     wmem_destroy_allocator(file_scope);
     wmem_destroy_allocator(epan_scope);
 
+    /* other threads' packet scopes go away when they exit */
+    g_private_replace(&thread_packet_scope, NULL);
+
     packet_scope = NULL;
     file_scope   = NULL;
     epan_scope   = NULL;
@@ -38,6 +38,15 @@ WS_DLL_LOCAL
 void
 wmem_leave_packet_scope(void);
 
+/** Returns a packet scope private to the calling thread, created on first
+ * use and destroyed when the thread exits. Unlike wmem_packet_scope() it is
+ * always in scope; the thread frees it with wmem_free_all() when it is done
+ * with a packet. Work done off the main thread must use this instead of
+ * wmem_packet_scope(), which belongs to the main thread. */
+WS_DLL_PUBLIC
+wmem_allocator_t *
+wmem_thread_packet_scope(void);
+
 /* File Scope */
 
 WS_DLL_PUBLIC
@@ -16,11 +16,18 @@
 #include <errno.h>
 #include <glib.h>
 
+#include <wsutil/inet_addr.h>
+
 #include "wmem_core.h"
 #include "wmem_strbuf.h"
 
 #define DEFAULT_MINIMUM_LEN 16
 
+/* Strings up to this long (including the null-terminator) are kept in the
+ * wmem_strbuf_t itself instead of a separate allocation. Most strings built
+ * while dissecting - labels, addresses, short descriptions - fit. */
+#define WMEM_STRBUF_INLINE_LEN 32
+
 /* Holds a wmem-allocated string-buffer.
  *  len is the length of the string (not counting the null-terminator) and
  *      should be the same as strlen(str) unless the string contains embedded
@@ -30,6 +37,8 @@
  *  max_len is the maximum permitted alloc_len (NOT the maximum permitted len,
  *      which must be one shorter than alloc_len to permit null-termination).
  *      When max_len is 0 (the default), no maximum is enforced.
+ *  inline_str holds the string while it is short enough, in which case str
+ *      points to it.
  */
 struct _wmem_strbuf_t {
     wmem_allocator_t *allocator;
@@ -39,8 +48,12 @@ struct _wmem_strbuf_t {
     gsize len;
     gsize alloc_len;
     gsize max_len;
+
+    gchar inline_str[WMEM_STRBUF_INLINE_LEN];
 };
 
+#define WMEM_STRBUF_IS_INLINE(S) ((S)->str == (S)->inline_str)
+
 /* _ROOM accounts for the null-terminator, _RAW_ROOM does not.
  * Some functions need one, some functions need the other. */
 #define WMEM_STRBUF_ROOM(S) ((S)->alloc_len - (S)->len - 1)
@@ -56,12 +69,25 @@ wmem_strbuf_sized_new(wmem_allocator_t *allocator,
 
     strbuf = wmem_new(allocator, wmem_strbuf_t);
 
+    if (alloc_len == 0) {
+        /* as much as fits inline, which costs nothing extra */
+        alloc_len = WMEM_STRBUF_INLINE_LEN;
+        if (max_len && alloc_len > max_len) {
+            alloc_len = max_len;
+        }
+    }
+
     strbuf->allocator = allocator;
     strbuf->len       = 0;
-    strbuf->alloc_len = alloc_len ? alloc_len : DEFAULT_MINIMUM_LEN;
+    strbuf->alloc_len = alloc_len;
     strbuf->max_len   = max_len;
 
-    strbuf->str    = (gchar *)wmem_alloc(strbuf->allocator, strbuf->alloc_len);
+    if (alloc_len <= WMEM_STRBUF_INLINE_LEN) {
+        strbuf->str = strbuf->inline_str;
+    }
+    else {
+        strbuf->str = (gchar *)wmem_alloc(strbuf->allocator, strbuf->alloc_len);
+    }
     strbuf->str[0] = '\0';
 
     return strbuf;
@@ -74,7 +100,7 @@ wmem_strbuf_new(wmem_allocator_t *allocator, const gchar *str)
     gsize          len, alloc_len;
 
     len       = str ? strlen(str) : 0;
-    alloc_len = DEFAULT_MINIMUM_LEN;
+    alloc_len = MAX(DEFAULT_MINIMUM_LEN, WMEM_STRBUF_INLINE_LEN);
 
     /* +1 for the null-terminator */
     while (alloc_len < (len + 1)) {
@@ -123,7 +149,14 @@ wmem_strbuf_grow(wmem_strbuf_t *strbuf, const gsize to_add)
         return;
     }
 
-    strbuf->str = (gchar *)wmem_realloc(strbuf->allocator, strbuf->str, new_alloc_len);
+    if (WMEM_STRBUF_IS_INLINE(strbuf)) {
+        /* moving out of the inline buffer */
+        strbuf->str = (gchar *)wmem_alloc(strbuf->allocator, new_alloc_len);
+        memcpy(strbuf->str, strbuf->inline_str, strbuf->len + 1);
+    }
+    else {
+        strbuf->str = (gchar *)wmem_realloc(strbuf->allocator, strbuf->str, new_alloc_len);
+    }
 
     strbuf->alloc_len = new_alloc_len;
 }
@@ -254,6 +287,112 @@ wmem_strbuf_append_unichar(wmem_strbuf_t *strbuf, const gunichar c)
     }
 }
 
+/* The formatting helpers below build their output in a local buffer and
+ * append it in one go, which takes care of growing and of max_len. */
+
+void
+wmem_strbuf_append_uint(wmem_strbuf_t *strbuf, guint64 value)
+{
+    gchar  buf[20]; /* G_MAXUINT64 has 20 digits */
+    gchar *p = buf + sizeof(buf);
+
+    do {
+        *--p = '0' + (gchar)(value % 10);
+        value /= 10;
+    } while (value);
+
+    wmem_strbuf_append_len(strbuf, p, buf + sizeof(buf) - p);
+}
+
+void
+wmem_strbuf_append_int(wmem_strbuf_t *strbuf, gint64 value)
+{
+    if (value < 0) {
+        wmem_strbuf_append_c(strbuf, '-');
+        /* negate as unsigned, so that G_MININT64 works too */
+        wmem_strbuf_append_uint(strbuf, 0 - (guint64)value);
+    }
+    else {
+        wmem_strbuf_append_uint(strbuf, (guint64)value);
+    }
+}
+
+static const gchar hex_digits[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+void
+wmem_strbuf_append_hex(wmem_strbuf_t *strbuf, guint64 value, guint digits)
+{
+    gchar  buf[16];
+    gchar *p = buf + sizeof(buf);
+
+    if (digits > sizeof(buf)) {
+        digits = sizeof(buf);
+    }
+
+    do {
+        *--p = hex_digits[value & 0xF];
+        value >>= 4;
+    } while (value || (guint)(buf + sizeof(buf) - p) < digits);
+
+    wmem_strbuf_append_len(strbuf, p, buf + sizeof(buf) - p);
+}
+
+void
+wmem_strbuf_append_ipv4(wmem_strbuf_t *strbuf, const guint8 *ad)
+{
+    gchar  buf[WS_INET_ADDRSTRLEN];
+    gchar *p = buf;
+    int    i;
+
+    for (i = 0; i < 4; i++) {
+        guint8 octet = ad[i];
+
+        if (i) {
+            *p++ = '.';
+        }
+        if (octet >= 100) {
+            *p++ = '0' + octet / 100;
+            octet %= 100;
+            *p++ = '0' + octet / 10;
+        }
+        else if (octet >= 10) {
+            *p++ = '0' + octet / 10;
+        }
+        *p++ = '0' + octet % 10;
+    }
+
+    wmem_strbuf_append_len(strbuf, buf, p - buf);
+}
+
+void
+wmem_strbuf_append_ipv6(wmem_strbuf_t *strbuf, const guint8 *ad)
+{
+    gchar buf[WS_INET6_ADDRSTRLEN];
+
+    ws_inet_ntop6(ad, buf, sizeof(buf));
+    wmem_strbuf_append(strbuf, buf);
+}
+
+void
+wmem_strbuf_append_ether(wmem_strbuf_t *strbuf, const guint8 *ad)
+{
+    gchar  buf[6 * 3];
+    gchar *p = buf;
+    int    i;
+
+    for (i = 0; i < 6; i++) {
+        *p++ = hex_digits[ad[i] >> 4];
+        *p++ = hex_digits[ad[i] & 0xF];
+        *p++ = ':';
+    }
+
+    /* without the last colon */
+    wmem_strbuf_append_len(strbuf, buf, sizeof(buf) - 1);
+}
+
 void
 wmem_strbuf_truncate(wmem_strbuf_t *strbuf, const gsize len)
 {
@@ -286,7 +425,13 @@ wmem_strbuf_finalize(wmem_strbuf_t *strbuf)
 {
     char *ret;
 
-    ret = (char *)wmem_realloc(strbuf->allocator, strbuf->str, strbuf->len+1);
+    if (WMEM_STRBUF_IS_INLINE(strbuf)) {
+        ret = (char *)wmem_alloc(strbuf->allocator, strbuf->len+1);
+        memcpy(ret, strbuf->str, strbuf->len+1);
+    }
+    else {
+        ret = (char *)wmem_realloc(strbuf->allocator, strbuf->str, strbuf->len+1);
+    }
 
     wmem_free(strbuf->allocator, strbuf);
 
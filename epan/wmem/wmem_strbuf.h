@@ -76,6 +76,41 @@ WS_DLL_PUBLIC
 void
 wmem_strbuf_append_unichar(wmem_strbuf_t *strbuf, const gunichar c);
 
+/* The following append formatted values without going through printf, for
+ * places that build many short strings. Like the other append functions,
+ * they truncate the output to strbuf->max_len. */
+
+/** Appends an unsigned integer in decimal. */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_append_uint(wmem_strbuf_t *strbuf, guint64 value);
+
+/** Appends a signed integer in decimal. */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_append_int(wmem_strbuf_t *strbuf, gint64 value);
+
+/** Appends an integer in lower-case hexadecimal, without a prefix and
+ * zero-padded to at least digits digits (at most 16), like "%0*x". */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_append_hex(wmem_strbuf_t *strbuf, guint64 value, guint digits);
+
+/** Appends the 4 bytes at ad as a dotted-quad IPv4 address. */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_append_ipv4(wmem_strbuf_t *strbuf, const guint8 *ad);
+
+/** Appends the 16 bytes at ad as an IPv6 address in RFC 5952 form. */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_append_ipv6(wmem_strbuf_t *strbuf, const guint8 *ad);
+
+/** Appends the 6 bytes at ad as a colon-separated MAC address. */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_append_ether(wmem_strbuf_t *strbuf, const guint8 *ad);
+
 WS_DLL_PUBLIC
 void
 wmem_strbuf_truncate(wmem_strbuf_t *strbuf, const gsize len);
@@ -12,6 +12,7 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <glib.h>
 
 #include "wmem.h"
@@ -21,6 +22,7 @@
 #include "wmem_allocator_block_fast.h"
 #include "wmem_allocator_simple.h"
 #include "wmem_allocator_strict.h"
+#include "wmem_allocator_thread.h"
 
 #include <wsutil/time_util.h>
 
@@ -42,6 +44,7 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
     allocator = wmem_new(NULL, wmem_allocator_t);
     allocator->type = type;
     allocator->callbacks = NULL;
+    allocator->stats = NULL;
     allocator->in_scope = TRUE;
 
     switch (type) {
@@ -57,6 +60,9 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
         case WMEM_ALLOCATOR_STRICT:
             wmem_strict_allocator_init(allocator);
             break;
+        case WMEM_ALLOCATOR_THREAD:
+            wmem_thread_allocator_init(allocator);
+            break;
         default:
             g_assert_not_reached();
             /* This is necessary to squelch MSVC errors; is there
@@ -194,6 +200,69 @@ wmem_test_allocator_callbacks(void)
     g_assert_true(cb_called_count == 3);
 }
 
+static void
+wmem_test_count_tags(const wmem_stats_t *stats, void *user_data)
+{
+    guint64 *bytes = (guint64 *)user_data;
+
+    *bytes += stats->bytes;
+}
+
+static void
+wmem_test_allocator_stats(void)
+{
+    wmem_allocator_t   *allocator;
+    const wmem_stats_t *stats;
+    const char         *saved_tag;
+    guint64             tag_bytes = 0;
+    void               *ptr;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    wmem_alloc(allocator, 8);
+    g_assert_null(wmem_stats_get(allocator));
+
+    wmem_stats_enable(1);
+    g_assert_true(wmem_stats_enabled());
+
+    wmem_alloc(allocator, 10);
+    saved_tag = wmem_stats_set_tag("test");
+    ptr = wmem_alloc(allocator, 20);
+    wmem_realloc(allocator, ptr, 30);
+    g_assert_true(wmem_stats_set_tag(saved_tag) == (const char *)"test");
+
+    stats = wmem_stats_get(allocator);
+    g_assert_nonnull(stats);
+    g_assert_cmpuint(stats->allocs, ==, 3);
+    g_assert_cmpuint(stats->bytes, ==, 60);
+    wmem_stats_foreach_tag(allocator, wmem_test_count_tags, &tag_bytes);
+    g_assert_cmpuint(tag_bytes, ==, 60);
+
+    wmem_free_all(allocator);
+    g_assert_cmpuint(stats->bytes, ==, 0);
+    g_assert_cmpuint(stats->peak_bytes, ==, 60);
+    wmem_alloc(allocator, 5);
+    g_assert_cmpuint(stats->bytes, ==, 5);
+    g_assert_cmpuint(stats->peak_bytes, ==, 60);
+    g_assert_cmpuint(stats->total_bytes, ==, 65);
+
+    /* sampled allocations are scaled up to stand for the skipped ones */
+    wmem_stats_enable(4);
+    wmem_alloc(allocator, 100);
+    wmem_alloc(allocator, 100);
+    wmem_alloc(allocator, 100);
+    wmem_alloc(allocator, 100);
+    g_assert_cmpuint(stats->allocs, ==, 8);
+    g_assert_cmpuint(stats->bytes, ==, 405);
+
+    wmem_stats_enable(0);
+    g_assert_false(wmem_stats_enabled());
+    wmem_alloc(allocator, 100);
+    g_assert_cmpuint(stats->allocs, ==, 8);
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_det(wmem_allocator_t *allocator, wmem_verify_func verify,
         guint len)
@@ -345,6 +414,36 @@ wmem_test_allocator_block(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_BLOCK, &wmem_block_verify);
 }
 
+static void
+wmem_test_allocator_block_huge_pages(void)
+{
+    wmem_allocator_t *allocator;
+    char *ptrs[MAX_SIMULTANEOUS_ALLOCS];
+    int i, j;
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_BLOCK);
+    wmem_block_allocator_set_huge_pages(allocator, TRUE);
+
+    /* fill more than one block, free everything and do it again, checking
+     * that the released memory comes back usable */
+    for (j = 0; j < 2; j++) {
+        for (i = 0; i < MAX_SIMULTANEOUS_ALLOCS; i++) {
+            ptrs[i] = (char *)wmem_alloc(allocator, MAX_ALLOC_SIZE);
+            memset(ptrs[i], i & 0xff, MAX_ALLOC_SIZE);
+        }
+        wmem_block_verify(allocator);
+        for (i = 0; i < MAX_SIMULTANEOUS_ALLOCS; i++) {
+            g_assert_true(ptrs[i][MAX_ALLOC_SIZE - 1] == (char)(i & 0xff));
+        }
+        wmem_free_all(allocator);
+        wmem_block_verify(allocator);
+    }
+
+    wmem_gc(allocator);
+    wmem_block_verify(allocator);
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_block_fast(void)
 {
@@ -353,6 +452,67 @@ wmem_test_allocator_block_fast(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_BLOCK, NULL);
 }
 
+#define THREAD_TEST_THREADS 4
+
+static gpointer
+wmem_test_allocator_thread_worker(gpointer data)
+{
+    wmem_allocator_t *allocator = (wmem_allocator_t *)data;
+    wmem_allocator_t *packet_scope;
+    guint32 *ptrs[MAX_SIMULTANEOUS_ALLOCS];
+    guint32 tag = GPOINTER_TO_UINT(g_thread_self());
+    int i;
+
+    packet_scope = wmem_thread_packet_scope();
+    g_assert_true(packet_scope == wmem_thread_packet_scope());
+
+    for (i = 0; i < MAX_SIMULTANEOUS_ALLOCS; i++) {
+        ptrs[i] = wmem_new(allocator, guint32);
+        *ptrs[i] = tag + i;
+        if (i % 64 == 0) {
+            /* grow some past the size of a block */
+            ptrs[i] = (guint32 *)wmem_realloc(allocator, ptrs[i], 2 * 1024 * 1024);
+        }
+        *wmem_new(packet_scope, guint32) = tag;
+    }
+    wmem_free_all(packet_scope);
+
+    for (i = 0; i < MAX_SIMULTANEOUS_ALLOCS; i++) {
+        g_assert_true(*ptrs[i] == tag + i);
+        wmem_free(allocator, ptrs[i]);
+    }
+
+    return NULL;
+}
+
+static void
+wmem_test_allocator_thread(void)
+{
+    wmem_allocator_t *allocator;
+    GThread *threads[THREAD_TEST_THREADS];
+    int i, j;
+
+    wmem_test_allocator(WMEM_ALLOCATOR_THREAD, NULL,
+            MAX_SIMULTANEOUS_ALLOCS*4);
+    wmem_test_allocator_jumbo(WMEM_ALLOCATOR_THREAD, NULL);
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_THREAD);
+
+    /* twice, so that the second round reuses the blocks of the first */
+    for (j = 0; j < 2; j++) {
+        for (i = 0; i < THREAD_TEST_THREADS; i++) {
+            threads[i] = g_thread_new(NULL, wmem_test_allocator_thread_worker, allocator);
+        }
+        for (i = 0; i < THREAD_TEST_THREADS; i++) {
+            g_thread_join(threads[i]);
+        }
+        wmem_free_all(allocator);
+    }
+
+    wmem_gc(allocator);
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_simple(void)
 {
@@ -903,6 +1063,12 @@ check_val_map(gpointer key _U_, gpointer val, gpointer user_data)
     g_assert_true(val == user_data);
 }
 
+static guint
+constant_hash(gconstpointer key _U_)
+{
+    return 0;
+}
+
 static void
 wmem_test_map(void)
 {
@@ -1007,10 +1173,133 @@ wmem_test_map(void)
     }
     g_assert_true(wmem_map_size(map) == CONTAINER_ITERS);
 
+    /* test reserve, and removal of every other key */
+    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+    wmem_map_reserve(map, CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+    }
+    for (i=0; i<CONTAINER_ITERS; i+=2) {
+        ret = wmem_map_remove(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_map_size(map) == CONTAINER_ITERS / 2);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_contains(map, GINT_TO_POINTER(i)) == (i % 2 == 1));
+    }
+    wmem_free_all(allocator);
+
+    /* test colliding keys, which all want the same slot */
+    map = wmem_map_new(allocator, constant_hash, g_direct_equal);
+    g_assert_true(map);
+    for (i=0; i<100; i++) {
+        ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == NULL);
+    }
+    for (i=0; i<100; i+=3) {
+        g_assert_true(wmem_map_steal(map, GINT_TO_POINTER(i)) == TRUE);
+        g_assert_true(wmem_map_steal(map, GINT_TO_POINTER(i)) == FALSE);
+    }
+    for (i=0; i<100; i++) {
+        ret = wmem_map_lookup(map, GINT_TO_POINTER(i));
+        if (i % 3 == 0) {
+            g_assert_true(ret == NULL);
+        } else {
+            g_assert_true(ret == GINT_TO_POINTER(i));
+        }
+    }
+    g_assert_true(wmem_map_size(map) == 66);
+
     wmem_destroy_allocator(extra_allocator);
     wmem_destroy_allocator(allocator);
 }
 
+static void
+sum_map_values(gpointer key _U_, gpointer val, gpointer user_data)
+{
+    *(guint *)user_data += GPOINTER_TO_UINT(val);
+}
+
+/* NOTE: You have to run "wmem_test --verbose" to see results. */
+static void
+wmem_test_mapperf(void)
+{
+#define MAP_PERF_COUNT (1000 * 1000)
+    wmem_allocator_t   *allocator;
+    wmem_map_t         *map;
+    GHashTable         *table;
+    guint               i, sum;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    RESOURCE_USAGE_START;
+    for (i = 1; i <= MAP_PERF_COUNT; i++) {
+        wmem_map_insert(map, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_map_insert: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 1; i <= MAP_PERF_COUNT; i++) {
+        g_assert_true(wmem_map_lookup(map, GUINT_TO_POINTER(i)) != NULL);
+        g_assert_true(wmem_map_lookup(map, GUINT_TO_POINTER(i + MAP_PERF_COUNT)) == NULL);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_map_lookup hit and miss: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    sum = 0;
+    RESOURCE_USAGE_START;
+    wmem_map_foreach(map, sum_map_values, &sum);
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_map_foreach: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+    wmem_free_all(allocator);
+
+    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    RESOURCE_USAGE_START;
+    wmem_map_reserve(map, MAP_PERF_COUNT);
+    for (i = 1; i <= MAP_PERF_COUNT; i++) {
+        wmem_map_insert(map, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_map_insert after wmem_map_reserve: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+    wmem_free_all(allocator);
+
+    table = g_hash_table_new(g_direct_hash, g_direct_equal);
+    RESOURCE_USAGE_START;
+    for (i = 1; i <= MAP_PERF_COUNT; i++) {
+        g_hash_table_insert(table, GUINT_TO_POINTER(i), GUINT_TO_POINTER(i));
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "g_hash_table_insert: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 1; i <= MAP_PERF_COUNT; i++) {
+        g_assert_true(g_hash_table_lookup(table, GUINT_TO_POINTER(i)) != NULL);
+        g_assert_true(g_hash_table_lookup(table, GUINT_TO_POINTER(i + MAP_PERF_COUNT)) == NULL);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "g_hash_table_lookup hit and miss: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    sum = 0;
+    RESOURCE_USAGE_START;
+    g_hash_table_foreach(table, sum_map_values, &sum);
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "g_hash_table_foreach: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+    g_hash_table_destroy(table);
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1167,6 +1456,105 @@ wmem_test_strbuf(void)
     g_assert_true(strlen(wmem_strbuf_get_str(strbuf)) ==
              wmem_strbuf_get_len(strbuf));
 
+    /* the formatting helpers, starting in and growing out of the inline
+     * buffer */
+    strbuf = wmem_strbuf_new(allocator, NULL);
+    wmem_strbuf_append_uint(strbuf, 0);
+    wmem_strbuf_append_c(strbuf, ' ');
+    wmem_strbuf_append_uint(strbuf, G_MAXUINT64);
+    g_assert_cmpstr(wmem_strbuf_get_str(strbuf), ==, "0 18446744073709551615");
+    wmem_strbuf_append_c(strbuf, ' ');
+    wmem_strbuf_append_int(strbuf, G_MININT64);
+    wmem_strbuf_append_c(strbuf, ' ');
+    wmem_strbuf_append_int(strbuf, 42);
+    g_assert_cmpstr(wmem_strbuf_get_str(strbuf), ==,
+            "0 18446744073709551615 -9223372036854775808 42");
+    wmem_strbuf_truncate(strbuf, 0);
+    wmem_strbuf_append_hex(strbuf, 0, 0);
+    wmem_strbuf_append_c(strbuf, ' ');
+    wmem_strbuf_append_hex(strbuf, 0xabc, 4);
+    wmem_strbuf_append_c(strbuf, ' ');
+    wmem_strbuf_append_hex(strbuf, G_GUINT64_CONSTANT(0xfedcba9876543210), 2);
+    g_assert_cmpstr(wmem_strbuf_get_str(strbuf), ==, "0 0abc fedcba9876543210");
+    wmem_strbuf_truncate(strbuf, 0);
+    wmem_strbuf_append_ipv4(strbuf, (const guint8 *)"\x0a\x00\xc8\xff");
+    wmem_strbuf_append_c(strbuf, ' ');
+    wmem_strbuf_append_ipv6(strbuf, (const guint8 *)
+            "\x20\x01\x0d\xb8\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01");
+    wmem_strbuf_append_c(strbuf, ' ');
+    wmem_strbuf_append_ether(strbuf, (const guint8 *)"\x00\x1b\x21\xaa\xbb\xcc");
+    g_assert_cmpstr(wmem_strbuf_get_str(strbuf), ==,
+            "10.0.200.255 2001:db8::1 00:1b:21:aa:bb:cc");
+    str = wmem_strbuf_finalize(strbuf);
+    g_assert_cmpstr(str, ==, "10.0.200.255 2001:db8::1 00:1b:21:aa:bb:cc");
+
+    /* and they respect the maximum length */
+    strbuf = wmem_strbuf_sized_new(allocator, 0, 8);
+    wmem_strbuf_append_ipv4(strbuf, (const guint8 *)"\x0a\x00\xc8\xff");
+    g_assert_cmpstr(wmem_strbuf_get_str(strbuf), ==, "10.0.20");
+    wmem_strbuf_append_uint(strbuf, 1);
+    g_assert_cmpstr(wmem_strbuf_get_str(strbuf), ==, "10.0.20");
+    str = wmem_strbuf_finalize(strbuf);
+    g_assert_cmpstr(str, ==, "10.0.20");
+    wmem_strict_check_canaries(allocator);
+
+    wmem_destroy_allocator(allocator);
+}
+
+/* NOTE: You have to run "wmem_test --verbose" to see results. */
+static void
+wmem_test_strbufperf(void)
+{
+#define STRBUF_LOOP_COUNT (1 * 1000 * 1000)
+    wmem_allocator_t   *allocator;
+    wmem_strbuf_t      *strbuf;
+    const guint8        addr[4] = { 192, 168, 100, 1 };
+    int                 i;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < STRBUF_LOOP_COUNT; i++) {
+        strbuf = wmem_strbuf_new(allocator, NULL);
+        wmem_strbuf_append_printf(strbuf, "Port: %u", i);
+        wmem_free_all(allocator);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_strbuf_append_printf integer: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < STRBUF_LOOP_COUNT; i++) {
+        strbuf = wmem_strbuf_new(allocator, NULL);
+        wmem_strbuf_append(strbuf, "Port: ");
+        wmem_strbuf_append_uint(strbuf, i);
+        wmem_free_all(allocator);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_strbuf_append_uint integer: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < STRBUF_LOOP_COUNT; i++) {
+        strbuf = wmem_strbuf_new(allocator, NULL);
+        wmem_strbuf_append_printf(strbuf, "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+        wmem_free_all(allocator);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_strbuf_append_printf IPv4 address: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < STRBUF_LOOP_COUNT; i++) {
+        strbuf = wmem_strbuf_new(allocator, NULL);
+        wmem_strbuf_append_ipv4(strbuf, addr);
+        wmem_free_all(allocator);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_strbuf_append_ipv4 IPv4 address: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
     wmem_destroy_allocator(allocator);
 }
 
@@ -1330,6 +1718,88 @@ wmem_test_tree(void)
     wmem_destroy_allocator(allocator);
 }
 
+static gboolean
+wmem_test_tree_collect_keys(const void *key, void *value _U_, void *userData)
+{
+    GArray *keys = (GArray *)userData;
+    guint32 key32 = GPOINTER_TO_UINT(key);
+
+    g_array_append_val(keys, key32);
+    return FALSE;
+}
+
+static void
+wmem_test_btree(void)
+{
+    wmem_allocator_t   *allocator;
+    wmem_tree_t        *tree, *btree;
+    GArray             *keys, *bkeys;
+    guint32             i, key, last;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    btree = wmem_tree_new_btree32(allocator);
+    g_assert_true(btree);
+    g_assert_true(wmem_tree_is_empty(btree));
+    g_assert_true(wmem_tree_lookup32_le(btree, 1) == NULL);
+    g_assert_true(wmem_tree_lookup32_ge(btree, 1) == NULL);
+
+    /* ascending keys, as for frame numbers */
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(btree, 2*i+1) == NULL);
+        if (i > 0) {
+            g_assert_true(wmem_tree_lookup32_le(btree, 2*i+1) == GINT_TO_POINTER(i-1));
+            g_assert_true(wmem_tree_lookup32_ge(btree, 2*i) == NULL);
+        }
+        wmem_tree_insert32(btree, 2*i+1, GINT_TO_POINTER(i));
+        g_assert_true(wmem_tree_lookup32(btree, 2*i+1) == GINT_TO_POINTER(i));
+        g_assert_true(!wmem_tree_is_empty(btree));
+    }
+    g_assert_true(wmem_tree_count(btree) == CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32_le(btree, 2*i+2) == GINT_TO_POINTER(i));
+        g_assert_true(wmem_tree_lookup32_ge(btree, 2*i) == GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_tree_lookup32_le(btree, 0) == NULL);
+    g_assert_true(wmem_tree_remove32(btree, 3) == GINT_TO_POINTER(1));
+    g_assert_true(wmem_tree_lookup32(btree, 3) == NULL);
+    wmem_free_all(allocator);
+
+    /* random keys, compared against the red-black tree */
+    tree  = wmem_tree_new(allocator);
+    btree = wmem_tree_new_btree32(allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        key = g_test_rand_int_range(0, 4*CONTAINER_ITERS);
+        wmem_tree_insert32(tree, key, GINT_TO_POINTER(i));
+        wmem_tree_insert32(btree, key, GINT_TO_POINTER(i));
+    }
+    wmem_tree_insert32(tree, G_MAXUINT32, GINT_TO_POINTER(i));
+    wmem_tree_insert32(btree, G_MAXUINT32, GINT_TO_POINTER(i));
+    g_assert_true(wmem_tree_count(tree) == wmem_tree_count(btree));
+
+    keys  = g_array_new(FALSE, FALSE, sizeof(guint32));
+    bkeys = g_array_new(FALSE, FALSE, sizeof(guint32));
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        key = g_test_rand_int_range(0, 4*CONTAINER_ITERS+2);
+        g_assert_true(wmem_tree_lookup32(tree, key) == wmem_tree_lookup32(btree, key));
+        g_assert_true(wmem_tree_lookup32_le(tree, key) == wmem_tree_lookup32_le(btree, key));
+        g_assert_true(wmem_tree_lookup32_ge(tree, key) == wmem_tree_lookup32_ge(btree, key));
+
+        last = key + g_test_rand_int_range(0, 64);
+        g_array_set_size(keys, 0);
+        g_array_set_size(bkeys, 0);
+        wmem_tree_foreach_range32(tree, key, last, wmem_test_tree_collect_keys, keys);
+        wmem_tree_foreach_range32(btree, key, last, wmem_test_tree_collect_keys, bkeys);
+        g_assert_cmpuint(keys->len, ==, bkeys->len);
+        g_assert_true(memcmp(keys->data, bkeys->data, keys->len * sizeof(guint32)) == 0);
+    }
+    g_assert_true(wmem_tree_lookup32_ge(btree, G_MAXUINT32) == GINT_TO_POINTER(CONTAINER_ITERS));
+    g_array_free(keys, TRUE);
+    g_array_free(bkeys, TRUE);
+
+    wmem_destroy_allocator(allocator);
+}
+
 
 /* to be used as userdata in the callback wmem_test_itree_check_overlap_cb*/
 typedef struct wmem_test_itree_user_data {
@@ -1443,16 +1913,21 @@ main(int argc, char **argv)
     g_test_init(&argc, &argv, NULL);
 
     g_test_add_func("/wmem/allocator/block",     wmem_test_allocator_block);
+    g_test_add_func("/wmem/allocator/blk_huge",  wmem_test_allocator_block_huge_pages);
     g_test_add_func("/wmem/allocator/blk_fast",  wmem_test_allocator_block_fast);
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
+    g_test_add_func("/wmem/allocator/thread",    wmem_test_allocator_thread);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
+    g_test_add_func("/wmem/allocator/stats",     wmem_test_allocator_stats);
 
     g_test_add_func("/wmem/utils/misc",    wmem_test_miscutls);
     g_test_add_func("/wmem/utils/strings", wmem_test_strutls);
 
     if (!g_test_perf ()) {
         g_test_add_func("/wmem/utils/stringperf", wmem_test_stringperf);
+        g_test_add_func("/wmem/utils/strbufperf", wmem_test_strbufperf);
+        g_test_add_func("/wmem/datastruct/mapperf", wmem_test_mapperf);
     }
 
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
@@ -1462,6 +1937,7 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
     g_test_add_func("/wmem/datastruct/tree",   wmem_test_tree);
+    g_test_add_func("/wmem/datastruct/btree",  wmem_test_btree);
     g_test_add_func("/wmem/datastruct/itree",  wmem_test_itree);
 
     ret = g_test_run();
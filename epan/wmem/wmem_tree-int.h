@@ -44,10 +44,34 @@ typedef struct _wmem_tree_node_t wmem_tree_node_t;
 
 typedef struct _wmem_itree_node_t wmem_itree_node_t;
 
+/* Maximum number of keys in a node of a B+-tree */
+#define WMEM_BTREE_ORDER 32
+
+/* A node of a B+-tree with guint32 keys. A leaf holds up to WMEM_BTREE_ORDER
+ * keys and their data, and points to the next leaf in key order. An inner node
+ * holds up to WMEM_BTREE_ORDER separator keys and one more child; keys[i] is
+ * the smallest key under children[i+1]. There is room for one extra key (and
+ * child) while a full node is being split. */
+struct _wmem_btree_node_t {
+    guint    count;
+    gboolean is_leaf;
+    struct _wmem_btree_node_t *next;
+
+    guint32 keys[WMEM_BTREE_ORDER + 1];
+    union {
+        void                      *data[WMEM_BTREE_ORDER + 1];
+        struct _wmem_btree_node_t *children[WMEM_BTREE_ORDER + 2];
+    } u;
+};
+
+typedef struct _wmem_btree_node_t wmem_btree_node_t;
+
 struct _wmem_tree_t {
     wmem_allocator_t *metadata_allocator;
     wmem_allocator_t *data_allocator;
     wmem_tree_node_t *root;
+    wmem_btree_node_t *btree_root;
+    gboolean          is_btree;
     guint             metadata_scope_cb_id;
     guint             data_scope_cb_id;
 
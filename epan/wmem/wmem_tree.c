@@ -213,6 +213,7 @@ wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     wmem_tree_t *tree = (wmem_tree_t *)user_data;
 
     tree->root = NULL;
+    tree->btree_root = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
@@ -250,6 +251,288 @@ wmem_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_btree32(wmem_allocator_t *allocator)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_tree_new(allocator);
+    tree->is_btree = TRUE;
+
+    return tree;
+}
+
+/* B+-TREE FUNCTIONS
+ *
+ * Trees created with wmem_tree_new_btree32() keep their guint32 keys in a
+ * B+-tree instead of the red-black tree, so many keys share one allocation
+ * and a lookup touches a few nodes rather than one per level of a binary
+ * tree. The leaves are linked in key order for range traversals. Keys are
+ * never removed from the B+-tree; like in the red-black tree,
+ * wmem_tree_remove32() only sets their value to NULL.
+ */
+
+static wmem_btree_node_t *
+btree_new_node(wmem_allocator_t *allocator, gboolean is_leaf)
+{
+    wmem_btree_node_t *node;
+
+    node = wmem_new(allocator, wmem_btree_node_t);
+
+    node->count   = 0;
+    node->is_leaf = is_leaf;
+    node->next    = NULL;
+
+    return node;
+}
+
+/* Returns the index of the first key in the node that is >= key */
+static guint
+btree_lower_bound(const wmem_btree_node_t *node, guint32 key)
+{
+    guint lo = 0, hi = node->count, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (node->keys[mid] < key) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/* Returns the index of the first key in the node that is > key, which for an
+ * inner node is the index of the child the key belongs under */
+static guint
+btree_upper_bound(const wmem_btree_node_t *node, guint32 key)
+{
+    guint lo = 0, hi = node->count, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (node->keys[mid] <= key) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static wmem_btree_node_t *
+btree_find_leaf(wmem_btree_node_t *node, guint32 key)
+{
+    while (node && !node->is_leaf) {
+        node = node->u.children[btree_upper_bound(node, key)];
+    }
+
+    return node;
+}
+
+/* Inserts into the subtree under node. If the node has to be split, returns
+ * the new right half and sets split_key to the smallest key under it. */
+static wmem_btree_node_t *
+btree_insert_node(wmem_allocator_t *allocator, wmem_btree_node_t *node,
+        guint32 key, void *data, guint32 *split_key)
+{
+    wmem_btree_node_t *right;
+    guint              i, half;
+
+    if (node->is_leaf) {
+        i = btree_lower_bound(node, key);
+        if (i < node->count && node->keys[i] == key) {
+            node->u.data[i] = data;
+            return NULL;
+        }
+        memmove(&node->keys[i + 1], &node->keys[i],
+                (node->count - i) * sizeof node->keys[0]);
+        memmove(&node->u.data[i + 1], &node->u.data[i],
+                (node->count - i) * sizeof node->u.data[0]);
+        node->keys[i]   = key;
+        node->u.data[i] = data;
+    }
+    else {
+        i = btree_upper_bound(node, key);
+        right = btree_insert_node(allocator, node->u.children[i], key, data, split_key);
+        if (right == NULL) {
+            return NULL;
+        }
+        memmove(&node->keys[i + 1], &node->keys[i],
+                (node->count - i) * sizeof node->keys[0]);
+        memmove(&node->u.children[i + 2], &node->u.children[i + 1],
+                (node->count - i) * sizeof node->u.children[0]);
+        node->keys[i]           = *split_key;
+        node->u.children[i + 1] = right;
+    }
+    node->count++;
+
+    if (node->count <= WMEM_BTREE_ORDER) {
+        return NULL;
+    }
+
+    /* Split the over-full node. Keys are often inserted in ascending order
+     * (frame numbers, sequence numbers), so if the new key went at the end
+     * leave the left half full instead of half-empty. */
+    if (i == node->count - 1) {
+        half = node->is_leaf ? WMEM_BTREE_ORDER : WMEM_BTREE_ORDER - 1;
+    }
+    else {
+        half = node->count / 2;
+    }
+
+    right = btree_new_node(allocator, node->is_leaf);
+    if (node->is_leaf) {
+        right->count = node->count - half;
+        memcpy(right->keys, &node->keys[half], right->count * sizeof node->keys[0]);
+        memcpy(right->u.data, &node->u.data[half], right->count * sizeof node->u.data[0]);
+        right->next = node->next;
+        node->next  = right;
+        *split_key  = right->keys[0];
+    }
+    else {
+        /* the key between the halves moves up to the parent */
+        right->count = node->count - half - 1;
+        memcpy(right->keys, &node->keys[half + 1], right->count * sizeof node->keys[0]);
+        memcpy(right->u.children, &node->u.children[half + 1],
+                (right->count + 1) * sizeof node->u.children[0]);
+        *split_key = node->keys[half];
+    }
+    node->count = half;
+
+    return right;
+}
+
+static void
+btree_insert(wmem_tree_t *tree, guint32 key, void *data)
+{
+    wmem_btree_node_t *right, *root;
+    guint32            split_key;
+
+    if (tree->btree_root == NULL) {
+        tree->btree_root = btree_new_node(tree->data_allocator, TRUE);
+    }
+
+    right = btree_insert_node(tree->data_allocator, tree->btree_root, key, data, &split_key);
+    if (right) {
+        /* the root was split, grow the tree by one level */
+        root = btree_new_node(tree->data_allocator, FALSE);
+        root->count           = 1;
+        root->keys[0]         = split_key;
+        root->u.children[0]   = tree->btree_root;
+        root->u.children[1]   = right;
+        tree->btree_root      = root;
+    }
+}
+
+static void *
+btree_lookup(wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_node_t *leaf;
+    guint              i;
+
+    leaf = btree_find_leaf(tree->btree_root, key);
+    if (leaf == NULL) {
+        return NULL;
+    }
+
+    i = btree_lower_bound(leaf, key);
+    if (i < leaf->count && leaf->keys[i] == key) {
+        return leaf->u.data[i];
+    }
+
+    return NULL;
+}
+
+static void *
+btree_lookup_le(wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_node_t *leaf;
+    guint              i;
+
+    leaf = btree_find_leaf(tree->btree_root, key);
+    if (leaf == NULL) {
+        return NULL;
+    }
+
+    /* The first key of a leaf is the separator we followed to get to it,
+     * which is <= key; only the leftmost leaf can have no key <= key. */
+    i = btree_upper_bound(leaf, key);
+
+    return i > 0 ? leaf->u.data[i - 1] : NULL;
+}
+
+static void *
+btree_lookup_ge(wmem_tree_t *tree, guint32 key)
+{
+    wmem_btree_node_t *leaf;
+    guint              i;
+
+    leaf = btree_find_leaf(tree->btree_root, key);
+    if (leaf == NULL) {
+        return NULL;
+    }
+
+    i = btree_lower_bound(leaf, key);
+    if (i == leaf->count) {
+        /* all keys in this leaf are smaller, the next one starts above key */
+        leaf = leaf->next;
+        i = 0;
+    }
+
+    return leaf ? leaf->u.data[i] : NULL;
+}
+
+static gboolean
+btree_foreach_range(wmem_tree_t *tree, guint32 first, guint32 last,
+        wmem_foreach_func callback, void *user_data)
+{
+    wmem_btree_node_t *leaf;
+    guint              i;
+
+    leaf = btree_find_leaf(tree->btree_root, first);
+    if (leaf == NULL) {
+        return FALSE;
+    }
+
+    for (i = btree_lower_bound(leaf, first); leaf; leaf = leaf->next, i = 0) {
+        for (; i < leaf->count; i++) {
+            if (leaf->keys[i] > last) {
+                return FALSE;
+            }
+            if (callback(GUINT_TO_POINTER(leaf->keys[i]), leaf->u.data[i], user_data)) {
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+static void
+btree_free_node(wmem_allocator_t *allocator, wmem_btree_node_t *node, gboolean free_values)
+{
+    guint i;
+
+    if (!node->is_leaf) {
+        for (i = 0; i <= node->count; i++) {
+            btree_free_node(allocator, node->u.children[i], free_values);
+        }
+    }
+    else if (free_values) {
+        for (i = 0; i < node->count; i++) {
+            wmem_free(allocator, node->u.data[i]);
+        }
+    }
+
+    wmem_free(allocator, node);
+}
+
 static void
 free_tree_node(wmem_allocator_t *allocator, wmem_tree_node_t* node, gboolean free_keys, gboolean free_values)
 {
@@ -284,6 +567,9 @@ void
 wmem_tree_destroy(wmem_tree_t *tree, gboolean free_keys, gboolean free_values)
 {
     free_tree_node(tree->data_allocator, tree->root, free_keys, free_values);
+    if (tree->btree_root) {
+        btree_free_node(tree->data_allocator, tree->btree_root, free_values);
+    }
     if (tree->metadata_allocator) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
     }
@@ -296,7 +582,7 @@ wmem_tree_destroy(wmem_tree_t *tree, gboolean free_keys, gboolean free_values)
 gboolean
 wmem_tree_is_empty(wmem_tree_t *tree)
 {
-    return tree->root == NULL;
+    return tree->root == NULL && tree->btree_root == NULL;
 }
 
 static gboolean
@@ -355,6 +641,9 @@ lookup_or_insert32_node(wmem_tree_t *tree, guint32 key,
     wmem_tree_node_t *node     = tree->root;
     wmem_tree_node_t *new_node = NULL;
 
+    /* B+-trees only hold guint32 keys, see wmem_tree_insert32() */
+    g_assert(!tree->is_btree);
+
     /* is this the first node ?*/
     if (!node) {
         new_node = create_node(tree->data_allocator, NULL, GUINT_TO_POINTER(key),
@@ -448,6 +737,9 @@ wmem_tree_insert(wmem_tree_t *tree, const void *key, void *data, compare_func cm
     wmem_tree_node_t *node = tree->root;
     wmem_tree_node_t *new_node = NULL;
 
+    /* B+-trees only hold guint32 keys */
+    g_assert(!tree->is_btree);
+
     /* is this the first node ?*/
     if (!node) {
         tree->root = create_node(tree->data_allocator, node, key,
@@ -497,6 +789,11 @@ wmem_tree_insert(wmem_tree_t *tree, const void *key, void *data, compare_func cm
 void
 wmem_tree_insert32(wmem_tree_t *tree, guint32 key, void *data)
 {
+    if (tree->is_btree) {
+        btree_insert(tree, key, data);
+        return;
+    }
+
     lookup_or_insert32(tree, key, NULL, data, FALSE, TRUE);
 }
 
@@ -505,6 +802,10 @@ wmem_tree_lookup32(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->is_btree) {
+        return btree_lookup(tree, key);
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return node->data;
@@ -525,6 +826,10 @@ wmem_tree_lookup32_le(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->is_btree) {
+        return btree_lookup_le(tree, key);
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return node->data;
@@ -582,6 +887,33 @@ wmem_tree_lookup32_le(wmem_tree_t *tree, guint32 key)
     }
 }
 
+void *
+wmem_tree_lookup32_ge(wmem_tree_t *tree, guint32 key)
+{
+    wmem_tree_node_t *node = tree->root;
+    wmem_tree_node_t *candidate = NULL;
+
+    if (tree->is_btree) {
+        return btree_lookup_ge(tree, key);
+    }
+
+    while (node) {
+        if (key == GPOINTER_TO_UINT(node->key)) {
+            return node->data;
+        }
+        else if (key < GPOINTER_TO_UINT(node->key)) {
+            /* the smallest key above the search key seen so far */
+            candidate = node;
+            node = node->left;
+        }
+        else {
+            node = node->right;
+        }
+    }
+
+    return candidate ? candidate->data : NULL;
+}
+
 void *
 wmem_tree_remove32(wmem_tree_t *tree, guint32 key)
 {
@@ -754,12 +1086,59 @@ gboolean
 wmem_tree_foreach(wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data)
 {
+    if (tree->is_btree)
+        return btree_foreach_range(tree, 0, G_MAXUINT32, callback, user_data);
+
     if(!tree->root)
         return FALSE;
 
     return wmem_tree_foreach_nodes(tree->root, callback, user_data);
 }
 
+static gboolean
+wmem_tree_foreach_range32_nodes(wmem_tree_node_t* node, guint32 first, guint32 last,
+        wmem_foreach_func callback, void *user_data)
+{
+    guint32 key = GPOINTER_TO_UINT(node->key);
+
+    /* skip the subtrees that lie entirely outside the range */
+    if (key > first && node->left) {
+        if (wmem_tree_foreach_range32_nodes(node->left, first, last, callback, user_data)) {
+            return TRUE;
+        }
+    }
+
+    if (key >= first && key <= last && !node->is_subtree && !node->is_removed) {
+        if (callback(node->key, node->data, user_data)) {
+            return TRUE;
+        }
+    }
+
+    if (key < last && node->right) {
+        if (wmem_tree_foreach_range32_nodes(node->right, first, last, callback, user_data)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+gboolean
+wmem_tree_foreach_range32(wmem_tree_t* tree, guint32 first, guint32 last,
+        wmem_foreach_func callback, void *user_data)
+{
+    if (first > last)
+        return FALSE;
+
+    if (tree->is_btree)
+        return btree_foreach_range(tree, first, last, callback, user_data);
+
+    if (!tree->root)
+        return FALSE;
+
+    return wmem_tree_foreach_range32_nodes(tree->root, first, last, callback, user_data);
+}
+
 static void wmem_print_subtree(wmem_tree_t *tree, guint32 level, wmem_printer_func key_printer, wmem_printer_func data_printer);
 
 static void
@@ -806,12 +1185,56 @@ wmem_tree_print_nodes(const char *prefix, wmem_tree_node_t *node, guint32 level,
 }
 
 
+static void
+wmem_btree_print_nodes(wmem_btree_node_t *node, guint32 level,
+    wmem_printer_func key_printer, wmem_printer_func data_printer)
+{
+    guint i;
+
+    wmem_print_indent(level);
+
+    ws_debug_printf("%s:%p count:%u next:%p\n",
+            node->is_leaf?"LEAF":"NODE", (void *)node, node->count, (void *)node->next);
+
+    for (i = 0; i < node->count; i++) {
+        wmem_print_indent(level + 1);
+        ws_debug_printf("key:%u", node->keys[i]);
+        if (key_printer) {
+            ws_debug_printf(" ");
+            key_printer(GUINT_TO_POINTER(node->keys[i]));
+        }
+        if (node->is_leaf) {
+            ws_debug_printf(" data:%p", node->u.data[i]);
+            if (data_printer) {
+                ws_debug_printf(" ");
+                data_printer(node->u.data[i]);
+            }
+        }
+        ws_debug_printf("\n");
+    }
+
+    if (!node->is_leaf) {
+        for (i = 0; i <= node->count; i++) {
+            wmem_btree_print_nodes(node->u.children[i], level+1, key_printer, data_printer);
+        }
+    }
+}
+
 static void
 wmem_print_subtree(wmem_tree_t *tree, guint32 level, wmem_printer_func key_printer, wmem_printer_func data_printer)
 {
     if (!tree)
         return;
 
+    if (tree->is_btree) {
+        wmem_print_indent(level);
+        ws_debug_printf("WMEM B+tree:%p root:%p\n", (void *)tree, (void *)tree->btree_root);
+        if (tree->btree_root) {
+            wmem_btree_print_nodes(tree->btree_root, level, key_printer, data_printer);
+        }
+        return;
+    }
+
     wmem_print_indent(level);
 
     ws_debug_printf("WMEM tree:%p root:%p\n", (void *)tree, (void *)tree->root);
@@ -60,6 +60,19 @@ wmem_tree_t *
 wmem_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope)
 G_GNUC_MALLOC;
 
+/** Creates a tree with the given allocator scope that stores its keys in a
+ * B+-tree instead of a red-black tree. Keys share nodes, which takes less
+ * memory per key and fewer cache misses per lookup on large trees.
+ *
+ * Only the guint32 key functions can be used on it: wmem_tree_insert32(),
+ * wmem_tree_lookup32(), wmem_tree_lookup32_le(), wmem_tree_lookup32_ge(),
+ * wmem_tree_remove32(), wmem_tree_foreach() and wmem_tree_foreach_range32().
+ */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_btree32(wmem_allocator_t *allocator)
+G_GNUC_MALLOC;
+
 /** Cleanup memory used by tree.  Intended for NULL scope allocated trees */
 WS_DLL_PUBLIC
 void
@@ -105,6 +118,14 @@ WS_DLL_PUBLIC
 void *
 wmem_tree_lookup32_le(wmem_tree_t *tree, guint32 key);
 
+/** Look up a node in the tree indexed by a guint32 integer value.
+ * Returns the node that has the smallest key that is greater than or equal
+ * to the search key, or NULL if no such key exists.
+ */
+WS_DLL_PUBLIC
+void *
+wmem_tree_lookup32_ge(wmem_tree_t *tree, guint32 key);
+
 /** Remove a node in the tree indexed by a guint32 integer value. This is not
  * really a remove, but the value is set to NULL so that wmem_tree_lookup32
  * not will find it.
@@ -228,6 +249,18 @@ wmem_tree_foreach(wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data);
 
 
+/** Traversal in key order of the nodes of a tree indexed by guint32 integer
+ * values whose keys are between first and last, inclusive, calling
+ * callback(key, value, userdata) for each. The key is passed converted
+ * with GUINT_TO_POINTER().
+ *
+ * Returns TRUE if the traversal was ended prematurely by the callback.
+ */
+WS_DLL_PUBLIC
+gboolean
+wmem_tree_foreach_range32(wmem_tree_t* tree, guint32 first, guint32 last,
+        wmem_foreach_func callback, void *user_data);
+
 /* Accepts callbacks to print the key and/or data (both printers can be null) */
 void
 wmem_print_tree(wmem_tree_t *tree, wmem_printer_func key_printer, wmem_printer_func data_printer);
@@ -52,6 +52,17 @@ static int hf_wslua_text = -1;
 
 static expert_field ei_lua_error = EI_INIT;
 
+/* Per callback profiling: kind ("dissector", "heuristic", ...) ->
+ * name (protocol or listener) -> wslua_profile_entry_t */
+typedef struct {
+    guint64 calls;
+    guint64 time_us;
+    guint64 heap_growth_kb;
+} wslua_profile_entry_t;
+
+gboolean wslua_profiling = FALSE;
+static GHashTable *wslua_profile_table = NULL;
+
 static expert_field ei_lua_proto_checksum_comment = EI_INIT;
 static expert_field ei_lua_proto_checksum_chat    = EI_INIT;
 static expert_field ei_lua_proto_checksum_note    = EI_INIT;
@@ -152,11 +163,75 @@ int get_hf_wslua_text(void) {
     return hf_wslua_text;
 }
 
+void wslua_profile_enable(gboolean enable) {
+    wslua_profiling = enable;
+}
+
+void wslua_profile_begin(lua_State* LS, wslua_profile_mark_t* mark) {
+    if (!wslua_profiling)
+        return;
+    mark->start_kb = lua_gc(LS, LUA_GCCOUNT, 0);
+    mark->start_us = g_get_monotonic_time();
+}
+
+void wslua_profile_end(lua_State* LS, const wslua_profile_mark_t* mark, const char* kind, const char* name) {
+    GHashTable *names;
+    wslua_profile_entry_t *entry;
+    gint64 elapsed;
+    int heap_kb;
+
+    if (!wslua_profiling)
+        return;
+    elapsed = g_get_monotonic_time() - mark->start_us;
+    heap_kb = lua_gc(LS, LUA_GCCOUNT, 0);
+
+    if (!wslua_profile_table) {
+        wslua_profile_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_destroy);
+    }
+    names = (GHashTable *)g_hash_table_lookup(wslua_profile_table, kind);
+    if (!names) {
+        names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+        g_hash_table_insert(wslua_profile_table, g_strdup(kind), names);
+    }
+    if (!name)
+        name = "(unnamed)";
+    entry = (wslua_profile_entry_t *)g_hash_table_lookup(names, name);
+    if (!entry) {
+        entry = g_new0(wslua_profile_entry_t, 1);
+        g_hash_table_insert(names, g_strdup(name), entry);
+    }
+
+    entry->calls++;
+    entry->time_us += elapsed;
+    /* Net growth only, a collection during the call can make this negative */
+    if (heap_kb > mark->start_kb)
+        entry->heap_growth_kb += heap_kb - mark->start_kb;
+}
+
+void wslua_profile_foreach(wslua_profile_callback callback, void *user_data) {
+    GHashTableIter kind_iter, name_iter;
+    gpointer kind, names, name, value;
+
+    if (!wslua_profile_table)
+        return;
+
+    g_hash_table_iter_init(&kind_iter, wslua_profile_table);
+    while (g_hash_table_iter_next(&kind_iter, &kind, &names)) {
+        g_hash_table_iter_init(&name_iter, (GHashTable *)names);
+        while (g_hash_table_iter_next(&name_iter, &name, &value)) {
+            const wslua_profile_entry_t *entry = (const wslua_profile_entry_t *)value;
+            callback((const char *)kind, (const char *)name, entry->calls,
+                     entry->time_us, entry->heap_growth_kb, user_data);
+        }
+    }
+}
+
 int dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void* data _U_) {
     int consumed_bytes = tvb_captured_length(tvb);
     tvbuff_t *saved_lua_tvb = lua_tvb;
     packet_info *saved_lua_pinfo = lua_pinfo;
     struct _wslua_treeitem *saved_lua_tree = lua_tree;
+    wslua_profile_mark_t mark;
     lua_pinfo = pinfo;
     lua_tvb = tvb;
 
@@ -182,9 +257,12 @@ int dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void* data
         lua_tree = push_TreeItem(L, tree, proto_tree_add_item(tree, hf_wslua_fake, tvb, 0, 0, ENC_NA));
         proto_item_set_hidden(lua_tree->item);
 
+        wslua_profile_begin(L, &mark);
         if  ( lua_pcall(L,3,1,0) ) {
+            wslua_profile_end(L, &mark, "dissector", pinfo->current_proto);
             proto_tree_add_expert_format(tree, pinfo, &ei_lua_error, tvb, 0, 0, "Lua Error: %s", lua_tostring(L,-1));
         } else {
+            wslua_profile_end(L, &mark, "dissector", pinfo->current_proto);
 
             /* if the Lua dissector reported the consumed bytes, pass it to our caller */
             if (lua_isnumber(L, -1)) {
@@ -221,6 +299,7 @@ gboolean heur_dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, v
     tvbuff_t *saved_lua_tvb = lua_tvb;
     packet_info *saved_lua_pinfo = lua_pinfo;
     struct _wslua_treeitem *saved_lua_tree = lua_tree;
+    wslua_profile_mark_t mark;
     lua_tvb = tvb;
     lua_pinfo = pinfo;
 
@@ -281,11 +360,14 @@ gboolean heur_dissect_lua(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, v
     lua_tree = push_TreeItem(L, tree, proto_tree_add_item(tree, hf_wslua_fake, tvb, 0, 0, ENC_NA));
     proto_item_set_hidden(lua_tree->item);
 
+    wslua_profile_begin(L, &mark);
     if  ( lua_pcall(L,3,1,0) ) {
+        wslua_profile_end(L, &mark, "heuristic", pinfo->current_proto);
         proto_tree_add_expert_format(tree, pinfo, &ei_lua_error, tvb, 0, 0,
                 "Lua Error: error calling %s heuristic dissector: %s", pinfo->current_proto, lua_tostring(L,-1));
         lua_settop(L,0);
     } else {
+        wslua_profile_end(L, &mark, "heuristic", pinfo->current_proto);
         if (lua_isboolean(L, -1) || lua_isnil(L, -1)) {
             result = lua_toboolean(L, -1);
         } else if (lua_type(L, -1) == LUA_TNUMBER) {
@@ -1090,6 +1172,11 @@ void wslua_reload_plugins (register_cb cb, gpointer client_data) {
 }
 
 void wslua_cleanup(void) {
+    if (wslua_profile_table) {
+        g_hash_table_destroy(wslua_profile_table);
+        wslua_profile_table = NULL;
+    }
+
     /* cleanup lua */
     if (L) {
         lua_close(L);
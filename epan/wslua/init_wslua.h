@@ -27,6 +27,13 @@ WS_DLL_PUBLIC void wslua_plugins_get_descriptions(wslua_plugin_description_callb
 WS_DLL_PUBLIC void wslua_plugins_dump_all(void);
 WS_DLL_PUBLIC const char *wslua_plugin_type_name(void);
 
+/* Profiling of the Lua callbacks; off until enabled. */
+typedef void (*wslua_profile_callback)(const char *kind, const char *name,
+                                       guint64 calls, guint64 time_us,
+                                       guint64 heap_growth_kb, void *user_data);
+WS_DLL_PUBLIC void wslua_profile_enable(gboolean enable);
+WS_DLL_PUBLIC void wslua_profile_foreach(wslua_profile_callback callback, void *user_data);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -240,7 +240,15 @@ struct _wslua_tap {
     int packet_ref;
     int draw_ref;
     int reset_ref;
+    int packets_ref;
     gboolean all_fields;
+    /* batched delivery of field values, see Listener:batch() */
+    struct _wslua_header_field_info** batch_fields;
+    guint batch_nfields;
+    int batch_fields_ref;
+    guint batch_size;
+    int rows_ref;
+    guint rows_count;
 };
 
 /* a "File" object can be different things under the hood. It can either
@@ -714,6 +722,16 @@ WSLUA_DECLARE_FUNCTIONS()
 
 extern lua_State* wslua_state(void);
 
+/* init_wslua.c: timing of callbacks into Lua, see wslua_profile_enable() */
+typedef struct _wslua_profile_mark {
+    gint64 start_us;
+    int start_kb;
+} wslua_profile_mark_t;
+
+extern gboolean wslua_profiling;
+extern void wslua_profile_begin(lua_State* L, wslua_profile_mark_t* mark);
+extern void wslua_profile_end(lua_State* L, const wslua_profile_mark_t* mark, const char* kind, const char* name);
+
 
 /* wslua_internals.c */
 /**
@@ -784,6 +802,7 @@ extern TreeItem push_TreeItem(lua_State *L, proto_tree *tree, proto_item *item);
 extern void clear_outstanding_TreeItem(void);
 
 extern FieldInfo* push_FieldInfo(lua_State *L, field_info* f);
+extern int push_Field_first_value(lua_State *L, proto_tree* tree, Field f);
 extern void clear_outstanding_FieldInfo(void);
 
 extern void wslua_print_stack(char* s, lua_State* L);
@@ -272,6 +272,108 @@ static int CaptureInfo_set_private_table(lua_State* L) {
     return set_wth_priv_table_ref(L, fi->wth);
 }
 
+/* reads one { offset, size } entry of a record layout table at the top of the stack */
+static void get_record_field(lua_State* L, const char* name, guint header_length, record_field_t* field) {
+    lua_getfield(L, -1, name);
+
+    field->offset = 0;
+    field->size = 0;
+
+    if (lua_istable(L, -1)) {
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+        field->offset = wslua_toguint(L, -2);
+        field->size = wslua_toguint(L, -1);
+        lua_pop(L, 2);
+
+        if (field->size != 1 && field->size != 2 && field->size != 4 && field->size != 8) {
+            luaL_error(L, "CaptureInfo.record_layout: size of '%s' must be 1, 2, 4 or 8", name);
+        } else if (field->offset > header_length || field->size > header_length - field->offset) {
+            luaL_error(L, "CaptureInfo.record_layout: '%s' does not fit in header_length", name);
+        }
+    } else if (!lua_isnil(L, -1)) {
+        luaL_error(L, "CaptureInfo.record_layout: '%s' must be a table of { offset, size }", name);
+    }
+
+    lua_pop(L, 1);
+}
+
+/* WSLUA_ATTRIBUTE CaptureInfo_record_layout WO A table describing a fixed-layout record header, set in `read_open()`,
+    so that Wireshark reads the records of this file natively instead of calling `read()` and `seek_read()`.
+
+    Each record is assumed to be a header of `header_length` bytes followed by `caplen` bytes of packet data for
+    the file's `encap`. The fields are given as `{ offset, size }` pairs within the header, with sizes of 1, 2, 4
+    or 8 bytes:
+
+    * `header_length` - the size of the record header (required)
+    * `big_endian` - true if the header fields are big-endian (default false)
+    * `caplen` - the captured length of the packet (required)
+    * `len` - the original length of the packet (default `caplen`)
+    * `ts_secs` - the seconds of the timestamp (optional)
+    * `ts_fraction` - the fraction of the timestamp, in units of `time_precision` (optional)
+
+    [source,lua]
+    ----
+    -- a classic big-endian pcap record header
+    capture.record_layout = {
+        header_length = 16,
+        big_endian = true,
+        ts_secs = { 0, 4 },
+        ts_fraction = { 4, 4 },
+        caplen = { 8, 4 },
+        len = { 12, 4 },
+    }
+    ----
+
+    Setting it to nil goes back to reading through the Lua functions.
+
+    @since 3.5.0
+*/
+static int CaptureInfo_set_record_layout(lua_State* L) {
+    CaptureInfo fi = checkCaptureInfo(L,1);
+    file_priv_t *priv = (file_priv_t*) fi->wth->priv;
+    record_layout_t layout;
+
+    if (!priv) {
+        /* shouldn't be possible */
+        return luaL_error(L, "Cannot set record layout: wtap private data is null");
+    }
+
+    if (lua_isnil(L, -1)) {
+        priv->has_record_layout = FALSE;
+        return 0;
+    }
+
+    luaL_checktype(L, -1, LUA_TTABLE);
+
+    memset(&layout, 0, sizeof layout);
+
+    lua_getfield(L, -1, "header_length");
+    layout.header_length = wslua_toguint(L, -1);
+    lua_pop(L, 1);
+    if (layout.header_length == 0 || layout.header_length > RECORD_HEADER_MAX_LENGTH) {
+        return luaL_error(L, "CaptureInfo.record_layout: header_length must be between 1 and %d", RECORD_HEADER_MAX_LENGTH);
+    }
+
+    lua_getfield(L, -1, "big_endian");
+    layout.big_endian = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    get_record_field(L, "ts_secs", layout.header_length, &layout.ts_secs);
+    get_record_field(L, "ts_fraction", layout.header_length, &layout.ts_fraction);
+    get_record_field(L, "caplen", layout.header_length, &layout.caplen);
+    get_record_field(L, "len", layout.header_length, &layout.len);
+
+    if (layout.caplen.size == 0) {
+        return luaL_error(L, "CaptureInfo.record_layout: caplen is required");
+    }
+
+    priv->record_layout = layout;
+    priv->has_record_layout = TRUE;
+
+    return 0;
+}
+
 WSLUA_ATTRIBUTES CaptureInfo_attributes[] = {
     WSLUA_ATTRIBUTE_RWREG(CaptureInfo,encap),
     WSLUA_ATTRIBUTE_RWREG(CaptureInfo,time_precision),
@@ -282,6 +384,7 @@ WSLUA_ATTRIBUTES CaptureInfo_attributes[] = {
     WSLUA_ATTRIBUTE_RWREG(CaptureInfo,user_app),
     WSLUA_ATTRIBUTE_WOREG(CaptureInfo,hosts),
     WSLUA_ATTRIBUTE_RWREG(CaptureInfo,private_table),
+    WSLUA_ATTRIBUTE_WOREG(CaptureInfo,record_layout),
     { NULL, NULL, NULL }
 };
 
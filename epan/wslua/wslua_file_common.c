@@ -38,6 +38,7 @@ void create_wth_priv(lua_State* L, wtap *wth) {
         return;
     }
     priv->table_ref = LUA_NOREF;
+    priv->has_record_layout = FALSE;
     wth->priv = (void*) priv;
 }
 
@@ -115,6 +116,7 @@ void create_wdh_priv(lua_State* L, wtap_dumper *wdh) {
         return;
     }
     priv->table_ref = LUA_NOREF;
+    priv->has_record_layout = FALSE;
     wdh->priv = (void*) priv;
 }
 
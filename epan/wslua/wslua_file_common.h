@@ -21,10 +21,29 @@
 #include "wslua.h"
 #include <wiretap/wtap-int.h>
 
-/* this is way overkill for this one member, but in case we need to add
-   more in the future, the plumbing will be here */
+/* the largest fixed record header CaptureInfo.record_layout accepts */
+#define RECORD_HEADER_MAX_LENGTH 1024
+
+/* one field of a fixed record header; a size of 0 means it is absent */
+typedef struct _record_field_t {
+    guint offset;
+    guint size;
+} record_field_t;
+
+/* a fixed-layout record header, read natively instead of through Lua */
+typedef struct _record_layout_t {
+    guint header_length;
+    gboolean big_endian;
+    record_field_t ts_secs;
+    record_field_t ts_fraction;
+    record_field_t caplen;
+    record_field_t len;
+} record_layout_t;
+
 typedef struct _file_priv_t {
     int table_ref;
+    gboolean has_record_layout;
+    record_layout_t record_layout;
 } file_priv_t;
 
 /* create and set the wtap->priv private data for the file instance */
@@ -14,6 +14,7 @@
  */
 
 #include "wslua_file_common.h"
+#include <wsutil/pint.h>
 
 /* WSLUA_CONTINUE_MODULE File */
 
@@ -132,6 +133,13 @@ static gboolean
 wslua_filehandler_seek_read(wtap *wth, gint64 seek_off,
     wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info);
+static gboolean
+wslua_filehandler_read_fixed(wtap *wth, wtap_rec *rec, Buffer *buf,
+                             int *err, gchar **err_info, gint64 *offset);
+static gboolean
+wslua_filehandler_seek_read_fixed(wtap *wth, gint64 seek_off,
+    wtap_rec *rec, Buffer *buf,
+    int *err, gchar **err_info);
 static void
 wslua_filehandler_close(wtap *wth);
 static void
@@ -180,21 +188,29 @@ wslua_filehandler_open(wtap *wth, int *err, gchar **err_info)
 
     if (retval == WTAP_OPEN_MINE) {
         /* this is our file type - set the routines and settings into wtap */
+        file_priv_t *priv = (file_priv_t*) wth->priv;
 
-        if (fh->read_ref != LUA_NOREF) {
-            wth->subtype_read = wslua_filehandler_read;
+        if (priv->has_record_layout) {
+            /* read_open() described the records, so we read them ourselves */
+            wth->subtype_read = wslua_filehandler_read_fixed;
+            wth->subtype_seek_read = wslua_filehandler_seek_read_fixed;
         }
         else {
-            g_warning("Lua file format module lacks a read routine");
-            return WTAP_OPEN_NOT_MINE;
-        }
+            if (fh->read_ref != LUA_NOREF) {
+                wth->subtype_read = wslua_filehandler_read;
+            }
+            else {
+                g_warning("Lua file format module lacks a read routine");
+                return WTAP_OPEN_NOT_MINE;
+            }
 
-        if (fh->seek_read_ref != LUA_NOREF) {
-            wth->subtype_seek_read = wslua_filehandler_seek_read;
-        }
-        else {
-            g_warning("Lua file format module lacks a seek-read routine");
-            return WTAP_OPEN_NOT_MINE;
+            if (fh->seek_read_ref != LUA_NOREF) {
+                wth->subtype_seek_read = wslua_filehandler_seek_read;
+            }
+            else {
+                g_warning("Lua file format module lacks a seek-read routine");
+                return WTAP_OPEN_NOT_MINE;
+            }
         }
 
         /* it's ok to not have a close routine */
@@ -349,6 +365,108 @@ wslua_filehandler_seek_read(wtap *wth, gint64 seek_off,
     return (retval == 1);
 }
 
+/* Gets a field of a fixed record header set by CaptureInfo.record_layout */
+static guint64
+record_field_value(const record_layout_t *layout, const record_field_t *field, const guint8 *hdr)
+{
+    const guint8 *p = hdr + field->offset;
+
+    switch (field->size) {
+        case 1:
+            return p[0];
+        case 2:
+            return layout->big_endian ? pntoh16(p) : pletoh16(p);
+        case 4:
+            return layout->big_endian ? pntoh32(p) : pletoh32(p);
+        case 8:
+            return layout->big_endian ? pntoh64(p) : pletoh64(p);
+        default:
+            return 0;
+    }
+}
+
+/* Reads one record described by CaptureInfo.record_layout, without calling
+ * into Lua.
+ */
+static gboolean
+wslua_filehandler_read_record(wtap *wth, FILE_T file, wtap_rec *rec, Buffer *buf,
+                              int *err, gchar **err_info)
+{
+    FileHandler fh = (FileHandler)(wth->wslua_data);
+    const record_layout_t *layout = &((file_priv_t*) wth->priv)->record_layout;
+    guint8 hdr[RECORD_HEADER_MAX_LENGTH];
+    guint64 caplen;
+    guint64 len;
+
+    if (!wtap_read_bytes_or_eof(file, hdr, layout->header_length, err, err_info))
+        return FALSE;
+
+    caplen = record_field_value(layout, &layout->caplen, hdr);
+    len = layout->len.size ? record_field_value(layout, &layout->len, hdr) : caplen;
+
+    if (caplen > WTAP_MAX_PACKET_SIZE_STANDARD || len > G_MAXUINT32) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("%s: record length %" G_GUINT64_FORMAT " is too large",
+                                    fh->finfo.name, caplen > WTAP_MAX_PACKET_SIZE_STANDARD ? caplen : len);
+        return FALSE;
+    }
+
+    g_free(rec->opt_comment);
+    rec->opt_comment = NULL;
+
+    rec->rec_type = REC_TYPE_PACKET;
+    rec->presence_flags = WTAP_HAS_CAP_LEN;
+    rec->tsprec = wth->file_tsprec;
+    rec->rec_header.packet_header.caplen = (guint32)caplen;
+    rec->rec_header.packet_header.len = (guint32)len;
+    rec->rec_header.packet_header.pkt_encap = wth->file_encap;
+
+    if (layout->ts_secs.size) {
+        guint64 fraction = layout->ts_fraction.size ? record_field_value(layout, &layout->ts_fraction, hdr) : 0;
+
+        switch (wth->file_tsprec) {
+            case WTAP_TSPREC_DSEC: fraction *= 100000000; break;
+            case WTAP_TSPREC_CSEC: fraction *= 10000000; break;
+            case WTAP_TSPREC_MSEC: fraction *= 1000000; break;
+            case WTAP_TSPREC_USEC: fraction *= 1000; break;
+            case WTAP_TSPREC_NSEC: break;
+            default: fraction = 0; break;
+        }
+
+        rec->presence_flags |= WTAP_HAS_TS;
+        rec->ts.secs = (time_t)record_field_value(layout, &layout->ts_secs, hdr);
+        rec->ts.nsecs = (int)(fraction % 1000000000);
+    }
+
+    return wtap_read_packet_bytes(file, buf, (guint)caplen, err, err_info);
+}
+
+static gboolean
+wslua_filehandler_read_fixed(wtap *wth, wtap_rec *rec, Buffer *buf,
+                             int *err, gchar **err_info, gint64 *offset)
+{
+    *offset = file_tell(wth->fh);
+
+    return wslua_filehandler_read_record(wth, wth->fh, rec, buf, err, err_info);
+}
+
+static gboolean
+wslua_filehandler_seek_read_fixed(wtap *wth, gint64 seek_off,
+    wtap_rec *rec, Buffer *buf,
+    int *err, gchar **err_info)
+{
+    if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
+        return FALSE;
+
+    if (!wslua_filehandler_read_record(wth, wth->random_fh, rec, buf, err, err_info)) {
+        if (*err == 0)
+            *err = WTAP_ERR_SHORT_READ;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 /* Classic wtap close function, called by wtap core.
  */
 static void
@@ -738,9 +856,7 @@ static gboolean verify_filehandler_complete(FileHandler fh) {
     return ((fh->is_reader || fh->is_writer) &&
             (!fh->is_reader ||
              (fh->is_reader &&
-              fh->read_open_ref != LUA_NOREF &&
-              fh->read_ref      != LUA_NOREF &&
-              fh->seek_read_ref != LUA_NOREF)) &&
+              fh->read_open_ref != LUA_NOREF)) &&
             (!fh->is_writer ||
              (fh->is_writer &&
               fh->can_write_encap_ref != LUA_NOREF &&
@@ -890,6 +1006,9 @@ WSLUA_ATTRIBUTE_FUNC_SETTER(FileHandler,read_open);
 
     The called Lua function should return the file offset/position number where the packet begins, or false if it hit an
     error.  The file offset will be saved by Wireshark and passed into the set `seek_read()` Lua function later.
+
+    This function is not called for files whose `read_open()` sets `CaptureInfo.record_layout`, and need not be set
+    (nor `seek_read`) if `read_open()` always does so.
     */
 WSLUA_ATTRIBUTE_FUNC_SETTER(FileHandler,read);
 
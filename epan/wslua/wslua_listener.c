@@ -66,13 +66,95 @@ static int tap_packet_cb_error_handler(lua_State* L) {
     return 0;
 }
 
+/* Appends a row with the values of the batched fields to the pending rows */
+static void lua_tap_batch_add(Listener tap, proto_tree* tree) {
+    lua_State* L = tap->L;
+    guint i;
+
+    if (tap->rows_ref == LUA_NOREF) {
+        lua_newtable(L);
+        tap->rows_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        tap->rows_count = 0;
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, tap->rows_ref);
+    lua_createtable(L, tap->batch_nfields, 0);
+
+    for (i = 0; i < tap->batch_nfields; i++) {
+        if (push_Field_first_value(L, tree, tap->batch_fields[i])) {
+            lua_rawseti(L, -2, i+1);
+        }
+    }
+
+    lua_rawseti(L, -2, ++tap->rows_count);
+    lua_pop(L, 1);
+}
+
+/* Drops the pending rows without delivering them */
+static void lua_tap_batch_discard(Listener tap) {
+    if (tap->rows_ref != LUA_NOREF) {
+        luaL_unref(tap->L, LUA_REGISTRYINDEX, tap->rows_ref);
+        tap->rows_ref = LUA_NOREF;
+    }
+    tap->rows_count = 0;
+}
+
+/* Hands the pending rows to the packets() callback in a single call */
+static gboolean lua_tap_batch_flush(Listener tap) {
+    lua_State* L = tap->L;
+    wslua_profile_mark_t mark;
+    int base;
+    int status;
+
+    if (tap->rows_count == 0 || tap->packets_ref == LUA_NOREF) {
+        lua_tap_batch_discard(tap);
+        return FALSE;
+    }
+
+    base = lua_gettop(L);
+    lua_pushcfunction(L,tap_packet_cb_error_handler);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, tap->packets_ref);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, tap->rows_ref);
+    lua_tap_batch_discard(tap);
+
+    wslua_profile_begin(L, &mark);
+    status = lua_pcall(L,1,0,base+1);
+    wslua_profile_end(L, &mark, "listener packets", tap->name);
+
+    switch ( status ) {
+        case 0:
+        case LUA_ERRRUN:
+            break;
+        case LUA_ERRMEM:
+            g_warning("Memory alloc error while calling listener tap callback packets");
+            break;
+        case LUA_ERRERR:
+            g_warning("Error while running the error handler function for listener tap callback");
+            break;
+        default:
+            g_assert_not_reached();
+            break;
+    }
+
+    lua_settop(L, base);
+    return TRUE;
+}
 
 static tap_packet_status lua_tap_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data) {
     Listener tap = (Listener)tapdata;
     tap_packet_status retval = TAP_PACKET_DONT_REDRAW;
     TreeItem lua_tree_tap;
+    wslua_profile_mark_t mark;
+    int status;
 
-    if (tap->packet_ref == LUA_NOREF) return TAP_PACKET_DONT_REDRAW; /* XXX - report error and return TAP_PACKET_FAILED? */
+    if (tap->batch_fields) {
+        lua_tap_batch_add(tap, edt->tree);
+        if (tap->batch_size && tap->rows_count >= tap->batch_size && lua_tap_batch_flush(tap)) {
+            retval = TAP_PACKET_REDRAW;
+        }
+    }
+
+    if (tap->packet_ref == LUA_NOREF) return retval; /* XXX - report error and return TAP_PACKET_FAILED? */
 
     lua_settop(tap->L,0);
     lua_pushcfunction(tap->L,tap_packet_cb_error_handler);
@@ -92,10 +174,15 @@ static tap_packet_status lua_tap_packet(void *tapdata, packet_info *pinfo, epan_
     lua_tree_tap = create_TreeItem(edt->tree, NULL);
     lua_tree = lua_tree_tap;
 
-    switch ( lua_pcall(tap->L,3,1,1) ) {
+    wslua_profile_begin(tap->L, &mark);
+    status = lua_pcall(tap->L,3,1,1);
+    wslua_profile_end(tap->L, &mark, "listener packet", tap->name);
+
+    switch ( status ) {
         case 0:
             /* XXX - treat 2 as TAP_PACKET_FAILED? */
-            retval = luaL_optinteger(tap->L,-1,1) == 0 ? TAP_PACKET_DONT_REDRAW : TAP_PACKET_REDRAW;
+            if (luaL_optinteger(tap->L,-1,1) != 0)
+                retval = TAP_PACKET_REDRAW;
             break;
         case LUA_ERRRUN:
             /* XXX - TAP_PACKET_FAILED? */
@@ -132,6 +219,8 @@ static int tap_reset_cb_error_handler(lua_State* L) {
 static void lua_tap_reset(void *tapdata) {
     Listener tap = (Listener)tapdata;
 
+    lua_tap_batch_discard(tap);
+
     if (tap->reset_ref == LUA_NOREF) return;
 
     lua_pushcfunction(tap->L,tap_reset_cb_error_handler);
@@ -164,13 +253,21 @@ static int tap_draw_cb_error_handler(lua_State* L) {
 static void lua_tap_draw(void *tapdata) {
     Listener tap = (Listener)tapdata;
     const gchar* error;
+    wslua_profile_mark_t mark;
+    int status;
+
+    lua_tap_batch_flush(tap);
 
     if (tap->draw_ref == LUA_NOREF) return;
 
     lua_pushcfunction(tap->L,tap_draw_cb_error_handler);
     lua_rawgeti(tap->L, LUA_REGISTRYINDEX, tap->draw_ref);
 
-    switch ( lua_pcall(tap->L,0,0,lua_gettop(tap->L)-1) ) {
+    wslua_profile_begin(tap->L, &mark);
+    status = lua_pcall(tap->L,0,0,lua_gettop(tap->L)-1);
+    wslua_profile_end(tap->L, &mark, "listener draw", tap->name);
+
+    switch ( status ) {
         case 0:
             /* OK */
             break;
@@ -201,6 +298,7 @@ static void deregister_Listener (lua_State* L _U_, Listener tap) {
 
     remove_tap_listener(tap);
 
+    g_free(tap->batch_fields);
     g_free(tap->filter);
     g_free(tap->name);
     g_free(tap);
@@ -235,7 +333,14 @@ WSLUA_CONSTRUCTOR Listener_new(lua_State* L) {
     tap->packet_ref = LUA_NOREF;
     tap->draw_ref = LUA_NOREF;
     tap->reset_ref = LUA_NOREF;
+    tap->packets_ref = LUA_NOREF;
     tap->all_fields = all_fields;
+    tap->batch_fields = NULL;
+    tap->batch_nfields = 0;
+    tap->batch_fields_ref = LUA_NOREF;
+    tap->batch_size = 0;
+    tap->rows_ref = LUA_NOREF;
+    tap->rows_count = 0;
 
     /*
      * XXX - do all Lua taps require the protocol tree?  If not, it might
@@ -320,6 +425,92 @@ WSLUA_METHOD Listener_remove(lua_State* L) {
     return 0;
 }
 
+WSLUA_METHOD Listener_batch(lua_State* L) {
+    /*
+    Collects the values of the given fields for every tapped packet without
+    calling into Lua, and hands them to `tap.packets` in batches. This avoids
+    entering the interpreter once per packet for statistics that only need
+    a few field values.
+
+    Each row is an array table holding the first value of each field, in
+    the order given, as `Field:values()` would return it; a field that is
+    absent from a packet leaves a `nil` hole in its row. The rows are
+    delivered every `count` packets, and whatever is pending when `tap.draw`
+    would be called. Pending rows are dropped on reset.
+
+    `tap.packet` is still called per packet if it is set.
+
+    @since 3.5.0
+
+    ===== Example
+
+    [source,lua]
+    ----
+    local f_len = Field.new("frame.len")
+    local tap = Listener.new("frame")
+    local bytes = 0
+    tap:batch({ f_len }, 1000)
+    function tap.packets(rows)
+        for _, row in ipairs(rows) do
+            bytes = bytes + row[1]
+        end
+    end
+    ----
+    */
+#define WSLUA_ARG_Listener_batch_FIELDS 2 /* An array table of `Field` objects to extract, or an empty table to stop batching. */
+#define WSLUA_OPTARG_Listener_batch_COUNT 3 /* The number of rows to collect before calling `tap.packets`.
+                                               The default is 0, which delivers the rows only when `tap.draw` would be called. */
+    Listener tap = checkListener(L,1);
+    lua_Integer count = luaL_optinteger(L,WSLUA_OPTARG_Listener_batch_COUNT,0);
+    GPtrArray* fields;
+    int i;
+
+    luaL_checktype(L,WSLUA_ARG_Listener_batch_FIELDS,LUA_TTABLE);
+
+    if (count < 0) {
+        WSLUA_OPTARG_ERROR(Listener_batch,COUNT,"must not be negative");
+        return 0;
+    }
+
+    fields = g_ptr_array_new();
+    lua_newtable(L);
+    for (i = 1; ; i++) {
+        lua_rawgeti(L,WSLUA_ARG_Listener_batch_FIELDS,i);
+        if (lua_isnil(L,-1)) {
+            lua_pop(L,1);
+            break;
+        }
+        if (!isField(L,-1)) {
+            g_ptr_array_free(fields,TRUE);
+            WSLUA_ARG_ERROR(Listener_batch,FIELDS,"must be an array of Field objects");
+            return 0;
+        }
+        g_ptr_array_add(fields,toField(L,-1));
+        /* keep the Field objects alive for as long as we use them */
+        lua_rawseti(L,-2,i);
+    }
+
+    if (tap->batch_fields_ref != LUA_NOREF) {
+        luaL_unref(L, LUA_REGISTRYINDEX, tap->batch_fields_ref);
+        tap->batch_fields_ref = LUA_NOREF;
+    }
+    g_free(tap->batch_fields);
+    tap->batch_fields = NULL;
+    tap->batch_nfields = fields->len;
+    tap->batch_size = (guint)count;
+
+    if (fields->len > 0) {
+        tap->batch_fields_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        tap->batch_fields = (Field*)g_ptr_array_free(fields,FALSE);
+    } else {
+        lua_pop(L,1);
+        g_ptr_array_free(fields,TRUE);
+        lua_tap_batch_discard(tap);
+    }
+
+    return 0;
+}
+
 WSLUA_METAMETHOD Listener__tostring(lua_State* L) {
     /* Generates a string of debug info for the tap `Listener`. */
     Listener tap = checkListener(L,1);
@@ -351,6 +542,22 @@ WSLUA_METAMETHOD Listener__tostring(lua_State* L) {
 WSLUA_ATTRIBUTE_FUNC_SETTER(Listener,packet);
 
 
+/* WSLUA_ATTRIBUTE Listener_packets WO A function that will be called with the rows collected by
+    `Listener:batch()`.
+
+    When later called by Wireshark, the `packets` function will be given an array table of rows,
+    each of which is an array table of field values.
+
+    [source,lua]
+    ----
+    function tap.packets(rows) ... end
+    ----
+
+    @since 3.5.0
+*/
+WSLUA_ATTRIBUTE_FUNC_SETTER(Listener,packets);
+
+
 /* WSLUA_ATTRIBUTE Listener_draw WO A function that will be called once every few seconds to redraw the GUI objects;
             in Tshark this funtion is called only at the very end of the capture file.
 
@@ -386,6 +593,7 @@ static int Listener__gc(lua_State* L _U_) {
  */
 WSLUA_ATTRIBUTES Listener_attributes[] = {
     WSLUA_ATTRIBUTE_WOREG(Listener,packet),
+    WSLUA_ATTRIBUTE_WOREG(Listener,packets),
     WSLUA_ATTRIBUTE_WOREG(Listener,draw),
     WSLUA_ATTRIBUTE_WOREG(Listener,reset),
     { NULL, NULL, NULL }
@@ -394,6 +602,7 @@ WSLUA_ATTRIBUTES Listener_attributes[] = {
 WSLUA_METHODS Listener_methods[] = {
     WSLUA_CLASS_FNREG(Listener,new),
     WSLUA_CLASS_FNREG(Listener,remove),
+    WSLUA_CLASS_FNREG(Listener,batch),
     WSLUA_CLASS_FNREG(Listener,list),
     { NULL, NULL }
 };
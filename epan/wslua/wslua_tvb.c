@@ -1361,6 +1361,31 @@ WSLUA_METHOD TvbRange_raw(lua_State* L) {
     WSLUA_RETURN(1); /* A Lua string of the binary bytes in the <<lua_class_TvbRange,`TvbRange`>>. */
 }
 
+WSLUA_METHOD TvbRange_pointer(lua_State* L) {
+    /* Obtain a pointer to the bytes of a <<lua_class_TvbRange,`TvbRange`>> and their number,
+       without copying them. This is meant for LuaJIT builds, where the pointer can be cast
+       to a `const uint8_t *` with the FFI.
+
+       The pointer is only valid while the packet is being dissected, and must not be
+       used for more than the returned number of bytes.
+
+       @since 3.5.0
+     */
+    TvbRange tvbr = checkTvbRange(L,1);
+
+    if (!tvbr || !tvbr->tvb) return 0;
+    if (tvbr->tvb->expired) {
+        luaL_error(L,"expired tvb");
+        return 0;
+    }
+
+    /* The range was checked against the captured data when it was created */
+    lua_pushlightuserdata(L, (void *)tvb_get_ptr(tvbr->tvb->ws_tvb, tvbr->offset, tvbr->len));
+    lua_pushnumber(L, tvbr->len);
+
+    WSLUA_RETURN(2); /* The pointer to the first byte, and the number of bytes. */
+}
+
 WSLUA_METAMETHOD TvbRange__eq(lua_State* L) {
     /* Checks whether the contents of two <<lua_class_TvbRange,`TvbRange`>>s are equal.
 
@@ -1449,6 +1474,7 @@ WSLUA_METHODS TvbRange_methods[] = {
     WSLUA_CLASS_FNREG(TvbRange,ustringz),
     WSLUA_CLASS_FNREG(TvbRange,uncompress),
     WSLUA_CLASS_FNREG(TvbRange,raw),
+    WSLUA_CLASS_FNREG(TvbRange,pointer),
     { NULL, NULL }
 };
 
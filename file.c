@@ -45,6 +45,7 @@
 #include "cfile.h"
 #include "file.h"
 #include "fileset.h"
+#include "first_pass_cache.h"
 #include "frame_tvbuff.h"
 
 #include "ui/alert_box.h"
@@ -71,9 +72,14 @@
 #endif
 
 static gboolean read_record(capture_file *cf, wtap_rec *rec, Buffer *buf,
-    dfilter_t *dfcode, epan_dissect_t *edt, column_info *cinfo, gint64 offset);
+    dfilter_t *dfcode, epan_dissect_t *edt, epan_dissect_t *rf_edt,
+    column_info *cinfo, gint64 offset);
+static epan_dissect_t *read_filter_edt_init(capture_file *cf, epan_dissect_t *rf_edt);
+static void read_filter_edt_cleanup(epan_dissect_t *rf_edt);
 
 static void rescan_packets(capture_file *cf, const char *action, const char *action_item, gboolean redissect);
+static void add_known_packet_to_packet_list(frame_data *fdata, capture_file *cf,
+    gboolean passed);
 
 typedef enum {
   MR_NOTMATCHED,
@@ -108,6 +114,7 @@ static gboolean find_packet(capture_file *cf, ws_match_function match_function,
 
 static void cf_rename_failure_alert_box(const char *filename, int err);
 static void ref_time_packets(capture_file *cf);
+static void cf_dfilter_results_clear(capture_file *cf);
 
 /* Seconds spent processing packets between pushing UI updates. */
 #define PROGBAR_UPDATE_INTERVAL 0.150
@@ -280,6 +287,7 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   cf->state = FILE_READ_IN_PROGRESS;
 
   cf->provider.wth = wth;
+  cap_file_provider_init_record_cache(&cf->provider);
   cf->f_datalen = 0;
 
   /* Set the file name because we need it to set the follow stream filter.
@@ -329,6 +337,10 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
   wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
 
+  cf->fp_cache = first_pass_cache_new(cf);
+  cf->first_pass_pending = FALSE;
+  cf->first_pass_frames = 0;
+
   return CF_OK;
 
 fail:
@@ -373,6 +385,7 @@ cf_close(capture_file *cf)
     wtap_close(cf->provider.wth);
     cf->provider.wth = NULL;
   }
+  cap_file_provider_free_record_cache(&cf->provider);
   /* We have no file open... */
   if (cf->filename != NULL) {
     /* If it's a temporary file, remove it. */
@@ -400,6 +413,7 @@ cf_close(capture_file *cf)
 
   dfilter_free(cf->rfcode);
   cf->rfcode = NULL;
+  cf_dfilter_results_clear(cf);
   if (cf->provider.frames != NULL) {
     free_frame_data_sequence(cf->provider.frames);
     cf->provider.frames = NULL;
@@ -408,6 +422,11 @@ cf_close(capture_file *cf)
     g_tree_destroy(cf->provider.frames_user_comments);
     cf->provider.frames_user_comments = NULL;
   }
+  /* The frames may have pointed to coloring rules it owns. */
+  first_pass_cache_free(cf->fp_cache);
+  cf->fp_cache = NULL;
+  cf->first_pass_pending = FALSE;
+  cf->first_pass_frames = 0;
   cf_unselect_packet(cf);   /* nothing to select */
   cf->first_displayed = 0;
   cf->last_displayed = 0;
@@ -488,6 +507,66 @@ calc_progbar_val(capture_file *cf, gint64 size, gint64 file_pos, gchar *status_s
   return progbar_val;
 }
 
+/*
+ * Name resolution records and decryption secrets are only read, and handed
+ * on, in the sequential pass through a file, so a first pass that saw any
+ * can't be replaced by the first pass cache.
+ */
+static gboolean first_pass_saw_side_data;
+
+static void
+first_pass_add_ipv4_name(const guint addr, const gchar *name)
+{
+  first_pass_saw_side_data = TRUE;
+  add_ipv4_name(addr, name);
+}
+
+static void
+first_pass_add_ipv6_name(const void *addrp, const gchar *name)
+{
+  first_pass_saw_side_data = TRUE;
+  add_ipv6_name((const ws_in6_addr *)addrp, name);
+}
+
+static void
+first_pass_add_secrets(guint32 secrets_type, const void *secrets, guint size)
+{
+  first_pass_saw_side_data = TRUE;
+  secrets_wtap_callback(secrets_type, secrets, size);
+}
+
+static guint
+file_num_idbs(capture_file *cf)
+{
+  wtapng_iface_descriptions_t *idb_info;
+  guint num_idbs;
+
+  idb_info = wtap_file_get_idb_info(cf->provider.wth);
+  num_idbs = idb_info->interface_data->len;
+  g_free(idb_info);
+  return num_idbs;
+}
+
+/*
+ * Add the frames read from the first pass cache to the packet list.  None
+ * of them has been dissected; first_pass_catch_up() does that, in order,
+ * when they're needed.
+ */
+static void
+add_cached_packets_to_packet_list(capture_file *cf)
+{
+  guint32     framenum;
+  frame_data *fdata;
+
+  for (framenum = 1; framenum <= cf->count; framenum++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    add_known_packet_to_packet_list(fdata, cf, TRUE);
+    packet_list_append(NULL, fdata);
+  }
+  cf->first_pass_pending = TRUE;
+  cf->first_pass_frames = 0;
+}
+
 cf_read_status_t
 cf_read(capture_file *cf, gboolean reloading)
 {
@@ -499,7 +578,8 @@ cf_read(capture_file *cf, gboolean reloading)
   GTimer              *prog_timer = g_timer_new();
   gint64               size;
   gint64               start_time;
-  epan_dissect_t       edt;
+  epan_dissect_t       edt, rf_edt_buf;
+  epan_dissect_t      *rf_edt;
   wtap_rec             rec;
   Buffer               buf;
   dfilter_t           *dfcode;
@@ -508,6 +588,8 @@ cf_read(capture_file *cf, gboolean reloading)
   guint                tap_flags;
   gboolean             compiled;
   volatile gboolean    is_read_aborted = FALSE;
+  gboolean             fp_cache_loaded = FALSE;
+  guint                num_idbs = 0;
 
   /* The update_progress_dlg call below might end up accepting a user request to
    * trigger redissection/rescans which can modify/destroy the dissection
@@ -567,10 +649,37 @@ cf_read(capture_file *cf, gboolean reloading)
   cf->stop_flag = FALSE;
   start_time = g_get_monotonic_time();
 
+  /* If only the packet list needs the first pass, it can come from the
+     first pass cache, or be saved to it. */
+  if (cf->fp_cache != NULL && dfcode == NULL && cf->rfcode == NULL &&
+      !tap_listeners_require_dissection()) {
+    num_idbs = file_num_idbs(cf);
+    fp_cache_loaded = first_pass_cache_load(cf->fp_cache, cf, num_idbs, max_records);
+    if (!fp_cache_loaded) {
+      /* Colorize the frames and fill in their columns as the packet list
+         would, so that those can be saved too. */
+      first_pass_cache_record(cf->fp_cache, &cf->cinfo);
+      if (color_filters_used() || have_custom_cols(&cf->cinfo) ||
+          have_field_extractors())
+        create_proto_tree = TRUE;
+
+      first_pass_saw_side_data = FALSE;
+      wtap_set_cb_new_ipv4(cf->provider.wth, first_pass_add_ipv4_name);
+      wtap_set_cb_new_ipv6(cf->provider.wth, first_pass_add_ipv6_name);
+      wtap_set_cb_new_secrets(cf->provider.wth, first_pass_add_secrets);
+    }
+  }
+
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
+  rf_edt = read_filter_edt_init(cf, &rf_edt_buf);
 
   /* If any tap listeners require the columns, construct them. */
   cinfo = (tap_flags & TL_REQUIRES_COLUMNS) ? &cf->cinfo : NULL;
+  if (first_pass_cache_recording(cf->fp_cache))
+    cinfo = &cf->cinfo;
+
+  if (fp_cache_loaded)
+    add_cached_packets_to_packet_list(cf);
 
   /* Find the size of the file. */
   size = wtap_file_size(cf->provider.wth, NULL);
@@ -589,7 +698,8 @@ cf_read(capture_file *cf, gboolean reloading)
     float   progbar_val;
     gchar   status_str[100];
 
-    while ((wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info,
+    while (!fp_cache_loaded &&
+           (wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info,
             &data_offset))) {
       if (size >= 0) {
         if (cf->count == max_records) {
@@ -649,7 +759,7 @@ cf_read(capture_file *cf, gboolean reloading)
            hours even on fast machines) just to see that it was the wrong file. */
         break;
       }
-      read_record(cf, &rec, &buf, dfcode, &edt, cinfo, data_offset);
+      read_record(cf, &rec, &buf, dfcode, &edt, rf_edt, cinfo, data_offset);
     }
   }
   CATCH(OutOfMemoryError) {
@@ -681,6 +791,7 @@ cf_read(capture_file *cf, gboolean reloading)
   dfilter_free(dfcode);
 
   epan_dissect_cleanup(&edt);
+  read_filter_edt_cleanup(rf_edt);
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
 
@@ -688,8 +799,11 @@ cf_read(capture_file *cf, gboolean reloading)
   wtap_sequential_close(cf->provider.wth);
 
   /* Allow the protocol dissectors to free up memory that they
-   * don't need after the sequential run-through of the packets. */
-  postseq_cleanup_all_protocols();
+   * don't need after the sequential run-through of the packets.
+   * If the frames came from the first pass cache, that run-through
+   * hasn't happened yet. */
+  if (!fp_cache_loaded)
+    postseq_cleanup_all_protocols();
 
   /* compute the time it took to load the file */
   compute_elapsed(cf, start_time);
@@ -697,8 +811,25 @@ cf_read(capture_file *cf, gboolean reloading)
   /* Set the file encapsulation type now; we don't know what it is until
      we've looked at all the packets, as we don't know until then whether
      there's more than one type (and thus whether it's
-     WTAP_ENCAP_PER_PACKET). */
-  cf->lnk_t = wtap_file_encap(cf->provider.wth);
+     WTAP_ENCAP_PER_PACKET).  The first pass cache has it. */
+  if (!fp_cache_loaded)
+    cf->lnk_t = wtap_file_encap(cf->provider.wth);
+
+  if (first_pass_cache_recording(cf->fp_cache)) {
+    /* Only save a complete first pass, of a file whose interfaces were all
+       known when it was opened, as the random access reader can't find the
+       others without the sequential read. */
+    if (err == 0 && !cf->stop_flag && !too_many_records && !is_read_aborted &&
+        !first_pass_saw_side_data && cf->redissection_queued == RESCAN_NONE &&
+        file_num_idbs(cf) == num_idbs)
+      first_pass_cache_write(cf->fp_cache, cf, num_idbs);
+    else
+      first_pass_cache_abandon(cf->fp_cache);
+
+    wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
+    wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+    wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+  }
 
   cf->current_frame = frame_data_sequence_find(cf->provider.frames, cf->first_displayed);
   cf->current_row = 0;
@@ -776,7 +907,8 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
   gchar            *err_info;
   volatile int      newly_displayed_packets = 0;
   dfilter_t        *dfcode;
-  epan_dissect_t    edt;
+  epan_dissect_t    edt, rf_edt_buf;
+  epan_dissect_t   *rf_edt;
   gboolean          create_proto_tree;
   guint             tap_flags;
   gboolean          compiled;
@@ -816,6 +948,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
   /*g_log(NULL, G_LOG_LEVEL_MESSAGE, "cf_continue_tail: %u new: %u", cf->count, to_read);*/
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
+  rf_edt = read_filter_edt_init(cf, &rf_edt_buf);
 
   TRY {
     gint64 data_offset = 0;
@@ -836,7 +969,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
            aren't any packets left to read) exit. */
         break;
       }
-      if (read_record(cf, rec, buf, dfcode, &edt, cinfo, data_offset)) {
+      if (read_record(cf, rec, buf, dfcode, &edt, rf_edt, cinfo, data_offset)) {
         newly_displayed_packets++;
       }
       to_read--;
@@ -865,6 +998,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
   dfilter_free(dfcode);
 
   epan_dissect_cleanup(&edt);
+  read_filter_edt_cleanup(rf_edt);
 
   /*g_log(NULL, G_LOG_LEVEL_MESSAGE, "cf_continue_tail: count %u state: %u err: %u",
     cf->count, cf->state, *err);*/
@@ -917,7 +1051,8 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
   gint64     data_offset;
   dfilter_t *dfcode;
   column_info *cinfo;
-  epan_dissect_t edt;
+  epan_dissect_t edt, rf_edt_buf;
+  epan_dissect_t *rf_edt;
   gboolean   create_proto_tree;
   guint      tap_flags;
   gboolean   compiled;
@@ -961,6 +1096,7 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
   /*packet_list_freeze();*/
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
+  rf_edt = read_filter_edt_init(cf, &rf_edt_buf);
 
   while ((wtap_read(cf->provider.wth, rec, buf, err, &err_info, &data_offset))) {
     if (cf->state == FILE_READ_ABORTED) {
@@ -969,13 +1105,14 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
          aren't any packets left to read) exit. */
       break;
     }
-    read_record(cf, rec, buf, dfcode, &edt, cinfo, data_offset);
+    read_record(cf, rec, buf, dfcode, &edt, rf_edt, cinfo, data_offset);
   }
 
   /* Cleanup and release all dfilter resources */
   dfilter_free(dfcode);
 
   epan_dissect_cleanup(&edt);
+  read_filter_edt_cleanup(rf_edt);
 
   /* Don't freeze/thaw the list when doing live capture */
   /*packet_list_thaw();*/
@@ -1197,11 +1334,26 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     prime_epan_dissect_with_postdissector_wanted_hfids(edt);
   }
 
+  if (first_pass_cache_recording(cf->fp_cache)) {
+    /* Colorize the frame and fill in its columns as the packet list
+       would, so that they can be saved in the first pass cache. */
+    color_filters_prime_edt(edt);
+    fdata->need_colorize = 1;
+    if (cinfo != NULL)
+      col_custom_prime_edt(edt, cinfo);
+  }
+
   /* Dissect the frame. */
   epan_dissect_run_with_taps(edt, cf->cd_t, rec,
                              frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
                              fdata, cinfo);
 
+  if (first_pass_cache_recording(cf->fp_cache)) {
+    if (cinfo != NULL)
+      epan_dissect_fill_in_columns(edt, FALSE, FALSE /* fill_fd_columns */);
+    first_pass_cache_add(cf->fp_cache, fdata, cinfo);
+  }
+
   /* If we don't have a display filter, set "passed_dfilter" to 1. */
   if (dfcode != NULL) {
     fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
@@ -1240,6 +1392,26 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   epan_dissect_reset(edt);
 }
 
+/*
+ * Set up, or clean up, the epan_dissect_t that read_record() runs the read
+ * filter in, if there is one, so that it's reused for every record.
+ */
+static epan_dissect_t *
+read_filter_edt_init(capture_file *cf, epan_dissect_t *rf_edt)
+{
+  if (!cf->rfcode)
+    return NULL;
+  epan_dissect_init(rf_edt, cf->epan, TRUE, FALSE);
+  return rf_edt;
+}
+
+static void
+read_filter_edt_cleanup(epan_dissect_t *rf_edt)
+{
+  if (rf_edt)
+    epan_dissect_cleanup(rf_edt);
+}
+
 /*
  * Read in a new record.
  * Returns TRUE if the packet was added to the packet (record) list,
@@ -1247,7 +1419,8 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
  */
 static gboolean
 read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
-            epan_dissect_t *edt, column_info *cinfo, gint64 offset)
+            epan_dissect_t *edt, epan_dissect_t *rf_edt, column_info *cinfo,
+            gint64 offset)
 {
   frame_data    fdlocal;
   frame_data   *fdata;
@@ -1268,16 +1441,13 @@ read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
      would be one more than the count of frames in the file so far. */
   frame_data_init(&fdlocal, cf->count + 1, rec, offset, cf->cum_bytes);
 
-  if (cf->rfcode) {
-    epan_dissect_t rf_edt;
-
-    epan_dissect_init(&rf_edt, cf->epan, TRUE, FALSE);
-    epan_dissect_prime_with_dfilter(&rf_edt, cf->rfcode);
-    epan_dissect_run(&rf_edt, cf->cd_t, rec,
+  if (cf->rfcode && rf_edt) {
+    epan_dissect_prime_with_dfilter(rf_edt, cf->rfcode);
+    epan_dissect_run(rf_edt, cf->cd_t, rec,
                      frame_tvbuff_new_buffer(&cf->provider, &fdlocal, buf),
                      &fdlocal, NULL);
-    passed = dfilter_apply_edt(cf->rfcode, &rf_edt);
-    epan_dissect_cleanup(&rf_edt);
+    passed = dfilter_apply_edt(cf->rfcode, rf_edt);
+    epan_dissect_reset(rf_edt);
   }
 
   if (passed) {
@@ -1364,7 +1534,7 @@ merge_callback(merge_event event, int num _U_,
             gint64 file_pos = 0;
             /* Get the sum of the seek positions in all of the files. */
             for (i = 0; i < in_file_count; i++)
-              file_pos += wtap_read_so_far(in_files[i].wth);
+              file_pos += in_files[i].read_so_far;
 
             progbar_val = (gfloat) file_pos / (gfloat) cb_data->f_len;
             if (progbar_val > 1.0f) {
@@ -1555,6 +1725,8 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
 void
 cf_reftime_packets(capture_file *cf)
 {
+  /* Time reference frames are always displayed. */
+  cf_dfilter_results_clear(cf);
   ref_time_packets(cf);
 }
 
@@ -1580,6 +1752,95 @@ cf_redissect_packets(capture_file *cf)
   }
 }
 
+/*
+ * Frames loaded from the first pass cache haven't been dissected.
+ * Dissectors expect to see the frames of a file in order the first time
+ * around, so before a frame is read to be dissected, dissect all the
+ * frames before it that haven't been.
+ *
+ * XXX - going to a frame near the end of a large file does most of the
+ * first pass, without a progress bar; one can't be put up here, as this
+ * may be called while the packet list is being drawn.
+ */
+static void
+first_pass_catch_up(capture_file *cf, guint32 framenum)
+{
+  static gboolean in_catch_up = FALSE;
+  epan_dissect_t  edt;
+  gboolean        edt_inited = FALSE;
+  wtap_rec        rec;
+  Buffer          buf;
+  frame_data     *fdata;
+  int             err;
+  gchar          *err_info;
+
+  if (!cf->first_pass_pending || in_catch_up)
+    return;
+  in_catch_up = TRUE;
+
+  while (cf->first_pass_frames < cf->count) {
+    fdata = frame_data_sequence_find(cf->provider.frames, cf->first_pass_frames + 1);
+    if (!fdata->visited) {
+      /* That one is up to the caller. */
+      if (fdata->num >= framenum)
+        break;
+
+      if (!edt_inited) {
+        epan_dissect_init(&edt, cf->epan, postdissectors_want_hfids(), FALSE);
+        wtap_rec_init(&rec);
+        ws_buffer_init(&buf, 1514);
+        edt_inited = TRUE;
+      }
+      /* If it can't be read, the caller finds out when it's displayed. */
+      if (cap_file_provider_read_record(&cf->provider, fdata->num, fdata->file_off, &rec, &buf, &err, &err_info)) {
+        prime_epan_dissect_with_postdissector_wanted_hfids(&edt);
+        epan_dissect_run(&edt, cf->cd_t, &rec,
+                         frame_tvbuff_new_buffer(&cf->provider, fdata, &buf),
+                         fdata, NULL);
+        epan_dissect_reset(&edt);
+      } else {
+        g_free(err_info);
+      }
+    }
+    cf->first_pass_frames++;
+  }
+
+  if (edt_inited) {
+    epan_dissect_cleanup(&edt);
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+  }
+
+  if (cf->first_pass_frames == cf->count) {
+    /* The first pass is done; see cf_read(). */
+    cf->first_pass_pending = FALSE;
+    postseq_cleanup_all_protocols();
+  }
+  in_catch_up = FALSE;
+}
+
+gboolean
+cf_get_cached_columns(capture_file *cf, const frame_data *fdata,
+                      column_info *cinfo, gboolean need_color)
+{
+  if (cf->fp_cache == NULL)
+    return FALSE;
+  if (need_color && !first_pass_cache_has_colors(cf->fp_cache))
+    return FALSE;
+  if (cinfo != NULL && !first_pass_cache_get_columns(cf->fp_cache, fdata, cinfo))
+    return FALSE;
+  return TRUE;
+}
+
+void
+cf_discard_cached_columns(capture_file *cf, gboolean columns, gboolean colors)
+{
+  if (columns)
+    first_pass_cache_discard_columns(cf->fp_cache);
+  if (colors)
+    first_pass_cache_discard_colors(cf->fp_cache);
+}
+
 gboolean
 cf_read_record(capture_file *cf, const frame_data *fdata,
                  wtap_rec *rec, Buffer *buf)
@@ -1587,7 +1848,8 @@ cf_read_record(capture_file *cf, const frame_data *fdata,
   int    err;
   gchar *err_info;
 
-  if (!wtap_seek_read(cf->provider.wth, fdata->file_off, rec, buf, &err, &err_info)) {
+  first_pass_catch_up(cf, fdata->num);
+  if (!cap_file_provider_read_record(&cf->provider, fdata->num, fdata->file_off, rec, buf, &err, &err_info)) {
     cfile_read_failure_alert_box(cf->filename, err, err_info);
     return FALSE;
   }
@@ -1601,7 +1863,8 @@ cf_read_record_no_alert(capture_file *cf, const frame_data *fdata,
   int    err;
   gchar *err_info;
 
-  if (!wtap_seek_read(cf->provider.wth, fdata->file_off, rec, buf, &err, &err_info)) {
+  first_pass_catch_up(cf, fdata->num);
+  if (!cap_file_provider_read_record(&cf->provider, fdata->num, fdata->file_off, rec, buf, &err, &err_info)) {
     g_free(err_info);
     return FALSE;
   }
@@ -1614,6 +1877,197 @@ cf_read_current_record(capture_file *cf)
   return cf_read_record(cf, cf->current_frame, &cf->rec, &cf->buf);
 }
 
+/*
+ * The per-frame results of the most recently applied display filters, so
+ * that going back to one of them doesn't require dissecting every frame
+ * again, and narrowing one of them down with "and" only requires dissecting
+ * the frames that passed it.
+ */
+#define DFILTER_RESULTS_MAX 4
+
+typedef struct {
+  gchar   *dftext;          /* filter string */
+  guint32  count;           /* number of frames the results cover */
+  guint8  *passed;          /* bit per frame: passed the filter */
+  guint8  *depended_upon;   /* bit per frame: a displayed frame depends on it */
+} dfilter_result_t;
+
+#define DFILTER_RESULT_GET(bits, framenum) \
+  (((bits)[((framenum) - 1) >> 3] >> (((framenum) - 1) & 7)) & 1)
+#define DFILTER_RESULT_SET(bits, framenum) \
+  ((bits)[((framenum) - 1) >> 3] |= (guint8)(1 << (((framenum) - 1) & 7)))
+
+static void
+dfilter_result_free(gpointer data)
+{
+  dfilter_result_t *result = (dfilter_result_t *)data;
+
+  g_free(result->dftext);
+  g_free(result->passed);
+  g_free(result->depended_upon);
+  g_free(result);
+}
+
+/*
+ * Forget all saved results.  This must be done whenever anything other
+ * than the dissection of a frame that a filter can test changes, such as
+ * the marked, ignored or time reference frames, or the dissection itself.
+ */
+static void
+cf_dfilter_results_clear(capture_file *cf)
+{
+  g_slist_free_full(cf->dfilter_results, dfilter_result_free);
+  cf->dfilter_results = NULL;
+}
+
+/*
+ * Returns TRUE if dftext is base followed by "and" (or "&&") and another
+ * test.  As "and" has the lowest precedence of all operators, such a
+ * filter can only match frames that base matches.
+ */
+static gboolean
+dfilter_text_narrows(const char *dftext, const char *base)
+{
+  size_t      base_len = strlen(base);
+  const char *p = dftext + base_len;
+
+  if (strncmp(dftext, base, base_len) != 0 || !g_ascii_isspace(*p))
+    return FALSE;
+  while (g_ascii_isspace(*p))
+    p++;
+  if (p[0] == '&' && p[1] == '&')
+    return TRUE;
+  return strncmp(p, "and", 3) == 0 &&
+         (g_ascii_isspace(p[3]) || p[3] == '(' || p[3] == '!');
+}
+
+/*
+ * Look up saved results usable for dftext: those of dftext itself, if any
+ * (in which case *exact is set), else those of a filter that it narrows.
+ */
+static dfilter_result_t *
+cf_dfilter_results_find(capture_file *cf, const char *dftext, gboolean *exact)
+{
+  GSList           *item;
+  dfilter_result_t *result, *narrowed = NULL;
+
+  /* Macros may have been redefined since the results were saved. */
+  if (dftext == NULL || strchr(dftext, '$') != NULL)
+    return NULL;
+
+  for (item = cf->dfilter_results; item != NULL; item = g_slist_next(item)) {
+    result = (dfilter_result_t *)item->data;
+    if (strcmp(result->dftext, dftext) == 0) {
+      *exact = TRUE;
+      return result;
+    }
+    if (narrowed == NULL && dfilter_text_narrows(dftext, result->dftext))
+      narrowed = result;
+  }
+  *exact = FALSE;
+  return narrowed;
+}
+
+/*
+ * Save the results of applying dftext to the first frames_count frames,
+ * replacing any older results for it.
+ */
+static void
+cf_dfilter_results_save(capture_file *cf, const char *dftext, guint32 frames_count)
+{
+  GSList           *item, *next;
+  dfilter_result_t *result;
+  frame_data       *fdata;
+  guint32           framenum;
+  guint             length;
+
+  if (dftext == NULL || strchr(dftext, '$') != NULL || frames_count == 0)
+    return;
+
+  for (item = cf->dfilter_results; item != NULL; item = next) {
+    next = g_slist_next(item);
+    result = (dfilter_result_t *)item->data;
+    if (strcmp(result->dftext, dftext) == 0) {
+      dfilter_result_free(result);
+      cf->dfilter_results = g_slist_delete_link(cf->dfilter_results, item);
+    }
+  }
+
+  result = g_new(dfilter_result_t, 1);
+  result->dftext = g_strdup(dftext);
+  result->count = frames_count;
+  result->passed = (guint8 *)g_malloc0((frames_count + 7) / 8);
+  result->depended_upon = (guint8 *)g_malloc0((frames_count + 7) / 8);
+  for (framenum = 1; framenum <= frames_count; framenum++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    if (fdata->passed_dfilter)
+      DFILTER_RESULT_SET(result->passed, framenum);
+    if (fdata->dependent_of_displayed)
+      DFILTER_RESULT_SET(result->depended_upon, framenum);
+  }
+  cf->dfilter_results = g_slist_prepend(cf->dfilter_results, result);
+
+  length = g_slist_length(cf->dfilter_results);
+  if (length > DFILTER_RESULTS_MAX) {
+    item = g_slist_nth(cf->dfilter_results, DFILTER_RESULTS_MAX - 1);
+    g_slist_free_full(item->next, dfilter_result_free);
+    item->next = NULL;
+  }
+}
+
+/*
+ * Account for a frame whose display filter result is already known,
+ * without reading or dissecting it; the counterpart of the bookkeeping
+ * in add_packet_to_packet_list().
+ */
+static void
+add_known_packet_to_packet_list(frame_data *fdata, capture_file *cf,
+    gboolean passed)
+{
+  frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                &cf->provider.ref, cf->provider.prev_dis);
+  cf->provider.prev_cap = fdata;
+
+  fdata->passed_dfilter = passed ? 1 : 0;
+
+  if (fdata->passed_dfilter || fdata->ref_time) {
+    cf->displayed_count++;
+    frame_data_set_after_dissect(fdata, &cf->cum_bytes);
+    cf->provider.prev_dis = fdata;
+
+    /* If we haven't yet seen the first frame, this is it. */
+    if (cf->first_displayed == 0)
+      cf->first_displayed = fdata->num;
+
+    /* This is the last frame we've seen so far. */
+    cf->last_displayed = fdata->num;
+  }
+}
+
+/*
+ * Apply a display filter that only refers to frame fields, as reported
+ * by dfilter_is_frame_only(), to a frame without dissecting its
+ * contents.
+ */
+static gboolean
+frame_metadata_passes_dfilter(frame_data *fdata, capture_file *cf,
+    epan_dissect_t *edt, dfilter_t *dfcode, wtap_rec *rec, Buffer *buf)
+{
+  gboolean passed;
+
+  frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                &cf->provider.ref, cf->provider.prev_dis);
+
+  epan_dissect_prime_with_dfilter(edt, dfcode);
+  epan_dissect_run(edt, cf->cd_t, rec,
+                   frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
+                   fdata, NULL);
+  passed = dfilter_apply_edt(dfcode, edt);
+  epan_dissect_reset(edt);
+
+  return passed;
+}
+
 /* Rescan the list of packets, reconstructing the CList.
 
    "action" describes why we're doing this; it's used in the progress
@@ -1644,6 +2098,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gint64      start_time;
   gchar       status_str[100];
   epan_dissect_t  edt;
+  epan_dissect_t  frame_edt;
   dfilter_t  *dfcode;
   column_info *cinfo;
   gboolean    create_proto_tree;
@@ -1652,6 +2107,12 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    compiled;
   guint32     frames_count;
   gboolean    queued_rescan_type = RESCAN_NONE;
+  dfilter_result_t *dfresult = NULL;
+  gboolean    dfresult_exact = FALSE;
+  gboolean    known;
+  gboolean    known_passed;
+  gboolean    frame_only = FALSE;
+  gboolean    rows_shown = FALSE;
 
   /* Rescan in progress, clear pending actions. */
   cf->redissection_queued = RESCAN_NONE;
@@ -1706,16 +2167,43 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
      screen updates while it happens. */
   packet_list_freeze();
 
+  if (redissect) {
+    /* The dissection of any frame may change. */
+    cf_dfilter_results_clear(cf);
+  } else if (dfcode != NULL && !tap_listeners_require_dissection()) {
+    /* If we've applied this filter, or one that this filter narrows down,
+       recently, we can use its results instead of dissecting some or all of
+       the frames.  We can't if tap listeners need to see every frame. */
+    dfresult = cf_dfilter_results_find(cf, cf->dfilter, &dfresult_exact);
+
+    /* If the filter only looks at the frame metadata, we can reject frames
+       without dissecting them; only the frames that pass get dissected,
+       so that we still find the frames they depend upon. */
+    frame_only = dfilter_is_frame_only(dfcode);
+  }
+
   if (redissect) {
     /* We need to re-initialize all the state information that protocols
        keep, because some preference that controls a dissector has changed,
        which might cause the state information to be constructed differently
-       by that dissector. */
+       by that dissector.
+
+       XXX - It would be nice to only redissect the frames that involve the
+       changed protocol and the frames depending on them.  However the state
+       is kept per capture file (conversations, reassembly tables and per
+       frame proto data of every protocol all live in wmem_file_scope()),
+       and a preference change such as a port number can make a protocol
+       show up in frames it wasn't seen in before, so all of it has to go. */
 
     /* We might receive new packets while redissecting, and we don't
        want to dissect those before their time. */
     cf->redissecting = TRUE;
 
+    /* What the first pass cache has may no longer be what the dissectors
+       would come up with, and the first pass starts over. */
+    cf_discard_cached_columns(cf, TRUE, TRUE);
+    cf->first_pass_frames = 0;
+
     /* 'reset' dissection session */
     epan_free(cf->epan);
     if (cf->edt && cf->edt->pi.fd) {
@@ -1779,6 +2267,10 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   frames_count = cf->count;
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
+  if (frame_only) {
+    epan_dissect_init(&frame_edt, cf->epan, TRUE, FALSE);
+    epan_dissect_set_frame_only(&frame_edt, TRUE);
+  }
 
   if (redissect) {
     /*
@@ -1824,6 +2316,14 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
         update_progress_dlg(progbar, progbar_val, status_str);
       }
 
+      /* Show the frames that have passed so far, rather than nothing
+         until the whole file has been filtered.  Not when redissecting,
+         as the packet list is being rebuilt then. */
+      if (!add_to_packet_list) {
+        packet_list_show_rescanned(framenum - 1);
+        rows_shown = TRUE;
+      }
+
       g_timer_start(prog_timer);
     }
 
@@ -1864,9 +2364,29 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->dependent_of_displayed = 0;
 
-    if (!cf_read_record(cf, fdata, &rec, &buf))
+    /* Do we already know the result for this frame?  We do if we have the
+       results of this very filter, or if the frame failed a filter that
+       this one narrows down. */
+    known = FALSE;
+    known_passed = FALSE;
+    if (dfresult != NULL && framenum <= dfresult->count) {
+      if (dfresult_exact) {
+        known = TRUE;
+        known_passed = DFILTER_RESULT_GET(dfresult->passed, framenum);
+        if (DFILTER_RESULT_GET(dfresult->depended_upon, framenum))
+          fdata->dependent_of_displayed = 1;
+      } else {
+        known = !DFILTER_RESULT_GET(dfresult->passed, framenum);
+      }
+    }
+
+    if (!known && !cf_read_record(cf, fdata, &rec, &buf))
       break; /* error reading the frame */
 
+    if (!known && frame_only)
+      known = !frame_metadata_passes_dfilter(fdata, cf, &frame_edt, dfcode,
+                                             &rec, &buf);
+
     /* If the previous frame is displayed, and we haven't yet seen the
        selected frame, remember that frame - it's the closest one we've
        yet seen before the selected frame. */
@@ -1875,9 +2395,13 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame = prev_frame;
     }
 
-    add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                                    cinfo, &rec, &buf,
-                                    add_to_packet_list);
+    if (known) {
+      add_known_packet_to_packet_list(fdata, cf, known_passed);
+    } else {
+      add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+                                      cinfo, &rec, &buf,
+                                      add_to_packet_list);
+    }
 
     /* If this frame is displayed, and this is the first frame we've
        seen displayed after the selected frame, remember this frame -
@@ -1899,7 +2423,13 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     prev_frame = fdata;
   }
 
+  /* If we got through all the frames, remember which ones passed. */
+  if (dfcode != NULL && framenum > frames_count)
+    cf_dfilter_results_save(cf, cf->dfilter, frames_count);
+
   epan_dissect_cleanup(&edt);
+  if (frame_only)
+    epan_dissect_cleanup(&frame_edt);
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
 
@@ -1929,9 +2459,14 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     destroy_progress_dlg(progbar);
   g_timer_destroy(prog_timer);
 
-  /* Unfreeze the packet list. */
-  if (!add_to_packet_list)
-    packet_list_recreate_visible_rows();
+  /* Unfreeze the packet list.  If we got through all the frames, the
+     rows shown so far only need the rest added to them. */
+  if (!add_to_packet_list) {
+    if (rows_shown && framenum > frames_count)
+      packet_list_show_rescanned(frames_count);
+    else
+      packet_list_recreate_visible_rows();
+  }
 
   /* Compute the time it took to filter the file */
   compute_elapsed(cf, start_time);
@@ -2103,6 +2638,15 @@ typedef enum {
   PSP_FAILED
 } psp_return_t;
 
+/*
+ * Once this many records in a row are each no more than
+ * READ_AHEAD_MAX_GAP bytes after the one before, we're going through
+ * the file in order, so have it read ahead; that's much faster than
+ * seeking to each record on compressed files and slow storage.
+ */
+#define READ_AHEAD_MIN_RUN  16
+#define READ_AHEAD_MAX_GAP  (256 * 1024)
+
 static psp_return_t
 process_specified_records(capture_file *cf, packet_range_t *range,
     const char *string1, const char *string2, gboolean terminate_is_stop,
@@ -2123,6 +2667,9 @@ process_specified_records(capture_file *cf, packet_range_t *range,
   float            progbar_val;
   gchar            progbar_status_str[100];
   range_process_e  process_this;
+  gint64           prev_off = -1;
+  guint            run = 0;
+  gboolean         reading_ahead = FALSE;
 
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
@@ -2202,6 +2749,19 @@ process_specified_records(capture_file *cf, packet_range_t *range,
       }
     }
 
+    if (!reading_ahead && cf->provider.wth != NULL) {
+      if (prev_off >= 0 && fdata->file_off > prev_off &&
+          fdata->file_off - prev_off <= READ_AHEAD_MAX_GAP)
+        run++;
+      else
+        run = 0;
+      prev_off = fdata->file_off;
+      if (run >= READ_AHEAD_MIN_RUN) {
+        wtap_set_seek_read_ahead(cf->provider.wth, TRUE);
+        reading_ahead = TRUE;
+      }
+    }
+
     /* Get the packet */
     if (!cf_read_record(cf, fdata, &rec, &buf)) {
       /* Attempt to get the packet failed. */
@@ -2216,6 +2776,9 @@ process_specified_records(capture_file *cf, packet_range_t *range,
     }
   }
 
+  if (reading_ahead && cf->provider.wth != NULL)
+    wtap_set_seek_read_ahead(cf->provider.wth, FALSE);
+
   /* We're done printing the packets; destroy the progress bar if
      it was created. */
   if (progbar != NULL)
@@ -3374,11 +3937,21 @@ match_narrow(capture_file *cf, frame_data *fdata,
   result = MR_NOTMATCHED;
   buf_len = fdata->cap_len;
   pd = ws_buffer_start_ptr(buf);
+
+  if (!cf->case_type) {
+    /* A case-sensitive search is a plain byte search. */
+    const guint8 *match = epan_memmem(pd, buf_len, ascii_text, (guint)textlen);
+    if (match) {
+      result = MR_MATCHED;
+      cf->search_pos = (guint32)(match - pd + textlen - 1);
+      cf->search_len = (guint32)textlen;
+    }
+    return result;
+  }
+
   i = 0;
   while (i < buf_len) {
-    c_char = pd[i];
-    if (cf->case_type)
-      c_char = g_ascii_toupper(c_char);
+    c_char = g_ascii_toupper(pd[i]);
     if (c_char == ascii_text[c_match]) {
       c_match += 1;
       if (c_match == textlen) {
@@ -3457,10 +4030,8 @@ match_binary(capture_file *cf, frame_data *fdata,
   const guint8 *binary_data = info->data;
   size_t        datalen     = info->data_len;
   match_result  result;
-  guint32       buf_len;
   guint8       *pd;
-  guint32       i;
-  size_t        c_match     = 0;
+  const guint8 *match;
 
   /* Load the frame's data. */
   if (!cf_read_record(cf, fdata, rec, buf)) {
@@ -3469,26 +4040,13 @@ match_binary(capture_file *cf, frame_data *fdata,
   }
 
   result = MR_NOTMATCHED;
-  buf_len = fdata->cap_len;
   pd = ws_buffer_start_ptr(buf);
-  i = 0;
-  while (i < buf_len) {
-    if (pd[i] == binary_data[c_match]) {
-      c_match += 1;
-      if (c_match == datalen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)datalen;
-        break;
-      }
-    }
-    else {
-      g_assert(i>=c_match);
-      i -= (guint32)c_match;
-      c_match = 0;
-    }
-    i += 1;
+  match = epan_memmem(pd, fdata->cap_len, binary_data, (guint)datalen);
+  if (match) {
+    result = MR_MATCHED;
+    cf->search_pos = (guint32)(match - pd + datalen - 1); /* Save the position of the last character
+                                                             for highlighting the field. */
+    cf->search_len = (guint32)datalen;
   }
   return result;
 }
@@ -3920,6 +4478,7 @@ cf_mark_frame(capture_file *cf, frame_data *frame)
 {
   if (! frame->marked) {
     frame->marked = TRUE;
+    cf_dfilter_results_clear(cf);
     if (cf->count > cf->marked_count)
       cf->marked_count++;
   }
@@ -3933,6 +4492,7 @@ cf_unmark_frame(capture_file *cf, frame_data *frame)
 {
   if (frame->marked) {
     frame->marked = FALSE;
+    cf_dfilter_results_clear(cf);
     if (cf->marked_count > 0)
       cf->marked_count--;
   }
@@ -3946,6 +4506,7 @@ cf_ignore_frame(capture_file *cf, frame_data *frame)
 {
   if (! frame->ignored) {
     frame->ignored = TRUE;
+    cf_dfilter_results_clear(cf);
     if (cf->count > cf->ignored_count)
       cf->ignored_count++;
   }
@@ -3959,6 +4520,7 @@ cf_unignore_frame(capture_file *cf, frame_data *frame)
 {
   if (frame->ignored) {
     frame->ignored = FALSE;
+    cf_dfilter_results_clear(cf);
     if (cf->ignored_count > 0)
       cf->ignored_count--;
   }
@@ -4052,6 +4614,7 @@ cf_set_user_packet_comment(capture_file *cf, frame_data *fd, const gchar *new_co
     cf->packet_comment_count++;
 
   cap_file_provider_set_user_comment(&cf->provider, fd, new_comment);
+  cf_dfilter_results_clear(cf);
 
   expert_update_comment_count(cf->packet_comment_count);
 
@@ -4146,7 +4709,9 @@ save_record(capture_file *cf, frame_data *fdata, wtap_rec *rec,
     pkt_comment = rec->opt_comment;
   new_rec.opt_comment  = g_strdup(pkt_comment);
   new_rec.has_comment_changed = fdata->has_user_comment ? TRUE : FALSE;
-  /* XXX - what if times have been shifted? */
+  /* Write what the packet list shows if the time has been shifted. */
+  if (fdata->has_shift_offset)
+    new_rec.ts = fdata->abs_ts;
 
   /* and save the packet */
   if (!wtap_dump(args->pdh, &new_rec, ws_buffer_start_ptr(buf), &err, &err_info)) {
@@ -4300,6 +4865,7 @@ rescan_file(capture_file *cf, const char *fname, gboolean is_tempfile)
     cfile_open_failure_alert_box(fname, err, err_info);
     return CF_READ_ERROR;
   }
+  cap_file_provider_init_record_cache(&cf->provider);
 
   /* We're scanning a file whose contents should be the same as what
      we had before, so we don't discard dissection state etc.. */
@@ -4697,6 +5263,7 @@ cf_save_records(capture_file *cf, const char *fname, guint save_format,
         cfile_open_failure_alert_box(fname, err, err_info);
         cf_close(cf);
       } else {
+        cap_file_provider_init_record_cache(&cf->provider);
         g_free(cf->filename);
         cf->filename = g_strdup(fname);
         cf->is_tempfile = FALSE;
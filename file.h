@@ -176,6 +176,31 @@ gboolean cf_read_record_no_alert(capture_file *cf, const frame_data *fdata,
  */
 gboolean cf_read_current_record(capture_file *cf);
 
+/**
+ * Fill in the columns of a record, and check that its coloring rule is
+ * still valid, from the first pass cache, without reading or dissecting
+ * the record.
+ *
+ * @param cf the capture file
+ * @param fdata the frame_data structure for the record in question
+ * @param cinfo the columns to fill in, or NULL if only the color is needed
+ * @param need_color TRUE if the record's coloring rule is needed
+ * @return TRUE if everything asked for came from the cache
+ */
+gboolean cf_get_cached_columns(capture_file *cf, const frame_data *fdata,
+                               column_info *cinfo, gboolean need_color);
+
+/**
+ * Stop using the column text and coloring rules of the first pass cache,
+ * because the columns or the coloring rules changed.
+ *
+ * @param cf the capture file
+ * @param columns TRUE to stop using the column text
+ * @param colors TRUE to stop using the coloring rules
+ */
+void cf_discard_cached_columns(capture_file *cf, gboolean columns,
+                               gboolean colors);
+
 /**
  * Read packets from the "end" of a capture file.
  *
@@ -8,10 +8,35 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#include <string.h>
+
 #include <glib.h>
 
+#include <wsutil/glib-compat.h>
+#include <wsutil/strtoi.h>
+
 #include "cfile.h"
 
+/* Default size of the record cache, in KiB. */
+#define RECORD_CACHE_DEFAULT_SIZE (16 * 1024)
+
+typedef struct {
+  guint32   num;        /* Frame number */
+  gint64    file_off;   /* Offset the record was read from */
+  wtap_rec  rec;
+  guint8   *data;
+  guint32   data_len;
+  gsize     size;       /* What the record counts against the budget */
+  GList     link;       /* In record_cache.lru */
+} record_cache_entry_t;
+
+struct record_cache {
+  GHashTable *records;  /* Frame number -> record_cache_entry_t */
+  GQueue      lru;      /* Most recently used first */
+  gsize       budget;
+  record_cache_stats_t stats;
+};
+
 static int
 frame_cmp(gconstpointer a, gconstpointer b, gpointer user_data _U_)
 {
@@ -90,3 +115,218 @@ cap_file_provider_set_user_comment(struct packet_provider_data *prov, frame_data
 
   fd->has_user_comment = TRUE;
 }
+
+/*
+ * Copy the metadata of a record, keeping the allocations that "dst"
+ * already has, as wtap_seek_read() does.  The options buffer is only
+ * scratch space for the reader, so it isn't copied.
+ */
+static void
+record_cache_copy_rec(wtap_rec *dst, const wtap_rec *src)
+{
+  gchar *opt_comment = dst->opt_comment;
+  GPtrArray *packet_verdict = dst->packet_verdict;
+  Buffer options_buf = dst->options_buf;
+  guint i;
+
+  *dst = *src;
+  dst->options_buf = options_buf;
+
+  g_free(opt_comment);
+  dst->opt_comment = g_strdup(src->opt_comment);
+
+  if (packet_verdict != NULL)
+    g_ptr_array_set_size(packet_verdict, 0);
+  if (src->packet_verdict != NULL && src->packet_verdict->len > 0) {
+    if (packet_verdict == NULL)
+      packet_verdict = g_ptr_array_new_with_free_func((GDestroyNotify) g_bytes_unref);
+    for (i = 0; i < src->packet_verdict->len; i++)
+      g_ptr_array_add(packet_verdict, g_bytes_ref((GBytes *) g_ptr_array_index(src->packet_verdict, i)));
+  }
+  dst->packet_verdict = packet_verdict;
+}
+
+/*
+ * How many bytes of data wtap_seek_read() put in the buffer for a record
+ * (as frame_data_init() works out cap_len).  FALSE for records we don't
+ * know the length of, which aren't cached.
+ */
+static gboolean
+record_cache_data_len(const wtap_rec *rec, guint32 *data_len)
+{
+  switch (rec->rec_type) {
+
+  case REC_TYPE_PACKET:
+    *data_len = rec->rec_header.packet_header.caplen;
+    return TRUE;
+
+  case REC_TYPE_FT_SPECIFIC_EVENT:
+  case REC_TYPE_FT_SPECIFIC_REPORT:
+    *data_len = rec->rec_header.ft_specific_header.record_len;
+    return TRUE;
+
+  case REC_TYPE_SYSCALL:
+    *data_len = rec->rec_header.syscall_header.event_filelen;
+    return TRUE;
+
+  case REC_TYPE_SYSTEMD_JOURNAL:
+    *data_len = rec->rec_header.systemd_journal_header.record_len;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+static void
+record_cache_entry_free(gpointer data)
+{
+  record_cache_entry_t *entry = (record_cache_entry_t *) data;
+
+  wtap_rec_cleanup(&entry->rec);
+  g_free(entry->data);
+  g_free(entry);
+}
+
+static void
+record_cache_remove(struct record_cache *cache, record_cache_entry_t *entry)
+{
+  g_queue_unlink(&cache->lru, &entry->link);
+  cache->stats.bytes -= entry->size;
+  cache->stats.records--;
+  g_hash_table_remove(cache->records, GUINT_TO_POINTER(entry->num));
+}
+
+static void
+record_cache_insert(struct record_cache *cache, guint32 framenum, gint64 file_off,
+                    const wtap_rec *rec, const Buffer *buf)
+{
+  record_cache_entry_t *entry;
+  guint32 data_len;
+  gsize size;
+  guint i;
+
+  if (!record_cache_data_len(rec, &data_len))
+    return;
+
+  size = sizeof(record_cache_entry_t) + data_len;
+  if (rec->opt_comment != NULL)
+    size += strlen(rec->opt_comment) + 1;
+  if (rec->packet_verdict != NULL) {
+    for (i = 0; i < rec->packet_verdict->len; i++)
+      size += g_bytes_get_size((GBytes *) g_ptr_array_index(rec->packet_verdict, i));
+  }
+
+  /* Don't let one huge record push out everything else. */
+  if (size > cache->budget / 4)
+    return;
+
+  entry = (record_cache_entry_t *) g_hash_table_lookup(cache->records, GUINT_TO_POINTER(framenum));
+  if (entry != NULL)
+    record_cache_remove(cache, entry);
+
+  while (cache->stats.bytes + size > cache->budget && cache->lru.tail != NULL) {
+    record_cache_remove(cache, (record_cache_entry_t *) cache->lru.tail->data);
+    cache->stats.evictions++;
+  }
+
+  entry = g_new0(record_cache_entry_t, 1);
+  entry->num = framenum;
+  entry->file_off = file_off;
+  wtap_rec_init(&entry->rec);
+  record_cache_copy_rec(&entry->rec, rec);
+  entry->data = (guint8 *) g_memdup2(ws_buffer_start_ptr(buf), data_len);
+  entry->data_len = data_len;
+  entry->size = size;
+  entry->link.data = entry;
+
+  g_hash_table_insert(cache->records, GUINT_TO_POINTER(framenum), entry);
+  g_queue_push_head_link(&cache->lru, &entry->link);
+  cache->stats.bytes += size;
+  cache->stats.records++;
+}
+
+void
+cap_file_provider_init_record_cache(struct packet_provider_data *prov)
+{
+  const char *env;
+  guint32 size_kb = RECORD_CACHE_DEFAULT_SIZE;
+
+  cap_file_provider_free_record_cache(prov);
+
+  env = g_getenv("WIRESHARK_RECORD_CACHE_SIZE");
+  if (env && !ws_strtou32(env, NULL, &size_kb))
+    size_kb = RECORD_CACHE_DEFAULT_SIZE;
+  if (size_kb == 0)
+    return;
+
+  prov->rec_cache = g_new0(struct record_cache, 1);
+  prov->rec_cache->records = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, record_cache_entry_free);
+  g_queue_init(&prov->rec_cache->lru);
+  prov->rec_cache->budget = (gsize) size_kb * 1024;
+}
+
+void
+cap_file_provider_free_record_cache(struct packet_provider_data *prov)
+{
+  struct record_cache *cache = prov->rec_cache;
+  guint64 lookups;
+
+  if (cache == NULL)
+    return;
+
+  lookups = cache->stats.hits + cache->stats.misses;
+  if (lookups > 0) {
+    g_debug("Record cache: %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT " misses (%.1f%% hit rate), %" G_GUINT64_FORMAT " evictions",
+            cache->stats.hits, cache->stats.misses, 100.0 * (double) cache->stats.hits / (double) lookups,
+            cache->stats.evictions);
+  }
+
+  g_hash_table_destroy(cache->records);
+  g_free(cache);
+  prov->rec_cache = NULL;
+}
+
+/*
+ * Read the record for frame "framenum", at "file_off", from the cache or,
+ * failing that, with wtap_seek_read().
+ */
+gboolean
+cap_file_provider_read_record(const struct packet_provider_data *prov, guint32 framenum, gint64 file_off,
+                              wtap_rec *rec, Buffer *buf, int *err, gchar **err_info)
+{
+  struct record_cache *cache = prov->rec_cache;
+  record_cache_entry_t *entry;
+
+  if (cache != NULL) {
+    entry = (record_cache_entry_t *) g_hash_table_lookup(cache->records, GUINT_TO_POINTER(framenum));
+    if (entry != NULL && entry->file_off == file_off) {
+      cache->stats.hits++;
+      g_queue_unlink(&cache->lru, &entry->link);
+      g_queue_push_head_link(&cache->lru, &entry->link);
+
+      record_cache_copy_rec(rec, &entry->rec);
+      ws_buffer_assure_space(buf, entry->data_len);
+      memcpy(ws_buffer_start_ptr(buf), entry->data, entry->data_len);
+      *err = 0;
+      *err_info = NULL;
+      return TRUE;
+    }
+    cache->stats.misses++;
+  }
+
+  if (!wtap_seek_read(prov->wth, file_off, rec, buf, err, err_info))
+    return FALSE;
+
+  if (cache != NULL)
+    record_cache_insert(cache, framenum, file_off, rec, buf);
+  return TRUE;
+}
+
+gboolean
+cap_file_provider_get_record_cache_stats(const struct packet_provider_data *prov, record_cache_stats_t *stats)
+{
+  if (prov->rec_cache == NULL)
+    return FALSE;
+
+  *stats = prov->rec_cache->stats;
+  return TRUE;
+}
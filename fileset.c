@@ -202,44 +202,91 @@ fileset_update_file(const char *path)
     }
 }
 
-/* we know this file is part of the set, so add it */
-static fileset_entry *
-fileset_add_file(const char *dirname, const char *fname, gboolean current)
+/*
+ * Directories with at least this many files of the set get their files
+ * looked at by a pool of threads; stat()ing tens of thousands of files
+ * of a ring buffer one after the other takes a while, especially on a
+ * network file system.
+ */
+#define FILESET_STAT_THREADED_MIN   64
+
+/* Get the time and size of this file, or set its size to -1 if we can't */
+static void
+fileset_stat_entry(gpointer data, gpointer user_data _U_)
 {
-    int fh, result;
+    fileset_entry *entry = (fileset_entry *)data;
     ws_statb64 buf;
-    char *path;
-    fileset_entry *entry = NULL;
 
+    if (ws_stat64(entry->fullname, &buf) == 0) {
+        entry->ctime    = ST_CREATE_TIME(buf);
+        entry->mtime    = buf.st_mtime;
+        entry->size     = buf.st_size;
+    } else {
+        entry->size     = -1;
+    }
+}
 
-    path = g_strdup_printf("%s%s", dirname, fname);
+static fileset_entry *
+fileset_entry_new(const char *dirname, const char *fname, gboolean current)
+{
+    fileset_entry *entry;
 
-    fh = ws_open( path, O_RDONLY, 0000 /* no creation so don't matter */);
-    if(fh !=  -1) {
+    entry = g_new(fileset_entry, 1);
 
-        /* Get statistics */
-        result = ws_fstat64( fh, &buf );
+    entry->fullname = g_strdup_printf("%s%s", dirname, fname);
+    entry->name     = g_strdup(fname);
+    entry->ctime    = 0;
+    entry->mtime    = 0;
+    entry->size     = 0;
+    entry->current  = current;
 
-        /* Show statistics if they are valid */
-        if( result == 0 ) {
-            entry = g_new(fileset_entry, 1);
+    return entry;
+}
 
-            entry->fullname = g_strdup(path);
-            entry->name     = g_strdup(fname);
-            entry->ctime    = ST_CREATE_TIME(buf);
-            entry->mtime    = buf.st_mtime;
-            entry->size     = buf.st_size;
-            entry->current  = current;
+static void fileset_entry_delete(gpointer data, gpointer user_data _U_);
 
-            set.entries = g_list_append(set.entries, entry);
-        }
+/*
+ * Get the times and sizes of all the files of our list, and remove the
+ * ones we couldn't look at.
+ */
+static void
+fileset_stat_entries(void)
+{
+    GThreadPool *pool = NULL;
+    GList *le, *next;
 
-        ws_close(fh);
+    if (g_list_length(set.entries) >= FILESET_STAT_THREADED_MIN)
+        pool = g_thread_pool_new(fileset_stat_entry, NULL,
+                                 g_get_num_processors(), TRUE, NULL);
+
+    for (le = set.entries; le != NULL; le = g_list_next(le)) {
+        if (pool == NULL || !g_thread_pool_push(pool, le->data, NULL))
+            fileset_stat_entry(le->data, NULL);
+    }
+    if (pool != NULL) {
+        /* wait for all of them to be done */
+        g_thread_pool_free(pool, FALSE, TRUE);
     }
 
-    g_free(path);
+    for (le = set.entries; le != NULL; le = next) {
+        next = g_list_next(le);
+        if (((fileset_entry *)le->data)->size == -1) {
+            fileset_entry_delete(le->data, NULL);
+            set.entries = g_list_delete_link(set.entries, le);
+        }
+    }
+}
 
-    return entry;
+/* we know this file is part of the set, so add it */
+static void
+fileset_add_file(const char *dirname, const char *fname, gboolean current)
+{
+    /*
+     * Prepend rather than append, so that adding all the files of a big
+     * set isn't quadratic; the list gets sorted afterwards anyway.
+     */
+    set.entries = g_list_prepend(set.entries,
+                                 fileset_entry_new(dirname, fname, current));
 }
 
 
@@ -279,6 +326,7 @@ fileset_add_dir(const char *fname, void *window)
     const char    *name;
     GString       *dirname;
     gchar         *fname_dup;
+    const char    *basename = get_basename(fname);
 
 
     /* get (convert) directory name, but don't touch the given string */
@@ -296,8 +344,8 @@ fileset_add_dir(const char *fname, void *window)
         if ((dir = ws_dir_open(dirname->str, 0, NULL)) != NULL) {
             while ((file = ws_dir_read_name(dir)) != NULL) {
                 name = ws_dir_get_name(file);
-                if(fileset_filename_match_pattern(name) && fileset_is_file_in_set(name, get_basename(fname))) {
-                    fileset_add_file(dirname->str, name, strcmp(name, get_basename(fname))== 0 /* current */);
+                if(fileset_filename_match_pattern(name) && fileset_is_file_in_set(name, basename)) {
+                    fileset_add_file(dirname->str, name, strcmp(name, basename)== 0 /* current */);
                 }
             } /* while */
 
@@ -305,12 +353,14 @@ fileset_add_dir(const char *fname, void *window)
         } /* if */
     } else {
         /* no, this is a "standalone file", just add this one */
-        fileset_add_file(dirname->str, get_basename(fname), TRUE /* current */);
+        fileset_add_file(dirname->str, basename, TRUE /* current */);
         /* don't add the file to the dialog here, this will be done in fileset_update_dlg() below */
     }
 
     g_string_free(dirname, TRUE /* free_segment */);
 
+    fileset_stat_entries();
+
     /* sort entries by creation time */
     set.entries = g_list_sort(set.entries, fileset_sort_compare);
 
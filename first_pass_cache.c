@@ -0,0 +1,824 @@
+/* first_pass_cache.c
+ * Routines for an on-disk cache of the first pass through a capture file.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/filesystem.h>
+
+#include <epan/addr_resolv.h>
+#include <epan/color_filters.h>
+#include <epan/column.h>
+#include <epan/column-utils.h>
+#include <epan/prefs.h>
+#include <epan/prefs-int.h>
+#include <epan/timestamp.h>
+
+#include "first_pass_cache.h"
+
+/*
+ * A cache is two files in the cache directory, named after the SHA-256
+ * hash of everything the first pass depends on (see compute_key()):
+ *
+ *   <key>.fpc holds an fp_cache_header_t, the link-layer types of the
+ *   file, an fp_cache_frame_t for every frame and, if there is column
+ *   text, the offset of every frame's text in the other file;
+ *
+ *   <key>.fpt holds the text of the columns of every frame, as one
+ *   NUL-terminated string per column.
+ *
+ * Both are only ever read back by the program that wrote them, on the same
+ * machine, as the version is part of the key, so they're written in host
+ * byte order and layout; the header records enough to notice if that
+ * isn't so.
+ */
+
+/* Bump this whenever the layout of the files changes. */
+#define FP_CACHE_FORMAT_VERSION 1
+
+#define FP_CACHE_MAGIC          "WSFPC\r\n\032"
+#define FP_CACHE_BYTE_ORDER     0x01020304
+#define FP_CACHE_KEY_LEN        32      /* SHA-256 */
+
+/* How many frame records are read at a time. */
+#define FP_CACHE_CHUNK          4096
+
+typedef struct {
+  char     magic[8];
+  guint32  byte_order;
+  guint32  format_version;
+  guint32  header_size;          /* sizeof (fp_cache_header_t) */
+  guint32  frame_size;           /* sizeof (fp_cache_frame_t) */
+  guint8   key[FP_CACHE_KEY_LEN];
+  guint32  num_frames;
+  guint32  num_idbs;             /* Interfaces known after the first pass */
+  gint32   lnk_t;
+  guint32  num_linktypes;
+  guint32  num_colors;           /* Entries in the color filter list */
+  guint32  num_cols;             /* Columns of text per frame, 0 if none */
+  guint64  packet_comment_count;
+  gint64   f_datalen;
+} fp_cache_header_t;
+
+#define FP_FRAME_HAS_TS                 0x0001
+#define FP_FRAME_HAS_PHDR_COMMENT       0x0002
+#define FP_FRAME_ENCODING_EBCDIC        0x0004
+
+typedef struct {
+  gint64   file_off;
+  gint64   secs;
+  gint32   nsecs;
+  guint32  pkt_len;
+  guint32  cap_len;
+  guint32  color;                /* 1 + index in the color filter list, 0 if none */
+  guint16  flags;                /* FP_FRAME_ flags */
+  guint16  tsprec;
+  guint32  padding;
+} fp_cache_frame_t;
+
+struct first_pass_cache {
+  char        *path;             /* Cache file name, without extension */
+  guint8       key[FP_CACHE_KEY_LEN];
+  GPtrArray   *colors;           /* Clones of the color filter list */
+  gboolean     colors_valid;     /* TRUE if the frames' coloring rules can be used */
+
+  /* Column text of a loaded cache. */
+  GMappedFile *text;
+  guint64     *text_offsets;
+  guint32      text_frames;
+  guint32      num_cols;
+
+  /* State while recording the first pass. */
+  gboolean     recording;
+  GArray      *frames;           /* of fp_cache_frame_t */
+  GHashTable  *color_index;      /* color_filter_t * -> 1 + index in colors */
+  FILE        *text_fh;          /* Column text, if recorded */
+  char        *text_tmp_path;
+  GArray      *rec_text_offsets; /* of guint64 */
+  guint64      text_len;
+  guint32      rec_num_cols;
+};
+
+static void stop_recording(first_pass_cache_t *fpc);
+
+static void
+add_color_clone(color_filter_t *colorf, gpointer user_data)
+{
+  g_ptr_array_add((GPtrArray *)user_data, colorf);
+}
+
+static void
+free_color_clone(gpointer data)
+{
+  color_filter_delete((color_filter_t *)data);
+}
+
+/*
+ * Everything that goes into the key.  Each value is followed by something
+ * that can't be part of it (a NUL for strings, fixed sizes for numbers),
+ * so that different inputs can't run together into the same stream.
+ */
+static void
+key_add_string(GChecksum *sum, const char *str)
+{
+  if (str == NULL)
+    str = "";
+  g_checksum_update(sum, (const guchar *)str, strlen(str) + 1);
+}
+
+static void
+key_add_uint64(GChecksum *sum, guint64 val)
+{
+  g_checksum_update(sum, (const guchar *)&val, sizeof val);
+}
+
+static guint
+key_add_pref(pref_t *pref, gpointer user_data)
+{
+  char *str = prefs_pref_to_str(pref, pref_current);
+
+  key_add_string((GChecksum *)user_data, str);
+  g_free(str);
+  return 0;
+}
+
+static guint
+key_add_module(module_t *module, gpointer user_data)
+{
+  GChecksum *sum = (GChecksum *)user_data;
+
+  key_add_string(sum, module->name);
+  prefs_pref_foreach(module, key_add_pref, sum);
+  if (prefs_module_has_submodules(module))
+    return prefs_modules_foreach_submodules(module, key_add_module, sum);
+  return 0;
+}
+
+static gint
+compare_names(gconstpointer a, gconstpointer b)
+{
+  return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+/*
+ * The files in the profile directory: UATs, decode as entries, enabled and
+ * disabled protocols, name resolution files and so on.  The "recent" files
+ * change every time Wireshark exits, and what in them matters (the time
+ * stamp format and name resolution) is added separately.
+ *
+ * XXX - files in the global configuration directory are not included.
+ */
+static void
+key_add_config_files(GChecksum *sum)
+{
+  char        *dir = get_profile_dir(get_profile_name(), FALSE);
+  GDir        *gdir;
+  const char  *name;
+  GPtrArray   *names = g_ptr_array_new_with_free_func(g_free);
+  guint        i;
+
+  gdir = g_dir_open(dir, 0, NULL);
+  if (gdir != NULL) {
+    while ((name = g_dir_read_name(gdir)) != NULL) {
+      if (!g_str_has_prefix(name, "recent"))
+        g_ptr_array_add(names, g_strdup(name));
+    }
+    g_dir_close(gdir);
+  }
+  g_ptr_array_sort(names, compare_names);
+
+  for (i = 0; i < names->len; i++) {
+    char  *path = g_build_filename(dir, (const char *)g_ptr_array_index(names, i), NULL);
+    gchar *contents;
+    gsize  len;
+
+    if (g_file_test(path, G_FILE_TEST_IS_REGULAR) &&
+        g_file_get_contents(path, &contents, &len, NULL)) {
+      key_add_string(sum, (const char *)g_ptr_array_index(names, i));
+      key_add_uint64(sum, len);
+      g_checksum_update(sum, (const guchar *)contents, len);
+      g_free(contents);
+    }
+    g_free(path);
+  }
+
+  g_ptr_array_free(names, TRUE);
+  g_free(dir);
+}
+
+static gboolean
+compute_key(capture_file *cf, GPtrArray *colors, guint8 *key)
+{
+  ws_statb64  st;
+  char       *abs_name;
+  char       *cwd;
+  GChecksum  *sum;
+  gsize       len = FP_CACHE_KEY_LEN;
+  guint       i;
+
+  if (ws_stat64(cf->filename, &st) != 0)
+    return FALSE;
+
+  sum = g_checksum_new(G_CHECKSUM_SHA256);
+
+  key_add_uint64(sum, FP_CACHE_FORMAT_VERSION);
+  key_add_string(sum, VERSION);
+
+  /* The file. */
+  if (g_path_is_absolute(cf->filename)) {
+    abs_name = g_strdup(cf->filename);
+  } else {
+    cwd = g_get_current_dir();
+    abs_name = g_build_filename(cwd, cf->filename, NULL);
+    g_free(cwd);
+  }
+  key_add_string(sum, abs_name);
+  g_free(abs_name);
+  key_add_uint64(sum, (guint64)st.st_size);
+  key_add_uint64(sum, (guint64)st.st_mtime);
+  key_add_uint64(sum, cf->open_type);
+  key_add_uint64(sum, cf->cd_t);
+
+  /* How it's dissected and shown. */
+  key_add_string(sum, get_profile_name());
+  prefs_modules_foreach_submodules(NULL, key_add_module, sum);
+  key_add_config_files(sum);
+  key_add_uint64(sum, timestamp_get_type());
+  key_add_uint64(sum, (guint64)timestamp_get_precision());
+  key_add_uint64(sum, timestamp_get_seconds_type());
+  key_add_uint64(sum, gbl_resolv_flags.mac_name);
+  key_add_uint64(sum, gbl_resolv_flags.network_name);
+  key_add_uint64(sum, gbl_resolv_flags.transport_name);
+  key_add_uint64(sum, gbl_resolv_flags.dns_pkt_addr_resolution);
+  key_add_uint64(sum, gbl_resolv_flags.use_external_net_name_resolver);
+  key_add_uint64(sum, gbl_resolv_flags.vlan_name);
+  key_add_uint64(sum, gbl_resolv_flags.ss7pc_name);
+
+  /* How it's colored. */
+  for (i = 0; i < colors->len; i++) {
+    color_filter_t *colorf = (color_filter_t *)g_ptr_array_index(colors, i);
+
+    key_add_string(sum, colorf->filter_name);
+    key_add_string(sum, colorf->filter_text);
+    key_add_uint64(sum, ((guint64)colorf->fg_color.red << 32) |
+                        ((guint64)colorf->fg_color.green << 16) |
+                        colorf->fg_color.blue);
+    key_add_uint64(sum, ((guint64)colorf->bg_color.red << 32) |
+                        ((guint64)colorf->bg_color.green << 16) |
+                        colorf->bg_color.blue);
+    key_add_uint64(sum, colorf->disabled);
+  }
+
+  g_checksum_get_digest(sum, key, &len);
+  g_checksum_free(sum);
+  return len == FP_CACHE_KEY_LEN;
+}
+
+first_pass_cache_t *
+first_pass_cache_new(capture_file *cf)
+{
+  const char         *dir;
+  first_pass_cache_t *fpc;
+  char                hex[FP_CACHE_KEY_LEN * 2 + 1];
+  guint               i;
+
+  dir = g_getenv("WIRESHARK_FIRST_PASS_CACHE_DIR");
+  if (dir == NULL || *dir == '\0' || test_for_directory(dir) != EISDIR)
+    return NULL;
+
+  /* A capture that's being written, or that will be removed when it's
+     closed, isn't worth caching. */
+  if (cf->is_tempfile)
+    return NULL;
+
+  /* Skipping the sequential read is only safe for formats whose random
+     access reader doesn't depend on state that the sequential read builds
+     up, and only fast for files that can be read at random without it
+     having recorded where to resume decompressing. */
+  if (cf->cd_t != wtap_pcap_file_type_subtype() &&
+      cf->cd_t != wtap_pcap_nsec_file_type_subtype() &&
+      cf->cd_t != wtap_pcapng_file_type_subtype())
+    return NULL;
+  if (wtap_get_compression_type(cf->provider.wth) != WTAP_UNCOMPRESSED)
+    return NULL;
+
+  fpc = g_new0(first_pass_cache_t, 1);
+  fpc->colors = g_ptr_array_new_with_free_func(free_color_clone);
+  color_filters_clone(fpc->colors, add_color_clone);
+  if (!compute_key(cf, fpc->colors, fpc->key)) {
+    first_pass_cache_free(fpc);
+    return NULL;
+  }
+  for (i = 0; i < FP_CACHE_KEY_LEN; i++)
+    g_snprintf(&hex[i * 2], 3, "%02x", fpc->key[i]);
+  fpc->path = g_build_filename(dir, hex, NULL);
+
+  return fpc;
+}
+
+static gboolean
+read_fully(FILE *fh, void *buf, size_t len)
+{
+  return len == 0 || fread(buf, 1, len, fh) == len;
+}
+
+/*
+ * Map the column text file and check that every frame's text lies within
+ * it.  Returns FALSE if there's no usable text; the frames can still be
+ * used without it.
+ */
+static gboolean
+load_text(first_pass_cache_t *fpc, FILE *fh, guint32 num_frames, guint32 num_cols)
+{
+  char    *text_path = g_strdup_printf("%s.fpt", fpc->path);
+  guint64 *offsets;
+  gsize    text_len;
+  guint32  i;
+
+  fpc->text = g_mapped_file_new(text_path, FALSE, NULL);
+  g_free(text_path);
+  if (fpc->text == NULL)
+    return FALSE;
+
+  text_len = g_mapped_file_get_length(fpc->text);
+  offsets = g_new(guint64, num_frames);
+  if (!read_fully(fh, offsets, (size_t)num_frames * sizeof (guint64)))
+    goto fail;
+  for (i = 0; i < num_frames; i++) {
+    if (offsets[i] >= text_len)
+      goto fail;
+  }
+  /* The last string must be terminated, so that reading the text of any
+     frame stops within the file. */
+  if (text_len == 0 || g_mapped_file_get_contents(fpc->text)[text_len - 1] != '\0')
+    goto fail;
+
+  fpc->text_offsets = offsets;
+  fpc->text_frames = num_frames;
+  fpc->num_cols = num_cols;
+  return TRUE;
+
+fail:
+  g_free(offsets);
+  g_mapped_file_unref(fpc->text);
+  fpc->text = NULL;
+  return FALSE;
+}
+
+gboolean
+first_pass_cache_load(first_pass_cache_t *fpc, capture_file *cf,
+                      guint num_idbs, guint32 max_frames)
+{
+  char              *cache_path;
+  FILE              *fh;
+  ws_statb64         st;
+  fp_cache_header_t  hdr;
+  gint32            *linktypes = NULL;
+  fp_cache_frame_t  *chunk;
+  guint64            expected_size;
+  guint32            framenum;
+  guint32            i, n;
+  gboolean           ok = FALSE;
+
+  cache_path = g_strdup_printf("%s.fpc", fpc->path);
+  fh = ws_fopen(cache_path, "rb");
+  g_free(cache_path);
+  if (fh == NULL)
+    return FALSE;
+
+  if (!read_fully(fh, &hdr, sizeof hdr) ||
+      memcmp(hdr.magic, FP_CACHE_MAGIC, sizeof hdr.magic) != 0 ||
+      hdr.byte_order != FP_CACHE_BYTE_ORDER ||
+      hdr.format_version != FP_CACHE_FORMAT_VERSION ||
+      hdr.header_size != sizeof (fp_cache_header_t) ||
+      hdr.frame_size != sizeof (fp_cache_frame_t) ||
+      memcmp(hdr.key, fpc->key, FP_CACHE_KEY_LEN) != 0 ||
+      hdr.num_idbs != num_idbs ||
+      hdr.num_frames > max_frames ||
+      hdr.num_colors != fpc->colors->len) {
+    fclose(fh);
+    return FALSE;
+  }
+
+  /* Catch a cache that was cut short. */
+  expected_size = sizeof hdr +
+                  (guint64)hdr.num_linktypes * sizeof (gint32) +
+                  (guint64)hdr.num_frames * sizeof (fp_cache_frame_t) +
+                  (hdr.num_cols != 0 ? (guint64)hdr.num_frames * sizeof (guint64) : 0);
+  if (ws_fstat64(ws_fileno(fh), &st) != 0 || (guint64)st.st_size != expected_size) {
+    fclose(fh);
+    return FALSE;
+  }
+
+  linktypes = g_new(gint32, hdr.num_linktypes);
+  if (!read_fully(fh, linktypes, hdr.num_linktypes * sizeof (gint32))) {
+    g_free(linktypes);
+    fclose(fh);
+    return FALSE;
+  }
+
+  chunk = g_new(fp_cache_frame_t, FP_CACHE_CHUNK);
+  for (framenum = 0; framenum < hdr.num_frames; framenum += n) {
+    n = MIN(hdr.num_frames - framenum, FP_CACHE_CHUNK);
+    if (!read_fully(fh, chunk, n * sizeof (fp_cache_frame_t)))
+      goto done;
+    for (i = 0; i < n; i++) {
+      fp_cache_frame_t *frec = &chunk[i];
+      frame_data        fdlocal;
+      wtap_rec          rec;
+
+      if (frec->color > fpc->colors->len || frec->tsprec > 0xF)
+        goto done;
+
+      /* frame_data_init() takes what it needs from a record. */
+      memset(&rec, 0, sizeof rec);
+      rec.rec_type = REC_TYPE_PACKET;
+      rec.presence_flags = (frec->flags & FP_FRAME_HAS_TS) ? WTAP_HAS_TS : 0;
+      rec.tsprec = frec->tsprec;
+      rec.ts.secs = (time_t)frec->secs;
+      rec.ts.nsecs = frec->nsecs;
+      rec.rec_header.packet_header.len = frec->pkt_len;
+      rec.rec_header.packet_header.caplen = frec->cap_len;
+      frame_data_init(&fdlocal, cf->count + 1, &rec, frec->file_off, 0);
+      fdlocal.has_phdr_comment = (frec->flags & FP_FRAME_HAS_PHDR_COMMENT) ? 1 : 0;
+      if (frec->flags & FP_FRAME_ENCODING_EBCDIC)
+        fdlocal.encoding = PACKET_CHAR_ENC_CHAR_EBCDIC;
+      if (frec->color != 0)
+        fdlocal.color_filter = (const color_filter_t *)g_ptr_array_index(fpc->colors, frec->color - 1);
+
+      frame_data_sequence_add(cf->provider.frames, &fdlocal);
+      cf->count++;
+    }
+  }
+
+  if (hdr.num_cols != 0)
+    load_text(fpc, fh, hdr.num_frames, hdr.num_cols);
+
+  for (i = 0; i < hdr.num_linktypes; i++) {
+    int encap = linktypes[i];
+
+    g_array_append_val(cf->linktypes, encap);
+  }
+  cf->lnk_t = hdr.lnk_t;
+  cf->packet_comment_count = hdr.packet_comment_count;
+  cf->f_datalen = hdr.f_datalen;
+  fpc->colors_valid = TRUE;
+  ok = TRUE;
+
+done:
+  if (!ok) {
+    /* Take back the frames added so far. */
+    free_frame_data_sequence(cf->provider.frames);
+    cf->provider.frames = new_frame_data_sequence();
+    cf->count = 0;
+  }
+  g_free(chunk);
+  g_free(linktypes);
+  fclose(fh);
+  return ok;
+}
+
+void
+first_pass_cache_record(first_pass_cache_t *fpc, column_info *cinfo)
+{
+  stop_recording(fpc);
+
+  fpc->recording = TRUE;
+  fpc->frames = g_array_new(FALSE, FALSE, sizeof (fp_cache_frame_t));
+  fpc->color_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  if (cinfo != NULL && cinfo->num_cols > 0) {
+    fpc->text_tmp_path = g_strdup_printf("%s.fpt.tmp", fpc->path);
+    fpc->text_fh = ws_fopen(fpc->text_tmp_path, "wb");
+    if (fpc->text_fh != NULL) {
+      fpc->rec_text_offsets = g_array_new(FALSE, FALSE, sizeof (guint64));
+      fpc->rec_num_cols = cinfo->num_cols;
+      fpc->text_len = 0;
+    }
+  }
+}
+
+gboolean
+first_pass_cache_recording(first_pass_cache_t *fpc)
+{
+  return fpc != NULL && fpc->recording;
+}
+
+/*
+ * The index of a coloring rule in the cloned color filter list, plus one.
+ * The frames point to the rules in the live list, which have the same
+ * names and filters as their clones.
+ */
+static guint32
+color_index(first_pass_cache_t *fpc, const color_filter_t *colorf)
+{
+  gpointer idx;
+  guint    i;
+
+  if (colorf == NULL)
+    return 0;
+  if (g_hash_table_lookup_extended(fpc->color_index, colorf, NULL, &idx))
+    return GPOINTER_TO_UINT(idx);
+
+  idx = GUINT_TO_POINTER(0);
+  for (i = 0; i < fpc->colors->len; i++) {
+    const color_filter_t *clone = (const color_filter_t *)g_ptr_array_index(fpc->colors, i);
+
+    if (g_strcmp0(clone->filter_name, colorf->filter_name) == 0 &&
+        g_strcmp0(clone->filter_text, colorf->filter_text) == 0) {
+      idx = GUINT_TO_POINTER(i + 1);
+      break;
+    }
+  }
+  g_hash_table_insert(fpc->color_index, (gpointer)colorf, idx);
+  return GPOINTER_TO_UINT(idx);
+}
+
+void
+first_pass_cache_add(first_pass_cache_t *fpc, const frame_data *fdata,
+                     column_info *cinfo)
+{
+  fp_cache_frame_t frec;
+  gint             col;
+
+  if (!first_pass_cache_recording(fpc))
+    return;
+
+  memset(&frec, 0, sizeof frec);
+  frec.file_off = fdata->file_off;
+  frec.secs = (gint64)fdata->abs_ts.secs;
+  frec.nsecs = fdata->abs_ts.nsecs;
+  frec.pkt_len = fdata->pkt_len;
+  frec.cap_len = fdata->cap_len;
+  frec.color = color_index(fpc, fdata->color_filter);
+  if (fdata->has_ts)
+    frec.flags |= FP_FRAME_HAS_TS;
+  if (fdata->has_phdr_comment)
+    frec.flags |= FP_FRAME_HAS_PHDR_COMMENT;
+  if (fdata->encoding == PACKET_CHAR_ENC_CHAR_EBCDIC)
+    frec.flags |= FP_FRAME_ENCODING_EBCDIC;
+  frec.tsprec = fdata->tsprec;
+  g_array_append_val(fpc->frames, frec);
+
+  if (fpc->text_fh == NULL)
+    return;
+
+  if (cinfo == NULL || cinfo->num_cols != (gint)fpc->rec_num_cols) {
+    /* No text for this frame means no text for any. */
+    fclose(fpc->text_fh);
+    fpc->text_fh = NULL;
+    return;
+  }
+
+  g_array_append_val(fpc->rec_text_offsets, fpc->text_len);
+  for (col = 0; col < cinfo->num_cols; col++) {
+    const char *col_str;
+    size_t      len;
+
+    /* The string the packet list would show; columns based only on the
+       frame data are filled in from it when they're shown. */
+    if (!get_column_resolved(col) && cinfo->col_expr.col_expr_val[col])
+      col_str = cinfo->col_expr.col_expr_val[col];
+    else if (col_based_on_frame_data(cinfo, col))
+      col_str = NULL;
+    else
+      col_str = cinfo->columns[col].col_data;
+    if (col_str == NULL)
+      col_str = "";
+
+    len = strlen(col_str) + 1;
+    if (fwrite(col_str, 1, len, fpc->text_fh) != len) {
+      fclose(fpc->text_fh);
+      fpc->text_fh = NULL;
+      return;
+    }
+    fpc->text_len += len;
+  }
+}
+
+static void
+stop_recording(first_pass_cache_t *fpc)
+{
+  fpc->recording = FALSE;
+  if (fpc->frames != NULL) {
+    g_array_free(fpc->frames, TRUE);
+    fpc->frames = NULL;
+  }
+  if (fpc->color_index != NULL) {
+    g_hash_table_destroy(fpc->color_index);
+    fpc->color_index = NULL;
+  }
+  if (fpc->text_fh != NULL) {
+    fclose(fpc->text_fh);
+    fpc->text_fh = NULL;
+  }
+  if (fpc->text_tmp_path != NULL) {
+    ws_unlink(fpc->text_tmp_path);
+    g_free(fpc->text_tmp_path);
+    fpc->text_tmp_path = NULL;
+  }
+  if (fpc->rec_text_offsets != NULL) {
+    g_array_free(fpc->rec_text_offsets, TRUE);
+    fpc->rec_text_offsets = NULL;
+  }
+}
+
+void
+first_pass_cache_abandon(first_pass_cache_t *fpc)
+{
+  if (fpc == NULL)
+    return;
+
+  /* Some frames may not have been colorized. */
+  if (fpc->recording)
+    fpc->colors_valid = FALSE;
+  stop_recording(fpc);
+}
+
+void
+first_pass_cache_write(first_pass_cache_t *fpc, capture_file *cf,
+                       guint num_idbs)
+{
+  fp_cache_header_t  hdr;
+  char              *cache_path;
+  char              *tmp_path;
+  char              *text_path = NULL;
+  FILE              *fh;
+  gboolean           have_text;
+  gboolean           ok;
+  guint              i;
+
+  if (!first_pass_cache_recording(fpc))
+    return;
+  if (fpc->frames->len != cf->count) {
+    first_pass_cache_abandon(fpc);
+    return;
+  }
+
+  /* Every frame was colorized, so their coloring rules can be used. */
+  fpc->colors_valid = TRUE;
+
+  /* Finish the text first, so that a cache is never left pointing at
+     text that isn't all there. */
+  have_text = FALSE;
+  if (fpc->text_fh != NULL) {
+    ok = fclose(fpc->text_fh) == 0;
+    fpc->text_fh = NULL;
+    if (ok && fpc->rec_text_offsets->len == cf->count) {
+      text_path = g_strdup_printf("%s.fpt", fpc->path);
+      have_text = ws_rename(fpc->text_tmp_path, text_path) == 0;
+      g_free(text_path);
+    }
+  }
+
+  memset(&hdr, 0, sizeof hdr);
+  memcpy(hdr.magic, FP_CACHE_MAGIC, sizeof hdr.magic);
+  hdr.byte_order = FP_CACHE_BYTE_ORDER;
+  hdr.format_version = FP_CACHE_FORMAT_VERSION;
+  hdr.header_size = sizeof (fp_cache_header_t);
+  hdr.frame_size = sizeof (fp_cache_frame_t);
+  memcpy(hdr.key, fpc->key, FP_CACHE_KEY_LEN);
+  hdr.num_frames = cf->count;
+  hdr.num_idbs = num_idbs;
+  hdr.lnk_t = cf->lnk_t;
+  hdr.num_linktypes = cf->linktypes->len;
+  hdr.num_colors = fpc->colors->len;
+  hdr.num_cols = have_text ? fpc->rec_num_cols : 0;
+  hdr.packet_comment_count = cf->packet_comment_count;
+  hdr.f_datalen = cf->f_datalen;
+
+  cache_path = g_strdup_printf("%s.fpc", fpc->path);
+  tmp_path = g_strdup_printf("%s.fpc.tmp", fpc->path);
+  fh = ws_fopen(tmp_path, "wb");
+  ok = fh != NULL;
+  if (ok)
+    ok = fwrite(&hdr, sizeof hdr, 1, fh) == 1;
+  for (i = 0; ok && i < cf->linktypes->len; i++) {
+    gint32 encap = g_array_index(cf->linktypes, int, i);
+
+    ok = fwrite(&encap, sizeof encap, 1, fh) == 1;
+  }
+  if (ok && cf->count != 0)
+    ok = fwrite(fpc->frames->data, sizeof (fp_cache_frame_t), cf->count, fh) == cf->count;
+  if (ok && have_text && cf->count != 0)
+    ok = fwrite(fpc->rec_text_offsets->data, sizeof (guint64), cf->count, fh) == cf->count;
+  if (fh != NULL && fclose(fh) != 0)
+    ok = FALSE;
+  if (ok)
+    ok = ws_rename(tmp_path, cache_path) == 0;
+  if (!ok)
+    ws_unlink(tmp_path);
+  g_free(tmp_path);
+  g_free(cache_path);
+
+  /* The text file, if renamed, isn't temporary any more. */
+  if (have_text) {
+    g_free(fpc->text_tmp_path);
+    fpc->text_tmp_path = NULL;
+  }
+  stop_recording(fpc);
+}
+
+gboolean
+first_pass_cache_get_columns(first_pass_cache_t *fpc, const frame_data *fdata,
+                             column_info *cinfo)
+{
+  const char *text;
+  const char *end;
+  gint        col;
+
+  if (fpc == NULL || fpc->text == NULL || cinfo == NULL ||
+      cinfo->num_cols != (gint)fpc->num_cols ||
+      fdata->num == 0 || fdata->num > fpc->text_frames)
+    return FALSE;
+
+  text = g_mapped_file_get_contents(fpc->text);
+  end = text + g_mapped_file_get_length(fpc->text);
+  text += fpc->text_offsets[fdata->num - 1];
+
+  for (col = 0; col < cinfo->num_cols; col++) {
+    size_t len;
+
+    if (text >= end)
+      return FALSE;
+    /* load_text() made sure the file ends with a NUL. */
+    len = strlen(text);
+
+    /* Put it where the packet list looks for it, whether the column is
+       resolved or not. */
+    g_strlcpy(cinfo->columns[col].col_buf, text,
+              cinfo->columns[col].col_fmt == COL_INFO ? COL_MAX_INFO_LEN : COL_MAX_LEN);
+    cinfo->columns[col].col_data = cinfo->columns[col].col_buf;
+    if (cinfo->col_expr.col_expr_val[col])
+      g_strlcpy(cinfo->col_expr.col_expr_val[col], text, COL_MAX_LEN);
+    text += len + 1;
+  }
+  return TRUE;
+}
+
+gboolean
+first_pass_cache_has_colors(first_pass_cache_t *fpc)
+{
+  return fpc != NULL && fpc->colors_valid;
+}
+
+void
+first_pass_cache_discard_columns(first_pass_cache_t *fpc)
+{
+  if (fpc == NULL || fpc->text == NULL)
+    return;
+
+  g_mapped_file_unref(fpc->text);
+  fpc->text = NULL;
+  g_free(fpc->text_offsets);
+  fpc->text_offsets = NULL;
+  fpc->text_frames = 0;
+}
+
+void
+first_pass_cache_discard_colors(first_pass_cache_t *fpc)
+{
+  /* The frames keep pointing to the clones until they're colorized
+     again, so the clones stay until the cache handle is freed. */
+  if (fpc != NULL)
+    fpc->colors_valid = FALSE;
+}
+
+void
+first_pass_cache_free(first_pass_cache_t *fpc)
+{
+  if (fpc == NULL)
+    return;
+
+  stop_recording(fpc);
+  first_pass_cache_discard_columns(fpc);
+  g_ptr_array_free(fpc->colors, TRUE);
+  g_free(fpc->path);
+  g_free(fpc);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 2
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=2 tabstop=8 expandtab:
+ * :indentSize=2:tabSize=8:noTabs=true:
+ */
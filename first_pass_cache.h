@@ -0,0 +1,135 @@
+/* first_pass_cache.h
+ * Definitions for an on-disk cache of the first pass through a capture file.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FIRST_PASS_CACHE_H__
+#define __FIRST_PASS_CACHE_H__
+
+#include "cfile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Reading a capture file for the first time means reading, dissecting and
+ * colorizing every frame in it.  If WIRESHARK_FIRST_PASS_CACHE_DIR is set,
+ * what that pass finds out about each frame (where it is, its time stamp
+ * and lengths, its coloring rule) and, optionally, the text of its columns
+ * is saved in that directory, so that opening the same file again can fill
+ * in the packet list without dissecting anything.
+ *
+ * A cache is only used for the file it was written for, with the same
+ * size and modification time, and in the same profile, with the same
+ * preferences, coloring rules and configuration files.
+ */
+typedef struct first_pass_cache first_pass_cache_t;
+
+/**
+ * Look for the cache of a capture file that has just been opened.
+ *
+ * @param cf the capture file
+ * @return a cache handle, or NULL if caching is off or the file can't
+ * be cached
+ */
+first_pass_cache_t *first_pass_cache_new(capture_file *cf);
+
+/**
+ * Fill in cf->provider.frames, cf->count, cf->linktypes, cf->lnk_t,
+ * cf->packet_comment_count and cf->f_datalen from the cache.
+ *
+ * @param fpc the cache
+ * @param cf the capture file, with no frames read yet
+ * @param num_idbs the number of interfaces known for the file
+ * @param max_frames the most frames the file may have
+ * @return TRUE if the cache was read, FALSE, with nothing changed in cf,
+ * if there is no usable cache
+ */
+gboolean first_pass_cache_load(first_pass_cache_t *fpc, capture_file *cf,
+                               guint num_idbs, guint32 max_frames);
+
+/**
+ * Start recording the first pass.  Frames are added with
+ * first_pass_cache_add(), with their columns filled in if cinfo isn't
+ * NULL, and the cache is written by first_pass_cache_write().
+ */
+void first_pass_cache_record(first_pass_cache_t *fpc, column_info *cinfo);
+
+/** TRUE if the first pass is being recorded. */
+gboolean first_pass_cache_recording(first_pass_cache_t *fpc);
+
+/** Record a frame after it's been dissected in the first pass. */
+void first_pass_cache_add(first_pass_cache_t *fpc, const frame_data *fdata,
+                          column_info *cinfo);
+
+/**
+ * Stop recording without writing the cache, because the first pass can't
+ * be reproduced from it (it was stopped, or the file has data, such as
+ * name resolution records or decryption secrets, that is only read in
+ * the first pass).
+ */
+void first_pass_cache_abandon(first_pass_cache_t *fpc);
+
+/**
+ * Write the recorded first pass to the cache directory.  Failures are
+ * silently ignored; the cache is just not there next time.
+ */
+void first_pass_cache_write(first_pass_cache_t *fpc, capture_file *cf,
+                            guint num_idbs);
+
+/**
+ * Fill in the columns of a frame from the cache.
+ *
+ * @param fpc the cache
+ * @param fdata the frame
+ * @param cinfo the columns to fill in, other than those based on frame
+ * data only
+ * @return TRUE if it was filled in
+ */
+gboolean first_pass_cache_get_columns(first_pass_cache_t *fpc,
+                                      const frame_data *fdata,
+                                      column_info *cinfo);
+
+/**
+ * TRUE if the coloring rules the frames got from the cache, or while the
+ * first pass was recorded, still apply.
+ */
+gboolean first_pass_cache_has_colors(first_pass_cache_t *fpc);
+
+/** Stop using the cached column text, e.g. because the columns changed. */
+void first_pass_cache_discard_columns(first_pass_cache_t *fpc);
+
+/** Stop using the cached coloring rules. */
+void first_pass_cache_discard_colors(first_pass_cache_t *fpc);
+
+/**
+ * Free the cache handle.  The frames filled in by first_pass_cache_load()
+ * may point to coloring rules owned by it, so this must not be called
+ * before they are freed.
+ */
+void first_pass_cache_free(first_pass_cache_t *fpc);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FIRST_PASS_CACHE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 2
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=2 tabstop=8 expandtab:
+ * :indentSize=2:tabSize=8:noTabs=true:
+ */
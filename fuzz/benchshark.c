@@ -0,0 +1,558 @@
+/* benchshark.c
+ *
+ * Dissector benchmark, a sibling of fuzzshark that replays a corpus
+ * through a dissector many times and reports how fast it went.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+/*
+ * If we have getopt_long() in the system library, include <getopt.h>.
+ * Otherwise, we're using our own getopt_long() (either because the
+ * system has getopt() but not getopt_long(), as with some UN*Xes,
+ * or because it doesn't even have getopt(), as with Windows), so
+ * include our getopt_long()'s header.
+ */
+#ifdef HAVE_GETOPT_LONG
+#include <getopt.h>
+#else
+#include <wsutil/wsgetopt.h>
+#endif
+
+#include <epan/epan.h>
+
+#include <ui/cmdarg_err.h>
+#include <ui/failure_message.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/json_dumper.h>
+#include <wsutil/privileges.h>
+#include <wsutil/report_message.h>
+#include <version_info.h>
+
+#include <wiretap/wtap.h>
+
+#include <epan/timestamp.h>
+#include <epan/prefs.h>
+#include <epan/epan_dissect.h>
+#include <epan/packet.h>
+#include <epan/proto.h>
+
+#define BENCH_DEFAULT_PASSES 10
+
+/* One packet of the corpus, kept in memory so that reading the files isn't
+ * part of the measurement. */
+typedef struct {
+	guint32 rec_type;
+	guint32 presence_flags;
+	nstime_t ts;
+	int tsprec;
+	wtap_packet_header packet_header;
+	int file_type_subtype;
+	guint8 *data;
+} bench_sample_t;
+
+typedef struct {
+	guint64 packets;
+	gint64 elapsed_us;
+	guint64 allocs;
+	guint64 bytes;
+	guint64 file_allocs;
+	guint64 tree_nodes;
+} bench_result_t;
+
+static epan_t *bench_epan;
+static epan_dissect_t *bench_edt;
+static guint32 bench_framenum;
+
+/*
+ * Report an error in command-line arguments.
+ */
+static void
+benchshark_cmdarg_err(const char *msg_format, va_list ap)
+{
+	fprintf(stderr, "benchshark: ");
+	vfprintf(stderr, msg_format, ap);
+	fprintf(stderr, "\n");
+}
+
+/*
+ * Report additional information for an error in command-line arguments.
+ */
+static void
+benchshark_cmdarg_err_cont(const char *msg_format, va_list ap)
+{
+	vfprintf(stderr, msg_format, ap);
+	fprintf(stderr, "\n");
+}
+
+static const nstime_t *
+benchshark_get_frame_ts(struct packet_provider_data *prov _U_, guint32 frame_num _U_)
+{
+	static nstime_t empty;
+
+	return &empty;
+}
+
+static epan_t *
+benchshark_epan_new(void)
+{
+	static const struct packet_provider_funcs funcs = {
+		benchshark_get_frame_ts,
+		NULL,
+		NULL,
+		NULL
+	};
+
+	return epan_new(NULL, &funcs);
+}
+
+static void
+print_usage(FILE *output)
+{
+	fprintf(output, "\n");
+	fprintf(output, "Usage: benchshark [options] <file> ...\n");
+	fprintf(output, "\n");
+	fprintf(output, "Replays capture files or raw sample files through a dissector.\n");
+	fprintf(output, "\n");
+	fprintf(output, "Options:\n");
+	fprintf(output, "  -d <dissector>  run each packet through this dissector instead of the\n");
+	fprintf(output, "                  full stack; required for raw sample files\n");
+	fprintf(output, "  -t <table>      look the dissector up by its filter name in this table,\n");
+	fprintf(output, "                  as with FUZZSHARK_TABLE\n");
+	fprintf(output, "  -n <passes>     number of timed passes over the corpus (def: %d)\n", BENCH_DEFAULT_PASSES);
+	fprintf(output, "  -j              print the results as JSON\n");
+	fprintf(output, "  -h              display this help and exit\n");
+}
+
+/* Same lookup as fuzzshark's, so that the same target names work */
+static dissector_handle_t
+get_dissector_handle(const char *table, const char *target)
+{
+	dissector_handle_t bench_handle = NULL;
+
+	if (table != NULL && target != NULL)
+	{
+		GSList *handle_list = dissector_table_get_dissector_handles(find_dissector_table(table));
+		while (handle_list)
+		{
+			dissector_handle_t handle = (dissector_handle_t) handle_list->data;
+			const char *handle_filter_name = proto_get_protocol_filter_name(dissector_handle_get_protocol_index(handle));
+
+			if (!strcmp(handle_filter_name, target))
+				bench_handle = handle;
+			handle_list = handle_list->next;
+		}
+	}
+	else if (target != NULL)
+	{
+		bench_handle = find_dissector(target);
+	}
+
+	return bench_handle;
+}
+
+static void
+add_raw_sample(GArray *samples, guint8 *data, guint32 len)
+{
+	bench_sample_t sample;
+
+	memset(&sample, 0, sizeof(sample));
+	sample.rec_type = REC_TYPE_PACKET;
+	sample.presence_flags = WTAP_HAS_TS | WTAP_HAS_CAP_LEN;
+	sample.tsprec = WTAP_TSPREC_USEC;
+	sample.packet_header.caplen = len;
+	sample.packet_header.len = len;
+	/* An encapsulation the frame dissector doesn't know, so that only the
+	 * target dissector, registered as a postdissector, sees the data. */
+	sample.packet_header.pkt_encap = G_MAXINT16;
+	sample.file_type_subtype = WTAP_FILE_TYPE_SUBTYPE_UNKNOWN;
+	sample.data = data;
+	g_array_append_val(samples, sample);
+}
+
+/* Loads a capture file, or else the whole file as a single raw sample */
+static gboolean
+load_file(GArray *samples, const char *filename, gboolean have_target)
+{
+	wtap *wth;
+	wtap_rec rec;
+	Buffer buf;
+	int err = 0;
+	gchar *err_info = NULL;
+	gint64 data_offset;
+
+	wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+	if (wth == NULL) {
+		gchar *contents;
+		gsize length;
+		GError *error = NULL;
+
+		if (err != WTAP_ERR_FILE_UNKNOWN_FORMAT) {
+			cfile_open_failure_message(filename, err, err_info);
+			return FALSE;
+		}
+		g_free(err_info);
+
+		if (!have_target) {
+			cmdarg_err("%s is not a capture file; raw samples need a dissector (-d)", filename);
+			return FALSE;
+		}
+		if (!g_file_get_contents(filename, &contents, &length, &error)) {
+			cmdarg_err("%s", error->message);
+			g_error_free(error);
+			return FALSE;
+		}
+		if (length > WTAP_MAX_PACKET_SIZE_STANDARD) {
+			cmdarg_err("%s is too large for a single sample", filename);
+			g_free(contents);
+			return FALSE;
+		}
+		add_raw_sample(samples, (guint8 *)contents, (guint32)length);
+		return TRUE;
+	}
+
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+	while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+		bench_sample_t sample;
+		guint32 caplen = rec.rec_header.packet_header.caplen;
+
+		if (rec.rec_type != REC_TYPE_PACKET)
+			continue;
+
+		if (have_target) {
+			/* Only the packet bytes matter to the target dissector */
+			add_raw_sample(samples, (guint8 *)g_memdup2(ws_buffer_start_ptr(&buf), caplen), caplen);
+			continue;
+		}
+
+		memset(&sample, 0, sizeof(sample));
+		sample.rec_type = rec.rec_type;
+		sample.presence_flags = rec.presence_flags;
+		sample.ts = rec.ts;
+		sample.tsprec = rec.tsprec;
+		sample.packet_header = rec.rec_header.packet_header;
+		sample.file_type_subtype = wtap_file_type_subtype(wth);
+		sample.data = (guint8 *)g_memdup2(ws_buffer_start_ptr(&buf), caplen);
+		g_array_append_val(samples, sample);
+	}
+	ws_buffer_free(&buf);
+	wtap_rec_cleanup(&rec);
+	wtap_close(wth);
+
+	if (err != 0) {
+		cfile_read_failure_message(filename, err, err_info);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+count_tree_nodes(proto_node *node, gpointer data)
+{
+	guint64 *count = (guint64 *)data;
+
+	(*count)++;
+	proto_tree_children_foreach(node, count_tree_nodes, data);
+}
+
+static void
+dissect_sample(const bench_sample_t *sample, guint64 *tree_nodes)
+{
+	wtap_rec rec;
+	frame_data fdlocal;
+	guint32 len = sample->packet_header.caplen;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.rec_type = sample->rec_type;
+	rec.presence_flags = sample->presence_flags;
+	rec.ts = sample->ts;
+	rec.tsprec = sample->tsprec;
+	rec.rec_header.packet_header = sample->packet_header;
+
+	frame_data_init(&fdlocal, ++bench_framenum, &rec, /* offset */ 0, /* cum_bytes */ 0);
+	/* frame_data_set_before_dissect() not needed */
+	epan_dissect_run(bench_edt, sample->file_type_subtype, &rec,
+	    tvb_new_real_data(sample->data, len, len), &fdlocal, NULL);
+
+	if (tree_nodes != NULL && bench_edt->tree != NULL)
+		proto_tree_children_foreach(bench_edt->tree, count_tree_nodes, tree_nodes);
+
+	frame_data_destroy(&fdlocal);
+	epan_dissect_reset(bench_edt);
+}
+
+static guint64
+stats_allocs(wmem_allocator_t *allocator, guint64 *bytes)
+{
+	const wmem_stats_t *stats = wmem_stats_get(allocator);
+
+	if (bytes != NULL)
+		*bytes = stats ? stats->total_bytes : 0;
+	return stats ? stats->allocs : 0;
+}
+
+static void
+run_benchmark(GArray *samples, guint passes, bench_result_t *result)
+{
+	guint64 allocs_before, bytes_before, file_allocs_before;
+	guint64 bytes_after;
+	gint64 start_us;
+	guint pass;
+	guint i;
+
+	memset(result, 0, sizeof(*result));
+
+	/* A first, untimed pass counts the allocations and tree nodes, and
+	 * warms up the caches and the per-conversation state. */
+	wmem_stats_enable(1);
+	allocs_before = stats_allocs(wmem_packet_scope(), &bytes_before);
+	file_allocs_before = stats_allocs(wmem_file_scope(), NULL);
+	for (i = 0; i < samples->len; i++)
+		dissect_sample(&g_array_index(samples, bench_sample_t, i), &result->tree_nodes);
+	result->allocs = stats_allocs(wmem_packet_scope(), &bytes_after) - allocs_before;
+	result->bytes = bytes_after - bytes_before;
+	result->file_allocs = stats_allocs(wmem_file_scope(), NULL) - file_allocs_before;
+	wmem_stats_enable(0);
+
+	start_us = g_get_monotonic_time();
+	for (pass = 0; pass < passes; pass++) {
+		for (i = 0; i < samples->len; i++)
+			dissect_sample(&g_array_index(samples, bench_sample_t, i), NULL);
+	}
+	result->elapsed_us = g_get_monotonic_time() - start_us;
+	result->packets = (guint64)passes * samples->len;
+}
+
+static void
+print_results(const char *table, const char *target, guint passes,
+    guint n_samples, const bench_result_t *result, gboolean json)
+{
+	double seconds = result->elapsed_us / 1e6;
+	double pps = seconds > 0 ? result->packets / seconds : 0;
+	double ns_per_packet = result->packets ? result->elapsed_us * 1000.0 / result->packets : 0;
+	double allocs_per_packet = n_samples ? (double)result->allocs / n_samples : 0;
+	double bytes_per_packet = n_samples ? (double)result->bytes / n_samples : 0;
+	double file_allocs_per_packet = n_samples ? (double)result->file_allocs / n_samples : 0;
+	double nodes_per_packet = n_samples ? (double)result->tree_nodes / n_samples : 0;
+
+	if (json) {
+		json_dumper dumper = {
+			.output_file = stdout,
+			.flags = JSON_DUMPER_FLAGS_PRETTY_PRINT,
+		};
+
+		json_dumper_begin_object(&dumper);
+		json_dumper_set_member_name(&dumper, "table");
+		json_dumper_value_string(&dumper, table);
+		json_dumper_set_member_name(&dumper, "dissector");
+		json_dumper_value_string(&dumper, target);
+		json_dumper_set_member_name(&dumper, "passes");
+		json_dumper_value_anyf(&dumper, "%u", passes);
+		json_dumper_set_member_name(&dumper, "samples");
+		json_dumper_value_anyf(&dumper, "%u", n_samples);
+		json_dumper_set_member_name(&dumper, "packets");
+		json_dumper_value_anyf(&dumper, "%" G_GUINT64_FORMAT, result->packets);
+		json_dumper_set_member_name(&dumper, "seconds");
+		json_dumper_value_double(&dumper, seconds);
+		json_dumper_set_member_name(&dumper, "packets_per_second");
+		json_dumper_value_double(&dumper, pps);
+		json_dumper_set_member_name(&dumper, "ns_per_packet");
+		json_dumper_value_double(&dumper, ns_per_packet);
+		json_dumper_set_member_name(&dumper, "allocs_per_packet");
+		json_dumper_value_double(&dumper, allocs_per_packet);
+		json_dumper_set_member_name(&dumper, "alloc_bytes_per_packet");
+		json_dumper_value_double(&dumper, bytes_per_packet);
+		json_dumper_set_member_name(&dumper, "file_allocs_per_packet");
+		json_dumper_value_double(&dumper, file_allocs_per_packet);
+		json_dumper_set_member_name(&dumper, "tree_nodes_per_packet");
+		json_dumper_value_double(&dumper, nodes_per_packet);
+		json_dumper_end_object(&dumper);
+		json_dumper_finish(&dumper);
+		return;
+	}
+
+	printf("Dissector:               %s%s%s\n", target ? target : "(full stack)",
+	    table ? " in " : "", table ? table : "");
+	printf("Passes:                  %u over %u samples\n", passes, n_samples);
+	printf("Packets:                 %" G_GUINT64_FORMAT "\n", result->packets);
+	printf("Time:                    %.3f s\n", seconds);
+	printf("Packets/s:               %.1f\n", pps);
+	printf("ns/packet:               %.1f\n", ns_per_packet);
+	printf("Allocations/packet:      %.2f (%.1f bytes)\n", allocs_per_packet, bytes_per_packet);
+	printf("File allocations/packet: %.2f\n", file_allocs_per_packet);
+	printf("Tree nodes/packet:       %.2f\n", nodes_per_packet);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char                *init_progfile_dir_error;
+
+	static const struct report_message_routines benchshark_report_routines = {
+		failure_message,
+		failure_message,
+		open_failure_message,
+		read_failure_message,
+		write_failure_message,
+		cfile_open_failure_message,
+		cfile_dump_open_failure_message,
+		cfile_read_failure_message,
+		cfile_write_failure_message,
+		cfile_close_failure_message
+	};
+
+	int                  opt;
+	const char          *bench_table = NULL;
+	const char          *bench_target = NULL;
+	guint                passes = BENCH_DEFAULT_PASSES;
+	gboolean             json = FALSE;
+	dissector_handle_t   bench_handle;
+	GArray              *samples;
+	bench_result_t       result;
+	int                  ret = EXIT_SUCCESS;
+	guint                i;
+
+	cmdarg_err_init(benchshark_cmdarg_err, benchshark_cmdarg_err_cont);
+
+	while ((opt = getopt(argc, argv, "d:t:n:jh")) != -1) {
+		switch (opt) {
+		case 'd':
+			bench_target = optarg;
+			break;
+		case 't':
+			bench_table = optarg;
+			break;
+		case 'n':
+			passes = (guint)strtoul(optarg, NULL, 10);
+			if (passes == 0) {
+				cmdarg_err("the number of passes must be positive");
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'j':
+			json = TRUE;
+			break;
+		case 'h':
+			print_usage(stdout);
+			return EXIT_SUCCESS;
+		default:
+			print_usage(stderr);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind >= argc) {
+		print_usage(stderr);
+		return EXIT_FAILURE;
+	}
+	if (bench_table && !bench_target) {
+		cmdarg_err("-t needs a dissector given with -d");
+		return EXIT_FAILURE;
+	}
+
+	/*
+	 * Get credential information for later use, and drop privileges
+	 * before doing anything else.
+	 * Let the user know if anything happened.
+	 */
+	init_process_policies();
+	relinquish_special_privs_perm();
+
+	/*
+	 * Attempt to get the pathname of the executable file.
+	 */
+	init_progfile_dir_error = init_progfile_dir(argv[0]);
+	if (init_progfile_dir_error != NULL) {
+		fprintf(stderr, "benchshark: Can't get pathname of benchshark program: %s.\n", init_progfile_dir_error);
+		g_free(init_progfile_dir_error);
+	}
+
+	/* Initialize the version information. */
+	ws_init_version_info("Benchshark (Wireshark)", NULL,
+	    epan_get_compiled_version_info, epan_get_runtime_version_info);
+
+	init_report_message("benchshark", &benchshark_report_routines);
+
+	timestamp_set_type(TS_RELATIVE);
+	timestamp_set_precision(TS_PREC_AUTO);
+	timestamp_set_seconds_type(TS_SECONDS_DEFAULT);
+
+	wtap_init(TRUE);
+
+	if (!epan_init(NULL, NULL, FALSE)) {
+		ret = EXIT_FAILURE;
+		goto clean_exit;
+	}
+
+	/* Load libwireshark settings from the current profile. */
+	epan_load_settings();
+
+	if (bench_target) {
+		bench_handle = get_dissector_handle(bench_table, bench_target);
+		if (bench_handle == NULL) {
+			cmdarg_err("dissector \"%s\" not found", bench_target);
+			ret = EXIT_FAILURE;
+			goto clean_exit;
+		}
+		register_postdissector(bench_handle);
+	}
+
+	samples = g_array_new(FALSE, FALSE, sizeof(bench_sample_t));
+	for (i = optind; i < (guint)argc; i++) {
+		if (!load_file(samples, argv[i], bench_target != NULL)) {
+			ret = EXIT_FAILURE;
+			goto clean_samples;
+		}
+	}
+	if (samples->len == 0) {
+		cmdarg_err("no packets to dissect");
+		ret = EXIT_FAILURE;
+		goto clean_samples;
+	}
+
+	bench_epan = benchshark_epan_new();
+	bench_edt = epan_dissect_new(bench_epan, TRUE, FALSE);
+
+	run_benchmark(samples, passes, &result);
+	print_results(bench_table, bench_target, passes, samples->len, &result, json);
+
+	epan_dissect_free(bench_edt);
+	epan_free(bench_epan);
+
+clean_samples:
+	for (i = 0; i < samples->len; i++)
+		g_free(g_array_index(samples, bench_sample_t, i).data);
+	g_array_free(samples, TRUE);
+	epan_cleanup();
+clean_exit:
+	wtap_cleanup();
+	free_progdirs();
+	return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
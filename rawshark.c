@@ -138,6 +138,24 @@ static print_format_e print_format = PR_FMT_TEXT;
 
 static gboolean want_pcap_pkthdr;
 
+/*
+ * Records are parsed out of a buffer that is refilled with whatever
+ * the pipe has available, rather than with two reads per packet.
+ */
+#define PIPE_BUF_SIZE (64 * 1024)
+static guint8 *pipe_buf;
+static size_t pipe_buf_pos;
+static size_t pipe_buf_len;
+
+/*
+ * Output is formatted into out_buf and written out when it holds
+ * OUTPUT_FLUSH_SIZE bytes, after every packet with -l, and whenever we
+ * are about to wait for more input, so whoever is feeding us always
+ * sees the results for the packets sent so far.
+ */
+#define OUTPUT_FLUSH_SIZE (64 * 1024)
+static GString *out_buf;
+
 cf_status_t raw_cf_open(capture_file *cf, const char *fname);
 static gboolean load_cap_file(capture_file *cf);
 static gboolean process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
@@ -209,6 +227,20 @@ print_usage(FILE *output)
     fprintf(output, "  -v                       display version info and exit\n");
 }
 
+static void
+flush_output(void)
+{
+    if (out_buf->len != 0) {
+        fwrite(out_buf->str, 1, out_buf->len, stdout);
+        g_string_truncate(out_buf, 0);
+    }
+    fflush(stdout);
+    if (ferror(stdout)) {
+        show_print_file_io_error(errno);
+        exit(2);
+    }
+}
+
 static void
 log_func_ignore (const gchar *log_domain _U_, GLogLevelFlags log_level _U_,
                  const gchar *message _U_, gpointer user_data _U_)
@@ -845,11 +877,53 @@ clean_exit:
  * @param data_offset [OUT] data offset in the pipe.
  * @return TRUE on success, FALSE on failure.
  */
+/**
+ * Copy up to "len" bytes from the pipe to "dst", going through pipe_buf.
+ * Pending output is written out before we wait for more input. Returns
+ * the number of bytes copied; if that's less than "len", we hit the end
+ * of the input (*err == 0) or an error (*err == errno).
+ */
+static size_t
+pipe_read_bytes(guint8 *dst, size_t len, int *err)
+{
+    size_t copied = 0;
+    ssize_t bytes_read;
+
+    while (copied < len) {
+        if (pipe_buf_pos == pipe_buf_len) {
+            flush_output();
+            if (len - copied >= PIPE_BUF_SIZE) {
+                /* Big enough to read straight into place. */
+                bytes_read = ws_read(fd, dst + copied, (unsigned int)(len - copied));
+                if (bytes_read <= 0) {
+                    *err = bytes_read < 0 ? errno : 0;
+                    return copied;
+                }
+                copied += bytes_read;
+                continue;
+            }
+            bytes_read = ws_read(fd, pipe_buf, PIPE_BUF_SIZE);
+            if (bytes_read <= 0) {
+                *err = bytes_read < 0 ? errno : 0;
+                return copied;
+            }
+            pipe_buf_pos = 0;
+            pipe_buf_len = bytes_read;
+        }
+
+        size_t chunk = MIN(len - copied, pipe_buf_len - pipe_buf_pos);
+        memcpy(dst + copied, pipe_buf + pipe_buf_pos, chunk);
+        pipe_buf_pos += chunk;
+        copied += chunk;
+    }
+    return copied;
+}
+
 static gboolean
 raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *data_offset) {
     struct pcap_pkthdr mem_hdr;
     struct pcaprec_hdr disk_hdr;
-    ssize_t bytes_read = 0;
+    size_t bytes_read;
     unsigned int bytes_needed = (unsigned int) sizeof(disk_hdr);
     guchar *ptr = (guchar*) &disk_hdr;
 
@@ -877,21 +951,11 @@ raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *da
     }
 #endif
 
-    /* Copied from capture_loop.c */
-    while (bytes_needed > 0) {
-        bytes_read = ws_read(fd, ptr, bytes_needed);
-        if (bytes_read == 0) {
-            *err = 0;
-            *err_info = NULL;
-            return FALSE;
-        } else if (bytes_read < 0) {
-            *err = errno;
-            *err_info = NULL;
-            return FALSE;
-        }
-        bytes_needed -= (unsigned int)bytes_read;
-        *data_offset += bytes_read;
-        ptr += bytes_read;
+    bytes_read = pipe_read_bytes(ptr, bytes_needed, err);
+    *data_offset += bytes_read;
+    if (bytes_read < bytes_needed) {
+        *err_info = NULL;
+        return FALSE;
     }
 
     rec->rec_type = REC_TYPE_PACKET;
@@ -927,20 +991,13 @@ raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *da
 
     ws_buffer_assure_space(buf, bytes_needed);
     ptr = ws_buffer_start_ptr(buf);
-    while (bytes_needed > 0) {
-        bytes_read = ws_read(fd, ptr, bytes_needed);
-        if (bytes_read == 0) {
+    bytes_read = pipe_read_bytes(ptr, bytes_needed, err);
+    *data_offset += bytes_read;
+    if (bytes_read < bytes_needed) {
+        if (*err == 0)
             *err = WTAP_ERR_SHORT_READ;
-            *err_info = NULL;
-            return FALSE;
-        } else if (bytes_read < 0) {
-            *err = errno;
-            *err_info = NULL;
-            return FALSE;
-        }
-        bytes_needed -= (unsigned int)bytes_read;
-        *data_offset += bytes_read;
-        ptr += bytes_read;
+        *err_info = NULL;
+        return FALSE;
     }
     return TRUE;
 }
@@ -961,10 +1018,20 @@ load_cap_file(capture_file *cf)
 
     epan_dissect_init(&edt, cf->epan, TRUE, FALSE);
 
+    pipe_buf = (guint8 *)g_malloc(PIPE_BUF_SIZE);
+    pipe_buf_pos = pipe_buf_len = 0;
+    out_buf = g_string_sized_new(OUTPUT_FLUSH_SIZE + 4096);
+
     while (raw_pipe_read(&rec, &buf, &err, &err_info, &data_offset)) {
         process_packet(cf, &edt, data_offset, &rec, &buf);
     }
 
+    flush_output();
+    g_string_free(out_buf, TRUE);
+    out_buf = NULL;
+    g_free(pipe_buf);
+    pipe_buf = NULL;
+
     epan_dissect_cleanup(&edt);
 
     wtap_rec_cleanup(&rec);
@@ -991,11 +1058,11 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         /* The user sends an empty packet when he wants to get output from us even if we don't currently have
            packets to process. We spit out a line with the timestamp and the text "void"
         */
-        printf("%lu %lu %lu void -\n", (unsigned long int)cf->count,
+        g_string_append_printf(out_buf, "%lu %lu %lu void -\n", (unsigned long int)cf->count,
                (unsigned long int)rec->ts.secs,
                (unsigned long int)rec->ts.nsecs);
 
-        fflush(stdout);
+        flush_output();
 
         return FALSE;
     }
@@ -1018,7 +1085,7 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         }
     }
 
-    printf("%lu", (unsigned long int) cf->count);
+    g_string_append_printf(out_buf, "%lu", (unsigned long int) cf->count);
 
     frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
                                   &cf->provider.ref, cf->provider.prev_dis);
@@ -1050,10 +1117,10 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
             passed = TRUE;
 
         /* Print a one-line summary */
-        printf(" %d", passed ? 1 : 0);
+        g_string_append(out_buf, passed ? " 1" : " 0");
     }
 
-    printf(" -\n");
+    g_string_append(out_buf, " -\n");
 
     /* The ANSI C standard does not appear to *require* that a line-buffered
        stream be flushed to the host environment whenever a newline is
@@ -1075,13 +1142,8 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
        be piped to a program or script and to have that script see the
        information for the packet as soon as it's printed, rather than
        having to wait until a standard I/O buffer fills up. */
-    if (line_buffered)
-        fflush(stdout);
-
-    if (ferror(stdout)) {
-        show_print_file_io_error(errno);
-        exit(2);
-    }
+    if (line_buffered || out_buf->len >= OUTPUT_FLUSH_SIZE)
+        flush_output();
 
     epan_dissect_reset(edt);
     frame_data_destroy(&fdata);
@@ -1251,14 +1313,14 @@ static gboolean print_field_value(field_info *finfo, int cmd_line_index)
                 }
             }
         }
-        printf(" %d=\"%s\"", cmd_line_index, label_s->str);
+        g_string_append_printf(out_buf, " %d=\"%s\"", cmd_line_index, label_s->str);
         wmem_free(NULL, fs_buf);
         return TRUE;
     }
 
     if(finfo->value.ftype->val_to_string_repr)
     {
-        printf(" %d=\"%s\"", cmd_line_index, fs_ptr);
+        g_string_append_printf(out_buf, " %d=\"%s\"", cmd_line_index, fs_ptr);
         wmem_free(NULL, fs_buf);
         return TRUE;
     }
@@ -1268,7 +1330,7 @@ static gboolean print_field_value(field_info *finfo, int cmd_line_index)
      * e.g. http
      * We return n.a.
      */
-    printf(" %d=\"n.a.\"", cmd_line_index);
+    g_string_append_printf(out_buf, " %d=\"n.a.\"", cmd_line_index);
     return TRUE;
 }
 
@@ -1281,7 +1343,7 @@ protocolinfo_packet(void *prs, packet_info *pinfo _U_, epan_dissect_t *edt, cons
 
     gp=proto_get_finfo_ptr_array(edt->tree, rs->hf_index);
     if(!gp){
-        printf(" n.a.");
+        g_string_append(out_buf, " n.a.");
         return TAP_PACKET_DONT_REDRAW;
     }
 
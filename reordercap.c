@@ -63,12 +63,29 @@ print_usage(FILE *output)
     fprintf(output, "  -v        print version information and exit.\n");
 }
 
-/* Remember where this frame was in the file */
-typedef struct FrameRecord_t {
-    gint64       offset;
-    guint        num;
+/*
+ * Frames that are at most this many frames out of place are put in order
+ * by passing them through a window of that many frames.  Otherwise, the
+ * frames are sorted in memory; if they take up more than REORDER_MEM_MAX
+ * bytes, each REORDER_MEM_MAX bytes' worth are sorted and written to a
+ * temporary file, and then those runs are merged.  Either way, the input
+ * file is read sequentially.
+ */
+#define REORDER_WINDOW      4096
+#define REORDER_MEM_MAX     (256 * 1024 * 1024)
 
+/* What we sort frames by */
+typedef struct FrameKey_t {
     nstime_t     frame_time;
+    guint        run;           /* run the frame came from, if merging runs */
+    guint        num;           /* frame number in the file it came from */
+} FrameKey_t;
+
+/* A frame we've read and not written yet */
+typedef struct FrameRecord_t {
+    FrameKey_t   key;           /* must be first */
+    wtap_rec     rec;
+    Buffer       buf;
 } FrameRecord_t;
 
 
@@ -86,20 +103,37 @@ typedef struct FrameRecord_t {
 /**************************************************/
 
 
+static FrameRecord_t *
+frame_new(void)
+{
+    FrameRecord_t *frame = g_new(FrameRecord_t, 1);
+
+    wtap_rec_init(&frame->rec);
+    ws_buffer_init(&frame->buf, 1514);
+    return frame;
+}
+
 static void
-frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
-            wtap_rec *rec, Buffer *buf, const char *infile,
-            const char *outfile)
+frame_free(gpointer data)
 {
-    int    err;
-    gchar  *err_info;
+    FrameRecord_t *frame = (FrameRecord_t *)data;
 
-    DEBUG_PRINT("\nDumping frame (offset=%" G_GINT64_MODIFIER "u)\n",
-                frame->offset);
+    wtap_rec_cleanup(&frame->rec);
+    ws_buffer_free(&frame->buf);
+    g_free(frame);
+}
 
+/* Read the next frame; returns FALSE at the end of the file */
+static gboolean
+frame_read(FrameRecord_t *frame, wtap *wth, guint run, guint num,
+           const char *infile)
+{
+    int    err;
+    gchar  *err_info;
+    gint64 data_offset;
 
-    /* Re-read the frame from the stored location */
-    if (!wtap_seek_read(wth, frame->offset, rec, buf, &err, &err_info)) {
+    if (!wtap_read(wth, &frame->rec, &frame->buf, &err, &err_info,
+                   &data_offset)) {
         if (err != 0) {
             /* Print a message noting that the read failed somewhere along the line. */
             fprintf(stderr,
@@ -108,17 +142,33 @@ frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
             cfile_read_failure_message(infile, err, err_info);
             exit(1);
         }
+        return FALSE;
+    }
+
+    frame->key.run = run;
+    frame->key.num = num;
+    if (frame->rec.presence_flags & WTAP_HAS_TS) {
+        frame->key.frame_time = frame->rec.ts;
+    } else {
+        nstime_set_unset(&frame->key.frame_time);
     }
+    return TRUE;
+}
+
+static void
+frame_write(FrameRecord_t *frame, wtap_dumper *pdh, int file_type_subtype,
+            const char *infile, const char *outfile)
+{
+    int    err;
+    gchar  *err_info;
 
-    /* Copy, and set length and timestamp from item. */
-    /* TODO: remove when wtap_seek_read() fills in rec,
-       including time stamps, for all file types  */
-    rec->ts = frame->frame_time;
+    DEBUG_PRINT("\nDumping frame %u\n", frame->key.num);
 
     /* Dump frame to outfile */
-    if (!wtap_dump(pdh, rec, ws_buffer_start_ptr(buf), &err, &err_info)) {
-        cfile_write_failure_message(infile, outfile, err, err_info, frame->num,
-                                    wtap_file_type_subtype(wth));
+    if (!wtap_dump(pdh, &frame->rec, ws_buffer_start_ptr(&frame->buf),
+                   &err, &err_info)) {
+        cfile_write_failure_message(infile, outfile, err, err_info,
+                                    frame->key.num, file_type_subtype);
         exit(1);
     }
 }
@@ -127,17 +177,248 @@ frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
    negative if (t1 < t2)
    zero     if (t1 == t2)
    positive if (t1 > t2)
+   Frames with the same timestamp stay in the order they were read in.
 */
 static int
 frames_compare(gconstpointer a, gconstpointer b)
 {
-    const FrameRecord_t *frame1 = *(const FrameRecord_t *const *) a;
-    const FrameRecord_t *frame2 = *(const FrameRecord_t *const *) b;
+    const FrameKey_t *frame1 = *(const FrameKey_t *const *) a;
+    const FrameKey_t *frame2 = *(const FrameKey_t *const *) b;
+    int cmp;
+
+    cmp = nstime_cmp(&frame1->frame_time, &frame2->frame_time);
+    if (cmp != 0)
+        return cmp;
+    if (frame1->run != frame2->run)
+        return frame1->run < frame2->run ? -1 : 1;
+    if (frame1->num != frame2->num)
+        return frame1->num < frame2->num ? -1 : 1;
+    return 0;
+}
 
-    const nstime_t *time1 = &frame1->frame_time;
-    const nstime_t *time2 = &frame2->frame_time;
+static gint
+frames_compare_data(gconstpointer a, gconstpointer b, gpointer user_data _U_)
+{
+    return frames_compare(a, b);
+}
 
-    return nstime_cmp(time1, time2);
+/* Binary min-heap of frames (or their keys), in frames_compare() order */
+static void
+frame_heap_push(GPtrArray *heap, gpointer frame)
+{
+    guint i, parent;
+
+    g_ptr_array_add(heap, frame);
+    for (i = heap->len - 1; i != 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (frames_compare(&frame, &heap->pdata[parent]) >= 0)
+            break;
+        heap->pdata[i] = heap->pdata[parent];
+    }
+    heap->pdata[i] = frame;
+}
+
+static gpointer
+frame_heap_pop(GPtrArray *heap)
+{
+    gpointer top, last;
+    guint i, child;
+
+    top = heap->pdata[0];
+    last = g_ptr_array_remove_index(heap, heap->len - 1);
+    if (heap->len == 0)
+        return top;
+
+    /* Sift the last frame down from the top. */
+    for (i = 0; (child = 2 * i + 1) < heap->len; i = child) {
+        if (child + 1 < heap->len &&
+            frames_compare(&heap->pdata[child + 1], &heap->pdata[child]) < 0)
+            child++;
+        if (frames_compare(&heap->pdata[child], &last) >= 0)
+            break;
+        heap->pdata[i] = heap->pdata[child];
+    }
+    heap->pdata[i] = last;
+    return top;
+}
+
+/* Write out the frame_count frames of wth, which are no more than window
+   frames out of place, in order */
+static void
+reorder_window(wtap *wth, wtap_dumper *pdh, guint frame_count, guint window,
+               const char *infile, const char *outfile)
+{
+    GPtrArray *heap = g_ptr_array_sized_new(window + 1);
+    FrameRecord_t *frame = NULL;
+    guint num;
+
+    for (num = 1; num <= frame_count; num++) {
+        if (frame == NULL)
+            frame = frame_new();
+        if (!frame_read(frame, wth, 0, num, infile))
+            break;
+        frame_heap_push(heap, frame);
+        frame = NULL;
+        if (heap->len > window) {
+            frame = (FrameRecord_t *)frame_heap_pop(heap);
+            frame_write(frame, pdh, wtap_file_type_subtype(wth), infile, outfile);
+        }
+    }
+    if (frame != NULL)
+        frame_free(frame);
+
+    while (heap->len != 0) {
+        frame = (FrameRecord_t *)frame_heap_pop(heap);
+        frame_write(frame, pdh, wtap_file_type_subtype(wth), infile, outfile);
+        frame_free(frame);
+    }
+    g_ptr_array_free(heap, TRUE);
+}
+
+/* Write a sorted run of frames to a temporary file, and return its name */
+static char *
+reorder_write_run(FrameRecord_t **frames, guint count, wtap *wth,
+                  const char *infile)
+{
+    wtap_dump_params params;
+    wtap_dumper *pdh;
+    char *run_name;
+    int err;
+    gchar *err_info;
+    guint i;
+
+    wtap_dump_params_init(&params, wth);
+    /* The output file gets the DSBs straight from the input file. */
+    params.dsbs_growing = NULL;
+    pdh = wtap_dump_open_tempfile(&run_name, "reordercap",
+                                  wtap_file_type_subtype(wth),
+                                  WTAP_UNCOMPRESSED, &params, &err, &err_info);
+    g_free(params.idb_inf);
+    params.idb_inf = NULL;
+    if (pdh == NULL) {
+        cfile_dump_open_failure_message("temporary file", err, err_info,
+                                        wtap_file_type_subtype(wth));
+        exit(1);
+    }
+
+    for (i = 0; i < count; i++)
+        frame_write(frames[i], pdh, wtap_file_type_subtype(wth), infile,
+                    run_name);
+
+    if (!wtap_dump_close(pdh, &err, &err_info)) {
+        cfile_close_failure_message(run_name, err, err_info);
+        exit(1);
+    }
+    wtap_dump_params_cleanup(&params);
+    return run_name;
+}
+
+/* Merge the sorted runs into the output file, and remove them */
+static void
+reorder_merge_runs(GPtrArray *runs, wtap_dumper *pdh, int file_type_subtype,
+                   const char *outfile)
+{
+    wtap **run_wths;
+    GPtrArray *heap;
+    FrameRecord_t *frame;
+    int err;
+    gchar *err_info;
+    guint i;
+
+    run_wths = g_new(wtap *, runs->len);
+    heap = g_ptr_array_sized_new(runs->len);
+    for (i = 0; i < runs->len; i++) {
+        const char *run_name = (const char *)runs->pdata[i];
+
+        run_wths[i] = wtap_open_offline(run_name, WTAP_TYPE_AUTO, &err,
+                                        &err_info, FALSE);
+        if (run_wths[i] == NULL) {
+            cfile_open_failure_message(run_name, err, err_info);
+            exit(1);
+        }
+        frame = frame_new();
+        if (frame_read(frame, run_wths[i], i, 1, run_name))
+            frame_heap_push(heap, frame);
+        else
+            frame_free(frame);
+    }
+
+    while (heap->len != 0) {
+        frame = (FrameRecord_t *)frame_heap_pop(heap);
+        i = frame->key.run;
+        frame_write(frame, pdh, file_type_subtype,
+                    (const char *)runs->pdata[i], outfile);
+        if (frame_read(frame, run_wths[i], i, frame->key.num + 1,
+                       (const char *)runs->pdata[i]))
+            frame_heap_push(heap, frame);
+        else
+            frame_free(frame);
+    }
+
+    for (i = 0; i < runs->len; i++) {
+        wtap_close(run_wths[i]);
+        ws_unlink((const char *)runs->pdata[i]);
+    }
+    g_ptr_array_free(heap, TRUE);
+    g_free(run_wths);
+}
+
+/* Write out the frame_count frames of in_wth sorted, spilling sorted runs
+   to temporary files if they don't fit in memory; wth is the input file
+   the output file was opened for */
+static void
+reorder_sort(wtap *wth, wtap *in_wth, wtap_dumper *pdh, guint frame_count,
+             const char *infile, const char *outfile)
+{
+    GPtrArray *frames = g_ptr_array_new_with_free_func(frame_free);
+    GPtrArray *runs = g_ptr_array_new_with_free_func(g_free);
+    FrameRecord_t *frame;
+    gsize mem;
+    guint num = 1;
+    guint count, i;
+    gboolean at_eof = FALSE;
+
+    while (!at_eof) {
+        /* Read as many frames as we can hold, reusing the last run's. */
+        count = 0;
+        mem = 0;
+        while (mem < REORDER_MEM_MAX) {
+            if (num > frame_count) {
+                at_eof = TRUE;
+                break;
+            }
+            if (count == frames->len)
+                g_ptr_array_add(frames, frame_new());
+            frame = (FrameRecord_t *)frames->pdata[count];
+            if (!frame_read(frame, in_wth, 0, num, infile)) {
+                at_eof = TRUE;
+                break;
+            }
+            count++;
+            num++;
+            mem += sizeof(FrameRecord_t) + frame->buf.allocated;
+        }
+
+        /* Sort them; this is a stable sort. */
+        g_qsort_with_data(frames->pdata, count, sizeof(gpointer),
+                          frames_compare_data, NULL);
+
+        if (at_eof && runs->len == 0) {
+            /* They all fit; no need for temporary files. */
+            for (i = 0; i < count; i++)
+                frame_write((FrameRecord_t *)frames->pdata[i], pdh,
+                            wtap_file_type_subtype(wth), infile, outfile);
+            break;
+        }
+        if (count != 0)
+            g_ptr_array_add(runs, reorder_write_run((FrameRecord_t **)frames->pdata,
+                                                    count, wth, infile));
+    }
+    g_ptr_array_free(frames, TRUE);
+
+    if (runs->len != 0)
+        reorder_merge_runs(runs, pdh, wtap_file_type_subtype(wth), outfile);
+    g_ptr_array_free(runs, TRUE);
 }
 
 /*
@@ -188,14 +469,18 @@ main(int argc, char *argv[])
     int err;
     gchar *err_info;
     gint64 data_offset;
+    guint frame_count = 0;
     guint wrong_order_count = 0;
     gboolean write_output_regardless = TRUE;
-    guint i;
     wtap_dump_params params;
     int                          ret = EXIT_SUCCESS;
 
-    GPtrArray *frames;
-    FrameRecord_t *prevFrame = NULL;
+    wtap *in_wth;
+    nstime_t prev_time;
+    GPtrArray *window;
+    FrameKey_t *window_keys, *key, *spare_key = NULL;
+    nstime_t last_out_time;
+    gboolean window_ok = TRUE;
 
     int opt;
     static const struct option long_options[] = {
@@ -268,7 +553,7 @@ main(int argc, char *argv[])
     /* Open infile */
     /* TODO: if reordercap is ever changed to give the user a choice of which
        open_routine reader to use, then the following needs to change. */
-    wth = wtap_open_offline(infile, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    wth = wtap_open_offline(infile, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
     if (wth == NULL) {
         cfile_open_failure_message(infile, err, err_info);
         ret = OPEN_ERROR;
@@ -297,30 +582,44 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
-    /* Allocate the array of frame pointers. */
-    frames = g_ptr_array_new();
-
-    /* Read each frame from infile */
+    /* Read the time stamps of the frames in infile, to see how out of
+       order they are; see whether passing them through a window of
+       REORDER_WINDOW frames would be enough to put them in order. */
+    wtap_set_skip_packet_data(wth, TRUE);
+    window = g_ptr_array_sized_new(REORDER_WINDOW + 1);
+    window_keys = g_new(FrameKey_t, REORDER_WINDOW + 1);
+    nstime_set_unset(&prev_time);
+    nstime_set_unset(&last_out_time);
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
     while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
-        FrameRecord_t *newFrameRecord;
+        nstime_t frame_time;
 
-        newFrameRecord = g_slice_new(FrameRecord_t);
-        newFrameRecord->num = frames->len + 1;
-        newFrameRecord->offset = data_offset;
         if (rec.presence_flags & WTAP_HAS_TS) {
-            newFrameRecord->frame_time = rec.ts;
+            frame_time = rec.ts;
         } else {
-            nstime_set_unset(&newFrameRecord->frame_time);
+            nstime_set_unset(&frame_time);
         }
 
-        if (prevFrame && frames_compare(&newFrameRecord, &prevFrame) < 0) {
+        if (frame_count != 0 && nstime_cmp(&frame_time, &prev_time) < 0) {
            wrong_order_count++;
         }
-
-        g_ptr_array_add(frames, newFrameRecord);
-        prevFrame = newFrameRecord;
+        prev_time = frame_time;
+        frame_count++;
+
+        if (window_ok) {
+            key = (spare_key != NULL) ? spare_key : &window_keys[window->len];
+            key->frame_time = frame_time;
+            key->run = 0;
+            key->num = frame_count;
+            frame_heap_push(window, key);
+            if (window->len > REORDER_WINDOW) {
+                spare_key = (FrameKey_t *)frame_heap_pop(window);
+                if (nstime_cmp(&spare_key->frame_time, &last_out_time) < 0)
+                    window_ok = FALSE;
+                last_out_time = spare_key->frame_time;
+            }
+        }
     }
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
@@ -328,36 +627,37 @@ main(int argc, char *argv[])
       /* Print a message noting that the read failed somewhere along the line. */
       cfile_read_failure_message(infile, err, err_info);
     }
-
-    printf("%u frames, %u out of order\n", frames->len, wrong_order_count);
-
-    /* Sort the frames */
-    if (wrong_order_count > 0) {
-        g_ptr_array_sort(frames, frames_compare);
+    while (window_ok && window->len != 0) {
+        key = (FrameKey_t *)frame_heap_pop(window);
+        if (nstime_cmp(&key->frame_time, &last_out_time) < 0)
+            window_ok = FALSE;
+        last_out_time = key->frame_time;
     }
-
-    /* Write out each sorted frame in turn */
-    wtap_rec_init(&rec);
-    ws_buffer_init(&buf, 1514);
-    for (i = 0; i < frames->len; i++) {
-        FrameRecord_t *frame = (FrameRecord_t *)frames->pdata[i];
-
-        /* Avoid writing if already sorted and configured to */
-        if (write_output_regardless || (wrong_order_count > 0)) {
-            frame_write(frame, wth, pdh, &rec, &buf, infile, outfile);
+    g_ptr_array_free(window, TRUE);
+    g_free(window_keys);
+
+    printf("%u frames, %u out of order\n", frame_count, wrong_order_count);
+
+    /* Avoid writing if already sorted and configured to */
+    if (write_output_regardless || (wrong_order_count > 0)) {
+        /* Read infile again, sequentially, to write out the frames in order */
+        in_wth = wtap_open_offline(infile, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+        if (in_wth == NULL) {
+            cfile_open_failure_message(infile, err, err_info);
+            exit(OPEN_ERROR);
         }
-        g_slice_free(FrameRecord_t, frame);
-    }
-    wtap_rec_cleanup(&rec);
-    ws_buffer_free(&buf);
-
-    if (!write_output_regardless && (wrong_order_count == 0)) {
+        if (wrong_order_count == 0) {
+            reorder_window(in_wth, pdh, frame_count, 0, infile, outfile);
+        } else if (window_ok) {
+            reorder_window(in_wth, pdh, frame_count, REORDER_WINDOW, infile, outfile);
+        } else {
+            reorder_sort(wth, in_wth, pdh, frame_count, infile, outfile);
+        }
+        wtap_close(in_wth);
+    } else {
         printf("Not writing output file because input file is already in order.\n");
     }
 
-    /* Free the whole array */
-    g_ptr_array_free(frames, TRUE);
-
     /* Close outfile */
     if (!wtap_dump_close(pdh, &err, &err_info)) {
         cfile_close_failure_message(outfile, err, err_info);
@@ -32,6 +32,10 @@
 
 #ifdef HAVE_LIBPCAP
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* for fallocate() and sync_file_range() */
+#endif
+
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -40,6 +44,7 @@
 #include <glib.h>
 
 #include "wspcap.h"
+#include "ws_attributes.h"
 
 #include <glib.h>
 
@@ -47,20 +52,35 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
 #ifdef _WIN32
 #include <wsutil/win32-utils.h>
 #endif
 
 #include "ringbuffer.h"
 #include <wsutil/file_util.h>
+#include <wsutil/ws_probes.h>
 
 #ifdef HAVE_ZLIB
 #include <zlib.h>
 #endif
 
+/* A completed ringbuffer file that's waiting to be, or being, compressed */
+typedef struct _rb_compress_job {
+  gchar         *name;               /**< name of the uncompressed file */
+  struct _rb_compress_job **owner;   /**< where the ringbuffer refers to us, if it still does */
+  gboolean       cancelled;          /**< TRUE if the file was removed by rotation meanwhile */
+} rb_compress_job;
+
 /* Ringbuffer file structure */
 typedef struct _rb_file {
   gchar         *name;
+  rb_compress_job *compress_job;     /**< pending compression of this file, if any */
 } rb_file;
 
 #define MAX_FILENAME_QUEUE  100
@@ -81,12 +101,27 @@ typedef struct _ringbuf_data {
   FILE         *name_h;              /**< write names of completed files to this handle */
   gchar        *compress_type;       /**< compress type */
 
-  GMutex        mutex;               /**< mutex for oldnames */
+  GMutex        mutex;               /**< mutex for oldnames and compression jobs */
   gchar        *oldnames[MAX_FILENAME_QUEUE];       /**< filename list of pending to be deleted */
+
+  GAsyncQueue  *compress_q;          /**< completed files for the compression thread */
+  GThread      *compress_thread;     /**< compresses completed files, one at a time */
+
+  gint64        prealloc_size;       /**< bytes to allocate for the next file ahead of time, or 0 */
+  gchar        *prealloc_name;       /**< name of the next file until it's switched to */
+  GThread      *prealloc_thread;     /**< creates and allocates the next file */
+  int           prealloc_fd;         /**< the next file, once prealloc_thread is done, or -1 */
+
+  gint64        write_behind;        /**< bytes to write before writing them back, or 0 */
+  gint64        wb_start;            /**< start of the range being written back */
+  gint64        wb_end;              /**< end of that range, and start of what isn't yet */
 } ringbuf_data;
 
 static ringbuf_data rb_data;
 
+/* Tells the compression thread to exit */
+static rb_compress_job rb_compress_stop;
+
 /*
  * delete pending uncompressed pcap files.
  */
@@ -123,81 +158,245 @@ static void CleanupOldCap(gchar* name)
   g_mutex_unlock(&rb_data.mutex);
 }
 
+#ifdef HAVE_ZLIB
 /*
- * compress capture file
+ * compress capture file into "<name>.gz"; the result is written to a
+ * temporary file first and renamed when it's complete, so nobody sees
+ * a partial compressed file, and the original is removed only then
  */
-static int ringbuf_exec_compress(gchar* name)
+static void ringbuf_exec_compress(rb_compress_job *job)
 {
   guint8  *buffer = NULL;
   gchar* outgz = NULL;
+  gchar* outtmp = NULL;
   int  fd = -1;
   ssize_t nread;
-  gboolean delete_org_file = TRUE;
+  gboolean compressed = TRUE;
+  gboolean delete_org_file = FALSE;
   gzFile fi = NULL;
 
-  fd = ws_open(name, O_RDONLY | O_BINARY, 0000);
+  fd = ws_open(job->name, O_RDONLY | O_BINARY, 0000);
   if (fd < 0) {
-    return -1;
-  }
-
-  outgz = g_strdup_printf("%s.gz", name);
-  fi = gzopen(outgz, "wb");
-  g_free(outgz);
-  if (fi == NULL) {
-    ws_close(fd);
-    return -1;
-  }
-
+    compressed = FALSE;
+  } else {
+    outgz = g_strdup_printf("%s.gz", job->name);
+    outtmp = g_strdup_printf("%s.tmp", outgz);
+    fi = gzopen(outtmp, "wb");
+    if (fi == NULL) {
+      compressed = FALSE;
+    } else {
 #define FS_READ_SIZE 65536
-  buffer = (guint8*)g_malloc(FS_READ_SIZE);
-  if (buffer == NULL) {
+      buffer = (guint8*)g_malloc(FS_READ_SIZE);
+      while ((nread = ws_read(fd, buffer, FS_READ_SIZE)) > 0) {
+        int n = gzwrite(fi, buffer, (unsigned int)nread);
+        if (n <= 0) {
+          /* mark compression as failed */
+          compressed = FALSE;
+          break;
+        }
+      }
+      if (nread < 0) {
+        /* mark compression as failed */
+        compressed = FALSE;
+      }
+      if (gzclose(fi) != Z_OK) {
+        compressed = FALSE;
+      }
+      g_free(buffer);
+    }
     ws_close(fd);
-    gzclose(fi);
-    return -1;
   }
 
-  while ((nread = ws_read(fd, buffer, FS_READ_SIZE)) > 0) {
-    int n = gzwrite(fi, buffer, (unsigned int)nread);
-    if (n <= 0) {
-      /* mark compression as failed */
-      delete_org_file = FALSE;
-      break;
+  g_mutex_lock(&rb_data.mutex);
+  if (outtmp != NULL) {
+    if (compressed && !job->cancelled && ws_rename(outtmp, outgz) == 0) {
+      /* delete the original file only if compression succeeds */
+      delete_org_file = TRUE;
+    } else {
+      ws_unlink(outtmp);
     }
   }
-  if (nread < 0) {
-    /* mark compression as failed */
-    delete_org_file = FALSE;
+  if (job->owner != NULL) {
+    *job->owner = NULL;
   }
-  ws_close(fd);
-  gzclose(fi);
-  g_free(buffer);
+  g_mutex_unlock(&rb_data.mutex);
 
-  /* delete the original file only if compression succeeds */
   if (delete_org_file) {
-    ws_unlink(name);
-    CleanupOldCap(name);
+    ws_unlink(job->name);
+    CleanupOldCap(job->name);
   }
-  g_free(name);
-  return 0;
+  g_free(outgz);
+  g_free(outtmp);
+  g_free(job->name);
+  g_free(job);
 }
 
 /*
- * thread to compress capture file
+ * thread to compress capture files; it runs at a low priority, so
+ * that it doesn't get in the way of the capture
  */
-static void* exec_compress_thread(void* arg)
+static void* exec_compress_thread(void* arg _U_)
 {
-  ringbuf_exec_compress((gchar*)arg);
+  rb_compress_job *job;
+
+#ifdef _WIN32
+  SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+  /* On Linux this applies to just this thread, and its I/O priority follows it */
+  if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19) != 0) {
+    /* not fatal, we just compete with the capture for the CPU */
+  }
+#endif
+
+  while ((job = (rb_compress_job *)g_async_queue_pop(rb_data.compress_q)) != &rb_compress_stop) {
+    ringbuf_exec_compress(job);
+  }
+  return NULL;
+}
+
+/*
+ * hand a completed capture file to the compression thread
+ */
+static void ringbuf_start_compress_file(rb_file* rfile)
+{
+  rb_compress_job *job = g_new(rb_compress_job, 1);
+
+  job->name = g_strdup(rfile->name);
+  job->owner = &rfile->compress_job;
+  job->cancelled = FALSE;
+  rfile->compress_job = job;
+
+  if (rb_data.compress_thread == NULL) {
+    rb_data.compress_q = g_async_queue_new();
+    rb_data.compress_thread = g_thread_new("exec_compress", &exec_compress_thread, NULL);
+  }
+  g_async_queue_push(rb_data.compress_q, job);
+}
+#endif /* HAVE_ZLIB */
+
+/*
+ * are completed files compressed?
+ */
+static gboolean ringbuf_compressing(void)
+{
+#ifdef HAVE_ZLIB
+  return rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "gzip") == 0;
+#else
+  return FALSE;
+#endif
+}
+
+/*
+ * wait until all the completed files have been compressed
+ */
+static void ringbuf_stop_compressing(void)
+{
+  if (rb_data.compress_thread != NULL) {
+    g_async_queue_push(rb_data.compress_q, &rb_compress_stop);
+    g_thread_join(rb_data.compress_thread);
+    rb_data.compress_thread = NULL;
+    g_async_queue_unref(rb_data.compress_q);
+    rb_data.compress_q = NULL;
+  }
+}
+
+#ifdef __linux__
+/*
+ * thread to create the file we'll switch to next and allocate its space,
+ * so that neither happens in the capture loop when we switch
+ */
+static void* exec_prealloc_thread(void* arg _U_)
+{
+  int fd;
+
+  fd = ws_open(rb_data.prealloc_name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
+               rb_data.group_read_access ? 0640 : 0600);
+  if (fd != -1) {
+    /* keep the size at 0; what isn't written is given back at close */
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, rb_data.prealloc_size) != 0) {
+      /* not supported by the file system; the file is still usable */
+    }
+  }
+  rb_data.prealloc_fd = fd;
   return NULL;
 }
+#endif
+
+/*
+ * start preparing the file we'll switch to next, if we preallocate
+ */
+static void ringbuf_start_prealloc(void)
+{
+#ifdef __linux__
+  if (rb_data.prealloc_size == 0 || rb_data.prealloc_thread != NULL)
+    return;
+
+  g_free(rb_data.prealloc_name);
+  rb_data.prealloc_name = g_strconcat(rb_data.fprefix, "_next",
+                                      rb_data.fsuffix, ".tmp", NULL);
+  rb_data.prealloc_fd = -1;
+  rb_data.prealloc_thread = g_thread_new("exec_prealloc", &exec_prealloc_thread, NULL);
+#endif
+}
+
+/*
+ * wait for the prepared next file, if any; returns its descriptor, or -1
+ * if there's none, in which case it's removed if it's there
+ */
+static int ringbuf_finish_prealloc(void)
+{
+  int fd;
+
+  if (rb_data.prealloc_thread == NULL)
+    return -1;
+
+  g_thread_join(rb_data.prealloc_thread);
+  rb_data.prealloc_thread = NULL;
+  fd = rb_data.prealloc_fd;
+  rb_data.prealloc_fd = -1;
+  return fd;
+}
+
+static void ringbuf_discard_prealloc(void)
+{
+  int fd = ringbuf_finish_prealloc();
+
+  if (fd != -1)
+    ws_close(fd);
+  if (rb_data.prealloc_name != NULL) {
+    ws_unlink(rb_data.prealloc_name);
+    g_free(rb_data.prealloc_name);
+    rb_data.prealloc_name = NULL;
+  }
+}
 
 /*
- * start a thread to compress capture file
+ * the current file is about to be closed: give back what was preallocated
+ * for it but not used, and start writing back what's still only in the
+ * page cache
  */
-static int ringbuf_start_compress_file(rb_file* rfile)
+static void ringbuf_finish_file(void)
 {
-  gchar* name = g_strdup(rfile->name);
-  g_thread_new("exec_compress", &exec_compress_thread, name);
-  return 0;
+#ifdef __linux__
+  gint64 size;
+
+  if (rb_data.prealloc_size == 0 && rb_data.write_behind == 0)
+    return;
+  if (fflush(rb_data.pdh) == EOF)
+    return;   /* fclose() will report it */
+
+  size = ws_lseek64(rb_data.fd, 0, SEEK_CUR);
+  if (size < 0)
+    return;
+  if (rb_data.prealloc_size != 0 && size < rb_data.prealloc_size) {
+    if (ftruncate(rb_data.fd, size) != 0) {
+      /* the space stays allocated until the file is removed */
+    }
+  }
+  if (rb_data.write_behind != 0 && size > rb_data.wb_end) {
+    sync_file_range(rb_data.fd, rb_data.wb_end, size - rb_data.wb_end, SYNC_FILE_RANGE_WRITE);
+  }
+#endif
 }
 
 /*
@@ -211,12 +410,24 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
   struct tm *tm;
 
   if (rfile->name != NULL) {
+    /* this slot is about to get a new file; forget about the old one */
+    g_mutex_lock(&rb_data.mutex);
+    if (rfile->compress_job != NULL) {
+      /* if the old file is removed, don't keep its compressed version */
+      rfile->compress_job->cancelled = !rb_data.unlimited;
+      rfile->compress_job->owner = NULL;
+      rfile->compress_job = NULL;
+    }
+    g_mutex_unlock(&rb_data.mutex);
     if (rb_data.unlimited == FALSE) {
       /* remove old file (if any, so ignore error) */
       ws_unlink(rfile->name);
-    }
-    else if (rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "gzip") == 0) {
-      ringbuf_start_compress_file(rfile);
+      if (ringbuf_compressing()) {
+        /* or what it was compressed to */
+        gchar *gzname = g_strdup_printf("%s.gz", rfile->name);
+        ws_unlink(gzname);
+        g_free(gzname);
+      }
     }
     g_free(rfile->name);
   }
@@ -241,11 +452,25 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
     return -1;
   }
 
-  rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
-                            rb_data.group_read_access ? 0640 : 0600);
+  /* use the prepared file if there is one and it can be given its name */
+  rb_data.fd = ringbuf_finish_prealloc();
+  if (rb_data.fd != -1 && ws_rename(rb_data.prealloc_name, rfile->name) != 0) {
+    ws_close(rb_data.fd);
+    ws_unlink(rb_data.prealloc_name);
+    rb_data.fd = -1;
+  }
+  if (rb_data.fd == -1) {
+    rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
+                              rb_data.group_read_access ? 0640 : 0600);
+  }
 
-  if (rb_data.fd == -1 && err != NULL) {
-    *err = errno;
+  if (rb_data.fd == -1) {
+    if (err != NULL) {
+      *err = errno;
+    }
+  } else {
+    rb_data.wb_start = rb_data.wb_end = 0;
+    ringbuf_start_prealloc();
   }
 
   return rb_data.fd;
@@ -272,6 +497,11 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   rb_data.group_read_access = group_read_access;
   rb_data.name_h = NULL;
   rb_data.compress_type = compress_type;
+  rb_data.prealloc_size = 0;
+  rb_data.prealloc_name = NULL;
+  rb_data.prealloc_thread = NULL;
+  rb_data.prealloc_fd = -1;
+  rb_data.write_behind = 0;
   g_mutex_init(&rb_data.mutex);
 
   /* just to be sure ... */
@@ -331,6 +561,7 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
 
   for (i=0; i < rb_data.num_files; i++) {
     rb_data.files[i].name = NULL;
+    rb_data.files[i].compress_job = NULL;
   }
 
   /* create the first file */
@@ -342,6 +573,63 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   return rb_data.fd;
 }
 
+/*
+ * Set how much space to allocate for each file before switching to it,
+ * in the background; 0 turns that off.
+ */
+void
+ringbuf_set_prealloc(gint64 size)
+{
+  rb_data.prealloc_size = size;
+  if (size != 0 && rb_data.fd != -1) {
+    /* prepare the file after the current one */
+    ringbuf_start_prealloc();
+  }
+}
+
+/*
+ * Set how often to write back what's been written to the current file,
+ * and to drop what was written back the previous time from the page
+ * cache; 0 turns that off.
+ */
+void
+ringbuf_set_write_behind(gint64 size)
+{
+  rb_data.write_behind = size;
+}
+
+/*
+ * Called with the number of bytes written to the current file so far.
+ * Once another write_behind bytes have been written, wait for the
+ * previous range to be on disk and drop it from the page cache, and
+ * start writing back the new one, so that dirty pages don't pile up
+ * until the kernel writes them in a burst.
+ */
+void
+ringbuf_write_behind(gint64 bytes_written)
+{
+#ifdef __linux__
+  if (rb_data.write_behind == 0 || rb_data.pdh == NULL ||
+      bytes_written - rb_data.wb_end < rb_data.write_behind)
+    return;
+
+  if (fflush(rb_data.pdh) == EOF)
+    return;   /* the next write will report it */
+
+  if (rb_data.wb_end > rb_data.wb_start) {
+    sync_file_range(rb_data.fd, rb_data.wb_start, rb_data.wb_end - rb_data.wb_start,
+                    SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER);
+    posix_fadvise(rb_data.fd, rb_data.wb_start, rb_data.wb_end - rb_data.wb_start,
+                  POSIX_FADV_DONTNEED);
+  }
+  sync_file_range(rb_data.fd, rb_data.wb_end, bytes_written - rb_data.wb_end, SYNC_FILE_RANGE_WRITE);
+  rb_data.wb_start = rb_data.wb_end;
+  rb_data.wb_end = bytes_written;
+#else
+  (void)bytes_written;
+#endif
+}
+
 /*
  * Set name of file to which to print ringbuffer file names.
  */
@@ -427,6 +715,7 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
 
   /* close current file */
 
+  ringbuf_finish_file();
   if (fclose(rb_data.pdh) == EOF) {
     if (err != NULL) {
       *err = errno;
@@ -447,6 +736,13 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
     fflush(rb_data.name_h);
   }
 
+#ifdef HAVE_ZLIB
+  /* compress the file we're done with in the background */
+  if (ringbuf_compressing()) {
+    ringbuf_start_compress_file(&rb_data.files[rb_data.curr_file_num % rb_data.num_files]);
+  }
+#endif
+
   /* get the next file number and open it */
 
   rb_data.curr_file_num++ /* = next_file_num*/;
@@ -461,6 +757,8 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
     return FALSE;
   }
 
+  WS_PROBE1(ringbuf_switch, rb_data.curr_file_num);
+
   /* switch to the new file */
   *save_file = next_rfile->name;
   *save_file_fd = rb_data.fd;
@@ -479,6 +777,7 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 
   /* close current file, if it's open */
   if (rb_data.pdh != NULL) {
+    ringbuf_finish_file();
     if (fclose(rb_data.pdh) == EOF) {
       if (err != NULL) {
         *err = errno;
@@ -515,6 +814,10 @@ ringbuf_free(void)
 {
   unsigned int i;
 
+  /* this also makes sure no compression job refers to our files any more */
+  ringbuf_stop_compressing();
+  ringbuf_discard_prealloc();
+
   if (rb_data.files != NULL) {
     for (i=0; i < rb_data.num_files; i++) {
       if (rb_data.files[i].name != NULL) {
@@ -33,6 +33,9 @@ gboolean ringbuf_libpcap_dump_close(gchar **save_file, int *err);
 void ringbuf_free(void);
 void ringbuf_error_cleanup(void);
 gboolean ringbuf_set_print_name(gchar *name, int *err);
+void ringbuf_set_prealloc(gint64 size);
+void ringbuf_set_write_behind(gint64 size);
+void ringbuf_write_behind(gint64 bytes_written);
 
 #endif /* ringbuffer.h */
 
@@ -29,6 +29,7 @@
 #include <wsutil/file_util.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
+#include <wsutil/startup_profile.h>
 #include <version_info.h>
 #include <wiretap/wtap_opttypes.h>
 
@@ -72,6 +73,7 @@ capture_file cfile;
 
 static guint32 cum_bytes;
 static frame_data ref_frame;
+static gboolean tailing;       /* the sequential side was kept open by the load */
 
 static void sharkd_cmdarg_err(const char *msg_format, va_list ap);
 static void sharkd_cmdarg_err_cont(const char *msg_format, va_list ap);
@@ -191,6 +193,9 @@ main(int argc, char *argv[])
   /* Build the column format array */
   build_column_format_array(&cfile.cinfo, prefs_p->num_cols, TRUE);
 
+  /* We're done starting up; write the --startup-profile report. */
+  startup_profile_write();
+
 #ifdef HAVE_MAXMINDDB
   /* mmdbresolve is started from mmdb_resolve_start(), which is called from epan_load_settings via: read_prefs -> (...) uat_load_all -> maxmind_db_post_update_cb.
    * Need to stop it, otherwise all sharkd will have same mmdbresolve process, including pipe descriptors to read and write. */
@@ -325,7 +330,7 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
 
 
 static int
-load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
+load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count, gboolean tail)
 {
   int          err;
   gchar       *err_info = NULL;
@@ -385,12 +390,18 @@ load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
 
-    /* Close the sequential I/O side, to free up memory it requires. */
-    wtap_sequential_close(cf->provider.wth);
-
-    /* Allow the protocol dissectors to free up memory that they
-     * don't need after the sequential run-through of the packets. */
-    postseq_cleanup_all_protocols();
+    if (tail) {
+      /* Keep reading from here, and keep the first pass state, for
+       * sharkd_tail_cap_file(). */
+      tailing = TRUE;
+    } else {
+      /* Close the sequential I/O side, to free up memory it requires. */
+      wtap_sequential_close(cf->provider.wth);
+
+      /* Allow the protocol dissectors to free up memory that they
+       * don't need after the sequential run-through of the packets. */
+      postseq_cleanup_all_protocols();
+    }
 
     cf->provider.prev_dis = NULL;
     cf->provider.prev_cap = NULL;
@@ -416,6 +427,7 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   /* The open succeeded.  Fill in the information for this file. */
 
   cf->provider.wth = wth;
+  cap_file_provider_init_record_cache(&cf->provider);
   cf->f_datalen = 0; /* not used, but set it anyway */
 
   /* Set the file name because we need it to set the follow stream filter.
@@ -439,6 +451,7 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   cf->provider.ref = NULL;
   cf->provider.prev_dis = NULL;
   cf->provider.prev_cap = NULL;
+  tailing = FALSE;
 
   /* Create new epan session for dissection. */
   epan_free(cf->epan);
@@ -485,9 +498,73 @@ sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *
 }
 
 int
-sharkd_load_cap_file(void)
+sharkd_load_cap_file(gboolean tail)
 {
-  return load_cap_file(&cfile, 0, 0);
+  return load_cap_file(&cfile, 0, 0, tail);
+}
+
+/*
+ * Reopen the random side of the loaded file, so that a process forked
+ * after the load doesn't share the file offset with the others.
+ */
+int
+sharkd_reopen_cap_file(void)
+{
+  int err = 0;
+
+  if (cfile.provider.wth != NULL && !wtap_fdreopen(cfile.provider.wth, cfile.filename, &err))
+    cfile_open_failure_message(cfile.filename, err, NULL);
+
+  return err;
+}
+
+/*
+ * Read the records written to the file since it was loaded, with tail
+ * set, or since the last call.  Returns the number of new frames, or -1
+ * on an error or if the file wasn't loaded that way, with *err set to 0
+ * in the latter case.
+ */
+int
+sharkd_tail_cap_file(int *err)
+{
+  capture_file *cf = &cfile;
+  guint32       old_count = cf->count;
+  gchar        *err_info = NULL;
+  gint64        data_offset;
+  wtap_rec      rec;
+  Buffer        buf;
+  epan_dissect_t *edt;
+
+  *err = 0;
+  if (!tailing)
+    return -1;
+
+  edt = epan_dissect_new(cf->epan,
+                         cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids(),
+                         FALSE);
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+
+  /* Carry on from the last frame, as the load did. */
+  if (cf->count != 0)
+    cf->provider.prev_cap = cf->provider.prev_dis = sharkd_get_frame(cf->count);
+
+  while (wtap_read_tail(cf->provider.wth, &rec, &buf, err, &err_info, &data_offset))
+    process_packet(cf, edt, data_offset, &rec, &buf);
+
+  epan_dissect_free(edt);
+  wtap_rec_cleanup(&rec);
+  ws_buffer_free(&buf);
+
+  cf->provider.prev_dis = NULL;
+  cf->provider.prev_cap = NULL;
+
+  if (*err != 0) {
+    cfile_read_failure_message(cf->filename, *err, err_info);
+    return -1;
+  }
+
+  return (int) (cf->count - old_count);
 }
 
 frame_data *
@@ -516,7 +593,7 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num, guint32 prev_dis
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
 
-  if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info)) {
+  if (!cap_file_provider_read_record(&cfile.provider, fdata->num, fdata->file_off, &rec, &buf, &err, &err_info)) {
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
     return -1; /* error reading the record */
@@ -576,7 +653,7 @@ sharkd_dissect_columns(frame_data *fdata, guint32 frame_ref_num, guint32 prev_di
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
 
-  if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info)) {
+  if (!cap_file_provider_read_record(&cfile.provider, fdata->num, fdata->file_off, &rec, &buf, &err, &err_info)) {
     col_fill_in_error(cinfo, fdata, FALSE, FALSE /* fill_fd_columns */);
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
@@ -617,6 +694,30 @@ sharkd_dissect_columns(frame_data *fdata, guint32 frame_ref_num, guint32 prev_di
   return 0;
 }
 
+/* How many frames long requests go through between calls to poll_func. */
+#define SHARKD_POLL_FRAMES 256
+
+static sharkd_poll_func_t poll_func = NULL;
+
+void
+sharkd_set_poll_func(sharkd_poll_func_t func)
+{
+  poll_func = func;
+}
+
+static gboolean
+sharkd_poll(guint32 framenum)
+{
+  if (poll_func == NULL || (framenum % SHARKD_POLL_FRAMES) != 0)
+    return TRUE;
+  return poll_func();
+}
+
+/*
+ * Run all frames through the registered tap listeners.  The caller
+ * draws them; returns -1, without having gone through all the frames,
+ * if the request was cancelled.
+ */
 int
 sharkd_retap(void)
 {
@@ -631,6 +732,7 @@ sharkd_retap(void)
   gboolean      create_proto_tree;
   epan_dissect_t edt;
   column_info   *cinfo;
+  gboolean      cancelled = FALSE;
 
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
@@ -656,9 +758,14 @@ sharkd_retap(void)
   reset_tap_listeners();
 
   for (framenum = 1; framenum <= cfile.count; framenum++) {
+    if (!sharkd_poll(framenum)) {
+      cancelled = TRUE;
+      break;
+    }
+
     fdata = sharkd_get_frame(framenum);
 
-    if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
+    if (!cap_file_provider_read_record(&cfile.provider, fdata->num, fdata->file_off, &rec, &buf, &err, &err_info))
       break;
 
     fdata->ref_time = FALSE;
@@ -674,9 +781,7 @@ sharkd_retap(void)
   ws_buffer_free(&buf);
   epan_dissect_cleanup(&edt);
 
-  draw_tap_listeners(TRUE);
-
-  return 0;
+  return cancelled ? -1 : 0;
 }
 
 int
@@ -693,6 +798,7 @@ sharkd_filter(const char *dftext, guint8 **result)
 
   guint8 *result_bits;
   guint8  passed_bits;
+  gboolean cancelled = FALSE;
 
   epan_dissect_t edt;
 
@@ -717,14 +823,21 @@ sharkd_filter(const char *dftext, guint8 **result)
   result_bits = (guint8 *) g_malloc(2 + (frames_count / 8));
 
   for (framenum = 1; framenum <= frames_count; framenum++) {
-    frame_data *fdata = sharkd_get_frame(framenum);
+    frame_data *fdata;
+
+    if (!sharkd_poll(framenum)) {
+      cancelled = TRUE;
+      break;
+    }
+
+    fdata = sharkd_get_frame(framenum);
 
     if ((framenum & 7) == 0) {
       result_bits[(framenum / 8) - 1] = passed_bits;
       passed_bits = 0;
     }
 
-    if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
+    if (!cap_file_provider_read_record(&cfile.provider, fdata->num, fdata->file_off, &rec, &buf, &err, &err_info))
       break;
 
     /* frame_data_set_before_dissect */
@@ -757,6 +870,11 @@ sharkd_filter(const char *dftext, guint8 **result)
 
   dfilter_free(dfcode);
 
+  if (cancelled) {
+    g_free(result_bits);
+    return -2;
+  }
+
   *result = result_bits;
 
   return framenum;
@@ -27,9 +27,14 @@
 
 typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, struct epan_column_info *cinfo, const GSList *data_src, void *data);
 
+/* Called now and then during long requests; returns FALSE to cancel the request. */
+typedef gboolean (*sharkd_poll_func_t)(void);
+
 /* sharkd.c */
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err);
-int sharkd_load_cap_file(void);
+int sharkd_load_cap_file(gboolean tail);
+int sharkd_tail_cap_file(int *err);
+int sharkd_reopen_cap_file(void);
 int sharkd_retap(void);
 int sharkd_filter(const char *dftext, guint8 **result);
 frame_data *sharkd_get_frame(guint32 framenum);
@@ -38,6 +43,7 @@ int sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num, guint32 prev
 const char *sharkd_get_user_comment(const frame_data *fd);
 int sharkd_set_user_comment(frame_data *fd, const gchar *new_comment);
 const char *sharkd_version(void);
+void sharkd_set_poll_func(sharkd_poll_func_t func);
 
 /* sharkd_daemon.c */
 int sharkd_init(int argc, char **argv);
@@ -45,6 +51,8 @@ int sharkd_loop(int argc _U_, char* argv[] _U_);
 
 /* sharkd_session.c */
 int sharkd_session_main(int mode_setting);
+void sharkd_session_set_column_cache_size(guint entries);
+void sharkd_session_share_columns(void);
 
 #endif /* __SHARKD_H */
 
@@ -25,6 +25,7 @@
 #endif
 
 #include <wsutil/filesystem.h>
+#include <wsutil/file_util.h>
 #include <wsutil/socket.h>
 #include <wsutil/inet_addr.h>
 #include <wsutil/please_report_bug.h>
@@ -47,7 +48,9 @@
 #endif
 
 #include <wsutil/strtoi.h>
+#include <wsutil/startup_profile.h>
 #include <version_info.h>
+#include <ui/clopts_common.h>
 
 #include "sharkd.h"
 
@@ -62,6 +65,10 @@
 static int mode = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
 
+/* Session processes forked ahead of connections, and the file they start with. */
+static guint32 _pool_size = 0;
+static const char *_preload_file = NULL;
+
 static socket_handle_t
 socket_init(char *path)
 {
@@ -188,15 +195,29 @@ print_usage(FILE* output)
 	fprintf(output, "Gold (gold_options):\n");
 	fprintf(output, "  -a <socket>, --api <socket>\n");
 	fprintf(output, "                           listen on this socket\n");
+	fprintf(output, "  -c <entries>, --column-cache <entries>\n");
+	fprintf(output, "                           keep the columns of this many listed frames\n");
+	fprintf(output, "                           (default 10000; 0 to not keep any)\n");
 	fprintf(output, "  -h, --help               show this help information\n");
+	fprintf(output, "  -l <file>, --load <file>\n");
+	fprintf(output, "                           load this file before taking connections, so\n");
+	fprintf(output, "                           that sessions start with it, and with the\n");
+	fprintf(output, "                           columns of its frames\n");
 	fprintf(output, "  -v, --version            show version information\n");
+	fprintf(output, "  -w <count>, --workers <count>\n");
+	fprintf(output, "                           keep this many session processes ready for\n");
+	fprintf(output, "                           new connections (default 0; UN*X only)\n");
 	fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
 	fprintf(output, "                           start with specified configuration profile\n");
+	fprintf(output, "  --startup-profile <file>\n");
+	fprintf(output, "                           write a breakdown of the startup time to this\n");
+	fprintf(output, "                           file as JSON\n");
 
 	fprintf(output, "\n");
 	fprintf(output, "  Examples:\n");
 	fprintf(output, "    sharkd -C myprofile\n");
 	fprintf(output, "    sharkd -a tcp:127.0.0.1:4446 -C myprofile\n");
+	fprintf(output, "    sharkd -a unix:/tmp/sharkd.sock -w 4 -l /tmp/big.pcapng\n");
 
 	fprintf(output, "\n");
 	fprintf(output, "See the sharkd page of the Wireshark wiki for full details.\n");
@@ -226,16 +247,20 @@ sharkd_init(int argc, char **argv)
 	 * platform-dependent.
 	 */
 
-#define OPTSTRING "+" "a:hmvC:"
+#define OPTSTRING "+" "a:c:hl:mvw:C:"
+#define LONGOPT_STARTUP_PROFILE LONGOPT_BASE_APPLICATION+1
 
 	static const char    optstring[] = OPTSTRING;
 
-	// right now we don't have any long options
 	static const struct option long_options[] = {
 	  {"api", required_argument, NULL, 'a'},
+	  {"column-cache", required_argument, NULL, 'c'},
 	  {"help", no_argument, NULL, 'h'},
+	  {"load", required_argument, NULL, 'l'},
 	  {"version", no_argument, NULL, 'v'},
+	  {"workers", required_argument, NULL, 'w'},
 	  {"config-profile", required_argument, NULL, 'C'},
+	  {"startup-profile", required_argument, NULL, LONGOPT_STARTUP_PROFILE},
 	  {0, 0, 0, 0 }
 	};
 
@@ -320,11 +345,27 @@ sharkd_init(int argc, char **argv)
 				mode = SHARKD_MODE_GOLD_DAEMON;
 				break;
 
+			case 'c':
+			{
+				guint32 entries;
+
+				if (!ws_strtou32(optarg, NULL, &entries)) {
+					fprintf(stderr, "Invalid column cache size \"%s\"\n", optarg);
+					return -1;
+				}
+				sharkd_session_set_column_cache_size(entries);
+				break;
+			}
+
 			case 'h':
 				print_usage(stderr);
 				exit(0);
 				break;
 
+			case 'l':
+				_preload_file = optarg;
+				break;
+
 			case 'm':
 				// m is an internal-only option used when the daemon session process is created
 				mode = SHARKD_MODE_GOLD_CONSOLE;
@@ -335,6 +376,22 @@ sharkd_init(int argc, char **argv)
 				exit(0);
 				break;
 
+			case 'w':
+				if (!ws_strtou32(optarg, NULL, &_pool_size)) {
+					fprintf(stderr, "Invalid number of workers \"%s\"\n", optarg);
+					return -1;
+				}
+#ifdef _WIN32
+				if (_pool_size != 0)
+					fprintf(stderr, "Session processes can't be started ahead on Windows, ignoring -w\n");
+				_pool_size = 0;
+#endif
+				break;
+
+			case LONGOPT_STARTUP_PROFILE:
+				startup_profile_enable("sharkd", optarg);
+				break;
+
 			default:
 				if (!optopt)
 					fprintf(stderr, "This option isn't supported: %s\n", argv[optind]);
@@ -364,6 +421,133 @@ sharkd_init(int argc, char **argv)
 	return 0;
 }
 
+/*
+ * Load the -l file in the daemon, so that the session processes forked
+ * from it share its frames, copy-on-write, rather than each doing the
+ * first pass again.  Their default columns are worked out here too, for
+ * the same reason.
+ */
+static void
+sharkd_preload(void)
+{
+	int err = 0;
+
+	if (!_preload_file)
+		return;
+
+#ifdef _WIN32
+	/* session processes are started afresh, with -l, and load it themselves */
+	if (mode == SHARKD_MODE_GOLD_DAEMON)
+		return;
+#endif
+
+	fprintf(stderr, "load: filename=%s\n", _preload_file);
+
+	if (sharkd_cf_open(_preload_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
+		return;
+
+	err = sharkd_load_cap_file(FALSE);
+	if (err != 0)
+	{
+		fprintf(stderr, "load: %s\n", g_strerror(err));
+		return;
+	}
+
+	if (mode == SHARKD_MODE_CLASSIC_DAEMON || mode == SHARKD_MODE_GOLD_DAEMON)
+		sharkd_session_share_columns();
+}
+
+#ifndef _WIN32
+/*
+ * A session process forked ahead: wait for a connection, then tell the
+ * daemon, through ready_fd, to fork another one in its place.
+ */
+static int
+sharkd_pool_worker(int ready_fd)
+{
+	socket_handle_t fd;
+
+	do
+	{
+		fd = accept(_server_fd, NULL, NULL);
+		if (fd == INVALID_SOCKET && errno != EINTR)
+			fprintf(stderr, "cannot accept(): %s\n", g_strerror(errno));
+	} while (fd == INVALID_SOCKET);
+
+	if (ws_write(ready_fd, "", 1) != 1)
+		fprintf(stderr, "cannot notify the daemon: %s\n", g_strerror(errno));
+	ws_close(ready_fd);
+
+	closesocket(_server_fd);
+	/* redirect stdin, stdout to socket */
+	dup2(fd, 0);
+	dup2(fd, 1);
+	close(fd);
+
+	sharkd_reopen_cap_file();
+
+	return sharkd_session_main(mode);
+}
+
+/*
+ * Keep _pool_size session processes waiting in accept() on the listening
+ * socket, starting another one each time one of them gets a connection.
+ */
+static int
+sharkd_pool_loop(void)
+{
+	int ready[2];
+	guint32 idle = 0;
+
+	if (pipe(ready) == -1)
+	{
+		fprintf(stderr, "cannot create pipe: %s\n", g_strerror(errno));
+		return 1;
+	}
+
+	/* the session processes aren't waited for */
+	signal(SIGCHLD, SIG_IGN);
+
+	for (;;)
+	{
+		char c;
+
+		while (idle < _pool_size)
+		{
+			pid_t pid = fork();
+
+			if (pid == 0)
+			{
+				ws_close(ready[0]);
+				exit(sharkd_pool_worker(ready[1]));
+			}
+
+			if (pid == -1)
+			{
+				fprintf(stderr, "cannot fork(): %s\n", g_strerror(errno));
+				break;
+			}
+			idle++;
+		}
+
+		if (idle == 0)
+		{
+			/* couldn't fork any, try again later */
+			g_usleep(G_USEC_PER_SEC);
+			continue;
+		}
+
+		if (ws_read(ready[0], &c, 1) == 1)
+			idle--;
+		else if (errno != EINTR)
+		{
+			fprintf(stderr, "cannot read from pipe: %s\n", g_strerror(errno));
+			return 1;
+		}
+	}
+}
+#endif
+
 int
 #ifndef _WIN32
 sharkd_loop(int argc _U_, char* argv[] _U_)
@@ -371,11 +555,18 @@ sharkd_loop(int argc _U_, char* argv[] _U_)
 sharkd_loop(int argc _U_, char* argv[])
 #endif
 {
+	sharkd_preload();
+
 	if (mode == SHARKD_MODE_CLASSIC_CONSOLE || mode == SHARKD_MODE_GOLD_CONSOLE)
 	{
 		return sharkd_session_main(mode);
 	}
 
+#ifndef _WIN32
+	if (_pool_size > 0)
+		return sharkd_pool_loop();
+#endif
+
 	while (1)
 	{
 #ifndef _WIN32
@@ -406,6 +597,8 @@ sharkd_loop(int argc _U_, char* argv[])
 			dup2(fd, 1);
 			close(fd);
 
+			sharkd_reopen_cap_file();
+
 			exit(sharkd_session_main(mode));
 		}
 
@@ -34,6 +34,7 @@
 #include <epan/column.h>
 
 #include <ui/ssl_key_export.h>
+#include <ui/follow_files.h>
 
 #include <ui/io_graph_item.h>
 #include <epan/stats_tree_priv.h>
@@ -67,6 +68,7 @@
 
 #include <wsutil/pint.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/filesystem.h>
 
 #include "globals.h"
 
@@ -84,11 +86,121 @@ gboolean extended_log = FALSE;
 
 static json_dumper dumper = {0};
 
+/*
+ * Lines read from stdin by sharkd_session_reader(), and those set aside
+ * by sharkd_session_poll() to be processed after the current request.
+ */
+static GAsyncQueue *req_queue = NULL;
+/* Largest length-prefixed request we accept */
+#define SHARKD_MAX_REQUEST_LEN (64 * 1024 * 1024)
+static GQueue req_pending = G_QUEUE_INIT;
+
+/*
+ * Column text of recently listed frames, most recently used first, so
+ * that paging back and forth through the frame list doesn't dissect the
+ * same frames again.  Cleared whenever something that might change the
+ * text does.
+ */
+struct sharkd_column_cache_entry
+{
+	char *key;     /* frame, reference frame, previous frame and columns */
+	char **cols;
+	GList link;
+};
+
+static GHashTable *column_cache = NULL;
+static GQueue column_cache_lru = G_QUEUE_INIT;
+static guint column_cache_max = 10000;
+
+/*
+ * Column text of every frame of the file the daemon loads before taking
+ * connections, with the default columns, every frame displayed and no
+ * time references: what a web UI pages through first.  The daemon fills
+ * it in before forking the session processes and nobody changes it
+ * afterwards, so they all share its pages; a session that clears its
+ * column cache stops using it.
+ */
+static GStringChunk *shared_columns_text = NULL;
+static char **shared_columns = NULL;  /* shared_columns_num_cols per frame, from frame 1 */
+static guint32 shared_columns_frames = 0;
+static int shared_columns_num_cols = 0;
+
+/*
+ * Output of taps, by tap string, for tap requests that ask for the same
+ * tap again.  Cleared along with the column cache, and when frames are
+ * added.
+ */
+static GHashTable *tap_cache = NULL;
+
+#define SHARKD_TAP_CACHE_MAX_OUTPUT (1024 * 1024) /* don't keep bigger outputs */
+#define SHARKD_TAP_REQUESTS_MAX 16                /* tap requests sharing a pass */
+
+static const char *req_id = NULL;      /* "id" of the request being replied to */
+static char *req_running_id = NULL;    /* "id" of the request sharkd_session_main() is running */
+static gboolean req_cancelled = FALSE;
+
+/* Check the file loaded with tail for new frames whenever we're idle. */
+static gboolean tail_follow = FALSE;
+#define SHARKD_TAIL_FOLLOW_INTERVAL 1000000 /* microseconds */
+
+/*
+ * Attributes of the requests being processed, by name, so that looking
+ * one up (e.g. "column0" ... "columnN") doesn't scan the tokens each
+ * time.  A status, complete or cancel request can be processed while
+ * another one is running, hence the second level.
+ */
+#define SHARKD_ATTR_INDEX_DEPTH 2
+static struct {
+	const jsmntok_t *tokens;
+	GHashTable *attrs;         /* name -> value, both pointing into the request buffer */
+} attr_index[SHARKD_ATTR_INDEX_DEPTH];
+static int attr_index_depth = 0;
+
+static void
+sharkd_session_index_push(const char *buf, const jsmntok_t *tokens, int count)
+{
+	if (attr_index_depth < SHARKD_ATTR_INDEX_DEPTH)
+	{
+		GHashTable *attrs = attr_index[attr_index_depth].attrs;
+		int i;
+
+		if (attrs)
+			g_hash_table_remove_all(attrs);
+		else
+			attrs = attr_index[attr_index_depth].attrs = g_hash_table_new(g_str_hash, g_str_equal);
+
+		for (i = 0; i < count; i += 2)
+		{
+			const char *tok_attr = &buf[tokens[i + 0].start];
+
+			/* the first one wins, as with a scan */
+			if (!g_hash_table_contains(attrs, tok_attr))
+				g_hash_table_insert(attrs, (gpointer) tok_attr, (gpointer) &buf[tokens[i + 1].start]);
+		}
+		attr_index[attr_index_depth].tokens = tokens;
+	}
+	attr_index_depth++;
+}
+
+static void
+sharkd_session_index_pop(void)
+{
+	attr_index_depth--;
+	if (attr_index_depth < SHARKD_ATTR_INDEX_DEPTH)
+		attr_index[attr_index_depth].tokens = NULL;
+}
+
 static const char *
 json_find_attr(const char *buf, const jsmntok_t *tokens, int count, const char *attr)
 {
 	int i;
 
+	for (i = MIN(attr_index_depth, SHARKD_ATTR_INDEX_DEPTH) - 1; i >= 0; i--)
+	{
+		if (attr_index[i].tokens == tokens)
+			return (const char *) g_hash_table_lookup(attr_index[i].attrs, attr);
+	}
+
 	for (i = 0; i < count; i += 2)
 	{
 		const char *tok_attr  = &buf[tokens[i + 0].start];
@@ -170,6 +282,13 @@ sharkd_json_array_close(void)
 	json_dumper_end_array(&dumper);
 }
 
+static void
+sharkd_json_value_id(void)
+{
+	if (req_id)
+		sharkd_json_value_string("id", req_id);
+}
+
 static void
 sharkd_json_simple_reply(int err, const char *errmsg)
 {
@@ -177,11 +296,140 @@ sharkd_json_simple_reply(int err, const char *errmsg)
 	sharkd_json_value_anyf("err", "%d", err);
 	if (errmsg)
 		sharkd_json_value_string("errmsg", errmsg);
+	sharkd_json_value_id();
 
 	json_dumper_end_object(&dumper);
 	json_dumper_finish(&dumper);
 }
 
+void
+sharkd_session_set_column_cache_size(guint entries)
+{
+	column_cache_max = entries;
+}
+
+static void
+sharkd_column_cache_entry_free(gpointer data)
+{
+	struct sharkd_column_cache_entry *entry = (struct sharkd_column_cache_entry *) data;
+
+	g_free(entry->key);
+	g_strfreev(entry->cols);
+	g_free(entry);
+}
+
+static void
+sharkd_column_cache_clear(void)
+{
+	/*
+	 * Don't free it: in a session process that would only unshare the
+	 * pages the daemon still has.
+	 */
+	shared_columns = NULL;
+	shared_columns_frames = 0;
+
+	if (!column_cache)
+		return;
+
+	g_hash_table_remove_all(column_cache);
+	g_queue_init(&column_cache_lru);
+}
+
+static void
+sharkd_tap_cache_clear(void)
+{
+	if (tap_cache)
+		g_hash_table_remove_all(tap_cache);
+}
+
+static char **
+sharkd_column_cache_lookup(const char *key)
+{
+	struct sharkd_column_cache_entry *entry;
+
+	if (!column_cache)
+		return NULL;
+
+	entry = (struct sharkd_column_cache_entry *) g_hash_table_lookup(column_cache, key);
+	if (!entry)
+		return NULL;
+
+	g_queue_unlink(&column_cache_lru, &entry->link);
+	g_queue_push_head_link(&column_cache_lru, &entry->link);
+	return entry->cols;
+}
+
+/* Takes ownership of key. */
+static void
+sharkd_column_cache_add(char *key, const column_info *cinfo)
+{
+	struct sharkd_column_cache_entry *entry;
+	int col;
+
+	if (!column_cache)
+		column_cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, sharkd_column_cache_entry_free);
+
+	while (column_cache_lru.length >= column_cache_max)
+	{
+		GList *oldest = g_queue_pop_tail_link(&column_cache_lru);
+
+		g_hash_table_remove(column_cache, ((struct sharkd_column_cache_entry *) oldest->data)->key);
+	}
+
+	entry = g_new(struct sharkd_column_cache_entry, 1);
+	entry->key = key;
+	entry->cols = g_new(char *, cinfo->num_cols + 1);
+	for (col = 0; col < cinfo->num_cols; ++col)
+		entry->cols[col] = g_strdup(cinfo->columns[col].col_data);
+	entry->cols[cinfo->num_cols] = NULL;
+	entry->link.data = entry;
+	entry->link.prev = entry->link.next = NULL;
+
+	g_hash_table_insert(column_cache, entry->key, entry);
+	g_queue_push_head_link(&column_cache_lru, &entry->link);
+}
+
+/*
+ * Fill in the shared columns for the loaded file.  Called by the daemon,
+ * once the file is loaded and before any session process is forked.
+ */
+void
+sharkd_session_share_columns(void)
+{
+	column_info *cinfo = &cfile.cinfo;
+	guint32 framenum;
+	int col;
+
+	if (column_cache_max == 0 || cfile.count == 0 || cinfo->num_cols == 0)
+		return;
+
+	shared_columns_text = g_string_chunk_new(64 * 1024);
+	shared_columns = g_new(char *, (gsize) cfile.count * cinfo->num_cols);
+	shared_columns_num_cols = cinfo->num_cols;
+
+	for (framenum = 1; framenum <= cfile.count; framenum++)
+	{
+		frame_data *fdata = sharkd_get_frame(framenum);
+		char **cols = &shared_columns[(gsize) (framenum - 1) * shared_columns_num_cols];
+
+		sharkd_dissect_columns(fdata, (framenum != 1) ? 1 : 0, framenum - 1, cinfo, (fdata->color_filter == NULL));
+		for (col = 0; col < shared_columns_num_cols; ++col)
+			cols[col] = g_string_chunk_insert_const(shared_columns_text, cinfo->columns[col].col_data);
+	}
+	shared_columns_frames = cfile.count;
+}
+
+static char **
+sharkd_shared_columns_lookup(guint32 framenum, guint32 ref_frame, guint32 prev_dis_num)
+{
+	if (framenum > shared_columns_frames)
+		return NULL;
+	if (ref_frame != ((framenum != 1) ? 1 : 0) || prev_dis_num != framenum - 1)
+		return NULL;
+
+	return &shared_columns[(gsize) (framenum - 1) * shared_columns_num_cols];
+}
+
 static void
 sharkd_session_filter_free(gpointer data)
 {
@@ -203,7 +451,7 @@ sharkd_session_filter_data(const char *filter)
 
 		int ret = sharkd_filter(filter, &filtered);
 
-		if (ret == -1)
+		if (ret < 0)
 			return NULL;
 
 		l = g_new(struct sharkd_filter_item, 1);
@@ -533,6 +781,7 @@ sharkd_session_process_info(void)
  *
  * Input:
  *   (m) file - file to be loaded
+ *   (o) tail - if "true", keep the file open for tail requests, as it's still being written
  *
  * Output object with attributes:
  *   (m) err - error code
@@ -541,6 +790,7 @@ static void
 sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 {
 	const char *tok_file = json_find_attr(buf, tokens, count, "file");
+	const char *tok_tail = json_find_attr(buf, tokens, count, "tail");
 	int err = 0;
 
 	if (!tok_file)
@@ -548,6 +798,10 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 	fprintf(stderr, "load: filename=%s\n", tok_file);
 
+	sharkd_column_cache_clear();
+	sharkd_tap_cache_clear();
+	tail_follow = FALSE;
+
 	if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
 	{
 		sharkd_json_simple_reply(err, NULL);
@@ -556,7 +810,7 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 	TRY
 	{
-		err = sharkd_load_cap_file();
+		err = sharkd_load_cap_file(tok_tail && !strcmp(tok_tail, "true"));
 	}
 	CATCH(OutOfMemoryError)
 	{
@@ -568,6 +822,112 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 	sharkd_json_simple_reply(err, NULL);
 }
 
+/*
+ * Read the frames written to the file since the last load or tail, and
+ * drop the filter results, as they only cover the frames we had.
+ * Returns the number of new frames, or -1.
+ */
+static int
+sharkd_session_tail(int *err)
+{
+	int frames = -1;
+
+	TRY
+	{
+		frames = sharkd_tail_cap_file(err);
+	}
+	CATCH(OutOfMemoryError)
+	{
+		fprintf(stderr, "tail: OutOfMemoryError\n");
+		*err = ENOMEM;
+	}
+	ENDTRY;
+
+	if (frames > 0)
+	{
+		g_hash_table_remove_all(filter_table);
+		sharkd_tap_cache_clear();
+	}
+
+	return frames;
+}
+
+/**
+ * sharkd_session_process_tail()
+ *
+ * Process tail request
+ *
+ * Input:
+ *   (o) follow - "true" to check for new frames every second while there are no requests,
+ *                "false" to stop doing so
+ *
+ * Output object with attributes:
+ *   (m) err    - error code
+ *   (o) frames - count of currently loaded frames
+ *   (o) new    - count of frames read by this request
+ *
+ * While following, each check that finds new frames writes an object with:
+ *   (m) event  - "tail"
+ *   (m) frames - count of currently loaded frames
+ *   (m) new    - count of frames read
+ */
+static void
+sharkd_session_process_tail(const char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_follow = json_find_attr(buf, tokens, count, "follow");
+	int err = 0;
+	int frames;
+
+	frames = sharkd_session_tail(&err);
+	if (frames < 0)
+	{
+		tail_follow = FALSE;
+		sharkd_json_simple_reply(err ? err : -1, err ? NULL : "File wasn't loaded with tail");
+		return;
+	}
+
+	if (tok_follow)
+		tail_follow = !strcmp(tok_follow, "true");
+
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_anyf("err", "0");
+	sharkd_json_value_anyf("frames", "%u", cfile.count);
+	sharkd_json_value_anyf("new", "%d", frames);
+	sharkd_json_value_id();
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+}
+
+/*
+ * The follow side of tail requests: called when no request came in for
+ * a while.
+ */
+static void
+sharkd_session_tail_follow(void)
+{
+	int err = 0;
+	int frames;
+
+	frames = sharkd_session_tail(&err);
+	if (frames < 0)
+	{
+		/* the error was logged, don't keep hitting it */
+		tail_follow = FALSE;
+		return;
+	}
+
+	if (frames == 0)
+		return;
+
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_string("event", "tail");
+	sharkd_json_value_anyf("frames", "%u", cfile.count);
+	sharkd_json_value_anyf("new", "%d", frames);
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+	fflush(stdout);
+}
+
 /**
  * sharkd_session_process_status()
  *
@@ -578,12 +938,21 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *   (m) duration - time difference between time of first frame, and last loaded frame
  *   (o) filename - capture filename
  *   (o) filesize - capture filesize
+ *   (o) filemem  - bytes allocated in the file scope, if wmem statistics are enabled
+ *   (o) filemem_peak - highest number of bytes allocated in the file scope
+ *   (o) reccache_hits   - records taken from the record cache, once records have been read back
+ *   (o) reccache_misses - records that had to be read back from the file
+ *   (o) reccache_bytes  - bytes held by the record cache
+ *   (o) id       - the request's id, if it had one
  */
 static void
 sharkd_session_process_status(void)
 {
+	record_cache_stats_t rc_stats;
+
 	json_dumper_begin_object(&dumper);
 
+	sharkd_json_value_id();
 	sharkd_json_value_anyf("frames", "%u", cfile.count);
 	sharkd_json_value_anyf("duration", "%.9f", nstime_to_sec(&cfile.elapsed_time));
 
@@ -603,6 +972,25 @@ sharkd_session_process_status(void)
 			sharkd_json_value_anyf("filesize", "%" G_GINT64_FORMAT, file_size);
 	}
 
+	if (wmem_stats_enabled())
+	{
+		const wmem_stats_t *stats = wmem_stats_get(wmem_file_scope());
+
+		if (stats)
+		{
+			sharkd_json_value_anyf("filemem", "%" G_GUINT64_FORMAT, stats->bytes);
+			sharkd_json_value_anyf("filemem_peak", "%" G_GUINT64_FORMAT, stats->peak_bytes);
+		}
+	}
+
+	if (cap_file_provider_get_record_cache_stats(&cfile.provider, &rc_stats) &&
+	    rc_stats.hits + rc_stats.misses > 0)
+	{
+		sharkd_json_value_anyf("reccache_hits", "%" G_GUINT64_FORMAT, rc_stats.hits);
+		sharkd_json_value_anyf("reccache_misses", "%" G_GUINT64_FORMAT, rc_stats.misses);
+		sharkd_json_value_anyf("reccache_bytes", "%" G_GSIZE_FORMAT, rc_stats.bytes);
+	}
+
 	json_dumper_end_object(&dumper);
 	json_dumper_finish(&dumper);
 }
@@ -805,14 +1193,8 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 
 	column_info *cinfo = &cfile.cinfo;
 	column_info user_cinfo;
-
-	if (tok_column)
-	{
-		memset(&user_cinfo, 0, sizeof(user_cinfo));
-		cinfo = sharkd_session_create_columns(&user_cinfo, buf, tokens, count);
-		if (!cinfo)
-			return;
-	}
+	GString *columns_key;
+	char **cached_cols;
 
 	if (tok_filter)
 	{
@@ -820,7 +1202,11 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 
 		filter_item = sharkd_session_filter_data(tok_filter);
 		if (!filter_item)
+		{
+			if (req_cancelled)
+				sharkd_json_simple_reply(-1, "Cancelled");
 			return;
+		}
 		filter_data = filter_item->filtered;
 	}
 
@@ -844,6 +1230,32 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 			return;
 	}
 
+	columns_key = g_string_new(NULL);
+
+	/* the columns requested, before sharkd_session_create_columns() changes them */
+	for (col = 0; ; col++)
+	{
+		char tok_column_name[64];
+		const char *tok_col;
+
+		snprintf(tok_column_name, sizeof(tok_column_name), "column%d", col);
+		tok_col = json_find_attr(buf, tokens, count, tok_column_name);
+		if (tok_col == NULL)
+			break;
+		g_string_append_printf(columns_key, ",%s", tok_col);
+	}
+
+	if (tok_column)
+	{
+		memset(&user_cinfo, 0, sizeof(user_cinfo));
+		cinfo = sharkd_session_create_columns(&user_cinfo, buf, tokens, count);
+		if (!cinfo)
+		{
+			g_string_free(columns_key, TRUE);
+			return;
+		}
+	}
+
 	sharkd_json_array_open(NULL);
 	for (framenum = 1; framenum <= cfile.count; framenum++)
 	{
@@ -892,7 +1304,26 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 		}
 
 		fdata = sharkd_get_frame(framenum);
-		sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL));
+
+		cached_cols = NULL;
+		if (cinfo == &cfile.cinfo)
+			cached_cols = sharkd_shared_columns_lookup(framenum, ref_frame, prev_dis_num);
+
+		if (cached_cols == NULL && column_cache_max != 0)
+		{
+			char *key = g_strdup_printf("%u,%u,%u%s", framenum, ref_frame, prev_dis_num, columns_key->str);
+
+			cached_cols = sharkd_column_cache_lookup(key);
+			if (cached_cols)
+				g_free(key);
+			else
+			{
+				sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL));
+				sharkd_column_cache_add(key, cinfo);
+			}
+		}
+		else if (cached_cols == NULL)
+			sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL));
 
 		json_dumper_begin_object(&dumper);
 
@@ -901,7 +1332,7 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 		{
 			const col_item_t *col_item = &cinfo->columns[col];
 
-			sharkd_json_value_string(NULL, col_item->col_data);
+			sharkd_json_value_string(NULL, cached_cols ? cached_cols[col] : col_item->col_data);
 		}
 		sharkd_json_array_close();
 
@@ -934,6 +1365,7 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 	sharkd_json_array_close();
 	json_dumper_finish(&dumper);
 
+	g_string_free(columns_key, TRUE);
 	if (cinfo != &cfile.cinfo)
 		col_cleanup(cinfo);
 }
@@ -1208,14 +1640,121 @@ sharkd_session_free_tap_flow_cb(void *tapdata)
 	sequence_analysis_info_free(graph_analysis);
 }
 
+enum sharkd_conv_sort
+{
+	SHARKD_CONV_SORT_NONE = 0,
+	SHARKD_CONV_SORT_FRAMES,
+	SHARKD_CONV_SORT_BYTES,
+	SHARKD_CONV_SORT_TXF,
+	SHARKD_CONV_SORT_TXB,
+	SHARKD_CONV_SORT_RXF,
+	SHARKD_CONV_SORT_RXB,
+	SHARKD_CONV_SORT_START
+};
+
 struct sharkd_conv_tap_data
 {
 	const char *type;
 	conv_hash_t hash;
 	gboolean resolve_name;
 	gboolean resolve_port;
+
+	/* which of the conversations or hosts to write, and in what order */
+	enum sharkd_conv_sort sort;
+	gboolean sort_desc;
+	guint32 skip;
+	guint32 limit;
 };
 
+static double
+sharkd_conv_sort_value(const struct sharkd_conv_tap_data *iu, guint idx)
+{
+	guint64 rxf, rxb, txf, txb;
+
+	if (!strncmp(iu->type, "conv:", 5))
+	{
+		const conv_item_t *iui = &g_array_index(iu->hash.conv_array, conv_item_t, idx);
+
+		if (iu->sort == SHARKD_CONV_SORT_START)
+			return nstime_to_sec(&iui->start_time);
+		rxf = iui->rx_frames;
+		rxb = iui->rx_bytes;
+		txf = iui->tx_frames;
+		txb = iui->tx_bytes;
+	}
+	else
+	{
+		const hostlist_talker_t *host = &g_array_index(iu->hash.conv_array, hostlist_talker_t, idx);
+
+		rxf = host->rx_frames;
+		rxb = host->rx_bytes;
+		txf = host->tx_frames;
+		txb = host->tx_bytes;
+	}
+
+	switch (iu->sort)
+	{
+		case SHARKD_CONV_SORT_FRAMES:
+			return (double) (rxf + txf);
+		case SHARKD_CONV_SORT_BYTES:
+			return (double) (rxb + txb);
+		case SHARKD_CONV_SORT_TXF:
+			return (double) txf;
+		case SHARKD_CONV_SORT_TXB:
+			return (double) txb;
+		case SHARKD_CONV_SORT_RXF:
+			return (double) rxf;
+		case SHARKD_CONV_SORT_RXB:
+			return (double) rxb;
+		default:
+			return 0.0;
+	}
+}
+
+static gint
+sharkd_conv_sort_cmp(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const struct sharkd_conv_tap_data *iu = (const struct sharkd_conv_tap_data *) user_data;
+	guint idx_a = *(const guint *) a;
+	guint idx_b = *(const guint *) b;
+	double val_a = sharkd_conv_sort_value(iu, idx_a);
+	double val_b = sharkd_conv_sort_value(iu, idx_b);
+
+	if (val_a != val_b)
+		return ((val_a < val_b) != iu->sort_desc) ? -1 : 1;
+
+	/* keep the tap's order between equal ones */
+	return (idx_a < idx_b) ? -1 : (idx_a > idx_b);
+}
+
+/*
+ * Indexes of the conversations or hosts to write, after sorting, skipping
+ * and limiting them as the request asked.  Returns the number of them.
+ */
+static guint
+sharkd_conv_select(const struct sharkd_conv_tap_data *iu, guint **order)
+{
+	guint len = iu->hash.conv_array ? iu->hash.conv_array->len : 0;
+	guint i;
+
+	*order = g_new(guint, len ? len : 1);
+	for (i = 0; i < len; i++)
+		(*order)[i] = i;
+
+	if (iu->sort != SHARKD_CONV_SORT_NONE)
+		g_qsort_with_data(*order, len, sizeof(guint), sharkd_conv_sort_cmp, (gpointer) iu);
+
+	if (iu->skip >= len)
+		return 0;
+
+	len -= iu->skip;
+	memmove(*order, *order + iu->skip, len * sizeof(guint));
+	if (iu->limit && iu->limit < len)
+		len = iu->limit;
+
+	return len;
+}
+
 static gboolean
 sharkd_session_geoip_addr(address *addr, const char *suffix)
 {
@@ -1505,6 +2044,7 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
  *   (m) proto      - protocol short name
  *   (o) filter     - filter string
  *   (o) geoip      - whether GeoIP information is available, boolean
+ *   (m) total      - number of conversations or hosts, before skip and limit
  *
  *   (o) convs      - array of object with attributes:
  *                  (m) saddr - source address
@@ -1534,7 +2074,9 @@ sharkd_session_process_tap_conv_cb(void *arg)
 	const struct sharkd_conv_tap_data *iu = (struct sharkd_conv_tap_data *) hash->user_data;
 	const char *proto;
 	int proto_with_port;
-	guint i;
+	guint *order;
+	guint order_len;
+	guint n;
 
 	int with_geoip = 0;
 
@@ -1561,11 +2103,13 @@ sharkd_session_process_tap_conv_cb(void *arg)
 
 	proto_with_port = (!strcmp(proto, "TCP") || !strcmp(proto, "UDP") || !strcmp(proto, "SCTP"));
 
+	order_len = sharkd_conv_select(iu, &order);
+
 	if (iu->hash.conv_array != NULL && !strncmp(iu->type, "conv:", 5))
 	{
-		for (i = 0; i < iu->hash.conv_array->len; i++)
+		for (n = 0; n < order_len; n++)
 		{
-			conv_item_t *iui = &g_array_index(iu->hash.conv_array, conv_item_t, i);
+			conv_item_t *iui = &g_array_index(iu->hash.conv_array, conv_item_t, order[n]);
 			char *src_addr, *dst_addr;
 			char *src_port, *dst_port;
 			char *filter_str;
@@ -1613,9 +2157,9 @@ sharkd_session_process_tap_conv_cb(void *arg)
 	}
 	else if (iu->hash.conv_array != NULL && !strncmp(iu->type, "endpt:", 6))
 	{
-		for (i = 0; i < iu->hash.conv_array->len; i++)
+		for (n = 0; n < order_len; n++)
 		{
-			hostlist_talker_t *host = &g_array_index(iu->hash.conv_array, hostlist_talker_t, i);
+			hostlist_talker_t *host = &g_array_index(iu->hash.conv_array, hostlist_talker_t, order[n]);
 			char *host_str, *port_str;
 			char *filter_str;
 
@@ -1651,9 +2195,11 @@ sharkd_session_process_tap_conv_cb(void *arg)
 		}
 	}
 	sharkd_json_array_close();
+	g_free(order);
 
 	sharkd_json_value_string("proto", proto);
 	sharkd_json_value_anyf("geoip", with_geoip ? "true" : "false");
+	sharkd_json_value_anyf("total", "%u", iu->hash.conv_array ? iu->hash.conv_array->len : 0);
 
 	json_dumper_end_object(&dumper);
 }
@@ -1793,6 +2339,7 @@ sharkd_session_free_tap_nstat_cb(void *arg)
  *                  (m) tot - total SRT time
  *                  (m) min_frame - minimal SRT
  *                  (m) max_frame - maximum SRT
+ *                  (m) p50, p99, p999 - estimated percentiles of the SRT time
  *                  (o) open_req - Open Requests
  *                  (o) disc_rsp - Discarded Responses
  *                  (o) req_dup  - Duplicated Requests
@@ -1860,6 +2407,9 @@ sharkd_session_process_tap_rtd_cb(void *arg)
 			sharkd_json_value_anyf("tot", "%.9f", nstime_to_sec(&(ms->rtd[j].tot)));
 			sharkd_json_value_anyf("min_frame", "%u", ms->rtd[j].min_num);
 			sharkd_json_value_anyf("max_frame", "%u", ms->rtd[j].max_num);
+			sharkd_json_value_anyf("p50", "%.9f", time_stat_percentile(&ms->rtd[j], 50.0) / 1000);
+			sharkd_json_value_anyf("p99", "%.9f", time_stat_percentile(&ms->rtd[j], 99.0) / 1000);
+			sharkd_json_value_anyf("p999", "%.9f", time_stat_percentile(&ms->rtd[j], 99.9) / 1000);
 
 			if (rtd_data->stat_table.num_rtds != 1)
 			{
@@ -1905,6 +2455,7 @@ sharkd_session_free_tap_rtd_cb(void *arg)
  *                            (m) min - minimum SRT time
  *                            (m) max - maximum SRT time
  *                            (m) tot - total SRT time
+ *                            (m) p50, p99, p999 - estimated percentiles of the SRT time
  */
 static void
 sharkd_session_process_tap_srt_cb(void *arg)
@@ -1964,6 +2515,9 @@ sharkd_session_process_tap_srt_cb(void *arg)
 			sharkd_json_value_anyf("min", "%.9f", nstime_to_sec(&proc->stats.min));
 			sharkd_json_value_anyf("max", "%.9f", nstime_to_sec(&proc->stats.max));
 			sharkd_json_value_anyf("tot", "%.9f", nstime_to_sec(&proc->stats.tot));
+			sharkd_json_value_anyf("p50", "%.9f", time_stat_percentile(&proc->stats, 50.0) / 1000);
+			sharkd_json_value_anyf("p99", "%.9f", time_stat_percentile(&proc->stats, 99.0) / 1000);
+			sharkd_json_value_anyf("p999", "%.9f", time_stat_percentile(&proc->stats, 99.9) / 1000);
 
 			json_dumper_end_object(&dumper);
 		}
@@ -2147,44 +2701,293 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 	json_dumper_end_object(&dumper);
 }
 
-/**
- * sharkd_session_process_tap()
- *
- * Process tap request
- *
- * Input:
- *   (m) tap0         - First tap request
- *   (o) tap1...tap15 - Other tap requests
- *
- * Output object with attributes:
- *   (m) taps  - array of object with attributes:
- *                  (m) tap  - tap name
- *                  (m) type - tap output type
- *                  ...
- *                  for type:stats see sharkd_session_process_tap_stats_cb()
- *                  for type:nstat see sharkd_session_process_tap_nstat_cb()
- *                  for type:conv see sharkd_session_process_tap_conv_cb()
- *                  for type:host see sharkd_session_process_tap_conv_cb()
- *                  for type:rtp-streams see sharkd_session_process_tap_rtp_cb()
- *                  for type:rtp-analyse see sharkd_session_process_tap_rtp_analyse_cb()
- *                  for type:eo see sharkd_session_process_tap_eo_cb()
- *                  for type:expert see sharkd_session_process_tap_expert_cb()
- *                  for type:rtd see sharkd_session_process_tap_rtd_cb()
- *                  for type:srt see sharkd_session_process_tap_srt_cb()
- *                  for type:flow see sharkd_session_process_tap_flow_cb()
- *
- *   (m) err   - error code
+/* Check that the request is an object of strings and primitives, and split and unescape them in place. */
+static gboolean
+sharkd_session_split(char *buf, const jsmntok_t *tokens, int count)
+{
+	int i;
+
+	/* sanity check, and split strings */
+	if (count < 1 || tokens[0].type != JSMN_OBJECT)
+	{
+		fprintf(stderr, "sanity check(1): [0] not object\n");
+		return FALSE;
+	}
+
+	/* don't need [0] token */
+	tokens++;
+	count--;
+
+	if (count & 1)
+	{
+		fprintf(stderr, "sanity check(2): %d not even\n", count);
+		return FALSE;
+	}
+
+	for (i = 0; i < count; i += 2)
+	{
+		if (tokens[i].type != JSMN_STRING)
+		{
+			fprintf(stderr, "sanity check(3): [%d] not string\n", i);
+			return FALSE;
+		}
+
+		if (tokens[i + 1].type != JSMN_STRING && tokens[i + 1].type != JSMN_PRIMITIVE)
+		{
+			fprintf(stderr, "sanity check(3a): [%d] wrong type\n", i + 1);
+			return FALSE;
+		}
+
+		buf[tokens[i + 0].end] = '\0';
+		buf[tokens[i + 1].end] = '\0';
+
+		/* unescape only value, as keys are simple strings */
+		if (tokens[i + 1].type == JSMN_STRING && !json_decode_string_inplace(&buf[tokens[i + 1].start]))
+		{
+			fprintf(stderr, "sanity check(3b): [%d] cannot unescape string\n", i + 1);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Parse a request line into tokens, growing *tokens as needed.  Returns
+ * the number of tokens, 0 if the line isn't JSON, or -1 if the second
+ * parse fails.
  */
-static void
-sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
+static int
+sharkd_session_tokenize(const char *buf, jsmntok_t **tokens, int *tokens_max)
 {
-	void *taps_data[16];
+	int ret;
+
+	/* Try the array we have first; it's usually big enough, and then
+	 * the line is only parsed once.  The last token is kept zeroed. */
+	if (*tokens != NULL && *tokens_max > 1)
+	{
+		ret = json_parse(buf, *tokens, *tokens_max - 1);
+		if (ret > 0)
+		{
+			memset(&(*tokens)[ret], 0, sizeof(jsmntok_t));
+			return ret;
+		}
+		if (ret != JSMN_ERROR_NOMEM)
+			return 0;
+	}
+
+	ret = json_parse(buf, NULL, 0);
+	if (ret <= 0)
+		return 0;
+
+	/* fprintf(stderr, "JSON: %d tokens\n", ret); */
+	ret += 1;
+
+	if (*tokens == NULL || *tokens_max < ret)
+	{
+		*tokens_max = ret;
+		*tokens = (jsmntok_t *) g_realloc(*tokens, sizeof(jsmntok_t) * *tokens_max);
+	}
+
+	memset(*tokens, 0, ret * sizeof(jsmntok_t));
+
+	ret = json_parse(buf, *tokens, ret);
+	if (ret <= 0)
+		return -1;
+
+	return ret;
+}
+
+/*
+ * Parse and split a copy of a request line, leaving the line itself as
+ * it is.  Returns the copy, or NULL if the line isn't a valid request.
+ */
+static char *
+sharkd_session_parse(const char *line, jsmntok_t **tokens, int *tokens_max, int *count)
+{
+	char *buf = g_strdup(line);
+
+	*count = sharkd_session_tokenize(buf, tokens, tokens_max);
+	if (*count <= 0 || !sharkd_session_split(buf, *tokens, *count))
+	{
+		g_free(buf);
+		return NULL;
+	}
+	return buf;
+}
+
+/* Get the "id" of a request line without processing it. */
+static char *
+sharkd_session_peek_id(const char *line)
+{
+	static jsmntok_t *tokens = NULL;
+	static int tokens_max = -1;
+	int count;
+	char *buf = sharkd_session_parse(line, &tokens, &tokens_max, &count);
+	char *id = NULL;
+
+	if (buf)
+		id = g_strdup(json_find_attr(buf, tokens + 1, count - 1, "id"));
+	g_free(buf);
+	return id;
+}
+
+/* The taps of one tap request, registered for a pass that may be shared with others. */
+struct sharkd_tap_request
+{
+	char *line;                /* request line of a coalesced request, which the tokens point into */
+	jsmntok_t *tokens;
+	char *id;
+	const char *errmsg;
+
+	int taps_count;
+	void *taps_data[16];       /* NULL if the output was cached */
 	GFreeFunc taps_free[16];
-	int taps_count = 0;
+	tap_draw_cb taps_draw[16];
+	char *taps_key[16];        /* NULL if the output isn't to be cached */
+	char *taps_output[16];
+
+	rtpstream_tapinfo_t rtp_tapinfo;
+};
+
+static struct sharkd_tap_request *
+sharkd_tap_request_new(void)
+{
+	static const rtpstream_tapinfo_t rtp_tapinfo_init =
+		{ NULL, NULL, NULL, NULL, 0, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE, FALSE, NULL};
+	struct sharkd_tap_request *req = g_new0(struct sharkd_tap_request, 1);
+
+	req->rtp_tapinfo = rtp_tapinfo_init;
+	return req;
+}
+
+static void
+sharkd_tap_request_free(struct sharkd_tap_request *req)
+{
+	int i;
+
+	for (i = 0; i < req->taps_count; i++)
+	{
+		if (req->taps_data[i])
+			remove_tap_listener(req->taps_data[i]);
+
+		if (req->taps_free[i])
+			req->taps_free[i](req->taps_data[i]);
+
+		g_free(req->taps_key[i]);
+		g_free(req->taps_output[i]);
+	}
+
+	g_free(req->tokens);
+	g_free(req->line);
+	g_free(req->id);
+	g_free(req);
+}
+
+/* Run a tap's draw callback into a string rather than into the reply. */
+static char *
+sharkd_tap_draw(tap_draw_cb draw, void *tap_data)
+{
+	json_dumper saved = dumper;
+	GString *output = g_string_new(NULL);
+
+	memset(&dumper, 0, sizeof(dumper));
+	dumper.output_string = output;
+
+	draw(tap_data);
+
+	dumper = saved;
+	return g_string_free(output, FALSE);
+}
+
+static void
+sharkd_tap_request_reply(struct sharkd_tap_request *req, gboolean cancelled)
+{
 	int i;
 
-	rtpstream_tapinfo_t rtp_tapinfo =
-		{ NULL, NULL, NULL, NULL, 0, NULL, 0, TAP_ANALYSE, NULL, NULL, NULL, FALSE, FALSE};
+	if (req->errmsg)
+	{
+		sharkd_json_simple_reply(-1, req->errmsg);
+		return;
+	}
+
+	fprintf(stderr, "sharkd_session_process_tap() count=%d\n", req->taps_count);
+	if (req->taps_count == 0)
+		return;
+
+	if (cancelled)
+	{
+		sharkd_json_simple_reply(-1, "Cancelled");
+		return;
+	}
+
+	json_dumper_begin_object(&dumper);
+
+	/* last registered first, as draw_tap_listeners() did */
+	sharkd_json_array_open("taps");
+	for (i = req->taps_count - 1; i >= 0; i--)
+	{
+		if (!req->taps_output[i])
+		{
+			req->taps_output[i] = sharkd_tap_draw(req->taps_draw[i], req->taps_data[i]);
+
+			if (req->taps_key[i] && strlen(req->taps_output[i]) <= SHARKD_TAP_CACHE_MAX_OUTPUT)
+			{
+				g_hash_table_insert(tap_cache, req->taps_key[i], g_strdup(req->taps_output[i]));
+				req->taps_key[i] = NULL;
+			}
+		}
+		json_dumper_value_anyf(&dumper, "%s", req->taps_output[i]);
+	}
+	sharkd_json_array_close();
+
+	sharkd_json_value_anyf("err", "0");
+	sharkd_json_value_id();
+
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+}
+
+/* Register the taps of a tap request, see sharkd_session_process_tap(). */
+static void
+sharkd_session_tap_register(struct sharkd_tap_request *req, char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_sort  = json_find_attr(buf, tokens, count, "sort");
+	const char *tok_order = json_find_attr(buf, tokens, count, "order");
+	const char *tok_skip  = json_find_attr(buf, tokens, count, "skip");
+	const char *tok_limit = json_find_attr(buf, tokens, count, "limit");
+
+	int i;
+
+	enum sharkd_conv_sort conv_sort = SHARKD_CONV_SORT_NONE;
+	guint32 conv_skip = 0;
+	guint32 conv_limit = 0;
+
+	if (tok_sort)
+	{
+		static const char *sort_names[] = { "frames", "bytes", "txf", "txb", "rxf", "rxb", "start" };
+
+		for (i = 0; i < (int) G_N_ELEMENTS(sort_names); i++)
+			if (!strcmp(tok_sort, sort_names[i]))
+				conv_sort = (enum sharkd_conv_sort) (SHARKD_CONV_SORT_FRAMES + i);
+
+		if (conv_sort == SHARKD_CONV_SORT_NONE)
+		{
+			req->errmsg = "Invalid sort";
+			return;
+		}
+	}
+
+	if (tok_skip && !ws_strtou32(tok_skip, NULL, &conv_skip))
+	{
+		req->errmsg = "Invalid skip";
+		return;
+	}
+
+	if (tok_limit && !ws_strtou32(tok_limit, NULL, &conv_limit))
+	{
+		req->errmsg = "Invalid limit";
+		return;
+	}
 
 	for (i = 0; i < 16; i++)
 	{
@@ -2193,14 +2996,39 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 		void *tap_data = NULL;
 		GFreeFunc tap_free = NULL;
+		tap_draw_cb tap_draw = NULL;
 		const char *tap_filter = "";
 		GString *tap_error = NULL;
+		char *tap_key;
+		const char *cached;
 
 		snprintf(tapbuf, sizeof(tapbuf), "tap%d", i);
 		tok_tap = json_find_attr(buf, tokens, count, tapbuf);
 		if (!tok_tap)
 			break;
 
+		/* export objects are kept for download requests, so always run those */
+		if (!strncmp(tok_tap, "eo:", 3))
+			tap_key = NULL;
+		else if (!strncmp(tok_tap, "conv:", 5) || !strncmp(tok_tap, "endpt:", 6))
+			tap_key = g_strdup_printf("%s|%s|%s|%u|%u", tok_tap, tok_sort ? tok_sort : "",
+			                          tok_order ? tok_order : "", conv_skip, conv_limit);
+		else
+			tap_key = g_strdup(tok_tap);
+
+		cached = tap_key ? (const char *) g_hash_table_lookup(tap_cache, tap_key) : NULL;
+		if (cached)
+		{
+			g_free(tap_key);
+			req->taps_data[req->taps_count] = NULL;
+			req->taps_free[req->taps_count] = NULL;
+			req->taps_draw[req->taps_count] = NULL;
+			req->taps_key[req->taps_count] = NULL;
+			req->taps_output[req->taps_count] = g_strdup(cached);
+			req->taps_count++;
+			continue;
+		}
+
 		if (!strncmp(tok_tap, "stat:", 5))
 		{
 			stats_tree_cfg *cfg = stats_tree_get_cfg_by_abbr(tok_tap + 5);
@@ -2209,6 +3037,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			if (!cfg)
 			{
 				fprintf(stderr, "sharkd_session_process_tap() stat %s not found\n", tok_tap + 5);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2221,6 +3050,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 			tap_data = st;
 			tap_free = sharkd_session_free_tap_stats_cb;
+			tap_draw = sharkd_session_process_tap_stats_cb;
 		}
 		else if (!strcmp(tok_tap, "expert"))
 		{
@@ -2233,6 +3063,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 			tap_data = expert_tap;
 			tap_free = sharkd_session_free_tap_expert_cb;
+			tap_draw = sharkd_session_process_tap_expert_cb;
 		}
 		else if (!strncmp(tok_tap, "seqa:", 5))
 		{
@@ -2246,6 +3077,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			if (!analysis)
 			{
 				fprintf(stderr, "sharkd_session_process_tap() seq analysis %s not found\n", tok_tap + 5);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2262,6 +3094,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 			tap_data = graph_analysis;
 			tap_free = sharkd_session_free_tap_flow_cb;
+			tap_draw = sharkd_session_process_tap_flow_cb;
 		}
 		else if (!strncmp(tok_tap, "conv:", 5) || !strncmp(tok_tap, "endpt:", 6))
 		{
@@ -2277,6 +3110,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 				if (!ct || !(tap_func = get_conversation_packet_func(ct)))
 				{
 					fprintf(stderr, "sharkd_session_process_tap() conv %s not found\n", tok_tap + 5);
+					g_free(tap_key);
 					continue;
 				}
 			}
@@ -2287,12 +3121,14 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 				if (!ct || !(tap_func = get_hostlist_packet_func(ct)))
 				{
 					fprintf(stderr, "sharkd_session_process_tap() endpt %s not found\n", tok_tap + 6);
+					g_free(tap_key);
 					continue;
 				}
 			}
 			else
 			{
 				fprintf(stderr, "sharkd_session_process_tap() conv/endpt(?): %s not found\n", tok_tap);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2306,10 +3142,16 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			ct_data->resolve_name = TRUE;
 			ct_data->resolve_port = TRUE;
 
+			ct_data->sort = conv_sort;
+			ct_data->sort_desc = (tok_order && !strcmp(tok_order, "desc"));
+			ct_data->skip = conv_skip;
+			ct_data->limit = conv_limit;
+
 			tap_error = register_tap_listener(ct_tapname, &ct_data->hash, tap_filter, 0, NULL, tap_func, sharkd_session_process_tap_conv_cb, NULL);
 
 			tap_data = &ct_data->hash;
 			tap_free = sharkd_session_free_tap_conv_cb;
+			tap_draw = sharkd_session_process_tap_conv_cb;
 		}
 		else if (!strncmp(tok_tap, "nstat:", 6))
 		{
@@ -2319,6 +3161,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			if (!stat_tap)
 			{
 				fprintf(stderr, "sharkd_session_process_tap() nstat=%s not found\n", tok_tap + 6);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2332,6 +3175,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 			tap_data = stat_data;
 			tap_free = sharkd_session_free_tap_nstat_cb;
+			tap_draw = sharkd_session_process_tap_nstat_cb;
 		}
 		else if (!strncmp(tok_tap, "rtd:", 4))
 		{
@@ -2342,6 +3186,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			if (!rtd)
 			{
 				fprintf(stderr, "sharkd_session_process_tap() rtd=%s not found\n", tok_tap + 4);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2350,6 +3195,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			{
 				fprintf(stderr, "sharkd_session_process_tap() rtd=%s err=%s\n", tok_tap + 4, err);
 				g_free(err);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2361,6 +3207,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 			tap_data = rtd_data;
 			tap_free = sharkd_session_free_tap_rtd_cb;
+			tap_draw = sharkd_session_process_tap_rtd_cb;
 		}
 		else if (!strncmp(tok_tap, "srt:", 4))
 		{
@@ -2371,6 +3218,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			if (!srt)
 			{
 				fprintf(stderr, "sharkd_session_process_tap() srt=%s not found\n", tok_tap + 4);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2379,6 +3227,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			{
 				fprintf(stderr, "sharkd_session_process_tap() srt=%s err=%s\n", tok_tap + 4, err);
 				g_free(err);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2391,6 +3240,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 			tap_data = srt_data;
 			tap_free = sharkd_session_free_tap_srt_cb;
+			tap_draw = sharkd_session_process_tap_srt_cb;
 		}
 		else if (!strncmp(tok_tap, "eo:", 3))
 		{
@@ -2401,6 +3251,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			if (!eo)
 			{
 				fprintf(stderr, "sharkd_session_process_tap() eo=%s not found\n", tok_tap + 3);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2433,13 +3284,15 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 			tap_data = eo_object;
 			tap_free = g_free; /* need to free only eo_object, object_list need to be kept for potential download */
+			tap_draw = sharkd_session_process_tap_eo_cb;
 		}
 		else if (!strcmp(tok_tap, "rtp-streams"))
 		{
-			tap_error = register_tap_listener("rtp", &rtp_tapinfo, tap_filter, 0, rtpstream_reset_cb, rtpstream_packet_cb, sharkd_session_process_tap_rtp_cb, NULL);
+			tap_error = register_tap_listener("rtp", &req->rtp_tapinfo, tap_filter, 0, rtpstream_reset_cb, rtpstream_packet_cb, sharkd_session_process_tap_rtp_cb, NULL);
 
-			tap_data = &rtp_tapinfo;
+			tap_data = &req->rtp_tapinfo;
 			tap_free = rtpstream_reset_cb;
+			tap_draw = sharkd_session_process_tap_rtp_cb;
 		}
 		else if (!strncmp(tok_tap, "rtp-analyse:", 12))
 		{
@@ -2450,6 +3303,7 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			{
 				rtpstream_id_free(&rtp_req->id);
 				g_free(rtp_req);
+				g_free(tap_key);
 				continue;
 			}
 
@@ -2461,10 +3315,12 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 
 			tap_data = rtp_req;
 			tap_free = sharkd_session_process_tap_rtp_free_cb;
+			tap_draw = sharkd_session_process_tap_rtp_analyse_cb;
 		}
 		else
 		{
 			fprintf(stderr, "sharkd_session_process_tap() %s not recognized\n", tok_tap);
+			g_free(tap_key);
 			continue;
 		}
 
@@ -2474,37 +3330,139 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
 			g_string_free(tap_error, TRUE);
 			if (tap_free)
 				tap_free(tap_data);
+			g_free(tap_key);
 			continue;
 		}
 
-		taps_data[taps_count] = tap_data;
-		taps_free[taps_count] = tap_free;
-		taps_count++;
+		req->taps_data[req->taps_count] = tap_data;
+		req->taps_free[req->taps_count] = tap_free;
+		req->taps_draw[req->taps_count] = tap_draw;
+		req->taps_key[req->taps_count] = tap_key;
+		req->taps_output[req->taps_count] = NULL;
+		req->taps_count++;
 	}
+}
 
-	fprintf(stderr, "sharkd_session_process_tap() count=%d\n", taps_count);
-	if (taps_count == 0)
-		return;
+/*
+ * Take the tap requests waiting right after the current one, so that
+ * they share its pass over the frames.
+ */
+static gboolean sharkd_session_poll(void);
 
-	json_dumper_begin_object(&dumper);
+static int
+sharkd_session_tap_coalesce(struct sharkd_tap_request **reqs, int max)
+{
+	int n = 0;
 
-	sharkd_json_array_open("taps");
-	sharkd_retap();
-	sharkd_json_array_close();
+	/* see what else has come in */
+	(void) sharkd_session_poll();
 
-	sharkd_json_value_anyf("err", "0");
+	while (n < max && !g_queue_is_empty(&req_pending))
+	{
+		struct sharkd_tap_request *req;
+		char *line = (char *) g_queue_peek_head(&req_pending);
+		jsmntok_t *tokens = NULL;
+		int tokens_max = -1;
+		int count;
+		char *buf;
+
+		buf = sharkd_session_parse(line, &tokens, &tokens_max, &count);
+		if (!buf || g_strcmp0(json_find_attr(buf, tokens + 1, count - 1, "req"), "tap") != 0)
+		{
+			g_free(tokens);
+			g_free(buf);
+			break;
+		}
 
-	json_dumper_end_object(&dumper);
-	json_dumper_finish(&dumper);
+		req = sharkd_tap_request_new();
+		g_free(g_queue_pop_head(&req_pending));
+		req->line = buf;
+		req->tokens = tokens;
+
+		req->id = g_strdup(json_find_attr(req->line, req->tokens + 1, count - 1, "id"));
+		sharkd_session_tap_register(req, req->line, req->tokens + 1, count - 1);
 
-	for (i = 0; i < taps_count; i++)
+		reqs[n++] = req;
+	}
+
+	return n;
+}
+
+/**
+ * sharkd_session_process_tap()
+ *
+ * Process tap request
+ *
+ * Input:
+ *   (m) tap0         - First tap request
+ *   (o) tap1...tap15 - Other tap requests
+ *   (o) sort         - for conv and endpt taps, sort by: frames, bytes, txf, txb, rxf, rxb or start (conv only)
+ *   (o) order        - "desc" to sort in descending order
+ *   (o) skip=N       - for conv and endpt taps, skip N conversations or hosts
+ *   (o) limit=N      - for conv and endpt taps, show only N conversations or hosts
+ *
+ * Tap requests waiting right behind this one are run in the same pass over
+ * the frames, and the output of each tap, except eo, is kept for when it's
+ * asked for again, until the file, its comments or the preferences change.
+ *
+ * Output object with attributes:
+ *   (m) taps  - array of object with attributes:
+ *                  (m) tap  - tap name
+ *                  (m) type - tap output type
+ *                  ...
+ *                  for type:stats see sharkd_session_process_tap_stats_cb()
+ *                  for type:nstat see sharkd_session_process_tap_nstat_cb()
+ *                  for type:conv see sharkd_session_process_tap_conv_cb()
+ *                  for type:host see sharkd_session_process_tap_conv_cb()
+ *                  for type:rtp-streams see sharkd_session_process_tap_rtp_cb()
+ *                  for type:rtp-analyse see sharkd_session_process_tap_rtp_analyse_cb()
+ *                  for type:eo see sharkd_session_process_tap_eo_cb()
+ *                  for type:expert see sharkd_session_process_tap_expert_cb()
+ *                  for type:rtd see sharkd_session_process_tap_rtd_cb()
+ *                  for type:srt see sharkd_session_process_tap_srt_cb()
+ *                  for type:flow see sharkd_session_process_tap_flow_cb()
+ *
+ *   (m) err   - error code
+ */
+static void
+sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
+{
+	struct sharkd_tap_request *reqs[SHARKD_TAP_REQUESTS_MAX];
+	const char *running_req_id = req_id;
+	gboolean need_pass = FALSE;
+	gboolean cancelled = FALSE;
+	int reqs_count;
+	int i, j;
+
+	reqs[0] = sharkd_tap_request_new();
+	sharkd_session_tap_register(reqs[0], buf, tokens, count);
+	reqs_count = 1 + sharkd_session_tap_coalesce(reqs + 1, SHARKD_TAP_REQUESTS_MAX - 1);
+
+	/* one pass for all of them, unless everything was cached */
+	for (i = 0; i < reqs_count; i++)
+		for (j = 0; j < reqs[i]->taps_count; j++)
+			if (reqs[i]->taps_data[j])
+				need_pass = TRUE;
+
+	if (need_pass)
+		cancelled = (sharkd_retap() == -1);
+
+	for (i = 0; i < reqs_count; i++)
 	{
-		if (taps_data[i])
-			remove_tap_listener(taps_data[i]);
+		req_id = i ? reqs[i]->id : running_req_id;
+		sharkd_tap_request_reply(reqs[i], cancelled);
 
-		if (taps_free[i])
-			taps_free[i](taps_data[i]);
+		if (i)
+		{
+			/* what sharkd_session_process() would have ended it with */
+			json_dumper_finish(&dumper);
+			fflush(stdout);
+		}
 	}
+	req_id = running_req_id;
+
+	for (i = 0; i < reqs_count; i++)
+		sharkd_tap_request_free(reqs[i]);
 }
 
 /**
@@ -2566,7 +3524,13 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
 		return;
 	}
 
-	sharkd_retap();
+	if (sharkd_retap() == -1)
+	{
+		sharkd_json_simple_reply(-1, "Cancelled");
+		remove_tap_listener(follow_info);
+		follow_info_free(follow_info);
+		return;
+	}
 
 	json_dumper_begin_object(&dumper);
 
@@ -2622,6 +3586,157 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
 	follow_info_free(follow_info);
 }
 
+static void
+sharkd_session_followall_node(register_follow_t *follower, const char *name_host, const char *name_port, const char *name_bytes,
+		const address *addr, guint port, guint bytes)
+{
+	char *port_str;
+
+	sharkd_json_value_string(name_host, address_to_name(addr));
+
+	port_str = get_follow_port_to_display(follower)(NULL, port);
+	sharkd_json_value_string(name_port, port_str);
+	wmem_free(NULL, port_str);
+
+	sharkd_json_value_anyf(name_bytes, "%u", bytes);
+}
+
+/**
+ * sharkd_session_process_followall()
+ *
+ * Process followall request: write every followed stream to files, one per
+ * stream and direction, in the given directory. Payload is written out as
+ * the capture is retapped, so only "buffer" bytes per stream are held.
+ *
+ * Input:
+ *   (m) follow  - follow protocol request (e.g. TCP)
+ *   (m) dir     - existing directory for the files
+ *   (o) filter  - only follow streams with packets matching this filter
+ *   (o) buffer  - payload bytes held per stream, default 65536
+ *
+ * Output object with attributes:
+ *
+ *   (m) err     - error code
+ *   (m) files   - number of files written
+ *   (o) errors  - number of streams that couldn't be written
+ *   (m) streams - array of object with attributes:
+ *                  (m) stream    - stream index
+ *                  (o) substream - sub-stream index (HTTP/2, QUIC)
+ *                  (m) chost, cport, cbytes - client host, port, bytes sent
+ *                  (m) shost, sport, sbytes - server host, port, bytes sent
+ *                  (o) cfile - file with the data sent by the client
+ *                  (o) sfile - file with the data sent by the server
+ */
+static void
+sharkd_session_process_followall(char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_follow = json_find_attr(buf, tokens, count, "follow");
+	const char *tok_dir = json_find_attr(buf, tokens, count, "dir");
+	const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
+	const char *tok_buffer = json_find_attr(buf, tokens, count, "buffer");
+
+	register_follow_t *follower;
+	follow_files_t files;
+	follow_multi_t *multi;
+	GString *tap_error;
+	guint32 max_buffered = 64 * 1024;
+	guint i;
+
+	if (!tok_follow || !tok_dir)
+		return;
+
+	if (tok_buffer && !ws_strtou32(tok_buffer, NULL, &max_buffered))
+		return;
+
+	follower = get_follow_by_name(tok_follow);
+	if (!follower)
+	{
+		fprintf(stderr, "sharkd_session_process_followall() follower=%s not found\n", tok_follow);
+		return;
+	}
+
+	if (test_for_directory(tok_dir) != EISDIR)
+	{
+		sharkd_json_simple_reply(-1, "Not a directory");
+		return;
+	}
+
+	follow_files_init(&files, follower, tok_dir);
+	multi = follow_multi_new(follower, max_buffered, follow_files_write, &files);
+
+	tap_error = follow_multi_register_tap_listener(multi, tok_filter, NULL, NULL);
+	if (tap_error)
+	{
+		fprintf(stderr, "sharkd_session_process_followall() name=%s error=%s", tok_follow, tap_error->str);
+		g_string_free(tap_error, TRUE);
+		follow_multi_free(multi);
+		follow_files_cleanup(&files);
+		return;
+	}
+
+	if (sharkd_retap() == -1)
+	{
+		sharkd_json_simple_reply(-1, "Cancelled");
+		remove_tap_listener(multi);
+		follow_multi_free(multi);
+		follow_files_cleanup(&files);
+		return;
+	}
+
+	remove_tap_listener(multi);
+	follow_multi_flush(multi);
+
+	json_dumper_begin_object(&dumper);
+
+	sharkd_json_value_anyf("err", "0");
+	sharkd_json_value_anyf("files", "%u", files.files);
+	if (files.errors)
+		sharkd_json_value_anyf("errors", "%u", files.errors);
+
+	sharkd_json_array_open("streams");
+	for (i = 0; i < follow_multi_num_streams(multi); i++)
+	{
+		follow_info_t *follow_info;
+		guint stream, sub_stream;
+		char *path;
+
+		follow_info = follow_multi_get_stream(multi, i, &stream, &sub_stream);
+
+		json_dumper_begin_object(&dumper);
+
+		sharkd_json_value_anyf("stream", "%u", stream);
+		if (files.sub_streams)
+			sharkd_json_value_anyf("substream", "%u", sub_stream);
+
+		sharkd_session_followall_node(follower, "chost", "cport", "cbytes",
+				&follow_info->client_ip, follow_info->client_port, follow_info->bytes_written[FROM_CLIENT]);
+		sharkd_session_followall_node(follower, "shost", "sport", "sbytes",
+				&follow_info->server_ip, follow_info->server_port, follow_info->bytes_written[FROM_SERVER]);
+
+		if (follow_files_written(follow_info, FALSE))
+		{
+			path = follow_files_path(&files, stream, sub_stream, FALSE);
+			sharkd_json_value_string("cfile", path);
+			g_free(path);
+		}
+		if (follow_files_written(follow_info, TRUE))
+		{
+			path = follow_files_path(&files, stream, sub_stream, TRUE);
+			sharkd_json_value_string("sfile", path);
+			g_free(path);
+		}
+
+		json_dumper_end_object(&dumper);
+	}
+	sharkd_json_array_close();
+
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+
+	follow_multi_free(multi);
+	follow_files_cleanup(&files);
+}
+
 static void
 sharkd_session_process_frame_cb_tree(epan_dissect_t *edt, proto_tree *tree, tvbuff_t **tvbs, gboolean display_hidden)
 {
@@ -3074,8 +4189,20 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 	}
 
 	/* retap only if we have at least one ok */
-	if (is_any_ok)
-		sharkd_retap();
+	if (is_any_ok && sharkd_retap() == -1)
+	{
+		for (i = 0; i < graph_count; i++)
+		{
+			struct sharkd_iograph *graph = &graphs[i];
+
+			if (graph->error)
+				g_string_free(graph->error, TRUE);
+			remove_tap_listener(graph);
+			g_free(graph->items);
+		}
+		sharkd_json_simple_reply(-1, "Cancelled");
+		return;
+	}
 
 	json_dumper_begin_object(&dumper);
 
@@ -3185,7 +4312,11 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
 
 		filter_item = sharkd_session_filter_data(tok_filter);
 		if (!filter_item)
+		{
+			if (req_cancelled)
+				sharkd_json_simple_reply(-1, "Cancelled");
 			return;
+		}
 		filter_data = filter_item->filtered;
 	}
 
@@ -3449,6 +4580,7 @@ sharkd_session_process_complete_pref_option_cb(pref_t *pref, gpointer d)
  *   (o) pref  - array of object with attributes:
  *                  (m) f - pref name
  *                  (o) d - pref description
+ *   (o) id    - the request's id, if it had one
  */
 static int
 sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
@@ -3458,6 +4590,7 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
 
 	json_dumper_begin_object(&dumper);
 	sharkd_json_value_anyf("err", "0");
+	sharkd_json_value_id();
 
 	if (tok_field != NULL && tok_field[0])
 	{
@@ -3588,6 +4721,9 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
 		return;
 
 	ret = sharkd_set_user_comment(fdata, tok_comment);
+	/* a column might show the comment */
+	sharkd_column_cache_clear();
+	sharkd_tap_cache_clear();
 
 	sharkd_json_simple_reply(ret, NULL);
 }
@@ -3620,6 +4756,8 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
 	snprintf(pref, sizeof(pref), "%s:%s", tok_name, tok_value);
 
 	ret = prefs_set_pref(pref, &errmsg);
+	sharkd_column_cache_clear();
+	sharkd_tap_cache_clear();
 
 	sharkd_json_simple_reply(ret, errmsg);
 	g_free(errmsg);
@@ -4113,7 +5251,13 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
 			return;
 		}
 
-		sharkd_retap();
+		if (sharkd_retap() == -1)
+		{
+			sharkd_json_simple_reply(-1, "Cancelled");
+			remove_tap_listener(&rtp_req);
+			g_slist_free_full(rtp_req.packets, sharkd_rtp_download_free_items);
+			return;
+		}
 		remove_tap_listener(&rtp_req);
 
 		if (rtp_req.packets)
@@ -4138,53 +5282,63 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
 	}
 }
 
+/**
+ * sharkd_session_process_cancel()
+ *
+ * Process cancel request; these are also handled while a long request,
+ * such as tap, follow, iograph, intervals, download, or frames with a new
+ * filter, is running, as are status and complete requests.
+ *
+ * Input:
+ *   (o) target - id of the request to cancel, which might be running or
+ *                waiting to be run; if not given, cancel the running request
+ *
+ * Output object with attributes:
+ *   (m) err - always 0
+ *   (o) id  - the request's id, if it had one
+ *
+ * The cancelled request, if it was running, replies with an err of -1.
+ */
 static void
-sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
+sharkd_session_process_cancel(char *buf, const jsmntok_t *tokens, int count)
 {
-	int i;
-
-	/* sanity check, and split strings */
-	if (count < 1 || tokens[0].type != JSMN_OBJECT)
-	{
-		fprintf(stderr, "sanity check(1): [0] not object\n");
-		return;
-	}
+	const char *tok_target = json_find_attr(buf, tokens, count, "target");
 
-	/* don't need [0] token */
-	tokens++;
-	count--;
+	if (!tok_target || g_strcmp0(tok_target, req_running_id) == 0)
+		req_cancelled = TRUE;
 
-	if (count & 1)
+	if (tok_target)
 	{
-		fprintf(stderr, "sanity check(2): %d not even\n", count);
-		return;
-	}
+		GList *item, *next;
 
-	for (i = 0; i < count; i += 2)
-	{
-		if (tokens[i].type != JSMN_STRING)
+		for (item = req_pending.head; item != NULL; item = next)
 		{
-			fprintf(stderr, "sanity check(3): [%d] not string\n", i);
-			return;
-		}
+			char *line = (char *) item->data;
+			char *id;
 
-		if (tokens[i + 1].type != JSMN_STRING && tokens[i + 1].type != JSMN_PRIMITIVE)
-		{
-			fprintf(stderr, "sanity check(3a): [%d] wrong type\n", i + 1);
-			return;
+			next = item->next;
+			id = sharkd_session_peek_id(line);
+			if (id && !g_strcmp0(id, tok_target))
+			{
+				g_queue_delete_link(&req_pending, item);
+				g_free(line);
+			}
+			g_free(id);
 		}
+	}
 
-		buf[tokens[i + 0].end] = '\0';
-		buf[tokens[i + 1].end] = '\0';
+	sharkd_json_simple_reply(0, NULL);
+}
 
-		/* unescape only value, as keys are simple strings */
-		if (tokens[i + 1].type == JSMN_STRING && !json_decode_string_inplace(&buf[tokens[i + 1].start]))
-		{
-			fprintf(stderr, "sanity check(3b): [%d] cannot unescape string\n", i + 1);
-			return;
-		}
-	}
+/* Process a request that sharkd_session_split() has been run on. */
+static void
+sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
+{
+	/* don't need [0] token */
+	tokens++;
+	count--;
 
+	sharkd_session_index_push(buf, tokens, count);
 	{
 		const char *tok_req = json_find_attr(buf, tokens, count, "req");
 
@@ -4194,6 +5348,8 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 			return;
 		}
 
+		req_id = json_find_attr(buf, tokens, count, "id");
+
 		if (!strcmp(tok_req, "load"))
 			sharkd_session_process_load(buf, tokens, count);
 		else if (!strcmp(tok_req, "status"))
@@ -4212,6 +5368,8 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 			sharkd_session_process_tap(buf, tokens, count);
 		else if (!strcmp(tok_req, "follow"))
 			sharkd_session_process_follow(buf, tokens, count);
+		else if (!strcmp(tok_req, "followall"))
+			sharkd_session_process_followall(buf, tokens, count);
 		else if (!strcmp(tok_req, "iograph"))
 			sharkd_session_process_iograph(buf, tokens, count);
 		else if (!strcmp(tok_req, "intervals"))
@@ -4226,6 +5384,10 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 			sharkd_session_process_dumpconf(buf, tokens, count);
 		else if (!strcmp(tok_req, "download"))
 			sharkd_session_process_download(buf, tokens, count);
+		else if (!strcmp(tok_req, "cancel"))
+			sharkd_session_process_cancel(buf, tokens, count);
+		else if (!strcmp(tok_req, "tail"))
+			sharkd_session_process_tail(buf, tokens, count);
 		else if (!strcmp(tok_req, "bye"))
 			exit(0);
 		else
@@ -4250,12 +5412,116 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 		 */
 		fflush(stdout);
 	}
+	sharkd_session_index_pop();
+}
+
+/*
+ * Read requests on their own thread, so that sharkd_session_poll() can
+ * see them while a long request is running.
+ */
+static gpointer
+sharkd_session_reader(gpointer data _U_)
+{
+	GString *line = g_string_sized_new(2 * 1024);
+	char chunk[2 * 1024];
+
+	for (;;)
+	{
+		/* a line of any length */
+		g_string_truncate(line, 0);
+		while (fgets(chunk, sizeof(chunk), stdin))
+		{
+			g_string_append(line, chunk);
+			if (line->str[line->len - 1] == '\n')
+				break;
+		}
+		if (line->len == 0)
+			break;
+
+		if (g_ascii_isdigit(line->str[0]))
+		{
+			/*
+			 * A request can't start with a digit, so this is the
+			 * length of a request that follows without a newline,
+			 * which saves scanning large requests for one.
+			 */
+			guint32 len;
+			char *req;
+
+			g_strchomp(line->str);
+			if (!ws_strtou32(line->str, NULL, &len) || len > SHARKD_MAX_REQUEST_LEN)
+			{
+				fprintf(stderr, "invalid request length %s -> closing\n", line->str);
+				break;
+			}
+			req = (char *) g_malloc(len + 1);
+			if (fread(req, 1, len, stdin) != len)
+			{
+				g_free(req);
+				break;
+			}
+			req[len] = '\0';
+			g_async_queue_push(req_queue, req);
+		}
+		else
+			g_async_queue_push(req_queue, g_strndup(line->str, line->len));
+	}
+	g_string_free(line, TRUE);
+
+	/* requests are never empty, so that marks the end */
+	g_async_queue_push(req_queue, g_strdup(""));
+	return NULL;
+}
+
+/*
+ * Called now and then by long requests.  Answers the status, complete
+ * and cancel requests that have come in since, and sets the others aside
+ * to be processed afterwards, as they'd dissect frames or change what the
+ * running request is using.  Status and complete requests don't jump
+ * ahead of requests that have already been set aside.
+ */
+static gboolean
+sharkd_session_poll(void)
+{
+	char *line;
+
+	static jsmntok_t *tokens = NULL;
+	static int tokens_max = -1;
+
+	while ((line = (char *) g_async_queue_try_pop(req_queue)) != NULL)
+	{
+		const char *req = NULL;
+		char *buf = NULL;
+		int count = 0;
+
+		if (*line != '\0')
+			buf = sharkd_session_parse(line, &tokens, &tokens_max, &count);
+		if (buf)
+			req = json_find_attr(buf, tokens + 1, count - 1, "req");
+
+		if (req &&
+		    (!strcmp(req, "cancel") ||
+		     (g_queue_is_empty(&req_pending) && (!strcmp(req, "status") || !strcmp(req, "complete")))))
+		{
+			const char *running_req_id = req_id;
+
+			sharkd_session_process(buf, tokens, count);
+			req_id = running_req_id;
+
+			g_free(line);
+		}
+		else
+			g_queue_push_tail(&req_pending, line);
+
+		g_free(buf);
+	}
+
+	return !req_cancelled;
 }
 
 int
 sharkd_session_main(int mode_setting)
 {
-	char buf[2 * 1024];
 	jsmntok_t *tokens = NULL;
 	int tokens_max = -1;
 
@@ -4266,48 +5532,69 @@ sharkd_session_main(int mode_setting)
 	dumper.output_file = stdout;
 
 	filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+	tap_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 
 #ifdef HAVE_MAXMINDDB
 	/* mmdbresolve was stopped before fork(), force starting it */
 	uat_get_table_by_name("MaxMind Database Paths")->post_update_cb();
 #endif
 
-	while (fgets(buf, sizeof(buf), stdin))
+	req_queue = g_async_queue_new();
+	g_thread_unref(g_thread_new("sharkd reader", sharkd_session_reader, NULL));
+	sharkd_set_poll_func(sharkd_session_poll);
+
+	for (;;)
 	{
 		/* every command is line seperated JSON */
+		char *buf = (char *) g_queue_pop_head(&req_pending);
 		int ret;
 
-		ret = json_parse(buf, NULL, 0);
-		if (ret <= 0)
+		while (buf == NULL && tail_follow)
 		{
-			fprintf(stderr, "invalid JSON -> closing\n");
-			return 1;
+			buf = (char *) g_async_queue_timeout_pop(req_queue, SHARKD_TAIL_FOLLOW_INTERVAL);
+			if (buf == NULL)
+				sharkd_session_tail_follow();
 		}
-
-		/* fprintf(stderr, "JSON: %d tokens\n", ret); */
-		ret += 1;
-
-		if (tokens == NULL || tokens_max < ret)
+		if (buf == NULL)
+			buf = (char *) g_async_queue_pop(req_queue);
+		if (*buf == '\0')
 		{
-			tokens_max = ret;
-			tokens = (jsmntok_t *) g_realloc(tokens, sizeof(jsmntok_t) * tokens_max);
+			g_free(buf);
+			break;
 		}
 
-		memset(tokens, 0, ret * sizeof(jsmntok_t));
-
-		ret = json_parse(buf, tokens, ret);
+		ret = sharkd_session_tokenize(buf, &tokens, &tokens_max);
 		if (ret <= 0)
 		{
-			fprintf(stderr, "invalid JSON(2) -> closing\n");
-			return 2;
+			fprintf(stderr, (ret == 0) ? "invalid JSON -> closing\n" : "invalid JSON(2) -> closing\n");
+			g_free(buf);
+			return (ret == 0) ? 1 : 2;
 		}
 
-		host_name_lookup_process();
+		/* newly resolved names show up in the address columns and taps */
+		if (host_name_lookup_process())
+		{
+			sharkd_column_cache_clear();
+			sharkd_tap_cache_clear();
+		}
+
+		if (sharkd_session_split(buf, tokens, ret))
+		{
+			/* so that a cancel request can name this one */
+			req_running_id = g_strdup(json_find_attr(buf, tokens + 1, ret - 1, "id"));
+			req_cancelled = FALSE;
+
+			sharkd_session_process(buf, tokens, ret);
+		}
 
-		sharkd_session_process(buf, tokens, ret);
+		req_id = NULL;
+		g_free(req_running_id);
+		req_running_id = NULL;
+		g_free(buf);
 	}
 
 	g_hash_table_destroy(filter_table);
+	g_hash_table_destroy(tap_cache);
 	g_free(tokens);
 
 	return 0;
@@ -166,6 +166,14 @@ function tap.packet(pinfo,tvb)
     test("FieldInfo.len-1", fi_eth_src.len == 6)
     test("FieldInfo.len-2",not pcall(setFieldInfo,fi_eth_src,"len",6))
 
+    testing("Field.values")
+
+    test("Field.values-1", f_udp_srcport:values() == finfo_udp_srcport.value)
+    local eth_mac_values = { f_eth_mac:values() }
+    test("Field.values-2", #eth_mac_values == #eth_macs)
+    test("Field.values-3", tostring(eth_mac_values[2]) == tostring(eth_macs[2].value))
+    test("Field.values-4", select('#', f_dhcp_opt:values()) == select('#', f_dhcp_opt()))
+
     if packet_count == 4 then
         print("\n-----------------------------\n")
         print("All tests passed!\n\n")
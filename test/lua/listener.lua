@@ -35,7 +35,7 @@ end
 -- note ip only runs 3 times because it gets removed
 -- and dhcp only runs twice because the filter makes it run
 -- once and then it gets replaced with a different one for the second time
-local taptests = { [FRAME]=4, [ETH]=4, [IP]=3, [DHCP]=2, [OTHER]=16 }
+local taptests = { [FRAME]=4, [ETH]=4, [IP]=3, [DHCP]=2, [OTHER]=20 }
 local function getResults()
     print("\n-----------------------------\n")
     for k,v in pairs(taptests) do
@@ -155,6 +155,12 @@ test("Listener.remove-14",pcall(tmptap.remove,tmptap))
 
 test("typeof-15", typeof(tmptap) == "Listener")
 
+local f_frame_number = Field.new("frame.number")
+local f_ip_proto = Field.new("ip.proto")
+local batchtap = Listener.new()
+test("Listener.batch-16",not pcall(batchtap.batch,batchtap,{ "frame.number" }))
+test("Listener.batch-17",pcall(batchtap.batch,batchtap,{ f_frame_number, f_ip_proto },2))
+
 -- revert to original test function
 test = orig_test
 
@@ -265,6 +271,20 @@ dhcp_packet = function (pinfo,tvb,dhcp)
 end
 tap_dhcp.packet = dhcp_packet
 
+-- 4 packets in batches of 2 means two calls, both before draw
+local batched = 0
+function batchtap.packets(rows)
+    testing(OTHER,"batched packets")
+    local ok = #rows == 2
+    for i, row in ipairs(rows) do
+        batched = batched + 1
+        ok = ok and row[1] == batched and row[2] == 17
+    end
+    if test(OTHER,"Listener.packets-"..batched, ok) then
+        setPassed(OTHER)
+    end
+end
+
 function tap_frame.reset()
     -- reset never gets called in tshark (sadly)
     if not GUI_ENABLED then
@@ -23,6 +23,15 @@ local debug = {
 -- set it to debug.LEVEL_2 to enable really verbose printing
 local DEBUG = debug.LEVEL_1
 
+-- pass "record_layout=true" as a script argument to have Wireshark read the
+-- records natively using CaptureInfo.record_layout, instead of calling read()
+local use_record_layout = false
+for _, arg in ipairs({...}) do
+    if arg == "record_layout=true" then
+        use_record_layout = true
+    end
+end
+
 
 local wireshark_name = "Wireshark"
 if not GUI_ENABLED then
@@ -121,6 +130,18 @@ local function read_open(file, capture)
         capture.encap           = file_settings.wtap_type
         capture.snapshot_length = file_settings.snaplen
 
+        if use_record_layout then
+            -- the first 16 bytes are the same for all the record header types
+            capture.record_layout = {
+                header_length = file_settings.rec_hdr_len,
+                big_endian    = file_settings.endianess == ENC_BIG_ENDIAN,
+                ts_secs       = { 0, 4 },
+                ts_fraction   = { 4, 4 },
+                caplen        = { 8, 4 },
+                len           = { 12, 4 },
+            }
+        end
+
         return true
     end
 
@@ -519,6 +519,19 @@ class case_tshark_capture(subprocesstest.SubprocessTestCase):
         '''Capture truncated packets using TShark'''
         check_capture_snapshot_len(self, cmd=cmd_tshark)
 
+    def test_tshark_capture_live_pipeline(self, cmd_tshark, cmd_dumpcap):
+        '''Capture from stdin, dissecting in the live pipeline threads'''
+        slow_dhcp_cmd = subprocesstest.cat_dhcp_command('slow')
+        capture_cmd = capture_command(cmd_tshark,
+            '-i', '-',
+            '--live-pipeline', 'block',
+            '-Y', 'dhcp',
+            '-a', 'duration:{}'.format(capture_duration),
+            shell=True
+        )
+        live_proc = self.assertRun(slow_dhcp_cmd + ' | ' + capture_cmd, shell=True)
+        self.assertEqual(self.countOutput('DHCP', proc=live_proc), 8)
+
 
 @fixtures.mark_usefixtures('base_env')
 @fixtures.uses_fixtures
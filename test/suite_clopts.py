@@ -285,6 +285,121 @@ class case_tshark_z_expert(subprocesstest.SubprocessTestCase):
         self.assertFalse(self.grepOutput('Chats'))
 
 
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_tshark_sampling(subprocesstest.SubprocessTestCase):
+    def read_times(self, cmd_tshark, infile, *args, env=None):
+        proc = self.assertRun((cmd_tshark, '-r', infile) + args +
+            ('-Tfields', '-e', 'frame.time_epoch'), env=env)
+        return proc.stdout_str.splitlines()
+
+    def test_tshark_sample_every(self, cmd_tshark, cmd_editcap, capture_file, test_env):
+        '''--sample-every with and without a record index'''
+        infile = capture_file('dhcp.pcapng')
+        all_times = self.read_times(cmd_tshark, infile)
+        self.assertEqual(self.read_times(cmd_tshark, infile, '--sample-every', '2'), all_times[::2])
+        indexed = self.filename_from_id('dhcp-index.pcapng')
+        index_env = test_env.copy()
+        index_env['WIRESHARK_WTAP_PCAPNG_INDEX'] = '1'
+        self.assertRun((cmd_editcap, infile, indexed), env=index_env)
+        for passes in ((), ('-2',)):
+            self.assertEqual(self.read_times(cmd_tshark, indexed, '--sample-every', '3', *passes), all_times[::3])
+
+    def test_tshark_time_range(self, cmd_tshark, capture_file):
+        '''--time-range with one and with two ranges'''
+        infile = capture_file('dhcp.pcapng')
+        all_times = self.read_times(cmd_tshark, infile)
+        self.assertEqual(self.read_times(cmd_tshark, infile,
+            '--time-range', all_times[1] + ',' + all_times[3]), all_times[1:3])
+        self.assertEqual(self.read_times(cmd_tshark, infile,
+            '--time-range', ',' + all_times[1],
+            '--time-range', all_times[3] + ','), [all_times[0], all_times[3]])
+
+    def test_tshark_time_range_invalid(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-r', capture_file('dhcp.pcapng'),
+            '--time-range', 'yesterday'),
+            expected_return=self.exit_command_line)
+
+    def test_editcap_time_ordered(self, cmd_tshark, cmd_editcap, capture_file):
+        '''editcap -A/-B with --time-ordered keeps the same packets as without'''
+        for infile in (capture_file('dhcp.pcapng'), capture_file('dhcp.pcap')):
+            all_times = self.read_times(cmd_tshark, infile)
+            for ordered in ((), ('--time-ordered',)):
+                outfile = self.filename_from_id('time-ordered-{}.out'.format(len(ordered)))
+                self.assertRun((cmd_editcap, '-A', all_times[1], '-B', all_times[3]) +
+                    ordered + (infile, outfile))
+                self.assertEqual(self.read_times(cmd_tshark, outfile), all_times[1:3])
+
+    def test_tshark_sample_flows(self, cmd_tshark, capture_file):
+        '''--sample-flows 1 keeps everything, and both directions of a flow are kept together'''
+        infile = capture_file('http-ooo.pcap')
+        all_times = self.read_times(cmd_tshark, infile)
+        self.assertEqual(self.read_times(cmd_tshark, infile, '--sample-flows', '1'), all_times)
+        def streams(*args):
+            proc = self.assertRun((cmd_tshark, '-r', infile) + args + ('-Tfields', '-e', 'tcp.stream'))
+            return proc.stdout_str.split()
+        all_streams = streams()
+        sampled_streams = streams('--sample-flows', '2')
+        for stream in set(sampled_streams):
+            self.assertEqual(sampled_streams.count(stream), all_streams.count(stream))
+
+    def test_tshark_spill_frames(self, cmd_tshark, capture_file):
+        '''-2 --spill-frames gives the same output as -2'''
+        infile = capture_file('http-ooo.pcap')
+        for args in ((), ('-Y', 'http'), ('-R', 'tcp.len > 0', '-Y', 'http')):
+            in_memory = self.assertRun((cmd_tshark, '-r', infile, '-2') + args)
+            spilled = self.assertRun((cmd_tshark, '-r', infile, '-2', '--spill-frames') + args)
+            self.assertEqual(spilled.stdout_str, in_memory.stdout_str)
+
+    def test_tshark_spill_frames_requires_two_pass(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-r', capture_file('http-ooo.pcap'), '--spill-frames'),
+            expected_return=self.exit_command_line)
+
+    def test_tshark_filter_workers(self, cmd_tshark, cmd_editcap, capture_file, test_env):
+        '''--filter-workers writes the same packets as filtering without workers'''
+        if sys.platform == 'win32':
+            fixtures.skip('--filter-workers uses fork().')
+        indexed = self.filename_from_id('dhcp-index.pcapng')
+        index_env = test_env.copy()
+        index_env['WIRESHARK_WTAP_PCAPNG_INDEX'] = '1'
+        self.assertRun((cmd_editcap, capture_file('dhcp.pcapng'), indexed), env=index_env)
+        outputs = []
+        for workers in ((), ('--filter-workers', '2')):
+            outfile = self.filename_from_id('filtered-{}.pcapng'.format(len(outputs)))
+            self.assertRun((cmd_tshark, '-r', indexed, '-Y', 'ip.dst == 255.255.255.255',
+                '-w', outfile) + workers)
+            outputs.append(self.read_times(cmd_tshark, outfile))
+        self.assertEqual(outputs[1], outputs[0])
+        self.assertNotEqual(outputs[0], [])
+
+    def test_tshark_filter_workers_requires_write(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-r', capture_file('dhcp.pcapng'), '-Y', 'ip',
+            '--filter-workers', '2'),
+            expected_return=self.exit_command_line)
+
+    def test_tshark_session_idle_timeout(self, cmd_tshark, cmd_editcap, cmd_mergecap, capture_file):
+        '''--session-idle-timeout expires the DNS conversation once DHCP has run for a while'''
+        dns_file = capture_file('dns_port.pcap')
+        dhcp_file = capture_file('dhcp.pcap')
+        dns_times = self.read_times(cmd_tshark, dns_file)
+        dhcp_times = self.read_times(cmd_tshark, dhcp_file)
+        # Start the DHCP packets 10 seconds after the last DNS one.
+        shift = float(dns_times[-1]) - float(dhcp_times[0]) + 10
+        shifted = self.filename_from_id('dhcp-shifted.pcap')
+        self.assertRun((cmd_editcap, '-t', '{:.6f}'.format(shift), dhcp_file, shifted))
+        merged = self.filename_from_id('dns-dhcp.pcap')
+        self.assertRun((cmd_mergecap, '-a', '-w', merged, dns_file, shifted))
+        self.assertRun((cmd_tshark, '-r', merged, '-q'))
+        self.assertFalse(self.grepOutput('idle conversations'))
+        self.assertRun((cmd_tshark, '-r', merged, '-q', '--session-idle-timeout', '5'))
+        self.assertTrue(self.grepOutput(r'expired \d+ idle conversations'))
+
+    def test_tshark_session_limits_require_single_pass(self, cmd_tshark, capture_file):
+        for option in ('--session-idle-timeout', '--session-memory-limit'):
+            self.assertRun((cmd_tshark, '-r', capture_file('dhcp.pcap'), '-2', option, '60'),
+                expected_return=self.exit_command_line)
+
+
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
 class case_tshark_extcap(subprocesstest.SubprocessTestCase):
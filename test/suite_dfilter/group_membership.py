@@ -58,3 +58,15 @@ class case_membership(unittest.TestCase):
         dfilter = 'frame.number in {1 "foo"}'
         error = '"foo" cannot be converted to Unsigned integer, 4 bytes.'
         checkDFilterFail(dfilter, error)
+
+    def test_membership_12_large_set_match(self, checkDFilterCount):
+        dfilter = 'tcp.port in {1 2 3 4 5 6 7 8 80}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_13_large_set_no_match(self, checkDFilterCount):
+        dfilter = 'tcp.dstport in {1 2 3 4 5 6 7 8 81 .. 65535}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_14_large_set_ip_subnet(self, checkDFilterCount):
+        dfilter = 'ip.addr in {192.168.0.1 192.168.0.2 192.168.0.3 192.168.0.4 192.168.0.5 192.168.0.6 192.168.0.7 10.0.0.0/24}'
+        checkDFilterCount(dfilter, 1)
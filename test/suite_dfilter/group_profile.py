@@ -0,0 +1,37 @@
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+
+import subprocess
+import unittest
+import fixtures
+from suite_dfilter.dfiltertest import *
+
+
+@fixtures.fixture
+def run_dftest_profile(cmd_dftest, capture_file, base_env):
+    def run_dftest_profile_real(*args):
+        return subprocess.check_output(
+            (cmd_dftest, '-r', capture_file('http.pcap')) + args,
+            universal_newlines=True, env=base_env)
+    return run_dftest_profile_real
+
+
+@fixtures.uses_fixtures
+class case_profile(unittest.TestCase):
+    def test_profile_1_counts(self, run_dftest_profile):
+        output = run_dftest_profile('-n', '3', 'tcp.port == 80')
+        self.assertIn('Filter: "tcp.port == 80"', output)
+        self.assertIn('Packets:                1\n', output)
+        self.assertIn('Applications:           3\n', output)
+        self.assertIn('Matches:                3\n', output)
+        self.assertIn('READ_TREE:              1 hits, 0 misses, 0 cached', output)
+        self.assertIn('    RETURN ', output)
+
+    def test_profile_2_compare_equivalent(self, run_dftest_profile):
+        output = run_dftest_profile('-f', 'tcp.port in {80}', 'tcp.port == 80')
+        self.assertIn('Comparison:', output)
+        self.assertNotIn('Warning:', output)
+
+    def test_profile_3_compare_different(self, run_dftest_profile):
+        output = run_dftest_profile('-f', 'udp', 'tcp.port == 80')
+        self.assertIn('Warning: not all of the filters matched the same packets.', output)
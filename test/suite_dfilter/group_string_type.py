@@ -132,6 +132,22 @@ class case_string(unittest.TestCase):
         dfilter = 'http.request.method contains 48:45:41:44' # "HEAD"
         checkDFilterCount(dfilter, 1)
 
+    def test_contains_any_1(self, checkDFilterCount):
+        dfilter = 'http.request.method contains "POST" or http.request.method contains "EA" or http.request.method contains "PUT"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_contains_any_2(self, checkDFilterCount):
+        dfilter = 'http.request.method contains "POST" or http.request.method contains "PUT"'
+        checkDFilterCount(dfilter, 0)
+
+    def test_matches_literal_1(self, checkDFilterCount):
+        dfilter = 'http.request.method matches "^hea"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_matches_literal_2(self, checkDFilterCount):
+        dfilter = 'http.request.method matches "^HEAD?X"'
+        checkDFilterCount(dfilter, 0)
+
     def test_contains_fail_0(self, checkDFilterCount):
         dfilter = 'http.user_agent contains "update"'
         checkDFilterCount(dfilter, 0)
@@ -161,6 +177,18 @@ class case_string(unittest.TestCase):
         dfilter = 'lower(http.user_agent) contains "update"'
         checkDFilterCount(dfilter, 1)
 
+    def test_eq_lower_0(self, checkDFilterCount):
+        dfilter = 'lower(http.request.method) == "head"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_eq_lower_2(self, checkDFilterCount):
+        dfilter = 'lower(http.request.method) == "Head"'
+        checkDFilterCount(dfilter, 0)
+
+    def test_eq_upper_0(self, checkDFilterCount):
+        dfilter = 'upper(http.request.method) == "HEAD"'
+        checkDFilterCount(dfilter, 1)
+
     def test_eq_lower_1(self, checkDFilterFail):
         dfilter = 'lower(tcp.seq) == 4'
         error = 'Only strings can be used in upper() or lower() or len()'
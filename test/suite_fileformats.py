@@ -109,6 +109,25 @@ class case_fileformat_pcapng(subprocesstest.SubprocessTestCase):
             )
         self.assertTrue(self.diffOutput(capture_proc.stdout_str, fileformats_baseline_str, 'tshark', baseline_file))
 
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_fileformat_pcapng_index(subprocesstest.SubprocessTestCase):
+    def test_pcapng_index_ignored(self, cmd_editcap, cmd_tshark, capture_file, test_env, fileformats_baseline_str):
+        '''Microsecond pcap direct vs microsecond pcapng with a record index'''
+        outfile = self.filename_from_id('dhcp-index.pcapng')
+        index_env = test_env.copy()
+        index_env['WIRESHARK_WTAP_PCAPNG_INDEX'] = '1'
+        self.assertRun((cmd_editcap, capture_file('dhcp.pcapng'), outfile), env=index_env)
+        for passes in ((), ('-2',)):
+            capture_proc = self.assertRun((cmd_tshark,
+                    '-r', outfile,
+                ) + passes + (
+                    '-Tfields',
+                    '-e', 'frame.number', '-e', 'frame.time_epoch', '-e', 'frame.time_delta',
+                    ),
+                )
+            self.assertTrue(self.diffOutput(capture_proc.stdout_str, fileformats_baseline_str, 'tshark', baseline_file))
+
 @fixtures.fixture
 def check_pcapng_dsb_fields(request, cmd_tshark):
     '''Factory that checks whether the DSB within the capture file matches.'''
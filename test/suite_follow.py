@@ -7,6 +7,8 @@
 #
 '''Follow Stream tests'''
 
+import os
+import tempfile
 import subprocesstest
 import fixtures
 
@@ -71,3 +73,25 @@ Node 1: 10.0.0.2:80
 ===================================================================
 """.replace("\r\n", "\n"),
             proc.stdout_str)
+
+    def test_follow_tcp_files(self, cmd_tshark, capture_file):
+        '''Follow every TCP stream to per-stream files.'''
+        with tempfile.TemporaryDirectory() as out_dir:
+            proc = self.assertRun((cmd_tshark,
+                                    '-r', capture_file('tcp-badsegments.pcap'),
+                                    '-qz', 'follow,tcp,files,{}'.format(out_dir),
+                                    ))
+            self.assertIn('Streams: 1\n', proc.stdout_str)
+            self.assertIn('Stream 0: Node 0 10.0.0.1:32323, ', proc.stdout_str)
+            # The same reassembled client data as the hex dump above.
+            client_file = os.path.join(out_dir, 'tcp-0-client.bin')
+            self.assertEqual(os.path.getsize(client_file), 0x18f)
+            with open(client_file, 'rb') as f:
+                self.assertTrue(f.read().startswith(b'GET / HTTP/1.1\r\n'))
+
+    def test_follow_tcp_files_bad_dir(self, cmd_tshark, capture_file):
+        '''A missing directory is rejected.'''
+        self.assertRun((cmd_tshark,
+                        '-r', capture_file('tcp-badsegments.pcap'),
+                        '-qz', 'follow,tcp,files,{}'.format(self.filename_from_id('missing')),
+                        ), expected_return=1)
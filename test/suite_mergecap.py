@@ -121,6 +121,17 @@ class case_mergecap_pcap(subprocesstest.SubprocessTestCase):
         ))
         check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 62, 1, 62)
 
+    def test_mergecap_basic_many_pcap_pcap(self, cmd_mergecap, capture_file):
+        '''Merge many pcap files to pcap'''
+        # $MERGECAP -vF pcap -w testout.pcap "${CAPTURE_DIR}dhcp.pcap" ... (250 times) > testout.txt 2>&1
+        testout_file = self.filename_from_id(testout_pcap)
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-v',
+            '-F', 'pcap',
+            '-w', testout_file,
+        ) + (capture_file('dhcp.pcap'),) * 250)
+        check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 1000, 1, 1000)
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
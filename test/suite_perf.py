@@ -0,0 +1,252 @@
+#
+# Wireshark tests
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Performance tests
+
+Each test times a scenario over a reference capture and records its wall
+time and peak resident set size (RSS).
+
+Set WS_PERF_RESULTS to a file name to have the results written there as
+JSON; such a file can be used as a baseline for later runs by setting
+WS_PERF_BASELINE to its name. With a baseline, a scenario fails if it is
+slower, or uses more memory, than the baseline by more than
+WS_PERF_TOLERANCE (a fraction, 0.25 by default). WS_PERF_REPEAT sets how
+many times each scenario is run; the fastest run is kept.
+
+Baselines depend on the machine and the build type, so none is shipped.
+'''
+
+import json
+import os
+import subprocess
+import sys
+import time
+import fixtures
+import subprocesstest
+
+
+def _env_float(name, default):
+    try:
+        return float(os.environ.get(name, default))
+    except ValueError:
+        return default
+
+
+@fixtures.fixture(scope='session')
+def perf_results():
+    '''Results of all scenarios in this session, keyed by scenario name.'''
+    results = {}
+    yield results
+    results_file = os.environ.get('WS_PERF_RESULTS')
+    if results_file and results:
+        with open(results_file, 'w') as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+            f.write('\n')
+
+
+@fixtures.fixture(scope='session')
+def perf_baseline():
+    baseline_file = os.environ.get('WS_PERF_BASELINE')
+    if not baseline_file:
+        return {}
+    with open(baseline_file, 'r') as f:
+        return json.load(f)
+
+
+def _run_measured(args, env, stdin_data=None):
+    '''Runs a process to completion. Returns its wall time in seconds and
+    its peak RSS in KiB (None where the platform can't tell).'''
+    start = time.monotonic()
+    proc = subprocess.Popen(args, env=env,
+        stdin=subprocess.PIPE if stdin_data is not None else subprocess.DEVNULL,
+        stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    if stdin_data is not None:
+        proc.stdin.write(stdin_data)
+        proc.stdin.close()
+    if hasattr(os, 'wait4'):
+        # Read stderr first so that a chatty process can't block on it.
+        stderr = proc.stderr.read()
+        _, status, rusage = os.wait4(proc.pid, 0)
+        proc.returncode = os.waitstatus_to_exitcode(status) if hasattr(os, 'waitstatus_to_exitcode') else status >> 8
+        max_rss = rusage.ru_maxrss
+        if sys.platform == 'darwin':
+            # macOS reports bytes, everyone else KiB.
+            max_rss //= 1024
+    else:
+        stderr = proc.communicate()[1]
+        max_rss = None
+    wall_time = time.monotonic() - start
+    proc.stderr.close()
+    return proc.returncode, wall_time, max_rss, stderr
+
+
+@fixtures.fixture
+def check_perf(perf_results, perf_baseline, request):
+    self = request.instance
+
+    def check_perf_real(name, args, stdin_data=None):
+        env = getattr(self, 'injected_test_env', None)
+        repeat = max(1, int(_env_float('WS_PERF_REPEAT', 3)))
+        tolerance = _env_float('WS_PERF_TOLERANCE', 0.25)
+        best_time = None
+        best_rss = None
+        for _ in range(repeat):
+            returncode, wall_time, max_rss, stderr = _run_measured(args, env, stdin_data)
+            self.log_fd.write('{}: {:.3f} s, {} KiB\n'.format(name, wall_time, max_rss))
+            self.assertEqual(returncode, 0, stderr.decode('utf8', 'replace'))
+            if best_time is None or wall_time < best_time:
+                best_time = wall_time
+            if max_rss is not None and (best_rss is None or max_rss < best_rss):
+                best_rss = max_rss
+
+        perf_results[name] = {'wall_time': best_time, 'max_rss': best_rss}
+
+        baseline = perf_baseline.get(name)
+        if not baseline:
+            return
+        if baseline.get('wall_time'):
+            limit = baseline['wall_time'] * (1 + tolerance)
+            self.assertLessEqual(best_time, limit,
+                '{} took {:.3f} s, baseline {:.3f} s'.format(name, best_time, baseline['wall_time']))
+        if baseline.get('max_rss') and best_rss is not None:
+            limit = baseline['max_rss'] * (1 + tolerance)
+            self.assertLessEqual(best_rss, limit,
+                '{} used {} KiB, baseline {} KiB'.format(name, best_rss, baseline['max_rss']))
+    return check_perf_real
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_perf_tshark(subprocesstest.SubprocessTestCase):
+    def test_perf_read(self, check_perf, cmd_tshark, capture_file):
+        '''Read and dissect a capture without printing it'''
+        check_perf('tshark_read', (cmd_tshark,
+            '-r', capture_file('wpa-test-decode.pcap.gz'),
+            '-q',
+        ))
+
+    def test_perf_fields(self, check_perf, cmd_tshark, capture_file):
+        '''Print fields of every packet'''
+        check_perf('tshark_fields', (cmd_tshark,
+            '-r', capture_file('http2-data-reassembly.pcap'),
+            '-T', 'fields',
+            '-e', 'frame.number',
+            '-e', 'ip.src',
+            '-e', 'tcp.srcport',
+            '-e', 'tcp.len',
+        ))
+
+    def test_perf_json(self, check_perf, cmd_tshark, capture_file):
+        '''Print every packet as JSON'''
+        check_perf('tshark_json', (cmd_tshark,
+            '-r', capture_file('http2-data-reassembly.pcap'),
+            '-T', 'json',
+        ))
+
+    def test_perf_filter(self, check_perf, cmd_tshark, capture_file):
+        '''Apply a display filter to every packet'''
+        check_perf('tshark_filter', (cmd_tshark,
+            '-r', capture_file('netperfmeter.pcapng.gz'),
+            '-Y', 'sctp.data_payload_proto_id == 36 || frame.len > 1000',
+            '-q',
+        ))
+
+    def test_perf_conv(self, check_perf, cmd_tshark, capture_file):
+        '''Gather conversation statistics'''
+        check_perf('tshark_conv', (cmd_tshark,
+            '-r', capture_file('http2-data-reassembly.pcap'),
+            '-q',
+            '-z', 'conv,tcp',
+        ))
+
+    def test_perf_two_pass(self, check_perf, cmd_tshark, capture_file):
+        '''Two-pass analysis'''
+        check_perf('tshark_two_pass', (cmd_tshark,
+            '-r', capture_file('http2-data-reassembly.pcap'),
+            '-2',
+            '-q',
+        ))
+
+    def test_perf_strings(self, check_perf, cmd_tshark, capture_file):
+        '''Dissect header-heavy traffic, where most fields are strings'''
+        check_perf('tshark_strings', (cmd_tshark,
+            '-r', capture_file('sip.pcapng'),
+            '-V',
+        ))
+
+    def test_perf_tls_decrypt(self, check_perf, cmd_tshark, dirs, capture_file, features):
+        '''Decrypt TLS with a key log file'''
+        if not features.have_libgcrypt17:
+            self.skipTest('Requires GCrypt 1.7 or later.')
+        key_file = os.path.join(dirs.key_dir, 'tls12-chacha20poly1305.keys')
+        check_perf('tshark_tls_decrypt', (cmd_tshark,
+            '-r', capture_file('tls12-chacha20poly1305.pcap'),
+            '-o', 'tls.keylog_file: {}'.format(key_file),
+            '-V',
+        ))
+
+
+@fixtures.mark_usefixtures('base_env')
+@fixtures.uses_fixtures
+class case_perf_sharkd(subprocesstest.SubprocessTestCase):
+    def test_perf_sharkd_frames(self, check_perf, program, capture_file):
+        '''Load a capture and page through its frames'''
+        cmd_sharkd = program('sharkd')
+        requests = [{'req': 'load', 'file': capture_file('wpa-test-decode.pcap.gz')}]
+        for skip in range(0, 2000, 100):
+            requests.append({'req': 'frames', 'skip': skip, 'limit': 100})
+        stdin_data = '\n'.join(json.dumps(r) for r in requests).encode('utf8')
+        check_perf('sharkd_frames', (cmd_sharkd, '-'), stdin_data=stdin_data)
+
+
+@fixtures.mark_usefixtures('base_env')
+@fixtures.uses_fixtures
+class case_perf_wtapbench(subprocesstest.SubprocessTestCase):
+    def test_perf_wtapbench_compressed(self, program, capture_file):
+        '''Random access into a compressed file uses its fast seek points'''
+        self.assertRun((program('wtapbench'),
+            '-n', '1',
+            capture_file('wpa-test-decode.pcap.gz'),
+        ))
+        self.assertTrue(self.grepOutput('Random access reader:'))
+        self.assertTrue(self.grepOutput(r'rewind: +0$'))
+        self.assertFalse(self.grepOutput(r'Fast seek points: +0$'))
+
+    def test_perf_wtapbench_buffer_sizes(self, program, capture_file):
+        '''Buffer sizes can be compared in one run'''
+        self.assertRun((program('wtapbench'),
+            '-n', '1', '-r', '100',
+            '-b', '4096', '-b', '65536',
+            capture_file('wpa-test-decode.pcap.gz'),
+        ))
+        self.assertTrue(self.grepOutput(r'Buffer size: +4096$'))
+        self.assertTrue(self.grepOutput(r'Buffer size: +65536$'))
+        self.assertTrue(self.grepOutput('Cheap %'))
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_perf_startup_profile(subprocesstest.SubprocessTestCase):
+    def test_perf_startup_profile(self, cmd_tshark, capture_file):
+        '''--startup-profile breaks startup down into nested phases'''
+        profile_file = self.filename_from_id('startup.json')
+        self.assertRun((cmd_tshark,
+            '--startup-profile', profile_file,
+            '-r', capture_file('dhcp.pcap'),
+        ), env=dict(self.injected_test_env, WIRESHARK_STARTUP_PROFILE_THRESHOLD='0'))
+        with open(profile_file) as f:
+            profile = json.load(f)
+        self.assertEqual(profile['application'], 'tshark')
+        phases = {p['name']: p for p in profile['phases']}
+        self.assertIn('wtap_init', phases)
+        self.assertIn('epan_init', phases)
+        self.assertIn('epan_load_settings', phases)
+        subphases = {p['name']: p for p in phases['epan_init']['phases']}
+        proto_init = {p['name']: p for p in subphases['proto_init']['phases']}
+        register = proto_init['register_protocols']
+        # With a threshold of 0, every routine is listed by name.
+        self.assertIn('proto_register_dhcp', [i['name'] for i in register['items']])
+        self.assertNotIn('below_threshold', register)
+        self.assertLessEqual(phases['epan_init']['duration_ns'], profile['total_ns'])
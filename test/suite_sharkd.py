@@ -9,7 +9,9 @@
 '''sharkd tests'''
 
 import json
+import os
 import subprocess
+import tempfile
 import unittest
 import subprocesstest
 import fixtures
@@ -85,6 +87,20 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                 "filename": "dhcp.pcap", "filesize": 1400},
         ))
 
+    def test_sharkd_length_prefixed(self, run_sharkd_session, capture_file):
+        '''A request can be sent as its length and the request, newlines and all'''
+        status = json.dumps({"req": "status"}, indent=1)
+        outputs = run_sharkd_session((
+            json.dumps({"req": "load", "file": capture_file('dhcp.pcap')}),
+            str(len(status.encode('utf8'))),
+            status,
+        ))
+        self.assertEqual(outputs, (
+            {"err": 0},
+            {"frames": 4, "duration": 0.070345000,
+                "filename": "dhcp.pcap", "filesize": 1400},
+        ))
+
     def test_sharkd_req_analyse(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"req": "load", "file": capture_file('dhcp.pcap')},
@@ -169,6 +185,51 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             }),
         ))
 
+    def test_sharkd_req_frames_repeated(self, run_sharkd_session, capture_file):
+        '''Listing frames again, which uses the column cache, gives the same columns'''
+        requests = (
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frames"},
+            {"req": "frames", "column0": "ip.src:0", "column1": "5"},
+            {"req": "frames", "skip": "1", "limit": "2"},
+            {"req": "frames"},
+            {"req": "frames", "column0": "ip.src:0", "column1": "5"},
+        )
+        outputs = run_sharkd_session([json.dumps(x) for x in requests])
+        self.assertEqual(outputs[4], outputs[1])
+        self.assertEqual(outputs[5], outputs[2])
+        self.assertNotEqual(outputs[2], outputs[1])
+        self.assertEqual([f["c"] for f in outputs[3]], [f["c"] for f in outputs[1][1:3]])
+
+    def test_sharkd_req_frame_repeated(self, run_sharkd_session, capture_file):
+        '''Dissecting a frame again takes its record from the record cache'''
+        requests = (
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frame", "frame": 2, "bytes": "yes"},
+            {"req": "frame", "frame": 2, "bytes": "yes"},
+            {"req": "status"},
+        )
+        outputs = run_sharkd_session([json.dumps(x) for x in requests])
+        self.assertEqual(outputs[2], outputs[1])
+        self.assertGreaterEqual(outputs[3]["reccache_hits"], 1)
+        self.assertGreaterEqual(outputs[3]["reccache_misses"], 1)
+        self.assertGreater(outputs[3]["reccache_bytes"], 0)
+
+    def test_sharkd_req_tail(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "tail"},
+            {"req": "load", "file": capture_file('dhcp.pcap'), "tail": "true"},
+            {"req": "tail"},
+            {"req": "status"},
+        ), (
+            {"err": 0},
+            {"err": -1, "errmsg": "File wasn't loaded with tail"},
+            {"err": 0},
+            {"err": 0, "frames": 4, "new": 0},
+            MatchObject({"frames": 4}),
+        ))
+
     def test_sharkd_req_tap_invalid(self, check_sharkd_session, capture_file):
         # XXX Unrecognized taps result in an empty line, modify
         #     run_sharkd_session such that checking for it is possible.
@@ -195,6 +256,7 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                         "type": "host",
                         "proto": "TCP",
                         "geoip": MatchAny(bool),
+                        "total": 0,
                         "hosts": [],
                     },
                     {
@@ -202,6 +264,7 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                         "type": "conv",
                         "proto": "Ethernet",
                         "geoip": MatchAny(bool),
+                        "total": 2,
                         "convs": [
                             {
                                 "saddr": MatchAny(str),
@@ -231,6 +294,42 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             },
         ))
 
+
+    def test_sharkd_req_tap_repeated(self, run_sharkd_session, capture_file):
+        '''Tap requests in a row, which may share a pass or be cached, each get their reply'''
+        requests = (
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "tap", "tap0": "conv:Ethernet"},
+            {"req": "tap", "tap0": "endpt:UDP", "id": "2"},
+            {"req": "tap", "tap0": "conv:Ethernet"},
+        )
+        outputs = run_sharkd_session([json.dumps(x) for x in requests])
+        self.assertEqual(len(outputs), 4)
+        self.assertEqual(outputs[3], outputs[1])
+        self.assertEqual(outputs[1]["taps"][0]["tap"], "conv:Ethernet")
+        self.assertEqual(outputs[2]["taps"][0]["tap"], "endpt:UDP")
+        self.assertEqual(outputs[2]["id"], "2")
+
+    def test_sharkd_req_tap_conv_sorted(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "tap", "tap0": "conv:Ethernet", "sort": "txb", "order": "desc", "limit": "1"},
+            {"req": "tap", "tap0": "conv:Ethernet", "sort": "txb", "skip": "1"},
+            {"req": "tap", "tap0": "conv:Ethernet", "sort": "garbage"},
+        ), (
+            {"err": 0},
+            MatchObject({
+                "taps": [
+                    MatchObject({"total": 2, "convs": [MatchObject({"txb": 684})]}),
+                ],
+            }),
+            MatchObject({
+                "taps": [
+                    MatchObject({"total": 2, "convs": [MatchObject({"txb": 684})]}),
+                ],
+            }),
+            {"err": -1, "errmsg": "Invalid sort"},
+        ))
     def test_sharkd_req_follow_bad(self, check_sharkd_session, capture_file):
         # Unrecognized taps currently produce no output (not even err).
         check_sharkd_session((
@@ -265,6 +364,25 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                  {"n": 1, "d": MatchRegExp(r'AQEGAAAAPR0A[a-zA-Z0-9]{330}AANwQBAwYq/wAAAAAAAAA=')}]},
         ))
 
+    def test_sharkd_req_followall_udp(self, check_sharkd_session, capture_file):
+        with tempfile.TemporaryDirectory() as out_dir:
+            client_file = os.path.join(out_dir, 'udp-0-client.bin')
+            check_sharkd_session((
+                {"req": "load", "file": capture_file('dhcp.pcap')},
+                {"req": "followall", "follow": "UDP", "dir": out_dir, "filter": "frame.number==1"},
+                {"req": "followall", "follow": "UDP", "dir": os.path.join(out_dir, 'missing')},
+            ), (
+                {"err": 0},
+                {"err": 0, "files": 1,
+                 "streams": [
+                     {"stream": 0,
+                      "chost": "0.0.0.0", "cport": "68", "cbytes": 272,
+                      "shost": "255.255.255.255", "sport": "67", "sbytes": 0,
+                      "cfile": client_file}]},
+                {"err": -1, "errmsg": "Not a directory"},
+            ))
+            self.assertEqual(os.path.getsize(client_file), 272)
+
     def test_sharkd_req_iograph_bad(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"req": "load", "file": capture_file('dhcp.pcap')},
@@ -392,6 +510,29 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                 "data": MatchRegExp(r'UlNBIFNlc3Npb24tSUQ6.+')},
         ))
 
+    def test_sharkd_req_cancel(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "cancel", "target": "nothing", "id": "c1"},
+            {"req": "status", "id": "s1"},
+            {"req": "tap", "tap0": "conv:Ethernet", "id": "t1"},
+        ), (
+            {"err": 0},
+            {"err": 0, "id": "c1"},
+            {"frames": 4, "duration": 0.070345000,
+                "filename": "dhcp.pcap", "filesize": 1400, "id": "s1"},
+            {
+                "taps": [{
+                    "tap": "conv:Ethernet",
+                    "type": "conv",
+                    "proto": "Ethernet",
+                    "geoip": MatchAny(bool),
+                    "convs": MatchAny(list),
+                }],
+                "err": 0,
+            },
+        ))
+
     def test_sharkd_req_bye(self, check_sharkd_session):
         check_sharkd_session((
             {"req": "bye"},
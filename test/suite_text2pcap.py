@@ -327,6 +327,28 @@ class case_text2pcap_parsing(subprocesstest.SubprocessTestCase):
                 "0020  74"
         check_rawip(pdata, 1, 33)
 
+    def test_text2pcap_threads(self, cmd_tshark, cmd_text2pcap, capture_file):
+        '''Scanning the input in several threads gives the same output.'''
+        testin_file = self.filename_from_id(testin_txt)
+        self.assertRun('{cmd} -r {cf} -o gui.column.format:"Time","%t" -t ad -P -x > {of}'.format(
+            cmd=cmd_tshark,
+            cf=capture_file('dhcp.pcap'),
+            of=testin_file,
+        ), shell=True)
+        outputs = []
+        for threads in ('1', '4'):
+            testout_file = self.filename_from_id('{}.{}'.format(threads, testout_pcap))
+            self.assertRun((cmd_text2pcap,
+                '-j', threads,
+                '-t', '%Y-%m-%d %H:%M:%S.',
+                testin_file,
+                testout_file,
+            ))
+            with open(testout_file, 'rb') as f:
+                outputs.append(f.read())
+        self.assertEqual(outputs[0], outputs[1])
+        self.assertEqual(check_capinfos_info(self, testout_file)['packets'], 4)
+
 
 @fixtures.fixture
 def run_text2pcap_capinfos_tshark(cmd_text2pcap, cmd_tshark, request):
@@ -152,6 +152,25 @@ class case_wslua(subprocesstest.SubprocessTestCase):
 
         self.diffOutput(lua_out, tshark_out, 'tshark + lua script', 'tshark only')
 
+    def test_wslua_file_reader_record_layout(self, check_lua_script, cmd_tshark, capture_file):
+        '''wslua file reader with a native record layout'''
+        cap_file_1 = capture_file(dhcp_pcap)
+        cap_file_2 = capture_file(wpa_induction_pcap_gz)
+
+        # First run tshark with the pcap_file_reader script, reading the records natively.
+        lua_proc_1 = check_lua_script(self, 'pcap_file.lua', cap_file_1, False,
+            '-X', 'lua_script1:record_layout=true')
+        lua_proc_2 = check_lua_script(self, 'pcap_file.lua', cap_file_2, False,
+            '-X', 'lua_script1:record_layout=true')
+        lua_out = lua_proc_1.stdout_str + lua_proc_2.stdout_str
+
+        # then run tshark again without the script
+        tshark_proc_1 = self.assertRun((cmd_tshark, '-r', cap_file_1))
+        tshark_proc_2 = self.assertRun((cmd_tshark, '-r', cap_file_2))
+        tshark_out = tshark_proc_1.stdout_str + tshark_proc_2.stdout_str
+
+        self.diffOutput(lua_out, tshark_out, 'tshark + lua script', 'tshark only')
+
     def test_wslua_file_writer(self, check_lua_script, capture_file):
         '''wslua file writer'''
         cap_file_1 = capture_file(dhcp_pcap)
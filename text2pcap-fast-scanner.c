@@ -0,0 +1,534 @@
+/********************************************************************************
+ *
+ * text2pcap-fast-scanner.c
+ *
+ * Hand-written replacement for the text2pcap-scanner.l scanner
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ *******************************************************************************/
+
+/*
+ * This produces the same tokens as the flex scanner, but works on large
+ * blocks of input at a time and decodes the bytes of a hex dump with a
+ * table lookup instead of strtoul(), which is what text2pcap spends most
+ * of its time on with large dumps.
+ *
+ * All of the scanner's rules only depend on the current line, so the
+ * input is read in chunks that end at a line boundary, and the chunks
+ * can be scanned in parallel by a pool of threads. The tokens are then
+ * fed to parse_token()/parse_byte() in input order by the main thread,
+ * so the packets come out exactly as they would have otherwise.
+ *
+ * The rules being reproduced, longest match first, earliest rule on a tie:
+ *
+ *   directive   ^#TEXT2PCAP.*\r?\n
+ *   comment     ^[\t ]*#.*\r?\n
+ *   byte        [0-9A-Fa-f][0-9A-Fa-f][ \t]?
+ *   byte_eol    [0-9A-Fa-f][0-9A-Fa-f]\r?\n
+ *   offset      [0-9A-Fa-f]+[: \t]
+ *   offset_eol  [0-9A-Fa-f]+\r?\n
+ *   mailfwd     >{offset}
+ *   eol         \r?\n\r?
+ *   whitespace  [ \t]           (ignored)
+ *   text        [^ \n\t]+
+ *
+ * "^" means the previous match ended with a '\n' (or this is the start
+ * of the input).
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+
+#include "ws_attributes.h"
+#include "text2pcap.h"
+
+/* Input is read this much at a time, and then cut at a line boundary. */
+#define SCAN_CHUNK_SIZE (4 * 1024 * 1024)
+
+/* Chunks read ahead of the one being parsed, per scanning thread. */
+#define SCAN_CHUNKS_PER_THREAD 2
+
+/* Value of each hex digit, or 0xff for anything else. */
+static guint8 hex_value[256];
+
+typedef struct {
+    token_t token;
+    /*
+     * T_BYTE: the number of consecutive bytes, in chunk->bytes;
+     * T_OFFSET, T_TEXT, T_DIRECTIVE: where the token's text starts in
+     * chunk->strs;
+     * T_EOL: unused.
+     */
+    guint32 arg;
+} scan_token_t;
+
+typedef struct {
+    char       *buf;        /* input; a number of whole lines, except at EOF */
+    size_t      len;
+    GArray     *tokens;     /* of scan_token_t */
+    GByteArray *bytes;      /* values of the T_BYTE tokens */
+    GByteArray *strs;       /* NUL-terminated text of the other tokens */
+    GMutex      mtx;
+    GCond       cond;
+    gboolean    done;
+} scan_chunk_t;
+
+static void
+init_hex_value(void)
+{
+    int c;
+
+    memset(hex_value, 0xff, sizeof hex_value);
+    for (c = '0'; c <= '9'; c++)
+        hex_value[c] = c - '0';
+    for (c = 'a'; c <= 'f'; c++)
+        hex_value[c] = c - 'a' + 10;
+    for (c = 'A'; c <= 'F'; c++)
+        hex_value[c] = c - 'A' + 10;
+}
+
+#define IS_HEX(c)   (hex_value[(guint8)(c)] != 0xff)
+#define IS_BLANK(c) ((c) == ' ' || (c) == '\t')
+/* Characters that end a "text" token */
+#define IS_DELIM(c) ((c) == ' ' || (c) == '\t' || (c) == '\n')
+
+static void
+add_token(scan_chunk_t *chunk, token_t token, guint32 arg)
+{
+    scan_token_t tok;
+
+    tok.token = token;
+    tok.arg = arg;
+    g_array_append_val(chunk->tokens, tok);
+}
+
+static void
+add_str_token(scan_chunk_t *chunk, token_t token, const char *str, size_t len)
+{
+    guint32 arg = chunk->strs->len;
+
+    g_byte_array_append(chunk->strs, (const guint8 *)str, (guint)len);
+    g_byte_array_append(chunk->strs, (const guint8 *)"", 1);
+    add_token(chunk, token, arg);
+}
+
+static void
+add_byte(scan_chunk_t *chunk, guint8 value)
+{
+    scan_token_t *last;
+
+    g_byte_array_append(chunk->bytes, &value, 1);
+    /* Runs of bytes are kept as one token. */
+    if (chunk->tokens->len > 0) {
+        last = &g_array_index(chunk->tokens, scan_token_t, chunk->tokens->len - 1);
+        if (last->token == T_BYTE) {
+            last->arg++;
+            return;
+        }
+    }
+    add_token(chunk, T_BYTE, 1);
+}
+
+/* Length of the run of characters that aren't text delimiters. */
+static size_t
+text_len(const char *p, const char *end)
+{
+    const char *q = p;
+
+    while (q < end && !IS_DELIM(*q))
+        q++;
+    return q - p;
+}
+
+/*
+ * Scans a hex number or text starting with a hex digit at p, which
+ * isn't a "byte" followed by a blank; returns where the next token
+ * starts. *bol is set if the token ended a line.
+ */
+static const char *
+scan_hex(scan_chunk_t *chunk, const char *p, const char *end, gboolean *bol)
+{
+    size_t n = 1;
+    size_t t;
+    const char *q;
+    size_t eol_len = 0;
+
+    while (p + n < end && IS_HEX(p[n]))
+        n++;
+    q = p + n;
+    t = text_len(p, end);
+
+    if (q < end && *q == '\n')
+        eol_len = 1;
+    else if (q + 1 < end && q[0] == '\r' && q[1] == '\n')
+        eol_len = 2;
+
+    *bol = FALSE;
+    if (eol_len) {
+        /* byte_eol, if two digits, otherwise offset_eol */
+        if (n == 2) {
+            add_byte(chunk, (hex_value[(guint8)p[0]] << 4) | hex_value[(guint8)p[1]]);
+        } else {
+            add_str_token(chunk, T_OFFSET, p, n + eol_len);
+        }
+        add_token(chunk, T_EOL, 0);
+        *bol = TRUE;
+        return q + eol_len;
+    }
+    if (q < end && (IS_BLANK(*q) || (*q == ':' && t == n + 1))) {
+        /* offset; a byte followed by a blank is handled by our caller */
+        add_str_token(chunk, T_OFFSET, p, n + 1);
+        return q + 1;
+    }
+    if (n == 2 && t == 2) {
+        /* Two digits at the end of the input */
+        add_byte(chunk, (hex_value[(guint8)p[0]] << 4) | hex_value[(guint8)p[1]]);
+        return q;
+    }
+    add_str_token(chunk, T_TEXT, p, t);
+    return p + t;
+}
+
+/*
+ * Scans a line that starts with optional blanks and a '#'; returns NULL if
+ * it isn't a directive or comment (because there's no end of line).
+ */
+static const char *
+scan_comment(scan_chunk_t *chunk, const char *p, const char *end)
+{
+    const char *nl = (const char *)memchr(p, '\n', end - p);
+
+    if (nl == NULL)
+        return NULL;
+    if (end - p >= 10 && memcmp(p, "#TEXT2PCAP", 10) == 0)
+        add_str_token(chunk, T_DIRECTIVE, p, nl + 1 - p);
+    add_token(chunk, T_EOL, 0);
+    return nl + 1;
+}
+
+static void
+scan_chunk(scan_chunk_t *chunk)
+{
+    const char *p = chunk->buf;
+    const char *end = chunk->buf + chunk->len;
+    const char *q;
+    gboolean bol = TRUE;
+    size_t t;
+
+    while (p < end) {
+        if (bol) {
+            for (q = p; q < end && IS_BLANK(*q); q++)
+                ;
+            if (q < end && *q == '#') {
+                q = scan_comment(chunk, p, end);
+                if (q != NULL) {
+                    p = q;
+                    continue;
+                }
+            }
+            bol = FALSE;
+        }
+
+        /* The common case: a byte followed by a blank */
+        while (p + 2 < end && IS_HEX(p[0]) && IS_HEX(p[1]) && IS_BLANK(p[2])) {
+            add_byte(chunk, (hex_value[(guint8)p[0]] << 4) | hex_value[(guint8)p[1]]);
+            p += 3;
+        }
+        if (p >= end)
+            break;
+
+        switch (*p) {
+
+        case ' ':
+        case '\t':
+            p++;
+            break;
+
+        case '\n':
+            /* eol */
+            p++;
+            if (p < end && *p == '\r') {
+                p++;
+            } else {
+                bol = TRUE;
+            }
+            add_token(chunk, T_EOL, 0);
+            break;
+
+        case '\r':
+            if (p + 1 < end && p[1] == '\n') {
+                /* eol */
+                p += 2;
+                if (p < end && *p == '\r') {
+                    p++;
+                } else {
+                    bol = TRUE;
+                }
+                add_token(chunk, T_EOL, 0);
+            } else {
+                t = text_len(p, end);
+                add_str_token(chunk, T_TEXT, p, t);
+                p += t;
+            }
+            break;
+
+        case '>':
+            /* mailfwd, if what follows is an offset */
+            t = text_len(p, end);
+            for (q = p + 1; q < end && IS_HEX(*q); q++)
+                ;
+            if (q > p + 1 && q < end &&
+                    (IS_BLANK(*q) || (*q == ':' && (size_t)(q + 1 - p) == t))) {
+                add_str_token(chunk, T_OFFSET, p + 1, q - p);
+                p = q + 1;
+            } else {
+                add_str_token(chunk, T_TEXT, p, t);
+                p += t;
+            }
+            break;
+
+        default:
+            if (IS_HEX(*p)) {
+                p = scan_hex(chunk, p, end, &bol);
+            } else {
+                t = text_len(p, end);
+                add_str_token(chunk, T_TEXT, p, t);
+                p += t;
+            }
+            break;
+        }
+    }
+}
+
+static scan_chunk_t *
+scan_chunk_new(void)
+{
+    scan_chunk_t *chunk = g_new0(scan_chunk_t, 1);
+
+    chunk->tokens = g_array_new(FALSE, FALSE, sizeof(scan_token_t));
+    chunk->bytes = g_byte_array_new();
+    chunk->strs = g_byte_array_new();
+    g_mutex_init(&chunk->mtx);
+    g_cond_init(&chunk->cond);
+    return chunk;
+}
+
+static void
+scan_chunk_free(scan_chunk_t *chunk)
+{
+    g_free(chunk->buf);
+    g_array_free(chunk->tokens, TRUE);
+    g_byte_array_free(chunk->bytes, TRUE);
+    g_byte_array_free(chunk->strs, TRUE);
+    g_mutex_clear(&chunk->mtx);
+    g_cond_clear(&chunk->cond);
+    g_free(chunk);
+}
+
+static void
+scan_chunk_worker(gpointer data, gpointer user_data _U_)
+{
+    scan_chunk_t *chunk = (scan_chunk_t *)data;
+
+    scan_chunk(chunk);
+
+    g_mutex_lock(&chunk->mtx);
+    chunk->done = TRUE;
+    g_cond_signal(&chunk->cond);
+    g_mutex_unlock(&chunk->mtx);
+}
+
+static void
+scan_chunk_wait(scan_chunk_t *chunk)
+{
+    g_mutex_lock(&chunk->mtx);
+    while (!chunk->done)
+        g_cond_wait(&chunk->cond, &chunk->mtx);
+    g_mutex_unlock(&chunk->mtx);
+}
+
+/*
+ * Finds the last place in buf where a line starts, for a chunk to end;
+ * a line that starts with '\r' doesn't count, as the "\r" would have been
+ * part of the previous line's eol. Returns 0 if there's none.
+ */
+static size_t
+find_chunk_end(const char *buf, size_t len)
+{
+    size_t i;
+
+    for (i = len - 1; i > 0; i--) {
+        if (buf[i - 1] == '\n' && buf[i] != '\r')
+            return i;
+    }
+    return 0;
+}
+
+/*
+ * Reads the next chunk of input, starting with what's left over from the
+ * last one in *carry. Returns NULL at the end of the input or on error.
+ */
+static scan_chunk_t *
+read_chunk(FILE *in, GByteArray *carry, gboolean *eof, int *err)
+{
+    scan_chunk_t *chunk;
+    char   *buf;
+    size_t  alloc = carry->len + SCAN_CHUNK_SIZE;
+    size_t  len = carry->len;
+    size_t  want, got;
+    size_t  chunk_len;
+
+    if (*eof && carry->len == 0)
+        return NULL;
+
+    buf = (char *)g_malloc(alloc);
+    memcpy(buf, carry->data, carry->len);
+    for (;;) {
+        if (!*eof) {
+            want = alloc - len;
+            got = fread(buf + len, 1, want, in);
+            len += got;
+            if (got < want) {
+                if (ferror(in)) {
+                    *err = errno;
+                    g_free(buf);
+                    return NULL;
+                }
+                *eof = TRUE;
+            }
+        }
+        if (*eof) {
+            chunk_len = len;
+            break;
+        }
+        chunk_len = find_chunk_end(buf, len);
+        if (chunk_len > 0)
+            break;
+
+        /* A very long line; read more of it. */
+        alloc += SCAN_CHUNK_SIZE;
+        buf = (char *)g_realloc(buf, alloc);
+    }
+
+    g_byte_array_set_size(carry, 0);
+    g_byte_array_append(carry, (const guint8 *)buf + chunk_len, (guint)(len - chunk_len));
+    if (chunk_len == 0) {
+        g_free(buf);
+        return NULL;
+    }
+
+    chunk = scan_chunk_new();
+    chunk->buf = buf;
+    chunk->len = chunk_len;
+    return chunk;
+}
+
+/* Hands the tokens of a scanned chunk to the parser, in order. */
+static int
+parse_chunk(scan_chunk_t *chunk)
+{
+    const guint8 *bytes = chunk->bytes->data;
+    char *strs = (char *)chunk->strs->data;
+    guint i, j;
+
+    for (i = 0; i < chunk->tokens->len; i++) {
+        scan_token_t *tok = &g_array_index(chunk->tokens, scan_token_t, i);
+
+        switch (tok->token) {
+
+        case T_BYTE:
+            for (j = 0; j < tok->arg; j++) {
+                if (parse_byte(*bytes++) != EXIT_SUCCESS)
+                    return EXIT_FAILURE;
+            }
+            break;
+
+        case T_EOL:
+            if (parse_token(T_EOL, NULL) != EXIT_SUCCESS)
+                return EXIT_FAILURE;
+            break;
+
+        default:
+            if (parse_token(tok->token, strs + tok->arg) != EXIT_SUCCESS)
+                return EXIT_FAILURE;
+            break;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+int
+text2pcap_fast_scan(FILE *in, guint threads)
+{
+    GByteArray   *carry = g_byte_array_new();
+    GThreadPool  *pool = NULL;
+    GQueue        pending = G_QUEUE_INIT;
+    scan_chunk_t *chunk;
+    gboolean      eof = FALSE;
+    int           err = 0;
+    int           ret = EXIT_SUCCESS;
+
+    init_hex_value();
+
+    if (threads > 1)
+        pool = g_thread_pool_new(scan_chunk_worker, NULL, threads, TRUE, NULL);
+
+    for (;;) {
+        /* Keep the scanning threads busy. */
+        while (ret == EXIT_SUCCESS && err == 0 &&
+                g_queue_get_length(&pending) < (pool ? threads * SCAN_CHUNKS_PER_THREAD : 1)) {
+            chunk = read_chunk(in, carry, &eof, &err);
+            if (chunk == NULL)
+                break;
+            if (pool) {
+                g_thread_pool_push(pool, chunk, NULL);
+            } else {
+                scan_chunk(chunk);
+                chunk->done = TRUE;
+            }
+            g_queue_push_tail(&pending, chunk);
+        }
+
+        chunk = (scan_chunk_t *)g_queue_pop_head(&pending);
+        if (chunk == NULL)
+            break;
+        scan_chunk_wait(chunk);
+        if (ret == EXIT_SUCCESS)
+            ret = parse_chunk(chunk);
+        scan_chunk_free(chunk);
+    }
+
+    if (pool)
+        g_thread_pool_free(pool, FALSE, TRUE);
+    g_byte_array_free(carry, TRUE);
+
+    if (err != 0) {
+        fprintf(stderr, "FATAL ERROR: Couldn't read input: %s\n", g_strerror(err));
+        ret = EXIT_FAILURE;
+    }
+    return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -103,6 +103,7 @@
 #include <cli_main.h>
 #include <version_info.h>
 #include <wsutil/inet_addr.h>
+#include <wsutil/strtoi.h>
 
 #ifdef _WIN32
 #include <io.h>     /* for _setmode */
@@ -150,6 +151,10 @@ static int debug = 0;
 /* Be quiet */
 static gboolean quiet = FALSE;
 
+/* Threads to scan the input in; 0 means one per processor, up to 8 */
+static guint scan_threads = 0;
+#define MAX_DEFAULT_SCAN_THREADS 8
+
 /* Dummy Ethernet header */
 static gboolean hdr_ethernet = FALSE;
 static guint8 hdr_eth_dest_addr[6] = {0x0a, 0x02, 0x02, 0x02, 0x02, 0x02};
@@ -424,14 +429,9 @@ parse_num(const char *str, int offset, guint32* num)
  * Write this byte into current packet
  */
 static int
-write_byte(const char *str)
+write_byte_value(guint8 value)
 {
-    guint32 num;
-
-    if (parse_num(str, FALSE, &num) != EXIT_SUCCESS)
-        return EXIT_FAILURE;
-
-    packet_buf[curr_offset] = (guint8) num;
+    packet_buf[curr_offset] = value;
     curr_offset++;
     if (curr_offset - header_length >= max_offset) /* packet full */
         if (start_new_packet(TRUE) != EXIT_SUCCESS)
@@ -440,6 +440,17 @@ write_byte(const char *str)
     return EXIT_SUCCESS;
 }
 
+static int
+write_byte(const char *str)
+{
+    guint32 num;
+
+    if (parse_num(str, FALSE, &num) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    return write_byte_value((guint8) num);
+}
+
 /*----------------------------------------------------------------------
  * Write a number of bytes into current packet
  */
@@ -1354,6 +1365,28 @@ fail_null_str:
     return EXIT_FAILURE;
 }
 
+/*----------------------------------------------------------------------
+ * Parse a byte whose value the scanner has already decoded; the
+ * equivalent of parse_token(T_BYTE, str)
+ */
+int
+parse_byte(guint8 value)
+{
+    switch (state) {
+    case READ_OFFSET:
+        state = READ_BYTE;
+        /* FALLTHROUGH */
+    case READ_BYTE:
+        if (write_byte_value(value) != EXIT_SUCCESS)
+            return EXIT_FAILURE;
+        break;
+    default:
+        break;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 /*----------------------------------------------------------------------
  * Print usage string and exit
  */
@@ -1390,6 +1423,8 @@ print_usage (FILE *output)
             "                         like a HEX dump.\n"
             "                         NOTE: Do not enable it if the input file does not\n"
             "                         contain the ASCII text dump.\n"
+            "  -j <threads>           scan the input in this many threads; default is one\n"
+            "                         per processor, up to %d.\n"
             "\n"
             "Output:\n"
             "  -l <typenum>           link-layer type number; default is 1 (Ethernet).  See\n"
@@ -1441,7 +1476,7 @@ print_usage (FILE *output)
             "  -d                     show detailed debug of parser states.\n"
             "  -q                     generate no output at all (automatically disables -d).\n"
             "",
-            WTAP_MAX_PACKET_SIZE_STANDARD);
+            MAX_DEFAULT_SCAN_THREADS, WTAP_MAX_PACKET_SIZE_STANDARD);
 }
 
 /*----------------------------------------------------------------------
@@ -1463,7 +1498,7 @@ parse_options (int argc, char *argv[])
     ws_init_version_info("Text2pcap (Wireshark)", NULL, NULL, NULL);
 
     /* Scan CLI parameters */
-    while ((c = getopt_long(argc, argv, "aDdhqe:i:l:m:nN:o:u:s:S:t:T:v4:6:", long_options, NULL)) != -1) {
+    while ((c = getopt_long(argc, argv, "aDdhqe:i:j:l:m:nN:o:u:s:S:t:T:v4:6:", long_options, NULL)) != -1) {
         switch (c) {
         case 'h':
             show_help_header("Generate a capture file from an ASCII hexdump of packets.");
@@ -1656,6 +1691,14 @@ parse_options (int argc, char *argv[])
             identify_ascii = TRUE;
             break;
 
+        case 'j':
+            if (!ws_strtou32(optarg, NULL, &scan_threads) || scan_threads == 0) {
+                fprintf(stderr, "Bad argument for '-j': %s\n", optarg);
+                print_usage(stderr);
+                return EXIT_FAILURE;
+            }
+            break;
+
         case 'v':
             show_version();
             exit(0);
@@ -1863,6 +1906,7 @@ int
 main(int argc, char *argv[])
 {
     int ret = EXIT_SUCCESS;
+    int scan_ret;
 
 #ifdef _WIN32
     create_app_running_mutex();
@@ -1906,8 +1950,16 @@ main(int argc, char *argv[])
     }
     curr_offset = header_length;
 
-    text2pcap_in = input_file;
-    if (text2pcap_scan() == EXIT_SUCCESS) {
+    if (scan_threads == 0)
+        scan_threads = MIN((guint)g_get_num_processors(), MAX_DEFAULT_SCAN_THREADS);
+    if (debug >= 2) {
+        /* Trace the tokens as the flex scanner sees them. */
+        text2pcap_in = input_file;
+        scan_ret = text2pcap_scan();
+    } else {
+        scan_ret = text2pcap_fast_scan(input_file, scan_threads);
+    }
+    if (scan_ret == EXIT_SUCCESS) {
         if (write_current_packet(FALSE) != EXIT_SUCCESS)
             ret = EXIT_FAILURE;
     } else {
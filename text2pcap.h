@@ -17,6 +17,10 @@
 #ifndef TEXT2PCAP_H
 #define TEXT2PCAP_H
 
+#include <stdio.h>
+
+#include <glib.h>
+
 typedef enum {
     T_BYTE = 1,
     T_OFFSET,
@@ -27,8 +31,14 @@ typedef enum {
 
 int parse_token(token_t token, char *str);
 
+/* Same as parse_token(T_BYTE, str) for a byte whose value is known */
+int parse_byte(guint8 value);
+
 int text2pcap_scan(void);
 
+/* Scan "in" with the hand-written scanner, in "threads" threads */
+int text2pcap_fast_scan(FILE *in, guint threads);
+
 #endif
 
 /*
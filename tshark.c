@@ -39,6 +39,8 @@
 
 #ifndef _WIN32
 #include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif
 
 #include <glib.h>
@@ -51,6 +53,7 @@
 #include <ui/urls.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
+#include <wsutil/tempfile.h>
 #include <wsutil/socket.h>
 #include <wsutil/privileges.h>
 #include <wsutil/report_message.h>
@@ -92,12 +95,14 @@
 #include <epan/epan_dissect.h>
 #include <epan/tap.h>
 #include <epan/stat_tap_ui.h>
+#include <epan/conversation.h>
 #include <epan/conversation_table.h>
 #include <epan/srt_table.h>
 #include <epan/rtd_table.h>
 #include <epan/ex-opt.h>
 #include <epan/exported_pdu.h>
 #include <epan/secrets.h>
+#include <epan/app_mem_usage.h>
 
 #include "capture_opts.h"
 
@@ -118,6 +123,7 @@
 #include <wsutil/str_util.h>
 #include <wsutil/utf8_entities.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/startup_profile.h>
 #ifdef _WIN32
 #include <wsutil/win32-utils.h>
 #endif
@@ -145,6 +151,15 @@
 #define LONGOPT_COLOR                   LONGOPT_BASE_APPLICATION+2
 #define LONGOPT_NO_DUPLICATE_KEYS       LONGOPT_BASE_APPLICATION+3
 #define LONGOPT_ELASTIC_MAPPING_FILTER  LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_SAMPLE_EVERY            LONGOPT_BASE_APPLICATION+5
+#define LONGOPT_SAMPLE_FLOWS            LONGOPT_BASE_APPLICATION+6
+#define LONGOPT_TIME_RANGE              LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_SPILL_FRAMES            LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_LIVE_PIPELINE           LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_FILTER_WORKERS          LONGOPT_BASE_APPLICATION+10
+#define LONGOPT_STARTUP_PROFILE         LONGOPT_BASE_APPLICATION+11
+#define LONGOPT_SESSION_IDLE_TIMEOUT    LONGOPT_BASE_APPLICATION+12
+#define LONGOPT_SESSION_MEMORY_LIMIT    LONGOPT_BASE_APPLICATION+13
 
 #if 0
 #define tshark_debug(...) g_warning(__VA_ARGS__)
@@ -159,10 +174,53 @@ static frame_data ref_frame;
 static frame_data prev_dis_frame;
 static frame_data prev_cap_frame;
 
+/* Held while reading from, or looking up interfaces in, the wtap. */
+static GMutex live_wtap_lock;
+
 static gboolean perform_two_pass_analysis;
+static gboolean spill_frames;      /* --spill-frames */
+#ifndef _WIN32
+static guint filter_workers;       /* --filter-workers */
+#endif
 static guint32 epan_auto_reset_count = 0;
 static gboolean epan_auto_reset = FALSE;
 
+/*
+ * --session-idle-timeout: expire conversations that have seen no packets
+ * for this many seconds of packet time, looking for them once in that
+ * time.  idle_seconds has the number of the first frame in each second
+ * of packet time that may still be within the timeout.
+ */
+static guint session_idle_timeout = 0;
+typedef struct {
+  time_t secs;
+  guint32 frame;
+} idle_second_t;
+static GQueue idle_seconds = G_QUEUE_INIT;
+static time_t idle_sweep_time;
+
+/*
+ * --session-memory-limit: reset the session when the memory used goes
+ * over this many bytes, checking every SESSION_MEMORY_CHECK_INTERVAL
+ * packets.
+ */
+static gsize session_memory_limit = 0;
+#define SESSION_MEMORY_CHECK_INTERVAL 1000
+
+/*
+ * Subsets of the records in the file to process instead of all of them.
+ */
+static guint32 sample_every;   /* only every Nth record, if > 1 */
+static guint32 sample_flows;   /* only 1 in N flows, if > 1 */
+static GArray *time_ranges;    /* of time_range_t, sorted by start time */
+
+typedef struct {
+  gboolean has_start;
+  nstime_t start;
+  gboolean has_stop;
+  nstime_t stop;
+} time_range_t;
+
 /*
  * The way the packet decode is to be written.
  */
@@ -173,17 +231,20 @@ typedef enum {
   WRITE_FIELDS,   /* User defined list of fields */
   WRITE_JSON,     /* JSON */
   WRITE_JSON_RAW, /* JSON only raw hex */
-  WRITE_EK        /* JSON bulk insert to Elasticsearch */
+  WRITE_EK,       /* JSON bulk insert to Elasticsearch */
+  WRITE_ARROW     /* Typed columns of user defined fields, Arrow or Parquet */
   /* Add CSV and the like here */
 } output_action_e;
 
 static output_action_e output_action;
 static gboolean do_dissection;     /* TRUE if we have to dissect each packet */
+static gboolean frame_only_dissection; /* TRUE if dissecting the frame metadata is enough */
 static gboolean print_packet_info; /* TRUE if we're to print packet information */
 static gboolean print_summary;     /* TRUE if we're to print packet summary information */
 static gboolean print_details;     /* TRUE if we're to print packet details information */
 static gboolean print_hex;         /* TRUE if we're to print hex/ascii information */
 static gboolean line_buffered;
+static gboolean buffer_output; /* -T fields and -T ek output only written in large chunks */
 static gboolean quiet = FALSE;
 static gboolean really_quiet = FALSE;
 static gchar* delimiter_char = " ";
@@ -202,6 +263,8 @@ static gboolean no_duplicate_keys = FALSE;
 static proto_node_children_grouper_func node_children_grouper = proto_node_group_children_by_unique;
 
 static json_dumper jdumper;
+static arrow_format_e arrow_format;
+static arrow_writer_t *arrow_writer;
 
 /* The line separator used between packets, changeable via the -S option */
 static const char *separator = "";
@@ -214,6 +277,17 @@ static gboolean prefs_loaded = FALSE;
  */
 static gboolean print_packet_counts;
 
+/*
+ * What to do, with --live-pipeline, when dissection falls behind.
+ */
+typedef enum {
+  LIVE_PIPELINE_OFF,    /* read and dissect on the main loop */
+  LIVE_PIPELINE_BLOCK,  /* stop reading until dissection catches up */
+  LIVE_PIPELINE_DROP    /* read, but don't dissect, what doesn't fit */
+} live_pipeline_policy_t;
+
+static live_pipeline_policy_t live_pipeline_policy = LIVE_PIPELINE_OFF;
+
 static capture_options global_capture_opts;
 static capture_session global_capture_session;
 static info_data_t global_info_data;
@@ -248,6 +322,7 @@ static void report_counts_siginfo(int);
 #endif /* HAVE_LIBPCAP */
 
 static void reset_epan_mem(capture_file *cf, epan_dissect_t *edt, gboolean tree, gboolean visual);
+static void expire_idle_conversations(capture_file *cf, const nstime_t *abs_ts);
 
 typedef enum {
   PROCESS_FILE_SUCCEEDED,
@@ -373,6 +448,7 @@ print_usage(FILE *output)
   fprintf(output, "  -L, --list-data-link-types\n");
   fprintf(output, "                           print list of link-layer types of iface and exit\n");
   fprintf(output, "  --list-time-stamp-types  print list of timestamp types for iface and exit\n");
+  fprintf(output, "  --update-interval        interval between updates with new packets (def: %dms)\n", DEFAULT_UPDATE_INTERVAL);
   fprintf(output, "\n");
   fprintf(output, "Capture stop conditions:\n");
   fprintf(output, "  -c <packet count>        stop after n packets (def: infinite)\n");
@@ -399,11 +475,33 @@ print_usage(FILE *output)
   fprintf(output, "Input file:\n");
   fprintf(output, "  -r <infile>, --read-file <infile>\n");
   fprintf(output, "                           set the filename to read from (or '-' for stdin)\n");
+  fprintf(output, "  --sample-every <N>       only read every Nth packet, starting with the first\n");
+  fprintf(output, "  --sample-flows <N>       only process 1 in N flows, keeping whole flows\n");
+  fprintf(output, "  --time-range [<start>],[<stop>]\n");
+  fprintf(output, "                           only read packets with a time stamp in this range;\n");
+  fprintf(output, "                           may be repeated. Times are YYYY-MM-DDThh:mm:ss[.n]\n");
+  fprintf(output, "                           [Z|+-hh:mm] or Unix epoch times\n");
 
   fprintf(output, "\n");
   fprintf(output, "Processing:\n");
   fprintf(output, "  -2                       perform a two-pass analysis\n");
+  fprintf(output, "  --spill-frames           with -2, keep the frame list in a temporary file\n");
+  fprintf(output, "                           and read the file sequentially in the second pass\n");
+#ifndef _WIN32
+  fprintf(output, "  --filter-workers <N>     with -Y and -w, filter an indexed file with N\n");
+  fprintf(output, "                           worker processes\n");
+#endif
+#ifdef HAVE_LIBPCAP
+  fprintf(output, "  --live-pipeline block|drop\n");
+  fprintf(output, "                           when capturing, read and dissect packets in their\n");
+  fprintf(output, "                           own threads; if dissection falls behind, block\n");
+  fprintf(output, "                           reading or read packets without dissecting them\n");
+#endif
   fprintf(output, "  -M <packet count>        perform session auto reset\n");
+  fprintf(output, "  --session-idle-timeout <seconds>\n");
+  fprintf(output, "                           expire conversations not seen for this long\n");
+  fprintf(output, "  --session-memory-limit <MiB>\n");
+  fprintf(output, "                           reset the session when memory use goes over this\n");
   fprintf(output, "  -R <read filter>, --read-filter <read filter>\n");
   fprintf(output, "                           packet Read filter in Wireshark display filter syntax\n");
   fprintf(output, "                           (requires -2)\n");
@@ -441,7 +539,11 @@ print_usage(FILE *output)
   fprintf(output, "  -P, --print              print packet summary even when writing to a file\n");
   fprintf(output, "  -S <separator>           the line separator to print between packets\n");
   fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
+#ifdef HAVE_ARROW
+  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|arrow|parquet|?\n");
+#else
   fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|?\n");
+#endif
   fprintf(output, "                           format of text output (def: text)\n");
   fprintf(output, "  -j <protocolfilter>      protocols layers filter if -T ek|pdml|json selected\n");
   fprintf(output, "                           (e.g. \"ip ip.flags text\", filter does not expand child\n");
@@ -493,6 +595,8 @@ print_usage(FILE *output)
   fprintf(output, "  -G [report]              dump one of several available reports and exit\n");
   fprintf(output, "                           default report=\"fields\"\n");
   fprintf(output, "                           use \"-G help\" for more help\n");
+  fprintf(output, "  --startup-profile <file> write a breakdown of the startup time to \"file\"\n");
+  fprintf(output, "                           as JSON (or '-' for stdout)\n");
 #ifdef __linux__
   fprintf(output, "\n");
   fprintf(output, "Dumpcap can benefit from an enabled BPF JIT compiler if available.\n");
@@ -702,7 +806,274 @@ must_do_dissection(dfilter_t *rfcode, dfilter_t *dfcode,
 
         we're using any taps that need dissection. */
   return print_packet_info || rfcode || dfcode || pdu_export_arg ||
-      tap_listeners_require_dissection() || dissect_color;
+      tap_listeners_require_dissection() || dissect_color ||
+      sample_flows > 1;
+}
+
+static gboolean
+can_do_frame_only_dissection(dfilter_t *rfcode, dfilter_t *dfcode,
+                             gchar *volatile pdu_export_arg)
+{
+  /* If the only reason to dissect each packet is a read or display
+     filter, and those filters only refer to fields taken from the
+     frame metadata (frame.len, frame.time, frame.number, ...), we
+     don't have to call the dissectors for the packet contents.
+
+     We can't do that if anything else looks at the packets, as in
+     must_do_dissection(), if a postdissector wants fields, if we're
+     doing two-pass analysis, which has to find the frames that the
+     displayed frames depend upon, or if we're sampling flows, which
+     needs the addresses and ports. */
+  if (print_packet_info || pdu_export_arg ||
+      tap_listeners_require_dissection() || dissect_color ||
+      postdissectors_want_hfids() || perform_two_pass_analysis ||
+      sample_flows > 1)
+    return FALSE;
+  if (rfcode != NULL && !dfilter_is_frame_only(rfcode))
+    return FALSE;
+  if (dfcode != NULL && !dfilter_is_frame_only(dfcode))
+    return FALSE;
+  return TRUE;
+}
+
+static gboolean
+parse_range_time(nstime_t *ts, const char *str)
+{
+  if ((0 < iso8601_to_nstime(ts, str)) || (0 < unix_epoch_to_nstime(ts, str)))
+    return TRUE;
+  cmdarg_err("\"%s\" isn't a valid date and time", str);
+  return FALSE;
+}
+
+static gint
+time_range_compare(gconstpointer a, gconstpointer b)
+{
+  const time_range_t *range_a = (const time_range_t *)a;
+  const time_range_t *range_b = (const time_range_t *)b;
+
+  if (!range_a->has_start || !range_b->has_start)
+    return (range_b->has_start ? -1 : 0) + (range_a->has_start ? 1 : 0);
+  return nstime_cmp(&range_a->start, &range_b->start);
+}
+
+/*
+ * Add a "--time-range [<start>],[<stop>]" range, keeping the list sorted
+ * by start time and merging ranges that overlap, so that it's sorted by
+ * stop time as well.
+ */
+static gboolean
+add_time_range(const char *arg)
+{
+  time_range_t range;
+  const char *comma;
+  gchar *start_str;
+  guint i, j;
+
+  comma = strchr(arg, ',');
+  if (comma == NULL) {
+    cmdarg_err("Invalid time range \"%s\"; it must be [<start>],[<stop>]", arg);
+    return FALSE;
+  }
+
+  memset(&range, 0, sizeof range);
+  start_str = g_strndup(arg, comma - arg);
+  if (*start_str != '\0') {
+    if (!parse_range_time(&range.start, start_str)) {
+      g_free(start_str);
+      return FALSE;
+    }
+    range.has_start = TRUE;
+  }
+  g_free(start_str);
+  if (comma[1] != '\0') {
+    if (!parse_range_time(&range.stop, comma + 1))
+      return FALSE;
+    range.has_stop = TRUE;
+  }
+  if (range.has_start && range.has_stop &&
+      nstime_cmp(&range.stop, &range.start) <= 0) {
+    cmdarg_err("Time range \"%s\" doesn't contain any times", arg);
+    return FALSE;
+  }
+
+  if (time_ranges == NULL)
+    time_ranges = g_array_new(FALSE, FALSE, sizeof(time_range_t));
+  g_array_append_val(time_ranges, range);
+  g_array_sort(time_ranges, time_range_compare);
+
+  for (i = 0, j = 1; j < time_ranges->len; j++) {
+    time_range_t *prev = &g_array_index(time_ranges, time_range_t, i);
+    time_range_t *cur = &g_array_index(time_ranges, time_range_t, j);
+
+    if (!prev->has_stop || !cur->has_start ||
+        nstime_cmp(&cur->start, &prev->stop) <= 0) {
+      /* They overlap or touch; extend the earlier one. */
+      if (prev->has_stop &&
+          (!cur->has_stop || nstime_cmp(&cur->stop, &prev->stop) > 0)) {
+        prev->has_stop = cur->has_stop;
+        prev->stop = cur->stop;
+      }
+    } else {
+      g_array_index(time_ranges, time_range_t, ++i) = *cur;
+    }
+  }
+  g_array_set_size(time_ranges, i + 1);
+  return TRUE;
+}
+
+/*
+ * Whether the sampling or time slicing options want to skip ahead in
+ * the file with its record index, if it has one.
+ */
+static gboolean
+sample_can_seek(void)
+{
+  return sample_every > 1 || time_ranges != NULL;
+}
+
+/*
+ * Put a packet's flow into one of sample_flows buckets and keep the
+ * packets in the first.  The hash doesn't depend on the direction, so
+ * both sides of a conversation end up in the same bucket.
+ */
+static gboolean
+flow_is_sampled(const packet_info *pinfo)
+{
+  guint src_hash, dst_hash, hash;
+
+  src_hash = add_address_to_hash(pinfo->srcport, &pinfo->net_src);
+  dst_hash = add_address_to_hash(pinfo->destport, &pinfo->net_dst);
+  hash = (src_hash ^ dst_hash) + (guint)pinfo->ptype;
+  hash *= 0x9e3779b1U;
+  hash ^= hash >> 16;
+  return hash % sample_flows == 0;
+}
+
+/*
+ * State for picking the records given by --sample-every and --time-range
+ * out of a sequential read of the file.
+ */
+typedef struct {
+  wtap     *wth;
+  gboolean  seek_frames;  /* wtap_seek_to_frame() may get us closer */
+  gboolean  seek_times;   /* wtap_seek_to_time() may get us closer */
+  guint32   next_rec;     /* number of the record the next read returns */
+  guint32   high_water;   /* all records before this one have been seen */
+  guint     seek_range;   /* 1 + the time range last seeked to */
+} sample_state_t;
+
+typedef enum {
+  SAMPLE_KEEP,
+  SAMPLE_SKIP,
+  SAMPLE_DONE,            /* no later records are wanted */
+  SAMPLE_ERROR
+} sample_result_t;
+
+/* Don't bother with the index for a shorter skip than this. */
+#define SAMPLE_SEEK_MIN_DISTANCE 64
+
+static void
+sample_state_init(sample_state_t *ss, wtap *wth, gboolean can_seek)
+{
+  ss->wth = wth;
+  ss->seek_frames = can_seek && sample_every > 1;
+  ss->seek_times = can_seek && time_ranges != NULL;
+  ss->next_rec = 1;
+  ss->high_water = 1;
+  ss->seek_range = 0;
+}
+
+static gboolean
+sample_seek(sample_state_t *ss, guint32 frame_num, const nstime_t *ts,
+            int *err, gchar **err_info)
+{
+  guint32 next_frame_num;
+  gboolean ok;
+
+  if (ts != NULL)
+    ok = wtap_seek_to_time(ss->wth, ts, &next_frame_num, err, err_info);
+  else
+    ok = wtap_seek_to_frame(ss->wth, frame_num, &next_frame_num, err, err_info);
+  if (!ok && *err == 0 && ts != NULL && sample_every <= 1) {
+    /*
+     * No usable index; if the records are in time order, we can
+     * bisect the file instead.  We no longer know the record numbers
+     * after that, but without --sample-every we don't need them.
+     */
+    if (wtap_seek_time(ss->wth, ts, err, err_info)) {
+      tshark_debug("tshark: seeked by time stamp");
+      ss->next_rec = ss->high_water;
+      return TRUE;
+    }
+  }
+  if (!ok) {
+    if (*err != 0)
+      return FALSE;
+    /* No usable index; just keep reading. */
+    if (ts == NULL)
+      ss->seek_frames = FALSE;
+    return TRUE;
+  }
+  tshark_debug("tshark: seeked to record %u", next_frame_num);
+
+  /*
+   * The index may take us back to records we've already looked at;
+   * those get skipped using the high-water mark.  If it does that for
+   * the sampling interval, its entries are too far apart to help.
+   */
+  if (ts == NULL && next_frame_num < ss->next_rec)
+    ss->seek_frames = FALSE;
+  ss->next_rec = next_frame_num;
+  return TRUE;
+}
+
+static sample_result_t
+sample_record(sample_state_t *ss, const wtap_rec *rec, int *err, gchar **err_info)
+{
+  guint32 rec_num = ss->next_rec++;
+
+  if (rec_num < ss->high_water)
+    return SAMPLE_SKIP;
+  ss->high_water = rec_num + 1;
+
+  if (time_ranges != NULL && (rec->presence_flags & WTAP_HAS_TS)) {
+    const time_range_t *range = NULL;
+    guint i;
+
+    /*
+     * Find the first range that hasn't ended by this record's time;
+     * if there isn't one, we assume that we're past all of the ranges,
+     * as we would be if the records are in time order.
+     */
+    for (i = 0; i < time_ranges->len; i++) {
+      range = &g_array_index(time_ranges, time_range_t, i);
+      if (!range->has_stop || nstime_cmp(&rec->ts, &range->stop) < 0)
+        break;
+    }
+    if (i == time_ranges->len)
+      return SAMPLE_DONE;
+    if (range->has_start && nstime_cmp(&rec->ts, &range->start) < 0) {
+      if (ss->seek_times && ss->seek_range != i + 1) {
+        ss->seek_range = i + 1;
+        if (!sample_seek(ss, 0, &range->start, err, err_info))
+          return SAMPLE_ERROR;
+      }
+      return SAMPLE_SKIP;
+    }
+  }
+
+  if (sample_every > 1 && (rec_num - 1) % sample_every != 0) {
+    if (ss->seek_frames) {
+      guint32 wanted = rec_num - (rec_num - 1) % sample_every + sample_every;
+
+      if (wanted > ss->next_rec &&
+          wanted - ss->next_rec >= SAMPLE_SEEK_MIN_DISTANCE &&
+          !sample_seek(ss, wanted, NULL, err, err_info))
+        return SAMPLE_ERROR;
+    }
+    return SAMPLE_SKIP;
+  }
+  return SAMPLE_KEEP;
 }
 
 int
@@ -732,10 +1103,24 @@ main(int argc, char *argv[])
     {"color", no_argument, NULL, LONGOPT_COLOR},
     {"no-duplicate-keys", no_argument, NULL, LONGOPT_NO_DUPLICATE_KEYS},
     {"elastic-mapping-filter", required_argument, NULL, LONGOPT_ELASTIC_MAPPING_FILTER},
+    {"sample-every", required_argument, NULL, LONGOPT_SAMPLE_EVERY},
+    {"sample-flows", required_argument, NULL, LONGOPT_SAMPLE_FLOWS},
+    {"time-range", required_argument, NULL, LONGOPT_TIME_RANGE},
+    {"spill-frames", no_argument, NULL, LONGOPT_SPILL_FRAMES},
+#ifdef HAVE_LIBPCAP
+    {"live-pipeline", required_argument, NULL, LONGOPT_LIVE_PIPELINE},
+#endif
+#ifndef _WIN32
+    {"filter-workers", required_argument, NULL, LONGOPT_FILTER_WORKERS},
+#endif
+    {"startup-profile", required_argument, NULL, LONGOPT_STARTUP_PROFILE},
+    {"session-idle-timeout", required_argument, NULL, LONGOPT_SESSION_IDLE_TIMEOUT},
+    {"session-memory-limit", required_argument, NULL, LONGOPT_SESSION_MEMORY_LIMIT},
     {0, 0, 0, 0 }
   };
   gboolean             arg_error = FALSE;
   gboolean             has_extcap_options = FALSE;
+  guint                startup_phase;
 
   int                  err;
   gchar               *err_info;
@@ -921,6 +1306,9 @@ main(int argc, char *argv[])
     case LONGOPT_ELASTIC_MAPPING_FILTER:
       elastic_mapping_filter = optarg;
       break;
+    case LONGOPT_STARTUP_PROFILE:
+      startup_profile_enable("tshark", optarg);
+      break;
     default:
       break;
     }
@@ -986,7 +1374,9 @@ main(int argc, char *argv[])
   /* Register all tap listeners; we do this before we parse the arguments,
      as the "-z" argument can specify a registered tap. */
 
+  startup_phase = startup_profile_begin("register_all_tap_listeners");
   register_all_tap_listeners(tap_reg_listener);
+  startup_profile_end(startup_phase);
 
   /*
    * An empty cf_name indicates that we're capturing, and we might
@@ -1152,6 +1542,7 @@ main(int argc, char *argv[])
     case 'B':        /* Buffer size */
 #endif
     case LONGOPT_COMPRESS_TYPE:        /* compress type */
+    case LONGOPT_UPDATE_INTERVAL:      /* capture update interval */
       /* These are options only for packet capture. */
 #ifdef HAVE_LIBPCAP
       exit_status = capture_opts_add_opt(&global_capture_opts, opt, optarg, &start_capture);
@@ -1398,11 +1789,29 @@ main(int argc, char *argv[])
         output_action = WRITE_JSON_RAW;
         print_details = TRUE;   /* Need details */
         print_summary = FALSE;  /* Don't allow summary */
+#ifdef HAVE_ARROW
+      } else if (strcmp(optarg, "arrow") == 0) {
+        output_action = WRITE_ARROW;
+        arrow_format = ARROW_FORMAT_IPC_STREAM;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "parquet") == 0) {
+        output_action = WRITE_ARROW;
+        arrow_format = ARROW_FORMAT_PARQUET;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
+#endif
       }
       else {
         cmdarg_err("Invalid -T parameter \"%s\"; it must be one of:", optarg);                   /* x */
         cmdarg_err_cont("\t\"fields\"  The values of fields specified with the -e option, in a form\n"
                         "\t          specified by the -E option.\n"
+#ifdef HAVE_ARROW
+                        "\t\"arrow\"   The values of fields specified with the -e option, as typed\n"
+                        "\t          columns in the Apache Arrow IPC streaming format.\n"
+                        "\t\"parquet\" The values of fields specified with the -e option, as typed\n"
+                        "\t          columns in the Apache Parquet format.\n"
+#endif
                         "\t\"pdml\"    Packet Details Markup Language, an XML-based format for the\n"
                         "\t          details of a decoded packet. This information is equivalent to\n"
                         "\t          the packet details printed with the -V flag.\n"
@@ -1520,6 +1929,48 @@ main(int argc, char *argv[])
       no_duplicate_keys = TRUE;
       node_children_grouper = proto_node_group_children_by_json_key;
       break;
+    case LONGOPT_SAMPLE_EVERY:
+      sample_every = get_nonzero_guint32(optarg, "sampling interval");
+      break;
+    case LONGOPT_SAMPLE_FLOWS:
+      sample_flows = get_nonzero_guint32(optarg, "flow sampling interval");
+      break;
+    case LONGOPT_TIME_RANGE:
+      if (!add_time_range(optarg)) {
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+      }
+      break;
+    case LONGOPT_SPILL_FRAMES:
+      spill_frames = TRUE;
+      break;
+#ifndef _WIN32
+    case LONGOPT_FILTER_WORKERS:
+      filter_workers = get_positive_int(optarg, "number of filter workers");
+      break;
+#endif
+    case LONGOPT_STARTUP_PROFILE:
+      /* already processed; just ignore it now */
+      break;
+    case LONGOPT_SESSION_IDLE_TIMEOUT:
+      session_idle_timeout = get_nonzero_guint32(optarg, "session idle timeout");
+      break;
+    case LONGOPT_SESSION_MEMORY_LIMIT:
+      session_memory_limit = (gsize)get_nonzero_guint32(optarg, "session memory limit") * 1024 * 1024;
+      break;
+#ifdef HAVE_LIBPCAP
+    case LONGOPT_LIVE_PIPELINE:
+      if (strcmp(optarg, "block") == 0) {
+        live_pipeline_policy = LIVE_PIPELINE_BLOCK;
+      } else if (strcmp(optarg, "drop") == 0) {
+        live_pipeline_policy = LIVE_PIPELINE_DROP;
+      } else {
+        cmdarg_err("Invalid --live-pipeline policy \"%s\"; it must be \"block\" or \"drop\".", optarg);
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+      }
+      break;
+#endif
     default:
     case '?':        /* Bad flag - print usage message */
       switch(optopt) {
@@ -1559,7 +2010,7 @@ main(int argc, char *argv[])
   }
 
   /* If we specified output fields, but not the output field type... */
-  if ((WRITE_FIELDS != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
+  if ((WRITE_FIELDS != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action && WRITE_ARROW != output_action) && 0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
             "but \"-Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
         exit_status = INVALID_OPTION;
@@ -1568,6 +2019,12 @@ main(int argc, char *argv[])
         cmdarg_err("\"-Tfields\" was specified, but no fields were "
                     "specified with \"-e\".");
 
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+  } else if (WRITE_ARROW == output_action && 0 == output_fields_num_fields(output_fields)) {
+        cmdarg_err("\"-Tarrow\" or \"-Tparquet\" was specified, but no fields were "
+                    "specified with \"-e\".");
+
         exit_status = INVALID_OPTION;
         goto clean_exit;
   }
@@ -1685,7 +2142,39 @@ main(int argc, char *argv[])
     goto clean_exit;
   }
 
+  if (spill_frames && !perform_two_pass_analysis) {
+    cmdarg_err("--spill-frames requires -2.");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+  if ((session_idle_timeout != 0 || session_memory_limit != 0) && perform_two_pass_analysis) {
+    cmdarg_err("--session-idle-timeout and --session-memory-limit do not support two pass analysis.");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+  if ((sample_every > 1 || sample_flows > 1 || time_ranges != NULL) && !cf_name) {
+    cmdarg_err("--sample-every, --sample-flows and --time-range can only be used when reading a file.");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
+#ifndef _WIN32
+  if (filter_workers > 1 && (!cf_name || !dfilter || !output_file_name)) {
+    cmdarg_err("--filter-workers requires -r, -Y and -w.");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+#endif
+
 #ifdef HAVE_LIBPCAP
+  if (live_pipeline_policy != LIVE_PIPELINE_OFF && cf_name) {
+    cmdarg_err("--live-pipeline can only be used when capturing.");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
   if (caps_queries) {
     /* We're supposed to list the link-layer/timestamp types for an interface;
        did the user also specify a capture file to be read? */
@@ -1942,6 +2431,12 @@ main(int argc, char *argv[])
   /* Build the column format array */
   build_column_format_array(&cfile.cinfo, prefs_p->num_cols, TRUE);
 
+  /* We're done starting up; write the --startup-profile report. */
+  if (!startup_profile_write()) {
+    exit_status = INVALID_FILE;
+    goto clean_exit;
+  }
+
 #ifdef HAVE_LIBPCAP
   capture_opts_trim_snaplen(&global_capture_opts, MIN_PACKET_SIZE);
   capture_opts_trim_ring_num_files(&global_capture_opts);
@@ -2111,6 +2606,13 @@ main(int argc, char *argv[])
        other things, what taps are listening, so determine that after
        starting the statistics taps. */
     do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
+    frame_only_dissection = can_do_frame_only_dissection(rfcode, dfcode, pdu_export_arg);
+
+    /* When reading a file, nobody is waiting to see each "-T fields"
+       or "-T ek" line as it is produced, so write the output in large
+       chunks unless we were asked to flush after every packet or are
+       writing to a terminal. */
+    buffer_output = !line_buffered && !ws_isatty(ws_fileno(stdout));
 
     /* Process the packets in the file */
     tshark_debug("tshark: invoking process_cap_file() to process the packets");
@@ -2294,6 +2796,7 @@ main(int argc, char *argv[])
        other things, what taps are listening, so determine that after
        starting the statistics taps. */
     do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
+    frame_only_dissection = can_do_frame_only_dissection(rfcode, dfcode, pdu_export_arg);
 
     /*
      * XXX - this returns FALSE if an error occurred, but it also
@@ -2489,13 +2992,39 @@ tshark_get_frame_ts(struct packet_provider_data *prov, guint32 frame_num)
   return NULL;
 }
 
+/*
+ * With --live-pipeline, the reading thread can add interfaces while
+ * packets are being dissected, so look them up with the wtap locked.
+ */
+static const char *
+tshark_get_interface_name(struct packet_provider_data *prov, guint32 interface_id)
+{
+  const char *name;
+
+  g_mutex_lock(&live_wtap_lock);
+  name = cap_file_provider_get_interface_name(prov, interface_id);
+  g_mutex_unlock(&live_wtap_lock);
+  return name;
+}
+
+static const char *
+tshark_get_interface_description(struct packet_provider_data *prov, guint32 interface_id)
+{
+  const char *description;
+
+  g_mutex_lock(&live_wtap_lock);
+  description = cap_file_provider_get_interface_description(prov, interface_id);
+  g_mutex_unlock(&live_wtap_lock);
+  return description;
+}
+
 static epan_t *
 tshark_epan_new(capture_file *cf)
 {
   static const struct packet_provider_funcs funcs = {
     tshark_get_frame_ts,
-    cap_file_provider_get_interface_name,
-    cap_file_provider_get_interface_description,
+    tshark_get_interface_name,
+    tshark_get_interface_description,
     NULL,
   };
 
@@ -2503,64 +3032,429 @@ tshark_epan_new(capture_file *cf)
 }
 
 #ifdef HAVE_LIBPCAP
-static gboolean
-capture(void)
-{
-  volatile gboolean ret = TRUE;
-  guint             i;
-  GString          *str;
-#ifdef USE_TSHARK_SELECT
-  fd_set            readfds;
-#endif
-#ifndef _WIN32
-  struct sigaction  action, oldaction;
-#endif
+/*
+ * With --live-pipeline, capture_input_new_packets() just tells a reading
+ * thread how many new records the capture child has written, so that
+ * the main loop goes straight back to the sync pipe and the capture
+ * child never waits for us.  The reading thread reads the records into
+ * a bounded queue, from which a dissecting thread dissects and prints
+ * them.  When the queue is full, the reading thread either waits for
+ * the dissecting thread or, with the "drop" policy, reads the record
+ * without queueing it, so that it's counted but not dissected.
+ *
+ * Name resolution and decryption secrets blocks that the reading thread
+ * comes across are handed over with the next queued record, so that
+ * the dissecting thread applies them in order.  Formatting the output
+ * needs the dissection, so it's done on the dissecting thread.
+ *
+ * The exception stack isn't per-thread, so nothing else may dissect
+ * while the pipeline's running; the main loop drains the pipeline
+ * before it switches to a new capture file or reports the final counts.
+ */
+#define LIVE_PIPELINE_RECORDS 256
 
-  /* Create new dissection section. */
-  epan_free(cfile.epan);
-  cfile.epan = tshark_epan_new(&cfile);
+typedef enum {
+  LIVE_EVENT_IPV4,
+  LIVE_EVENT_IPV6,
+  LIVE_EVENT_SECRETS
+} live_event_type_t;
+
+typedef struct {
+  live_event_type_t type;
+  guint32           ipv4;
+  ws_in6_addr       ipv6;
+  gchar            *name;
+  guint32           secrets_type;
+  gpointer          secrets;
+  guint             secrets_len;
+} live_event_t;
+
+typedef struct {
+  wtap_rec  rec;
+  Buffer    buf;
+  gint64    data_offset;
+  GSList   *events;       /* live_event_t's to apply before dissecting */
+} live_record_t;
+
+typedef struct {
+  capture_session *cap_session;
+  GThread         *reader;
+  GThread         *dissector;
+  GAsyncQueue     *read_q;        /* records read, in file order */
+  GAsyncQueue     *free_q;        /* records to read into */
+  live_record_t    records[LIVE_PIPELINE_RECORDS];
+  live_record_t    scratch;       /* read into when dropping */
+  GSList          *events;        /* read since the last queued record */
+  gboolean         read_failed;
+  guint32          not_dissected;
+  GMutex           lock;          /* protects the members below */
+  GCond            cond;
+  guint            to_read;       /* written by the child, not yet read */
+  guint            in_flight;     /* being read or dissected */
+  gboolean         stop;
+} live_pipeline_t;
+
+static live_pipeline_t *live_pipeline;
+
+/* Queued to stop the dissecting thread. */
+static live_record_t live_pipeline_done;
 
-#ifdef _WIN32
-  /* Catch a CTRL+C event and, if we get it, clean up and exit. */
-  SetConsoleCtrlHandler(capture_cleanup, TRUE);
-#else /* _WIN32 */
-  /* Catch SIGINT and SIGTERM and, if we get either of them,
-     clean up and exit.  If SIGHUP isn't being ignored, catch
-     it too and, if we get it, clean up and exit.
+static void
+live_pipeline_queue_ipv4(const guint addr, const gchar *name)
+{
+  live_event_t *event = g_new0(live_event_t, 1);
 
-     We restart any read that was in progress, so that it doesn't
-     disrupt reading from the sync pipe.  The signal handler tells
-     the capture child to finish; it will report that it finished,
-     or will exit abnormally, so  we'll stop reading from the sync
-     pipe, pick up the exit status, and quit. */
-  memset(&action, 0, sizeof(action));
-  action.sa_handler = capture_cleanup;
-  action.sa_flags = SA_RESTART;
-  sigemptyset(&action.sa_mask);
-  sigaction(SIGTERM, &action, NULL);
-  sigaction(SIGINT, &action, NULL);
-  sigaction(SIGHUP, NULL, &oldaction);
-  if (oldaction.sa_handler == SIG_DFL)
-    sigaction(SIGHUP, &action, NULL);
+  event->type = LIVE_EVENT_IPV4;
+  event->ipv4 = addr;
+  event->name = g_strdup(name);
+  live_pipeline->events = g_slist_prepend(live_pipeline->events, event);
+}
 
-#ifdef SIGINFO
-  /* Catch SIGINFO and, if we get it and we're capturing to a file in
-     quiet mode, report the number of packets we've captured.
+static void
+live_pipeline_queue_ipv6(const void *addrp, const gchar *name)
+{
+  live_event_t *event = g_new0(live_event_t, 1);
 
-     Again, restart any read that was in progress, so that it doesn't
-     disrupt reading from the sync pipe. */
-  action.sa_handler = report_counts_siginfo;
-  action.sa_flags = SA_RESTART;
-  sigemptyset(&action.sa_mask);
-  sigaction(SIGINFO, &action, NULL);
-#endif /* SIGINFO */
-#endif /* _WIN32 */
+  event->type = LIVE_EVENT_IPV6;
+  memcpy(&event->ipv6, addrp, sizeof event->ipv6);
+  event->name = g_strdup(name);
+  live_pipeline->events = g_slist_prepend(live_pipeline->events, event);
+}
 
-  global_capture_session.state = CAPTURE_PREPARING;
+static void
+live_pipeline_queue_secrets(guint32 secrets_type, const void *secrets, guint size)
+{
+  live_event_t *event = g_new0(live_event_t, 1);
 
-  /* Let the user know which interfaces were chosen. */
-  for (i = 0; i < global_capture_opts.ifaces->len; i++) {
-    interface_options *interface_opts;
+  event->type = LIVE_EVENT_SECRETS;
+  event->secrets_type = secrets_type;
+  event->secrets = g_memdup2(secrets, size);
+  event->secrets_len = size;
+  live_pipeline->events = g_slist_prepend(live_pipeline->events, event);
+}
+
+static void
+live_pipeline_set_wtap_callbacks(wtap *wth)
+{
+  wtap_set_cb_new_ipv4(wth, live_pipeline_queue_ipv4);
+  wtap_set_cb_new_ipv6(wth, live_pipeline_queue_ipv6);
+  wtap_set_cb_new_secrets(wth, live_pipeline_queue_secrets);
+}
+
+static void
+live_event_free(gpointer data)
+{
+  live_event_t *event = (live_event_t *)data;
+
+  g_free(event->name);
+  g_free(event->secrets);
+  g_free(event);
+}
+
+static void
+live_event_apply(gpointer data, gpointer user_data _U_)
+{
+  live_event_t *event = (live_event_t *)data;
+
+  switch (event->type) {
+
+  case LIVE_EVENT_IPV4:
+    add_ipv4_name(event->ipv4, event->name);
+    break;
+
+  case LIVE_EVENT_IPV6:
+    add_ipv6_name(&event->ipv6, event->name);
+    break;
+
+  case LIVE_EVENT_SECRETS:
+    secrets_wtap_callback(event->secrets_type, event->secrets, event->secrets_len);
+    break;
+  }
+}
+
+/* A record has been dropped or dissected. */
+static void
+live_pipeline_record_done(live_pipeline_t *lp)
+{
+  g_mutex_lock(&lp->lock);
+  lp->in_flight--;
+  g_cond_broadcast(&lp->cond);
+  g_mutex_unlock(&lp->lock);
+}
+
+static gpointer
+live_pipeline_read_thread(gpointer data)
+{
+  live_pipeline_t *lp = (live_pipeline_t *)data;
+  wtap            *wth;
+  live_record_t   *record;
+  gboolean         ret;
+  int              err;
+  gchar           *err_info;
+
+  for (;;) {
+    g_mutex_lock(&lp->lock);
+    while (lp->to_read == 0 && !lp->stop)
+      g_cond_wait(&lp->cond, &lp->lock);
+    if (lp->to_read == 0) {
+      /* We've been told to stop, and there's nothing left to read. */
+      g_mutex_unlock(&lp->lock);
+      break;
+    }
+    lp->to_read--;
+    lp->in_flight++;
+    g_mutex_unlock(&lp->lock);
+
+    if (live_pipeline_policy == LIVE_PIPELINE_BLOCK) {
+      record = (live_record_t *)g_async_queue_pop(lp->free_q);
+    } else {
+      record = (live_record_t *)g_async_queue_try_pop(lp->free_q);
+      if (record == NULL)
+        record = &lp->scratch;
+    }
+
+    ret = FALSE;
+    err_info = NULL;
+    g_mutex_lock(&live_wtap_lock);
+    wth = lp->cap_session->cf->provider.wth;
+    if (!lp->read_failed && wth != NULL) {
+      wtap_cleareof(wth);
+      ret = wtap_read(wth, &record->rec, &record->buf, &err, &err_info,
+                      &record->data_offset);
+    }
+    g_mutex_unlock(&live_wtap_lock);
+
+    if (ret && record != &lp->scratch) {
+      record->events = g_slist_reverse(lp->events);
+      lp->events = NULL;
+      g_async_queue_push(lp->read_q, record);
+      continue;
+    }
+
+    if (ret) {
+      /* The queue's full; we read it, but it won't be dissected. */
+      lp->not_dissected++;
+    } else if (!lp->read_failed) {
+      /* read from file failed, tell the capture child to stop */
+      g_free(err_info);
+      lp->read_failed = TRUE;
+      sync_pipe_stop(lp->cap_session);
+    }
+    if (record != &lp->scratch)
+      g_async_queue_push(lp->free_q, record);
+    live_pipeline_record_done(lp);
+  }
+  return NULL;
+}
+
+static gpointer
+live_pipeline_dissect_thread(gpointer data)
+{
+  live_pipeline_t *lp = (live_pipeline_t *)data;
+  capture_file    *cf = lp->cap_session->cf;
+  epan_dissect_t  *edt = NULL;
+  gboolean         create_proto_tree = FALSE;
+  guint            tap_flags = 0;
+  live_record_t   *record;
+
+  for (;;) {
+    record = (live_record_t *)g_async_queue_pop(lp->read_q);
+    if (record == &live_pipeline_done)
+      break;
+
+    if (edt == NULL) {
+      /*
+       * Set up to dissect, as capture_input_new_packets() does without
+       * the pipeline, for each run of queued records.
+       */
+      tap_flags = union_of_tap_listener_flags();
+      create_proto_tree =
+        (cf->rfcode || cf->dfcode || print_details || have_filtering_tap_listeners() ||
+          (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+          have_custom_cols(&cf->cinfo) || dissect_color);
+      edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+      epan_dissect_set_frame_only(edt, frame_only_dissection);
+    }
+
+    g_slist_foreach(record->events, live_event_apply, NULL);
+    g_slist_free_full(record->events, live_event_free);
+    record->events = NULL;
+
+    reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+    TRY
+    {
+      if (process_packet_single_pass(cf, edt, record->data_offset, &record->rec,
+                                     &record->buf, tap_flags)) {
+        /* packet successfully read and gone through the "Read Filter" */
+        packet_count++;
+      }
+    }
+    CATCH(OutOfMemoryError) {
+      fprintf(stderr,
+              "Out Of Memory.\n"
+              "\n"
+              "Sorry, but TShark has to terminate now.\n"
+              "\n"
+              "More information and workarounds can be found at\n"
+               WS_WIKI_URL("KnownBugs/OutOfMemory") "\n");
+      abort();
+    }
+    ENDTRY;
+
+    /*
+     * If that's all we have for now, free the epan_dissect_t, so that
+     * nothing refers to the session when the main loop drains us and
+     * starts a new one for a new capture file.
+     */
+    if (g_async_queue_length(lp->read_q) <= 0) {
+      epan_dissect_free(edt);
+      edt = NULL;
+    }
+    g_async_queue_push(lp->free_q, record);
+    live_pipeline_record_done(lp);
+  }
+
+  if (edt != NULL)
+    epan_dissect_free(edt);
+  return NULL;
+}
+
+static void
+live_pipeline_record_init(live_record_t *record)
+{
+  wtap_rec_init(&record->rec);
+  ws_buffer_init(&record->buf, 1514);
+  record->events = NULL;
+}
+
+static void
+live_pipeline_record_cleanup(live_record_t *record)
+{
+  g_slist_free_full(record->events, live_event_free);
+  ws_buffer_free(&record->buf);
+  wtap_rec_cleanup(&record->rec);
+}
+
+static live_pipeline_t *
+live_pipeline_start(capture_session *cap_session)
+{
+  live_pipeline_t *lp = g_new0(live_pipeline_t, 1);
+
+  lp->cap_session = cap_session;
+  lp->read_q = g_async_queue_new();
+  lp->free_q = g_async_queue_new();
+  for (int i = 0; i < LIVE_PIPELINE_RECORDS; i++) {
+    live_pipeline_record_init(&lp->records[i]);
+    g_async_queue_push(lp->free_q, &lp->records[i]);
+  }
+  live_pipeline_record_init(&lp->scratch);
+  g_mutex_init(&lp->lock);
+  g_cond_init(&lp->cond);
+  lp->reader = g_thread_new("live-read", live_pipeline_read_thread, lp);
+  lp->dissector = g_thread_new("live-dissect", live_pipeline_dissect_thread, lp);
+  return lp;
+}
+
+/* The capture child has written more records. */
+static void
+live_pipeline_add(live_pipeline_t *lp, int to_read)
+{
+  g_mutex_lock(&lp->lock);
+  lp->to_read += to_read;
+  g_cond_broadcast(&lp->cond);
+  g_mutex_unlock(&lp->lock);
+}
+
+/* Wait until everything the capture child has written has been handled. */
+static void
+live_pipeline_drain(live_pipeline_t *lp)
+{
+  g_mutex_lock(&lp->lock);
+  while (lp->to_read != 0 || lp->in_flight != 0)
+    g_cond_wait(&lp->cond, &lp->lock);
+  g_mutex_unlock(&lp->lock);
+}
+
+static void
+live_pipeline_stop(live_pipeline_t *lp)
+{
+  g_mutex_lock(&lp->lock);
+  lp->stop = TRUE;
+  g_cond_broadcast(&lp->cond);
+  g_mutex_unlock(&lp->lock);
+  g_thread_join(lp->reader);
+  g_async_queue_push(lp->read_q, &live_pipeline_done);
+  g_thread_join(lp->dissector);
+
+  for (int i = 0; i < LIVE_PIPELINE_RECORDS; i++)
+    live_pipeline_record_cleanup(&lp->records[i]);
+  live_pipeline_record_cleanup(&lp->scratch);
+  g_slist_free_full(lp->events, live_event_free);
+  g_async_queue_unref(lp->read_q);
+  g_async_queue_unref(lp->free_q);
+  g_mutex_clear(&lp->lock);
+  g_cond_clear(&lp->cond);
+  g_free(lp);
+}
+
+static gboolean
+capture(void)
+{
+  volatile gboolean ret = TRUE;
+  guint             i;
+  GString          *str;
+#ifdef USE_TSHARK_SELECT
+  fd_set            readfds;
+#endif
+#ifndef _WIN32
+  struct sigaction  action, oldaction;
+#endif
+
+  /* Create new dissection section. */
+  epan_free(cfile.epan);
+  cfile.epan = tshark_epan_new(&cfile);
+
+#ifdef _WIN32
+  /* Catch a CTRL+C event and, if we get it, clean up and exit. */
+  SetConsoleCtrlHandler(capture_cleanup, TRUE);
+#else /* _WIN32 */
+  /* Catch SIGINT and SIGTERM and, if we get either of them,
+     clean up and exit.  If SIGHUP isn't being ignored, catch
+     it too and, if we get it, clean up and exit.
+
+     We restart any read that was in progress, so that it doesn't
+     disrupt reading from the sync pipe.  The signal handler tells
+     the capture child to finish; it will report that it finished,
+     or will exit abnormally, so  we'll stop reading from the sync
+     pipe, pick up the exit status, and quit. */
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = capture_cleanup;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGTERM, &action, NULL);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGHUP, NULL, &oldaction);
+  if (oldaction.sa_handler == SIG_DFL)
+    sigaction(SIGHUP, &action, NULL);
+
+#ifdef SIGINFO
+  /* Catch SIGINFO and, if we get it and we're capturing to a file in
+     quiet mode, report the number of packets we've captured.
+
+     Again, restart any read that was in progress, so that it doesn't
+     disrupt reading from the sync pipe. */
+  action.sa_handler = report_counts_siginfo;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINFO, &action, NULL);
+#endif /* SIGINFO */
+#endif /* _WIN32 */
+
+  global_capture_session.state = CAPTURE_PREPARING;
+
+  /* Let the user know which interfaces were chosen. */
+  for (i = 0; i < global_capture_opts.ifaces->len; i++) {
+    interface_options *interface_opts;
 
     interface_opts = &g_array_index(global_capture_opts.ifaces, interface_options, i);
     g_free(interface_opts->descr);
@@ -2645,6 +3539,11 @@ capture(void)
     abort();
   }
   ENDTRY;
+
+  if (live_pipeline != NULL) {
+    live_pipeline_stop(live_pipeline);
+    live_pipeline = NULL;
+  }
   return ret;
 }
 
@@ -2708,6 +3607,10 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
 
   g_assert(cap_session->state == CAPTURE_PREPARING || cap_session->state == CAPTURE_RUNNING);
 
+  /* Finish with the old file before we close it. */
+  if (live_pipeline != NULL)
+    live_pipeline_drain(live_pipeline);
+
   /* free the old filename */
   if (capture_opts->save_file != NULL) {
 
@@ -2744,6 +3647,8 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
       capture_opts->save_file = NULL;
       return FALSE;
     }
+    if (live_pipeline_policy != LIVE_PIPELINE_OFF)
+      live_pipeline_set_wtap_callbacks(cf->provider.wth);
   } else if (quiet && is_tempfile) {
       cf->state = FILE_READ_ABORTED;
       cf->filename = g_strdup(new_file);
@@ -2783,7 +3688,12 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
 
-  if (do_dissection) {
+  if (do_dissection && live_pipeline_policy != LIVE_PIPELINE_OFF) {
+    /* Hand them to the reading thread; see above. */
+    if (live_pipeline == NULL)
+      live_pipeline = live_pipeline_start(cap_session);
+    live_pipeline_add(live_pipeline, to_read);
+  } else if (do_dissection) {
     gboolean create_proto_tree;
     epan_dissect_t *edt;
     wtap_rec rec;
@@ -2819,6 +3729,7 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
     edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+    epan_dissect_set_frame_only(edt, frame_only_dissection);
 
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
@@ -2887,6 +3798,11 @@ report_counts(void)
       fprintf(stderr, "%u packet%s captured\n", packet_count,
             plurality(packet_count, "", "s"));
   }
+  if (live_pipeline != NULL && live_pipeline->not_dissected != 0 && really_quiet == FALSE) {
+    /* Some were read while the queue was full with --live-pipeline drop. */
+    fprintf(stderr, "%u packet%s not dissected because dissection couldn't keep up\n",
+            live_pipeline->not_dissected, plurality(live_pipeline->not_dissected, "", "s"));
+  }
 #ifdef SIGINFO
   infoprint = FALSE; /* we just reported it */
 #endif /* SIGINFO */
@@ -2941,6 +3857,9 @@ capture_input_closed(capture_session *cap_session _U_, gchar *msg)
   if (msg != NULL)
     fprintf(stderr, "tshark: %s\n", msg);
 
+  if (live_pipeline != NULL)
+    live_pipeline_drain(live_pipeline);
+
   report_counts();
 
 #ifdef USE_BROKEN_G_MAIN_LOOP
@@ -2999,6 +3918,89 @@ capture_cleanup(int signum _U_)
 #endif /* _WIN32 */
 #endif /* HAVE_LIBPCAP */
 
+/*
+ * With --spill-frames, the first pass writes the frame_data of each
+ * frame it keeps to a temporary file instead of adding it to a
+ * frame_data_sequence, and the second pass reads them back in order;
+ * only one bit per frame, for whether a displayed frame depends on it,
+ * is kept in memory.
+ *
+ * The frame_data are written as they are in memory, as they're read
+ * back by the same process; any per-frame protocol data they point to
+ * stays where the first pass put it.
+ */
+typedef struct {
+  FILE       *fh;
+  gchar      *path;
+  int         err;         /* errno of a failed write */
+  GByteArray *dependent;   /* bit per frame, by frame number */
+} frame_spill_t;
+
+static frame_spill_t frame_spill;
+
+static gboolean
+frame_spill_open(void)
+{
+  GError *gerr = NULL;
+  int fd;
+
+  fd = create_tempfile(&frame_spill.path, "tshark_frames", NULL, &gerr);
+  if (fd == -1) {
+    cmdarg_err("Couldn't create a temporary file for the frame list: %s", gerr->message);
+    g_error_free(gerr);
+    return FALSE;
+  }
+  frame_spill.fh = ws_fdopen(fd, "w+b");
+  if (frame_spill.fh == NULL) {
+    cmdarg_err("Couldn't open the temporary file \"%s\" for the frame list: %s",
+               frame_spill.path, g_strerror(errno));
+    ws_close(fd);
+    ws_unlink(frame_spill.path);
+    g_free(frame_spill.path);
+    frame_spill.path = NULL;
+    return FALSE;
+  }
+  frame_spill.err = 0;
+  frame_spill.dependent = g_byte_array_new();
+  return TRUE;
+}
+
+static void
+frame_spill_close(void)
+{
+  if (frame_spill.fh == NULL)
+    return;
+  fclose(frame_spill.fh);
+  ws_unlink(frame_spill.path);
+  g_free(frame_spill.path);
+  g_byte_array_free(frame_spill.dependent, TRUE);
+  memset(&frame_spill, 0, sizeof frame_spill);
+}
+
+static void
+frame_spill_mark_depended_upon(gpointer data, gpointer user_data _U_)
+{
+  guint32 frame_num = GPOINTER_TO_UINT(data);
+  guint byte = frame_num / 8;
+
+  if (byte >= frame_spill.dependent->len) {
+    guint old_len = frame_spill.dependent->len;
+
+    g_byte_array_set_size(frame_spill.dependent, MAX(byte + 1, old_len * 2));
+    memset(frame_spill.dependent->data + old_len, 0, frame_spill.dependent->len - old_len);
+  }
+  frame_spill.dependent->data[byte] |= 1 << (frame_num % 8);
+}
+
+static gboolean
+frame_spill_is_depended_upon(guint32 frame_num)
+{
+  guint byte = frame_num / 8;
+
+  return byte < frame_spill.dependent->len &&
+         (frame_spill.dependent->data[byte] & (1 << (frame_num % 8))) != 0;
+}
+
 static gboolean
 process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
                           gint64 offset, wtap_rec *rec, Buffer *buf)
@@ -3050,11 +4052,21 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
     /* Run the read filter if we have one. */
     if (cf->rfcode)
       passed = dfilter_apply_edt(cf->rfcode, edt);
+
+    if (passed && sample_flows > 1)
+      passed = flow_is_sampled(&edt->pi);
   }
 
   if (passed) {
     frame_data_set_after_dissect(&fdlocal, &cum_bytes);
-    cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
+    if (frame_spill.fh != NULL) {
+      if (fwrite(&fdlocal, sizeof fdlocal, 1, frame_spill.fh) != 1)
+        frame_spill.err = errno;
+      prev_dis_frame = fdlocal;
+      cf->provider.prev_cap = cf->provider.prev_dis = &prev_dis_frame;
+    } else {
+      cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
+    }
 
     /* If we're not doing dissection then there won't be any dependent frames.
      * More importantly, edt.pi.dependent_frames won't be initialized because
@@ -3064,7 +4076,10 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
      */
     if (edt && cf->dfcode) {
       if (dfilter_apply_edt(cf->dfcode, edt)) {
-        g_slist_foreach(edt->pi.dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+        if (frame_spill.fh != NULL)
+          g_slist_foreach(edt->pi.dependent_frames, frame_spill_mark_depended_upon, NULL);
+        else
+          g_slist_foreach(edt->pi.dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
       }
     }
 
@@ -3142,12 +4157,16 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
   epan_dissect_t *edt = NULL;
   gint64          data_offset;
   pass_status_t   status = PASS_SUCCEEDED;
+  sample_state_t  ss;
 
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
+  sample_state_init(&ss, cf->provider.wth, TRUE);
 
-  /* Allocate a frame_data_sequence for all the frames. */
-  cf->provider.frames = new_frame_data_sequence();
+  /* Allocate a frame_data_sequence for all the frames, unless they
+     go to a temporary file. */
+  if (!spill_frames)
+    cf->provider.frames = new_frame_data_sequence();
 
   if (do_dissection) {
     gboolean create_proto_tree;
@@ -3171,6 +4190,7 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
     /* We're not going to display the protocol tree on this pass,
        so it's not going to be "visible". */
     edt = epan_dissect_new(cf->epan, create_proto_tree, FALSE);
+    epan_dissect_set_frame_only(edt, frame_only_dissection);
   }
 
   tshark_debug("tshark: reading records for first pass");
@@ -3180,7 +4200,20 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
       status = PASS_INTERRUPTED;
       break;
     }
+    if (sample_every > 1 || time_ranges != NULL) {
+      sample_result_t sampled = sample_record(&ss, &rec, err, err_info);
+
+      if (sampled == SAMPLE_SKIP)
+        continue;
+      if (sampled != SAMPLE_KEEP)
+        break;
+    }
     if (process_packet_first_pass(cf, edt, data_offset, &rec, &buf)) {
+      if (frame_spill.err != 0) {
+        *err = frame_spill.err;
+        status = PASS_WRITE_ERROR;
+        break;
+      }
       /* Stop reading if we have the maximum number of packets;
        * When the -c option has not been used, max_packet_count
        * starts at 0, which practically means, never stop reading.
@@ -3194,8 +4227,13 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
       }
     }
   }
-  if (*err != 0)
+  if (*err != 0 && status == PASS_SUCCEEDED)
     status = PASS_READ_ERROR;
+  if (frame_spill.fh != NULL && status != PASS_WRITE_ERROR &&
+      fflush(frame_spill.fh) != 0) {
+    *err = errno;
+    status = PASS_WRITE_ERROR;
+  }
 
   if (edt)
     epan_dissect_free(edt);
@@ -3240,6 +4278,11 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
     if (cf->dfcode)
       epan_dissect_prime_with_dfilter(edt, cf->dfcode);
 
+    /* Let the fields writers stop walking the tree once they have
+       seen every occurrence of the requested fields. */
+    if (print_packet_info)
+      output_fields_prime_edt(output_fields, edt);
+
     col_custom_prime_edt(edt, &cf->cinfo);
 
     /* We only need the columns if either
@@ -3293,9 +4336,22 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
         exit(2);
       }
     }
-    cf->provider.prev_dis = fdata;
+    if (frame_spill.fh != NULL) {
+      /* The frame list is on disk; keep our own copy of the frame. */
+      prev_dis_frame = *fdata;
+      prev_dis_frame.pfd = NULL;
+      cf->provider.prev_dis = &prev_dis_frame;
+    } else {
+      cf->provider.prev_dis = fdata;
+    }
+  }
+  if (frame_spill.fh != NULL) {
+    prev_cap_frame = *fdata;
+    prev_cap_frame.pfd = NULL;
+    cf->provider.prev_cap = &prev_cap_frame;
+  } else {
+    cf->provider.prev_cap = fdata;
   }
-  cf->provider.prev_cap = fdata;
 
   if (edt) {
     epan_dissect_reset(edt);
@@ -3335,6 +4391,9 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
   Buffer          buf;
   guint32         framenum;
   frame_data     *fdata;
+  frame_data      fdlocal;
+  wtap           *seq_wth = NULL;
+  gint64          data_offset;
   gboolean        filtering_tap_listeners;
   guint           tap_flags;
   epan_dissect_t *edt = NULL;
@@ -3386,6 +4445,7 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
     edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+    epan_dissect_set_frame_only(edt, frame_only_dissection);
   }
 
   /*
@@ -3394,17 +4454,55 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
    */
   set_resolution_synchrony(TRUE);
 
+  if (frame_spill.fh != NULL) {
+    /*
+     * The frame list was spilled to a temporary file; read it back in
+     * order, along with the records, from a second, sequential, handle
+     * on the capture file rather than seeking to each record.
+     */
+    rewind(frame_spill.fh);
+    seq_wth = wtap_open_offline(cf->filename, cf->open_type, err, err_info, FALSE);
+    if (seq_wth == NULL) {
+      status = PASS_READ_ERROR;
+      goto done;
+    }
+  }
+
   for (framenum = 1; framenum <= cf->count; framenum++) {
     if (read_interrupted) {
       status = PASS_INTERRUPTED;
       break;
     }
-    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
-    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, err,
-                        err_info)) {
-      /* Error reading from the input file. */
-      status = PASS_READ_ERROR;
-      break;
+    if (seq_wth != NULL) {
+      if (fread(&fdlocal, sizeof fdlocal, 1, frame_spill.fh) != 1) {
+        *err = ferror(frame_spill.fh) ? errno : WTAP_ERR_SHORT_READ;
+        *err_info = NULL;
+        status = PASS_READ_ERROR;
+        break;
+      }
+      fdlocal.dependent_of_displayed = frame_spill_is_depended_upon(framenum);
+      fdata = &fdlocal;
+      /* Skip the records the read filter dropped on the first pass. */
+      do {
+        if (!wtap_read(seq_wth, &rec, &buf, err, err_info, &data_offset)) {
+          if (*err == 0)
+            *err = WTAP_ERR_SHORT_READ;
+          break;
+        }
+      } while (data_offset != fdata->file_off);
+      if (data_offset != fdata->file_off || *err != 0) {
+        frame_data_destroy(&fdlocal);
+        status = PASS_READ_ERROR;
+        break;
+      }
+    } else {
+      fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+      if (!cap_file_provider_read_record(&cf->provider, fdata->num, fdata->file_off,
+                                         &rec, &buf, err, err_info)) {
+        /* Error reading from the input file. */
+        status = PASS_READ_ERROR;
+        break;
+      }
     }
     tshark_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
     if (process_packet_second_pass(cf, edt, fdata, &rec, &buf, tap_flags)) {
@@ -3418,12 +4516,20 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
           tshark_debug("tshark: error writing to a capture file (%d)", *err);
           *err_framenum = framenum;
           status = PASS_WRITE_ERROR;
+          if (seq_wth != NULL)
+            frame_data_destroy(&fdlocal);
           break;
         }
       }
     }
+    if (seq_wth != NULL)
+      frame_data_destroy(&fdlocal);
   }
 
+done:
+  if (seq_wth != NULL)
+    wtap_close(seq_wth);
+
   if (edt)
     epan_dissect_free(edt);
 
@@ -3433,6 +4539,488 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
   return status;
 }
 
+/*
+ * When reading a file in a single pass, read the records in a separate
+ * thread, so that reading (and decompressing) the file overlaps with
+ * dissecting it.
+ *
+ * We only do this for pcap files; their single interface is set up when
+ * the file is opened, and they have no name resolution or decryption
+ * secrets blocks, so reading a record changes nothing in the wtap that
+ * the dissection side looks at.
+ */
+#define READ_AHEAD_RECORDS 64
+
+typedef struct {
+  wtap_rec  rec;
+  Buffer    buf;
+  gint64    data_offset;
+} read_ahead_record_t;
+
+typedef struct {
+  wtap                *wth;
+  GThread             *thread;
+  GAsyncQueue         *read_q;    /* records read, in file order */
+  GAsyncQueue         *free_q;    /* records to read into */
+  read_ahead_record_t  records[READ_AHEAD_RECORDS];
+  gint                 stop;
+  gboolean             at_end;
+  int                  err;
+  gchar               *err_info;
+} read_ahead_t;
+
+/* Queued by the reading thread when it's done, and by us to stop it. */
+static read_ahead_record_t read_ahead_done;
+
+static gboolean
+read_ahead_usable(wtap *wth)
+{
+  int file_type_subtype = wtap_file_type_subtype(wth);
+
+  if (g_get_num_processors() < 2)
+    return FALSE;
+  return file_type_subtype == wtap_pcap_file_type_subtype() ||
+         file_type_subtype == wtap_pcap_nsec_file_type_subtype();
+}
+
+static gpointer
+read_ahead_thread(gpointer data)
+{
+  read_ahead_t        *ra = (read_ahead_t *)data;
+  read_ahead_record_t *record;
+
+  for (;;) {
+    record = (read_ahead_record_t *)g_async_queue_pop(ra->free_q);
+    if (g_atomic_int_get(&ra->stop))
+      break;
+    if (!wtap_read(ra->wth, &record->rec, &record->buf, &ra->err,
+                   &ra->err_info, &record->data_offset))
+      break;
+    g_async_queue_push(ra->read_q, record);
+  }
+  g_async_queue_push(ra->read_q, &read_ahead_done);
+  return NULL;
+}
+
+static read_ahead_t *
+read_ahead_start(wtap *wth)
+{
+  read_ahead_t *ra = g_new0(read_ahead_t, 1);
+
+  ra->wth = wth;
+  ra->read_q = g_async_queue_new();
+  ra->free_q = g_async_queue_new();
+  for (int i = 0; i < READ_AHEAD_RECORDS; i++) {
+    wtap_rec_init(&ra->records[i].rec);
+    ws_buffer_init(&ra->records[i].buf, 1514);
+    g_async_queue_push(ra->free_q, &ra->records[i]);
+  }
+  ra->thread = g_thread_new("read-ahead", read_ahead_thread, ra);
+  return ra;
+}
+
+/*
+ * Get the next record, in the same way as wtap_read(); the record and
+ * its data replace what's in rec and buf, whose contents are handed back
+ * to the reading thread to be reused.
+ */
+static gboolean
+read_ahead_next(read_ahead_t *ra, wtap_rec *rec, Buffer *buf, int *err,
+                gchar **err_info, gint64 *data_offset)
+{
+  read_ahead_record_t *record;
+  wtap_rec             tmp_rec;
+  Buffer               tmp_buf;
+
+  if (ra->at_end) {
+    *err = 0;
+    *err_info = NULL;
+    return FALSE;
+  }
+  record = (read_ahead_record_t *)g_async_queue_pop(ra->read_q);
+  if (record == &read_ahead_done) {
+    ra->at_end = TRUE;
+    *err = ra->err;
+    *err_info = ra->err_info;
+    ra->err_info = NULL;
+    return FALSE;
+  }
+  tmp_rec = *rec;
+  *rec = record->rec;
+  record->rec = tmp_rec;
+  tmp_buf = *buf;
+  *buf = record->buf;
+  record->buf = tmp_buf;
+  *data_offset = record->data_offset;
+  g_async_queue_push(ra->free_q, record);
+  return TRUE;
+}
+
+static void
+read_ahead_stop(read_ahead_t *ra)
+{
+  g_atomic_int_set(&ra->stop, 1);
+  g_async_queue_push(ra->free_q, &read_ahead_done);
+  g_thread_join(ra->thread);
+
+  for (int i = 0; i < READ_AHEAD_RECORDS; i++) {
+    ws_buffer_free(&ra->records[i].buf);
+    wtap_rec_cleanup(&ra->records[i].rec);
+  }
+  g_async_queue_unref(ra->read_q);
+  g_async_queue_unref(ra->free_q);
+  g_free(ra->err_info);
+  g_free(ra);
+}
+
+#ifndef _WIN32
+/*
+ * With --filter-workers, when all we're doing is writing the records
+ * that match a display filter, and the file has a record index, fork
+ * worker processes that each dissect and filter every Nth chunk of
+ * records, starting from the indexed record before it, with their own
+ * epan session.  Each worker writes the numbers of the matching records
+ * to a temporary file, and, when it's done with a chunk, sends the
+ * number of matches over a pipe.  We read the file sequentially as
+ * usual, but take the filter results from the workers, in chunk order,
+ * instead of dissecting, so the records are written in order, along
+ * with the IDBs they need.
+ *
+ * Dissectors keep state across packets, which a worker starting in the
+ * middle of a file doesn't have, so only filters on fields of protocols
+ * whose fields don't depend on earlier packets qualify.
+ */
+#define FILTER_WORKER_CHUNK_RECORDS 65536
+
+#define FILTER_WORKER_END           G_MAXUINT32          /* no more chunks */
+#define FILTER_WORKER_ERROR         (G_MAXUINT32 - 1)    /* followed by the error */
+
+static const char *const filter_worker_protocols[] = {
+  "frame", "eth", "vlan", "sll", "arp", "ip", "ipv6"
+};
+
+typedef struct {
+  guint     n_workers;
+  pid_t    *pids;
+  int      *token_fds;       /* number of matches in each chunk */
+  int      *results_fds;     /* frame numbers of the matches */
+  gchar   **results_paths;
+  guint32   chunk;           /* chunk we have the results of, plus 1 */
+  guint32   remaining;       /* matches in it that we haven't read */
+  guint32   next_match;      /* next matching frame number, or 0 */
+  gboolean  done;            /* the workers have run out of chunks */
+} filter_workers_t;
+
+static gboolean
+filter_worker_field_is_stateless(header_field_info *hfinfo, gpointer user_data _U_)
+{
+  int proto_id = hfinfo->parent == -1 ? hfinfo->id : hfinfo->parent;
+  const char *proto_name = proto_get_protocol_filter_name(proto_id);
+
+  /* Reassembly results depend on the packets before this one... */
+  if (strstr(hfinfo->abbrev, "fragment") != NULL ||
+      strstr(hfinfo->abbrev, "reassembled") != NULL)
+    return FALSE;
+  /* ...as do times relative to an earlier packet. */
+  if (strcmp(hfinfo->abbrev, "frame.time_relative") == 0 ||
+      strcmp(hfinfo->abbrev, "frame.ref_time") == 0 ||
+      g_str_has_prefix(hfinfo->abbrev, "frame.time_delta"))
+    return FALSE;
+  for (size_t i = 0; i < G_N_ELEMENTS(filter_worker_protocols); i++) {
+    if (strcmp(proto_name, filter_worker_protocols[i]) == 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/*
+ * Can we hand the filtering to workers?  If not, say why, and we'll
+ * do it ourselves.
+ */
+static gboolean
+filter_workers_usable(capture_file *cf, wtap_dumper *pdh,
+                      int max_packet_count, gint64 max_byte_count)
+{
+  wtap    *wth;
+  guint32  next_frame_num;
+  int      err;
+  gchar   *err_info = NULL;
+  gboolean indexed;
+
+  if (pdh == NULL || print_packet_info || cf->dfcode == NULL ||
+      tap_listeners_require_dissection() || max_packet_count != 0 ||
+      max_byte_count != 0 || epan_auto_reset || session_idle_timeout != 0 ||
+      session_memory_limit != 0 || sample_flows > 1 ||
+      sample_can_seek() || dissect_color) {
+    cmdarg_err("--filter-workers can only be used when just writing the packets that match -Y; filtering without workers.");
+    return FALSE;
+  }
+  if (!dfilter_check_interesting_fields(cf->dfcode, filter_worker_field_is_stateless, NULL)) {
+    cmdarg_err("The display filter refers to fields that depend on earlier packets; filtering without workers.");
+    return FALSE;
+  }
+  wth = wtap_open_offline(cf->filename, cf->open_type, &err, &err_info, TRUE);
+  if (wth == NULL) {
+    g_free(err_info);
+    return FALSE;
+  }
+  indexed = wtap_seek_to_frame(wth, 1, &next_frame_num, &err, &err_info);
+  g_free(err_info);
+  wtap_close(wth);
+  if (!indexed) {
+    cmdarg_err("\"%s\" has no record index; filtering without workers.", cf->filename);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static void
+filter_worker_send(int fd, guint32 value)
+{
+  const char *p = (const char *)&value;
+  size_t      left = sizeof value;
+  ssize_t     written;
+
+  while (left != 0) {
+    written = write(fd, p, left);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      _exit(2);
+    }
+    p += written;
+    left -= written;
+  }
+}
+
+static gboolean
+filter_worker_receive(int fd, guint32 *value)
+{
+  char   *p = (char *)value;
+  size_t  left = sizeof *value;
+  ssize_t got;
+
+  while (left != 0) {
+    got = read(fd, p, left);
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got <= 0)
+      return FALSE;
+    p += got;
+    left -= got;
+  }
+  return TRUE;
+}
+
+/* Runs in the worker process; never returns. */
+static void G_GNUC_NORETURN
+filter_worker_run(capture_file *cf, guint worker, guint n_workers,
+                  int token_fd, int results_fd)
+{
+  wtap           *wth;
+  FILE           *results;
+  epan_dissect_t *edt;
+  wtap_rec        rec;
+  Buffer          buf;
+  gint64          data_offset;
+  guint32         chunk, first, framenum, matches;
+  gboolean        at_end = FALSE;
+  int             err = 0;
+  gchar          *err_info = NULL;
+
+  /*
+   * Don't touch our parent's wtap; we share its file offsets.  Open
+   * our own, for random access, so we can use the index.
+   */
+  wth = wtap_open_offline(cf->filename, cf->open_type, &err, &err_info, TRUE);
+  results = ws_fdopen(results_fd, "wb");
+  if (wth == NULL || results == NULL) {
+    if (err == 0)
+      err = errno;
+    goto fail;
+  }
+  cf->provider.wth = wth;
+
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+  edt = epan_dissect_new(cf->epan, TRUE, FALSE);
+  epan_dissect_set_frame_only(edt, frame_only_dissection);
+
+  for (chunk = worker; !at_end; chunk += n_workers) {
+    first = chunk * FILTER_WORKER_CHUNK_RECORDS + 1;
+    if (!wtap_seek_to_frame(wth, first, &framenum, &err, &err_info)) {
+      if (err != 0)
+        goto fail;
+      break;    /* past the last indexed record */
+    }
+
+    /* Start afresh, as if this were the beginning of the file. */
+    cf->provider.ref = NULL;
+    cf->provider.prev_dis = NULL;
+    cf->provider.prev_cap = NULL;
+    matches = 0;
+    for (; framenum < first + FILTER_WORKER_CHUNK_RECORDS; framenum++) {
+      if (read_interrupted)
+        _exit(1);
+      if (!wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        if (err != 0)
+          goto fail;
+        at_end = TRUE;
+        break;
+      }
+      if (framenum < first)
+        continue;
+      cf->count = framenum - 1;
+      if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, 0)) {
+        if (fwrite(&framenum, sizeof framenum, 1, results) != 1) {
+          err = errno;
+          goto fail;
+        }
+        matches++;
+      }
+    }
+    if (fflush(results) != 0) {
+      err = errno;
+      goto fail;
+    }
+    filter_worker_send(token_fd, matches);
+  }
+  filter_worker_send(token_fd, FILTER_WORKER_END);
+  _exit(0);
+
+fail:
+  filter_worker_send(token_fd, FILTER_WORKER_ERROR);
+  filter_worker_send(token_fd, (guint32)err);
+  _exit(1);
+}
+
+static void
+filter_workers_stop(filter_workers_t *fw)
+{
+  int status;
+
+  for (guint i = 0; i < fw->n_workers; i++) {
+    if (fw->pids[i] > 0) {
+      kill(fw->pids[i], SIGTERM);
+      waitpid(fw->pids[i], &status, 0);
+    }
+    if (fw->token_fds[i] != -1)
+      ws_close(fw->token_fds[i]);
+    if (fw->results_fds[i] != -1)
+      ws_close(fw->results_fds[i]);
+    if (fw->results_paths[i] != NULL) {
+      ws_unlink(fw->results_paths[i]);
+      g_free(fw->results_paths[i]);
+    }
+  }
+  g_free(fw->pids);
+  g_free(fw->token_fds);
+  g_free(fw->results_fds);
+  g_free(fw->results_paths);
+  g_free(fw);
+}
+
+static filter_workers_t *
+filter_workers_start(capture_file *cf, guint n_workers)
+{
+  filter_workers_t *fw = g_new0(filter_workers_t, 1);
+  GError *gerr = NULL;
+  int     token_pipe[2];
+  int     results_fd;
+
+  fw->n_workers = n_workers;
+  fw->pids = g_new0(pid_t, n_workers);
+  fw->token_fds = g_new(int, n_workers);
+  fw->results_fds = g_new(int, n_workers);
+  fw->results_paths = g_new0(gchar *, n_workers);
+  for (guint i = 0; i < n_workers; i++) {
+    fw->token_fds[i] = -1;
+    fw->results_fds[i] = -1;
+  }
+
+  /* Anything we've buffered would otherwise be written by the workers too. */
+  fflush(stdout);
+  fflush(stderr);
+
+  for (guint i = 0; i < n_workers; i++) {
+    results_fd = create_tempfile(&fw->results_paths[i], "tshark_filter", NULL, &gerr);
+    if (results_fd == -1) {
+      cmdarg_err("Couldn't create a temporary file for the filter workers: %s", gerr->message);
+      g_error_free(gerr);
+      goto fail;
+    }
+    /* We read the results through a descriptor with an offset of our own. */
+    fw->results_fds[i] = ws_open(fw->results_paths[i], O_RDONLY|O_BINARY, 0);
+    if (fw->results_fds[i] == -1 || pipe(token_pipe) == -1) {
+      cmdarg_err("Couldn't set up the filter workers: %s", g_strerror(errno));
+      ws_close(results_fd);
+      goto fail;
+    }
+    fw->pids[i] = fork();
+    if (fw->pids[i] == 0) {
+      ws_close(token_pipe[0]);
+      filter_worker_run(cf, i, n_workers, token_pipe[1], results_fd);
+    }
+    ws_close(token_pipe[1]);
+    ws_close(results_fd);
+    fw->token_fds[i] = token_pipe[0];
+    if (fw->pids[i] == -1) {
+      cmdarg_err("Couldn't start the filter workers: %s", g_strerror(errno));
+      goto fail;
+    }
+  }
+  return fw;
+
+fail:
+  filter_workers_stop(fw);
+  return NULL;
+}
+
+/*
+ * Did record framenum match?  Records must be asked about in order.
+ * Returns FALSE, with *err set, if a worker failed.
+ */
+static gboolean
+filter_workers_passed(filter_workers_t *fw, guint32 framenum,
+                      gboolean *passed, int *err)
+{
+  guint32 chunk = (framenum - 1) / FILTER_WORKER_CHUNK_RECORDS;
+  guint   worker = chunk % fw->n_workers;
+  guint32 value;
+
+  if (!fw->done && fw->chunk != chunk + 1) {
+    /* Wait for the worker doing this chunk to finish it. */
+    if (!filter_worker_receive(fw->token_fds[worker], &value)) {
+      *err = WTAP_ERR_INTERNAL;
+      return FALSE;
+    }
+    if (value == FILTER_WORKER_ERROR) {
+      *err = filter_worker_receive(fw->token_fds[worker], &value) ?
+             (int)value : WTAP_ERR_INTERNAL;
+      return FALSE;
+    }
+    if (value == FILTER_WORKER_END) {
+      fw->done = TRUE;
+      value = 0;
+    }
+    fw->chunk = chunk + 1;
+    fw->remaining = value;
+    fw->next_match = 0;
+  }
+  if (fw->next_match == 0 && fw->remaining != 0) {
+    if (!filter_worker_receive(fw->results_fds[worker], &fw->next_match)) {
+      *err = WTAP_ERR_INTERNAL;
+      return FALSE;
+    }
+    fw->remaining--;
+  }
+  *passed = fw->next_match == framenum;
+  if (*passed)
+    fw->next_match = 0;
+  return TRUE;
+}
+#endif /* _WIN32 */
+
 static pass_status_t
 process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
                              int max_packet_count, gint64 max_byte_count,
@@ -3448,6 +5036,12 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
   epan_dissect_t *edt = NULL;
   gint64          data_offset;
   pass_status_t   status = PASS_SUCCEEDED;
+  read_ahead_t   *ra = NULL;
+  sample_state_t  ss;
+  gboolean        passed;
+#ifndef _WIN32
+  filter_workers_t *fw = NULL;
+#endif
 
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
@@ -3493,6 +5087,7 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
     edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+    epan_dissect_set_frame_only(edt, frame_only_dissection);
   }
 
   /*
@@ -3502,12 +5097,38 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
    */
   set_resolution_synchrony(TRUE);
 
+#ifndef _WIN32
+  /* Start the workers before any read-ahead thread; they're forked. */
+  if (filter_workers > 1 &&
+      filter_workers_usable(cf, pdh, max_packet_count, max_byte_count)) {
+    tshark_debug("tshark: filtering with %u worker processes", filter_workers);
+    fw = filter_workers_start(cf, filter_workers);
+  }
+#endif
+
+  if (read_ahead_usable(cf->provider.wth)) {
+    tshark_debug("tshark: reading records in a separate thread");
+    ra = read_ahead_start(cf->provider.wth);
+  }
+  /* The read-ahead thread's position can't be moved under it. */
+  sample_state_init(&ss, cf->provider.wth, ra == NULL);
+
   *err = 0;
-  while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+  while (ra != NULL ?
+         read_ahead_next(ra, &rec, &buf, err, err_info, &data_offset) :
+         wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
     if (read_interrupted) {
       status = PASS_INTERRUPTED;
       break;
     }
+    if (sample_every > 1 || time_ranges != NULL) {
+      sample_result_t sampled = sample_record(&ss, &rec, err, err_info);
+
+      if (sampled == SAMPLE_SKIP)
+        continue;
+      if (sampled != SAMPLE_KEEP)
+        break;
+    }
     framenum++;
 
     /*
@@ -3521,9 +5142,23 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 
     tshark_debug("tshark: processing packet #%d", framenum);
 
-    reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+#ifndef _WIN32
+    if (fw != NULL) {
+      /* The workers have dissected and filtered it. */
+      if (!filter_workers_passed(fw, framenum, &passed, err)) {
+        *err_info = NULL;
+        status = PASS_READ_ERROR;
+        break;
+      }
+      cf->count++;
+    } else
+#endif
+    {
+      reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+      passed = process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags);
+    }
 
-    if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
+    if (passed) {
       /* Either there's no read filtering or this packet passed the
          filter, so, if we're writing to a capture file, write
          this packet out. */
@@ -3550,6 +5185,12 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
       break;
     }
   }
+  if (ra != NULL)
+    read_ahead_stop(ra);
+#ifndef _WIN32
+  if (fw != NULL)
+    filter_workers_stop(fw);
+#endif
   if (*err != 0 && status == PASS_SUCCEEDED) {
     /* Error reading from the input file. */
     status = PASS_READ_ERROR;
@@ -3580,6 +5221,14 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
   char        *shb_user_appl;
   pass_status_t first_pass_status, second_pass_status;
 
+  if (perform_two_pass_analysis && spill_frames) {
+    /* Set up to keep the frame list in a temporary file. */
+    if (!frame_spill_open()) {
+      status = PROCESS_FILE_NO_FILE_PROCESSED;
+      goto out;
+    }
+  }
+
   if (save_file != NULL) {
     /* Set up to write to the capture file. */
     wtap_dump_params_init_no_idbs(&params, cf->provider.wth);
@@ -3656,9 +5305,21 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
 
     tshark_debug("tshark: done with first pass");
 
-    if (first_pass_status == PASS_INTERRUPTED) {
-      /* The first pass was interrupted; skip the second pass.
-         It won't be run, so it won't get an error. */
+    /*
+     * Resolve all the addresses the first pass queued up for
+     * resolution in bulk, rather than one at a time, synchronously,
+     * as the second pass comes across them.
+     */
+    if (first_pass_status != PASS_INTERRUPTED && gbl_resolv_flags.network_name) {
+      tshark_debug("tshark: resolving addresses seen in the first pass");
+      host_name_lookup_wait();
+    }
+
+    if (first_pass_status == PASS_INTERRUPTED ||
+        first_pass_status == PASS_WRITE_ERROR) {
+      /* The first pass was interrupted, or couldn't save the frame
+         list; skip the second pass.  It won't be run, so it won't
+         get an error. */
       second_pass_status = PASS_SUCCEEDED;
     } else {
       /*
@@ -3686,6 +5347,15 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
                                                       &err_framenum);
   }
 
+  if (getenv("WIRESHARK_REPORT_TREE_ITEM_COUNTS") != NULL) {
+    guint64 items_added, items_faked;
+
+    proto_tree_get_item_counts(&items_added, &items_faked);
+    fprintf(stderr, "%" G_GUINT64_FORMAT " protocol tree item%s added, %" G_GUINT64_FORMAT " not added because nothing referenced %s.\n",
+            items_added, plurality(items_added, "", "s"),
+            items_faked, plurality(items_faked, "it", "them"));
+  }
+
   if (first_pass_status != PASS_SUCCEEDED ||
       second_pass_status != PASS_SUCCEEDED) {
     /*
@@ -3733,7 +5403,10 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
       break;
 
     case PASS_WRITE_ERROR:
-      /* Won't happen on the first pass. */
+      /* Only happens when writing the frame list to a temporary file. */
+      cmdarg_err("An error occurred while writing the frame list to the temporary file \"%s\": %s.",
+                 frame_spill.path, g_strerror(err_pass1));
+      status = PROCESS_FILE_ERROR;
       break;
 
     case PASS_INTERRUPTED:
@@ -3803,6 +5476,9 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
 out:
   wtap_close(cf->provider.wth);
   cf->provider.wth = NULL;
+  cap_file_provider_free_record_cache(&cf->provider);
+
+  frame_spill_close();
 
   wtap_dump_params_cleanup(&params);
 
@@ -3842,6 +5518,11 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
        with the hfids postdissectors want on the first pass. */
     prime_epan_dissect_with_postdissector_wanted_hfids(edt);
 
+    /* Let the fields writers stop walking the tree once they have
+       seen every occurrence of the requested fields. */
+    if (print_packet_info)
+      output_fields_prime_edt(output_fields, edt);
+
     col_custom_prime_edt(edt, &cf->cinfo);
 
     /* We only need the columns if either
@@ -3875,6 +5556,11 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
     /* Run the filter if we have it. */
     if (cf->dfcode)
       passed = dfilter_apply_edt(cf->dfcode, edt);
+
+    if (passed && sample_flows > 1)
+      passed = flow_is_sampled(&edt->pi);
+
+    expire_idle_conversations(cf, &fdata.abs_ts);
   }
 
   if (passed) {
@@ -3941,6 +5627,19 @@ write_preamble(capture_file *cf)
   case WRITE_EK:
     return TRUE;
 
+  case WRITE_ARROW:
+  {
+    gchar *err_msg;
+
+    arrow_writer = write_arrow_preamble(output_fields, arrow_format, 0, stdout, &err_msg);
+    if (arrow_writer == NULL) {
+      cmdarg_err("%s", err_msg);
+      g_free(err_msg);
+      return FALSE;
+    }
+    return TRUE;
+  }
+
   default:
     g_assert_not_reached();
     return FALSE;
@@ -4280,8 +5979,9 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
       g_assert_not_reached();
     }
     if (print_details) {
-      write_fields_proto_tree(output_fields, edt, &cf->cinfo, stdout);
-      printf("\n");
+      write_fields_proto_tree_buffered(output_fields, edt, &cf->cinfo, stdout);
+      if (!buffer_output)
+        write_fields_flush(output_fields, stdout);
       return !ferror(stdout);
     }
     break;
@@ -4311,8 +6011,22 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
   case WRITE_EK:
     write_ek_proto_tree(output_fields, print_summary, print_hex, protocolfilter,
                         protocolfilter_flags, edt, &cf->cinfo, stdout);
+    if (!buffer_output)
+      write_ek_flush(stdout);
     return !ferror(stdout);
 
+  case WRITE_ARROW:
+  {
+    gchar *err_msg;
+
+    if (!write_arrow_proto_tree(arrow_writer, edt, &cf->cinfo, &err_msg)) {
+      cmdarg_err("%s", err_msg);
+      g_free(err_msg);
+      exit(2);
+    }
+    return TRUE;
+  }
+
   default:
     g_assert_not_reached();
   }
@@ -4355,7 +6069,21 @@ write_finale(void)
     return !ferror(stdout);
 
   case WRITE_EK:
-    return TRUE;
+    write_ek_finale(stdout);
+    return !ferror(stdout);
+
+  case WRITE_ARROW:
+  {
+    gchar *err_msg;
+    gboolean ok = write_arrow_finale(arrow_writer, &err_msg);
+
+    arrow_writer = NULL;
+    if (!ok) {
+      cmdarg_err("%s", err_msg);
+      g_free(err_msg);
+    }
+    return ok;
+  }
 
   default:
     g_assert_not_reached();
@@ -4373,6 +6101,7 @@ cf_close(capture_file *cf)
     wtap_close(cf->provider.wth);
     cf->provider.wth = NULL;
   }
+  cap_file_provider_free_record_cache(&cf->provider);
   /* We have no file open... */
   if (cf->filename != NULL) {
     /* If it's a temporary file, remove it. */
@@ -4392,13 +6121,21 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   wtap  *wth;
   gchar *err_info;
 
-  wth = wtap_open_offline(fname, type, err, &err_info, perform_two_pass_analysis);
+  /* Sampling and time slicing can skip ahead with a record index,
+     which is only available if the file is opened for random access;
+     if it can't be, just read through the records that aren't wanted. */
+  wth = wtap_open_offline(fname, type, err, &err_info,
+                          perform_two_pass_analysis || sample_can_seek());
+  if (wth == NULL && !perform_two_pass_analysis &&
+      (*err == WTAP_ERR_RANDOM_OPEN_PIPE || *err == WTAP_ERR_RANDOM_OPEN_STDIN))
+    wth = wtap_open_offline(fname, type, err, &err_info, FALSE);
   if (wth == NULL)
     goto fail;
 
   /* The open succeeded.  Fill in the information for this file. */
 
   cf->provider.wth = wth;
+  cap_file_provider_init_record_cache(&cf->provider);
   cf->f_datalen = 0; /* not used, but set it anyway */
 
   /* Set the file name because we need it to set the follow stream filter.
@@ -4535,9 +6272,91 @@ tshark_cmdarg_err_cont(const char *msg_format, va_list ap)
   fprintf(stderr, "\n");
 }
 
+/*
+ * The memory the process is using, as resident set size where that's
+ * known and total memory otherwise, or 0 if it can't be found out.
+ */
+static gsize
+session_memory_used(void)
+{
+  const char *name;
+  gsize value, total = 0;
+  guint i;
+
+  for (i = 0; (name = memory_usage_get(i, &value)) != NULL; i++) {
+    if (strcmp(name, "RSS") == 0)
+      return value;
+    if (strcmp(name, "Total") == 0)
+      total = value;
+  }
+  return total;
+}
+
+static gboolean
+session_needs_reset(capture_file *cf)
+{
+  if (epan_auto_reset && cf->count >= epan_auto_reset_count)
+    return TRUE;
+
+  if (session_memory_limit != 0 && cf->count != 0 &&
+      cf->count % SESSION_MEMORY_CHECK_INTERVAL == 0)
+    return session_memory_used() > session_memory_limit;
+
+  return FALSE;
+}
+
+/*
+ * Expire the conversations that have been idle for at least
+ * session_idle_timeout seconds, once that many seconds of packet time
+ * have passed since the last time this was done.
+ */
+static void
+expire_idle_conversations(capture_file *cf, const nstime_t *abs_ts)
+{
+  idle_second_t *second;
+  time_t idle_before;
+  guint32 first_active = 0;
+  guint expired;
+
+  if (session_idle_timeout == 0)
+    return;
+
+  second = (idle_second_t *)g_queue_peek_tail(&idle_seconds);
+  if (second == NULL || abs_ts->secs > second->secs) {
+    if (second == NULL)
+      idle_sweep_time = abs_ts->secs;
+    second = g_new(idle_second_t, 1);
+    second->secs = abs_ts->secs;
+    second->frame = cf->count;
+    g_queue_push_tail(&idle_seconds, second);
+  }
+
+  if (abs_ts->secs - idle_sweep_time < (time_t)session_idle_timeout)
+    return;
+  idle_sweep_time = abs_ts->secs;
+
+  /*
+   * Every frame before the first one of the second after a second that
+   * ended before idle_before has been idle long enough.  The current
+   * frame's second is never dropped, so there's always a next one.
+   */
+  idle_before = abs_ts->secs - (time_t)session_idle_timeout;
+  while ((second = (idle_second_t *)g_queue_peek_head(&idle_seconds)) != NULL &&
+         second->secs < idle_before) {
+    g_free(g_queue_pop_head(&idle_seconds));
+    first_active = ((idle_second_t *)g_queue_peek_head(&idle_seconds))->frame;
+  }
+  if (first_active == 0)
+    return;
+
+  expired = conversation_expire(first_active);
+  if (expired != 0)
+    fprintf(stderr, "expired %u idle conversations.\n", expired);
+}
+
 static void reset_epan_mem(capture_file *cf,epan_dissect_t *edt, gboolean tree, gboolean visual)
 {
-  if (!epan_auto_reset || (cf->count < epan_auto_reset_count))
+  if (!session_needs_reset(cf))
     return;
 
   fprintf(stderr, "resetting session.\n");
@@ -4548,6 +6367,8 @@ static void reset_epan_mem(capture_file *cf,epan_dissect_t *edt, gboolean tree,
   cf->epan = tshark_epan_new(cf);
   epan_dissect_init(edt, cf->epan, tree, visual);
   cf->count = 0;
+  while (!g_queue_is_empty(&idle_seconds))
+    g_free(g_queue_pop_head(&idle_seconds));
 }
 
 /*
@@ -29,6 +29,9 @@
 typedef struct _export_object_list_gui_t {
     GSList *entries;
     register_eo_t* eo;
+    const gchar *save_in_path;
+    gboolean dir_ready;     /* save_in_path has been checked/created */
+    gboolean streaming;     /* write entries as soon as they are added */
 } export_object_list_gui_t;
 
 static GHashTable* eo_opts = NULL;
@@ -82,19 +85,79 @@ gboolean eo_tap_opt_add(const char *option_string)
     return FALSE;
 }
 
+/* Make sure the destination directory (or its parents) exists. */
+static gboolean
+eo_prepare_dir(export_object_list_gui_t *object_list)
+{
+    if (object_list->dir_ready)
+        return TRUE;
+
+    if (!g_file_test(object_list->save_in_path, G_FILE_TEST_IS_DIR)) {
+        if (g_mkdir_with_parents(object_list->save_in_path, 0755) == -1) {
+            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
+                    object_list->save_in_path, g_strerror(errno));
+            return FALSE;
+        }
+    }
+    object_list->dir_ready = TRUE;
+    return TRUE;
+}
+
+/* Save an entry under a file name that is not yet in use. */
+static void
+eo_write_entry(export_object_list_gui_t *object_list, export_object_entry_t *entry)
+{
+    GString *safe_filename = NULL;
+    gchar *save_as_fullpath = NULL;
+    guint count = 0;
+
+    do {
+        g_free(save_as_fullpath);
+        if (entry->filename) {
+            safe_filename = eo_massage_str(entry->filename,
+                EXPORT_OBJECT_MAXFILELEN, count);
+        } else {
+            char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
+            const char *ext;
+            ext = eo_ct2ext(entry->content_type);
+            g_snprintf(generic_name, sizeof(generic_name),
+                "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
+            safe_filename = eo_massage_str(generic_name,
+                EXPORT_OBJECT_MAXFILELEN, count);
+        }
+        save_as_fullpath = g_build_filename(object_list->save_in_path, safe_filename->str, NULL);
+        g_string_free(safe_filename, TRUE);
+    } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < prefs.gui_max_export_objects);
+    eo_save_entry(save_as_fullpath, entry);
+    g_free(save_as_fullpath);
+}
+
 static void
 object_list_add_entry(void *gui_data, export_object_entry_t *entry)
 {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    object_list->entries = g_slist_append(object_list->entries, entry);
+    if (object_list->streaming) {
+        /* The entry is complete; write it out now instead of holding every
+         * object in memory until the end of the capture. */
+        if (eo_prepare_dir(object_list))
+            eo_write_entry(object_list, entry);
+        eo_free_entry(entry);
+        return;
+    }
+
+    object_list->entries = g_slist_prepend(object_list->entries, entry);
 }
 
 static export_object_entry_t*
 object_list_get_entry(void *gui_data, int row) {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    return (export_object_entry_t *)g_slist_nth_data(object_list->entries, row);
+    /* Entries are prepended, so row 0 is at the end of the list. */
+    gint len = (gint)g_slist_length(object_list->entries);
+    if (row < 0 || row >= len)
+        return NULL;
+    return (export_object_entry_t *)g_slist_nth_data(object_list->entries, len - 1 - row);
 }
 
 /* This is just for writing Exported Objects to a file */
@@ -103,51 +166,21 @@ eo_draw(void *tapdata)
 {
     export_object_list_t *tap_object = (export_object_list_t *)tapdata;
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)tap_object->gui_data;
-    GSList *slist = object_list->entries;
-    export_object_entry_t *entry;
-    gchar* save_in_path = (gchar*)g_hash_table_lookup(eo_opts, proto_get_protocol_filter_name(get_eo_proto_id(object_list->eo)));
-    GString *safe_filename = NULL;
-    gchar *save_as_fullpath = NULL;
-    guint count = 0;
+    GSList *slist;
 
-    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
-        /* If the destination directory (or its parents) do not exist, create them. */
-        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
-            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
-                    save_in_path, g_strerror(errno));
-            return;
-        }
-    }
+    /* Streamed entries have already been written. */
+    if (object_list->entries == NULL || !eo_prepare_dir(object_list))
+        return;
 
-    while (slist) {
-        entry = (export_object_entry_t *)slist->data;
-        do {
-            g_free(save_as_fullpath);
-            if (entry->filename) {
-                safe_filename = eo_massage_str(entry->filename,
-                    EXPORT_OBJECT_MAXFILELEN, count);
-            } else {
-                char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
-                const char *ext;
-                ext = eo_ct2ext(entry->content_type);
-                g_snprintf(generic_name, sizeof(generic_name),
-                    "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
-                safe_filename = eo_massage_str(generic_name,
-                    EXPORT_OBJECT_MAXFILELEN, count);
-            }
-            save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
-            g_string_free(safe_filename, TRUE);
-        } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < prefs.gui_max_export_objects);
-        count = 0;
-        eo_save_entry(save_as_fullpath, entry);
-        g_free(save_as_fullpath);
-        save_as_fullpath = NULL;
-        slist = slist->next;
+    object_list->entries = g_slist_reverse(object_list->entries);
+    for (slist = object_list->entries; slist; slist = slist->next) {
+        eo_write_entry(object_list, (export_object_entry_t *)slist->data);
     }
+    object_list->entries = g_slist_reverse(object_list->entries);
 }
 
 static void
-exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
+exportobject_handler(gpointer key, gpointer value, gpointer user_data _U_)
 {
     GString *error_msg;
     export_object_list_t *tap_data;
@@ -169,6 +202,15 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
     tap_data->gui_data = (void*)object_list;
 
     object_list->eo = eo;
+    object_list->save_in_path = (const gchar*)value;
+    /*
+     * Protocols that assemble an object over several packets keep
+     * intermediate state (and so register a reset callback) and refetch
+     * the entry with get_entry to fill it in; those must stay buffered
+     * until the end. Everything else hands over finished objects that
+     * can be written to disk and freed right away.
+     */
+    object_list->streaming = (get_eo_reset_func(eo) == NULL);
 
     /* Data will be gathered via a tap callback */
     error_msg = register_tap_listener(get_eo_tap_listener_name(eo), tap_data, NULL, 0,
@@ -15,6 +15,7 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -24,6 +25,8 @@
 #include <epan/follow.h>
 #include <epan/stat_tap_ui.h>
 #include <epan/tap.h>
+#include <wsutil/filesystem.h>
+#include <ui/follow_files.h>
 
 void register_tap_listener_follow(void);
 
@@ -53,6 +56,13 @@ typedef struct _cli_follow_info {
 #define STR_ASCII       ",ascii"
 #define STR_EBCDIC      ",ebcdic"
 #define STR_RAW         ",raw"
+#define STR_FILES       ",files"
+
+/* Payload bytes held per stream in "files" mode before writing them out */
+#define FOLLOW_FILES_BUFFERED   (64 * 1024)
+
+static const char       follow_separator[] =
+  "===================================================================\n";
 
 WS_NORETURN static void follow_exit(const char *strp)
 {
@@ -155,9 +165,6 @@ static void follow_print_hex(const char *prefixp, guint32 offset, void *datap, i
 
 static void follow_draw(void *contextp)
 {
-  static const char     separator[] =
-    "===================================================================\n";
-
   follow_info_t *follow_info = (follow_info_t*)contextp;
   cli_follow_info_t* cli_follow_info = (cli_follow_info_t*)follow_info->gui_data;
   gchar             buf[WS_INET6_ADDRSTRLEN];
@@ -169,7 +176,7 @@ static void follow_draw(void *contextp)
   follow_record_t   *follow_record;
   guint             chunk;
 
-  printf("\n%s", separator);
+  printf("\n%s", follow_separator);
   printf("Follow: %s,%s\n", proto_get_protocol_filter_name(get_follow_proto_id(cli_follow_info->follower)), follow_str_type(cli_follow_info));
   printf("Filter: %s\n", follow_info->filter_out_filter);
 
@@ -276,7 +283,64 @@ static void follow_draw(void *contextp)
     }
   }
 
-  printf("%s", separator);
+  printf("%s", follow_separator);
+}
+
+static void follow_print_node(const char *label, const address *addr, guint port, guint bytes)
+{
+  gchar             buf[WS_INET6_ADDRSTRLEN];
+
+  address_to_str_buf(addr, buf, sizeof buf);
+  if (addr->type == AT_IPv6)
+    printf("%s [%s]:%u, %u bytes", label, buf, port, bytes);
+  else
+    printf("%s %s:%u, %u bytes", label, buf, port, bytes);
+}
+
+static void follow_files_draw(void *contextp)
+{
+  follow_multi_t    *multi = (follow_multi_t *)contextp;
+  follow_files_t    *ff = (follow_files_t *)follow_multi_get_user_data(multi);
+  follow_info_t     *follow_info;
+  guint             ii, stream, sub_stream;
+
+  /* Write out what is still buffered before reporting on the files. */
+  follow_multi_flush(multi);
+
+  printf("\n%s", follow_separator);
+  printf("Follow: %s,files\n", ff->proto_name);
+  printf("Directory: %s\n", ff->dir);
+  printf("Streams: %u\n", follow_multi_num_streams(multi));
+  printf("Files: %u\n", ff->files);
+
+  for (ii = 0; ii < follow_multi_num_streams(multi); ii++)
+  {
+    follow_info = follow_multi_get_stream(multi, ii, &stream, &sub_stream);
+    if (ff->sub_streams)
+      printf("Stream %u.%u: ", stream, sub_stream);
+    else
+      printf("Stream %u: ", stream);
+    follow_print_node("Node 0", &follow_info->client_ip, follow_info->client_port, follow_info->bytes_written[FROM_CLIENT]);
+    follow_print_node("; Node 1", &follow_info->server_ip, follow_info->server_port, follow_info->bytes_written[FROM_SERVER]);
+    putchar('\n');
+  }
+
+  if (ff->errors > 0)
+  {
+    printf("Streams not written: %u\n", ff->errors);
+  }
+
+  printf("%s", follow_separator);
+}
+
+static void follow_files_free(void *contextp)
+{
+  follow_multi_t    *multi = (follow_multi_t *)contextp;
+  follow_files_t    *ff = (follow_files_t *)follow_multi_get_user_data(multi);
+
+  follow_multi_free(multi);
+  follow_files_cleanup(ff);
+  g_free(ff);
 }
 
 static gboolean follow_arg_strncmp(const char **opt_argp, const char *strp)
@@ -438,6 +502,59 @@ follow_arg_done(const char *opt_argp)
   }
 }
 
+/*
+ * -z follow,<proto>,files,<directory>[,<filter>]
+ *
+ * Write every stream, or every stream with packets matching the filter,
+ * to per-stream files as the capture is read.
+ */
+static void follow_files(const char *opt_argp, register_follow_t *follower)
+{
+  follow_files_t    *ff;
+  follow_multi_t    *multi;
+  const char        *dir_end;
+  const char        *filter = NULL;
+  char              *dir;
+  GString           *errp;
+
+  if (*opt_argp != ',')
+  {
+    follow_exit("Invalid directory.");
+  }
+  opt_argp++;
+
+  /* The filter, which may contain commas, is everything after the directory. */
+  dir_end = strchr(opt_argp, ',');
+  if (dir_end != NULL)
+  {
+    dir = g_strndup(opt_argp, dir_end - opt_argp);
+    if (dir_end[1] != 0)
+      filter = dir_end + 1;
+  }
+  else
+  {
+    dir = g_strdup(opt_argp);
+  }
+
+  if (*dir == 0 || test_for_directory(dir) != EISDIR)
+  {
+    follow_exit("Invalid directory.");
+  }
+
+  ff = g_new0(follow_files_t, 1);
+  follow_files_init(ff, follower, dir);
+  g_free(dir);
+  multi = follow_multi_new(follower, FOLLOW_FILES_BUFFERED, follow_files_write, ff);
+
+  errp = follow_multi_register_tap_listener(multi, filter, follow_files_draw, follow_files_free);
+  if (errp != NULL)
+  {
+    follow_files_free(multi);
+    g_string_free(errp, TRUE);
+    follow_exit("Error registering tap listener.");
+  }
+}
+
 static void follow_stream(const char *opt_argp, void *userdata)
 {
   follow_info_t *follow_info;
@@ -452,6 +569,12 @@ static void follow_stream(const char *opt_argp, void *userdata)
   opt_argp += strlen(STR_FOLLOW);
   opt_argp += strlen(proto_filter_name);
 
+  if (follow_arg_strncmp(&opt_argp, STR_FILES))
+  {
+    follow_files(opt_argp, follower);
+    return;
+  }
+
   cli_follow_info = g_new0(cli_follow_info_t, 1);
   cli_follow_info->stream_index = -1;
   /* use second parameter only for HTTP2 or QUIC substream */
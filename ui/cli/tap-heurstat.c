@@ -0,0 +1,123 @@
+/* tap-heurstat.c
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/* Print how often each heuristic dissector was tried and how often it matched */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_heurstat(void);
+
+#define TAP_NAME "heur,stats"
+
+static gint
+heurstat_compare_tries(gconstpointer a, gconstpointer b)
+{
+	const heur_dtbl_entry_t *entry_a = (const heur_dtbl_entry_t *)a;
+	const heur_dtbl_entry_t *entry_b = (const heur_dtbl_entry_t *)b;
+
+	if (entry_a->tries != entry_b->tries)
+		return entry_a->tries < entry_b->tries ? 1 : -1;
+	return g_strcmp0(entry_a->short_name, entry_b->short_name);
+}
+
+static void
+heurstat_gather_entry(const gchar *table_name _U_, heur_dtbl_entry_t *entry, gpointer user_data)
+{
+	GSList **entries = (GSList **)user_data;
+
+	if (entry->tries != 0)
+		*entries = g_slist_insert_sorted(*entries, entry, heurstat_compare_tries);
+}
+
+static void
+heurstat_print_list(const char *table_name, struct heur_dissector_list *table _U_, gpointer user_data _U_)
+{
+	GSList *entries = NULL;
+	GSList *item;
+
+	heur_dissector_table_foreach(table_name, heurstat_gather_entry, &entries);
+	for (item = entries; item != NULL; item = g_slist_next(item)) {
+		heur_dtbl_entry_t *entry = (heur_dtbl_entry_t *)item->data;
+
+		printf("%-16s %-32s %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT " %12" G_GUINT64_FORMAT "\n",
+		       table_name, entry->short_name, entry->tries, entry->matches,
+		       entry->tries - entry->matches);
+	}
+	g_slist_free(entries);
+}
+
+static void
+heurstat_draw(void *tapdata _U_)
+{
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Heuristic Dissector Statistics\n");
+	printf("%-16s %-32s %12s %12s %12s\n", "List", "Heuristic", "Tries", "Matches", "Rejections");
+	dissector_all_heur_tables_foreach_table(heurstat_print_list, NULL, (GCompareFunc)g_strcmp0);
+	printf("===================================================================\n");
+}
+
+static void
+heurstat_init(const char *opt_arg, void *userdata _U_)
+{
+	GString *error_string;
+
+	if (strcmp(TAP_NAME, opt_arg) != 0) {
+		cmdarg_err("invalid \"-z " TAP_NAME "\" argument");
+		exit(1);
+	}
+
+	error_string = register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING,
+					     NULL, NULL, heurstat_draw, NULL);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		cmdarg_err("Couldn't register " TAP_NAME " tap: %s",
+			   error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui heurstat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	TAP_NAME,
+	heurstat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_heurstat(void)
+{
+	register_stat_tap_ui(&heurstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
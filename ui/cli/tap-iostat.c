@@ -1371,7 +1371,12 @@ register_io_tap(io_stat_t *io, int i, const char *filter)
     }
     g_free(field);
 
-    error_string = register_tap_listener("frame", &io->items[i], flt, TL_REQUIRES_PROTO_TREE, NULL,
+    /*
+     * The only field we read out of the tree ourselves is the one
+     * being calculated on, so ask for just that one rather than for
+     * the whole tree; plain frame and byte counts need no tree at all.
+     */
+    error_string = register_tap_listener("frame", &io->items[i], flt, TL_REQUIRES_NOTHING, NULL,
                                        iostat_packet, i ? NULL : iostat_draw, NULL);
     if (error_string) {
         g_free(io->items);
@@ -1381,6 +1386,12 @@ register_io_tap(io_stat_t *io, int i, const char *filter)
         g_string_free(error_string, TRUE);
         exit(1);
     }
+    if (hfi) {
+        GArray *wanted_hfids = g_array_sized_new(FALSE, FALSE, (guint)sizeof(int), 1);
+
+        g_array_append_val(wanted_hfids, hfi->id);
+        set_tap_listener_wanted_hfids(&io->items[i], wanted_hfids);
+    }
 }
 
 static void
@@ -1524,6 +1535,181 @@ iostat_init(const char *opt_arg, void *userdata _U_)
     }
 }
 
+/*
+ * "io,rolling": frame and byte counts over a sliding window, printed every
+ * interval while packets are read instead of once at the end. Only
+ * window/interval buckets are kept per column, in a ring; when the window
+ * slides, the expiring bucket is subtracted from the window totals and
+ * reused, so memory use doesn't grow with the capture duration. This is
+ * intended for long running live captures, usually with -q.
+ */
+typedef struct _io_rolling_t io_rolling_t;
+
+typedef struct _io_rolling_col_t {
+    io_rolling_t *parent;
+    const char *filter;
+    guint64 *frames;      /* Per-interval counts, num_buckets entries */
+    guint64 *bytes;
+    guint64 win_frames;   /* Totals over the current window */
+    guint64 win_bytes;
+} io_rolling_col_t;
+
+struct _io_rolling_t {
+    guint64 interval;     /* Emission interval (us) */
+    guint64 window;       /* Window length (us), a multiple of interval */
+    guint num_buckets;    /* window / interval */
+    guint cur;            /* Bucket of the interval being filled */
+    guint64 cur_start;    /* Start of that interval, relative to the first frame (us) */
+    int num_cols;
+    io_rolling_col_t *cols;
+};
+
+static void
+iorolling_print_row(io_rolling_t *rs, guint64 end_time)
+{
+    int i;
+
+    printf("%8" G_GUINT64_FORMAT ".%06u", end_time / 1000000, (unsigned)(end_time % 1000000));
+    for (i=0; i<rs->num_cols; i++) {
+        printf(" | %10" G_GUINT64_FORMAT " %14" G_GUINT64_FORMAT,
+               rs->cols[i].win_frames, rs->cols[i].win_bytes);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/* Close every interval that ends at or before rel_time, printing the
+ * window ending with it and expiring the oldest interval. */
+static void
+iorolling_advance(io_rolling_t *rs, guint64 rel_time)
+{
+    int i;
+
+    while (rel_time >= rs->cur_start + rs->interval) {
+        iorolling_print_row(rs, rs->cur_start + rs->interval);
+
+        rs->cur = (rs->cur + 1) % rs->num_buckets;
+        rs->cur_start += rs->interval;
+        for (i=0; i<rs->num_cols; i++) {
+            io_rolling_col_t *col = &rs->cols[i];
+
+            col->win_frames -= col->frames[rs->cur];
+            col->win_bytes -= col->bytes[rs->cur];
+            col->frames[rs->cur] = 0;
+            col->bytes[rs->cur] = 0;
+        }
+    }
+}
+
+static tap_packet_status
+iorolling_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt _U_, const void *dummy _U_)
+{
+    io_rolling_col_t *col = (io_rolling_col_t *) arg;
+    io_rolling_t *rs = col->parent;
+
+    /* As with io,stat, frames with a negative relative time are counted
+     * in the current interval. */
+    if ((pinfo->rel_ts.secs >= 0) && (pinfo->rel_ts.nsecs >= 0)) {
+        iorolling_advance(rs, ((guint64)pinfo->rel_ts.secs * G_GUINT64_CONSTANT(1000000)) +
+                              ((guint64)((pinfo->rel_ts.nsecs+500)/1000)));
+    }
+
+    col->frames[rs->cur]++;
+    col->bytes[rs->cur] += pinfo->fd->pkt_len;
+    col->win_frames++;
+    col->win_bytes += pinfo->fd->pkt_len;
+
+    return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+iorolling_draw(void *arg)
+{
+    io_rolling_col_t *col = (io_rolling_col_t *) arg;
+    io_rolling_t *rs = col->parent;
+
+    /* The last, possibly partial, interval. */
+    iorolling_print_row(rs, rs->cur_start + rs->interval);
+}
+
+static void
+iorolling_init(const char *opt_arg, void *userdata _U_)
+{
+    gdouble interval_float, window_float;
+    guint32 idx = 0;
+    int i;
+    io_rolling_t *rs;
+    const gchar *filters, *str;
+    gchar **filter_list = NULL;
+    GString *error_string;
+
+    if ((sscanf(opt_arg, "io,rolling,%lf,%lf%n", &interval_float, &window_float, (int *)&idx) != 2) ||
+        (idx < 14) || (opt_arg[idx] != '\0' && opt_arg[idx] != ',')) {
+        fprintf(stderr, "\ntshark: invalid \"-z io,rolling,<interval>,<window>[,<filter>]...\" argument\n");
+        exit(1);
+    }
+
+    if (interval_float * 1000000.0 < 1.0 || window_float < interval_float) {
+        fprintf(stderr,
+            "\ntshark: io,rolling interval must be >=0.000001 seconds and the window at least one interval.\n");
+        exit(10);
+    }
+
+    rs = g_new0(io_rolling_t, 1);
+    rs->interval = (guint64)(interval_float * 1000000.0 + 0.5);
+    /* Round the window up to a whole number of intervals */
+    rs->num_buckets = (guint)(((guint64)(window_float * 1000000.0 + 0.5) + rs->interval - 1) / rs->interval);
+    rs->window = rs->interval * rs->num_buckets;
+
+    filters = opt_arg + idx;
+    if (*filters == ',') {
+        filter_list = g_strsplit(filters + 1, ",", 0);
+        rs->num_cols = g_strv_length(filter_list);
+    }
+    if (rs->num_cols < 1) {
+        rs->num_cols = 1;
+    }
+
+    rs->cols = g_new0(io_rolling_col_t, rs->num_cols);
+
+    printf("Rolling IO Statistics: %" G_GUINT64_FORMAT ".%06u s window, every %" G_GUINT64_FORMAT ".%06u s\n",
+           rs->window / 1000000, (unsigned)(rs->window % 1000000),
+           rs->interval / 1000000, (unsigned)(rs->interval % 1000000));
+
+    for (i=0; i<rs->num_cols; i++) {
+        io_rolling_col_t *col = &rs->cols[i];
+
+        str = filter_list ? g_strstrip(filter_list[i]) : NULL;
+        col->parent = rs;
+        col->filter = (str && *str) ? g_strdup(str) : NULL;
+        col->frames = g_new0(guint64, rs->num_buckets);
+        col->bytes = g_new0(guint64, rs->num_buckets);
+
+        printf("Column #%u: %s (frames bytes)\n", i, col->filter ? col->filter : "");
+
+        error_string = register_tap_listener("frame", col, col->filter, TL_REQUIRES_NOTHING, NULL,
+                                           iorolling_packet, i ? NULL : iorolling_draw, NULL);
+        if (error_string) {
+            fprintf(stderr, "\ntshark: Couldn't register io,rolling tap: %s\n",
+                error_string->str);
+            g_string_free(error_string, TRUE);
+            exit(1);
+        }
+    }
+    fflush(stdout);
+
+    g_strfreev(filter_list);
+}
+
+static stat_tap_ui iorolling_ui = {
+    REGISTER_STAT_GROUP_GENERIC,
+    NULL,
+    "io,rolling",
+    iorolling_init,
+    0,
+    NULL
+};
+
 static stat_tap_ui iostat_ui = {
     REGISTER_STAT_GROUP_GENERIC,
     NULL,
@@ -1537,6 +1723,7 @@ void
 register_tap_listener_iostat(void)
 {
     register_stat_tap_ui(&iostat_ui, NULL);
+    register_stat_tap_ui(&iorolling_ui, NULL);
 }
 
 /*
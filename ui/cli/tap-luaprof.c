@@ -0,0 +1,107 @@
+/* tap-luaprof.c
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/* Print how much time was spent in each Lua dissector and listener callback */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#ifdef HAVE_LUA
+#include <epan/wslua/init_wslua.h>
+#endif
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_luaprof(void);
+
+#define TAP_NAME "prof,lua"
+
+#ifdef HAVE_LUA
+static void
+luaprof_print_entry(const char *kind, const char *name, guint64 calls,
+		    guint64 time_us, guint64 heap_growth_kb, void *user_data _U_)
+{
+	printf("%-16s %-32s %12" G_GUINT64_FORMAT " %14.3f %12.3f %14" G_GUINT64_FORMAT "\n",
+	       kind, name, calls, time_us / 1000.0,
+	       calls ? (double)time_us / calls : 0.0, heap_growth_kb);
+}
+
+static void
+luaprof_draw(void *tapdata _U_)
+{
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Lua Callback Statistics\n");
+	printf("%-16s %-32s %12s %14s %12s %14s\n", "Callback", "Name", "Calls",
+	       "Total (ms)", "Avg (us)", "Heap gain (KB)");
+	wslua_profile_foreach(luaprof_print_entry, NULL);
+	printf("===================================================================\n");
+}
+#endif
+
+static void
+luaprof_init(const char *opt_arg, void *userdata _U_)
+{
+#ifdef HAVE_LUA
+	GString *error_string;
+
+	if (strcmp(TAP_NAME, opt_arg) != 0) {
+		cmdarg_err("invalid \"-z " TAP_NAME "\" argument");
+		exit(1);
+	}
+
+	error_string = register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING,
+					     NULL, NULL, luaprof_draw, NULL);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		cmdarg_err("Couldn't register " TAP_NAME " tap: %s",
+			   error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+	wslua_profile_enable(TRUE);
+#else
+	cmdarg_err("\"-z %s\" requires Lua support", opt_arg);
+	exit(1);
+#endif
+}
+
+static stat_tap_ui luaprof_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	TAP_NAME,
+	luaprof_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_luaprof(void)
+{
+	register_stat_tap_ui(&luaprof_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
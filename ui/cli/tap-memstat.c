@@ -0,0 +1,151 @@
+/* tap-memstat.c
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/* Print how much memory each wmem scope, and each protocol within it, allocated */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <ui/cmdarg_err.h>
+
+void register_tap_listener_memstat(void);
+
+#define TAP_NAME "mem,tree"
+
+static gint
+memstat_compare_total(gconstpointer a, gconstpointer b)
+{
+	const wmem_stats_t *stats_a = (const wmem_stats_t *)a;
+	const wmem_stats_t *stats_b = (const wmem_stats_t *)b;
+
+	if (stats_a->total_bytes != stats_b->total_bytes)
+		return stats_a->total_bytes < stats_b->total_bytes ? 1 : -1;
+	return g_strcmp0(stats_a->tag, stats_b->tag);
+}
+
+static void
+memstat_gather_tag(const wmem_stats_t *stats, void *user_data)
+{
+	GSList **tags = (GSList **)user_data;
+
+	*tags = g_slist_insert_sorted(*tags, (gpointer)stats, memstat_compare_total);
+}
+
+static void
+memstat_print_row(const char *scope, const char *tag, const wmem_stats_t *stats)
+{
+	printf("%-8s %-24s %12" G_GUINT64_FORMAT " %14" G_GUINT64_FORMAT " %14" G_GUINT64_FORMAT " %14" G_GUINT64_FORMAT "\n",
+	       scope, tag, stats->allocs, stats->bytes, stats->peak_bytes, stats->total_bytes);
+}
+
+static void
+memstat_print_scope(const char *scope, wmem_allocator_t *allocator)
+{
+	const wmem_stats_t *totals;
+	GSList *tags = NULL;
+	GSList *item;
+
+	totals = wmem_stats_get(allocator);
+	if (totals == NULL)
+		return;
+
+	memstat_print_row(scope, "Total", totals);
+	wmem_stats_foreach_tag(allocator, memstat_gather_tag, &tags);
+	for (item = tags; item != NULL; item = g_slist_next(item)) {
+		const wmem_stats_t *stats = (const wmem_stats_t *)item->data;
+
+		memstat_print_row("", stats->tag ? stats->tag : "<none>", stats);
+	}
+	g_slist_free(tags);
+}
+
+static void
+memstat_draw(void *tapdata _U_)
+{
+	printf("\n");
+	printf("===================================================================================================\n");
+	printf("Memory Allocation Statistics\n");
+	printf("%-8s %-24s %12s %14s %14s %14s\n", "Scope", "Protocol", "Allocations", "Bytes", "Peak Bytes", "Total Bytes");
+	memstat_print_scope("epan", wmem_epan_scope());
+	memstat_print_scope("file", wmem_file_scope());
+	memstat_print_scope("packet", wmem_packet_scope());
+	printf("===================================================================================================\n");
+}
+
+static void
+memstat_init(const char *opt_arg, void *userdata _U_)
+{
+	GString *error_string;
+	guint sample_interval = 1;
+
+	if (strcmp(TAP_NAME, opt_arg) == 0) {
+		/* Keep the interval of WIRESHARK_WMEM_STATS, if it was set */
+		if (wmem_stats_enabled())
+			sample_interval = 0;
+	} else if (strncmp(TAP_NAME ",", opt_arg, strlen(TAP_NAME ",")) == 0) {
+		char *end;
+
+		sample_interval = (guint)strtoul(opt_arg + strlen(TAP_NAME ","), &end, 10);
+		if (*end != '\0' || sample_interval == 0) {
+			cmdarg_err("invalid \"-z " TAP_NAME ",<interval>\" argument");
+			exit(1);
+		}
+	} else {
+		cmdarg_err("invalid \"-z " TAP_NAME "[,<interval>]\" argument");
+		exit(1);
+	}
+
+	if (sample_interval)
+		wmem_stats_enable(sample_interval);
+
+	error_string = register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING,
+					     NULL, NULL, memstat_draw, NULL);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		cmdarg_err("Couldn't register " TAP_NAME " tap: %s",
+			   error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui memstat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	TAP_NAME,
+	memstat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_memstat(void)
+{
+	register_stat_tap_ui(&memstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
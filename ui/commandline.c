@@ -34,6 +34,7 @@
 #include <ui/clopts_common.h>
 #include <ui/cmdarg_err.h>
 #include <wsutil/filesystem.h>
+#include <wsutil/startup_profile.h>
 
 #include <epan/ex-opt.h>
 #include <epan/packet.h>
@@ -107,6 +108,7 @@ commandline_print_usage(gboolean for_help_option) {
     fprintf(output, "  -L, --list-data-link-types\n");
     fprintf(output, "                           print list of link-layer types of iface and exit\n");
     fprintf(output, "  --list-time-stamp-types  print list of timestamp types for iface and exit\n");
+    fprintf(output, "  --update-interval        interval between updates with new packets (def: %dms)\n", DEFAULT_UPDATE_INTERVAL);
     fprintf(output, "\n");
     fprintf(output, "Capture stop conditions:\n");
     fprintf(output, "  -c <packet count>        stop after n packets (def: infinite)\n");
@@ -186,6 +188,8 @@ commandline_print_usage(gboolean for_help_option) {
     fprintf(output, "  --display <X display>    X display to use\n");
 #endif
     fprintf(output, "  --fullscreen             start Wireshark in full screen\n");
+    fprintf(output, "  --startup-profile <file> write a breakdown of the startup time to \"file\"\n");
+    fprintf(output, "                           as JSON\n");
 
 #ifdef _WIN32
     destroy_console();
@@ -193,6 +197,7 @@ commandline_print_usage(gboolean for_help_option) {
 }
 
 #define LONGOPT_FULL_SCREEN     LONGOPT_BASE_GUI+1
+#define LONGOPT_STARTUP_PROFILE LONGOPT_BASE_GUI+2
 
 #define OPTSTRING OPTSTRING_CAPTURE_COMMON OPTSTRING_DISSECT_COMMON "C:g:HhjJ:klm:o:P:r:R:Svw:X:Y:z:"
 static const struct option long_options[] = {
@@ -202,6 +207,7 @@ static const struct option long_options[] = {
         {"display-filter", required_argument, NULL, 'Y' },
         {"version", no_argument, NULL, 'v'},
         {"fullscreen", no_argument, NULL, LONGOPT_FULL_SCREEN },
+        {"startup-profile", required_argument, NULL, LONGOPT_STARTUP_PROFILE },
         LONGOPT_CAPTURE_COMMON
         LONGOPT_DISSECT_COMMON
         {0, 0, 0, 0 }
@@ -329,6 +335,9 @@ void commandline_early_options(int argc, char *argv[])
                  */
                 ex_opt_add(optarg);
                 break;
+            case LONGOPT_STARTUP_PROFILE:
+                startup_profile_enable("wireshark", optarg);
+                break;
             case '?':        /* Ignore errors - the "real" scan will catch them. */
                 break;
         }
@@ -418,6 +427,7 @@ void commandline_other_options(int argc, char *argv[], gboolean opt_reset)
             case 'p':        /* Don't capture in promiscuous mode */
             case 'i':        /* Use interface x */
             case LONGOPT_SET_TSTAMP_TYPE: /* Set capture timestamp type */
+            case LONGOPT_UPDATE_INTERVAL: /* Capture update interval */
 #ifdef HAVE_PCAP_CREATE
             case 'I':        /* Capture in monitor mode, if available */
 #endif
@@ -577,6 +587,9 @@ void commandline_other_options(int argc, char *argv[], gboolean opt_reset)
             case LONGOPT_FULL_SCREEN:
                 global_commandline_info.full_screen = TRUE;
                 break;
+            case LONGOPT_STARTUP_PROFILE:
+                /* Already processed; just ignore it now. */
+                break;
             default:
             case '?':        /* Bad flag - print usage message */
                 arg_error = TRUE;
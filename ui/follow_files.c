@@ -0,0 +1,135 @@
+/* follow_files.c
+ * Write followed streams to one file per stream and direction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#include <glib.h>
+
+#include <epan/proto.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/report_message.h>
+
+#include "follow_files.h"
+
+/* Per-stream state, kept in follow_info->gui_data. */
+#define FOLLOW_FILE_CLIENT  0x1     /* client file created */
+#define FOLLOW_FILE_SERVER  0x2     /* server file created */
+#define FOLLOW_FILE_FAILED  0x4     /* a write failed, stop writing */
+
+void
+follow_files_init(follow_files_t *ff, register_follow_t *follower, const char *dir)
+{
+    ff->dir = g_strdup(dir);
+    ff->proto_name = proto_get_protocol_filter_name(get_follow_proto_id(follower));
+    ff->sub_streams = g_str_equal(ff->proto_name, "http2") || g_str_equal(ff->proto_name, "quic");
+    ff->files = 0;
+    ff->errors = 0;
+}
+
+char *
+follow_files_path(const follow_files_t *ff, guint stream, guint sub_stream, gboolean is_server)
+{
+    char *name, *path;
+
+    if (ff->sub_streams)
+        name = g_strdup_printf("%s-%u.%u-%s.bin", ff->proto_name, stream, sub_stream, is_server ? "server" : "client");
+    else
+        name = g_strdup_printf("%s-%u-%s.bin", ff->proto_name, stream, is_server ? "server" : "client");
+    path = g_build_filename(ff->dir, name, NULL);
+    g_free(name);
+    return path;
+}
+
+gboolean
+follow_files_written(const follow_info_t *follow_info, gboolean is_server)
+{
+    guint state = GPOINTER_TO_UINT(follow_info->gui_data);
+
+    return (state & (is_server ? FOLLOW_FILE_SERVER : FOLLOW_FILE_CLIENT)) != 0;
+}
+
+void
+follow_files_write(guint stream, guint sub_stream, follow_info_t *follow_info, GList *records, void *user_data)
+{
+    follow_files_t *ff = (follow_files_t *)user_data;
+    guint state = GPOINTER_TO_UINT(follow_info->gui_data);
+    FILE *fp[2] = { NULL, NULL };
+    char *path[2] = { NULL, NULL };
+    GList *cur;
+    int side;
+
+    /* Nothing is allocated per stream, so there's nothing to free. */
+    if (records == NULL || (state & FOLLOW_FILE_FAILED))
+        return;
+
+    for (cur = records; cur; cur = g_list_next(cur)) {
+        follow_record_t *follow_record = (follow_record_t *)cur->data;
+        guint created;
+
+        side = follow_record->is_server ? 1 : 0;
+        created = side ? FOLLOW_FILE_SERVER : FOLLOW_FILE_CLIENT;
+
+        if (fp[side] == NULL) {
+            path[side] = follow_files_path(ff, stream, sub_stream, side);
+            fp[side] = ws_fopen(path[side], (state & created) ? "ab" : "wb");
+            if (fp[side] == NULL) {
+                report_open_failure(path[side], errno, TRUE);
+                state |= FOLLOW_FILE_FAILED;
+                break;
+            }
+            if (!(state & created)) {
+                state |= created;
+                ff->files++;
+            }
+        }
+
+        if (fwrite(follow_record->data->data, 1, follow_record->data->len, fp[side]) != follow_record->data->len) {
+            report_write_failure(path[side], errno);
+            state |= FOLLOW_FILE_FAILED;
+            break;
+        }
+    }
+
+    for (side = 0; side < 2; side++) {
+        if (fp[side] != NULL && fclose(fp[side]) == EOF && !(state & FOLLOW_FILE_FAILED)) {
+            report_write_failure(path[side], errno);
+            state |= FOLLOW_FILE_FAILED;
+        }
+        g_free(path[side]);
+    }
+
+    if (state & FOLLOW_FILE_FAILED)
+        ff->errors++;
+    follow_info->gui_data = GUINT_TO_POINTER(state);
+}
+
+void
+follow_files_cleanup(follow_files_t *ff)
+{
+    g_free(ff->dir);
+    ff->dir = NULL;
+}
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
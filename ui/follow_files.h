@@ -0,0 +1,67 @@
+/* follow_files.h
+ * Write followed streams to one file per stream and direction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FOLLOW_FILES_H__
+#define __FOLLOW_FILES_H__
+
+#include <epan/follow.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A write function for follow_multi_t that appends the payload sent by
+ * each side of a stream to its own file in a directory, named
+ * "<proto>-<stream>[.<sub-stream>]-<client|server>.bin". Used by TShark's
+ * "-z follow,<proto>,files,..." and sharkd's "followall" request.
+ *
+ * Files are opened only while payload is written to them, so any number
+ * of streams can be followed at once.
+ */
+typedef struct {
+    char       *dir;
+    const char *proto_name;
+    gboolean    sub_streams;   /* include the sub-stream in file names */
+    guint       files;         /* files created */
+    guint       errors;        /* streams that couldn't be written */
+} follow_files_t;
+
+void follow_files_init(follow_files_t *ff, register_follow_t *follower, const char *dir);
+
+/** The file the payload sent by one side of a stream goes to. g_free() it. */
+char *follow_files_path(const follow_files_t *ff, guint stream, guint sub_stream, gboolean is_server);
+
+/** TRUE if a file was created for that side of the stream */
+gboolean follow_files_written(const follow_info_t *follow_info, gboolean is_server);
+
+/** A follow_multi_write_func; "user_data" is the follow_files_t. */
+void follow_files_write(guint stream, guint sub_stream, follow_info_t *follow_info, GList *records, void *user_data);
+
+void follow_files_cleanup(follow_files_t *ff);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FOLLOW_FILES_H__ */
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -125,6 +125,88 @@ GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_u
     return err_str;
 }
 
+void merge_io_graph_item(io_graph_item_t *dst, const io_graph_item_t *src, int hf_index, int item_unit)
+{
+    gboolean new_max = FALSE;
+    gboolean new_min = FALSE;
+
+    if (dst->first_frame_in_invl == 0) {
+        dst->first_frame_in_invl = src->first_frame_in_invl;
+    }
+    if (src->last_frame_in_invl != 0) {
+        dst->last_frame_in_invl = src->last_frame_in_invl;
+    }
+
+    /* If dst->fields == 0 its min/max values aren't set yet. */
+    if (src->fields && hf_index >= 0) {
+        switch (proto_registrar_get_ftype(hf_index)) {
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+            new_max = dst->fields == 0 || (guint64)src->int_max > (guint64)dst->int_max;
+            new_min = dst->fields == 0 || (guint64)src->int_min < (guint64)dst->int_min;
+            break;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+            new_max = dst->fields == 0 || src->int_max > dst->int_max;
+            new_min = dst->fields == 0 || src->int_min < dst->int_min;
+            break;
+        case FT_FLOAT:
+            new_max = dst->fields == 0 || src->float_max > dst->float_max;
+            new_min = dst->fields == 0 || src->float_min < dst->float_min;
+            break;
+        case FT_DOUBLE:
+            new_max = dst->fields == 0 || src->double_max > dst->double_max;
+            new_min = dst->fields == 0 || src->double_min < dst->double_min;
+            break;
+        case FT_RELATIVE_TIME:
+            new_max = dst->fields == 0 || nstime_cmp(&src->time_max, &dst->time_max) > 0;
+            new_min = dst->fields == 0 || nstime_cmp(&src->time_min, &dst->time_min) < 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (new_max) {
+        dst->int_max = src->int_max;
+        dst->float_max = src->float_max;
+        dst->double_max = src->double_max;
+        dst->time_max = src->time_max;
+        if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+            dst->extreme_frame_in_invl = src->extreme_frame_in_invl;
+        }
+    }
+    if (new_min) {
+        dst->int_min = src->int_min;
+        dst->float_min = src->float_min;
+        dst->double_min = src->double_min;
+        dst->time_min = src->time_min;
+        if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+            dst->extreme_frame_in_invl = src->extreme_frame_in_invl;
+        }
+    }
+
+    dst->frames += src->frames;
+    dst->bytes += src->bytes;
+    dst->fields += src->fields;
+    dst->int_tot += src->int_tot;
+    dst->float_tot += src->float_tot;
+    dst->double_tot += src->double_tot;
+    nstime_add(&dst->time_tot, &src->time_tot);
+}
+
 // Adapted from get_it_value in gtk/io_stat.c.
 double get_io_graph_item(const io_graph_item_t *items_, io_graph_item_unit_t val_units_, int idx, int hf_index_, const capture_file *cap_file, int interval_, int cur_idx_)
 {
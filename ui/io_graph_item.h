@@ -114,6 +114,18 @@ int get_io_graph_index(packet_info *pinfo, int interval);
  */
 GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_unit_t item_unit);
 
+/** Add an io_graph_item_t to another one.
+ *
+ * Used to compute the items of a coarser interval from those of a finer one.
+ * Items must be merged in time order.
+ *
+ * @param dst [in,out] The item to add to.
+ * @param src [in] The item to add.
+ * @param hf_index [in] Header field index for advanced statistics.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ */
+void merge_io_graph_item(io_graph_item_t *dst, const io_graph_item_t *src, int hf_index, int item_unit);
+
 /** Get the value at the given interval (idx) for the current value unit.
  *
  * @param items [in] Array containing the item to get.
@@ -10,8 +10,6 @@
 
 #include "config.h"
 
-#include <string.h>
-
 #include "file.h"
 #include "frame_tvbuff.h"
 #include "ui/proto_hier_stats.h"
@@ -77,48 +75,53 @@ find_stat_node(GNode *parent_stat_node, header_field_info *needle_hfinfo)
 }
 
 
+/* Walk the top-level items of the tree, each one being a layer nested
+ * in the previous one. */
     static void
-process_node(proto_node *ptree_node, GNode *parent_stat_node, ph_stats_t *ps)
+process_node(proto_node *ptree_node, GNode *parent_stat_node, ph_stats_t *ps _U_)
 {
     field_info		*finfo;
     ph_stats_node_t	*stats;
     proto_node		*proto_sibling_node;
     GNode		*stat_node;
 
-    finfo = PNODE_FINFO(ptree_node);
-    /* We don't fake protocol nodes we expect them to have a field_info.
-     * Dissection with faked proto tree? */
-    g_assert(finfo);
-
-    /* If the field info isn't related to a protocol but to a field,
-     * don't count them, as they don't belong to any protocol.
-     * (happens e.g. for toplevel tree item of desegmentation "[Reassembled TCP Segments]") */
-    if (finfo->hfinfo->parent != -1) {
-        /* Skip this element, use parent status node */
-        stat_node = parent_stat_node;
-        stats = STAT_NODE_STATS(stat_node);
-    } else {
-        stat_node = find_stat_node(parent_stat_node, finfo->hfinfo);
-
-        stats = STAT_NODE_STATS(stat_node);
-        stats->num_pkts_total++;
-        stats->num_bytes_total += finfo->length;
-    }
-
-    proto_sibling_node = ptree_node->next;
+    while (ptree_node) {
+        finfo = PNODE_FINFO(ptree_node);
+        /* We don't fake protocol nodes we expect them to have a field_info.
+         * Dissection with faked proto tree? */
+        g_assert(finfo);
+
+        /* If the field info isn't related to a protocol but to a field,
+         * don't count them, as they don't belong to any protocol.
+         * (happens e.g. for toplevel tree item of desegmentation "[Reassembled TCP Segments]") */
+        if (finfo->hfinfo->parent != -1) {
+            /* Skip this element, use parent status node */
+            stat_node = parent_stat_node;
+            stats = STAT_NODE_STATS(stat_node);
+        } else {
+            stat_node = find_stat_node(parent_stat_node, finfo->hfinfo);
+
+            stats = STAT_NODE_STATS(stat_node);
+            stats->num_pkts_total++;
+            stats->num_bytes_total += finfo->length;
+        }
 
-    if (proto_sibling_node) {
-        /* If the name does not exist for this proto_sibling_node, then it is
-         * not a normal protocol in the top-level tree.  It was instead
-         * added as a normal tree such as IPv6's Hop-by-hop Option Header and
-         * should be skipped when creating the protocol hierarchy display. */
-        if(strlen(PNODE_FINFO(proto_sibling_node)->hfinfo->name) == 0 && ptree_node->next)
-            proto_sibling_node = proto_sibling_node->next;
+        proto_sibling_node = ptree_node->next;
+
+        if (proto_sibling_node) {
+            /* If the name does not exist for this proto_sibling_node, then it is
+             * not a normal protocol in the top-level tree.  It was instead
+             * added as a normal tree such as IPv6's Hop-by-hop Option Header and
+             * should be skipped when creating the protocol hierarchy display. */
+            if(PNODE_FINFO(proto_sibling_node)->hfinfo->name[0] == '\0' && ptree_node->next)
+                proto_sibling_node = proto_sibling_node->next;
+        } else {
+            stats->num_pkts_last++;
+            stats->num_bytes_last += finfo->length;
+        }
 
-        process_node(proto_sibling_node, stat_node, ps);
-    } else {
-        stats->num_pkts_last++;
-        stats->num_bytes_last += finfo->length;
+        ptree_node = proto_sibling_node;
+        parent_stat_node = stat_node;
     }
 }
 
@@ -148,9 +151,8 @@ process_tree(proto_tree *protocol_tree, ph_stats_t* ps)
 
     static gboolean
 process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
-               wtap_rec *rec, Buffer *buf, ph_stats_t* ps)
+               wtap_rec *rec, Buffer *buf, epan_dissect_t *edt, ph_stats_t* ps)
 {
-    epan_dissect_t	edt;
     double		cur_time;
 
     /* Load the record from the capture file */
@@ -158,15 +160,12 @@ process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
         return FALSE;	/* failure */
 
     /* Dissect the record   tree  not visible */
-    epan_dissect_init(&edt, cf->epan, TRUE, FALSE);
-    /* Don't fake protocols. We need them for the protocol hierarchy */
-    epan_dissect_fake_protocols(&edt, FALSE);
-    epan_dissect_run(&edt, cf->cd_t, rec,
+    epan_dissect_run(edt, cf->cd_t, rec,
                      frame_tvbuff_new_buffer(&cf->provider, frame, buf),
                      frame, cinfo);
 
     /* Get stats from this protocol tree */
-    process_tree(edt.tree, ps);
+    process_tree(edt->tree, ps);
 
     if (frame->has_ts) {
         /* Update times */
@@ -177,8 +176,8 @@ process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
             ps->last_time = cur_time;
     }
 
-    /* Free our memory. */
-    epan_dissect_cleanup(&edt);
+    /* Free our memory, but keep the tree for the next record. */
+    epan_dissect_reset(edt);
 
     return TRUE;	/* success */
 }
@@ -195,6 +194,7 @@ ph_stats_new(capture_file *cf)
     int		count;
     wtap_rec	rec;
     Buffer	buf;
+    epan_dissect_t	edt;
     float	progbar_val;
     gchar	status_str[100];
     int		progbar_nextstep;
@@ -230,6 +230,12 @@ ph_stats_new(capture_file *cf)
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
 
+    /* Fields are faked as the tree isn't visible, only protocol items
+     * are created. Don't fake protocols, we need them for the protocol
+     * hierarchy. */
+    epan_dissect_init(&edt, cf->epan, TRUE, FALSE);
+    epan_dissect_fake_protocols(&edt, FALSE);
+
     for (framenum = 1; framenum <= cf->count; framenum++) {
         frame = frame_data_sequence_find(cf->provider.frames, framenum);
 
@@ -290,7 +296,7 @@ ph_stats_new(capture_file *cf)
             }
 
             /* we don't care about colinfo */
-            if (!process_record(cf, frame, NULL, &rec, &buf, ps)) {
+            if (!process_record(cf, frame, NULL, &rec, &buf, &edt, ps)) {
                 /*
                  * Give up, and set "stop_flag" so we
                  * just abort rather than popping up
@@ -307,6 +313,7 @@ ph_stats_new(capture_file *cf)
         count++;
     }
 
+    epan_dissect_cleanup(&edt);
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
 
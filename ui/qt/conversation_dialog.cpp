@@ -783,23 +783,25 @@ void ConversationTreeWidget::updateItems() {
     }
     addTopLevelItems(new_items);
 
-    for (int i = 0; i < topLevelItemCount(); i++) {
-        ConversationTreeWidgetItem *ctwi = dynamic_cast<ConversationTreeWidgetItem *>(topLevelItem(i));
-
-        if (ctwi) {
-            double item_rel_start = nstime_to_sec(&(ctwi->convItem()->start_time));
-            if (item_rel_start < min_rel_start_time_) {
-                min_rel_start_time_ = item_rel_start;
-            }
+    // Stop times grow as packets are tapped, so look at every conversation.
+    // The array is a lot quicker to walk than the items.
+    for (guint i = 0; i < hash_.conv_array->len; i++) {
+        conv_item_t *conv_item = &g_array_index(hash_.conv_array, conv_item_t, i);
+
+        double item_rel_start = nstime_to_sec(&conv_item->start_time);
+        if (item_rel_start < min_rel_start_time_) {
+            min_rel_start_time_ = item_rel_start;
+        }
 
-            double item_rel_stop = nstime_to_sec(&(ctwi->convItem()->stop_time));
-            if (item_rel_stop > max_rel_stop_time_) {
-                max_rel_stop_time_ = item_rel_stop;
-            }
+        double item_rel_stop = nstime_to_sec(&conv_item->stop_time);
+        if (item_rel_stop > max_rel_stop_time_) {
+            max_rel_stop_time_ = item_rel_stop;
         }
     }
 
-    setSortingEnabled(true);
+    if (!retapping_) {
+        setSortingEnabled(true);
+    }
 
     if (resize) {
         for (int col = 0; col < columnCount(); col++) {
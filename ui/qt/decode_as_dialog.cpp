@@ -199,8 +199,9 @@ void DecodeAsDialog::on_clearToolButton_clicked()
 
 void DecodeAsDialog::applyChanges()
 {
-    model_->applyChanges();
-    wsApp->queueAppSignal(WiresharkApplication::PacketDissectionChanged);
+    if (model_->applyChanges()) {
+        wsApp->queueAppSignal(WiresharkApplication::PacketDissectionChanged);
+    }
 }
 
 void DecodeAsDialog::on_buttonBox_clicked(QAbstractButton *button)
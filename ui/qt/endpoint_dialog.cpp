@@ -641,7 +641,9 @@ void EndpointTreeWidget::updateItems()
 #endif
     }
     addTopLevelItems(new_items);
-    setSortingEnabled(true);
+    if (!retapping_) {
+        setSortingEnabled(true);
+    }
 
     if (resize) {
         for (int col = 0; col < columnCount(); col++) {
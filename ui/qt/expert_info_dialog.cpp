@@ -38,7 +38,8 @@ ExpertInfoDialog::ExpertInfoDialog(QWidget &parent, CaptureFile &capture_file) :
     ui(new Ui::ExpertInfoDialog),
     expert_info_model_(new ExpertInfoModel(capture_file)),
     proxyModel_(new ExpertInfoProxyModel(this)),
-    display_filter_(QString())
+    display_filter_(QString()),
+    all_frames_tapped_(false)
 {
     ui->setupUi(this);
 
@@ -132,6 +133,19 @@ ExpertInfoTreeView* ExpertInfoDialog::getExpertInfoView()
     return ui->expertInfoTreeView;
 }
 
+// True if display_filter_ is the filter that was last applied to the packet
+// list, in which case each frame's passed_dfilter flag tells us whether it
+// matches and we can limit the list without running a filtered retap.
+bool ExpertInfoDialog::displayFilterIsApplied()
+{
+    capture_file *cf = cap_file_.capFile();
+
+    if (!cf || !cf->dfilter || display_filter_.isEmpty())
+        return false;
+
+    return display_filter_ == QString::fromUtf8(cf->dfilter);
+}
+
 void ExpertInfoDialog::retapPackets()
 {
     if (file_closed_) return;
@@ -139,9 +153,17 @@ void ExpertInfoDialog::retapPackets()
     clearAllData();
     removeTapListeners();
 
+    bool limit = ui->limitCheckBox->isChecked();
+    bool use_passed = limit && displayFilterIsApplied();
+
+    // Collect every expert item when we can filter afterward so that
+    // toggling "Limit to Display Filter" doesn't require another pass.
+    all_frames_tapped_ = !limit || use_passed;
+    proxyModel_->setPassedFramesFilter(use_passed ? cap_file_.capFile() : NULL);
+
     if (!registerTapListener("expert",
                              expert_info_model_,
-                             ui->limitCheckBox->isChecked() ? display_filter_.toUtf8().constData(): NULL,
+                             all_frames_tapped_ ? NULL : display_filter_.toUtf8().constData(),
                              TL_REQUIRES_COLUMNS,
                              ExpertInfoModel::tapReset,
                              ExpertInfoModel::tapPacket,
@@ -169,6 +191,17 @@ void ExpertInfoDialog::captureEvent(CaptureEvent e)
             break;
         }
     }
+    else if (e.captureContext() == CaptureEvent::Rescan && e.eventType() == CaptureEvent::Finished)
+    {
+        // A new display filter was applied, which changes passed_dfilter.
+        if (ui->limitCheckBox->isChecked() && all_frames_tapped_) {
+            if (displayFilterIsApplied()) {
+                proxyModel_->setPassedFramesFilter(cap_file_.capFile());
+            } else {
+                retapPackets();
+            }
+        }
+    }
 }
 
 void ExpertInfoDialog::updateWidgets()
@@ -303,8 +336,14 @@ void ExpertInfoDialog::expandTree()
     ui->expertInfoTreeView->expandAll();
 }
 
-void ExpertInfoDialog::on_limitCheckBox_toggled(bool)
+void ExpertInfoDialog::on_limitCheckBox_toggled(bool checked)
 {
+    if (all_frames_tapped_ && (!checked || displayFilterIsApplied())) {
+        proxyModel_->setPassedFramesFilter(checked ? cap_file_.capFile() : NULL);
+        updateWidgets();
+        return;
+    }
+
     retapPackets();
 }
 
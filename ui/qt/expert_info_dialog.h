@@ -51,6 +51,9 @@ private:
     QMenu ctx_menu_;
 
     QString display_filter_;
+    bool all_frames_tapped_;
+
+    bool displayFilterIsApplied();
 
 private slots:
     void retapPackets();
@@ -70,6 +70,11 @@ FollowStreamDialog::FollowStreamDialog(QWidget &parent, CaptureFile &cf, follow_
     follower_(NULL),
     show_type_(SHOW_ASCII),
     truncated_(false),
+    next_record_(NULL),
+    global_client_pos_(0),
+    global_server_pos_(0),
+    reading_(false),
+    save_out_(NULL),
     client_buffer_count_(0),
     server_buffer_count_(0),
     client_packet_count_(0),
@@ -152,6 +157,8 @@ FollowStreamDialog::FollowStreamDialog(QWidget &parent, CaptureFile &cf, follow_
             this, SLOT(fillHintLabel(int)));
     connect(ui->teStreamContent, SIGNAL(mouseClickedOnTextCursorPosition(int)),
             this, SLOT(goToPacketForTextPos(int)));
+    connect(ui->teStreamContent->verticalScrollBar(), SIGNAL(valueChanged(int)),
+            this, SLOT(readAhead()));
 
     fillHintLabel(-1);
 }
@@ -183,8 +190,10 @@ void FollowStreamDialog::printStream()
 #ifndef QT_NO_PRINTER
     QPrinter printer(QPrinter::HighResolution);
     QPrintDialog dialog(&printer, this);
-    if (dialog.exec() == QDialog::Accepted)
+    if (dialog.exec() == QDialog::Accepted) {
+        readMoreStream(-1);
         ui->teStreamContent->print(&printer);
+    }
 #endif
 }
 
@@ -274,11 +283,16 @@ void FollowStreamDialog::findText(bool go_back)
     if (ui->leFind->text().isEmpty()) return;
 
     bool found;
-    if (use_regex_find_) {
-        QRegExp regex(ui->leFind->text());
-        found = ui->teStreamContent->find(regex);
-    } else {
-        found = ui->teStreamContent->find(ui->leFind->text());
+    forever {
+        if (use_regex_find_) {
+            QRegExp regex(ui->leFind->text());
+            found = ui->teStreamContent->find(regex);
+        } else {
+            found = ui->teStreamContent->find(ui->leFind->text());
+        }
+        // Look in the rest of the stream a window at a time.
+        if (found || !next_record_ || truncated_ || dialogClosed()) break;
+        readMoreStream(render_window_);
     }
 
     if (found) {
@@ -302,16 +316,45 @@ void FollowStreamDialog::saveAs()
         return;
     }
 
-    // Unconditionally save data as UTF-8 (even if data is decoded otherwise).
-    QByteArray bytes = ui->teStreamContent->toPlainText().toUtf8();
-    if (show_type_ == SHOW_RAW) {
-        // The "Raw" format is currently displayed as hex data and needs to be
-        // converted to binary data.
-        bytes = QByteArray::fromHex(bytes);
+    // Save the whole stream rather than what we've rendered, starting over
+    // so that the C array and YAML numbering matches.
+    GList *next_record = next_record_;
+    guint32 global_client_pos = global_client_pos_;
+    guint32 global_server_pos = global_server_pos_;
+    int client_buffer_count = client_buffer_count_;
+    int server_buffer_count = server_buffer_count_;
+    int client_packet_count = client_packet_count_;
+    int server_packet_count = server_packet_count_;
+    guint32 last_packet = last_packet_;
+    gboolean last_from_server = last_from_server_;
+    int turns = turns_;
+
+    next_record_ = g_list_last(follow_info_.payload);
+    global_client_pos_ = global_server_pos_ = 0;
+    client_buffer_count_ = server_buffer_count_ = 0;
+    client_packet_count_ = server_packet_count_ = 0;
+    last_packet_ = 0;
+    turns_ = 0;
+
+    updateWidgets(true);
+    save_out_ = &file;
+    readFollowStream(-1);
+    save_out_ = NULL;
+    if (dialogClosed()) {
+        return;
     }
+    updateWidgets(false);
 
-    QDataStream out(&file);
-    out.writeRawData(bytes.constData(), bytes.size());
+    next_record_ = next_record;
+    global_client_pos_ = global_client_pos;
+    global_server_pos_ = global_server_pos;
+    client_buffer_count_ = client_buffer_count;
+    server_buffer_count_ = server_buffer_count;
+    client_packet_count_ = client_packet_count;
+    server_packet_count_ = server_packet_count;
+    last_packet_ = last_packet;
+    last_from_server_ = last_from_server;
+    turns_ = turns;
 }
 
 void FollowStreamDialog::helpButton()
@@ -504,6 +547,7 @@ void FollowStreamDialog::resetStream()
 
     follow_info_.payload = Q_NULLPTR;
     follow_info_.client_port = 0;
+    next_record_ = NULL;
 }
 
 frs_return_t
@@ -523,6 +567,10 @@ FollowStreamDialog::readStream()
     last_packet_ = 0;
     turns_ = 0;
 
+    next_record_ = g_list_last(follow_info_.payload);
+    global_client_pos_ = 0;
+    global_server_pos_ = 0;
+
     switch(follow_type_) {
 
     case FOLLOW_TCP :
@@ -533,7 +581,7 @@ FollowStreamDialog::readStream()
     case FOLLOW_QUIC:
     case FOLLOW_TLS :
     case FOLLOW_SIP :
-        ret = readFollowStream();
+        ret = readFollowStream(render_window_);
         break;
 
     default :
@@ -553,9 +601,51 @@ FollowStreamDialog::followStream()
     readStream();
 }
 
+// Render the rest of the stream, or max_chars more of it, leaving the cursor
+// and scroll position alone.
+void FollowStreamDialog::readMoreStream(int max_chars)
+{
+    if (!next_record_ || truncated_ || reading_) {
+        return;
+    }
+
+    QTextCursor cursor = ui->teStreamContent->textCursor();
+    int cur_pos = ui->teStreamContent->verticalScrollBar()->value();
+    readFollowStream(max_chars);
+    if (dialogClosed()) {
+        return;
+    }
+    ui->teStreamContent->setTextCursor(cursor);
+    ui->teStreamContent->verticalScrollBar()->setValue(cur_pos);
+}
+
+// Render another window once the user scrolls close to the end of what we
+// have so far.
+void FollowStreamDialog::readAhead()
+{
+    QScrollBar *sb = ui->teStreamContent->verticalScrollBar();
+    if (sb->value() < sb->maximum() - 2 * sb->pageStep()) {
+        return;
+    }
+    readMoreStream(render_window_);
+}
+
 const int FollowStreamDialog::max_document_length_ = 500 * 1000 * 1000; // Just a guess
+const int FollowStreamDialog::render_window_ = 1000 * 1000; // chars
 void FollowStreamDialog::addText(QString text, gboolean is_from_server, guint32 packet_num)
 {
+    if (save_out_) {
+        // Unconditionally save data as UTF-8 (even if data is decoded otherwise).
+        QByteArray bytes = text.toUtf8();
+        if (show_type_ == SHOW_RAW) {
+            // The "Raw" format is currently displayed as hex data and needs to be
+            // converted to binary data.
+            bytes = QByteArray::fromHex(bytes);
+        }
+        save_out_->write(bytes);
+        return;
+    }
+
     if (truncated_) {
         return;
     }
@@ -1119,31 +1209,34 @@ void FollowStreamDialog::captureFileClosed()
  * This might or might not be the reason why C arrays display
  * correctly but get extra blank lines very other line when printed.
  */
+// Render records starting at next_record_ until the document has grown by
+// max_chars, or until the end if max_chars is negative.
 frs_return_t
-FollowStreamDialog::readFollowStream()
+FollowStreamDialog::readFollowStream(int max_chars)
 {
-    guint32 global_client_pos = 0, global_server_pos = 0;
     guint32 *global_pos;
     gboolean skip;
-    GList* cur;
     frs_return_t frs_return;
     follow_record_t *follow_record;
     QElapsedTimer elapsed_timer;
+    int start_count = ui->teStreamContent->document()->characterCount();
 
     elapsed_timer.start();
+    reading_ = true;
 
-    for (cur = g_list_last(follow_info_.payload); cur; cur = g_list_previous(cur)) {
+    for (; next_record_; next_record_ = g_list_previous(next_record_)) {
         if (dialogClosed()) break;
+        if (max_chars >= 0 && ui->teStreamContent->document()->characterCount() - start_count >= max_chars) break;
 
-        follow_record = (follow_record_t *)cur->data;
+        follow_record = (follow_record_t *)next_record_->data;
         skip = FALSE;
         if (!follow_record->is_server) {
-            global_pos = &global_client_pos;
+            global_pos = &global_client_pos_;
             if (follow_info_.show_stream == FROM_SERVER) {
                 skip = TRUE;
             }
         } else {
-            global_pos = &global_server_pos;
+            global_pos = &global_server_pos_;
             if (follow_info_.show_stream == FROM_CLIENT) {
                 skip = TRUE;
             }
@@ -1161,8 +1254,10 @@ FollowStreamDialog::readFollowStream()
                         follow_record->is_server,
                         follow_record->packet_num,
                         global_pos);
-            if (frs_return == FRS_PRINT_ERROR)
+            if (frs_return == FRS_PRINT_ERROR) {
+                reading_ = false;
                 return frs_return;
+            }
             if (elapsed_timer.elapsed() > info_update_freq_) {
                 fillHintLabel(ui->teStreamContent->textCursor().position());
                 wsApp->processEvents();
@@ -1171,5 +1266,6 @@ FollowStreamDialog::readFollowStream()
         }
     }
 
+    reading_ = false;
     return FRS_OK;
 }
@@ -66,6 +66,7 @@ private slots:
     void printStream();
     void fillHintLabel(int text_pos);
     void goToPacketForTextPos(int text_pos);
+    void readAhead();
 
     void on_streamNumberSpinBox_valueChanged(int stream_num);
     void on_subStreamNumberSpinBox_valueChanged(int sub_stream_num);
@@ -86,7 +87,8 @@ private:
                 guint32 packet_num, guint32 *global_pos);
 
     frs_return_t readStream();
-    frs_return_t readFollowStream();
+    frs_return_t readFollowStream(int max_chars);
+    void readMoreStream(int max_chars);
     frs_return_t readSslStream();
 
     void followStream();
@@ -106,7 +108,14 @@ private:
     show_type_t             show_type_;
     QString                 data_out_filename_;
     static const int        max_document_length_;
+    static const int        render_window_;
     bool                    truncated_;
+    // The next record to render, and the stream offsets it starts at.
+    GList                   *next_record_;
+    guint32                 global_client_pos_;
+    guint32                 global_server_pos_;
+    bool                    reading_;
+    QIODevice               *save_out_;
     QString                 previous_filter_;
     QString                 filter_out_filter_;
     QString                 output_filter_;
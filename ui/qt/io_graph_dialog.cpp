@@ -601,7 +601,9 @@ void IOGraphDialog::syncGraphSettings(int row)
 
     iog->y_axis_factor_ = uat_model_->data(uat_model_->index(row, colYAxisFactor)).toInt();
 
-    iog->setInterval(ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt());
+    if (!iog->setInterval(ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt())) {
+        retap = visible;
+    }
 
     if (!iog->configError().isEmpty()) {
         hint_err_ = iog->configError();
@@ -1225,12 +1227,13 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
     bool need_retap = false;
 
+    // Graphs tapped at a finer interval that divides the new one can just
+    // add up their items.
     if (uat_model_ != NULL) {
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
-                iog->setInterval(interval);
-                if (iog->visible()) {
+                if (!iog->setInterval(interval) && iog->visible()) {
                     need_retap = true;
                 }
             }
@@ -1239,6 +1242,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -1588,6 +1593,10 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     bars_(NULL),
     val_units_(IOG_ITEM_UNIT_FIRST),
     hf_index_(-1),
+    interval_(0),
+    base_interval_(1),
+    base_idx_(-1),
+    items_stale_(false),
     cur_idx_(-1)
 {
     Q_ASSERT(parent_ != NULL);
@@ -1879,9 +1888,9 @@ int IOGraph::packetFromTime(double ts)
         switch (val_units_) {
         case IOG_ITEM_UNIT_CALC_MAX:
         case IOG_ITEM_UNIT_CALC_MIN:
-            return items_[idx].extreme_frame_in_invl;
+            return items()[idx].extreme_frame_in_invl;
         default:
-            return items_[idx].last_frame_in_invl;
+            return items()[idx].last_frame_in_invl;
         }
     }
     return -1;
@@ -1889,8 +1898,12 @@ int IOGraph::packetFromTime(double ts)
 
 void IOGraph::clearAllData()
 {
+    base_items_.clear();
+    base_interval_ = 1;
+    base_idx_ = -1;
+    items_.clear();
+    items_stale_ = false;
     cur_idx_ = -1;
-    reset_io_graph_items(items_, max_io_items_);
     if (graph_) {
         graph_->data()->clear();
     }
@@ -1917,6 +1930,8 @@ void IOGraph::recalcGraphData(capture_file *cap_file, bool enable_scaling)
         x_axis = bars_->keyAxis();
     }
 
+    aggregateItems();
+
     if (moving_avg_period_ > 0 && cur_idx_ >= 0) {
         /* "Warm-up phase" - calculate average on some data not displayed;
          * just to make sure average on leftmost and rightmost displayed
@@ -2100,7 +2115,7 @@ bool IOGraph::hasItemToShow(int idx, double value) const
 
     bool result = false;
 
-    const io_graph_item_t *item = &items_[idx];
+    const io_graph_item_t *item = &items()[idx];
 
     switch (val_units_) {
     case IOG_ITEM_UNIT_PACKETS:
@@ -2134,9 +2149,90 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+// Returns false if the new interval can't be added up from the buckets we
+// have, in which case we need a retap.
+bool IOGraph::setInterval(int interval)
 {
     interval_ = interval;
+    if (interval_ % base_interval_ != 0) {
+        return false;
+    }
+    items_stale_ = true;
+    aggregateItems();
+    return true;
+}
+
+// Base intervals we can coarsen to when the capture is too long for
+// max_io_items_ buckets. Each is a multiple of the ones before it, and
+// there's one that divides each of the intervals in the combo box.
+static const int base_intervals_[] = { 1, 10, 100, 1000, 10000, 60000, 600000 };
+
+// Add up the base buckets into the next base interval that still divides
+// interval_, or into interval_ itself. Returns false if we're already there.
+bool IOGraph::coarsenBaseItems()
+{
+    int next_interval = interval_;
+    for (size_t i = 0; i < G_N_ELEMENTS(base_intervals_); i++) {
+        if (base_intervals_[i] > base_interval_ && interval_ % base_intervals_[i] == 0) {
+            next_interval = base_intervals_[i];
+            break;
+        }
+    }
+    if (next_interval <= base_interval_) {
+        return false;
+    }
+
+    // Bucket j gets buckets j * factor and up, which are never before j.
+    int factor = next_interval / base_interval_;
+    int count = base_idx_ / factor + 1;
+    for (int j = 0; j < count; j++) {
+        io_graph_item_t item;
+        reset_io_graph_items(&item, 1);
+        for (int i = j * factor; i < (j + 1) * factor && i <= base_idx_; i++) {
+            merge_io_graph_item(&item, &base_items_[i], hf_index_, val_units_);
+        }
+        base_items_[j] = item;
+    }
+    base_items_.resize(count);
+    base_interval_ = next_interval;
+    base_idx_ = count - 1;
+    items_stale_ = true;
+    return true;
+}
+
+// Add up the base buckets into items_ for interval_.
+void IOGraph::aggregateItems()
+{
+    if (!items_stale_) {
+        return;
+    }
+    items_stale_ = false;
+
+    if (interval_ <= 0 || interval_ % base_interval_ != 0 || base_idx_ < 0) {
+        // Waiting for a retap.
+        items_.clear();
+        cur_idx_ = -1;
+        return;
+    }
+
+    int factor = interval_ / base_interval_;
+    cur_idx_ = base_idx_ / factor;
+    if (factor == 1) {
+        // items() uses base_items_ directly.
+        items_.clear();
+        return;
+    }
+
+    items_.resize(cur_idx_ + 1);
+    reset_io_graph_items(items_.data(), items_.size());
+    for (int i = 0; i <= base_idx_; i++) {
+        merge_io_graph_item(&items_[i / factor], &base_items_.at(i), hf_index_, val_units_);
+    }
+}
+
+const io_graph_item_t *IOGraph::items() const
+{
+    return interval_ == base_interval_ ? base_items_.constData() : items_.constData();
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -2144,7 +2240,7 @@ double IOGraph::getItemValue(int idx, const capture_file *cap_file) const
 {
     g_assert(idx < max_io_items_);
 
-    return get_io_graph_item(items_, val_units_, idx, hf_index_, cap_file, interval_, cur_idx_);
+    return get_io_graph_item(items(), val_units_, idx, hf_index_, cap_file, interval_, cur_idx_);
 }
 
 // "tap_reset" callback for register_tap_listener
@@ -2165,20 +2261,34 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         return TAP_PACKET_DONT_REDRAW;
     }
 
-    int idx = get_io_graph_index(pinfo, iog->interval_);
+    int idx = get_io_graph_index(pinfo, iog->base_interval_);
     bool recalc = false;
 
+    while (idx >= max_io_items_ && iog->coarsenBaseItems()) {
+        idx = get_io_graph_index(pinfo, iog->base_interval_);
+    }
+
     /* some sanity checks */
     if ((idx < 0) || (idx >= max_io_items_)) {
-        iog->cur_idx_ = max_io_items_ - 1;
+        if (idx >= max_io_items_ && iog->base_idx_ < max_io_items_ - 1) {
+            int count = iog->base_items_.size();
+            iog->base_items_.resize(max_io_items_);
+            reset_io_graph_items(iog->base_items_.data() + count, max_io_items_ - count);
+            iog->base_idx_ = max_io_items_ - 1;
+            iog->items_stale_ = true;
+        }
         return TAP_PACKET_DONT_REDRAW;
     }
 
     /* update num_items */
-    if (idx > iog->cur_idx_) {
-        iog->cur_idx_ = (guint32) idx;
+    if (idx > iog->base_idx_) {
+        int count = iog->base_items_.size();
+        iog->base_items_.resize(idx + 1);
+        reset_io_graph_items(iog->base_items_.data() + count, idx + 1 - count);
+        iog->base_idx_ = idx;
         recalc = true;
     }
+    iog->items_stale_ = true;
 
     /* set start time */
     if (iog->start_time_ == 0.0) {
@@ -2194,7 +2304,7 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         adv_edt = edt;
     }
 
-    if (!update_io_graph_item(iog->items_, idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
+    if (!update_io_graph_item(iog->base_items_.data(), idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->base_interval_)) {
         return TAP_PACKET_DONT_REDRAW;
     }
 
@@ -26,6 +26,7 @@
 #include <QIcon>
 #include <QMenu>
 #include <QTextStream>
+#include <QVector>
 
 class QRubberBand;
 class QTimer;
@@ -65,7 +66,7 @@ public:
     const QString valueUnitField() { return vu_field_; }
     void setValueUnitField(const QString &vu_field);
     unsigned int movingAveragePeriod() { return moving_avg_period_; }
-    void setInterval(int interval);
+    bool setInterval(int interval);
     bool addToLegend();
     bool removeFromLegend();
     QCPGraph *graph() { return graph_; }
@@ -98,6 +99,10 @@ private:
     static tap_packet_status tapPacket(void *iog_ptr, packet_info *pinfo, epan_dissect_t *edt, const void *data);
     static void tapDraw(void *iog_ptr);
 
+    bool coarsenBaseItems();
+    void aggregateItems();
+    const io_graph_item_t *items() const;
+
     void calculateScaledValueUnit();
     template<class DataMap> double maxValueFromGraphData(const DataMap &map);
     template<class DataMap> void scaleGraphData(DataMap &map, int scalar);
@@ -119,7 +124,13 @@ private:
 
     // Cached data. We should be able to change the Y axis without retapping as
     // much as is feasible.
-    io_graph_item_t items_[max_io_items_];
+    // We tap into buckets of base_interval_ ms, as fine as max_io_items_
+    // allows, and add those up for coarser intervals.
+    QVector<io_graph_item_t> base_items_;
+    int base_interval_;
+    int base_idx_;
+    QVector<io_graph_item_t> items_;
+    bool items_stale_;
     int cur_idx_;
 };
 
@@ -44,6 +44,7 @@
 #include <wsutil/plugins.h>
 #endif
 #include <wsutil/report_message.h>
+#include <wsutil/startup_profile.h>
 #include <wsutil/please_report_bug.h>
 #include <wsutil/unicode-utils.h>
 #include <version_info.h>
@@ -987,6 +988,7 @@ int main(int argc, char *qt_argv[])
 
     wsApp->allSystemsGo();
     g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_INFO, "Wireshark is up and ready to go, elapsed time %.3fs\n", (float) (g_get_monotonic_time() - start_time) / 1000000);
+    startup_profile_write();
     SimpleDialog::displayQueuedMessages(main_w);
 
     /* User could specify filename, or display filter, or both */
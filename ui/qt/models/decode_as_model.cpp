@@ -704,13 +704,53 @@ void DecodeAsModel::gatherChangedEntries(const gchar *table_name,
     }
 }
 
-void DecodeAsModel::applyChanges()
+// The item that decides what an entry in a dissector table ends up as:
+// the last one for it, as they're applied in order.
+DecodeAsItem *DecodeAsModel::lastItemForEntry(const gchar *table_name, ftenum_t selector_type, guint selector_uint, const char *selector_string) const
+{
+    for (int row = decode_as_items_.count() - 1; row >= 0; row--) {
+        DecodeAsItem *item = decode_as_items_[row];
+
+        if (g_strcmp0(item->tableName_, table_name) != 0) {
+            continue;
+        }
+        if (selector_type == FT_NONE ||
+                (IS_FT_UINT(selector_type) && item->selectorUint_ == selector_uint) ||
+                (IS_FT_STRING(selector_type) && item->selectorString_ == QString::fromUtf8(selector_string))) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+// Whether the items would leave an entry in a dissector table as it is.
+bool DecodeAsModel::entryUnchanged(const gchar *table_name, ftenum_t selector_type, guint selector_uint, const char *selector_string, dissector_handle_t handle)
+{
+    DecodeAsItem *item = lastItemForEntry(table_name, selector_type, selector_uint, selector_string);
+
+    if (!item || item->current_proto_.isEmpty() || item->current_proto_ == DECODE_AS_NONE) {
+        return false;
+    }
+    if (!item->dissector_handle_ || item->dissector_handle_ != handle) {
+        return false;
+    }
+    unchanged_items_ << item;
+    return true;
+}
+
+bool DecodeAsModel::applyChanges()
 {
     dissector_table_t sub_dissectors;
     module_t *module;
     pref_t* pref_value;
     dissector_handle_t handle;
-    // Reset all dissector tables, then apply all rules from model.
+    bool changed = false;
+    // Reset the dissector table entries that the model changes or drops,
+    // then apply the rules from the model that aren't in place already.
+    // Entries that stay as they are aren't touched, nor are the
+    // preferences that go with them, so that their protocols don't have
+    // to apply their preferences again, and nothing needs to be
+    // redissected if nothing changed.
 
     // We can't call g_hash_table_removed from g_hash_table_foreach, which
     // means we can't call dissector_reset_{string,uint} from
@@ -719,11 +759,16 @@ void DecodeAsModel::applyChanges()
     //
     // If dissector_all_tables_remove_changed existed we could call it
     // instead.
+    unchanged_items_.clear();
     dissector_all_tables_foreach_changed(gatherChangedEntries, this);
     foreach (UintPair uint_entry, changed_uint_entries_) {
-        /* Set "Decode As preferences" to default values */
         sub_dissectors = find_dissector_table(uint_entry.first);
         handle = dissector_get_uint_handle(sub_dissectors, uint_entry.second);
+        if (entryUnchanged(uint_entry.first, dissector_table_get_type(sub_dissectors), uint_entry.second, NULL, handle)) {
+            continue;
+        }
+
+        /* Set "Decode As preferences" to default values */
         if (handle != NULL) {
             module = prefs_find_module(proto_get_protocol_filter_name(dissector_handle_get_protocol_index(handle)));
             pref_value = prefs_find_preference(module, uint_entry.first);
@@ -734,10 +779,17 @@ void DecodeAsModel::applyChanges()
         }
 
         dissector_reset_uint(uint_entry.first, uint_entry.second);
+        changed = true;
     }
     changed_uint_entries_.clear();
     foreach (CharPtrPair char_ptr_entry, changed_string_entries_) {
+        sub_dissectors = find_dissector_table(char_ptr_entry.first);
+        handle = dissector_get_string_handle(sub_dissectors, char_ptr_entry.second);
+        if (entryUnchanged(char_ptr_entry.first, dissector_table_get_type(sub_dissectors), 0, char_ptr_entry.second, handle)) {
+            continue;
+        }
         dissector_reset_string(char_ptr_entry.first, char_ptr_entry.second);
+        changed = true;
     }
     changed_string_entries_.clear();
 
@@ -747,6 +799,15 @@ void DecodeAsModel::applyChanges()
         if (item->current_proto_.isEmpty()) {
             continue;
         }
+        if (!unchanged_items_.isEmpty()) {
+            // Skip earlier items for the entry too, or they'd undo it.
+            QByteArray selector_string = item->selectorString_.toUtf8();
+            DecodeAsItem *last_item = lastItemForEntry(item->tableName_, get_dissector_table_selector_type(item->tableName_),
+                                                       item->selectorUint_, selector_string.constData());
+            if (unchanged_items_.contains(last_item)) {
+                continue;
+            }
+        }
 
         for (GList *cur = decode_as_list; cur; cur = cur->next) {
             decode_as_entry = (decode_as_t *) cur->data;
@@ -788,6 +849,7 @@ void DecodeAsModel::applyChanges()
                     continue;
                 }
 
+                changed = true;
                 if ((item->current_proto_ == DECODE_AS_NONE) || !item->dissector_handle_) {
                     decode_as_entry->reset_value(decode_as_entry->table_name, selector_value);
                     sub_dissectors = find_dissector_table(decode_as_entry->table_name);
@@ -822,5 +884,8 @@ void DecodeAsModel::applyChanges()
             }
         }
     }
+    unchanged_items_.clear();
     prefs_apply_all();
+
+    return changed;
 }
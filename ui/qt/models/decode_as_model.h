@@ -16,6 +16,7 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QSet>
 
 #include "cfile.h"
 
@@ -79,7 +80,8 @@ public:
 
     static QString entryString(const gchar *table_name, gconstpointer value);
 
-    void applyChanges();
+    // Returns true if any dissector table entry changed.
+    bool applyChanges();
 
 protected:
     static void buildChangedList(const gchar *table_name, ftenum_t selector_type,
@@ -89,12 +91,17 @@ protected:
                           gpointer key, gpointer value, gpointer user_data);
     static prefs_set_pref_e readDecodeAsEntry(gchar *key, const gchar *value,
                           void *user_data, gboolean return_range_errors);
+    DecodeAsItem *lastItemForEntry(const gchar *table_name, ftenum_t selector_type,
+                          guint selector_uint, const char *selector_string) const;
+    bool entryUnchanged(const gchar *table_name, ftenum_t selector_type,
+                          guint selector_uint, const char *selector_string, dissector_handle_t handle);
 
 private:
     capture_file *cap_file_;
     QList<DecodeAsItem *> decode_as_items_;
     QList<QPair<const char *, guint32> > changed_uint_entries_;
     QList<QPair<const char *, const char *> > changed_string_entries_;
+    QSet<DecodeAsItem *> unchanged_items_;
 };
 
 #endif // DECODE_AS_MODEL_H
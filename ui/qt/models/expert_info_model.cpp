@@ -58,6 +58,11 @@ void ExpertPacketItem::appendChild(ExpertPacketItem* child, QString hash)
     hashChild_[hash] = child;
 }
 
+void ExpertPacketItem::appendChild(ExpertPacketItem* child)
+{
+    childItems_.append(child);
+}
+
 ExpertPacketItem* ExpertPacketItem::child(int row)
 {
     return childItems_.value(row);
@@ -65,7 +70,7 @@ ExpertPacketItem* ExpertPacketItem::child(int row)
 
 ExpertPacketItem* ExpertPacketItem::child(QString hash)
 {
-    return hashChild_[hash];
+    return hashChild_.value(hash, NULL);
 }
 
 int ExpertPacketItem::childCount() const
@@ -341,7 +346,7 @@ int ExpertInfoModel::columnCount(const QModelIndex&) const
 void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
 {
     QString groupKey = ExpertPacketItem::groupKey(FALSE, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
-    QString summaryKey = ExpertPacketItem::groupKey(TRUE, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
+    QString summaryKey = groupKey + QString("|%1").arg(expert_info.hf_index);
 
     ExpertPacketItem* expert_root = root_->child(groupKey);
     if (expert_root == NULL) {
@@ -353,7 +358,8 @@ void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
     }
 
     ExpertPacketItem *expert = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_root);
-    expert_root->appendChild(expert, groupKey);
+    // Packet items are never looked up by key.
+    expert_root->appendChild(expert);
 
     //add the summary children off of the first child of the root children
     ExpertPacketItem* summary_root = expert_root->child(0);
@@ -368,7 +374,7 @@ void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
     }
 
     ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_summary_root);
-    expert_summary_root->appendChild(expert_summary, summaryKey);
+    expert_summary_root->appendChild(expert_summary);
 }
 
 void ExpertInfoModel::tapReset(void *eid_ptr)
@@ -41,6 +41,7 @@ public:
     QString groupKey(bool group_by_summary);
 
     void appendChild(ExpertPacketItem* child, QString hash);
+    void appendChild(ExpertPacketItem* child);
     ExpertPacketItem* child(int row);
     ExpertPacketItem* child(QString hash);
     int childCount() const;
@@ -13,7 +13,8 @@
 #include <ui/qt/utils/color_utils.h>
 
 ExpertInfoProxyModel::ExpertInfoProxyModel(QObject *parent) : QSortFilterProxyModel(parent),
-    severityMode_(Group)
+    severityMode_(Group),
+    passed_cf_(NULL)
 {
 }
 
@@ -229,16 +230,20 @@ bool ExpertInfoProxyModel::filterAcceptItem(ExpertPacketItem& item) const
     if (hidden_severities_.contains(item.severity()))
         return false;
 
-    if (!textFilter_.isEmpty()) {
-        QRegExp regex(textFilter_, Qt::CaseInsensitive);
+    if (passed_cf_ && passed_cf_->provider.frames && item.packetNum() > 0) {
+        frame_data *fdata = frame_data_sequence_find(passed_cf_->provider.frames, item.packetNum());
+        if (fdata && !fdata->passed_dfilter)
+            return false;
+    }
 
-        if (item.protocol().contains(regex))
+    if (!textFilter_.isEmpty()) {
+        if (item.protocol().contains(textRegex_))
             return true;
 
-        if (item.summary().contains(regex))
+        if (item.summary().contains(textRegex_))
             return true;
 
-        if (item.colInfo().contains(regex))
+        if (item.colInfo().contains(textRegex_))
             return true;
 
         return false;
@@ -254,6 +259,17 @@ bool ExpertInfoProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &so
     if (item == NULL)
         return true;
 
+    // Groups whose packets were all hidden by the display filter would
+    // otherwise show up with a count of zero.
+    if (passed_cf_ && !sourceParent.isValid() && item->childCount() > 0) {
+        for (int row = 0; row < item->childCount(); row++) {
+            ExpertPacketItem *child_item = item->child(row);
+            if (child_item && filterAcceptItem(*child_item))
+                return true;
+        }
+        return false;
+    }
+
     return filterAcceptItem(*item);
 }
 
@@ -281,5 +297,12 @@ void ExpertInfoProxyModel::setSeverityFilter(int severity, bool hide)
 void ExpertInfoProxyModel::setSummaryFilter(const QString &filter)
 {
     textFilter_ = filter;
+    textRegex_ = QRegExp(filter, Qt::CaseInsensitive);
+    invalidateFilter();
+}
+
+void ExpertInfoProxyModel::setPassedFramesFilter(capture_file *cf)
+{
+    passed_cf_ = cf;
     invalidateFilter();
 }
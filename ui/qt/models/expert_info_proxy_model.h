@@ -13,8 +13,11 @@
 
 #include <config.h>
 
+#include <QRegExp>
 #include <QSortFilterProxyModel>
 
+#include "cfile.h"
+
 class ExpertPacketItem;
 
 class ExpertInfoProxyModel : public QSortFilterProxyModel
@@ -45,6 +48,9 @@ public:
     void setSeverityMode(enum SeverityMode);
     void setSeverityFilter(int severity, bool hide);
     void setSummaryFilter(const QString &filter);
+    // Hide packet items whose frames didn't pass the display filter
+    // currently applied to cf. Pass NULL to show every packet.
+    void setPassedFramesFilter(capture_file *cf);
 
 protected:
     bool lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const;
@@ -54,6 +60,8 @@ protected:
     QList<int> hidden_severities_;
 
     QString textFilter_;
+    QRegExp textRegex_;
+    capture_file *passed_cf_;
 
 };
 
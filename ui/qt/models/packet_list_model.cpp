@@ -8,6 +8,9 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <glib.h>
 
 #include "packet_list_model.h"
@@ -16,9 +19,11 @@
 
 #include <wsutil/nstime.h>
 #include <epan/column.h>
+#include <epan/column-utils.h>
 #include <epan/prefs.h>
 
 #include "ui/packet_list_utils.h"
+#include "ui/progress_dlg.h"
 #include "ui/recent.h"
 
 #include <epan/color_filters.h>
@@ -34,8 +39,12 @@
 #include <QColor>
 #include <QElapsedTimer>
 #include <QFontMetrics>
+#include <QGuiApplication>
 #include <QModelIndex>
 #include <QElapsedTimer>
+#include <QScreen>
+#include <QThread>
+#include <QTimer>
 
 // Print timing information
 //#define DEBUG_PACKET_LIST_MODEL 1
@@ -47,6 +56,17 @@
 static PacketListModel * glbl_plist_model = Q_NULLPTR;
 static const int reserved_packets_ = 100000;
 
+// How long a frame of the primary display lasts, so that packets read
+// while capturing are added to the view once per screen update.
+static int displayFrameMs()
+{
+    QScreen *screen = QGuiApplication::primaryScreen();
+    if (screen && screen->refreshRate() > 0) {
+        return qBound(4, int(1000 / screen->refreshRate()), 100);
+    }
+    return 16;
+}
+
 guint
 packet_list_append(column_info *, frame_data *fdata)
 {
@@ -71,12 +91,27 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     number_to_row_(QVector<int>()),
     max_row_height_(0),
     max_line_count_(1),
-    idle_dissection_row_(0)
+    rescan_row_(0),
+    rows_sorted_(false),
+    sorting_(false),
+    stop_sorting_(FALSE),
+    idle_dissection_row_(0),
+    idle_budget_(0),
+    idle_slice_ms_(0),
+    viewport_first_(-1),
+    viewport_last_(-1),
+    viewport_scroll_down_(true),
+    viewport_paint_ms_(0)
 {
     Q_ASSERT(glbl_plist_model == Q_NULLPTR);
     glbl_plist_model = this;
     setCaptureFile(cf);
 
+    flush_timer_ = new QTimer(this);
+    flush_timer_->setSingleShot(true);
+    flush_timer_->setInterval(displayFrameMs());
+    connect(flush_timer_, &QTimer::timeout, this, &PacketListModel::flushVisibleRows);
+
     physical_rows_.reserve(reserved_packets_);
     visible_rows_.reserve(reserved_packets_);
     new_visible_rows_.reserve(1000);
@@ -135,16 +170,26 @@ int PacketListModel::packetNumberToRow(int packet_num) const
     return number_to_row_.value(packet_num) - 1;
 }
 
-guint PacketListModel::recreateVisibleRows()
+guint PacketListModel::recreateVisibleRows(guint32 last_frame)
 {
     beginResetModel();
     visible_rows_.resize(0);
     number_to_row_.fill(0);
     endResetModel();
 
+    rescan_row_ = 0;
     foreach (PacketListRecord *record, physical_rows_) {
         frame_data *fdata = record->frameData();
 
+        if (fdata->num > last_frame) {
+            // Not filtered yet, so passed_dfilter is from the last filter.
+            if (rows_sorted_) {
+                continue;
+            }
+            break;
+        }
+        rescan_row_++;
+
         if (fdata->passed_dfilter || fdata->ref_time) {
             visible_rows_ << record;
             if (number_to_row_.size() <= (int)fdata->num) {
@@ -161,17 +206,61 @@ guint PacketListModel::recreateVisibleRows()
     return visible_rows_.count();
 }
 
+// Add the rows of the frames a rescan has filtered since the last call, or
+// since recreateVisibleRows(). Rows in frame order only need appending;
+// sorted ones need recreating.
+void PacketListModel::appendRescannedRows(guint32 last_frame)
+{
+    if (rows_sorted_) {
+        recreateVisibleRows(last_frame);
+        return;
+    }
+
+    QVector<PacketListRecord *> rescanned_rows;
+    int pos = visible_rows_.count();
+
+    for (; rescan_row_ < physical_rows_.count(); rescan_row_++) {
+        PacketListRecord *record = physical_rows_.at(rescan_row_);
+        frame_data *fdata = record->frameData();
+
+        if (fdata->num > last_frame) {
+            break;
+        }
+
+        if (fdata->passed_dfilter || fdata->ref_time) {
+            rescanned_rows << record;
+            if (number_to_row_.size() <= (int)fdata->num) {
+                number_to_row_.resize(fdata->num + 10000);
+            }
+            number_to_row_[fdata->num] = pos + rescanned_rows.count();
+        }
+    }
+
+    if (!rescanned_rows.isEmpty()) {
+        beginInsertRows(QModelIndex(), pos, pos + rescanned_rows.count() - 1);
+        visible_rows_ << rescanned_rows;
+        endInsertRows();
+    }
+}
+
 void PacketListModel::clear() {
+    // A sort in progress would still be looking at the records.
+    stop_sorting_ = TRUE;
+
     emit beginResetModel();
     qDeleteAll(physical_rows_);
     physical_rows_.resize(0);
     visible_rows_.resize(0);
     new_visible_rows_.resize(0);
+    flush_timer_->stop();
     number_to_row_.resize(0);
+    rescan_row_ = 0;
+    rows_sorted_ = false;
     emit endResetModel();
     max_row_height_ = 0;
     max_line_count_ = 1;
     idle_dissection_row_ = 0;
+    viewport_first_ = viewport_last_ = -1;
 }
 
 void PacketListModel::invalidateAllColumnStrings()
@@ -184,6 +273,7 @@ void PacketListModel::invalidateAllColumnStrings()
 void PacketListModel::resetColumns()
 {
     if (cap_file_) {
+        cf_discard_cached_columns(cap_file_, TRUE, FALSE);
         PacketListRecord::resetColumns(&cap_file_->cinfo);
     }
 
@@ -191,8 +281,26 @@ void PacketListModel::resetColumns()
     emit headerDataChanged(Qt::Horizontal, 0, columnCount() - 1);
 }
 
+// A time shift changes time stamps, not what frames dissect to, so only
+// the time columns need filling in again, unless a custom column might
+// show a time field.
+void PacketListModel::resetTimeColumns()
+{
+    if (cap_file_ && have_custom_cols(&cap_file_->cinfo)) {
+        resetColumns();
+        return;
+    }
+
+    PacketListRecord::invalidateTimeColumns();
+    emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
+            QVector<int>() << Qt::DisplayRole);
+}
+
 void PacketListModel::resetColorized()
 {
+    if (cap_file_) {
+        cf_discard_cached_columns(cap_file_, FALSE, TRUE);
+    }
     PacketListRecord::resetColorization();
     dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
             QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole);
@@ -346,6 +454,8 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 {
     if (!cap_file_ || visible_rows_.count() < 1) return;
     if (column < 0) return;
+    // The progress bar of a text column sort can let another one in.
+    if (sorting_) return;
 
     sort_column_ = column;
     text_sort_column_ = PacketListRecord::textColumn(column);
@@ -354,8 +464,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     QString col_title = get_column_title(column);
 
-    // XXX Use updateProgress instead. We'd have to switch from std::sort to
-    // something we can interrupt.
     if (!col_title.isEmpty()) {
         QString busy_msg = tr("Sorting \"%1\"…").arg(col_title);
         wsApp->pushStatus(WiresharkApplication::BusyStatus, busy_msg);
@@ -363,7 +471,17 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     busy_timer_.start();
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
-    std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    if (text_sort_column_ < 0) {
+        // Frame data columns don't need dissection, so these are quick.
+        std::sort(physical_rows_.begin(), physical_rows_.end(), recordLessThan);
+    } else if (!sortTextColumn(col_title)) {
+        // Stopped, or the records went away.
+        if (!col_title.isEmpty()) {
+            wsApp->popStatus(WiresharkApplication::BusyStatus);
+        }
+        return;
+    }
+    rows_sorted_ = true;
 
     emit beginResetModel();
     visible_rows_.resize(0);
@@ -390,6 +508,149 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     }
 }
 
+// Dissect each record once for its sort key, with a progress bar that can
+// stop it, then sort the keys on other threads and put the records in their
+// order. Returns false if the sort was stopped.
+bool PacketListModel::sortTextColumn(const QString &col_title)
+{
+    int row_count = physical_rows_.count();
+    QVector<SortKey> keys;
+    progdlg_t *progbar = NULL;
+    QElapsedTimer progress_timer;
+    QByteArray task = tr("Sorting").toUtf8();
+    QByteArray title = col_title.toUtf8();
+    bool stopped = false;
+
+    sorting_ = true;
+    stop_sorting_ = FALSE;
+    keys.reserve(row_count);
+    progress_timer.start();
+
+    for (int row = 0; row < row_count; row++) {
+        PacketListRecord *record = physical_rows_.at(row);
+        SortKey key;
+
+        key.record = record;
+        key.frame_num = record->frameData()->num;
+        key.num = 0.0;
+        key.num_ok = false;
+        if (sort_column_is_numeric_) {
+            key.num = parseNumericColumn(record->columnString(sort_cap_file_, sort_column_), &key.num_ok);
+        } else {
+            key.text = record->columnString(sort_cap_file_, sort_column_);
+        }
+        keys << key;
+
+        if (progress_timer.elapsed() > busy_timeout_) {
+            gfloat progress = (gfloat) row / row_count;
+
+            if (!progbar) {
+                progbar = delayed_create_progress_dlg(cap_file_->window, task.constData(), title.constData(), TRUE, &stop_sorting_, progress);
+            } else {
+                update_progress_dlg(progbar, progress, NULL);
+            }
+            progress_timer.restart();
+
+            if (stop_sorting_) {
+                stopped = true;
+                break;
+            }
+        }
+    }
+
+    if (!stopped) {
+        int threads = QThread::idealThreadCount();
+        int depth = 0;
+        std::atomic<bool> sorted(false);
+
+        while (threads > 1) {
+            threads /= 2;
+            depth++;
+        }
+
+        std::thread sorter([&keys, &sorted, depth] {
+            sortKeys(keys.data(), keys.data() + keys.count(), depth);
+            sorted = true;
+        });
+        // Keep the progress bar, and the rest of the UI, going meanwhile.
+        while (!sorted) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (progress_timer.elapsed() > busy_timeout_) {
+                if (!progbar) {
+                    progbar = delayed_create_progress_dlg(cap_file_->window, task.constData(), title.constData(), TRUE, &stop_sorting_, 1.0);
+                } else {
+                    update_progress_dlg(progbar, 1.0, NULL);
+                }
+                progress_timer.restart();
+            }
+        }
+        sorter.join();
+        stopped = stop_sorting_;
+    }
+
+    if (progbar) {
+        destroy_progress_dlg(progbar);
+    }
+    sorting_ = false;
+
+    if (stopped) {
+        return false;
+    }
+
+    // Records appended while we were sorting stay at the end.
+    for (int row = 0; row < row_count; row++) {
+        physical_rows_[row] = keys.at(row).record;
+    }
+    return true;
+}
+
+bool PacketListModel::sortKeyLessThan(const SortKey &k1, const SortKey &k2)
+{
+    int cmp_val = 0;
+
+    // Same as recordLessThan for text columns.
+    if (sort_column_is_numeric_) {
+        if (!k1.num_ok && !k2.num_ok) {
+            cmp_val = 0;
+        } else if (!k1.num_ok || (k2.num_ok && k1.num < k2.num)) {
+            cmp_val = -1;
+        } else if (!k2.num_ok || (k1.num > k2.num)) {
+            cmp_val = 1;
+        }
+    } else {
+        cmp_val = k1.text.compare(k2.text);
+    }
+
+    if (cmp_val == 0) {
+        cmp_val = (k1.frame_num < k2.frame_num) ? -1 : (k1.frame_num > k2.frame_num);
+    }
+
+    if (sort_order_ == Qt::AscendingOrder) {
+        return cmp_val < 0;
+    } else {
+        return cmp_val > 0;
+    }
+}
+
+// Parallel merge sort: sort each half on its own thread, depth levels
+// down, then merge them.
+void PacketListModel::sortKeys(SortKey *first, SortKey *last, int depth)
+{
+    const ptrdiff_t min_split = 64 * 1024;
+    SortKey *middle;
+
+    if (depth <= 0 || last - first < min_split) {
+        std::sort(first, last, sortKeyLessThan);
+        return;
+    }
+
+    middle = first + (last - first) / 2;
+    std::thread left([first, middle, depth] { sortKeys(first, middle, depth - 1); });
+    sortKeys(middle, last, depth - 1);
+    left.join();
+    std::inplace_merge(first, middle, last, sortKeyLessThan);
+}
+
 bool PacketListModel::isNumericColumn(int column)
 {
     if (column < 0) {
@@ -478,7 +739,7 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
         // Column comes directly from frame data
         cmp_val = frame_data_compare(sort_cap_file_->epan, r1->frameData(), r2->frameData(), sort_cap_file_->cinfo.columns[sort_column_].col_fmt);
     } else  {
-        if (r1->columnString(sort_cap_file_, sort_column_).constData() == r2->columnString(sort_cap_file_, sort_column_).constData()) {
+        if (r1->columnText(sort_cap_file_, sort_column_) == r2->columnText(sort_cap_file_, sort_column_)) {
             cmp_val = 0;
         } else if (sort_column_is_numeric_) {
             // Custom column with numeric data (or something like a port number).
@@ -660,16 +921,19 @@ void PacketListModel::flushVisibleRows()
 {
     gint pos = visible_rows_.count();
 
+    flush_timer_->stop();
     if (new_visible_rows_.count() > 0) {
-        emit beginInsertRows(QModelIndex(), pos, pos + new_visible_rows_.count());
-        foreach (PacketListRecord *record, new_visible_rows_) {
-            frame_data *fdata = record->frameData();
+        frame_data *last_fdata = new_visible_rows_.last()->frameData();
 
-            visible_rows_ << record;
-            if (number_to_row_.size() <= (int)fdata->num) {
-                number_to_row_.resize(fdata->num + 10000);
-            }
-            number_to_row_[fdata->num] = visible_rows_.count();
+        // Rows are appended in frame order, so one resize covers them all.
+        if (number_to_row_.size() <= (int)last_fdata->num) {
+            number_to_row_.resize(last_fdata->num + 10000);
+        }
+
+        emit beginInsertRows(QModelIndex(), pos, pos + new_visible_rows_.count() - 1);
+        visible_rows_ << new_visible_rows_;
+        for (int row = pos; row < visible_rows_.count(); row++) {
+            number_to_row_[visible_rows_[row]->frameData()->num] = row + 1;
         }
         emit endInsertRows();
         new_visible_rows_.resize(0);
@@ -678,25 +942,97 @@ void PacketListModel::flushVisibleRows()
 
 // Fill our column string and colorization cache while the application is
 // idle. Try to be as conservative with the CPU and disk as possible.
+// Idle dissection runs in slices of at most idle_budget_ ms, idle_dissection_interval_
+// ms apart. Each slice and the paint it's competing with should fit in a frame;
+// if the event loop gets back to us late the budget is halved, otherwise it
+// creeps back up.
 static const int idle_dissection_interval_ = 5; // ms
+static const int idle_frame_ms_ = 16; // ms
+static const int idle_budget_min_ = 2; // ms
+// Pages of rows to dissect ahead of the viewport in the scroll direction.
+static const int idle_prefetch_pages_ = 4;
+
+void PacketListModel::setViewportRows(int first, int last, qint64 paint_ms)
+{
+    if (first < 0) {
+        return;
+    }
+    if (last < first) {
+        last = first;
+    }
+
+    if (first > viewport_first_) {
+        viewport_scroll_down_ = true;
+    } else if (first < viewport_first_) {
+        viewport_scroll_down_ = false;
+    }
+    viewport_first_ = first;
+    viewport_last_ = last;
+    viewport_paint_ms_ = paint_ms;
+}
+
+// Dissect rows from first to last, inclusive, stepping by step. Returns
+// false if the slice ran out of time.
+bool PacketListModel::dissectIdleRows(int first, int last, int step)
+{
+    for (int row = first; step > 0 ? row <= last : row >= last; row += step) {
+        if (idle_dissection_timer_->elapsed() >= idle_budget_) {
+            return false;
+        }
+        ensureRowColorized(row);
+    }
+    return true;
+}
+
 void PacketListModel::dissectIdle(bool reset)
 {
     if (reset) {
 //        qDebug() << "=di reset" << idle_dissection_row_;
         idle_dissection_row_ = 0;
+        idle_budget_ = idle_frame_ms_ / 2;
+        idle_slice_ms_ = 0;
     } else if (!idle_dissection_timer_->isValid()) {
         return;
+    } else {
+        // Time since the last slice started, less that slice and our
+        // interval, is time the event loop was busy elsewhere.
+        qint64 late = idle_dissection_timer_->elapsed() - idle_slice_ms_ - idle_dissection_interval_;
+        if (late > idle_budget_) {
+            idle_budget_ = qMax(idle_budget_min_, idle_budget_ / 2);
+        } else {
+            idle_budget_++;
+        }
+        idle_budget_ = qBound(idle_budget_min_, idle_budget_, qMax(idle_budget_min_, int(idle_frame_ms_ - viewport_paint_ms_)));
     }
 
     idle_dissection_timer_->restart();
 
+    // Rows on screen first, then a few pages ahead in the direction we're
+    // scrolling and one behind, then everything else in order.
+    bool more = true;
+    if (viewport_first_ >= 0 && viewport_first_ < visible_rows_.count()) {
+        int last = qMin(viewport_last_, visible_rows_.count() - 1);
+        int page = last - viewport_first_ + 1;
+        int ahead = idle_prefetch_pages_ * page;
+
+        more = dissectIdleRows(viewport_first_, last, 1);
+        if (viewport_scroll_down_) {
+            more = more && dissectIdleRows(last + 1, qMin(last + ahead, visible_rows_.count() - 1), 1);
+            more = more && dissectIdleRows(viewport_first_ - 1, qMax(viewport_first_ - page, 0), -1);
+        } else {
+            more = more && dissectIdleRows(viewport_first_ - 1, qMax(viewport_first_ - ahead, 0), -1);
+            more = more && dissectIdleRows(last + 1, qMin(last + page, visible_rows_.count() - 1), 1);
+        }
+    }
+
     int first = idle_dissection_row_;
-    while (idle_dissection_timer_->elapsed() < idle_dissection_interval_
+    while (more && idle_dissection_timer_->elapsed() < idle_budget_
            && idle_dissection_row_ < physical_rows_.count()) {
         ensureRowColorized(idle_dissection_row_);
         idle_dissection_row_++;
 //        if (idle_dissection_row_ % 1000 == 0) qDebug() << "=di row" << idle_dissection_row_;
     }
+    idle_slice_ms_ = idle_dissection_timer_->elapsed();
 
     if (idle_dissection_row_ < physical_rows_.count()) {
         QTimer::singleShot(idle_dissection_interval_, this, SLOT(dissectIdle()));
@@ -725,10 +1061,11 @@ gint PacketListModel::appendPacket(frame_data *fdata)
 
     if (fdata->passed_dfilter || fdata->ref_time) {
         new_visible_rows_ << record;
-        if (new_visible_rows_.count() < 2) {
-            // This is the first queued packet. Schedule an insertion for
-            // the next UI update.
-            QTimer::singleShot(0, this, SLOT(flushVisibleRows()));
+        if (!flush_timer_->isActive()) {
+            // This is the first queued packet. Insert it, and any that
+            // follow it, at the next screen update, so that a fast
+            // capture doesn't spend its time in model signals.
+            flush_timer_->start();
         }
         pos = visible_rows_.count() + new_visible_rows_.count() - 1;
     }
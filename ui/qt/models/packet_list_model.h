@@ -27,6 +27,7 @@
 #include "cfile.h"
 
 class QElapsedTimer;
+class QTimer;
 
 class PacketListModel : public QAbstractItemModel
 {
@@ -39,7 +40,8 @@ public:
                       const QModelIndex & = QModelIndex()) const;
     QModelIndex parent(const QModelIndex &) const;
     int packetNumberToRow(int packet_num) const;
-    guint recreateVisibleRows();
+    guint recreateVisibleRows(guint32 last_frame = G_MAXUINT32);
+    void appendRescannedRows(guint32 last_frame);
     void clear();
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
@@ -60,6 +62,10 @@ public:
      * @brief Rebuild columns from settings.
      */
     void resetColumns();
+    /**
+     * @brief Fill in the time columns again after a time shift.
+     */
+    void resetTimeColumns();
     void resetColorized();
     void toggleFrameMark(const QModelIndexList &indeces);
     void setDisplayedFrameMark(gboolean set);
@@ -70,6 +76,14 @@ public:
 
     void setMaximumRowHeight(int height);
 
+    /**
+     * @brief Tell idle dissection which rows the view is showing.
+     * @param first The first row in the viewport.
+     * @param last The last row in the viewport.
+     * @param paint_ms How long the view took to paint them.
+     */
+    void setViewportRows(int first, int last, qint64 paint_ms);
+
 signals:
     void goToPacket(int);
     void maxLineCountChanged(const QModelIndex &ih_index) const;
@@ -89,10 +103,17 @@ private:
     QVector<PacketListRecord *> visible_rows_;
     QVector<PacketListRecord *> new_visible_rows_;
     QVector<int> number_to_row_;
+    // Appends new_visible_rows_ at most once per display frame.
+    QTimer *flush_timer_;
 
     int max_row_height_; // px
     int max_line_count_;
 
+    // Physical rows that a rescan has shown so far, and whether they've
+    // been sorted out of frame order.
+    int rescan_row_;
+    bool rows_sorted_;
+
     static int sort_column_;
     static int sort_column_is_numeric_;
     static int text_sort_column_;
@@ -101,8 +122,34 @@ private:
     static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
     static double parseNumericColumn(const QString &val, bool *ok);
 
+    // What a text column sort compares, extracted from each record once so
+    // that the sort itself doesn't dissect and can run on other threads.
+    struct SortKey {
+        PacketListRecord *record;
+        guint32 frame_num;
+        double num;
+        bool num_ok;
+        QString text;
+    };
+    static bool sortKeyLessThan(const SortKey &k1, const SortKey &k2);
+    static void sortKeys(SortKey *first, SortKey *last, int depth);
+    bool sortTextColumn(const QString &col_title);
+
+    bool sorting_;
+    gboolean stop_sorting_;
+
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
+    int idle_budget_; // ms
+    qint64 idle_slice_ms_;
+
+    // What the view last painted, and which way it's been scrolling.
+    int viewport_first_;
+    int viewport_last_;
+    bool viewport_scroll_down_;
+    qint64 viewport_paint_ms_;
+
+    bool dissectIdleRows(int first, int last, int step);
 
     struct _GStringChunk *string_cache_pool_;
 
@@ -23,17 +23,21 @@
 
 #include <ui/qt/utils/qt_ui_utils.h>
 
-#include <QStringList>
-
 QMap<int, int> PacketListRecord::cinfo_column_;
 unsigned PacketListRecord::col_data_ver_ = 1;
+unsigned PacketListRecord::col_time_ver_ = 1;
 unsigned PacketListRecord::rows_color_ver_ = 1;
+GStringChunk *PacketListRecord::string_cache_ = NULL;
+
+// Size of the blocks string_cache_ grows by.
+static const gsize string_cache_block_size_ = 64 * 1024;
 
 PacketListRecord::PacketListRecord(frame_data *frameData) :
     fdata_(frameData),
     lines_(1),
     line_count_changed_(false),
     data_ver_(0),
+    time_ver_(0),
     color_ver_(0),
     colorized_(false),
     conv_index_(0),
@@ -66,15 +70,20 @@ void PacketListRecord::ensureColorized(capture_file *cap_file)
     }
 }
 
-// We might want to return a const char * instead. This would keep us from
-// creating excessive QByteArrays, e.g. in PacketListModel::recordLessThan.
+// Only rows that are shown or sorted on get a QString, the others keep their
+// text as UTF-8 in string_cache_.
 const QString PacketListRecord::columnString(capture_file *cap_file, int column, bool colorized)
+{
+    return QString::fromUtf8(columnText(cap_file, column, colorized));
+}
+
+const char *PacketListRecord::columnText(capture_file *cap_file, int column, bool colorized)
 {
     // packet_list_store.c:packet_list_get_value
     Q_ASSERT(fdata_);
 
     if (!cap_file || column < 0 || column > cap_file->cinfo.num_cols) {
-        return QString();
+        return NULL;
     }
 
     //
@@ -83,11 +92,25 @@ const QString PacketListRecord::columnString(capture_file *cap_file, int column,
     // properly colorized?
     //
     bool dissect_color = ( colorized && !colorized_ ) || ( color_ver_ != rows_color_ver_ );
-    if (column >= col_text_.count() || col_text_.at(column).isNull() || data_ver_ != col_data_ver_ || dissect_color) {
+    if (column >= col_text_.count() || !col_text_.at(column) || data_ver_ != col_data_ver_ || dissect_color) {
         dissect(cap_file, dissect_color);
+    } else if (time_ver_ != col_time_ver_) {
+        refreshTimeColumns(&cap_file->cinfo);
     }
 
-    return col_text_.at(column);
+    return col_text_.value(column, NULL);
+}
+
+void PacketListRecord::invalidateAllRecords()
+{
+    col_data_ver_++;
+
+    // Every record dissects again before it uses its text, so nothing
+    // points into the old strings any more.
+    if (string_cache_) {
+        g_string_chunk_free(string_cache_);
+        string_cache_ = NULL;
+    }
 }
 
 void PacketListRecord::resetColumns(column_info *cinfo)
@@ -127,6 +150,20 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
         cinfo = &cap_file->cinfo;
     }
 
+    // Frames whose first pass came from the first pass cache can be
+    // shown without reading or dissecting them.
+    if (cf_get_cached_columns(cap_file, fdata_, cinfo, dissect_color)) {
+        if (dissect_columns) {
+            cacheColumnStrings(cinfo);
+        }
+        if (dissect_color) {
+            colorized_ = true;
+            color_ver_ = rows_color_ver_;
+        }
+        data_ver_ = col_data_ver_;
+        return;
+    }
+
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
     if (read_failed_) {
@@ -216,7 +253,6 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
     wtap_rec_cleanup(&rec);
 }
 
-//#define MINIMIZE_STRING_COPYING 1
 void PacketListRecord::cacheColumnStrings(column_info *cinfo)
 {
     // packet_list_store.c:packet_list_change_record(PacketList *packet_list, PacketListRecord *record, gint col, column_info *cinfo)
@@ -224,89 +260,80 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         return;
     }
 
+    if (!string_cache_) {
+        string_cache_ = g_string_chunk_new(string_cache_block_size_);
+    }
+
     col_text_.clear();
+    col_text_.reserve(cinfo->num_cols);
     lines_ = 1;
     line_count_changed_ = false;
 
     for (int column = 0; column < cinfo->num_cols; ++column) {
-        int col_lines = 1;
+        const char *col_str;
 
-#ifdef MINIMIZE_STRING_COPYING
-        int text_col = cinfo_column_.value(column, -1);
+        if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
+            /* Use the unresolved value in col_expr_val */
+            col_str = cinfo->col_expr.col_expr_val[column];
+        } else {
+            int text_col = cinfo_column_.value(column, -1);
 
-        /* Column based on frame_data or it already contains a value */
-        if (text_col < 0) {
-            col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
-            col_text_ << QString(cinfo->columns[column].col_data);
-            continue;
+            if (text_col < 0) {
+                col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
+            }
+            col_str = cinfo->columns[column].col_data;
+        }
+        if (!col_str) {
+            col_str = "";
         }
 
-        switch (cinfo->col_fmt[column]) {
-        case COL_PROTOCOL:
+        // Protocol, addresses, ports, lengths and most custom columns have
+        // few distinct values, so keep each of those once. Numbers, times
+        // and Info are nearly all different, so don't spend a hash on them.
+        switch (cinfo->columns[column].col_fmt) {
+        case COL_NUMBER:
         case COL_INFO:
-        case COL_IF_DIR:
-        case COL_DCE_CALL:
-        case COL_8021Q_VLAN_ID:
-        case COL_EXPERT:
-        case COL_FREQ_CHAN:
-            if (cinfo->columns[column].col_data && cinfo->columns[column].col_data != cinfo->columns[column].col_buf) {
-                /* This is a constant string, so we don't have to copy it */
-                // XXX - ui/gtk/packet_list_store.c uses G_MAXUSHORT. We don't do proper UTF8
-                // truncation in either case.
-                int col_text_len = MIN(qstrlen(cinfo->col_data[column]) + 1, COL_MAX_INFO_LEN);
-                col_text_ << QString(QByteArray::fromRawData(cinfo->columns[column].col_data, col_text_len));
-                break;
-            }
-            /* !! FALL-THROUGH!! */
-
-        case COL_DEF_SRC:
-        case COL_RES_SRC:        /* COL_DEF_SRC is currently just like COL_RES_SRC */
-        case COL_UNRES_SRC:
-        case COL_DEF_DL_SRC:
-        case COL_RES_DL_SRC:
-        case COL_UNRES_DL_SRC:
-        case COL_DEF_NET_SRC:
-        case COL_RES_NET_SRC:
-        case COL_UNRES_NET_SRC:
-        case COL_DEF_DST:
-        case COL_RES_DST:        /* COL_DEF_DST is currently just like COL_RES_DST */
-        case COL_UNRES_DST:
-        case COL_DEF_DL_DST:
-        case COL_RES_DL_DST:
-        case COL_UNRES_DL_DST:
-        case COL_DEF_NET_DST:
-        case COL_RES_NET_DST:
-        case COL_UNRES_NET_DST:
+        case COL_CUMULATIVE_BYTES:
+            col_text_ << g_string_chunk_insert(string_cache_, col_str);
+            break;
         default:
-            if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
-                /* Use the unresolved value in col_expr_val */
-                // XXX Use QContiguousCache?
-                col_text_ << QString(cinfo->col_expr.col_expr_val[column]);
+            if (col_has_time_fmt(cinfo, column)) {
+                col_text_ << g_string_chunk_insert(string_cache_, col_str);
             } else {
-                col_text_ << QString(cinfo->columns[column].col_data);
+                col_text_ << g_string_chunk_insert_const(string_cache_, col_str);
             }
             break;
         }
-#else // MINIMIZE_STRING_COPYING
-        QString col_str;
-        if (!get_column_resolved(column) && cinfo->col_expr.col_expr_val[column]) {
-            /* Use the unresolved value in col_expr_val */
-            col_str = QString(cinfo->col_expr.col_expr_val[column]);
-        } else {
-            int text_col = cinfo_column_.value(column, -1);
 
-            if (text_col < 0) {
-                col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
+        int col_lines = 0;
+        for (const char *c = col_str; *c; c++) {
+            if (*c == '\n') {
+                col_lines++;
             }
-            col_str = QString(cinfo->columns[column].col_data);
         }
-
-        col_text_ << col_str;
-        col_lines = col_str.count('\n');
         if (col_lines > lines_) {
             lines_ = col_lines;
             line_count_changed_ = true;
         }
-#endif // MINIMIZE_STRING_COPYING
     }
+    time_ver_ = col_time_ver_;
+}
+
+// Time columns are filled in from frame data alone, so this doesn't need
+// to read or dissect the frame.
+void PacketListRecord::refreshTimeColumns(column_info *cinfo)
+{
+    if (!string_cache_) {
+        string_cache_ = g_string_chunk_new(string_cache_block_size_);
+    }
+
+    for (int column = 0; column < col_text_.count() && column < cinfo->num_cols; ++column) {
+        if (cinfo_column_.value(column, -1) >= 0 || !col_has_time_fmt(cinfo, column)) {
+            continue;
+        }
+        col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
+        const char *col_str = cinfo->columns[column].col_data;
+        col_text_[column] = g_string_chunk_insert(string_cache_, col_str ? col_str : "");
+    }
+    time_ver_ = col_time_ver_;
 }
@@ -22,6 +22,7 @@
 #include <QByteArray>
 #include <QList>
 #include <QVariant>
+#include <QVector>
 
 struct conversation;
 struct _GStringChunk;
@@ -36,6 +37,9 @@ public:
     void ensureColorized(capture_file *cap_file);
     // Return the string value for a column. Data is cached if possible.
     const QString columnString(capture_file *cap_file, int column, bool colorized = false);
+    // Return the UTF-8 text for a column, valid until the records are
+    // invalidated. Repeated values of repetitive columns share a pointer.
+    const char *columnText(capture_file *cap_file, int column, bool colorized = false);
     frame_data *frameData() const { return fdata_; }
     // packet_list->col_to_text in gtk/packet_list_store.c
     static int textColumn(int column) { return cinfo_column_.value(column, -1); }
@@ -43,16 +47,21 @@ public:
     unsigned int conversation() { return conv_index_; }
 
     int columnTextSize(const char *str);
-    static void invalidateAllRecords() { col_data_ver_++; }
+    static void invalidateAllRecords();
     static void resetColumns(column_info *cinfo);
     static void resetColorization() { rows_color_ver_++; }
+    // Fill in the time columns again, from frame data, e.g. after a time
+    // shift. The other columns are kept.
+    static void invalidateTimeColumns() { col_time_ver_++; }
 
     inline int lineCount() { return lines_; }
     inline int lineCountChanged() { return line_count_changed_; }
 
 private:
-    /** The column text for some columns */
-    QStringList col_text_;
+    /** The column text for some columns. Points into string_cache_. */
+    QVector<const char *> col_text_;
+    /** UTF-8 column text of all records. Freed when they're invalidated. */
+    static struct _GStringChunk *string_cache_;
 
     frame_data *fdata_;
     int lines_;
@@ -62,6 +71,9 @@ private:
     /** Data versions. Used to invalidate col_text_ */
     static unsigned col_data_ver_;
     unsigned data_ver_;
+    /** Time versions. Used to refill the time columns of col_text_ */
+    static unsigned col_time_ver_;
+    unsigned time_ver_;
     /** Has this record been colorized? */
     static unsigned int rows_color_ver_;
     unsigned int color_ver_;
@@ -74,6 +86,7 @@ private:
 
     void dissect(capture_file *cap_file, bool dissect_color = false);
     void cacheColumnStrings(column_info *cinfo);
+    void refreshTimeColumns(column_info *cinfo);
 };
 
 #endif // PACKET_LIST_RECORD_H
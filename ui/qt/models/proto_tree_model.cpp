@@ -28,7 +28,7 @@ ProtoTreeModel::ProtoTreeModel(QObject * parent) :
 Qt::ItemFlags ProtoTreeModel::flags(const QModelIndex &index) const
 {
     Qt::ItemFlags item_flags = QAbstractItemModel::flags(index);
-    if (rowCount(index) < 1) {
+    if (!hasChildren(index)) {
         item_flags |= Qt::ItemNeverHasChildren;
     }
 
@@ -47,20 +47,12 @@ QModelIndex ProtoTreeModel::index(int row, int, const QModelIndex &parent) const
     if (! parent_node.isValid())
         return QModelIndex();
 
-    int cur_row = 0;
-    ProtoNode::ChildIterator kids = parent_node.children();
-    while (kids.element().isValid())
-    {
-        if (cur_row == row)
-            break;
-        cur_row++;
-        kids.next();
-    }
-    if (! kids.element().isValid()) {
+    const QVector<proto_node *> &kids = childNodes(parent_node.protoNode());
+    if (row < 0 || row >= kids.count()) {
         return QModelIndex();
     }
 
-    return createIndex(row, 0, static_cast<void *>(kids.element().protoNode()));
+    return createIndex(row, 0, static_cast<void *>(kids.at(row)));
 }
 
 QModelIndex ProtoTreeModel::parent(const QModelIndex &index) const
@@ -72,9 +64,41 @@ QModelIndex ProtoTreeModel::parent(const QModelIndex &index) const
 int ProtoTreeModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid()) {
-        return protoNodeFromIndex(parent).childrenCount();
+        return childNodes(protoNodeFromIndex(parent).protoNode()).count();
+    }
+    return childNodes(root_node_).count();
+}
+
+// Unlike rowCount this doesn't gather the children, so that collapsed nodes
+// stay cheap.
+bool ProtoTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    ProtoNode parent_node = parent.isValid() ? protoNodeFromIndex(parent) : ProtoNode(root_node_);
+    if (!parent_node.isValid()) {
+        return false;
+    }
+    return parent_node.children().element().isValid();
+}
+
+const QVector<proto_node *> &ProtoTreeModel::childNodes(proto_node *node) const
+{
+    static const QVector<proto_node *> no_children;
+    if (!node) {
+        return no_children;
+    }
+
+    QHash<proto_node *, QVector<proto_node *> >::iterator it = child_nodes_.find(node);
+    if (it == child_nodes_.end()) {
+        QVector<proto_node *> kids;
+        ProtoNode::ChildIterator kid = ProtoNode(node).children();
+        while (kid.element().isValid()) {
+            node_rows_.insert(kid.element().protoNode(), kids.count());
+            kids << kid.element().protoNode();
+            kid.next();
+        }
+        it = child_nodes_.insert(node, kids);
     }
-    return ProtoNode(root_node_).childrenCount();
+    return it.value();
 }
 
 // The QItemDelegate documentation says
@@ -147,6 +171,8 @@ void ProtoTreeModel::setRootNode(proto_node *root_node)
 {
     beginResetModel();
     root_node_ = root_node;
+    child_nodes_.clear();
+    node_rows_.clear();
     endResetModel();
     if (!root_node) return;
 
@@ -163,9 +189,13 @@ ProtoNode ProtoTreeModel::protoNodeFromIndex(const QModelIndex &index) const
 
 QModelIndex ProtoTreeModel::indexFromProtoNode(ProtoNode &index_node) const
 {
-    int row = index_node.row();
+    if (!index_node.isChild()) {
+        return QModelIndex();
+    }
 
-    if (!index_node.isValid() || row < 0) {
+    childNodes(index_node.parentNode().protoNode());
+    int row = node_rows_.value(index_node.protoNode(), -1);
+    if (row < 0) {
         return QModelIndex();
     }
 
@@ -13,7 +13,9 @@
 #include <ui/qt/utils/proto_node.h>
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QModelIndex>
+#include <QVector>
 
 class ProtoTreeModel : public QAbstractItemModel
 {
@@ -26,6 +28,7 @@ public:
     QModelIndex index(int row, int, const QModelIndex &parent = QModelIndex()) const;
     virtual QModelIndex parent(const QModelIndex &index) const;
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
     virtual int columnCount(const QModelIndex &) const { return 1; }
     virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
 
@@ -39,6 +42,12 @@ public:
 
 private:
     proto_node* root_node_;
+    // Shown children of each node the view has asked about, and the row of
+    // each of those children. Built as nodes are expanded so that a node
+    // with thousands of children isn't walked for every index() and row.
+    mutable QHash<proto_node *, QVector<proto_node *> > child_nodes_;
+    mutable QHash<proto_node *, int> node_rows_;
+    const QVector<proto_node *> &childNodes(proto_node *node) const;
     static void foreachFindHfid(proto_node *node, gpointer find_hfid_ptr);
     static void foreachFindField(proto_node *node, gpointer find_finfo_ptr);
 };
@@ -160,6 +160,15 @@ packet_list_freeze(void)
     }
 }
 
+// Called from rescan_packets as it filters.
+void
+packet_list_show_rescanned(guint32 last_framenum)
+{
+    if (gbl_cur_packet_list) {
+        gbl_cur_packet_list->showRescanned(last_framenum);
+    }
+}
+
 void
 packet_list_thaw(void)
 {
@@ -781,7 +790,19 @@ void PacketList::paintEvent(QPaintEvent *event)
     // require a new overlay, e.g. page up/down, scrolling, column
     // resizing, etc.
     create_near_overlay_ = true;
+
+    QElapsedTimer paint_timer;
+    paint_timer.start();
     QTreeView::paintEvent(event);
+
+    // Let idle dissection know which rows to work on first.
+    QModelIndex first_idx = indexAt(viewport()->rect().topLeft());
+    QModelIndex last_idx = indexAt(viewport()->rect().bottomLeft());
+    if (first_idx.isValid()) {
+        packet_list_model_->setViewportRows(first_idx.row(),
+                                            last_idx.isValid() ? last_idx.row() : packet_list_model_->rowCount() - 1,
+                                            paint_timer.elapsed());
+    }
 }
 
 void PacketList::mousePressEvent (QMouseEvent *event)
@@ -1227,6 +1248,18 @@ void PacketList::thaw(bool restore_selection)
     frozen_rows_ = QModelIndexList();
 }
 
+// Show the frames up to last_frame that passed the filter being applied,
+// thawing the list the first time.
+void PacketList::showRescanned(guint32 last_frame)
+{
+    if (!model()) {
+        packet_list_model_->recreateVisibleRows(last_frame);
+        thaw();
+    } else {
+        packet_list_model_->appendRescannedRows(last_frame);
+    }
+}
+
 void PacketList::clear() {
     related_packet_delegate_.clear();
     selectionModel()->clear();
@@ -1670,8 +1703,9 @@ void PacketList::unsetAllTimeReferences()
 
 void PacketList::applyTimeShift()
 {
-    packet_list_model_->resetColumns();
-    redrawVisiblePackets();
+    packet_list_model_->resetTimeColumns();
+    // The selected frame is dissected again for its time fields.
+    drawCurrentPacket();
     // XXX emit packetDissectionChanged(); ?
 }
 
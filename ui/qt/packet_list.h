@@ -66,6 +66,7 @@ public:
      * packet. This includes filling in the detail and byte views.
      */
     void thaw(bool restore_selection = false);
+    void showRescanned(guint32 last_frame);
     void clear();
     void writeRecent(FILE *rf);
     bool contextMenuActive();
@@ -412,27 +412,39 @@ void ProtoTree::setMonospaceFont(const QFont &mono_font)
     update();
 }
 
-void ProtoTree::foreachTreeNode(proto_node *node, gpointer proto_tree_ptr)
+void ProtoTree::foreachRelatedFrame(proto_node *node, gpointer proto_tree_ptr)
 {
     ProtoTree *tree_view = static_cast<ProtoTree *>(proto_tree_ptr);
-    ProtoTreeModel *model = qobject_cast<ProtoTreeModel *>(tree_view->model());
-    if (!tree_view || !model) {
-        return;
-    }
-
-    // Expanded state
-    if (tree_expanded(node->finfo->tree_type)) {
-        ProtoNode expand_node = ProtoNode(node);
-        tree_view->expand(model->indexFromProtoNode(expand_node));
-    }
 
-    // Related frames
     if (node->finfo->hfinfo->type == FT_FRAMENUM) {
         ft_framenum_type_t framenum_type = (ft_framenum_type_t)GPOINTER_TO_INT(node->finfo->hfinfo->strings);
         tree_view->emitRelatedFrame(node->finfo->value.value.uinteger, framenum_type);
     }
 
-    proto_tree_children_foreach(node, foreachTreeNode, proto_tree_ptr);
+    proto_tree_children_foreach(node, foreachRelatedFrame, proto_tree_ptr);
+}
+
+// Rows we'll expand when restoring the expanded state of a new tree or of a
+// newly expanded item. Anything past it stays collapsed until the user
+// expands it, so that a tree with thousands of items doesn't stall us.
+static const int max_restored_rows_ = 2000;
+
+// Expand the children of parent that were expanded before, and theirs,
+// without looking beneath collapsed items. syncExpanded takes care of those
+// when they're expanded.
+void ProtoTree::expandSavedSubtrees(const QModelIndex &parent, int &row_budget)
+{
+    int row_count = proto_tree_model_->rowCount(parent);
+    for (int row = 0; row < row_count && row_budget > 0; row++) {
+        QModelIndex child = proto_tree_model_->index(row, 0, parent);
+        ProtoNode child_node = proto_tree_model_->protoNodeFromIndex(child);
+        if (!child_node.isExpanded()) {
+            continue;
+        }
+        expand(child);
+        row_budget -= proto_tree_model_->rowCount(child);
+        expandSavedSubtrees(child, row_budget);
+    }
 }
 
 // setRootNode sets the new contents for the protocol tree and subsequently
@@ -444,9 +456,14 @@ void ProtoTree::setRootNode(proto_node *root_node) {
     proto_tree_model_->setRootNode(root_node);
 
     disconnect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(syncExpanded(QModelIndex)));
-    proto_tree_children_foreach(root_node, foreachTreeNode, this);
+    int row_budget = max_restored_rows_;
+    expandSavedSubtrees(QModelIndex(), row_budget);
     connect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(syncExpanded(QModelIndex)));
 
+    if (root_node) {
+        proto_tree_children_foreach(root_node, foreachRelatedFrame, this);
+    }
+
     updateContentWidth();
 }
 
@@ -512,6 +529,12 @@ void ProtoTree::syncExpanded(const QModelIndex &index) {
     if (finfo.treeType() != -1) {
         tree_expanded_set(finfo.treeType(), TRUE);
     }
+
+    // setRootNode only restored what was visible back then.
+    disconnect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(syncExpanded(QModelIndex)));
+    int row_budget = max_restored_rows_;
+    expandSavedSubtrees(index, row_budget);
+    connect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(syncExpanded(QModelIndex)));
 }
 
 void ProtoTree::syncCollapsed(const QModelIndex &index) {
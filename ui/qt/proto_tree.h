@@ -70,7 +70,8 @@ private:
     epan_dissect_t *edt_;
 
     void saveSelectedField(QModelIndex &index);
-    static void foreachTreeNode(proto_node *node, gpointer proto_tree_ptr);
+    static void foreachRelatedFrame(proto_node *node, gpointer proto_tree_ptr);
+    void expandSavedSubtrees(const QModelIndex &parent, int &row_budget);
 
 signals:
     void fieldSelected(FieldInformation *);
@@ -289,9 +289,11 @@ void ProtocolPreferencesMenu::boolPreferenceTriggered()
     if (changed_flags & PREF_EFFECT_FIELDS) {
         wsApp->emitAppSignal(WiresharkApplication::FieldsChanged);
     }
-    /* Protocol preference changes almost always affect dissection,
-       so don't bother checking flags */
-    wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+    /* Redissecting rescans the whole file, so only do it if the
+       preference may change how packets are dissected. */
+    if (changed_flags & PREF_EFFECT_DISSECTION) {
+        wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+    }
 }
 
 void ProtocolPreferencesMenu::enumPreferenceTriggered()
@@ -308,9 +310,11 @@ void ProtocolPreferencesMenu::enumPreferenceTriggered()
         if (changed_flags & PREF_EFFECT_FIELDS) {
             wsApp->emitAppSignal(WiresharkApplication::FieldsChanged);
         }
-        /* Protocol preference changes almost always affect dissection,
-           so don't bother checking flags */
-        wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+        /* Redissecting rescans the whole file, so only do it if the
+           preference may change how packets are dissected. */
+        if (changed_flags & PREF_EFFECT_DISSECTION) {
+            wsApp->emitAppSignal(WiresharkApplication::PacketDissectionChanged);
+        }
     }
 }
 
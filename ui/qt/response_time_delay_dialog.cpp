@@ -64,7 +64,10 @@ enum {
     col_open_requests,
     col_discarded_responses_,
     col_repeated_requests_,
-    col_repeated_responses_
+    col_repeated_responses_,
+    col_p50_srt_,
+    col_p99_srt_,
+    col_p999_srt_
 };
 
 enum {
@@ -94,6 +97,9 @@ public:
         setText(col_discarded_responses_, QString::number(timestat_->disc_rsp_num));
         setText(col_repeated_requests_, QString::number(timestat_->req_dup_num));
         setText(col_repeated_responses_, QString::number(timestat_->rsp_dup_num));
+        setText(col_p50_srt_, QString::number(time_stat_percentile(timestat_->rtd, 50.0) / 1000.0, 'f', 6));
+        setText(col_p99_srt_, QString::number(time_stat_percentile(timestat_->rtd, 99.0) / 1000.0, 'f', 6));
+        setText(col_p999_srt_, QString::number(time_stat_percentile(timestat_->rtd, 99.9) / 1000.0, 'f', 6));
 
         setHidden(timestat_->rtd->num < 1);
     }
@@ -127,6 +133,12 @@ public:
             return timestat_->req_dup_num < other_row->timestat_->req_dup_num;
         case col_repeated_responses_:
             return timestat_->rsp_dup_num < other_row->timestat_->rsp_dup_num;
+        case col_p50_srt_:
+            return time_stat_percentile(timestat_->rtd, 50.0) < time_stat_percentile(other_row->timestat_->rtd, 50.0);
+        case col_p99_srt_:
+            return time_stat_percentile(timestat_->rtd, 99.0) < time_stat_percentile(other_row->timestat_->rtd, 99.0);
+        case col_p999_srt_:
+            return time_stat_percentile(timestat_->rtd, 99.9) < time_stat_percentile(other_row->timestat_->rtd, 99.9);
         default:
             break;
         }
@@ -139,7 +151,10 @@ public:
                                  << get_average(&timestat_->rtd->tot, timestat_->rtd->num) / 1000.0
                                  << timestat_->rtd->min_num << timestat_->rtd->max_num
                                  << timestat_->open_req_num << timestat_->disc_rsp_num
-                                 << timestat_->req_dup_num << timestat_->rsp_dup_num;
+                                 << timestat_->req_dup_num << timestat_->rsp_dup_num
+                                 << time_stat_percentile(timestat_->rtd, 50.0) / 1000.0
+                                 << time_stat_percentile(timestat_->rtd, 99.0) / 1000.0
+                                 << time_stat_percentile(timestat_->rtd, 99.9) / 1000.0;
     }
 
 private:
@@ -161,7 +176,8 @@ ResponseTimeDelayDialog::ResponseTimeDelayDialog(QWidget &parent, CaptureFile &c
             << tr("Min SRT") << tr("Max SRT") << tr("Avg SRT")
             << tr("Min in Frame") << tr("Max in Frame")
             << tr("Open Requests") << tr("Discarded Responses")
-            << tr("Repeated Requests") << tr("Repeated Responses");
+            << tr("Repeated Requests") << tr("Repeated Responses")
+            << tr("p50 SRT") << tr("p99 SRT") << tr("p99.9 SRT");
 
     statsTreeWidget()->setHeaderLabels(header_names);
 
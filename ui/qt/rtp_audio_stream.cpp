@@ -28,6 +28,8 @@
 
 #include <ui/qt/utils/rtp_audio_routing_filter.h>
 
+#include <algorithm>
+
 #include <QAudioFormat>
 #include <QAudioOutput>
 #include <QDir>
@@ -150,7 +152,8 @@ void RtpAudioStream::reset(double global_start_time)
     stop_rel_time_ = start_rel_time_;
     audio_out_rate_ = 0;
     max_sample_val_ = 1;
-    packet_timestamps_.clear();
+    visual_timestamps_.clear();
+    visual_frame_nums_.clear();
     visual_samples_.clear();
     out_of_seq_timestamps_.clear();
     jitter_drop_timestamps_.clear();
@@ -182,14 +185,52 @@ void RtpAudioStream::setAudioRouting(AudioRouting audio_routing)
  */
 static const qint64 max_silence_samples_ = MAX_SILENCE_FRAMES;
 
-void RtpAudioStream::decode(QAudioDeviceInfo out_device)
+void RtpAudioStream::prepareDecode(QAudioDeviceInfo out_device)
 {
-    if (rtp_packets_.size() < 1) return;
-
     if (audio_resampler_) {
-        speex_resampler_reset_mem(audio_resampler_);
+        speex_resampler_destroy(audio_resampler_);
+        audio_resampler_ = 0;
     }
-    decodeAudio(out_device);
+    first_sample_rate_ = 0;
+    audio_out_rate_ = 0;
+
+    // The output rate depends on the first packet we are able to decode,
+    // and QAudioDeviceInfo must be only asked from the GUI thread. Find
+    // that packet with throwaway decoders so that the state of the real
+    // ones isn't disturbed.
+    struct _GHashTable *probe_hash = rtp_decoder_hash_table_new();
+    for (int cur_packet = 0; cur_packet < rtp_packets_.size(); cur_packet++) {
+        SAMPLE *decode_buff = NULL;
+        rtp_packet_t *rtp_packet = rtp_packets_[cur_packet];
+        unsigned int channels = 0;
+        unsigned int sample_rate = 0;
+
+        size_t decoded_bytes = decode_rtp_packet(rtp_packet, &decode_buff, probe_hash, &channels, &sample_rate);
+        g_free(decode_buff);
+
+        // Same rules as in decodeAudio()
+        if (decoded_bytes == 0 || sample_rate == 0 ||
+            ((rtp_packet->info->info_payload_type == PT_PCMU ||
+              rtp_packet->info->info_payload_type == PT_PCMA
+             ) && (decoded_bytes == 2)
+            )
+           ) {
+            continue;
+        }
+
+        first_sample_rate_ = sample_rate;
+        // Side effect: it creates and initiates resampler if needed
+        audio_out_rate_ = calculateAudioOutRate(out_device, sample_rate, audio_requested_out_rate_);
+        break;
+    }
+    g_hash_table_destroy(probe_hash);
+}
+
+void RtpAudioStream::decode()
+{
+    if (rtp_packets_.size() < 1) return;
+
+    decodeAudio();
 
     speex_resampler_reset_mem(visual_resampler_);
     decodeVisual();
@@ -236,7 +277,7 @@ quint32 RtpAudioStream::calculateAudioOutRate(QAudioDeviceInfo out_device, unsig
     return out_rate;
 }
 
-void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
+void RtpAudioStream::decodeAudio()
 {
     // XXX This is more messy than it should be.
 
@@ -257,6 +298,7 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
     guint64 start_timestamp = 0;
 
     size_t decoded_bytes_prev = 0;
+    bool first_decoded = true;
 
     rtp_frame_info frame_info;
 
@@ -307,13 +349,11 @@ void RtpAudioStream::decodeAudio(QAudioDeviceInfo out_device)
             continue;
         }
 
-        if (audio_out_rate_ == 0) {
-            first_sample_rate_ = sample_rate;
+        if (first_decoded) {
+            first_decoded = false;
 
-            // We calculate audio_out_rate just for first sample_rate.
-            // All later are just resampled to it.
-            // Side effect: it creates and initiates resampler if needed
-            audio_out_rate_ = calculateAudioOutRate(out_device, sample_rate, audio_requested_out_rate_);
+            // audio_out_rate_ was calculated by prepareDecode() for the
+            // first sample_rate. All later are just resampled to it.
 
             // Calculate count of prepend samples for the stream
             // Note: Order of operations and separation to two formulas is
@@ -495,7 +535,8 @@ void RtpAudioStream::decodeVisual()
         // Create timestamp and visual sample
         for (unsigned i = 0; i < out_len; i++) {
             double time = start_rel_time_ + (double) sample_no / visual_sample_rate_;
-            packet_timestamps_[time] = frame_info.frame_num;
+            visual_timestamps_.append(time);
+            visual_frame_nums_.append(frame_info.frame_num);
             if (qAbs(resample_buff[i]) > max_sample_val_) max_sample_val_ = qAbs(resample_buff[i]);
             visual_samples_.append(resample_buff[i]);
             sample_no++;
@@ -516,12 +557,12 @@ const QStringList RtpAudioStream::payloadNames() const
 
 const QVector<double> RtpAudioStream::visualTimestamps(bool relative)
 {
-    QVector<double> ts_keys = packet_timestamps_.keys().toVector();
-    if (relative) return ts_keys;
+    if (relative) return visual_timestamps_;
 
     QVector<double> adj_timestamps;
-    for (int i = 0; i < ts_keys.size(); i++) {
-        adj_timestamps.append(ts_keys[i] + start_abs_offset_ - start_rel_time_);
+    adj_timestamps.reserve(visual_timestamps_.size());
+    for (int i = 0; i < visual_timestamps_.size(); i++) {
+        adj_timestamps.append(visual_timestamps_[i] + start_abs_offset_ - start_rel_time_);
     }
     return adj_timestamps;
 }
@@ -533,6 +574,7 @@ const QVector<double> RtpAudioStream::visualSamples(int y_offset)
 {
     QVector<double> adj_samples;
     double scaled_offset = y_offset * stack_offset_;
+    adj_samples.reserve(visual_samples_.size());
     for (int i = 0; i < visual_samples_.size(); i++) {
         adj_samples.append(((double)visual_samples_[i] * G_MAXINT16 / max_sample_val_used_) + scaled_offset);
     }
@@ -625,12 +667,12 @@ const QVector<double> RtpAudioStream::insertedSilenceSamples(int y_offset)
 
 quint32 RtpAudioStream::nearestPacket(double timestamp, bool is_relative)
 {
-    if (packet_timestamps_.keys().count() < 1) return 0;
+    if (visual_timestamps_.size() < 1) return 0;
 
     if (!is_relative) timestamp -= start_abs_offset_;
-    QMap<double, quint32>::const_iterator it = packet_timestamps_.lowerBound(timestamp);
-    if (it == packet_timestamps_.end()) return 0;
-    return it.value();
+    QVector<double>::const_iterator it = std::lower_bound(visual_timestamps_.constBegin(), visual_timestamps_.constEnd(), timestamp);
+    if (it == visual_timestamps_.constEnd()) return 0;
+    return visual_frame_nums_[(int)(it - visual_timestamps_.constBegin())];
 }
 
 QAudio::State RtpAudioStream::outputState() const
@@ -59,7 +59,18 @@ public:
     void reset(double global_start_time);
     AudioRouting getAudioRouting();
     void setAudioRouting(AudioRouting audio_routing);
-    void decode(QAudioDeviceInfo out_device);
+    /**
+     * @brief Pick the output rate for the stream. Must be called from the
+     * GUI thread before decode().
+     * @param out_device The device the stream will be played on.
+     */
+    void prepareDecode(QAudioDeviceInfo out_device);
+    /**
+     * @brief Decode the audio and the visual waveform of the stream. Only
+     * touches the state of this stream, so several streams can be decoded
+     * in parallel from worker threads.
+     */
+    void decode();
 
     double startRelTime() const { return start_rel_time_; }
     double stopRelTime() const { return stop_rel_time_; }
@@ -187,7 +198,8 @@ private:
     struct SpeexResamplerState_ *audio_resampler_;
     struct SpeexResamplerState_ *visual_resampler_;
     QAudioOutput *audio_output_;
-    QMap<double, quint32> packet_timestamps_;
+    QVector<double> visual_timestamps_;  // Sorted, one per visual sample
+    QVector<quint32> visual_frame_nums_; // Frame of each visual sample
     QVector<qint16> visual_samples_;
     QVector<double> out_of_seq_timestamps_;
     QVector<double> jitter_drop_timestamps_;
@@ -205,7 +217,7 @@ private:
     const QString formatDescription(const QAudioFormat & format);
     QString currentOutputDevice();
 
-    void decodeAudio(QAudioDeviceInfo out_device);
+    void decodeAudio();
     void decodeVisual();
     quint32 calculateAudioOutRate(QAudioDeviceInfo out_device, unsigned int sample_rate, unsigned int requested_out_rate);
     SAMPLE *resizeBufferIfNeeded(SAMPLE *buff, gint32 *buff_bytes, qint64 requested_size);
@@ -35,6 +35,8 @@
 #include <QMenu>
 #include <QVBoxLayout>
 #include <QTimer>
+#include <QThreadPool>
+#include <QRunnable>
 
 #include <QAudioFormat>
 #include <QAudioOutput>
@@ -153,6 +155,7 @@ RtpPlayerDialog::RtpPlayerDialog(QWidget &parent, CaptureFile &cf) :
     , marker_stream_requested_out_rate_(0)
     , last_ti_(0)
     , listener_removed_(true)
+    , decoding_(false)
 {
     ui->setupUi(this);
     loadGeometry(parent.width(), parent.height());
@@ -339,6 +342,17 @@ QPushButton *RtpPlayerDialog::addPlayerButton(QDialogButtonBox *button_box, QDia
 }
 
 #ifdef QT_MULTIMEDIA_LIB
+// Decodes one stream on a worker thread
+class RtpAudioStreamDecoder : public QRunnable
+{
+public:
+    RtpAudioStreamDecoder(RtpAudioStream *audio_stream) : audio_stream_(audio_stream) {}
+    void run() { audio_stream_->decode(); }
+
+private:
+    RtpAudioStream *audio_stream_;
+};
+
 RtpPlayerDialog::~RtpPlayerDialog()
 {
     cleanupMarkerStream();
@@ -379,6 +393,11 @@ void RtpPlayerDialog::retapPackets()
         // Retap is running, nothing better we can do
         return;
     }
+    if (decoding_) {
+        // Streams are being decoded, try again once they are done
+        QTimer::singleShot(100, this, SLOT(retapPackets()));
+        return;
+    }
     ui->hintLabel->setText("<i><small>" + tr("Decoding streams...") + "</i></small>");
     wsApp->processEvents();
 
@@ -417,12 +436,19 @@ void RtpPlayerDialog::retapPackets()
 
 void RtpPlayerDialog::rescanPackets(bool rescale_axes)
 {
+    if (decoding_) {
+        return;
+    }
+
     // Show information for a user - it can last long time...
     ui->hintLabel->setText("<i><small>" + tr("Decoding streams...") + "</i></small>");
     wsApp->processEvents();
 
     QAudioDeviceInfo cur_out_device = getCurrentDeviceInfo();
     int row_count = ui->streamTreeWidget->topLevelItemCount();
+    // Streams don't share any decoding state, so decode each of them on
+    // its own worker thread.
+    QThreadPool decode_pool;
 
     // Reset stream values
     for (int row = 0; row < row_count; row++) {
@@ -446,8 +472,17 @@ void RtpPlayerDialog::rescanPackets(bool rescale_axes)
         }
         audio_stream->setTimingMode(timing_mode);
 
-        audio_stream->decode(cur_out_device);
+        audio_stream->prepareDecode(cur_out_device);
+        decode_pool.start(new RtpAudioStreamDecoder(audio_stream));
+    }
+
+    // Keep repainting while the workers run, but don't let the user
+    // change or remove the streams under them.
+    decoding_ = true;
+    while (!decode_pool.waitForDone(100)) {
+        wsApp->processEvents(QEventLoop::ExcludeUserInputEvents);
     }
+    decoding_ = false;
 
     for (int col = 0; col < ui->streamTreeWidget->columnCount() - 1; col++) {
         ui->streamTreeWidget->resizeColumnToContents(col);
@@ -494,6 +529,8 @@ void RtpPlayerDialog::createPlot(bool rescale_axes)
         int y_offset = row_count - row - 1;
         AudioRouting audio_routing = audio_stream->getAudioRouting();
 
+        // Its wave was already removed by clearGraphs()
+        delete ti->data(graph_audio_data_col_, Qt::UserRole).value<RtpAudioGraph*>();
         ti->setData(graph_audio_data_col_, Qt::UserRole, QVariant());
         ti->setData(graph_sequence_data_col_, Qt::UserRole, QVariant());
         ti->setData(graph_jitter_data_col_, Qt::UserRole, QVariant());
@@ -1414,6 +1451,7 @@ void RtpPlayerDialog::removeRow(QTreeWidgetItem *ti)
     if (audio_graph) {
         ti->setData(graph_audio_data_col_, Qt::UserRole, QVariant());
         audio_graph->remove(ui->audioPlot);
+        delete audio_graph;
     }
 
     QCPGraph *graph;
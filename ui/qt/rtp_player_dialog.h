@@ -176,6 +176,7 @@ private:
     quint32 marker_stream_requested_out_rate_;
     QTreeWidgetItem *last_ti_;
     bool listener_removed_;
+    bool decoding_;
     QPushButton *export_btn_;
 
 //    const QString streamKey(const rtpstream_info_t *rtpstream);
@@ -21,9 +21,61 @@
 #include <QPalette>
 #include <QPen>
 #include <QPointF>
+#include <qmath.h>
 
 const int max_comment_em_width_ = 20;
 
+// Labels the rows of the time or comment axis. Only the labels of visible
+// rows are created, instead of one for every item up front.
+class SequenceRowTicker : public QCPAxisTicker
+{
+public:
+    SequenceRowTicker(const WSCPSeqDataVector *data, bool comment) :
+        data_(data),
+        comment_(comment),
+        elide_w_(0)
+    {}
+
+    void setFont(const QFont &font)
+    {
+        font_ = font;
+        elide_w_ = QFontMetrics(font_).height() * max_comment_em_width_;
+    }
+
+protected:
+    virtual double getTickStep(const QCPRange &) Q_DECL_OVERRIDE { return 1.0; }
+    virtual int getSubTickCount(double) Q_DECL_OVERRIDE { return 0; }
+
+    virtual QString getTickLabel(double tick, const QLocale &, QChar, int) Q_DECL_OVERRIDE
+    {
+        int key = qRound(tick);
+        if (key < 0 || key >= data_->size()) return QString();
+
+        seq_analysis_item_t *sai = data_->at(key).value;
+        if (!comment_) return sai->time_str;
+        return QFontMetrics(font_).elidedText(sai->comment, Qt::ElideRight, elide_w_);
+    }
+
+    virtual QVector<double> createTickVector(double, const QCPRange &range) Q_DECL_OVERRIDE
+    {
+        QVector<double> ticks;
+        // One tick outside of the range on both sides, like QCPAxisTickerText
+        int first = qMax(qFloor(range.lower) - 1, 0);
+        int last = qMin(qCeil(range.upper) + 1, data_->size() - 1);
+
+        for (int key = first; key <= last; key++) {
+            ticks.append(key);
+        }
+        return ticks;
+    }
+
+private:
+    const WSCPSeqDataVector *data_;
+    bool comment_;
+    QFont font_;
+    int elide_w_;
+};
+
 // UML-like network node sequence diagrams.
 // https://developer.ibm.com/articles/the-sequence-diagram/
 
@@ -44,12 +96,10 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
     key_axis_(keyAxis),
     value_axis_(valueAxis),
     comment_axis_(commentAxis),
-    data_(NULL),
     sainfo_(NULL),
     selected_packet_(0),
     selected_key_(-1.0)
 {
-    data_ = new WSCPSeqDataMap();
     // xaxis (value): Address
     // yaxis (key): Time
     // yaxis2 (comment): Extra info ("Comment" in GTK+)
@@ -57,10 +107,11 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
 //    valueAxis->setAutoTickStep(false);
     QList<QCPAxis *> axes;
     axes << value_axis_ << key_axis_ << comment_axis_;
+    value_axis_->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTickerText));
+    key_axis_->setTicker(QSharedPointer<QCPAxisTicker>(new SequenceRowTicker(&data_, false)));
+    comment_axis_->setTicker(QSharedPointer<QCPAxisTicker>(new SequenceRowTicker(&data_, true)));
     QPen no_pen(Qt::NoPen);
     foreach (QCPAxis *axis, axes) {
-        QSharedPointer<QCPAxisTicker> ticker(new QCPAxisTickerText);
-        axis->setTicker(ticker);
         axis->setSubTickPen(no_pen);
         axis->setTickPen(no_pen);
         axis->setBasePen(no_pen);
@@ -88,50 +139,28 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
 
 SequenceDiagram::~SequenceDiagram()
 {
-    delete data_;
 }
 
 int SequenceDiagram::adjacentPacket(bool next)
 {
     int adjacent_packet = -1;
-    WSCPSeqDataMap::const_iterator it;
+    int key;
 
-    if (data_->size() < 1) return adjacent_packet;
+    if (data_.size() < 1) return adjacent_packet;
 
     if (selected_packet_ < 1) {
-        if (next) {
-            it = data_->constBegin();
-        } else {
-            it = data_->constEnd();
-            --it;
-        }
-        selected_key_ = it.value().key;
-        return it.value().value->frame_number;
+        key = next ? 0 : data_.size() - 1;
+        selected_key_ = data_[key].key;
+        return data_[key].value->frame_number;
     }
 
-    if (next) {
-        for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-            if (it.value().value->frame_number == selected_packet_) {
-                ++it;
-                if (it != data_->constEnd()) {
-                    adjacent_packet = it.value().value->frame_number;
-                    selected_key_ = it.value().key;
-                }
-                break;
-            }
-        }
-    } else {
-        it = data_->constEnd();
-        --it;
-        while (it != data_->constBegin()) {
-            guint32 prev_frame = it.value().value->frame_number;
-            --it;
-            if (prev_frame == selected_packet_) {
-                adjacent_packet = it.value().value->frame_number;
-                selected_key_ = it.value().key;
-                break;
-            }
-        }
+    key = frame_keys_.value(selected_packet_, -1);
+    if (key < 0) return adjacent_packet;
+
+    key += next ? 1 : -1;
+    if (key >= 0 && key < data_.size()) {
+        adjacent_packet = data_[key].value->frame_number;
+        selected_key_ = data_[key].key;
     }
 
     return adjacent_packet;
@@ -139,30 +168,23 @@ int SequenceDiagram::adjacentPacket(bool next)
 
 void SequenceDiagram::setData(_seq_analysis_info *sainfo)
 {
-    data_->clear();
+    clearData();
     sainfo_ = sainfo;
     if (!sainfo) return;
 
     double cur_key = 0.0;
-    QVector<double> key_ticks, val_ticks;
-    QVector<QString> key_labels, val_labels, com_labels;
-    QFontMetrics com_fm(comment_axis_->tickLabelFont());
-    int elide_w = com_fm.height() * max_comment_em_width_;
+    QVector<double> val_ticks;
+    QVector<QString> val_labels;
     char* addr_str;
 
+    data_.reserve(g_queue_get_length(sainfo->items));
     for (GList *cur = g_queue_peek_nth_link(sainfo->items, 0); cur; cur = gxx_list_next(cur)) {
         seq_analysis_item_t *sai = gxx_list_data(seq_analysis_item_t *, cur);
         if (sai->display) {
-            WSCPSeqData new_data;
-
-            new_data.key = cur_key;
-            new_data.value = sai;
-            data_->insert(new_data.key, new_data);
-
-            key_ticks.append(cur_key);
-            key_labels.append(sai->time_str);
-
-            com_labels.append(com_fm.elidedText(sai->comment, Qt::ElideRight, elide_w));
+            if (!frame_keys_.contains(sai->frame_number)) {
+                frame_keys_.insert(sai->frame_number, data_.size());
+            }
+            data_.append(WSCPSeqData(cur_key, sai));
 
             cur_key++;
         }
@@ -179,12 +201,10 @@ void SequenceDiagram::setData(_seq_analysis_info *sainfo)
         wmem_free(Q_NULLPTR, addr_str);
     }
 
-    QSharedPointer<QCPAxisTickerText> key_ticker = qSharedPointerCast<QCPAxisTickerText>(keyAxis()->ticker());
-    key_ticker->setTicks(key_ticks, key_labels);
     QSharedPointer<QCPAxisTickerText> value_ticker = qSharedPointerCast<QCPAxisTickerText>(valueAxis()->ticker());
     value_ticker->setTicks(val_ticks, val_labels);
-    QSharedPointer<QCPAxisTickerText> comment_ticker = qSharedPointerCast<QCPAxisTickerText>(comment_axis_->ticker());
-    comment_ticker->setTicks(key_ticks, com_labels);
+    QSharedPointer<SequenceRowTicker> comment_ticker = qSharedPointerCast<SequenceRowTicker>(comment_axis_->ticker());
+    comment_ticker->setFont(comment_axis_->tickLabelFont());
 }
 
 void SequenceDiagram::setSelectedPacket(int selected_packet)
@@ -192,6 +212,10 @@ void SequenceDiagram::setSelectedPacket(int selected_packet)
     selected_key_ = -1;
     if (selected_packet > 0) {
         selected_packet_ = selected_packet;
+        int key = frame_keys_.value(selected_packet_, -1);
+        if (key >= 0) {
+            selected_key_ = data_[key].key;
+        }
     } else {
         selected_packet_ = 0;
     }
@@ -202,8 +226,8 @@ _seq_analysis_item *SequenceDiagram::itemForPosY(int ypos)
 {
     double key_pos = qRound(key_axis_->pixelToCoord(ypos));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
-        return data_->value(key_pos).value;
+    if (key_pos >= 0 && key_pos < data_.size()) {
+        return data_[(int) key_pos].value;
     }
     return NULL;
 }
@@ -212,7 +236,7 @@ double SequenceDiagram::selectTest(const QPointF &pos, bool, QVariant *) const
 {
     double key_pos = qRound(key_axis_->pixelToCoord(pos.y()));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
+    if (key_pos >= 0 && key_pos < data_.size()) {
         return 1.0;
     }
 
@@ -240,10 +264,12 @@ void SequenceDiagram::draw(QCPPainter *painter)
     painter->restore();
     fg_pen = pen();
 
-    WSCPSeqDataMap::const_iterator it;
-    for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-        double cur_key = it.key();
-        seq_analysis_item_t *sai = it.value().value;
+    // Only lay out the rows that can be seen. Keys are row numbers.
+    int first_key = qMax(qFloor(key_axis_->range().lower - 0.5), 0);
+    int last_key = qMin(qCeil(key_axis_->range().upper + 0.5), data_.size() - 1);
+    for (int key = first_key; key <= last_key; key++) {
+        double cur_key = data_[key].key;
+        seq_analysis_item_t *sai = data_[key].value;
         QColor bg_color;
 
         if (sai->frame_number == selected_packet_) {
@@ -366,18 +392,11 @@ QCPRange SequenceDiagram::getKeyRange(bool &validRange, QCP::SignDomain) const
     QCPRange range;
     bool valid = false;
 
-    WSCPSeqDataMap::const_iterator it = data_->constBegin();
-    while (it != data_->constEnd()) {
-        double cur_key = it.key();
-        if (!valid) {
-            range.lower = range.upper = cur_key;
-            valid = true;
-        } else if (cur_key < range.lower) {
-            range.lower = cur_key;
-        } else if (cur_key > range.upper) {
-            range.upper = cur_key;
-        }
-        ++it;
+    // Keys are assigned in increasing order
+    if (data_.size() > 0) {
+        range.lower = data_.first().key;
+        range.upper = data_.last().key;
+        valid = true;
     }
     validRange = valid;
     return range;
@@ -390,7 +409,7 @@ QCPRange SequenceDiagram::getValueRange(bool &validRange, QCP::SignDomain, const
 
     if (sainfo_) {
         range.lower = 0;
-        range.upper = data_->size();
+        range.upper = data_.size();
         valid = true;
     }
     validRange = valid;
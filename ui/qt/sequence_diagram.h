@@ -17,7 +17,8 @@
 #include <epan/address.h>
 
 #include <QObject>
-#include <QMultiMap>
+#include <QHash>
+#include <QVector>
 #include <ui/qt/widgets/qcustomplot.h>
 
 struct _seq_analysis_info;
@@ -33,7 +34,8 @@ public:
   struct _seq_analysis_item *value;
 };
 
-typedef QMultiMap<double, WSCPSeqData> WSCPSeqDataMap;
+// Displayed items, indexed by their key (row)
+typedef QVector<WSCPSeqData> WSCPSeqDataVector;
 
 class SequenceDiagram : public QCPAbstractPlottable
 {
@@ -55,7 +57,7 @@ public:
     struct _seq_analysis_item *itemForPosY(int ypos);
 
     // reimplemented virtual methods:
-    virtual void clearData() { data_->clear(); }
+    virtual void clearData() { data_.clear(); frame_keys_.clear(); }
     virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=0) const Q_DECL_OVERRIDE;
 
 public slots:
@@ -71,7 +73,8 @@ private:
     QCPAxis *key_axis_;
     QCPAxis *value_axis_;
     QCPAxis *comment_axis_;
-    WSCPSeqDataMap *data_;
+    WSCPSeqDataVector data_;
+    QHash<guint32, int> frame_keys_; // Frame number to first key
     struct _seq_analysis_info *sainfo_;
     guint32 selected_packet_;
     double selected_key_;
@@ -92,6 +92,9 @@ public:
         setText(SRT_COLUMN_MAX, QString::number(nstime_to_sec(&procedure_->stats.max), 'f', 6));
         setText(SRT_COLUMN_AVG, QString::number(get_average(&procedure_->stats.tot, procedure_->stats.num) / 1000.0, 'f', 6));
         setText(SRT_COLUMN_SUM, QString::number(nstime_to_sec(&procedure_->stats.tot), 'f', 6));
+        setText(SRT_COLUMN_P50, QString::number(time_stat_percentile(&procedure_->stats, 50.0) / 1000.0, 'f', 6));
+        setText(SRT_COLUMN_P99, QString::number(time_stat_percentile(&procedure_->stats, 99.0) / 1000.0, 'f', 6));
+        setText(SRT_COLUMN_P999, QString::number(time_stat_percentile(&procedure_->stats, 99.9) / 1000.0, 'f', 6));
 
         for (int col = 0; col < columnCount(); col++) {
             if (col == SRT_COLUMN_PROCEDURE) continue;
@@ -123,6 +126,12 @@ public:
         }
         case SRT_COLUMN_SUM:
             return nstime_cmp(&procedure_->stats.tot, &other_row->procedure_->stats.tot) < 0;
+        case SRT_COLUMN_P50:
+            return time_stat_percentile(&procedure_->stats, 50.0) < time_stat_percentile(&other_row->procedure_->stats, 50.0);
+        case SRT_COLUMN_P99:
+            return time_stat_percentile(&procedure_->stats, 99.0) < time_stat_percentile(&other_row->procedure_->stats, 99.0);
+        case SRT_COLUMN_P999:
+            return time_stat_percentile(&procedure_->stats, 99.9) < time_stat_percentile(&other_row->procedure_->stats, 99.9);
         default:
             break;
         }
@@ -133,7 +142,10 @@ public:
         return QList<QVariant>() << QString(procedure_->procedure) << procedure_->proc_index << procedure_->stats.num
                                  << nstime_to_sec(&procedure_->stats.min) << nstime_to_sec(&procedure_->stats.max)
                                  << get_average(&procedure_->stats.tot, procedure_->stats.num) / 1000.0
-                                 << nstime_to_sec(&procedure_->stats.tot);
+                                 << nstime_to_sec(&procedure_->stats.tot)
+                                 << time_stat_percentile(&procedure_->stats, 50.0) / 1000.0
+                                 << time_stat_percentile(&procedure_->stats, 99.0) / 1000.0
+                                 << time_stat_percentile(&procedure_->stats, 99.9) / 1000.0;
     }
 private:
     const srt_procedure_t *procedure_;
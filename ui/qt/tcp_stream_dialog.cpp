@@ -351,6 +351,7 @@ TCPStreamDialog::TCPStreamDialog(QWidget *parent, capture_file *cf, tcp_graph_ty
     connect(sp, SIGNAL(axisClick(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)),
             this, SLOT(axisClicked(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)));
     connect(sp->yAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(transformYRange(QCPRange)));
+    connect(sp->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(xAxisRangeChanged(QCPRange)));
     disconnect(ui->buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
     this->setResult(QDialog::Accepted);
 }
@@ -526,6 +527,7 @@ void TCPStreamDialog::fillGraph(bool reset_axes, bool set_focus)
     tracer_->setGraph(NULL);
 
     // base_graph_ is always visible.
+    seq_series_.clear();
     for (int i = 0; i < sp->graphCount(); i++) {
         sp->graph(i)->data()->clear();
         sp->graph(i)->setVisible(i == 0 ? true : false);
@@ -611,6 +613,24 @@ void TCPStreamDialog::fillGraph(bool reset_axes, bool set_focus)
     default:
         break;
     }
+
+    if (!seq_series_.isEmpty()) {
+        // Start with everything if the axes are about to be rescaled.
+        QCPRange key_range = sp->xAxis->range();
+        if (reset_axes) {
+            bool found = false;
+            foreach (const SeqSeries &series, seq_series_) {
+                if (series.keys.isEmpty()) continue;
+                if (!found) {
+                    key_range = QCPRange(series.keys.first(), series.keys.last());
+                    found = true;
+                } else {
+                    key_range.expand(QCPRange(series.keys.first(), series.keys.last()));
+                }
+            }
+        }
+        decimateSeqSeries(key_range);
+    }
     sp->setEnabled(true);
 
     stream_desc_ = tr("%1 %2 pkts, %3 %4 %5 pkts, %6 ")
@@ -787,7 +807,7 @@ void TCPStreamDialog::fillStevens()
         rel_time.append(ts - ts_offset_);
         seq.append(seg->th_seq - seq_offset_);
     }
-    base_graph_->setData(rel_time, seq);
+    addSeqSeries(base_graph_, rel_time, seq);
 }
 
 void TCPStreamDialog::fillTcptrace()
@@ -881,17 +901,115 @@ void TCPStreamDialog::fillTcptrace()
             rwin.append(ackno + seg->th_win);
         }
     }
-    base_graph_->setData(pkt_time, pkt_seqnums);
-    ack_graph_->setData(ackrwin_time, ack);
-    seg_graph_->setData(sb_time, sb_center);
-    seg_eb_->setData(sb_span);
-    sack_graph_->setData(sack_time, sack_center);
-    sack_eb_->setData(sack_span);
-    sack2_graph_->setData(sack2_time, sack2_center);
-    sack2_eb_->setData(sack2_span);
-    rwin_graph_->setData(ackrwin_time, rwin);
-    dup_ack_graph_->setData(dup_ack_time, dup_ack);
-    zero_win_graph_->setData(zero_win_time, zero_win);
+    addSeqSeries(base_graph_, pkt_time, pkt_seqnums);
+    addSeqSeries(ack_graph_, ackrwin_time, ack);
+    addSeqSeries(seg_graph_, sb_time, sb_center, seg_eb_, sb_span);
+    addSeqSeries(sack_graph_, sack_time, sack_center, sack_eb_, sack_span);
+    addSeqSeries(sack2_graph_, sack2_time, sack2_center, sack2_eb_, sack2_span);
+    addSeqSeries(rwin_graph_, ackrwin_time, rwin);
+    addSeqSeries(dup_ack_graph_, dup_ack_time, dup_ack);
+    addSeqSeries(zero_win_graph_, zero_win_time, zero_win);
+}
+
+void TCPStreamDialog::addSeqSeries(QCPGraph *graph, const QVector<double> &keys, const QVector<double> &values,
+                                   QCPErrorBars *error_bars, const QVector<double> &spans)
+{
+    SeqSeries series;
+
+    series.graph = graph;
+    series.error_bars = error_bars;
+    if (std::is_sorted(keys.begin(), keys.end())) {
+        series.keys = keys;
+        series.values = values;
+        series.spans = spans;
+    } else {
+        // Time stamps can go backwards. QCustomPlot sorts its data by key,
+        // and so must we to look up the visible range.
+        std::vector<std::pair<double, int> > order;
+        order.reserve(keys.size());
+        for (int i = 0; i < keys.size(); i++) {
+            order.push_back(std::make_pair(keys[i], i));
+        }
+        std::sort(order.begin(), order.end());
+        for (size_t j = 0; j < order.size(); j++) {
+            int i = order[j].second;
+            series.keys.append(keys[i]);
+            series.values.append(values[i]);
+            if (error_bars) series.spans.append(spans[i]);
+        }
+    }
+    seq_series_.append(series);
+}
+
+// Hand QCustomPlot the points of each sequence number series that fall
+// within key_range (and one on either side, so that lines reach the
+// edges). If there are many more points than pixel columns, each column
+// is reduced to its first, lowest, highest and last points, which draws
+// the same envelope. Error bars in a column are merged into one that
+// spans them all.
+void TCPStreamDialog::decimateSeqSeries(const QCPRange &key_range)
+{
+    QCustomPlot *sp = ui->streamPlot;
+    int columns = qMax(1, sp->axisRect()->width());
+    double column_width = key_range.size() / columns;
+
+    foreach (const SeqSeries &series, seq_series_) {
+        const QVector<double> &keys = series.keys;
+        const QVector<double> &values = series.values;
+        bool have_spans = series.error_bars != NULL;
+        int start = int(std::lower_bound(keys.begin(), keys.end(), key_range.lower) - keys.begin());
+        int end = int(std::upper_bound(keys.begin(), keys.end(), key_range.upper) - keys.begin());
+        QVector<double> d_keys, d_values, d_spans;
+
+        if (start > 0) start--;
+        if (end < keys.size()) end++;
+
+        if (end - start <= columns * 4 || column_width <= 0.0) {
+            d_keys = keys.mid(start, end - start);
+            d_values = values.mid(start, end - start);
+            if (have_spans) d_spans = series.spans.mid(start, end - start);
+        } else {
+            int i = start;
+            while (i < end) {
+                qint64 column = qint64(floor((keys[i] - key_range.lower) / column_width));
+                int first = i, min_i = i, max_i = i;
+                double span = have_spans ? series.spans[i] : 0.0;
+                double low = values[i] - span;
+                double high = values[i] + span;
+
+                for (i++; i < end && qint64(floor((keys[i] - key_range.lower) / column_width)) == column; i++) {
+                    span = have_spans ? series.spans[i] : 0.0;
+                    if (values[i] - span < low) {
+                        low = values[i] - span;
+                        min_i = i;
+                    }
+                    if (values[i] + span > high) {
+                        high = values[i] + span;
+                        max_i = i;
+                    }
+                }
+
+                if (have_spans) {
+                    d_keys.append(keys[first]);
+                    d_values.append((low + high) / 2.0);
+                    d_spans.append((high - low) / 2.0);
+                } else {
+                    int picks[4] = { first, min_i, max_i, i - 1 };
+                    std::sort(picks, picks + 4);
+                    for (int j = 0; j < 4; j++) {
+                        if (j > 0 && picks[j] == picks[j - 1]) continue;
+                        d_keys.append(keys[picks[j]]);
+                        d_values.append(values[picks[j]]);
+                    }
+                }
+            }
+        }
+
+        series.graph->setData(d_keys, d_values, true);
+        if (have_spans) {
+            series.error_bars->setData(d_spans);
+        }
+    }
 }
 
 // If the current implementation of incorporating SACKs in goodput calc
@@ -1824,6 +1942,15 @@ void TCPStreamDialog::transformYRange(const QCPRange &y_range1)
 }
 
 // XXX - We have similar code in io_graph_dialog and packet_diagram. Should this be a common routine?
+void TCPStreamDialog::xAxisRangeChanged(const QCPRange &x_range)
+{
+    // Zooming and panning only change what the sequence number graphs
+    // show, not what we tapped, so there's no need to retap.
+    if (!seq_series_.isEmpty()) {
+        decimateSeqSeries(x_range);
+    }
+}
+
 void TCPStreamDialog::on_buttonBox_accepted()
 {
     QString file_name, extension;
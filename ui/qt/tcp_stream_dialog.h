@@ -90,6 +90,18 @@ private:
     QCPGraph *dup_ack_graph_;
     QCPGraph *zero_win_graph_;
     QCPItemTracer *tracer_;
+    // The sequence number graphs keep their full data here. QCustomPlot
+    // only gets what's in the visible time range, reduced to the highest
+    // and lowest points in each pixel column, so that streams with
+    // millions of segments stay responsive.
+    struct SeqSeries {
+        QCPGraph *graph;
+        QCPErrorBars *error_bars;
+        QVector<double> keys;
+        QVector<double> values;
+        QVector<double> spans;
+    };
+    QList<SeqSeries> seq_series_;
     QRectF axis_bounds_;
     guint32 packet_num_;
     QTransform y_axis_xfrm_;
@@ -135,6 +147,9 @@ private:
     void fillThroughput();
     void fillRoundTripTime();
     void fillWindowScale();
+    void addSeqSeries(QCPGraph *graph, const QVector<double> &keys, const QVector<double> &values,
+                      QCPErrorBars *error_bars = NULL, const QVector<double> &spans = QVector<double>());
+    void decimateSeqSeries(const QCPRange &key_range);
     QString streamDescription();
     bool compareHeaders(struct segment *seg);
     void toggleTracerStyle(bool force_default = false);
@@ -146,6 +161,7 @@ private slots:
     void mouseMoved(QMouseEvent *event);
     void mouseReleased(QMouseEvent *event);
     void transformYRange(const QCPRange &y_range1);
+    void xAxisRangeChanged(const QCPRange &x_range);
     void on_buttonBox_accepted();
     void on_graphTypeComboBox_currentIndexChanged(int index);
     void on_resetButton_clicked();
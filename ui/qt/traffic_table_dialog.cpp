@@ -225,9 +225,17 @@ void TrafficTableDialog::captureEvent(CaptureEvent e)
         {
         case CaptureEvent::Started:
             ui->displayFilterCheckBox->setEnabled(false);
+            for (int i = 0; i < ui->trafficTableTabWidget->count(); i++) {
+                TrafficTableTreeWidget *cur_tree = qobject_cast<TrafficTableTreeWidget *>(ui->trafficTableTabWidget->widget(i));
+                if (cur_tree) cur_tree->setRetapping(true);
+            }
             break;
         case CaptureEvent::Finished:
             ui->displayFilterCheckBox->setEnabled(true);
+            for (int i = 0; i < ui->trafficTableTabWidget->count(); i++) {
+                TrafficTableTreeWidget *cur_tree = qobject_cast<TrafficTableTreeWidget *>(ui->trafficTableTabWidget->widget(i));
+                if (cur_tree) cur_tree->setRetapping(false);
+            }
             break;
         default:
             break;
@@ -344,7 +352,8 @@ TrafficTableTreeWidget::TrafficTableTreeWidget(QWidget *parent, register_ct_t *t
     QTreeWidget(parent),
     table_(table),
     hash_(),
-    resolve_names_(false)
+    resolve_names_(false),
+    retapping_(false)
 {
     setRootIsDecorated(false);
     sortByColumn(0, Qt::AscendingOrder);
@@ -397,6 +406,14 @@ bool TrafficTableTreeWidget::hasNameResolution() const
     return false;
 }
 
+void TrafficTableTreeWidget::setRetapping(bool retapping)
+{
+    retapping_ = retapping;
+    if (!retapping_) {
+        updateItems();
+    }
+}
+
 void TrafficTableTreeWidget::setNameResolutionEnabled(bool enable)
 {
     if (resolve_names_ != enable) {
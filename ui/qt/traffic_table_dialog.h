@@ -56,6 +56,14 @@ public:
 
     bool hasNameResolution() const;
 
+    /** Rows are appended as they're tapped. While retapping we don't sort
+     * them, which would mean sorting every row on every tap update; we sort
+     * once when the retap is done.
+     *
+     * @param retapping true when a retap starts, false when it finishes.
+     */
+    void setRetapping(bool retapping);
+
 public slots:
     void setNameResolutionEnabled(bool enable);
 
@@ -68,6 +76,7 @@ protected:
     QString title_;
     conv_hash_t hash_;
     bool resolve_names_;
+    bool retapping_;
     QMenu ctx_menu_;
 
     // When adding rows, resize to contents up to this number.
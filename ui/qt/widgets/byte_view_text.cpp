@@ -58,7 +58,8 @@ ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWi
     show_ascii_(true),
     row_width_(recent.gui_bytes_view == BYTES_HEX ? 16 : 8),
     font_width_(0),
-    line_height_(0)
+    line_height_(0),
+    x_pos_partial_(false)
 {
     layout_->setCacheEnabled(true);
 
@@ -190,6 +191,7 @@ void ByteViewText::setMonospaceFont(const QFont &mono_font)
     layout_->setFont(int_font);
 
     updateLayoutMetrics();
+    x_pos_to_column_.clear();
 
     updateScrollbars();
     viewport()->update();
@@ -198,15 +200,17 @@ void ByteViewText::setMonospaceFont(const QFont &mono_font)
 void ByteViewText::updateByteViewSettings()
 {
     row_width_ = recent.gui_bytes_view == BYTES_HEX ? 16 : 8;
+    x_pos_to_column_.clear();
 
     updateContextMenu();
     updateScrollbars();
     viewport()->update();
 }
 
-void ByteViewText::paintEvent(QPaintEvent *)
+void ByteViewText::paintEvent(QPaintEvent *event)
 {
     updateLayoutMetrics();
+    QRect dirty_rect = event->rect();
 
     QPainter painter(viewport());
     painter.translate(-horizontalScrollBar()->value() * font_width_, 0);
@@ -236,9 +240,16 @@ void ByteViewText::paintEvent(QPaintEvent *)
     int leading = fontMetrics().leading();
     painter.save();
 
-    x_pos_to_column_.clear();
+    if (x_pos_partial_) {
+        x_pos_to_column_.clear();
+        x_pos_partial_ = false;
+    }
     while ((int) (row_y + line_height_) < widget_height && offset < (int) data_.count()) {
-        drawLine(&painter, offset, row_y);
+        // Only lay out the lines that need repainting, e.g. the ones the
+        // hovered byte moved between.
+        if (row_y + line_height_ + leading > dirty_rect.top() && row_y <= dirty_rect.bottom()) {
+            drawLine(&painter, offset, row_y);
+        }
         offset += row_width_;
         row_y += line_height_ + leading;
     }
@@ -319,17 +330,23 @@ void ByteViewText::mouseMoveEvent(QMouseEvent *event)
         return;
     }
 
+    int old_hovered_byte_offset = hovered_byte_offset_;
     hovered_byte_offset_ = byteOffsetAtPixel(event->pos());
+    if (hovered_byte_offset_ == old_hovered_byte_offset) {
+        return;
+    }
     emit byteHovered(hovered_byte_offset_);
-    viewport()->update();
+    updateByteLine(old_hovered_byte_offset);
+    updateByteLine(hovered_byte_offset_);
 }
 
 void ByteViewText::leaveEvent(QEvent *event)
 {
+    int old_hovered_byte_offset = hovered_byte_offset_;
     hovered_byte_offset_ = -1;
     emit byteHovered(hovered_byte_offset_);
 
-    viewport()->update();
+    updateByteLine(old_hovered_byte_offset);
     QAbstractScrollArea::leaveEvent(event);
 }
 
@@ -402,7 +419,9 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
             /* insert a space every separator_interval_ bytes */
             if ((tvb_pos != offset) && ((tvb_pos % separator_interval_) == 0)) {
                 line += ' ';
-                x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset - 1, font_width_);
+                if (build_x_pos) {
+                    x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset - 1, font_width_);
+                }
             }
 
             switch (recent.gui_bytes_view) {
@@ -501,6 +520,11 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
     // XXX Fields won't be highlighted if neither hex nor ascii are enabled.
     addFormatRange(fmt_list, 0, offsetChars(), offset_mode);
 
+    // A short (last) line doesn't cover every column.
+    if (build_x_pos && max_tvb_pos - offset + 1 < row_width_) {
+        x_pos_partial_ = true;
+    }
+
     layout_->clearLayout();
     layout_->clearFormats();
     layout_->setText(line);
@@ -591,6 +615,21 @@ void ByteViewText::scrollToByte(int byte)
     verticalScrollBar()->setValue(byte / row_width_);
 }
 
+// Repaint the line holding a byte, if it's visible.
+void ByteViewText::updateByteLine(int byte)
+{
+    if (byte < 0 || line_height_ < 1) {
+        return;
+    }
+
+    int row = byte / row_width_ - verticalScrollBar()->value();
+    int row_height = line_height_ + fontMetrics().leading();
+    if (row < 0 || row * row_height >= viewport()->height()) {
+        return;
+    }
+    viewport()->update(0, row * row_height, viewport()->width(), row_height);
+}
+
 // Offset character width
 int ByteViewText::offsetChars(bool include_pad)
 {
@@ -84,6 +84,7 @@ private:
     bool addHexFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
     bool addAsciiFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
     void scrollToByte(int byte);
+    void updateByteLine(int byte);
     void updateScrollbars();
     int byteOffsetAtPixel(QPoint pos);
 
@@ -125,8 +126,9 @@ private:
     int line_height_;           // Font line spacing
     QList<QRect> hover_outlines_; // Hovered byte outlines.
 
-    // Data selection
+    // Data selection. Kept across paints, rebuilt when the metrics change.
     QVector<int> x_pos_to_column_;
+    bool x_pos_partial_;        // Built from a short line, rebuild on next paint
 
     // Context menu actions
     QAction *action_bytes_hex_;
@@ -15,8 +15,14 @@
 #include <ui/qt/utils/color_utils.h>
 
 static const double wf_graph_normal_width_ = 0.5;
+// Don't build levels smaller than this
+static const int wf_min_level_points_ = 2000;
 
-RtpAudioGraph::RtpAudioGraph(QCustomPlot *audio_plot, QRgb color)
+RtpAudioGraph::RtpAudioGraph(QCustomPlot *audio_plot, QRgb color) :
+    QObject(audio_plot),
+    audio_plot_(audio_plot),
+    points_per_key_(0.0),
+    cur_level_(0)
 {
     QPen p;
     QPalette sel_pal;
@@ -30,6 +36,8 @@ RtpAudioGraph::RtpAudioGraph(QCustomPlot *audio_plot, QRgb color)
     wave_->setSelectable(QCP::stNone);
     wave_->removeFromLegend();
     selection_color_ = sel_pal.color(QPalette::Highlight);
+
+    connect(audio_plot_, SIGNAL(beforeReplot()), this, SLOT(selectLevel()));
 }
 
 // Indicate that audio will not be hearable
@@ -68,25 +76,97 @@ void RtpAudioGraph::setSelected(bool isSelected)
     wave_->setPen(p);
 }
 
+// Build the decimated copies of the waveform once, so that zooming and
+// panning only has to switch between them.
 void RtpAudioGraph::setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
 {
-    wave_->setData(keys, values, alreadySorted);
+    QSharedPointer<QCPGraphDataContainer> level(new QCPGraphDataContainer);
+    QVector<QCPGraphData> points(qMin(keys.size(), values.size()));
+
+    for (int i = 0; i < points.size(); i++) {
+        points[i].key = keys[i];
+        points[i].value = values[i];
+    }
+    level->set(points, alreadySorted);
+
+    levels_.clear();
+    levels_ << level;
+    points_per_key_ = 0.0;
+    if (level->size() > 1) {
+        double span = (level->constEnd() - 1)->key - level->constBegin()->key;
+        if (span > 0.0) {
+            points_per_key_ = level->size() / span;
+        }
+    }
+
+    while (level->size() / 2 >= wf_min_level_points_) {
+        QSharedPointer<QCPGraphDataContainer> coarser(new QCPGraphDataContainer);
+        QVector<QCPGraphData> coarser_points;
+        QCPGraphDataContainer::const_iterator it = level->constBegin();
+
+        coarser_points.reserve(level->size() / 2 + 2);
+        while (it != level->constEnd()) {
+            QCPGraphDataContainer::const_iterator end = it + qMin(4, (int)(level->constEnd() - it));
+            QCPGraphDataContainer::const_iterator min_it = it;
+            QCPGraphDataContainer::const_iterator max_it = it;
+            for (QCPGraphDataContainer::const_iterator cur = it; cur != end; ++cur) {
+                if (cur->value < min_it->value) min_it = cur;
+                if (cur->value > max_it->value) max_it = cur;
+            }
+            // Keep the peaks in the order they occurred
+            if (min_it->key <= max_it->key) {
+                coarser_points << *min_it;
+                if (max_it != min_it) coarser_points << *max_it;
+            } else {
+                coarser_points << *max_it << *min_it;
+            }
+            it = end;
+        }
+        coarser->set(coarser_points, true);
+        levels_ << coarser;
+        level = coarser;
+    }
+
+    cur_level_ = -1;
+    selectLevel();
 }
 
 void RtpAudioGraph::remove(QCustomPlot *audioPlot)
 {
     audioPlot->removeGraph(wave_);
+    wave_ = NULL;
 }
 
 bool RtpAudioGraph::isMyPlottable(QCPAbstractPlottable *plottable)
 {
-    if (plottable == wave_) {
+    if (plottable == wave_.data()) {
         return true;
     } else {
         return false;
     }
 }
 
+// Show the coarsest level that still has about two points per pixel
+// in the visible range.
+void RtpAudioGraph::selectLevel()
+{
+    if (!wave_ || levels_.isEmpty()) return;
+
+    int level = 0;
+    double visible_points = audio_plot_->xAxis->range().size() * points_per_key_;
+    double wanted_points = qMax(audio_plot_->axisRect()->width(), 1) * 2.0;
+
+    while (level < levels_.size() - 1 && visible_points / 2 >= wanted_points) {
+        visible_points /= 2;
+        level++;
+    }
+
+    if (level != cur_level_) {
+        wave_->setData(levels_[level]);
+        cur_level_ = level;
+    }
+}
+
 
 /*
  * Editor modelines
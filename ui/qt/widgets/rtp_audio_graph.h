@@ -14,6 +14,8 @@
 
 #include <ui/qt/widgets/qcustomplot.h>
 
+#include <QPointer>
+
 //class QCPItemStraightLine;
 //class QCPAxisTicker;
 //class QCPAxisTickerDateTime;
@@ -32,9 +34,18 @@ public:
 
 
 private:
-  QCPGraph *wave_;
+  QCustomPlot *audio_plot_;
+  QPointer<QCPGraph> wave_; // Owned by the plot
   QRgb color_;
   QColor selection_color_;
+  // levels_[0] holds the waveform as set, every following level keeps
+  // the minimum and maximum of each four points of the previous one.
+  QVector<QSharedPointer<QCPGraphDataContainer> > levels_;
+  double points_per_key_; // Density of levels_[0]
+  int cur_level_;
+
+private slots:
+  void selectLevel();
 };
 
 #endif // RTP_AUDIO_GRAPH_H
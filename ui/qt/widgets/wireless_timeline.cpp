@@ -68,16 +68,48 @@ public:
             (int) (255*(blue * fraction + base))) { }
 };
 
-static void reset_rgb(float rgb[TIMELINE_HEIGHT][3])
+/* Sub-pixel frames are accumulated as per-row color deltas: each frame
+ * only touches the first and one-past-last row it covers, and the rows
+ * are resolved once per rendered pixel. This keeps the cost per frame
+ * constant, which matters when zoomed out and thousands of frames fall
+ * within a single pixel. Every frame covers the rows just above the
+ * center line, so the touched rows are always the contiguous range
+ * [top, bottom).
+ */
+struct pixel_accumulator {
+    float delta[TIMELINE_HEIGHT+1][3];
+    int top;
+    int bottom;
+};
+
+static void reset_rgb(struct pixel_accumulator *acc)
 {
     int i;
-    for (i = 0; i < TIMELINE_HEIGHT; i++)
-        rgb[i][0] = rgb[i][1] = rgb[i][2] = 1.0;
+    for (i = 0; i <= TIMELINE_HEIGHT; i++)
+        acc->delta[i][0] = acc->delta[i][1] = acc->delta[i][2] = 0.0;
+    acc->top = TIMELINE_HEIGHT;
+    acc->bottom = 0;
 }
 
-static void render_pixels(QPainter &p, gint x, gint width, float rgb[TIMELINE_HEIGHT][3], float ratio)
+static void render_pixels(QPainter &p, gint x, gint width, struct pixel_accumulator *acc, float ratio)
 {
+    float rgb[TIMELINE_HEIGHT][3];
+    float r = 1.0, g = 1.0, b = 1.0;
     int previous = 0, i;
+
+    for (i = 0; i < TIMELINE_HEIGHT; i++) {
+        if (i < acc->top || i >= acc->bottom) {
+            rgb[i][0] = rgb[i][1] = rgb[i][2] = 1.0;
+            continue;
+        }
+        r += acc->delta[i][0];
+        g += acc->delta[i][1];
+        b += acc->delta[i][2];
+        rgb[i][0] = r;
+        rgb[i][1] = g;
+        rgb[i][2] = b;
+    }
+
     for (i = 1; i <= TIMELINE_HEIGHT; i++) {
         if (i != TIMELINE_HEIGHT &&
                 rgb[previous][0] == rgb[i][0] &&
@@ -89,7 +121,7 @@ static void render_pixels(QPainter &p, gint x, gint width, float rgb[TIMELINE_HE
         }
         previous = i;
     }
-    reset_rgb(rgb);
+    reset_rgb(acc);
 }
 
 static void render_rectangle(QPainter &p, gint x, gint width, guint height, int dfilter, float r, float g, float b, float ratio)
@@ -97,14 +129,22 @@ static void render_rectangle(QPainter &p, gint x, gint width, guint height, int
     p.fillRect(QRectF(x/ratio, TIMELINE_HEIGHT/2-height, width/ratio, dfilter ? height * 2 : height), pcolor(r,g,b));
 }
 
-static void accumulate_rgb(float rgb[TIMELINE_HEIGHT][3], int height, int dfilter, float width, float red, float green, float blue)
+static void accumulate_rgb(struct pixel_accumulator *acc, int height, int dfilter, float width, float red, float green, float blue)
 {
-    int i;
-    for (i = TIMELINE_HEIGHT/2-height; i < (TIMELINE_HEIGHT/2 + (dfilter ? height : 0)); i++) {
-        rgb[i][0] = rgb[i][0] - width + width * red;
-        rgb[i][1] = rgb[i][1] - width + width * green;
-        rgb[i][2] = rgb[i][2] - width + width * blue;
-    }
+    int top = TIMELINE_HEIGHT/2-height;
+    int bottom = TIMELINE_HEIGHT/2 + (dfilter ? height : 0);
+
+    acc->delta[top][0] += width * (red - 1);
+    acc->delta[top][1] += width * (green - 1);
+    acc->delta[top][2] += width * (blue - 1);
+    acc->delta[bottom][0] -= width * (red - 1);
+    acc->delta[bottom][1] -= width * (green - 1);
+    acc->delta[bottom][2] -= width * (blue - 1);
+
+    if (top < acc->top)
+        acc->top = top;
+    if (bottom > acc->bottom)
+        acc->bottom = bottom;
 }
 
 
@@ -268,6 +308,11 @@ void WirelessTimeline::captureFileReadFinished()
         }
     }
 
+    radio_frames.resize(cfile.count);
+    for (guint32 n = 1; n <= cfile.count; n++) {
+        radio_frames[n-1] = (struct wlan_radio*)g_hash_table_lookup(radio_packet_list, GUINT_TO_POINTER(n));
+    }
+
     first = get_wlan_radio(1);
     last = get_wlan_radio(cfile.count);
 
@@ -347,6 +392,7 @@ void WirelessTimeline::tap_timeline_reset(void* tapdata)
         g_hash_table_destroy(timeline->radio_packet_list);
     }
     timeline->hide();
+    timeline->radio_frames.clear();
 
     timeline->radio_packet_list = g_hash_table_new(g_direct_hash, g_direct_equal);
 }
@@ -363,6 +409,9 @@ tap_packet_status WirelessTimeline::tap_timeline_packet(void *tapdata, packet_in
 
 struct wlan_radio* WirelessTimeline::get_wlan_radio(guint32 packet_num)
 {
+    if (packet_num > 0 && packet_num <= (guint32) radio_frames.size())
+        return radio_frames.at(packet_num-1);
+
     return (struct wlan_radio*)g_hash_table_lookup(radio_packet_list, GUINT_TO_POINTER(packet_num));
 }
 
@@ -490,8 +539,8 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
     int last_x=-1;
     int left = qpe->rect().left()*ratio;
     int right = qpe->rect().right()*ratio;
-    float rgb[TIMELINE_HEIGHT][3];
-    reset_rgb(rgb);
+    struct pixel_accumulator acc;
+    reset_rgb(&acc);
 
     zoom = ((double) width())/(end_tsf - start_tsf) * ratio;
 
@@ -550,7 +599,7 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
         /* is there a previous anti-aliased pixel to output */
         if (last_x >= 0 && ((int) x) != last_x) {
             /* write it out now */
-            render_pixels(p, last_x, 1, rgb, ratio);
+            render_pixels(p, last_x, 1, &acc, ratio);
             last_x = -1;
         }
 
@@ -595,14 +644,14 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
              * with all other sub pixels that fall within this
              * pixel */
             last_x = x;
-            accumulate_rgb(rgb, height, fdata->passed_dfilter, width, red, green, blue);
+            accumulate_rgb(&acc, height, fdata->passed_dfilter, width, red, green, blue);
         } else {
             /* it spans more than 1 pixel.
              * first accumulate the part that does fit */
             float partial = ((int) x) + 1 - x;
-            accumulate_rgb(rgb, height, fdata->passed_dfilter, partial, red, green, blue);
+            accumulate_rgb(&acc, height, fdata->passed_dfilter, partial, red, green, blue);
             /* and render it */
-            render_pixels(p, (int) x, 1, rgb, ratio);
+            render_pixels(p, (int) x, 1, &acc, ratio);
             last_x = -1;
             x += partial;
             width -= partial;
@@ -615,7 +664,7 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
             /* is there a partial pixel left */
             if (width > 0.0) {
                 last_x = x;
-                accumulate_rgb(rgb, height, fdata->passed_dfilter, width, red, green, blue);
+                accumulate_rgb(&acc, height, fdata->passed_dfilter, width, red, green, blue);
             }
         }
     }
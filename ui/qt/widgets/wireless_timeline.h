@@ -34,6 +34,7 @@
 #include <epan/dissectors/packet-ieee80211-radio.h>
 
 #include <QScrollArea>
+#include <QVector>
 
 #include "cfile.h"
 
@@ -93,6 +94,9 @@ protected:
     capture_file *capfile;
 
     GHashTable* radio_packet_list;
+    /* radio_packet_list flattened by frame number once the file has been
+     * read, so painting and searching don't need a hash lookup per frame */
+    QVector<struct wlan_radio *> radio_frames;
 
 protected slots:
     void selectedFrameChanged(QList<int>);
@@ -98,6 +98,7 @@ struct _rtpstream_tapinfo {
     FILE              *save_file;
     gboolean           is_registered; /**< if the tap listener is currently registered or not */
     gboolean           apply_display_filter; /**< if apply display filter during analyse */
+    GHashTable        *strinfo_hash; /**< rtpstream_info_t* of strinfo_list by id, used while tapping */
 };
 
 #if 0
@@ -70,6 +70,13 @@ gboolean rtpstream_id_equal(const rtpstream_id_t *id1, const rtpstream_id_t *id2
  */
 gboolean rtpstream_id_equal_pinfo_rtp_info(const rtpstream_id_t *id, const packet_info *pinfo, const struct _rtp_info *rtp_info);
 
+/**
+ * Get hash of rtpstream_id_t
+ * - hashes src_addr, dst_addr, src_port, dst_port and ssrc, so ids that are
+ *   equal with RTPSTREAM_ID_EQUAL_SSRC hash the same
+ */
+guint rtpstream_id_hash(const rtpstream_id_t *id);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
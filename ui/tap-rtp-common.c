@@ -157,6 +157,10 @@ void rtpstream_reset(rtpstream_tapinfo_t *tapinfo)
         }
         g_list_free(tapinfo->strinfo_list);
         tapinfo->strinfo_list = NULL;
+        if (tapinfo->strinfo_hash) {
+            g_hash_table_destroy(tapinfo->strinfo_hash);
+            tapinfo->strinfo_hash = NULL;
+        }
         tapinfo->nstreams = 0;
         tapinfo->npackets = 0;
     }
@@ -358,6 +362,18 @@ static void rtp_write_sample(rtpdump_info_t* rtpdump_info, FILE* file)
 }
 
 
+/****************************************************************************/
+/* GHashFunc/GEqualFunc for the strinfo_hash of rtpstream_tapinfo_t */
+static guint rtpstream_info_id_hash(gconstpointer key)
+{
+    return rtpstream_id_hash((const rtpstream_id_t *)key);
+}
+
+static gboolean rtpstream_info_id_equal(gconstpointer a, gconstpointer b)
+{
+    return rtpstream_id_equal((const rtpstream_id_t *)a, (const rtpstream_id_t *)b, RTPSTREAM_ID_EQUAL_SSRC);
+}
+
 /****************************************************************************/
 /* whenever a RTP packet is seen by the tap listener */
 tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissect_t *edt _U_, const void *arg2)
@@ -366,7 +382,6 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
     const struct _rtp_info *rtpinfo = (const struct _rtp_info *)arg2;
     rtpstream_info_t new_stream_info;
     rtpstream_info_t *stream_info = NULL;
-    GList* list;
     rtpdump_info_t rtpdump_info;
 
     struct _rtp_conversation_info *p_conv_data = NULL;
@@ -374,7 +389,10 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
     /* gather infos on the stream this packet is part of.
      * Addresses and strings are read-only and must be duplicated if copied. */
     rtpstream_info_init(&new_stream_info);
-    rtpstream_id_copy_pinfo(pinfo,&(new_stream_info.id),FALSE);
+    copy_address_shallow(&(new_stream_info.id.src_addr), &(pinfo->src));
+    new_stream_info.id.src_port = pinfo->srcport;
+    copy_address_shallow(&(new_stream_info.id.dst_addr), &(pinfo->dst));
+    new_stream_info.id.dst_port = pinfo->destport;
     new_stream_info.id.ssrc = rtpinfo->info_sync_src;
     new_stream_info.first_payload_type = rtpinfo->info_payload_type;
     new_stream_info.first_payload_type_name = rtpinfo->info_payload_type_str;
@@ -385,17 +403,11 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
             return TAP_PACKET_DONT_REDRAW;
         }
 
-        /* check whether we already have a stream with these parameters in the list */
-        list = g_list_first(tapinfo->strinfo_list);
-        while (list)
-        {
-            if (rtpstream_info_cmp(&new_stream_info, (rtpstream_info_t *)(list->data))==0)
-            {
-                stream_info = (rtpstream_info_t *)(list->data);  /*found!*/
-                break;
-            }
-            list = g_list_next(list);
+        /* check whether we already have a stream with these parameters */
+        if (!tapinfo->strinfo_hash) {
+            tapinfo->strinfo_hash = g_hash_table_new(rtpstream_info_id_hash, rtpstream_info_id_equal);
         }
+        stream_info = (rtpstream_info_t *)g_hash_table_lookup(tapinfo->strinfo_hash, &(new_stream_info.id));
 
         /* not in the list? then create a new entry */
         if (!stream_info) {
@@ -419,6 +431,7 @@ tap_packet_status rtpstream_packet_cb(void *arg, packet_info *pinfo, epan_dissec
             stream_info = rtpstream_info_malloc_and_init();
             rtpstream_info_copy_deep(stream_info, &new_stream_info);
             tapinfo->strinfo_list = g_list_prepend(tapinfo->strinfo_list, stream_info);
+            g_hash_table_insert(tapinfo->strinfo_hash, &(stream_info->id), stream_info);
         }
 
         /* get RTP stats for the packet */
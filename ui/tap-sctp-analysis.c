@@ -37,6 +37,11 @@
 
 static sctp_allassocs_info_t sctp_tapinfo_struct = {0, NULL, FALSE, NULL};
 
+/* The associations in sctp_tapinfo_struct.assoc_info_list, by assoc_id,
+ * and the last one in the list, so that adding one takes constant time. */
+static GHashTable *assoc_info_table = NULL;
+static GList *assoc_info_last = NULL;
+
 static void
 free_first(gpointer data, gpointer user_data _U_)
 {
@@ -169,6 +174,9 @@ reset(void *arg)
     g_list_free(tapdata->assoc_info_list);
     tapdata->sum_tvbs = 0;
     tapdata->assoc_info_list = NULL;
+    assoc_info_last = NULL;
+    if (assoc_info_table)
+        g_hash_table_remove_all(assoc_info_table);
 }
 
 
@@ -226,96 +234,80 @@ calc_checksum(const struct _sctp_info *check_data, sctp_assoc_info_t *data)
 static sctp_assoc_info_t *
 find_assoc(sctp_tmp_info_t *needle)
 {
-    sctp_allassocs_info_t *assoc_info;
-    sctp_assoc_info_t *info = NULL;
-    GList* list;
+    if (!assoc_info_table)
+        return NULL;
 
-    assoc_info = &sctp_tapinfo_struct;
-    if ((list = g_list_last(assoc_info->assoc_info_list))!=NULL)
-    {
-        while (list)
-        {
-            info = (sctp_assoc_info_t*)(list->data);
-            if (needle->assoc_id == info->assoc_id)
-                return info;
+    return (sctp_assoc_info_t *)g_hash_table_lookup(assoc_info_table, GUINT_TO_POINTER(needle->assoc_id));
+}
 
-            list = g_list_previous(list);
-        }
-    }
-    return NULL;
+static void
+append_assoc(sctp_assoc_info_t *info)
+{
+    if (!assoc_info_table)
+        assoc_info_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    assoc_info_last = g_list_append(assoc_info_last, info);
+    if (!sctp_tapinfo_struct.assoc_info_list)
+        sctp_tapinfo_struct.assoc_info_list = assoc_info_last;
+    else
+        assoc_info_last = assoc_info_last->next;
+    g_hash_table_insert(assoc_info_table, GUINT_TO_POINTER(info->assoc_id), info);
 }
 
-static sctp_assoc_info_t *
-add_chunk_count(address *vadd, sctp_assoc_info_t *info, guint32 direction, guint32 type)
+/*
+ * The per-address chunk counts of one source address in one direction.
+ * All the chunks of a packet go to the same one, so it's looked up once
+ * per packet rather than once per chunk.
+ */
+static sctp_addr_chunk *
+get_addr_chunk(address *vadd, sctp_assoc_info_t *info, guint32 direction)
 {
     GList *list;
     sctp_addr_chunk *ch=NULL;
-    int i;
-
-    list = g_list_first(info->addr_chunk_count);
 
-    while (list)
+    for (list = g_list_first(info->addr_chunk_count); list; list = g_list_next(list))
     {
         ch = (sctp_addr_chunk *)(list->data);
-        if (ch->direction == direction)
-        {
-            if (addresses_equal(vadd, &ch->addr))
-            {
-                if (IS_SCTP_CHUNK_TYPE(type))
-                    ch->addr_count[type]++;
-                else
-                    ch->addr_count[OTHER_CHUNKS_INDEX]++;
-                return info;
-            }
-            else
-            {
-                list = g_list_next(list);
-            }
-        }
-        else
-            list = g_list_next(list);
+        if (ch->direction == direction && addresses_equal(vadd, &ch->addr))
+            return ch;
     }
-    ch = g_new(sctp_addr_chunk, 1);
+    ch = g_new0(sctp_addr_chunk, 1);
     ch->direction = direction;
     copy_address(&ch->addr, vadd);
-    for (i=0; i < NUM_CHUNKS; i++)
-        ch->addr_count[i] = 0;
-
-    if (IS_SCTP_CHUNK_TYPE(type))
-        ch->addr_count[type]++;
-    else
-        ch->addr_count[OTHER_CHUNKS_INDEX]++;
 
     info->addr_chunk_count = g_list_append(info->addr_chunk_count, ch);
-    return info;
+    return ch;
 }
 
 static sctp_assoc_info_t *
-add_address(address *vadd, sctp_assoc_info_t *info, guint16 direction)
+add_address(const address *vadd, sctp_assoc_info_t *info, guint16 direction)
 {
     GList *list;
     address *v=NULL;
 
     if (direction == 1)
         list = g_list_first(info->addr1);
-    else
+    else if (direction == 2)
         list = g_list_first(info->addr2);
+    else
+        return info;
 
     while (list)
     {
         v = (address *) (list->data);
         if (addresses_equal(vadd, v)) {
-            free_address(vadd);
-            g_free(vadd);
             return info;
         }
         list = g_list_next(list);
     }
 
+    /* Only copy addresses we haven't seen before. */
+    v = g_new(address, 1);
+    copy_address(v, vadd);
     if (direction == 1)
-        info->addr1 = g_list_append(info->addr1, vadd);
-    else if (direction==2)
-        info->addr2 = g_list_append(info->addr2, vadd);
+        info->addr1 = g_list_append(info->addr1, v);
+    else
+        info->addr2 = g_list_append(info->addr2, v);
 
     return info;
 }
@@ -329,7 +321,8 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
     sctp_assoc_info_t *info = NULL;
     sctp_error_info_t *error = NULL;
     guint16 type, length = 0;
-    address *store = NULL;
+    address param_addr;
+    sctp_addr_chunk *addr_chunk = NULL;
     tsn_t *tsn = NULL;
     tsn_t *sack = NULL;
     guint8 *t_s_n = NULL;
@@ -511,15 +504,13 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                     type = tvb_get_ntohs(sctp_info->tvb[chunk_number],0);
                     if (type == IPV4ADDRESS_PARAMETER_ID)
                     {
-                        store = g_new(address, 1);
-                        alloc_address_tvb(NULL, store, AT_IPv4, 4, sctp_info->tvb[chunk_number], IPV4_ADDRESS_OFFSET);
-                        info = add_address(store, info, info->direction);
+                        set_address_tvb(&param_addr, AT_IPv4, 4, sctp_info->tvb[chunk_number], IPV4_ADDRESS_OFFSET);
+                        info = add_address(&param_addr, info, info->direction);
                     }
                     else if (type == IPV6ADDRESS_PARAMETER_ID)
                     {
-                        store = g_new(address, 1);
-                        alloc_address_tvb(NULL, store, AT_IPv6, 16, sctp_info->tvb[chunk_number], IPV6_ADDRESS_OFFSET);
-                        info = add_address(store, info, info->direction);
+                        set_address_tvb(&param_addr, AT_IPv6, 16, sctp_info->tvb[chunk_number], IPV6_ADDRESS_OFFSET);
+                        info = add_address(&param_addr, info, info->direction);
                     }
                 }
 
@@ -539,7 +530,7 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
 
                 info->chunk_count[idx]++;
                 info->ep1_chunk_count[idx]++;
-                info = add_chunk_count(&tmp_info.src, info, 1, idx);
+                get_addr_chunk(&tmp_info.src, info, 1)->addr_count[idx]++;
                 if (info->direction == 1) {
                     if (tvb_get_guint8(sctp_info->tvb[0],0) == SCTP_INIT_CHUNK_ID) {
                         info->dir1->init = TRUE;
@@ -581,9 +572,12 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                     if (!IS_SCTP_CHUNK_TYPE(idx))
                         idx = OTHER_CHUNKS_INDEX;
 
+                    if (!addr_chunk)
+                        addr_chunk = get_addr_chunk(&tmp_info.src, info, 1);
+
                     info->chunk_count[idx]++;
                     info->ep1_chunk_count[idx]++;
-                    info = add_chunk_count(&tmp_info.src, info, 1, idx);
+                    addr_chunk->addr_count[idx]++;
 
                     if ((tvb_get_guint8(sctp_info->tvb[chunk_number],0) == SCTP_DATA_CHUNK_ID) ||
                             (tvb_get_guint8(sctp_info->tvb[chunk_number],0) == SCTP_I_DATA_CHUNK_ID))
@@ -713,15 +707,11 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
             if (info->verification_tag1 != 0 || info->verification_tag2 != 0)
             {
                 guint32 number;
-                store = g_new(address, 1);
-                copy_address(store, &tmp_info.src);
-                info  = add_address(store, info, info->direction);
-                store = g_new(address, 1);
-                copy_address(store, &tmp_info.dst);
+                info  = add_address(&tmp_info.src, info, info->direction);
                 if (info->direction == 1)
-                    info = add_address(store, info, 2);
+                    info = add_address(&tmp_info.dst, info, 2);
                 else
-                    info = add_address(store, info, 1);
+                    info = add_address(&tmp_info.dst, info, 1);
                 number = pinfo->num;
                 info->frame_numbers=g_list_prepend(info->frame_numbers, GUINT_TO_POINTER(number));
                 if (datachunk || forwardchunk) {
@@ -732,7 +722,7 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                     info->sack2 = g_list_prepend(info->sack2, sack);
                     sack_used = TRUE;
                 }
-                sctp_tapinfo_struct.assoc_info_list = g_list_append(sctp_tapinfo_struct.assoc_info_list, info);
+                append_assoc(info);
             }
             else
             {
@@ -816,33 +806,16 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
         number = pinfo->num;
         info->frame_numbers=g_list_prepend(info->frame_numbers, GUINT_TO_POINTER(number));
 
-        store = g_new(address, 1);
-        copy_address(store, &tmp_info.src);
-
         switch (info->direction) {
             case 1:
-                info = add_address(store, info, 1);
+                info = add_address(&tmp_info.src, info, 1);
+                info = add_address(&tmp_info.dst, info, 2);
                 break;
             case 2:
-                info = add_address(store, info, 2);
+                info = add_address(&tmp_info.src, info, 2);
+                info = add_address(&tmp_info.dst, info, 1);
                 break;
             default:
-                g_free(store);
-                break;
-        }
-
-        store = g_new(address, 1);
-        copy_address(store, &tmp_info.dst);
-
-        switch (info->direction) {
-            case 1:
-                info = add_address(store, info, 2);
-                break;
-            case 2:
-                info = add_address(store, info, 1);
-                break;
-            default:
-                g_free(store);
                 break;
         }
 
@@ -883,21 +856,19 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                 info->ep1_chunk_count[idx]++;
             else
                 info->ep2_chunk_count[idx]++;
-            info = add_chunk_count(&tmp_info.src, info, info->direction, idx);
+            get_addr_chunk(&tmp_info.src, info, info->direction)->addr_count[idx]++;
             for (chunk_number = 1; chunk_number < sctp_info->number_of_tvbs; chunk_number++)
             {
                 type = tvb_get_ntohs(sctp_info->tvb[chunk_number],0);
                 if (type == IPV4ADDRESS_PARAMETER_ID)
                 {
-                    store = g_new(address, 1);
-                    alloc_address_tvb(NULL, store, AT_IPv4, 4, sctp_info->tvb[chunk_number], IPV4_ADDRESS_OFFSET);
-                    info = add_address(store, info, info->direction);
+                    set_address_tvb(&param_addr, AT_IPv4, 4, sctp_info->tvb[chunk_number], IPV4_ADDRESS_OFFSET);
+                    info = add_address(&param_addr, info, info->direction);
                 }
                 else if (type == IPV6ADDRESS_PARAMETER_ID)
                 {
-                    store = g_new(address, 1);
-                    alloc_address_tvb(NULL, store, AT_IPv6, 16, sctp_info->tvb[chunk_number], IPV6_ADDRESS_OFFSET);
-                    info = add_address(store, info, info->direction);
+                    set_address_tvb(&param_addr, AT_IPv6, 16, sctp_info->tvb[chunk_number], IPV6_ADDRESS_OFFSET);
+                    info = add_address(&param_addr, info, info->direction);
                 }
             }
             if (info->direction == 1) {
@@ -965,12 +936,15 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                 if (!IS_SCTP_CHUNK_TYPE(idx))
                     idx = OTHER_CHUNKS_INDEX;
 
+                if (!addr_chunk)
+                    addr_chunk = get_addr_chunk(&tmp_info.src, info, info->direction);
+
                 info->chunk_count[idx]++;
                 if (info->direction == 1)
                     info->ep1_chunk_count[idx]++;
                 else
                     info->ep2_chunk_count[idx]++;
-                info = add_chunk_count(&tmp_info.src, info,info->direction, idx);
+                addr_chunk->addr_count[idx]++;
 
                 if ((tvb_get_guint8(sctp_info->tvb[chunk_number],0) == SCTP_DATA_CHUNK_ID) ||
                         (tvb_get_guint8(sctp_info->tvb[chunk_number],0) == SCTP_I_DATA_CHUNK_ID))
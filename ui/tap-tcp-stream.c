@@ -31,7 +31,7 @@
 typedef struct _tcp_scan_t {
     int                     direction;
     struct tcp_graph       *tg;
-    struct segment         *last;
+    GArray                 *segments;
 } tcp_scan_t;
 
 
@@ -61,7 +61,11 @@ tapall_tcpip_packet(void *pct, packet_info *pinfo, epan_dissect_t *edt _U_, cons
                         ts->direction)
         && tg->stream == tcphdr->th_stream)
     {
-        struct segment *segment = g_new(struct segment, 1);
+        struct segment *segment;
+        int src_idx;
+
+        g_array_set_size(ts->segments, ts->segments->len + 1);
+        segment = &g_array_index(ts->segments, struct segment, ts->segments->len - 1);
         segment->next      = NULL;
         segment->num       = pinfo->num;
         segment->rel_secs  = (guint32)pinfo->rel_ts.secs;
@@ -77,8 +81,18 @@ tapall_tcpip_packet(void *pct, packet_info *pinfo, epan_dissect_t *edt _U_, cons
         segment->th_sport  = tcphdr->th_sport;
         segment->th_dport  = tcphdr->th_dport;
         segment->th_seglen = tcphdr->th_seglen;
-        copy_address(&segment->ip_src, &tcphdr->ip_src);
-        copy_address(&segment->ip_dst, &tcphdr->ip_dst);
+
+        /*
+         * Every segment of the stream goes from one of its endpoints to
+         * the other, so we only need one copy of each address.
+         */
+        if (tg->seg_addresses[0].type == AT_NONE) {
+            copy_address(&tg->seg_addresses[0], &tcphdr->ip_src);
+            copy_address(&tg->seg_addresses[1], &tcphdr->ip_dst);
+        }
+        src_idx = addresses_equal(&tcphdr->ip_src, &tg->seg_addresses[0]) ? 0 : 1;
+        copy_address_shallow(&segment->ip_src, &tg->seg_addresses[src_idx]);
+        copy_address_shallow(&segment->ip_dst, &tg->seg_addresses[1 - src_idx]);
 
         segment->num_sack_ranges = MIN(MAX_TCP_SACK_RANGES, tcphdr->num_sack_ranges);
         if (segment->num_sack_ranges > 0) {
@@ -86,13 +100,6 @@ tapall_tcpip_packet(void *pct, packet_info *pinfo, epan_dissect_t *edt _U_, cons
             memcpy(&segment->sack_left_edge, &tcphdr->sack_left_edge, sizeof(segment->sack_left_edge));
             memcpy(&segment->sack_right_edge, &tcphdr->sack_right_edge, sizeof(segment->sack_right_edge));
         }
-
-        if (ts->tg->segments) {
-            ts->last->next = segment;
-        } else {
-            ts->tg->segments = segment;
-        }
-        ts->last = segment;
     }
 
     return TAP_PACKET_DONT_REDRAW;
@@ -103,7 +110,9 @@ void
 graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
 {
     GString    *error_string;
+    gchar      *filter;
     tcp_scan_t  ts;
+    guint32     i;
 
     g_log(NULL, G_LOG_LEVEL_DEBUG, "graph_segment_list_get()");
 
@@ -112,13 +121,15 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
     }
 
     /* rescan all the packets and pick up all interesting tcp headers.
-     * we only filter for TCP here for speed and do the actual compare
-     * in the tap listener
+     * we only filter for the stream here for speed and do the actual
+     * compare in the tap listener
      */
     ts.direction = COMPARE_ANY_DIR;
     ts.tg      = tg;
-    ts.last    = NULL;
-    error_string = register_tap_listener("tcp", &ts, "tcp", 0, NULL, tapall_tcpip_packet, NULL, NULL);
+    ts.segments = g_array_new(FALSE, FALSE, sizeof(struct segment));
+    filter = g_strdup_printf("tcp.stream eq %u", tg->stream);
+    error_string = register_tap_listener("tcp", &ts, filter, 0, NULL, tapall_tcpip_packet, NULL, NULL);
+    g_free(filter);
     if (error_string) {
         fprintf(stderr, "wireshark: Couldn't register tcp_graph tap: %s\n",
                 error_string->str);
@@ -127,23 +138,26 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
     }
     cf_retap_packets(cf);
     remove_tap_listener(&ts);
+
+    /* The array won't grow any more, so the segments can be linked. */
+    tg->num_segments = ts.segments->len;
+    tg->segments = (struct segment *)g_array_free(ts.segments, tg->num_segments == 0);
+    for (i = 1; i < tg->num_segments; i++) {
+        tg->segments[i - 1].next = &tg->segments[i];
+    }
 }
 
 void
 graph_segment_list_free(struct tcp_graph *tg)
 {
-    struct segment *segment;
-
     free_address(&tg->src_address);
     free_address(&tg->dst_address);
+    free_address(&tg->seg_addresses[0]);
+    free_address(&tg->seg_addresses[1]);
 
-    while (tg->segments) {
-        segment = tg->segments->next;
-        free_address(&tg->segments->ip_src);
-        free_address(&tg->segments->ip_dst);
-        g_free(tg->segments);
-        tg->segments = segment;
-    }
+    g_free(tg->segments);
+    tg->segments = NULL;
+    tg->num_segments = 0;
 }
 
 int
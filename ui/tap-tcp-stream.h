@@ -60,8 +60,14 @@ struct tcp_graph {
     address          dst_address;
     guint16          dst_port;
     guint32          stream;
-    /* Should this be a map or tree instead? */
+    /* The segments are kept in one array, in the order they were tapped,
+     * and are also linked through their next pointers. */
     struct segment  *segments;
+    guint32          num_segments;
+    /* The two endpoint addresses of the stream. The ip_src and ip_dst
+     * addresses of each segment refer to these instead of holding copies
+     * of their own. */
+    address          seg_addresses[2];
 };
 
 /** Fill in the segment list for a TCP graph
@@ -31,8 +31,8 @@ export_pdu_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const
     wtap_rec rec;
     int err;
     gchar *err_info;
-    int buffer_len;
-    guint8 *packet_buf;
+    guint buffer_len;
+    const guint8 *packet_buf;
     tap_packet_status status = TAP_PACKET_DONT_REDRAW; /* no GUI, nothing to redraw */
 
     /*
@@ -42,13 +42,28 @@ export_pdu_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const
 
     memset(&rec, 0, sizeof rec);
     buffer_len = exp_pdu_data->tvb_captured_length + exp_pdu_data->tlv_buffer_len;
-    packet_buf = (guint8 *)g_malloc(buffer_len);
 
-    if(exp_pdu_data->tlv_buffer_len > 0){
-        memcpy(packet_buf, exp_pdu_data->tlv_buffer, exp_pdu_data->tlv_buffer_len);
-    }
-    if(exp_pdu_data->tvb_captured_length > 0){
-        tvb_memcpy(exp_pdu_data->pdu_tvb, packet_buf+exp_pdu_data->tlv_buffer_len, 0, exp_pdu_data->tvb_captured_length);
+    /*
+     * The record written is the tags followed by the PDU. wtap_dump()
+     * wants them in one piece, so they are put together in a buffer
+     * that is kept from one record to the next, except for a PDU
+     * without tags, which is written straight from its tvb.
+     */
+    if (exp_pdu_data->tlv_buffer_len == 0 && exp_pdu_data->tvb_captured_length > 0) {
+        packet_buf = tvb_get_ptr(exp_pdu_data->pdu_tvb, 0, exp_pdu_data->tvb_captured_length);
+    } else {
+        if (buffer_len > exp_pdu_tap_data->packet_buf_size) {
+            exp_pdu_tap_data->packet_buf_size = MAX(buffer_len, 2 * exp_pdu_tap_data->packet_buf_size);
+            exp_pdu_tap_data->packet_buf = (guint8 *)g_realloc(exp_pdu_tap_data->packet_buf,
+                                                               exp_pdu_tap_data->packet_buf_size);
+        }
+        if(exp_pdu_data->tlv_buffer_len > 0){
+            memcpy(exp_pdu_tap_data->packet_buf, exp_pdu_data->tlv_buffer, exp_pdu_data->tlv_buffer_len);
+        }
+        if(exp_pdu_data->tvb_captured_length > 0){
+            tvb_memcpy(exp_pdu_data->pdu_tvb, exp_pdu_tap_data->packet_buf+exp_pdu_data->tlv_buffer_len, 0, exp_pdu_data->tvb_captured_length);
+        }
+        packet_buf = exp_pdu_tap_data->packet_buf;
     }
     rec.rec_type                           = REC_TYPE_PACKET;
     rec.presence_flags                     = WTAP_HAS_CAP_LEN|WTAP_HAS_INTERFACE_ID|WTAP_HAS_TS|WTAP_HAS_PACK_FLAGS;
@@ -77,7 +92,6 @@ export_pdu_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const
         status = TAP_PACKET_FAILED;
     }
 
-    g_free(packet_buf);
     g_free(rec.opt_comment);
 
     return status;
@@ -96,6 +110,9 @@ exp_pdu_open(exp_pdu_t *exp_pdu_tap_data, char *pathname,
     gsize                        opt_len;
     gchar                       *opt_str;
 
+    exp_pdu_tap_data->packet_buf = NULL;
+    exp_pdu_tap_data->packet_buf_size = 0;
+
     /*
      * If the file format supports a section block, and the section
      * block supports comments, create data for it.
@@ -190,6 +207,9 @@ exp_pdu_close(exp_pdu_t *exp_pdu_tap_data, int *err, gchar **err_info)
 
     wtap_block_array_free(exp_pdu_tap_data->shb_hdrs);
     wtap_free_idb_info(exp_pdu_tap_data->idb_inf);
+    g_free(exp_pdu_tap_data->packet_buf);
+    exp_pdu_tap_data->packet_buf = NULL;
+    exp_pdu_tap_data->packet_buf_size = 0;
 
     remove_tap_listener(exp_pdu_tap_data);
     return status;
@@ -22,6 +22,8 @@ typedef struct _exp_pdu_t {
     GArray* shb_hdrs;
     wtapng_iface_descriptions_t* idb_inf;
     guint32      framenum;
+    guint8*      packet_buf;       /* reused for every record written */
+    guint        packet_buf_size;
 } exp_pdu_t;
 
 /**
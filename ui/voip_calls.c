@@ -452,7 +452,6 @@ static void insert_to_graph_t38(voip_calls_tapinfo_t *tapinfo, packet_info *pinf
 {
     seq_analysis_item_t *gai, *new_gai;
     GList    *list;
-    guint     item_num;
     gboolean  inserted;
     gchar     time_str[COL_MAX_LEN];
 
@@ -478,27 +477,26 @@ static void insert_to_graph_t38(voip_calls_tapinfo_t *tapinfo, packet_info *pinf
     new_gai->time_str = g_strdup(time_str);
     new_gai->display=FALSE;
 
-    item_num = 0;
     inserted = FALSE;
     if(tapinfo->graph_analysis){
-        list = g_queue_peek_nth_link(tapinfo->graph_analysis->items, 0);
+        /* Items are kept in frame order and the frame being inserted is
+         * almost always one of the latest, so search from the tail. */
+        list = g_queue_peek_tail_link(tapinfo->graph_analysis->items);
         while (list)
         {
             gai = (seq_analysis_item_t *)list->data;
-            if (gai->frame_number > frame_num) {
-                g_queue_insert_before(tapinfo->graph_analysis->items, list, new_gai);
-                g_hash_table_insert(tapinfo->graph_analysis->ht, GUINT_TO_POINTER(new_gai->frame_number), new_gai);
+            if (gai->frame_number <= frame_num) {
+                g_queue_insert_after(tapinfo->graph_analysis->items, list, new_gai);
                 inserted = TRUE;
                 break;
             }
-            list = g_list_next(list);
-            item_num++;
+            list = g_list_previous(list);
         }
 
         if (!inserted) {
-            g_queue_push_tail(tapinfo->graph_analysis->items, new_gai);
-            g_hash_table_insert(tapinfo->graph_analysis->ht, GUINT_TO_POINTER(new_gai->frame_number), new_gai);
+            g_queue_push_head(tapinfo->graph_analysis->items, new_gai);
         }
+        g_hash_table_insert(tapinfo->graph_analysis->ht, GUINT_TO_POINTER(new_gai->frame_number), new_gai);
     }
 }
 
@@ -921,11 +919,10 @@ t38_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, const
 
     voip_calls_info_t    *callsinfo             = NULL;
     voip_calls_info_t    *tmp_listinfo;
-    GList                *voip_calls_graph_list = NULL;
     GList                *list;
     gchar                *frame_label           = NULL;
     gchar                *comment               = NULL;
-    seq_analysis_item_t  *tmp_gai, *gai         = NULL;
+    seq_analysis_item_t  *gai                   = NULL;
     gchar                *tmp_str1, *tmp_str2;
     guint16               line_style            = 2;
     gdouble               duration;
@@ -941,16 +938,7 @@ t38_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt, const
     if  (t38_info->setup_frame_number != 0) {
         /* using the setup frame number of the T38 packet, we get the call number that it belongs */
         if(tapinfo->graph_analysis){
-            voip_calls_graph_list = g_queue_peek_nth_link(tapinfo->graph_analysis->items, 0);
-        }
-        while (voip_calls_graph_list)
-        {
-            tmp_gai = (seq_analysis_item_t *)voip_calls_graph_list->data;
-            if (t38_info->setup_frame_number == tmp_gai->frame_number) {
-                gai = tmp_gai;
-                break;
-            }
-            voip_calls_graph_list = g_list_next(voip_calls_graph_list);
+            gai = (seq_analysis_item_t *)g_hash_table_lookup(tapinfo->graph_analysis->ht, GUINT_TO_POINTER(t38_info->setup_frame_number));
         }
         if (gai) conv_num = (int) gai->conv_num;
     }
@@ -2638,7 +2626,6 @@ mgcp_calls_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt,
     voip_calls_info_t    *callsinfo    = NULL;
     mgcp_calls_info_t    *tmp_mgcpinfo = NULL;
     GList                *list;
-    GList                *listGraph    = NULL;
     gchar                *frame_label  = NULL;
     gchar                *comment      = NULL;
     seq_analysis_item_t  *gai          = NULL;
@@ -2702,29 +2689,24 @@ mgcp_calls_packet(void *tap_offset_ptr, packet_info *pinfo, epan_dissect_t *edt,
         /* if it is a response OR if it is a duplicated Request, lets look in the Graph to see
            if there is a request that matches */
         if(tapinfo->graph_analysis){
-            listGraph = g_queue_peek_nth_link(tapinfo->graph_analysis->items, 0);
+            gai = (seq_analysis_item_t *)g_hash_table_lookup(tapinfo->graph_analysis->ht, GUINT_TO_POINTER(pi->req_num));
         }
-        while (listGraph)
+        if (gai)
         {
-            gai = (seq_analysis_item_t *)listGraph->data;
-            if (gai->frame_number == pi->req_num) {
-                /* there is a request that match, so look the associated call with this call_num */
-                list = g_queue_peek_nth_link(tapinfo->callsinfos, 0);
-                while (list)
-                {
-                    tmp_listinfo=(voip_calls_info_t *)list->data;
-                    if (tmp_listinfo->protocol == VOIP_MGCP) {
-                        if (tmp_listinfo->call_num == gai->conv_num) {
-                            tmp_mgcpinfo = (mgcp_calls_info_t *)tmp_listinfo->prot_info;
-                            callsinfo = (voip_calls_info_t*)(list->data);
-                            break;
-                        }
+            /* there is a request that match, so look the associated call with this call_num */
+            list = g_queue_peek_nth_link(tapinfo->callsinfos, 0);
+            while (list)
+            {
+                tmp_listinfo=(voip_calls_info_t *)list->data;
+                if (tmp_listinfo->protocol == VOIP_MGCP) {
+                    if (tmp_listinfo->call_num == gai->conv_num) {
+                        tmp_mgcpinfo = (mgcp_calls_info_t *)tmp_listinfo->prot_info;
+                        callsinfo = (voip_calls_info_t*)(list->data);
+                        break;
                     }
-                    list = g_list_next (list);
                 }
-                if (callsinfo != NULL) break;
+                list = g_list_next (list);
             }
-            listGraph = g_list_next(listGraph);
         }
         /* if there is not a matching request, just return */
         if (callsinfo == NULL) return TAP_PACKET_DONT_REDRAW;
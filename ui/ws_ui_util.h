@@ -56,6 +56,7 @@ extern void pipe_input_set_handler(gint source, gpointer user_data, ws_process_i
 void packet_list_clear(void);
 void packet_list_freeze(void);
 void packet_list_recreate_visible_rows(void);
+void packet_list_show_rescanned(guint32 last_framenum);
 void packet_list_thaw(void);
 void packet_list_next(void);
 void packet_list_prev(void);
@@ -902,6 +902,7 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 
 		file_set_random_access(wth->fh, FALSE, wth->fast_seek);
 		file_set_random_access(wth->random_fh, TRUE, wth->fast_seek);
+		wth->fast_seek_from_index = file_seek_index_load(wth->random_fh, filename);
 	}
 
 	/* 'type' is 1 greater than the array index */
@@ -1150,6 +1151,9 @@ fail:
 	return NULL;
 
 success:
+	/* We're done poking around in the file to see what it is;
+	   read the rest of it ahead in another thread, if asked to. */
+	file_set_read_ahead(wth->fh);
 	return wth;
 }
 
@@ -2161,6 +2165,8 @@ static gboolean wtap_dump_open_finish(wtap_dumper *wdh, int *err,
 static WFILE_T wtap_dump_file_open(wtap_dumper *wdh, const char *filename);
 static WFILE_T wtap_dump_file_fdopen(wtap_dumper *wdh, int fd);
 static int wtap_dump_file_close(wtap_dumper *wdh);
+static size_t wtap_dump_write_buf_size(void);
+static gboolean wtap_dump_file_flush_buf(wtap_dumper *wdh, int *err);
 
 static wtap_dumper *
 wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_type,
@@ -2216,6 +2222,14 @@ wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_t
 		return NULL;
 	}
 
+	/* We can read zstd and lz4 compressed files, but we can only
+	   write gzip compressed ones. */
+	if (compression_type != WTAP_UNCOMPRESSED &&
+	    compression_type != WTAP_GZIP_COMPRESSED) {
+		*err = WTAP_ERR_COMPRESSION_NOT_SUPPORTED;
+		return NULL;
+	}
+
 	/* Allocate a data structure for the output stream. */
 	wdh = g_new0(wtap_dumper, 1);
 	if (wdh == NULL) {
@@ -2224,6 +2238,7 @@ wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_t
 	}
 
 	wdh->file_type_subtype = file_type_subtype;
+	wdh->write_buf_size = wtap_dump_write_buf_size();
 	wdh->snaplen = params->snaplen;
 	wdh->encap = params->encap;
 	wdh->compression_type = compression_type;
@@ -2572,6 +2587,8 @@ wtap_dump(wtap_dumper *wdh, const wtap_rec *rec,
 gboolean
 wtap_dump_flush(wtap_dumper *wdh, int *err)
 {
+	if (!wtap_dump_file_flush_buf(wdh, err))
+		return FALSE;
 #ifdef HAVE_ZLIB
 	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
 		if (gzwfile_flush((GZWFILE_T)wdh->fh) == -1) {
@@ -2720,14 +2737,76 @@ wtap_dump_file_fdopen(wtap_dumper *wdh _U_, int fd)
 }
 #endif
 
+/*
+ * Size of the write-combining buffer for uncompressed output; the
+ * WIRESHARK_WTAP_WRITE_BUFFER environment variable, if set, gives it
+ * in bytes, with 0 meaning "don't buffer beyond what stdio does".
+ */
+#define WTAP_DUMP_WRITE_BUF_SIZE_DEFAULT	(256 * 1024)
+#define WTAP_DUMP_WRITE_BUF_SIZE_MAX		(64 * 1024 * 1024)
+
+static size_t
+wtap_dump_write_buf_size(void)
+{
+	static gint64 write_buf_size = -1;
+	const char *env;
+
+	if (write_buf_size == -1) {
+		env = getenv("WIRESHARK_WTAP_WRITE_BUFFER");
+		if (env != NULL)
+			write_buf_size = g_ascii_strtoll(env, NULL, 10);
+		else
+			write_buf_size = WTAP_DUMP_WRITE_BUF_SIZE_DEFAULT;
+		if (write_buf_size < 0)
+			write_buf_size = 0;
+		else if (write_buf_size > WTAP_DUMP_WRITE_BUF_SIZE_MAX)
+			write_buf_size = WTAP_DUMP_WRITE_BUF_SIZE_MAX;
+	}
+	return (size_t)write_buf_size;
+}
+
+/* write raw bytes straight to an uncompressed file */
+static gboolean
+wtap_dump_file_write_raw(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
+{
+	size_t nwritten;
+
+	errno = WTAP_ERR_CANT_WRITE;
+	nwritten = fwrite(buf, 1, bufsize, (FILE *)wdh->fh);
+	/*
+	 * At least according to the macOS man page,
+	 * this can return a short count on an error.
+	 */
+	if (nwritten != bufsize) {
+		if (ferror((FILE *)wdh->fh))
+			*err = errno;
+		else
+			*err = WTAP_ERR_SHORT_WRITE;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* write out whatever's in the write-combining buffer */
+static gboolean
+wtap_dump_file_flush_buf(wtap_dumper *wdh, int *err)
+{
+	size_t len = wdh->write_buf_len;
+
+	if (len == 0)
+		return TRUE;
+	wdh->write_buf_len = 0;
+	return wtap_dump_file_write_raw(wdh, wdh->write_buf, len, err);
+}
+
 /* internally writing raw bytes (compressed or not) */
 gboolean
 wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
 {
-	size_t nwritten;
-
 #ifdef HAVE_ZLIB
 	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
+		size_t nwritten;
+
 		nwritten = gzwfile_write((GZWFILE_T)wdh->fh, buf, (unsigned int) bufsize);
 		/*
 		 * gzwfile_write() returns 0 on error.
@@ -2736,23 +2815,34 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 			*err = gzwfile_geterr((GZWFILE_T)wdh->fh);
 			return FALSE;
 		}
-	} else
+		return TRUE;
+	}
 #endif
-	{
-		errno = WTAP_ERR_CANT_WRITE;
-		nwritten = fwrite(buf, 1, bufsize, (FILE *)wdh->fh);
+	if (wdh->write_buf == NULL && wdh->write_buf_size != 0) {
 		/*
-		 * At least according to the macOS man page,
-		 * this can return a short count on an error.
+		 * First write; only buffer if we're writing to a regular
+		 * file, so that anybody reading from a pipe or terminal
+		 * sees records as soon as they would without buffering.
 		 */
-		if (nwritten != bufsize) {
-			if (ferror((FILE *)wdh->fh))
-				*err = errno;
-			else
-				*err = WTAP_ERR_SHORT_WRITE;
+		ws_statb64 statb;
+
+		if (ws_fstat64(ws_fileno((FILE *)wdh->fh), &statb) == 0 &&
+		    S_ISREG(statb.st_mode))
+			wdh->write_buf = (guint8 *)g_malloc(wdh->write_buf_size);
+		else
+			wdh->write_buf_size = 0;
+	}
+	if (wdh->write_buf_size == 0)
+		return wtap_dump_file_write_raw(wdh, buf, bufsize, err);
+
+	if (bufsize > wdh->write_buf_size - wdh->write_buf_len) {
+		if (!wtap_dump_file_flush_buf(wdh, err))
 			return FALSE;
-		}
+		if (bufsize >= wdh->write_buf_size)
+			return wtap_dump_file_write_raw(wdh, buf, bufsize, err);
 	}
+	memcpy(wdh->write_buf + wdh->write_buf_len, buf, bufsize);
+	wdh->write_buf_len += bufsize;
 	return TRUE;
 }
 
@@ -2760,12 +2850,25 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 static int
 wtap_dump_file_close(wtap_dumper *wdh)
 {
+	int err;
+
 #ifdef HAVE_ZLIB
 	if (wdh->compression_type == WTAP_GZIP_COMPRESSED)
 		return gzwfile_close((GZWFILE_T)wdh->fh);
 	else
 #endif
+	{
+		if (!wtap_dump_file_flush_buf(wdh, &err)) {
+			g_free(wdh->write_buf);
+			wdh->write_buf = NULL;
+			fclose((FILE *)wdh->fh);
+			errno = err;
+			return EOF;
+		}
+		g_free(wdh->write_buf);
+		wdh->write_buf = NULL;
 		return fclose((FILE *)wdh->fh);
+	}
 }
 
 gint64
@@ -2778,6 +2881,8 @@ wtap_dump_file_seek(wtap_dumper *wdh, gint64 offset, int whence, int *err)
 	} else
 #endif
 	{
+		if (!wtap_dump_file_flush_buf(wdh, err))
+			return -1;
 		if (-1 == ws_fseek64((FILE *)wdh->fh, offset, whence)) {
 			*err = errno;
 			return -1;
@@ -2804,7 +2909,8 @@ wtap_dump_file_tell(wtap_dumper *wdh, int *err)
 			return -1;
 		} else
 		{
-			return rval;
+			/* Count what's still in the write-combining buffer. */
+			return rval + (gint64)wdh->write_buf_len;
 		}
 	}
 }
@@ -17,16 +17,29 @@
 #include <config.h>
 
 #include <errno.h>
+#include <stddef.h>
 #include <string.h>
 #include "wtap-int.h"
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #ifdef HAVE_ZLIB
 #define ZLIB_CONST
 #include <zlib.h>
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+#include <lz4frame.h>
+#endif /* HAVE_LZ4FRAME_H */
+
 /*
  * See RFC 1952:
  *
@@ -34,6 +47,17 @@
  *
  * for a description of the gzip file format.
  *
+ * See RFC 8878 and
+ *
+ *      https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md
+ *
+ * for descriptions of the zstd format and of the seekable variant of
+ * it, and
+ *
+ *      https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+ *
+ * for a description of the lz4 frame format.
+ *
  * Some other compressed file formats we might want to support:
  *
  *      XZ format: https://tukaani.org/xz/
@@ -53,17 +77,22 @@ static struct compression_type {
 } compression_types[] = {
 #ifdef HAVE_ZLIB
     { WTAP_GZIP_COMPRESSED, "gz", "gzip compressed" },
+#endif
+#ifdef HAVE_ZSTD
+    { WTAP_ZSTD_COMPRESSED, "zst", "zstd compressed" },
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    { WTAP_LZ4_COMPRESSED, "lz4", "lz4 compressed" },
 #endif
     { WTAP_UNCOMPRESSED, NULL, NULL }
 };
 
+static wtap_compression_type file_get_compression_type(FILE_T stream);
+
 wtap_compression_type
 wtap_get_compression_type(wtap *wth)
 {
-	gboolean is_compressed;
-
-	is_compressed = file_iscompressed((wth->fh == NULL) ? wth->random_fh : wth->fh);
-	return is_compressed ? WTAP_GZIP_COMPRESSED : WTAP_UNCOMPRESSED;
+	return file_get_compression_type((wth->fh == NULL) ? wth->random_fh : wth->fh);
 }
 
 const char *
@@ -105,13 +134,22 @@ wtap_get_all_compression_type_extensions_list(void)
 /* #define GZBUFSIZE 8192 */
 #define GZBUFSIZE 4096
 
+/* Largest buffer size that WIRESHARK_WTAP_READ_BUFFER can ask for */
+#define READ_BUFFER_SIZE_MAX (16 * 1024 * 1024)
+
 /* values for wtap_reader compression */
 typedef enum {
     UNKNOWN,       /* unknown - look for a gzip header */
     UNCOMPRESSED,  /* uncompressed - copy input directly */
 #ifdef HAVE_ZLIB
     ZLIB,          /* decompress a zlib stream */
-    GZIP_AFTER_HEADER
+    GZIP_AFTER_HEADER,
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD,          /* decompress a zstd frame */
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4,           /* decompress an lz4 frame */
 #endif
 } compression_t;
 
@@ -135,6 +173,7 @@ struct wtap_reader {
     gint64 raw;                 /* where the raw data started, for seeking */
     compression_t compression;  /* type of compression, if any */
     gboolean is_compressed;     /* FALSE if completely uncompressed, TRUE otherwise */
+    wtap_compression_type compression_type; /* type of compression seen, if any */
 
     /* seek request */
     gint64 skip;                /* amount to skip (already rewound if backwards) */
@@ -148,10 +187,30 @@ struct wtap_reader {
     /* zlib inflate stream */
     z_stream strm;              /* stream structure in-place (not a pointer) */
     gboolean dont_check_crc;    /* TRUE if we aren't supposed to check the CRC */
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zstd_dctx;    /* zstd decompression stream, if we've needed one */
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_decompressionContext_t lz4_dctx; /* lz4 decompression context, if we've needed one */
 #endif
     /* fast seeking */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
+
+    /* reading ahead in another thread */
+    gboolean want_read_ahead;   /* TRUE if we should be reading ahead */
+    gint64 read_ahead_after;    /* ...once we've gotten this far */
+    struct read_ahead *read_ahead; /* read-ahead state, if it's running */
+
+#ifdef HAVE_SYS_MMAN_H
+    /* memory-mapped input, for uncompressed regular files */
+    unsigned char *map;         /* start of the mapping, or NULL if not mapped */
+    gint64 map_size;            /* length of the mapping */
+    unsigned char *out_alloc;   /* our own output buffer, while out.buf points into the mapping */
+#endif
+
+    wtap_reader_stats stats;    /* see file_get_stats() */
 };
 
 /* Current read offset within a buffer. */
@@ -223,6 +282,8 @@ buf_read(FILE_T state, struct wtap_reader_buf *buf)
     }
     if (ret == 0)
         state->eof = TRUE;
+    state->stats.raw_reads++;
+    state->stats.raw_bytes += ret;
     state->raw_pos += ret;
     buf->avail += ret;
     return 0;
@@ -240,6 +301,117 @@ fill_in_buffer(FILE_T state)
     return 0;
 }
 
+#ifdef HAVE_SYS_MMAN_H
+/*
+ * Largest chunk of a mapped file we hand out as the output buffer at
+ * once; the offsets within a buffer are unsigned ints, so we can't
+ * hand out all of a file bigger than 4GB at once.
+ */
+#define MMAP_WINDOW_SIZE (1U << 30)
+
+/*
+ * Map an uncompressed regular file, if the user asked us to do so, so
+ * that reads are served straight from the mapping rather than being
+ * read() into the input buffer and then copied out of it.
+ *
+ * This is opt-in, as the mapping is a snapshot of the size of the file
+ * when it was opened; data appended afterwards (e.g., by dumpcap, while
+ * we're doing a live capture) is read with read() once we run off the
+ * end of the mapping.
+ */
+static void
+file_map(FILE_T state)
+{
+    static int use_mmap = -1;
+    ws_statb64 st;
+    void *map;
+
+    if (use_mmap == -1)
+        use_mmap = (getenv("WIRESHARK_WTAP_USE_MMAP") != NULL);
+    if (!use_mmap)
+        return;
+
+    if (state->start != 0)
+        return;
+    if (ws_fstat64(state->fd, &st) < 0 || !S_ISREG(st.st_mode))
+        return;
+    if (st.st_size <= 0 || (guint64)st.st_size > G_MAXSIZE)
+        return;
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, state->fd, 0);
+    if (map == MAP_FAILED)
+        return;
+
+    state->map = (unsigned char *)map;
+    state->map_size = st.st_size;
+    state->out_alloc = state->out.buf;
+}
+
+/*
+ * Stop using the mapping, and go back to reading into our own
+ * buffer; the next byte read will be the one at the current position.
+ */
+static void
+file_unmap(FILE_T state)
+{
+    if (state->map == NULL)
+        return;
+
+    if (state->out.buf != state->out_alloc) {
+        /* The output buffer is in the mapping; discard it, and
+           arrange that we next read what would have been next. */
+        state->raw_pos = state->out.next - state->map;
+        state->out.buf = state->out_alloc;
+        buf_reset(&state->out);
+        if (state->fd != -1)
+            (void)ws_lseek64(state->fd, state->raw_pos, SEEK_SET);
+    }
+    munmap(state->map, (size_t)state->map_size);
+    state->map = NULL;
+    state->map_size = 0;
+    state->out_alloc = NULL;
+}
+
+/*
+ * Refill the output buffer of an uncompressed mapped file; it's
+ * pointed at the next window of the mapping, rather than read into.
+ *
+ * Returns 0 if the output buffer now points into the mapping, or -1
+ * if we're past the end of the mapping, in which case the output
+ * buffer is our own again, ready for buf_read().
+ */
+static int
+map_read(FILE_T state)
+{
+    gint64 left = state->map_size - state->raw_pos;
+
+    if (left <= 0) {
+        /* The file may have grown since we mapped it; read the rest. */
+        if (state->out.buf != state->out_alloc) {
+            state->out.buf = state->out_alloc;
+            buf_reset(&state->out);
+        }
+        return -1;
+    }
+
+    state->out.buf = state->map + state->raw_pos;
+    state->out.next = state->out.buf;
+    state->out.avail = left > MMAP_WINDOW_SIZE ? MMAP_WINDOW_SIZE : (guint)left;
+    state->raw_pos += state->out.avail;
+
+    /* Keep the descriptor where a read() would have left it, for seeks
+       relative to it and for reading past the end of the mapping. */
+    if (ws_lseek64(state->fd, state->raw_pos, SEEK_SET) == -1) {
+        state->err = errno;
+        state->err_info = NULL;
+        state->out.buf = state->out_alloc;
+        buf_reset(&state->out);
+        return -1;
+    }
+    return 0;
+}
+#endif /* HAVE_SYS_MMAN_H */
+
 #define ZLIB_WINSIZE 32768
 
 struct fast_seek_point {
@@ -261,6 +433,13 @@ struct fast_seek_point {
     } data;
 };
 
+/*
+ * Only zlib seek points need the data; the others are allocated with
+ * just the part of the structure before it, as there can be one of them
+ * for every frame of a zstd or lz4 file.
+ */
+#define FAST_SEEK_POINT_HDR_SIZE    offsetof(struct fast_seek_point, data)
+
 struct zlib_cur_seek_point {
     unsigned char window[ZLIB_WINSIZE]; /* preceding 32K of uncompressed data */
     unsigned int pos;
@@ -268,6 +447,15 @@ struct zlib_cur_seek_point {
 };
 
 #define SPAN G_GINT64_CONSTANT(1048576)
+
+/*
+ * The sequential and random streams share the table of seek points, and
+ * both add to it; if the sequential stream is reading ahead, it does so
+ * in another thread, so all access to the tables is done with this held.
+ * The points themselves don't change once they're in a table.
+ */
+static GMutex fast_seek_mutex;
+
 static struct fast_seek_point *
 fast_seek_find(FILE_T file, gint64 pos)
 {
@@ -278,6 +466,7 @@ fast_seek_find(FILE_T file, gint64 pos)
     if (!file->fast_seek)
         return NULL;
 
+    g_mutex_lock(&fast_seek_mutex);
     for (low = 0, max = file->fast_seek->len; low < max; ) {
         i = (low + max) / 2;
         item = (struct fast_seek_point *)file->fast_seek->pdata[i];
@@ -288,9 +477,11 @@ fast_seek_find(FILE_T file, gint64 pos)
             smallest = item;
             low = i + 1;
         } else {
-            return item;
+            smallest = item;
+            break;
         }
     }
+    g_mutex_unlock(&fast_seek_mutex);
     return smallest;
 }
 
@@ -300,17 +491,43 @@ fast_seek_header(FILE_T file, gint64 in_pos, gint64 out_pos,
 {
     struct fast_seek_point *item = NULL;
 
+    g_mutex_lock(&fast_seek_mutex);
     if (file->fast_seek->len != 0)
         item = (struct fast_seek_point *)file->fast_seek->pdata[file->fast_seek->len - 1];
 
     if (!item || item->out < out_pos) {
-        struct fast_seek_point *val = g_new(struct fast_seek_point,1);
+        struct fast_seek_point *val = (struct fast_seek_point *)g_malloc(FAST_SEEK_POINT_HDR_SIZE);
         val->in = in_pos;
         val->out = out_pos;
         val->compression = compression;
 
         g_ptr_array_add(file->fast_seek, val);
     }
+    g_mutex_unlock(&fast_seek_mutex);
+}
+
+/*
+ * Is this a compression type where every frame is compressed
+ * independently, so that every frame start is a seek point from which
+ * we can start decompressing with a fresh decoder?
+ */
+static gboolean
+fast_seek_is_frame(
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+    compression_t compression)
+#else
+    compression_t compression _U_)
+#endif
+{
+#ifdef HAVE_ZSTD
+    if (compression == ZSTD)
+        return TRUE;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    if (compression == LZ4)
+        return TRUE;
+#endif
+    return FALSE;
 }
 
 static void
@@ -462,14 +679,17 @@ gz_skipzstr(FILE_T state)
 static void
 zlib_fast_seek_add(FILE_T file, struct zlib_cur_seek_point *point, int bits, gint64 in_pos, gint64 out_pos)
 {
-    /* it's for sure after gzip header, so file->fast_seek->len != 0 */
-    struct fast_seek_point *item = (struct fast_seek_point *)file->fast_seek->pdata[file->fast_seek->len - 1];
+    struct fast_seek_point *item;
 
 #ifndef HAVE_INFLATEPRIME
     if (bits)
         return;
 #endif
 
+    g_mutex_lock(&fast_seek_mutex);
+    /* it's for sure after gzip header, so file->fast_seek->len != 0 */
+    item = (struct fast_seek_point *)file->fast_seek->pdata[file->fast_seek->len - 1];
+
     /* Glib has got Balanced Binary Trees (GTree) but I couldn't find a way to do quick search for nearest (and smaller) value to seek (It's what fast_seek_find() do)
      *      Inserting value in middle of sorted array is expensive, so we want to add only in the end.
      *      It's not big deal, cause first-read don't usually invoke seeking
@@ -507,6 +727,7 @@ zlib_fast_seek_add(FILE_T file, struct zlib_cur_seek_point *point, int bits, gin
         val->data.zlib.total_out = (guint32) file->strm.total_out;
         g_ptr_array_add(file->fast_seek, val);
     }
+    g_mutex_unlock(&fast_seek_mutex);
 }
 
 static void /* gz_decomp */
@@ -642,6 +863,261 @@ DIAG_ON(cast-qual)
 }
 #endif
 
+#ifdef HAVE_ZSTD
+/*
+ * Magic numbers and sizes for the zstd seekable format's seek table,
+ * which is a skippable frame at the end of the file, ending with a
+ * 9-byte footer.
+ */
+#define ZSTD_SKIPPABLE_MAGIC_MASK   0xFFFFFFF0U
+#define ZSTD_SKIPPABLE_MAGIC        0x184D2A50U
+#define ZSTD_SEEK_TABLE_MAGIC       0x184D2A5EU
+#define ZSTD_SEEKABLE_MAGIC         0x8F92EAB1U
+#define ZSTD_SEEK_TABLE_FOOTER_SIZE 9
+#define ZSTD_SEEK_TABLE_MAX_FRAMES  (1U << 22)
+
+/*
+ * If this is a regular file in the zstd seekable format, add a seek
+ * point for the start of every frame in it, so that we can seek to
+ * any frame before we've read that far.
+ *
+ * "in_pos" and "out_pos" are the offsets of the first frame in the file
+ * and in the uncompressed data; we leave the file offset as we found it.
+ */
+static void
+zstd_load_seek_table(FILE_T state, gint64 in_pos, gint64 out_pos)
+{
+    ws_statb64 st;
+    gint64 cur;
+    guint8 footer[ZSTD_SEEK_TABLE_FOOTER_SIZE];
+    guint32 num_frames, entry_size, i;
+    gint64 entries_size;
+    guint8 *entries;
+    gboolean have_points;
+
+    if (state->fast_seek == NULL)
+        return;
+    g_mutex_lock(&fast_seek_mutex);
+    have_points = (state->fast_seek->len != 0);
+    g_mutex_unlock(&fast_seek_mutex);
+    if (have_points)
+        return;
+    if (ws_fstat64(state->fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        st.st_size < in_pos + 8 + ZSTD_SEEK_TABLE_FOOTER_SIZE)
+        return;
+    if ((cur = ws_lseek64(state->fd, 0, SEEK_CUR)) == -1)
+        return;
+
+    entries = NULL;
+    if (ws_lseek64(state->fd, st.st_size - ZSTD_SEEK_TABLE_FOOTER_SIZE, SEEK_SET) == -1 ||
+        ws_read(state->fd, footer, sizeof footer) != (int)sizeof footer)
+        goto done;
+    /* The reserved and unused bits of the descriptor must be zero. */
+    if (pletoh32(footer + 5) != ZSTD_SEEKABLE_MAGIC || (footer[4] & 0x7F) != 0)
+        goto done;
+    num_frames = pletoh32(footer);
+    entry_size = (footer[4] & 0x80) ? 12 : 8;   /* checksum flag */
+    if (num_frames == 0 || num_frames > ZSTD_SEEK_TABLE_MAX_FRAMES)
+        goto done;
+    entries_size = (gint64)num_frames * entry_size;
+    if (st.st_size - ZSTD_SEEK_TABLE_FOOTER_SIZE - entries_size - 8 < in_pos)
+        goto done;
+
+    /* Read the skippable frame header and the entries together. */
+    entries = (guint8 *)g_malloc((gsize)entries_size + 8);
+    if (ws_lseek64(state->fd, st.st_size - ZSTD_SEEK_TABLE_FOOTER_SIZE - entries_size - 8, SEEK_SET) == -1 ||
+        ws_read(state->fd, entries, (unsigned int)entries_size + 8) != (int)entries_size + 8)
+        goto done;
+    if (pletoh32(entries) != ZSTD_SEEK_TABLE_MAGIC ||
+        pletoh32(entries + 4) != entries_size + ZSTD_SEEK_TABLE_FOOTER_SIZE)
+        goto done;
+
+    for (i = 0; i < num_frames; i++) {
+        const guint8 *entry = entries + 8 + (gsize)i * entry_size;
+
+        /* This skips frames that start where the previous one did,
+           i.e. the ones after an empty frame. */
+        fast_seek_header(state, in_pos, out_pos, ZSTD);
+        in_pos += pletoh32(entry);
+        out_pos += pletoh32(entry + 4);
+    }
+
+done:
+    g_free(entries);
+    /* If that failed, we just find the frames as we read them. */
+    ws_lseek64(state->fd, cur, SEEK_SET);
+}
+
+static void
+zstd_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output;
+    size_t ret;
+
+    if (state->in.avail == 0 && fill_in_buffer(state) == -1)
+        return;
+    if (state->in.avail == 0) {
+        /* EOF in the middle of a frame */
+        state->err = WTAP_ERR_SHORT_READ;
+        state->err_info = NULL;
+        return;
+    }
+
+    input.src = state->in.next;
+    input.size = state->in.avail;
+    input.pos = 0;
+    output.dst = buf;
+    output.size = count;
+    output.pos = 0;
+    ret = ZSTD_decompressStream(state->zstd_dctx, &output, &input);
+    if (ZSTD_isError(ret)) {
+        state->err = WTAP_ERR_DECOMPRESS;
+        state->err_info = ZSTD_getErrorName(ret);
+        return;
+    }
+    state->in.next += input.pos;
+    state->in.avail -= (guint)input.pos;
+    state->out.next = buf;
+    state->out.avail = (guint)output.pos;
+
+    if (ret == 0)
+        state->compression = UNKNOWN;   /* end of frame; look for another */
+}
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+static void
+lz4_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    size_t in_size, out_size;
+    size_t ret;
+
+    if (state->in.avail == 0 && fill_in_buffer(state) == -1)
+        return;
+    if (state->in.avail == 0) {
+        /* EOF in the middle of a frame */
+        state->err = WTAP_ERR_SHORT_READ;
+        state->err_info = NULL;
+        return;
+    }
+
+    in_size = state->in.avail;
+    out_size = count;
+    ret = LZ4F_decompress(state->lz4_dctx, buf, &out_size, state->in.next, &in_size, NULL);
+    if (LZ4F_isError(ret)) {
+        state->err = WTAP_ERR_DECOMPRESS;
+        state->err_info = LZ4F_getErrorName(ret);
+        return;
+    }
+    state->in.next += in_size;
+    state->in.avail -= (guint)in_size;
+    state->out.next = buf;
+    state->out.avail = (guint)out_size;
+
+    if (ret == 0)
+        state->compression = UNKNOWN;   /* end of frame; look for another */
+}
+#endif /* HAVE_LZ4FRAME_H */
+
+#define LZ4F_MAGIC  0x184D2204U
+#define ZSTD_MAGIC  0xFD2FB528U
+
+/*
+ * Look for the start of a zstd or lz4 frame at the current input
+ * position, without consuming anything.  Returns 1 and sets up for
+ * decompressing the frame if there is one, 0 if there isn't, and -1
+ * on an error.
+ */
+static int
+frame_head(FILE_T state)
+{
+    guint32 magic;
+
+    /* We need the four bytes of the magic number. */
+    if (state->in.avail < 4 && !state->eof) {
+        /* Make sure buf_read() has room to add to what we have. */
+        if (state->in.next != state->in.buf) {
+            memmove(state->in.buf, state->in.next, state->in.avail);
+            state->in.next = state->in.buf;
+        }
+        while (state->in.avail < 4 && !state->eof) {
+            if (fill_in_buffer(state) == -1)
+                return -1;
+        }
+    }
+    if (state->in.avail < 4)
+        return 0;
+    magic = pletoh32(state->in.next);
+
+    if (magic == ZSTD_MAGIC
+#ifdef HAVE_ZSTD
+        /* the seek table of a seekable file is in a skippable frame */
+        || (magic & ZSTD_SKIPPABLE_MAGIC_MASK) == ZSTD_SKIPPABLE_MAGIC
+#endif
+        ) {
+#ifdef HAVE_ZSTD
+        size_t ret;
+
+        if (state->zstd_dctx == NULL &&
+            (state->zstd_dctx = ZSTD_createDStream()) == NULL) {
+            state->err = ENOMEM;
+            return -1;
+        }
+        ret = ZSTD_initDStream(state->zstd_dctx);
+        if (ZSTD_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = ZSTD_getErrorName(ret);
+            return -1;
+        }
+        if (state->fast_seek) {
+            gint64 in_pos = state->raw_pos - state->in.avail;
+
+            zstd_load_seek_table(state, in_pos, state->pos);
+            fast_seek_header(state, in_pos, state->pos, ZSTD);
+        }
+        state->compression = ZSTD;
+        state->is_compressed = TRUE;
+        state->compression_type = WTAP_ZSTD_COMPRESSED;
+        return 1;
+#else
+        state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
+        state->err_info = "reading zstd-compressed files isn't supported";
+        return -1;
+#endif
+    }
+
+    if (magic == LZ4F_MAGIC) {
+#ifdef HAVE_LZ4FRAME_H
+        LZ4F_errorCode_t ret;
+
+        /* Start afresh, in case we've seeked away from a partly-read frame. */
+        if (state->lz4_dctx != NULL) {
+            LZ4F_freeDecompressionContext(state->lz4_dctx);
+            state->lz4_dctx = NULL;
+        }
+        ret = LZ4F_createDecompressionContext(&state->lz4_dctx, LZ4F_VERSION);
+        if (LZ4F_isError(ret)) {
+            state->lz4_dctx = NULL;
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = LZ4F_getErrorName(ret);
+            return -1;
+        }
+        if (state->fast_seek)
+            fast_seek_header(state, state->raw_pos - state->in.avail, state->pos, LZ4);
+        state->compression = LZ4;
+        state->is_compressed = TRUE;
+        state->compression_type = WTAP_LZ4_COMPRESSED;
+        return 1;
+#else
+        state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
+        state->err_info = "reading lz4-compressed files isn't supported";
+        return -1;
+#endif
+    }
+    return 0;
+}
+
 static int
 gz_head(FILE_T state)
 {
@@ -767,6 +1243,7 @@ gz_head(FILE_T state)
                 state->strm.adler = crc32(0L, Z_NULL, 0);
                 state->compression = ZLIB;
                 state->is_compressed = TRUE;
+                state->compression_type = WTAP_GZIP_COMPRESSED;
 #ifdef Z_BLOCK
                 if (state->fast_seek) {
                     struct zlib_cur_seek_point *cur = g_new(struct zlib_cur_seek_point,1);
@@ -804,6 +1281,14 @@ gz_head(FILE_T state)
             state->in.next--;
         }
     }
+    switch (frame_head(state)) {
+
+    case -1:
+        return -1;
+
+    case 1:
+        return 0;
+    }
 #ifdef HAVE_LIBXZ
     /* { 0xFD, '7', 'z', 'X', 'Z', 0x00 } */
     /* FD 37 7A 58 5A 00 */
@@ -831,9 +1316,44 @@ gz_head(FILE_T state)
     return 0;
 }
 
+static gboolean read_ahead_start(FILE_T state);
+static gboolean read_ahead_get(FILE_T state);
+static void read_ahead_end(FILE_T state, gboolean in_sync);
+
 static int /* gz_make */
 fill_out_buffer(FILE_T state)
 {
+    if (state->want_read_ahead && state->read_ahead == NULL &&
+        state->pos >= state->read_ahead_after)
+        read_ahead_start(state);
+    if (state->read_ahead != NULL) {
+        if (read_ahead_get(state))
+            return 0;
+        /* The thread stopped at the end of the file, and we've
+           used everything it read, but our caller has cleared
+           the EOF, e.g. because the file is still being written;
+           carry on reading here. */
+        read_ahead_end(state, TRUE);
+        if (state->err != 0)
+            return -1;
+    }
+#ifdef HAVE_SYS_MMAN_H
+    if (state->compression == UNKNOWN && state->map != NULL) {
+        /* If it's compressed, we don't use the mapping; otherwise we
+           don't need to read anything to look for a header. */
+        if ((state->map_size - state->raw_pos >= 2 &&
+             state->map[state->raw_pos] == 31 &&
+             state->map[state->raw_pos + 1] == 139) ||
+            (state->map_size - state->raw_pos >= 4 &&
+             (pletoh32(state->map + state->raw_pos) == ZSTD_MAGIC ||
+              pletoh32(state->map + state->raw_pos) == LZ4F_MAGIC))) {
+            file_unmap(state);
+        } else {
+            state->raw = state->pos;
+            state->compression = UNCOMPRESSED;
+        }
+    }
+#endif
     if (state->compression == UNKNOWN) {           /* look for gzip header */
         if (gz_head(state) == -1)
             return -1;
@@ -841,6 +1361,14 @@ fill_out_buffer(FILE_T state)
             return 0;
     }
     if (state->compression == UNCOMPRESSED) {           /* straight copy */
+#ifdef HAVE_SYS_MMAN_H
+        if (state->map != NULL) {
+            if (map_read(state) == 0)
+                return 0;
+            if (state->err != 0)
+                return -1;
+        }
+#endif
         if (buf_read(state, &state->out) < 0)
             return -1;
     }
@@ -848,6 +1376,16 @@ fill_out_buffer(FILE_T state)
     else if (state->compression == ZLIB) {      /* decompress */
         zlib_read(state, state->out.buf, state->size << 1);
     }
+#endif
+#ifdef HAVE_ZSTD
+    else if (state->compression == ZSTD) {
+        zstd_read(state, state->out.buf, state->size << 1);
+    }
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    else if (state->compression == LZ4) {
+        lz4_read(state, state->out.buf, state->size << 1);
+    }
 #endif
     return 0;
 }
@@ -866,6 +1404,7 @@ gz_skip(FILE_T state, gint64 len)
             state->out.avail -= n;
             state->out.next += n;
             state->pos += n;
+            state->stats.skipped_bytes += n;
             len -= n;
         } else if (state->err != 0) {
             /* We have nothing in the output buffer, and
@@ -902,6 +1441,390 @@ gz_reset(FILE_T state)
     buf_reset(&state->in);        /* no input data yet */
 }
 
+/*
+ * Reading ahead.
+ *
+ * If asked to, with file_set_read_ahead(), a sequential stream reads
+ * and decompresses the file in another thread, into a ring of chunks
+ * that fill_out_buffer() then hands out as the output buffer, so that
+ * decompression overlaps with whatever our caller does with the data.
+ *
+ * The thread reads with its own wtap_reader, to which we hand over our
+ * decoder state when it starts; we keep only the output buffer and the
+ * current position, so nothing above fill_out_buffer() can tell.  A
+ * seek that doesn't just skip forward a little stops the thread; we
+ * then set our decoder up to seek from the beginning, as we can't take
+ * back the decoder state from a thread that's read past where we are,
+ * and start reading ahead again the next time we need data.
+ */
+#define READ_AHEAD_CHUNKS       8
+#define READ_AHEAD_CHUNK_SIZE   (256U * 1024U)
+
+struct read_ahead_chunk {
+    struct wtap_reader_buf buf; /* uncompressed data */
+    gint64 raw_pos;             /* the thread's raw_pos after the data */
+    gboolean is_compressed;
+    wtap_compression_type compression_type;
+    int err;                    /* error after the data, if any */
+    const char *err_info;
+    gboolean eof;               /* TRUE if the data ends at the end of the file */
+};
+
+struct read_ahead {
+    FILE_T dec;                 /* the stream the thread reads with */
+    GThread *thread;
+    GMutex mutex;
+    GCond cond;                 /* signalled when a chunk is filled or released */
+    guint chunk_size;
+    struct read_ahead_chunk chunks[READ_AHEAD_CHUNKS];
+    guint fill;                 /* chunk the thread fills next */
+    guint use;                  /* chunk we're using, or use next */
+    guint nfull;                /* chunks filled and not yet released */
+    gboolean using;             /* TRUE if we're using chunks[use] */
+    gboolean finished;          /* TRUE if the thread has filled its last chunk */
+    gint stop;                  /* set to tell the thread to stop */
+    unsigned char *out_buf;     /* our own output buffer */
+};
+
+/*
+ * Hand the decoder state of src, which must not have any output data
+ * pending, over to dst, leaving src with nothing buffered; dst and src
+ * have the same buffer size.  If that fails, neither is changed, other
+ * than dst having a fresh zlib stream.
+ */
+static int
+decoder_move(FILE_T dst, FILE_T src)
+{
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zstd_dctx;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_decompressionContext_t lz4_dctx;
+#endif
+
+#ifdef HAVE_ZLIB
+    /* A z_stream can't just be copied, as zlib's state points back to it. */
+    inflateEnd(&dst->strm);
+    if (inflateCopy(&dst->strm, &src->strm) != Z_OK) {
+        memset(&dst->strm, 0, sizeof dst->strm);
+        (void)inflateInit2(&(dst->strm), -15);
+        return -1;
+    }
+    dst->dont_check_crc = src->dont_check_crc;
+#endif
+
+    memcpy(dst->in.buf, src->in.next, src->in.avail);
+    dst->in.next = dst->in.buf;
+    dst->in.avail = src->in.avail;
+    buf_reset(&src->in);
+
+    dst->raw_pos = src->raw_pos;
+    dst->pos = src->pos;
+    dst->eof = src->eof;
+    dst->raw = src->raw;
+    dst->compression = src->compression;
+    dst->is_compressed = src->is_compressed;
+    dst->compression_type = src->compression_type;
+    dst->err = src->err;
+    dst->err_info = src->err_info;
+
+    g_free(dst->fast_seek_cur);
+    dst->fast_seek_cur = src->fast_seek_cur;
+    src->fast_seek_cur = NULL;
+#ifdef HAVE_ZSTD
+    zstd_dctx = dst->zstd_dctx;
+    dst->zstd_dctx = src->zstd_dctx;
+    src->zstd_dctx = zstd_dctx;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    lz4_dctx = dst->lz4_dctx;
+    dst->lz4_dctx = src->lz4_dctx;
+    src->lz4_dctx = lz4_dctx;
+#endif
+    return 0;
+}
+
+static gpointer
+read_ahead_thread(gpointer data)
+{
+    struct read_ahead *ra = (struct read_ahead *)data;
+    FILE_T dec = ra->dec;
+    struct read_ahead_chunk *chunk;
+    unsigned char *p, *end;
+    gboolean done;
+
+    for (;;) {
+        g_mutex_lock(&ra->mutex);
+        while (ra->nfull == READ_AHEAD_CHUNKS && !g_atomic_int_get(&ra->stop))
+            g_cond_wait(&ra->cond, &ra->mutex);
+        chunk = &ra->chunks[ra->fill];
+        g_mutex_unlock(&ra->mutex);
+
+        /* Fill the chunk until there isn't room for another
+           output buffer's worth, or we hit the end of the file
+           or an error. */
+        p = chunk->buf.buf;
+        end = p + ra->chunk_size;
+        while ((guint)(end - p) >= dec->size << 1 &&
+               !g_atomic_int_get(&ra->stop)) {
+            dec->out.buf = p;
+            buf_reset(&dec->out);
+            fill_out_buffer(dec);
+            if (dec->out.avail != 0) {
+                if (dec->out.next != p)
+                    memmove(p, dec->out.next, dec->out.avail);
+                p += dec->out.avail;
+                dec->pos += dec->out.avail;
+                dec->out.avail = 0;
+            }
+            if (dec->err != 0 || (dec->eof && dec->in.avail == 0))
+                break;
+        }
+        if (g_atomic_int_get(&ra->stop))
+            break;
+
+        chunk->buf.next = chunk->buf.buf;
+        chunk->buf.avail = (guint)(p - chunk->buf.buf);
+        chunk->raw_pos = dec->raw_pos;
+        chunk->is_compressed = dec->is_compressed;
+        chunk->compression_type = dec->compression_type;
+        chunk->err = dec->err;
+        chunk->err_info = dec->err_info;
+        chunk->eof = (dec->eof && dec->in.avail == 0);
+        done = (chunk->err != 0 || chunk->eof);
+
+        g_mutex_lock(&ra->mutex);
+        ra->fill = (ra->fill + 1) % READ_AHEAD_CHUNKS;
+        ra->nfull++;
+        if (done)
+            ra->finished = TRUE;
+        g_cond_broadcast(&ra->cond);
+        g_mutex_unlock(&ra->mutex);
+        if (done)
+            break;
+    }
+    return NULL;
+}
+
+static void
+read_ahead_free(struct read_ahead *ra)
+{
+    FILE_T dec = ra->dec;
+    guint i;
+
+    for (i = 0; i < READ_AHEAD_CHUNKS; i++)
+        g_free(ra->chunks[i].buf.buf);
+#ifdef HAVE_ZLIB
+    inflateEnd(&dec->strm);
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_freeDStream(dec->zstd_dctx);
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    if (dec->lz4_dctx != NULL)
+        LZ4F_freeDecompressionContext(dec->lz4_dctx);
+#endif
+    g_free(dec->fast_seek_cur);
+    g_free(dec->in.buf);
+    g_free(dec);
+    g_mutex_clear(&ra->mutex);
+    g_cond_clear(&ra->cond);
+    g_free(ra);
+}
+
+/*
+ * Start reading ahead from the current position; we must have no
+ * output data pending.  If we can't, just don't try again.
+ */
+static gboolean
+read_ahead_start(FILE_T state)
+{
+    struct read_ahead *ra;
+    FILE_T dec;
+    guint i;
+
+    ra = g_new0(struct read_ahead, 1);
+    g_mutex_init(&ra->mutex);
+    g_cond_init(&ra->cond);
+    ra->chunk_size = MAX(READ_AHEAD_CHUNK_SIZE, state->size << 1);
+    for (i = 0; i < READ_AHEAD_CHUNKS; i++)
+        ra->chunks[i].buf.buf = (unsigned char *)g_malloc(ra->chunk_size);
+
+    dec = g_new0(struct wtap_reader, 1);
+    dec->fd = state->fd;
+    dec->size = state->size;
+    dec->start = state->start;
+    dec->fast_seek = state->fast_seek;
+    dec->in.buf = (unsigned char *)g_malloc(state->size);
+    buf_reset(&dec->in);
+    ra->dec = dec;
+#ifdef HAVE_ZLIB
+    if (inflateInit2(&(dec->strm), -15) != Z_OK) {
+        memset(&dec->strm, 0, sizeof dec->strm);
+        read_ahead_free(ra);
+        state->want_read_ahead = FALSE;
+        return FALSE;
+    }
+#endif
+    if (decoder_move(dec, state) == -1) {
+        read_ahead_free(ra);
+        state->want_read_ahead = FALSE;
+        return FALSE;
+    }
+
+    ra->out_buf = state->out.buf;
+    ra->thread = g_thread_try_new("wtap read-ahead", read_ahead_thread, ra, NULL);
+    if (ra->thread == NULL) {
+        decoder_move(state, dec);
+        read_ahead_free(ra);
+        state->want_read_ahead = FALSE;
+        return FALSE;
+    }
+    state->read_ahead = ra;
+    return TRUE;
+}
+
+/*
+ * Release the chunk we've used, if any, and make the next one the
+ * output buffer.  Returns FALSE if the thread has finished and we've
+ * used all it read.
+ */
+static gboolean
+read_ahead_get(FILE_T state)
+{
+    struct read_ahead *ra = state->read_ahead;
+    struct read_ahead_chunk *chunk;
+
+    g_mutex_lock(&ra->mutex);
+    if (ra->using) {
+        ra->using = FALSE;
+        ra->use = (ra->use + 1) % READ_AHEAD_CHUNKS;
+        ra->nfull--;
+        g_cond_broadcast(&ra->cond);
+    }
+    while (ra->nfull == 0 && !ra->finished)
+        g_cond_wait(&ra->cond, &ra->mutex);
+    if (ra->nfull == 0) {
+        g_mutex_unlock(&ra->mutex);
+        return FALSE;
+    }
+    chunk = &ra->chunks[ra->use];
+    ra->using = TRUE;
+    g_mutex_unlock(&ra->mutex);
+
+    state->out = chunk->buf;
+    state->raw_pos = chunk->raw_pos;
+    state->is_compressed = chunk->is_compressed;
+    state->compression_type = chunk->compression_type;
+    if (chunk->err != 0) {
+        state->err = chunk->err;
+        state->err_info = chunk->err_info;
+    }
+    if (chunk->eof)
+        state->eof = TRUE;
+    return TRUE;
+}
+
+/*
+ * Stop reading ahead.  If in_sync is TRUE, the thread has finished and
+ * we've used everything it read, so we can carry on from where it
+ * stopped; otherwise, we set ourselves up to seek from the beginning.
+ */
+static void
+read_ahead_end(FILE_T state, gboolean in_sync)
+{
+    struct read_ahead *ra = state->read_ahead;
+    gboolean eof = state->eof;
+    int err = state->err;
+    const char *err_info = state->err_info;
+
+    g_atomic_int_set(&ra->stop, 1);
+    g_mutex_lock(&ra->mutex);
+    g_cond_broadcast(&ra->cond);
+    g_mutex_unlock(&ra->mutex);
+    g_thread_join(ra->thread);
+
+    state->out.buf = ra->out_buf;
+    buf_reset(&state->out);
+    state->read_ahead = NULL;
+    if (in_sync) {
+        if (decoder_move(state, ra->dec) == 0) {
+            /* Whatever the thread saw at the end, our caller
+               has cleared. */
+            state->eof = eof;
+            state->err = err;
+            state->err_info = err_info;
+        } else {
+            /* We've lost our place. */
+            state->err = ENOMEM;
+            state->err_info = NULL;
+        }
+        /* Reading ahead again wouldn't get us much. */
+        state->want_read_ahead = FALSE;
+    } else {
+        if (ws_lseek64(state->fd, state->start, SEEK_SET) == -1) {
+            state->err = errno;
+            state->err_info = NULL;
+        } else {
+            state->raw_pos = state->start;
+            gz_reset(state);
+        }
+    }
+    read_ahead_free(ra);
+}
+
+static gboolean
+read_ahead_possible(FILE_T stream)
+{
+    ws_statb64 st;
+
+    /* Only for regular files, as stopping the thread means we have to
+       be able to seek back to the beginning, and there's no point if
+       the file's mapped. */
+    if (ws_fstat64(stream->fd, &st) == -1 || !S_ISREG(st.st_mode))
+        return FALSE;
+#ifdef HAVE_SYS_MMAN_H
+    if (stream->map != NULL)
+        return FALSE;
+#endif
+    return TRUE;
+}
+
+void
+file_set_read_ahead(FILE_T stream)
+{
+    static int use_read_ahead = -1;
+
+    if (use_read_ahead == -1)
+        use_read_ahead = (getenv("WIRESHARK_WTAP_READ_AHEAD") != NULL);
+    if (!use_read_ahead)
+        return;
+
+    if (read_ahead_possible(stream))
+        stream->want_read_ahead = TRUE;
+}
+
+/*
+ * Read a random access stream ahead while our caller seeks through it
+ * in ascending order.  Seeks that skip forward a little are served from
+ * what the thread has read; longer ones stop it, and it starts again
+ * once the reads look sequential again.
+ */
+void
+file_set_seek_read_ahead(FILE_T stream, gboolean read_ahead)
+{
+    if (!read_ahead) {
+        if (stream->read_ahead != NULL)
+            read_ahead_end(stream, FALSE);
+        stream->want_read_ahead = FALSE;
+        return;
+    }
+    if (read_ahead_possible(stream)) {
+        stream->want_read_ahead = TRUE;
+        stream->read_ahead_after = 0;
+    }
+}
+
 FILE_T
 file_fdopen(int fd)
 {
@@ -927,6 +1850,7 @@ file_fdopen(int fd)
     ws_statb64 st;
 #endif
     int want = GZBUFSIZE;
+    const char *env;
     FILE_T state;
 
     if (fd == -1)
@@ -939,12 +1863,25 @@ file_fdopen(int fd)
 
     state->fast_seek_cur = NULL;
     state->fast_seek = NULL;
+    state->want_read_ahead = FALSE;
+    state->read_ahead_after = 0;
+    state->read_ahead = NULL;
+#ifdef HAVE_SYS_MMAN_H
+    state->map = NULL;
+#endif
+#ifdef HAVE_ZSTD
+    state->zstd_dctx = NULL;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    state->lz4_dctx = NULL;
+#endif
 
     /* open the file with the appropriate mode (or just use fd) */
     state->fd = fd;
 
     /* we don't yet know whether it's compressed */
     state->is_compressed = FALSE;
+    state->compression_type = WTAP_UNCOMPRESSED;
 
     /* save the current position for rewinding (only if reading) */
     state->start = ws_lseek64(state->fd, 0, SEEK_CUR);
@@ -969,6 +1906,19 @@ file_fdopen(int fd)
     }
 #endif
 
+    /*
+     * WIRESHARK_WTAP_READ_BUFFER overrides that, for measuring the
+     * effect of the buffer size; it's looked up on every open so that
+     * wtapbench can try several sizes in one run.
+     */
+    env = getenv("WIRESHARK_WTAP_READ_BUFFER");
+    if (env != NULL) {
+        gint64 size = g_ascii_strtoll(env, NULL, 10);
+
+        if (size >= 512 && size <= READ_BUFFER_SIZE_MAX)
+            want = (int)size;
+    }
+
     /* allocate buffers */
     state->in.buf = (unsigned char *)g_try_malloc((gsize)want);
     state->in.next = state->in.buf;
@@ -1035,6 +1985,10 @@ file_open(const char *path)
         return NULL;
     }
 
+#ifdef HAVE_SYS_MMAN_H
+    file_map(ft);
+#endif
+
 #ifdef HAVE_ZLIB
     /*
      * If this file's name ends in ".caz", it's probably a compressed
@@ -1065,10 +2019,176 @@ file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
     stream->fast_seek = seek;
 }
 
+/*
+ * Seek index sidecar files.
+ *
+ * Building the fast seek table for a compressed file means decompressing
+ * all of it, so, if asked to, we save the table next to the file when
+ * we're done with a sequential pass through it, and load it up front
+ * the next time the file is opened, so that random access is fast from
+ * the start.
+ *
+ * The sidecar is only usable by the build that wrote it - the seek
+ * points are written out as they are in memory, with the data part
+ * only for zlib points - and only with the
+ * file it was written for, as checked with the file's size and
+ * modification time.
+ */
+#define SEEK_INDEX_MAGIC    "WTAPSIDX"
+#define SEEK_INDEX_VERSION  2
+
+struct seek_index_hdr {
+    char    magic[8];
+    guint32 version;
+    guint32 point_size;     /* sizeof (struct fast_seek_point) */
+    guint32 num_points;
+    guint32 pad;
+    gint64  file_size;
+    gint64  file_mtime;
+};
+
+static gchar *
+seek_index_path(const char *path)
+{
+    static int use_seek_index = -1;
+
+    if (use_seek_index == -1)
+        use_seek_index = (getenv("WIRESHARK_WTAP_SEEK_INDEX") != NULL);
+    if (!use_seek_index)
+        return NULL;
+    return g_strdup_printf("%s.seekidx", path);
+}
+
+gboolean
+file_seek_index_load(FILE_T stream, const char *path)
+{
+    gchar *index_path;
+    FILE *fp;
+    ws_statb64 st;
+    struct seek_index_hdr hdr;
+    gboolean ok = FALSE;
+
+    if (stream->fast_seek == NULL || stream->fast_seek->len != 0)
+        return FALSE;
+    if ((index_path = seek_index_path(path)) == NULL)
+        return FALSE;
+    if (ws_fstat64(stream->fd, &st) == -1) {
+        g_free(index_path);
+        return FALSE;
+    }
+    fp = ws_fopen(index_path, "rb");
+    g_free(index_path);
+    if (fp == NULL)
+        return FALSE;
+
+    if (fread(&hdr, sizeof hdr, 1, fp) == 1 &&
+        memcmp(hdr.magic, SEEK_INDEX_MAGIC, sizeof hdr.magic) == 0 &&
+        hdr.version == SEEK_INDEX_VERSION &&
+        hdr.point_size == sizeof (struct fast_seek_point) &&
+        hdr.file_size == (gint64)st.st_size &&
+        hdr.file_mtime == (gint64)st.st_mtime &&
+        hdr.num_points != 0) {
+        guint32 i;
+
+        for (i = 0; i < hdr.num_points; i++) {
+            struct fast_seek_point *val = (struct fast_seek_point *)g_malloc(FAST_SEEK_POINT_HDR_SIZE);
+
+            if (fread(val, FAST_SEEK_POINT_HDR_SIZE, 1, fp) != 1 ||
+                (i != 0 && val->out <= ((struct fast_seek_point *)stream->fast_seek->pdata[i - 1])->out)) {
+                g_free(val);
+                break;
+            }
+#ifdef HAVE_ZLIB
+            if (val->compression == ZLIB) {
+                val = (struct fast_seek_point *)g_realloc(val, sizeof *val);
+                if (fread(&val->data.zlib, sizeof val->data.zlib, 1, fp) != 1) {
+                    g_free(val);
+                    break;
+                }
+            }
+#endif
+            g_ptr_array_add(stream->fast_seek, val);
+        }
+        if (i == hdr.num_points) {
+            ok = TRUE;
+        } else {
+            /* Truncated or corrupt; don't trust any of it. */
+            for (i = 0; i < stream->fast_seek->len; i++)
+                g_free(stream->fast_seek->pdata[i]);
+            g_ptr_array_set_size(stream->fast_seek, 0);
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+void
+file_seek_index_save(FILE_T stream, const char *path)
+{
+    gchar *index_path, *tmp_path;
+    FILE *fp;
+    ws_statb64 st;
+    struct seek_index_hdr hdr;
+    guint i;
+    gboolean ok;
+
+    /*
+     * Only bother if the file is compressed - for an uncompressed file
+     * the table is trivial - and if we've read all of it, so that the
+     * table is complete.
+     */
+    if (stream->fast_seek == NULL || stream->fast_seek->len == 0 ||
+        !stream->is_compressed || !file_eof(stream) || stream->err != 0)
+        return;
+    if ((index_path = seek_index_path(path)) == NULL)
+        return;
+    if (ws_fstat64(stream->fd, &st) == -1) {
+        g_free(index_path);
+        return;
+    }
+
+    /* Write to a temporary file, so nobody sees a partial index. */
+    tmp_path = g_strdup_printf("%s.tmp", index_path);
+    fp = ws_fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        g_free(tmp_path);
+        g_free(index_path);
+        return;
+    }
+
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, SEEK_INDEX_MAGIC, sizeof hdr.magic);
+    hdr.version = SEEK_INDEX_VERSION;
+    hdr.point_size = sizeof (struct fast_seek_point);
+    hdr.file_size = (gint64)st.st_size;
+    hdr.file_mtime = (gint64)st.st_mtime;
+    g_mutex_lock(&fast_seek_mutex);
+    hdr.num_points = stream->fast_seek->len;
+    ok = (fwrite(&hdr, sizeof hdr, 1, fp) == 1);
+    for (i = 0; ok && i < stream->fast_seek->len; i++) {
+        struct fast_seek_point *point = (struct fast_seek_point *)stream->fast_seek->pdata[i];
+
+        ok = (fwrite(point, FAST_SEEK_POINT_HDR_SIZE, 1, fp) == 1);
+#ifdef HAVE_ZLIB
+        if (ok && point->compression == ZLIB)
+            ok = (fwrite(&point->data.zlib, sizeof point->data.zlib, 1, fp) == 1);
+#endif
+    }
+    g_mutex_unlock(&fast_seek_mutex);
+    if (fclose(fp) != 0)
+        ok = FALSE;
+
+    if (!ok || ws_rename(tmp_path, index_path) != 0)
+        ws_unlink(tmp_path);
+    g_free(tmp_path);
+    g_free(index_path);
+}
+
 gint64
 file_seek(FILE_T file, gint64 offset, int whence, int *err)
 {
     struct fast_seek_point *here;
+    gboolean rewound = FALSE;
     guint n;
 
     if (whence != SEEK_SET && whence != SEEK_CUR && whence != SEEK_END) {
@@ -1114,6 +2234,7 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /* No.  Just return the current position. */
         return file->pos;
     }
+    file->stats.seeks++;
 
     /*
      * Are we seeking backwards?
@@ -1146,6 +2267,7 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             file->out.avail += adjustment;
             file->out.next -= adjustment;
             file->pos -= adjustment;
+            file->stats.seeks_buffered++;
             return file->pos;
         }
     } else {
@@ -1165,12 +2287,42 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             file->out.avail -= (guint)offset;
             file->out.next += offset;
             file->pos += offset;
+            file->stats.seeks_buffered++;
             return file->pos;
         }
     }
 
     /*
-     * We're not seeking within the buffer.  Do we have "fast seek" data
+     * We're not seeking within the buffer.  If we're reading ahead,
+     * and we're only skipping forward a little, skip through what the
+     * read-ahead thread gives us; otherwise, stop reading ahead, so
+     * that we can do the seek ourselves.
+     */
+    if (file->read_ahead != NULL) {
+        gint64 target;
+
+        if (offset > 0 && offset <= SPAN) {
+            file->seek_pending = TRUE;
+            file->skip = offset;
+            file->stats.seeks_forward++;
+            return file->pos + offset;
+        }
+        target = file->pos + offset;
+        read_ahead_end(file, FALSE);
+        /* Don't start again until the caller looks like it's
+           reading sequentially again. */
+        file->read_ahead_after = target + SPAN;
+        if (file->err != 0) {
+            *err = file->err;
+            return -1;
+        }
+        offset = target - file->pos;
+        if (offset == 0)
+            return file->pos;
+    }
+
+    /*
+     * Do we have "fast seek" data
      * for the location to which we will be seeking, and is the offset
      * outside the span for compressed files or is this an uncompressed
      * file?
@@ -1178,9 +2330,12 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
      * XXX, profile
      */
     if ((here = fast_seek_find(file, file->pos + offset)) &&
-        (offset < 0 || offset > SPAN || here->compression == UNCOMPRESSED)) {
+        (offset < 0 || offset > SPAN || here->compression == UNCOMPRESSED ||
+         (fast_seek_is_frame(here->compression) && here->out > file->pos))) {
         gint64 off, off2;
 
+        file->stats.seeks_fast++;
+
         /*
          * Yes.  Use that data to do the seek.
          * Note that this will be true only if file_set_random_access()
@@ -1200,7 +2355,10 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             off2 = here->out;
         } else
 #endif
-        {
+        if (fast_seek_is_frame(here->compression)) {
+            off = here->in;
+            off2 = here->out;
+        } else {
             off2 = (file->pos + offset);
             off = here->in + (off2 - here->out);
         }
@@ -1252,6 +2410,10 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             file->compression = ZLIB;
         } else
 #endif
+        if (fast_seek_is_frame(here->compression)) {
+            /* Start of a frame; set up the decoder when we read it. */
+            file->compression = UNKNOWN;
+        } else
             file->compression = here->compression;
 
         offset = (file->pos + offset) - off2;
@@ -1285,6 +2447,7 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /*
          * Yes.  Just seek there within the file.
          */
+        file->stats.seeks_direct++;
         if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
             *err = errno;
             return -1;
@@ -1317,6 +2480,8 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             return -1;
         }
         /* rewind, then skip to offset */
+        file->stats.seeks_rewind++;
+        rewound = TRUE;
 
         /* back up and start over */
         if (ws_lseek64(file->fd, file->start, SEEK_SET) == -1) {
@@ -1334,6 +2499,8 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
      *
      * Skip what's in output buffer (one less gzgetc() check).
      */
+    if (!rewound)
+        file->stats.seeks_forward++;
     n = (gint64)file->out.avail > offset ? (unsigned)offset : file->out.avail;
     file->out.avail -= n;
     file->out.next += n;
@@ -1361,6 +2528,11 @@ file_tell(FILE_T stream)
 gint64
 file_tell_raw(FILE_T stream)
 {
+#ifdef HAVE_SYS_MMAN_H
+    /* Don't count the part of the mapping we haven't gotten to yet. */
+    if (stream->map != NULL && stream->out.buf != stream->out_alloc)
+        return stream->raw_pos - stream->out.avail;
+#endif
     return stream->raw_pos;
 }
 
@@ -1375,12 +2547,33 @@ file_fstat(FILE_T stream, ws_statb64 *statb, int *err)
     return 0;
 }
 
+void
+file_get_stats(FILE_T stream, wtap_reader_stats *stats)
+{
+    *stats = stream->stats;
+    if (stream->fast_seek != NULL) {
+        g_mutex_lock(&fast_seek_mutex);
+        stats->fast_seek_points = stream->fast_seek->len;
+        g_mutex_unlock(&fast_seek_mutex);
+    }
+    stats->buffer_size = stream->size;
+#ifdef HAVE_SYS_MMAN_H
+    stats->mapped = (stream->map != NULL);
+#endif
+}
+
 gboolean
 file_iscompressed(FILE_T stream)
 {
     return stream->is_compressed;
 }
 
+static wtap_compression_type
+file_get_compression_type(FILE_T stream)
+{
+    return stream->compression_type;
+}
+
 int
 file_read(void *buf, unsigned int len, FILE_T file)
 {
@@ -1489,6 +2682,44 @@ file_peekc(FILE_T file)
     return ret;
 }
 
+/*
+ * Return a pointer to the next "count" bytes of the file, if they're
+ * all already sitting contiguously in the output buffer (after filling
+ * it, if it's empty), without consuming them; otherwise return NULL,
+ * and the caller should read the data with file_read() instead.
+ *
+ * The pointer remains valid until more than "count" bytes have been
+ * consumed, or the file is seeked, so a caller can consume the bytes
+ * with file_read(NULL, count, file) and then parse them in place.
+ */
+const guint8 *
+file_peek_bytes(FILE_T file, unsigned int count)
+{
+    /* check that we're reading and that there's no error */
+    if (file->err != 0)
+        return NULL;
+
+    /* process a skip request */
+    if (file->seek_pending) {
+        file->seek_pending = FALSE;
+        if (gz_skip(file, file->skip) == -1)
+            return NULL;
+    }
+
+    /* this is the same as in file_peekc() */
+    while (file->out.avail == 0) {
+        if (file->err != 0)
+            return NULL;
+        if (file->eof && file->in.avail == 0)
+            return NULL;
+        if (fill_out_buffer(file) == -1)
+            return NULL;
+    }
+    if (file->out.avail < count)
+        return NULL;
+    return file->out.next;
+}
+
 /*
  * XXX - this gets a byte, not a character.
  */
@@ -1624,6 +2855,13 @@ file_clearerr(FILE_T stream)
 void
 file_fdclose(FILE_T file)
 {
+    if (file->read_ahead != NULL)
+        read_ahead_end(file, FALSE);
+    file->want_read_ahead = FALSE;
+#ifdef HAVE_SYS_MMAN_H
+    /* The file might be replaced before it's reopened. */
+    file_unmap(file);
+#endif
     ws_close(file->fd);
     file->fd = -1;
 }
@@ -1644,10 +2882,23 @@ file_close(FILE_T file)
 {
     int fd = file->fd;
 
+    if (file->read_ahead != NULL)
+        read_ahead_end(file, FALSE);
+#ifdef HAVE_SYS_MMAN_H
+    file_unmap(file);
+#endif
+
     /* free memory and close file */
     if (file->size) {
 #ifdef HAVE_ZLIB
         inflateEnd(&(file->strm));
+#endif
+#ifdef HAVE_ZSTD
+        ZSTD_freeDStream(file->zstd_dctx);
+#endif
+#ifdef HAVE_LZ4FRAME_H
+        if (file->lz4_dctx != NULL)
+            LZ4F_freeDecompressionContext(file->lz4_dctx);
 #endif
         g_free(file->out.buf);
         g_free(file->in.buf);
@@ -17,13 +17,19 @@
 extern FILE_T file_open(const char *path);
 extern FILE_T file_fdopen(int fildes);
 extern void file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek);
+extern gboolean file_seek_index_load(FILE_T stream, const char *path);
+extern void file_seek_index_save(FILE_T stream, const char *path);
+extern void file_set_read_ahead(FILE_T stream);
+extern void file_set_seek_read_ahead(FILE_T stream, gboolean read_ahead);
 WS_DLL_PUBLIC gint64 file_seek(FILE_T stream, gint64 offset, int whence, int *err);
 WS_DLL_PUBLIC gint64 file_tell(FILE_T stream);
 extern gint64 file_tell_raw(FILE_T stream);
 extern int file_fstat(FILE_T stream, ws_statb64 *statb, int *err);
+extern void file_get_stats(FILE_T stream, wtap_reader_stats *stats);
 WS_DLL_PUBLIC gboolean file_iscompressed(FILE_T stream);
 WS_DLL_PUBLIC int file_read(void *buf, unsigned int count, FILE_T file);
 WS_DLL_PUBLIC int file_peekc(FILE_T stream);
+extern const guint8 *file_peek_bytes(FILE_T stream, unsigned int count);
 WS_DLL_PUBLIC int file_getc(FILE_T stream);
 WS_DLL_PUBLIC char *file_gets(char *buf, int len, FILE_T stream);
 WS_DLL_PUBLIC char *file_getsp(char *buf, int len, FILE_T stream);
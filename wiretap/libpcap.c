@@ -60,6 +60,8 @@ typedef struct {
 /* Try to read the first few records of the capture file. */
 static int libpcap_try(wtap *wth, int *err, gchar **err_info);
 static int libpcap_try_record(wtap *wth, FILE_T fh, int *err, gchar **err_info);
+static gboolean libpcap_resync(wtap *wth, gint64 off, gint64 *rec_off,
+    int *err, gchar **err_info);
 
 static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info, gint64 *data_offset);
@@ -621,6 +623,14 @@ done:
 	 */
 	wtap_add_generated_idb(wth);
 
+	/*
+	 * We can only find record headers in the middle of the file
+	 * if we know exactly what they look like.
+	 */
+	if ((libpcap->variant == PCAP || libpcap->variant == PCAP_NSEC) &&
+	    libpcap->lengths_swapped == NOT_SWAPPED)
+		wth->subtype_resync = libpcap_resync;
+
 	return WTAP_OPEN_MINE;
 }
 
@@ -814,6 +824,76 @@ static int libpcap_try_record(wtap *wth, FILE_T fh, int *err, gchar **err_info)
 	return 0;
 }
 
+/*
+ * How far past the offset we're given we look for a record header.
+ */
+#define RESYNC_WINDOW	(1024*1024)
+
+/*
+ * Find the first offset at or after off that looks like the header of
+ * a record, followed by more records that look sane.  pcap records
+ * don't have a marker, so we check the header at each byte offset and
+ * then use the same test on the records after it that we use to tell
+ * the variants apart.
+ */
+static gboolean
+libpcap_resync(wtap *wth, gint64 off, gint64 *rec_off, int *err,
+    gchar **err_info)
+{
+	libpcap_t *libpcap = (libpcap_t *)wth->priv;
+	guint32 frac_limit = libpcap->variant == PCAP_NSEC ? 1000000000 : 1000000;
+	struct pcaprec_hdr hdr;
+	guint8 *window;
+	int bytes_read, i, ret;
+
+	if (file_seek(wth->fh, off, SEEK_SET, err) == -1)
+		return FALSE;
+	window = (guint8 *)g_malloc(RESYNC_WINDOW);
+	bytes_read = file_read(window, RESYNC_WINDOW, wth->fh);
+	if (bytes_read < 0) {
+		*err = file_error(wth->fh, err_info);
+		g_free(window);
+		return FALSE;
+	}
+
+	for (i = 0; i + (int)sizeof hdr <= bytes_read; i++) {
+		memcpy(&hdr, window + i, sizeof hdr);
+		if (libpcap->byte_swapped) {
+			hdr.ts_usec = GUINT32_SWAP_LE_BE(hdr.ts_usec);
+			hdr.incl_len = GUINT32_SWAP_LE_BE(hdr.incl_len);
+			hdr.orig_len = GUINT32_SWAP_LE_BE(hdr.orig_len);
+		}
+		if (hdr.ts_usec >= frac_limit ||
+		    hdr.incl_len > hdr.orig_len ||
+		    hdr.incl_len > wth->snapshot_length ||
+		    hdr.incl_len > wtap_max_snaplen_for_encap(wth->file_encap) ||
+		    hdr.orig_len > 128*1024*1024)
+			continue;
+
+		if (file_seek(wth->fh, off + i, SEEK_SET, err) == -1) {
+			g_free(window);
+			return FALSE;
+		}
+		ret = libpcap_try(wth, err, err_info);
+		if (ret == -1) {
+			g_free(window);
+			return FALSE;
+		}
+		if (ret == 0) {
+			g_free(window);
+			*rec_off = off + i;
+			return TRUE;
+		}
+		g_free(*err_info);
+		*err_info = NULL;
+	}
+
+	/* Nothing that looks like a record; not an error. */
+	g_free(window);
+	*err = 0;
+	return FALSE;
+}
+
 /* Read the next packet */
 static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info, gint64 *data_offset)
@@ -927,8 +1007,12 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	rec->rec_header.packet_header.len = orig_size;
 
 	/*
-	 * Read the packet data.
+	 * Read the packet data, or skip it if this is a sequential read
+	 * and our caller doesn't want it.
 	 */
+	if (fh == wth->fh && wth->skip_packet_data)
+		return wtap_read_bytes(fh, NULL, packet_size, err, err_info);
+
 	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
 		return FALSE;	/* failed */
 
@@ -70,11 +70,248 @@ merge_idb_merge_mode_to_string(const int mode)
 }
 
 
+/*
+ * Reading ahead.  When merging more than one file, each input file gets
+ * a thread that reads records into a small ring of slots while we merge,
+ * so that waiting for one file's I/O or decompression overlaps with
+ * reading the other files and writing the output.  Once a file's thread
+ * is running, only that thread may call into its wtap; the records,
+ * along with whatever DSBs were read with them and the file position,
+ * are handed over through the ring.
+ */
+#define MERGE_PREFETCH_SLOTS        64
+#define MERGE_PREFETCH_MAX_FILES    256     /* don't start more threads than this */
+
+typedef struct {
+    wtap_rec    rec;
+    Buffer      frame_buffer;
+    gboolean    got_record;     /* FALSE at EOF or on an error */
+    int         err;
+    gchar      *err_info;
+    GArray     *dsbs;           /* DSBs read along with this record, or NULL */
+    gint64      read_so_far;
+} merge_prefetch_slot_t;
+
+typedef struct merge_prefetch_s {
+    GThread    *thread;
+    GMutex      mutex;
+    GCond       not_empty;
+    GCond       not_full;
+    guint       head;           /* first filled slot */
+    guint       count;          /* number of filled slots */
+    gboolean    stop;           /* TRUE if the thread should quit */
+    guint       dsbs_read;      /* number of wth->dsbs seen by the thread */
+    GArray     *dsbs;           /* DSBs of the record handed out last */
+    merge_prefetch_slot_t slots[MERGE_PREFETCH_SLOTS];
+} merge_prefetch_t;
+
+static gpointer
+merge_prefetch_thread(gpointer data)
+{
+    merge_in_file_t *in_file = (merge_in_file_t *)data;
+    merge_prefetch_t *pf = in_file->prefetch;
+    merge_prefetch_slot_t *slot;
+    GArray *in_dsb;
+    gint64 data_offset;
+    gboolean got_record;
+
+    do {
+        g_mutex_lock(&pf->mutex);
+        while (pf->count == MERGE_PREFETCH_SLOTS && !pf->stop)
+            g_cond_wait(&pf->not_full, &pf->mutex);
+        if (pf->stop) {
+            g_mutex_unlock(&pf->mutex);
+            break;
+        }
+        slot = &pf->slots[(pf->head + pf->count) % MERGE_PREFETCH_SLOTS];
+        g_mutex_unlock(&pf->mutex);
+
+        /* The slot isn't filled yet, so the merging side leaves it alone. */
+        got_record = wtap_read(in_file->wth, &slot->rec, &slot->frame_buffer,
+                               &slot->err, &slot->err_info, &data_offset);
+        slot->got_record = got_record;
+        slot->read_so_far = wtap_read_so_far(in_file->wth);
+        in_dsb = in_file->wth->dsbs;
+        if (in_dsb != NULL && in_dsb->len > pf->dsbs_read) {
+            slot->dsbs = g_array_sized_new(FALSE, FALSE, sizeof(wtap_block_t),
+                                           in_dsb->len - pf->dsbs_read);
+            g_array_append_vals(slot->dsbs,
+                                &g_array_index(in_dsb, wtap_block_t, pf->dsbs_read),
+                                in_dsb->len - pf->dsbs_read);
+            pf->dsbs_read = in_dsb->len;
+        }
+
+        g_mutex_lock(&pf->mutex);
+        pf->count++;
+        g_cond_signal(&pf->not_empty);
+        g_mutex_unlock(&pf->mutex);
+    } while (got_record);
+
+    return NULL;
+}
+
+static void
+merge_prefetch_start(merge_in_file_t *in_file)
+{
+    merge_prefetch_t *pf;
+    guint i;
+
+    pf = g_new0(merge_prefetch_t, 1);
+    g_mutex_init(&pf->mutex);
+    g_cond_init(&pf->not_empty);
+    g_cond_init(&pf->not_full);
+    for (i = 0; i < MERGE_PREFETCH_SLOTS; i++) {
+        wtap_rec_init(&pf->slots[i].rec);
+        ws_buffer_init(&pf->slots[i].frame_buffer, 1514);
+    }
+    pf->dsbs_read = in_file->dsbs_seen;
+
+    in_file->prefetch = pf;
+    pf->thread = g_thread_try_new("merge prefetch", merge_prefetch_thread,
+                                  in_file, NULL);
+    if (pf->thread == NULL) {
+        /* No thread; just read the file ourselves. */
+        in_file->prefetch = NULL;
+        for (i = 0; i < MERGE_PREFETCH_SLOTS; i++) {
+            wtap_rec_cleanup(&pf->slots[i].rec);
+            ws_buffer_free(&pf->slots[i].frame_buffer);
+        }
+        g_cond_clear(&pf->not_full);
+        g_cond_clear(&pf->not_empty);
+        g_mutex_clear(&pf->mutex);
+        g_free(pf);
+    }
+}
+
+/*
+ * Stop the reader thread, if there is one, and throw away whatever it
+ * read that we didn't use.  The thread finishes the read it's in the
+ * middle of first.
+ */
+static void
+merge_prefetch_stop(merge_in_file_t *in_file)
+{
+    merge_prefetch_t *pf = in_file->prefetch;
+    guint i;
+
+    if (pf == NULL)
+        return;
+
+    g_mutex_lock(&pf->mutex);
+    pf->stop = TRUE;
+    g_cond_signal(&pf->not_full);
+    g_mutex_unlock(&pf->mutex);
+    g_thread_join(pf->thread);
+
+    for (i = 0; i < pf->count; i++)
+        g_free(pf->slots[(pf->head + i) % MERGE_PREFETCH_SLOTS].err_info);
+    for (i = 0; i < MERGE_PREFETCH_SLOTS; i++) {
+        wtap_rec_cleanup(&pf->slots[i].rec);
+        ws_buffer_free(&pf->slots[i].frame_buffer);
+        if (pf->slots[i].dsbs != NULL)
+            g_array_free(pf->slots[i].dsbs, TRUE);
+    }
+    if (pf->dsbs != NULL)
+        g_array_free(pf->dsbs, TRUE);
+    g_cond_clear(&pf->not_full);
+    g_cond_clear(&pf->not_empty);
+    g_mutex_clear(&pf->mutex);
+    g_free(pf);
+    in_file->prefetch = NULL;
+}
+
+/*
+ * Read the next record from in_file into in_file->rec and
+ * in_file->frame_buffer, from the reader thread if there is one;
+ * returns what wtap_read() would.
+ */
+static gboolean
+merge_in_file_read(merge_in_file_t *in_file, int *err, gchar **err_info)
+{
+    merge_prefetch_t *pf = in_file->prefetch;
+    merge_prefetch_slot_t *slot;
+    wtap_rec tmp_rec;
+    Buffer tmp_buffer;
+    gint64 data_offset;
+    gboolean got_record;
+
+    if (pf == NULL) {
+        got_record = wtap_read(in_file->wth, &in_file->rec,
+                               &in_file->frame_buffer, err, err_info,
+                               &data_offset);
+        in_file->read_so_far = wtap_read_so_far(in_file->wth);
+        return got_record;
+    }
+
+    g_mutex_lock(&pf->mutex);
+    while (pf->count == 0)
+        g_cond_wait(&pf->not_empty, &pf->mutex);
+    slot = &pf->slots[pf->head];
+    g_mutex_unlock(&pf->mutex);
+
+    /*
+     * Swap the record and its data with ours, which the thread
+     * can read the record after next into.
+     */
+    tmp_rec = in_file->rec;
+    in_file->rec = slot->rec;
+    slot->rec = tmp_rec;
+    tmp_buffer = in_file->frame_buffer;
+    in_file->frame_buffer = slot->frame_buffer;
+    slot->frame_buffer = tmp_buffer;
+
+    got_record = slot->got_record;
+    *err = slot->err;
+    *err_info = slot->err_info;
+    slot->err_info = NULL;
+    in_file->read_so_far = slot->read_so_far;
+    if (pf->dsbs != NULL)
+        g_array_free(pf->dsbs, TRUE);
+    pf->dsbs = slot->dsbs;
+    slot->dsbs = NULL;
+
+    g_mutex_lock(&pf->mutex);
+    pf->head = (pf->head + 1) % MERGE_PREFETCH_SLOTS;
+    pf->count--;
+    g_cond_signal(&pf->not_full);
+    g_mutex_unlock(&pf->mutex);
+
+    return got_record;
+}
+
+/*
+ * Pass the DSBs read before the current record of in_file, if any, on
+ * to the dumper.
+ */
+static void
+merge_in_file_copy_dsbs(merge_in_file_t *in_file, GArray *dsb_combined)
+{
+    merge_prefetch_t *pf = in_file->prefetch;
+
+    if (pf != NULL) {
+        if (pf->dsbs != NULL) {
+            g_array_append_vals(dsb_combined, pf->dsbs->data, pf->dsbs->len);
+            in_file->dsbs_seen += pf->dsbs->len;
+            g_array_free(pf->dsbs, TRUE);
+            pf->dsbs = NULL;
+        }
+    } else if (in_file->wth->dsbs) {
+        GArray *in_dsb = in_file->wth->dsbs;
+        for (guint i = in_file->dsbs_seen; i < in_dsb->len; i++) {
+            wtap_block_t wblock = g_array_index(in_dsb, wtap_block_t, i);
+            g_array_append_val(dsb_combined, wblock);
+            in_file->dsbs_seen++;
+        }
+    }
+}
+
 static void
 cleanup_in_file(merge_in_file_t *in_file)
 {
     g_assert(in_file != NULL);
 
+    merge_prefetch_stop(in_file);
+
     wtap_close(in_file->wth);
     in_file->wth = NULL;
 
@@ -206,21 +443,99 @@ merge_select_frame_type(int in_file_count, merge_in_file_t in_files[])
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * Binary min-heap of the input files that have a record present, ordered
+ * by the time stamp of that record, so that picking the next record to
+ * write doesn't mean looking at every input file.
+ */
+typedef struct {
+    merge_in_file_t **files;    /* heap of files with a record present */
+    guint             count;    /* number of files in the heap */
+    merge_in_file_t  *last;     /* file of the record we handed out last */
+    gboolean          started;  /* TRUE once we've read from all files */
+} merge_heap_t;
+
+/*
+ * Returns TRUE if the record from file l should be written before the
+ * record from file r.
+ *
+ * Records with no time stamp come first, in file order; otherwise, of two
+ * records with the same time stamp, the one from the later file comes
+ * first, as that's the order in which we've always merged them.
  */
 static gboolean
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_heap_before(const merge_in_file_t *l, const merge_in_file_t *r)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return FALSE;
-    } else if (l->secs < r->secs) { /* left is earlier */
+    gboolean l_has_ts = (l->rec.presence_flags & WTAP_HAS_TS) != 0;
+    gboolean r_has_ts = (r->rec.presence_flags & WTAP_HAS_TS) != 0;
+
+    if (!l_has_ts || !r_has_ts) {
+        if (l_has_ts != r_has_ts)
+            return !l_has_ts;
+        return l < r;
+    }
+    if (l->rec.ts.secs != r->rec.ts.secs)
+        return l->rec.ts.secs < r->rec.ts.secs;
+    if (l->rec.ts.nsecs != r->rec.ts.nsecs)
+        return l->rec.ts.nsecs < r->rec.ts.nsecs;
+    return l > r;
+}
+
+static void
+merge_heap_push(merge_heap_t *heap, merge_in_file_t *in_file)
+{
+    guint i, parent;
+
+    /* Sift up. */
+    for (i = heap->count++; i != 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (!merge_heap_before(in_file, heap->files[parent]))
+            break;
+        heap->files[i] = heap->files[parent];
+    }
+    heap->files[i] = in_file;
+}
+
+static merge_in_file_t *
+merge_heap_pop(merge_heap_t *heap)
+{
+    merge_in_file_t *top, *in_file;
+    guint i, child;
+
+    top = heap->files[0];
+    in_file = heap->files[--heap->count];
+
+    /* Sift the last file down from the top. */
+    for (i = 0; (child = 2 * i + 1) < heap->count; i = child) {
+        if (child + 1 < heap->count &&
+            merge_heap_before(heap->files[child + 1], heap->files[child]))
+            child++;
+        if (!merge_heap_before(heap->files[child], in_file))
+            break;
+        heap->files[i] = heap->files[child];
+    }
+    if (heap->count != 0)
+        heap->files[i] = in_file;
+    return top;
+}
+
+/*
+ * Read the next record from in_file and, if there is one, add the file
+ * to the heap.  Returns FALSE on a read error.
+ */
+static gboolean
+merge_heap_read(merge_heap_t *heap, merge_in_file_t *in_file,
+                int *err, gchar **err_info)
+{
+    if (!merge_in_file_read(in_file, err, err_info)) {
+        if (*err != 0) {
+            in_file->state = GOT_ERROR;
+            return FALSE;
+        }
+        in_file->state = AT_EOF;
         return TRUE;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
-        return FALSE;
     }
-    /* either one < two or one == two
-     * either way, return one
-     */
+    in_file->state = RECORD_PRESENT;
+    merge_heap_push(heap, in_file);
     return TRUE;
 }
 
@@ -238,6 +553,8 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  *
  * @param in_file_count number of entries in in_files
  * @param in_files input file array
+ * @param heap heap of files with a record present, with room for
+ * in_file_count files
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -246,79 +563,56 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  */
 static merge_in_file_t *
 merge_read_packet(int in_file_count, merge_in_file_t in_files[],
-                  int *err, gchar **err_info)
+                  merge_heap_t *heap, int *err, gchar **err_info)
 {
     int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
+    merge_in_file_t *in_file;
 
     /*
      * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
+     * EOF; the caller is done with the record we handed out last, so
+     * that file is the only one, other than at the beginning, that
+     * needs another read.  Files at EOF just drop out of the heap.
      */
-    for (i = 0; i < in_file_count; i++) {
-        gint64 data_offset;
-
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec,
-                           &in_files[i].frame_buffer, err, err_info,
-                           &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
-            }
+    if (!heap->started) {
+        for (i = 0; i < in_file_count; i++) {
+            if (!merge_heap_read(heap, &in_files[i], err, err_info))
+                return &in_files[i];
         }
+        heap->started = TRUE;
+    } else if (heap->last != NULL) {
+        if (!merge_heap_read(heap, heap->last, err, err_info))
+            return heap->last;
+        heap->last = NULL;
     }
 
-    if (ei == -1) {
+    if (heap->count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    /*
+     * Pick the record with the earliest time stamp, or with no time
+     * stamp (those records are treated as earlier than all other
+     * records).  Yes, this means you won't get a chronological merge
+     * of those records, but you obviously *can't* get that.
+     */
+    in_file = merge_heap_pop(heap);
+
     /* We'll need to read another packet from this file. */
-    in_files[ei].state = RECORD_NOT_PRESENT;
+    in_file->state = RECORD_NOT_PRESENT;
+    heap->last = in_file;
 
     /* Count this packet. */
-    in_files[ei].packet_num++;
+    in_file->packet_num++;
 
     /*
      * Return a pointer to the merge_in_file_t of the file from which the
      * packet was read.
      */
     *err = 0;
-    return &in_files[ei];
+    return in_file;
 }
 
 /** Read the next packet, in file sequence order, from the set of files
@@ -346,7 +640,6 @@ merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
                          int *err, gchar **err_info)
 {
     int i;
-    gint64 data_offset;
 
     /*
      * Find the first file not at EOF, and read the next packet from it.
@@ -354,9 +647,7 @@ merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
     for (i = 0; i < in_file_count; i++) {
         if (in_files[i].state == AT_EOF)
             continue; /* This file is already at EOF */
-        if (wtap_read(in_files[i].wth, &in_files[i].rec,
-                      &in_files[i].frame_buffer, err, err_info,
-                      &data_offset))
+        if (merge_in_file_read(&in_files[i], err, err_info))
             break; /* We have a packet */
         if (*err != 0) {
             /* Read error - quit immediately. */
@@ -850,6 +1141,17 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     wtap_rec *rec,      snap_rec;
+    merge_heap_t        heap;
+
+    heap.files = g_new(merge_in_file_t *, in_file_count);
+    heap.count = 0;
+    heap.last = NULL;
+    heap.started = FALSE;
+
+    if (in_file_count > 1 && in_file_count <= MERGE_PREFETCH_MAX_FILES) {
+        for (guint i = 0; i < in_file_count; i++)
+            merge_prefetch_start(&in_files[i]);
+    }
 
     for (;;) {
         *err = 0;
@@ -859,7 +1161,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
+            in_file = merge_read_packet(in_file_count, in_files, &heap, err,
                                         err_info);
         }
 
@@ -933,14 +1235,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
          * If any DSBs were read before this record, be sure to pass those now
          * such that wtap_dump can pick it up.
          */
-        if (dsb_combined && in_file->wth->dsbs) {
-            GArray *in_dsb = in_file->wth->dsbs;
-            for (guint i = in_file->dsbs_seen; i < in_dsb->len; i++) {
-                wtap_block_t wblock = g_array_index(in_dsb, wtap_block_t, i);
-                g_array_append_val(dsb_combined, wblock);
-                in_file->dsbs_seen++;
-            }
-        }
+        if (dsb_combined)
+            merge_in_file_copy_dsbs(in_file, dsb_combined);
 
         if (!wtap_dump(pdh, rec, ws_buffer_start_ptr(&in_file->frame_buffer),
                        err, err_info)) {
@@ -949,6 +1245,10 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         }
     }
 
+    g_free(heap.files);
+    for (guint i = 0; i < in_file_count; i++)
+        merge_prefetch_stop(&in_files[i]);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -37,6 +37,8 @@ typedef struct merge_in_file_s {
     gint64          size;           /* file size */
     GArray         *idb_index_map;  /* used for mapping the old phdr interface_id values to new during merge */
     guint           dsbs_seen;      /* number of elements processed so far from wth->dsbs */
+    gint64          read_so_far;    /* wtap_read_so_far() as of the current record */
+    struct merge_prefetch_s *prefetch; /* reader thread, if we're reading ahead */
 } merge_in_file_t;
 
 /** Return values from merge_files(). */
@@ -104,6 +106,10 @@ merge_idb_merge_mode_to_string(const int mode);
  * of the created merge info, in_file_count is the size of the array, data is
  * whatever was passed in the data member of this struct. The callback_func
  * routine's return value should be TRUE if merging should be aborted.
+ * The input files may be read by other threads while merging, so for a
+ * MERGE_EVENT_RECORD_WAS_READ callback only the wth's fixed properties,
+ * such as its file and encapsulation types, may be looked at; use
+ * read_so_far for progress rather than wtap_read_so_far().
  */
 typedef struct {
     gboolean (*callback_func)(merge_event event, int num,
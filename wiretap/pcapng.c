@@ -243,8 +243,54 @@ typedef struct {
     GArray *sections;             /**< Sections found in the capture file. */
     wtap_new_ipv4_callback_t add_new_ipv4;
     wtap_new_ipv6_callback_t add_new_ipv6;
+    GArray *record_index;         /**< Record index entries, or NULL if there's no usable index */
 } pcapng_t;
 
+/*
+ * Record index block.
+ *
+ * If asked to, we write, as the last block of the file, a block that
+ * gives the file offset of every Nth record, so that a reader that can
+ * seek can go straight to a given record, or to the records around a
+ * given time, rather than reading everything before it.  This isn't a
+ * standard block type; it uses a block type code reserved for local use,
+ * and a magic number at the start of the body in case somebody else
+ * uses that code, and readers that don't know about it just skip it.
+ *
+ * Offsets are relative to the start of the section, and an index is
+ * only used if the section starts at the beginning of the file, so
+ * that one from the last part of concatenated files is ignored.
+ */
+#define BLOCK_TYPE_RECORD_INDEX     0x8057A1D0  /* local use */
+#define RECORD_INDEX_MAGIC          "WSRECIDX"
+#define RECORD_INDEX_VERSION        1
+#define RECORD_INDEX_MAX_ENTRIES    65536       /* then index every other one */
+#define RECORD_INDEX_NO_TIME        G_MININT64  /* no time stamps yet */
+
+typedef struct pcapng_record_index_header_s {
+    guint8  magic[8];           /* RECORD_INDEX_MAGIC */
+    guint32 version;            /* RECORD_INDEX_VERSION */
+    guint32 stride;             /* number of records per entry */
+    guint32 num_entries;
+    guint32 num_records;        /* number of records in the section */
+    guint64 index_offset;       /* offset of this block in the section */
+} pcapng_record_index_header_t;
+
+typedef struct pcapng_record_index_entry_s {
+    guint64 offset;             /* offset of the record's block */
+    gint64  max_ts_before;      /* latest time of the records before it, in ns */
+    guint32 record_num;         /* 1-origin number of the record */
+    guint32 num_interfaces;     /* number of IDBs before it */
+} pcapng_record_index_entry_t;
+
+/* State for writing a record index. */
+typedef struct {
+    GArray  *entries;           /* pcapng_record_index_entry_t's */
+    guint32 stride;
+    guint32 num_records;
+    gint64  max_ts;             /* latest time stamp so far, in ns */
+} pcapng_dump_t;
+
 /*
  * Table for plugins to handle particular block types.
  *
@@ -1276,15 +1322,342 @@ pcapng_read_decryption_secrets_block(FILE_T fh, pcapng_block_header_t *bh,
     return TRUE;
 }
 
+/*
+ * Set a packet's comment from a comment option, reusing the memory for
+ * the comment from an earlier record if it's big enough.
+ */
+static void
+pcapng_set_packet_comment(wtap_rec *rec, const guint8 *option_content,
+                          guint16 option_length)
+{
+    const guint8 *nul;
+    gsize len;
+
+    /* Like g_strndup(), stop at a NUL in the option. */
+    nul = (const guint8 *)memchr(option_content, '\0', option_length);
+    len = (nul != NULL) ? (gsize)(nul - option_content) : option_length;
+    if (rec->opt_comment != NULL && strlen(rec->opt_comment) >= len) {
+        memcpy(rec->opt_comment, option_content, len);
+        rec->opt_comment[len] = '\0';
+    } else {
+        g_free(rec->opt_comment);
+        rec->opt_comment = g_strndup((const char *)option_content, len);
+    }
+}
+
+/*
+ * Get the option at the beginning of the "to_read" bytes of options
+ * at "opt_ptr", already in memory, with its header put into "oh" in
+ * host byte order.  Returns the number of bytes the option takes up,
+ * including padding, or -1 on error; this does the same sanity checks
+ * as pcapng_read_option().
+ */
+static int
+pcapng_get_option(const section_info_t *section_info,
+                  const guint8 *opt_ptr, guint to_read,
+                  pcapng_option_header_t *oh, const guint8 **content,
+                  int *err, gchar **err_info, const gchar *block_name)
+{
+    guint   block_read;
+
+    /* sanity check: don't run past the end of the block */
+    if (to_read < sizeof (*oh)) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("pcapng_read_option: Not enough data to read header of the %s block",
+                                    block_name);
+        return -1;
+    }
+
+    /* get option header */
+    memcpy(oh, opt_ptr, sizeof (*oh));
+    if (section_info->byte_swapped) {
+        oh->option_code      = GUINT16_SWAP_LE_BE(oh->option_code);
+        oh->option_length    = GUINT16_SWAP_LE_BE(oh->option_length);
+    }
+
+    /* sanity check: don't run past the end of the block */
+    if (to_read < sizeof (*oh) + oh->option_length) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("pcapng_read_option: Not enough data to handle option length (%d) of the %s block",
+                                    oh->option_length, block_name);
+        return -1;
+    }
+    *content = opt_ptr + sizeof (*oh);
+    block_read = (guint)sizeof (*oh) + oh->option_length;
+
+    /* jump over potential padding bytes at end of option */
+    if ((oh->option_length % 4) != 0)
+        block_read += 4 - (oh->option_length % 4);
+
+    /* some writers leave out the padding of the last option */
+    return (int)MIN(block_read, to_read);
+}
+
+/*
+ * Process the "opt_len" bytes of options of an (Enhanced) Packet Block
+ * at "opt_ptr".  They're only read, never modified, so they can be
+ * parsed in place in the read buffer.
+ */
+static gboolean
+pcapng_process_packet_block_options(wtapng_block_t *wblock,
+                                    const section_info_t *section_info,
+                                    const guint8 *opt_ptr, guint opt_len,
+                                    int *fcslen, gboolean *got_comment,
+                                    int *err, gchar **err_info)
+{
+    guint to_read;
+    int bytes_read;
+    pcapng_option_header_t oh;
+    const guint8 *option_content;
+    guint8 *option_content_copy;
+
+    to_read = opt_len;
+    while (to_read != 0) {
+        /* get option */
+        bytes_read = pcapng_get_option(section_info, opt_ptr, to_read, &oh, &option_content, err, err_info, "packet");
+        if (bytes_read <= 0) {
+            pcapng_debug("pcapng_read_packet_block: failed to read option");
+            /* XXX - free anything? */
+            return FALSE;
+        }
+        opt_ptr += bytes_read;
+        to_read -= bytes_read;
+
+        /*
+         * Handle option content.
+         *
+         * ***DO NOT*** add any items to this table that are not
+         * standardized option codes in either section 3.5 "Options"
+         * of the current pcapng spec, at
+         *
+         *    https://pcapng.github.io/pcapng/draft-tuexen-opsawg-pcapng.html#name-options
+         *
+         * or in the list of options in section 4.3 "Enhanced Packet Block"
+         * of the current pcapng spec, at
+         *
+         *    https://pcapng.github.io/pcapng/draft-tuexen-opsawg-pcapng.html#name-enhanced-packet-block
+         *
+         * All option codes in this switch statement here must be listed
+         * in one of those places as standardized option types.
+         */
+        switch (oh.option_code) {
+            case(OPT_EOFOPT):
+                if (to_read != 0) {
+                    pcapng_debug("pcapng_read_packet_block: %u bytes after opt_endofopt", to_read);
+                }
+                /* padding should be ok here, just get out of this */
+                to_read = 0;
+                break;
+            case(OPT_COMMENT):
+                if (oh.option_length > 0 && oh.option_length < opt_len) {
+                    wblock->rec->presence_flags |= WTAP_HAS_COMMENTS;
+                    pcapng_set_packet_comment(wblock->rec, option_content, oh.option_length);
+                    *got_comment = TRUE;
+                    pcapng_debug("pcapng_read_packet_block: length %u opt_comment '%s'", oh.option_length, wblock->rec->opt_comment);
+                } else {
+                    pcapng_debug("pcapng_read_packet_block: opt_comment length %u seems strange", oh.option_length);
+                }
+                break;
+            case(OPT_EPB_FLAGS):
+                if (oh.option_length != 4) {
+                    *err = WTAP_ERR_BAD_FILE;
+                    *err_info = g_strdup_printf("pcapng_read_packet_block: packet block flags option length %u is not 4",
+                                                oh.option_length);
+                    /* XXX - free anything? */
+                    return FALSE;
+                }
+                /*  Don't cast a guint8 * into a guint32 *--the
+                 *  guint8 * may not point to something that's
+                 *  aligned correctly.
+                 */
+                wblock->rec->presence_flags |= WTAP_HAS_PACK_FLAGS;
+                memcpy(&wblock->rec->rec_header.packet_header.pack_flags, option_content, sizeof(guint32));
+                if (section_info->byte_swapped) {
+                    wblock->rec->rec_header.packet_header.pack_flags = GUINT32_SWAP_LE_BE(wblock->rec->rec_header.packet_header.pack_flags);
+                }
+                if (PACK_FLAGS_FCS_LENGTH(wblock->rec->rec_header.packet_header.pack_flags) != 0) {
+                    /* The FCS length is present */
+                    *fcslen = PACK_FLAGS_FCS_LENGTH(wblock->rec->rec_header.packet_header.pack_flags);
+                }
+                pcapng_debug("pcapng_read_packet_block: pack_flags %u (ignored)", wblock->rec->rec_header.packet_header.pack_flags);
+                break;
+            case(OPT_EPB_HASH):
+                pcapng_debug("pcapng_read_packet_block: epb_hash %u currently not handled - ignoring %u bytes",
+                              oh.option_code, oh.option_length);
+                break;
+            case(OPT_EPB_DROPCOUNT):
+                if (oh.option_length != 8) {
+                    *err = WTAP_ERR_BAD_FILE;
+                    *err_info = g_strdup_printf("pcapng_read_packet_block: packet block drop count option length %u is not 8",
+                                                oh.option_length);
+                    /* XXX - free anything? */
+                    return FALSE;
+                }
+                /*  Don't cast a guint8 * into a guint64 *--the
+                 *  guint8 * may not point to something that's
+                 *  aligned correctly.
+                 */
+                wblock->rec->presence_flags |= WTAP_HAS_DROP_COUNT;
+                memcpy(&wblock->rec->rec_header.packet_header.drop_count, option_content, sizeof(guint64));
+                if (section_info->byte_swapped) {
+                    wblock->rec->rec_header.packet_header.drop_count = GUINT64_SWAP_LE_BE(wblock->rec->rec_header.packet_header.drop_count);
+                }
+
+                pcapng_debug("pcapng_read_packet_block: drop_count %" G_GINT64_MODIFIER "u", wblock->rec->rec_header.packet_header.drop_count);
+                break;
+            case(OPT_EPB_PACKETID):
+                if (oh.option_length != 8) {
+                    *err = WTAP_ERR_BAD_FILE;
+                    *err_info = g_strdup_printf("pcapng_read_packet_block: packet block packet id option length %u is not 8",
+                                                oh.option_length);
+                    /* XXX - free anything? */
+                    return FALSE;
+                }
+                /*  Don't cast a guint8 * into a guint64 *--the
+                 *  guint8 * may not point to something that's
+                 *  aligned correctly.
+                 */
+                wblock->rec->presence_flags |= WTAP_HAS_PACKET_ID;
+                memcpy(&wblock->rec->rec_header.packet_header.packet_id, option_content, sizeof(guint64));
+                if (section_info->byte_swapped) {
+                    wblock->rec->rec_header.packet_header.packet_id = GUINT64_SWAP_LE_BE(wblock->rec->rec_header.packet_header.packet_id);
+                }
+                pcapng_debug("pcapng_read_packet_block: packet_id %" G_GINT64_MODIFIER "u", wblock->rec->rec_header.packet_header.packet_id);
+                break;
+            case(OPT_EPB_QUEUE):
+                if (oh.option_length != 4) {
+                    *err = WTAP_ERR_BAD_FILE;
+                    *err_info = g_strdup_printf("pcapng_read_packet_block: packet block queue option length %u is not 4",
+                                                oh.option_length);
+                    /* XXX - free anything? */
+                    return FALSE;
+                }
+                /*  Don't cast a guint8 * into a guint32 *--the
+                 *  guint8 * may not point to something that's
+                 *  aligned correctly.
+                 */
+                wblock->rec->presence_flags |= WTAP_HAS_INT_QUEUE;
+                memcpy(&wblock->rec->rec_header.packet_header.interface_queue, option_content, sizeof(guint32));
+                if (section_info->byte_swapped) {
+                    wblock->rec->rec_header.packet_header.interface_queue = GUINT32_SWAP_LE_BE(wblock->rec->rec_header.packet_header.interface_queue);
+                }
+                pcapng_debug("pcapng_read_packet_block: queue %u", wblock->rec->rec_header.packet_header.interface_queue);
+                break;
+            case(OPT_EPB_VERDICT):
+                if (oh.option_length < 1 ||
+                    ((option_content[0] == OPT_VERDICT_TYPE_TC ||
+                      option_content[0] == OPT_VERDICT_TYPE_XDP) &&
+                     oh.option_length != 9)) {
+                    *err = WTAP_ERR_BAD_FILE;
+                    if (oh.option_length < 1)
+                        *err_info = g_strdup_printf("pcapng_read_packet_block: packet block verdict option length %u is < 1",
+                                                    oh.option_length);
+                    else
+                        *err_info = g_strdup_printf("pcapng_read_packet_block: packet block verdict option length %u is != 9",
+                                                    oh.option_length);
+                    /* XXX - free anything? */
+                    return FALSE;
+                }
+                /* Silently ignore unknown options */
+                if (option_content[0] > OPT_VERDICT_TYPE_XDP)
+                    break;
+
+                wblock->rec->presence_flags |= WTAP_HAS_VERDICT;
+                if (wblock->rec->packet_verdict == NULL)
+                    wblock->rec->packet_verdict = g_ptr_array_new_with_free_func((GDestroyNotify) g_bytes_unref);
+
+                option_content_copy = (guint8 *)g_memdup2(option_content, oh.option_length);
+
+                /*
+                 * For Linux XDP and TC we might need to byte swap; do
+                 * that in the copy we hand to the caller, as the option
+                 * content might be read-only (mapped from the file).
+                 */
+                if (section_info->byte_swapped &&
+                    (option_content[0] == OPT_VERDICT_TYPE_TC ||
+                     option_content[0] == OPT_VERDICT_TYPE_XDP)) {
+                    guint64 result;
+
+                    memcpy(&result, option_content_copy + 1, sizeof(result));
+                    result = GUINT64_SWAP_LE_BE(result);
+                    memcpy(option_content_copy + 1, &result, sizeof(result));
+                }
+
+                g_ptr_array_add(wblock->rec->packet_verdict,
+                                g_bytes_new_with_free_func(option_content_copy,
+                                                           oh.option_length,
+                                                           g_free,
+                                                           option_content_copy));
+                pcapng_debug("pcapng_read_packet_block: verdict type %u, data len %u",
+                             option_content[0], oh.option_length - 1);
+                break;
+            default:
+                pcapng_debug("pcapng_read_packet_block: unknown option %u - ignoring %u bytes",
+                              oh.option_code, oh.option_length);
+                break;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * If the body of the (Enhanced) Packet Block with the header "bh" is
+ * entirely in the read buffer, and can be parsed without reading any
+ * more from the file, consume it and return a pointer to it, so it can
+ * be parsed in place; otherwise, return NULL without consuming anything,
+ * with *err set to 0 unless there was an error.
+ *
+ * The pointer is valid until the block trailer is read.
+ */
+static const guint8 *
+pcapng_get_block_body_in_place(FILE_T fh, pcapng_block_header_t *bh,
+                               const section_info_t *section_info,
+                               int *err, gchar **err_info)
+{
+    guint32 body_len;
+    const guint8 *body;
+    pcapng_enhanced_packet_block_t epb;
+    guint32 interface_id;
+    interface_info_t iface_info;
+    union wtap_pseudo_header pseudo_header;
+
+    *err = 0;
+    body_len = ((bh->block_total_length + 3) & ~3U) - MIN_BLOCK_SIZE;
+    body = file_peek_bytes(fh, body_len);
+    if (body == NULL)
+        return NULL;
+
+    /*
+     * If there's a pseudo-header, pcap_process_pseudo_header() reads it
+     * from the file; leave that to the usual path.  If the interface
+     * isn't valid, let the usual path report that.
+     */
+    memcpy(&epb, body, sizeof epb);
+    interface_id = section_info->byte_swapped ?
+        GUINT32_SWAP_LE_BE(epb.interface_id) : epb.interface_id;
+    if (interface_id >= section_info->interfaces->len)
+        return NULL;
+    iface_info = g_array_index(section_info->interfaces, interface_info_t,
+                               interface_id);
+    memset(&pseudo_header, 0, sizeof pseudo_header);
+    if (pcap_get_phdr_size(iface_info.wtap_encap, &pseudo_header) != 0)
+        return NULL;
+
+    /* This doesn't copy anything; the data stays in the buffer. */
+    if (!wtap_read_bytes(fh, NULL, body_len, err, err_info))
+        return NULL;
+    return body;
+}
+
 static gboolean
 pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
                          const section_info_t *section_info,
                          wtapng_block_t *wblock,
                          int *err, gchar **err_info, gboolean enhanced)
 {
-    int bytes_read;
     guint block_read;
-    guint to_read, opt_cont_buf_len;
+    guint to_read;
+    const guint8 *body;
     pcapng_enhanced_packet_block_t epb;
     pcapng_packet_block_t pb;
     wtapng_packet_t packet;
@@ -1292,14 +1665,13 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     guint32 padding;
     interface_info_t iface_info;
     guint64 ts;
-    guint8 *opt_ptr;
-    pcapng_option_header_t *oh;
-    guint8 *option_content;
-    gpointer option_content_copy;
+    const guint8 *opt_ptr;
+    gboolean got_comment;
     int pseudo_header_len;
     int fcslen;
 
     /* "(Enhanced) Packet Block" read fixed part */
+    body = NULL;
     if (enhanced) {
         /*
          * Is this block long enough to be an EPB?
@@ -1313,9 +1685,22 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
                                         bh->block_total_length, MIN_EPB_SIZE);
             return FALSE;
         }
-        if (!wtap_read_bytes(fh, &epb, sizeof epb, err, err_info)) {
-            pcapng_debug("pcapng_read_packet_block: failed to read packet data");
-            return FALSE;
+
+        /*
+         * If the whole block is in the read buffer, as it nearly always
+         * is if the file is mapped into memory, parse it there rather
+         * than copying it out a field at a time.
+         */
+        body = pcapng_get_block_body_in_place(fh, bh, section_info, err, err_info);
+        if (body != NULL) {
+            memcpy(&epb, body, sizeof epb);
+        } else {
+            if (*err != 0)
+                return FALSE;
+            if (!wtap_read_bytes(fh, &epb, sizeof epb, err, err_info)) {
+                pcapng_debug("pcapng_read_packet_block: failed to read packet data");
+                return FALSE;
+            }
         }
         block_read = (guint)sizeof epb;
 
@@ -1444,276 +1829,122 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->rec_type = REC_TYPE_PACKET;
     wblock->rec->presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN|WTAP_HAS_INTERFACE_ID;
 
-    pcapng_debug("pcapng_read_packet_block: encapsulation = %d (%s), pseudo header size = %d.",
-                  iface_info.wtap_encap,
-                  wtap_encap_description(iface_info.wtap_encap),
-                  pcap_get_phdr_size(iface_info.wtap_encap, &wblock->rec->rec_header.packet_header.pseudo_header));
-    wblock->rec->rec_header.packet_header.interface_id = packet.interface_id;
-    wblock->rec->rec_header.packet_header.pkt_encap = iface_info.wtap_encap;
-    wblock->rec->tsprec = iface_info.tsprecision;
-
-    memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
-    pseudo_header_len = pcap_process_pseudo_header(fh,
-                                                   FALSE, /* not a Nokia pcap - not a pcap at all */
-                                                   iface_info.wtap_encap,
-                                                   packet.cap_len,
-                                                   wblock->rec,
-                                                   err,
-                                                   err_info);
-    if (pseudo_header_len < 0) {
-        return FALSE;
-    }
-    block_read += pseudo_header_len;
-    wblock->rec->rec_header.packet_header.caplen = packet.cap_len - pseudo_header_len;
-    wblock->rec->rec_header.packet_header.len = packet.packet_len - pseudo_header_len;
-
-    /* Combine the two 32-bit pieces of the timestamp into one 64-bit value */
-    ts = (((guint64)packet.ts_high) << 32) | ((guint64)packet.ts_low);
-    wblock->rec->ts.secs = (time_t)(ts / iface_info.time_units_per_second);
-    wblock->rec->ts.nsecs = (int)(((ts % iface_info.time_units_per_second) * 1000000000) / iface_info.time_units_per_second);
-
-    /* "(Enhanced) Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                packet.cap_len - pseudo_header_len, err, err_info))
-        return FALSE;
-    block_read += packet.cap_len - pseudo_header_len;
-
-    /* jump over potential padding bytes at end of the packet data */
-    if (padding != 0) {
-        if (!wtap_read_bytes(fh, NULL, padding, err, err_info))
-            return FALSE;
-        block_read += padding;
-    }
-
-    /* Option defaults */
-    g_free(wblock->rec->opt_comment);   /* Free memory from an earlier read. */
-    wblock->rec->opt_comment = NULL;
-    wblock->rec->rec_header.packet_header.drop_count  = -1;
-    wblock->rec->rec_header.packet_header.pack_flags  = 0;
-    wblock->rec->rec_header.packet_header.packet_id  = 0;
-    wblock->rec->rec_header.packet_header.interface_queue  = 0;
-    if (wblock->rec->packet_verdict != NULL) {
-        g_ptr_array_free(wblock->rec->packet_verdict, TRUE);
-        wblock->rec->packet_verdict = NULL;
-    }
-
-    /* FCS length default */
-    fcslen = iface_info.fcslen;
-
-    /* Options
-     * opt_comment    1
-     * epb_flags      2
-     * epb_hash       3
-     * epb_dropcount  4
-     * epb_packetid   5
-     * epb_queue      6
-     * epb_verdict    7
-     */
-    to_read = block_total_length -
-        (int)sizeof(pcapng_block_header_t) -
-        block_read -    /* fixed and variable part, including padding */
-        (int)sizeof(bh->block_total_length);
-
-    /* Ensure sufficient temporary memory to hold all options. It is not freed
-     * on return to avoid frequent reallocations. When called for sequential
-     * read (wtap_read), "wblock->rec == &wth->rec" (options_buf will be freed
-     * by wtap_sequential_close). For random access, memory is managed by the
-     * caller of wtap_seek_read. */
-    opt_cont_buf_len = to_read;
-    ws_buffer_assure_space(&wblock->rec->options_buf, opt_cont_buf_len);
-    opt_ptr = ws_buffer_start_ptr(&wblock->rec->options_buf);
-
-    while (to_read != 0) {
-        /* read option */
-        oh = (pcapng_option_header_t *)(void *)opt_ptr;
-        option_content = opt_ptr + sizeof (pcapng_option_header_t);
-        bytes_read = pcapng_read_option(fh, section_info, oh, option_content, opt_cont_buf_len, to_read, err, err_info, "packet");
-        if (bytes_read <= 0) {
-            pcapng_debug("pcapng_read_packet_block: failed to read option");
-            /* XXX - free anything? */
-            return FALSE;
-        }
-        to_read -= bytes_read;
-
-        /*
-         * Handle option content.
-         *
-         * ***DO NOT*** add any items to this table that are not
-         * standardized option codes in either section 3.5 "Options"
-         * of the current pcapng spec, at
-         *
-         *    https://pcapng.github.io/pcapng/draft-tuexen-opsawg-pcapng.html#name-options
-         *
-         * or in the list of options in section 4.3 "Enhanced Packet Block"
-         * of the current pcapng spec, at
-         *
-         *    https://pcapng.github.io/pcapng/draft-tuexen-opsawg-pcapng.html#name-enhanced-packet-block
-         *
-         * All option codes in this switch statement here must be listed
-         * in one of those places as standardized option types.
-         */
-        switch (oh->option_code) {
-            case(OPT_EOFOPT):
-                if (to_read != 0) {
-                    pcapng_debug("pcapng_read_packet_block: %u bytes after opt_endofopt", to_read);
-                }
-                /* padding should be ok here, just get out of this */
-                to_read = 0;
-                break;
-            case(OPT_COMMENT):
-                if (oh->option_length > 0 && oh->option_length < opt_cont_buf_len) {
-                    wblock->rec->presence_flags |= WTAP_HAS_COMMENTS;
-                    g_free(wblock->rec->opt_comment);
-                    wblock->rec->opt_comment = g_strndup((char *)option_content, oh->option_length);
-                    pcapng_debug("pcapng_read_packet_block: length %u opt_comment '%s'", oh->option_length, wblock->rec->opt_comment);
-                } else {
-                    pcapng_debug("pcapng_read_packet_block: opt_comment length %u seems strange", oh->option_length);
-                }
-                break;
-            case(OPT_EPB_FLAGS):
-                if (oh->option_length != 4) {
-                    *err = WTAP_ERR_BAD_FILE;
-                    *err_info = g_strdup_printf("pcapng_read_packet_block: packet block flags option length %u is not 4",
-                                                oh->option_length);
-                    /* XXX - free anything? */
-                    return FALSE;
-                }
-                /*  Don't cast a guint8 * into a guint32 *--the
-                 *  guint8 * may not point to something that's
-                 *  aligned correctly.
-                 */
-                wblock->rec->presence_flags |= WTAP_HAS_PACK_FLAGS;
-                memcpy(&wblock->rec->rec_header.packet_header.pack_flags, option_content, sizeof(guint32));
-                if (section_info->byte_swapped) {
-                    wblock->rec->rec_header.packet_header.pack_flags = GUINT32_SWAP_LE_BE(wblock->rec->rec_header.packet_header.pack_flags);
-                    memcpy(option_content, &wblock->rec->rec_header.packet_header.pack_flags, sizeof(guint32));
-                }
-                if (PACK_FLAGS_FCS_LENGTH(wblock->rec->rec_header.packet_header.pack_flags) != 0) {
-                    /* The FCS length is present */
-                    fcslen = PACK_FLAGS_FCS_LENGTH(wblock->rec->rec_header.packet_header.pack_flags);
-                }
-                pcapng_debug("pcapng_read_packet_block: pack_flags %u (ignored)", wblock->rec->rec_header.packet_header.pack_flags);
-                break;
-            case(OPT_EPB_HASH):
-                pcapng_debug("pcapng_read_packet_block: epb_hash %u currently not handled - ignoring %u bytes",
-                              oh->option_code, oh->option_length);
-                break;
-            case(OPT_EPB_DROPCOUNT):
-                if (oh->option_length != 8) {
-                    *err = WTAP_ERR_BAD_FILE;
-                    *err_info = g_strdup_printf("pcapng_read_packet_block: packet block drop count option length %u is not 8",
-                                                oh->option_length);
-                    /* XXX - free anything? */
-                    return FALSE;
-                }
-                /*  Don't cast a guint8 * into a guint64 *--the
-                 *  guint8 * may not point to something that's
-                 *  aligned correctly.
-                 */
-                wblock->rec->presence_flags |= WTAP_HAS_DROP_COUNT;
-                memcpy(&wblock->rec->rec_header.packet_header.drop_count, option_content, sizeof(guint64));
-                if (section_info->byte_swapped) {
-                    wblock->rec->rec_header.packet_header.drop_count = GUINT64_SWAP_LE_BE(wblock->rec->rec_header.packet_header.drop_count);
-                    memcpy(option_content, &wblock->rec->rec_header.packet_header.drop_count, sizeof(guint64));
-                }
-
-                pcapng_debug("pcapng_read_packet_block: drop_count %" G_GINT64_MODIFIER "u", wblock->rec->rec_header.packet_header.drop_count);
-                break;
-            case(OPT_EPB_PACKETID):
-                if (oh->option_length != 8) {
-                    *err = WTAP_ERR_BAD_FILE;
-                    *err_info = g_strdup_printf("pcapng_read_packet_block: packet block packet id option length %u is not 8",
-                                                oh->option_length);
-                    /* XXX - free anything? */
-                    return FALSE;
-                }
-                /*  Don't cast a guint8 * into a guint64 *--the
-                 *  guint8 * may not point to something that's
-                 *  aligned correctly.
-                 */
-                wblock->rec->presence_flags |= WTAP_HAS_PACKET_ID;
-                memcpy(&wblock->rec->rec_header.packet_header.packet_id, option_content, sizeof(guint64));
-                if (section_info->byte_swapped) {
-                    wblock->rec->rec_header.packet_header.packet_id = GUINT64_SWAP_LE_BE(wblock->rec->rec_header.packet_header.packet_id);
-                    memcpy(option_content, &wblock->rec->rec_header.packet_header.packet_id, sizeof(guint64));
-                }
-                pcapng_debug("pcapng_read_packet_block: packet_id %" G_GINT64_MODIFIER "u", wblock->rec->rec_header.packet_header.packet_id);
-                break;
-            case(OPT_EPB_QUEUE):
-                if (oh->option_length != 4) {
-                    *err = WTAP_ERR_BAD_FILE;
-                    *err_info = g_strdup_printf("pcapng_read_packet_block: packet block queue option length %u is not 4",
-                                                oh->option_length);
-                    /* XXX - free anything? */
-                    return FALSE;
-                }
-                /*  Don't cast a guint8 * into a guint32 *--the
-                 *  guint8 * may not point to something that's
-                 *  aligned correctly.
-                 */
-                wblock->rec->presence_flags |= WTAP_HAS_INT_QUEUE;
-                memcpy(&wblock->rec->rec_header.packet_header.interface_queue, option_content, sizeof(guint32));
-                if (section_info->byte_swapped) {
-                    wblock->rec->rec_header.packet_header.interface_queue = GUINT32_SWAP_LE_BE(wblock->rec->rec_header.packet_header.interface_queue);
-                    memcpy(option_content, &wblock->rec->rec_header.packet_header.interface_queue, sizeof(guint32));
-                }
-                pcapng_debug("pcapng_read_packet_block: queue %u", wblock->rec->rec_header.packet_header.interface_queue);
-                break;
-            case(OPT_EPB_VERDICT):
-                if (oh->option_length < 1 ||
-                    ((option_content[0] == OPT_VERDICT_TYPE_TC ||
-                      option_content[0] == OPT_VERDICT_TYPE_XDP) &&
-                     oh->option_length != 9)) {
-                    *err = WTAP_ERR_BAD_FILE;
-                    if (oh->option_length < 1)
-                        *err_info = g_strdup_printf("pcapng_read_packet_block: packet block verdict option length %u is < 1",
-                                                    oh->option_length);
-                    else
-                        *err_info = g_strdup_printf("pcapng_read_packet_block: packet block verdict option length %u is != 9",
-                                                    oh->option_length);
-                    /* XXX - free anything? */
-                    return FALSE;
-                }
-                /* Silently ignore unknown options */
-                if (option_content[0] > OPT_VERDICT_TYPE_XDP)
-                    continue;
-
-                if (wblock->rec->packet_verdict == NULL) {
-                    wblock->rec->presence_flags |= WTAP_HAS_VERDICT;
-                    wblock->rec->packet_verdict = g_ptr_array_new_with_free_func((GDestroyNotify) g_bytes_unref);
-                }
+    pcapng_debug("pcapng_read_packet_block: encapsulation = %d (%s), pseudo header size = %d.",
+                  iface_info.wtap_encap,
+                  wtap_encap_description(iface_info.wtap_encap),
+                  pcap_get_phdr_size(iface_info.wtap_encap, &wblock->rec->rec_header.packet_header.pseudo_header));
+    wblock->rec->rec_header.packet_header.interface_id = packet.interface_id;
+    wblock->rec->rec_header.packet_header.pkt_encap = iface_info.wtap_encap;
+    wblock->rec->tsprec = iface_info.tsprecision;
 
-                option_content_copy = g_memdup2(option_content, oh->option_length);
+    memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
+    pseudo_header_len = pcap_process_pseudo_header(fh,
+                                                   FALSE, /* not a Nokia pcap - not a pcap at all */
+                                                   iface_info.wtap_encap,
+                                                   packet.cap_len,
+                                                   wblock->rec,
+                                                   err,
+                                                   err_info);
+    if (pseudo_header_len < 0) {
+        return FALSE;
+    }
+    block_read += pseudo_header_len;
+    wblock->rec->rec_header.packet_header.caplen = packet.cap_len - pseudo_header_len;
+    wblock->rec->rec_header.packet_header.len = packet.packet_len - pseudo_header_len;
 
-                /* For Linux XDP and TC we might need to byte swap */
-                if (section_info->byte_swapped &&
-                    (option_content[0] == OPT_VERDICT_TYPE_TC ||
-                     option_content[0] == OPT_VERDICT_TYPE_XDP)) {
-                    guint64 result;
+    /* Combine the two 32-bit pieces of the timestamp into one 64-bit value */
+    ts = (((guint64)packet.ts_high) << 32) | ((guint64)packet.ts_low);
+    wblock->rec->ts.secs = (time_t)(ts / iface_info.time_units_per_second);
+    wblock->rec->ts.nsecs = (int)(((ts % iface_info.time_units_per_second) * 1000000000) / iface_info.time_units_per_second);
 
-                    memcpy(&result, option_content + 1, sizeof(result));
-                    result = GUINT64_SWAP_LE_BE(result);
-                    memcpy(option_content + 1, &result, sizeof(result));
-                }
+    /* "(Enhanced) Packet Block" read capture data */
+    if (body != NULL) {
+        /* The packet data goes into the caller's buffer. */
+        if (!wblock->skip_packet_data) {
+            ws_buffer_assure_space(wblock->frame_buffer, packet.cap_len);
+            memcpy(ws_buffer_start_ptr(wblock->frame_buffer),
+                   body + block_read, packet.cap_len);
+        }
+    } else if (wblock->skip_packet_data) {
+        if (!wtap_read_bytes(fh, NULL, packet.cap_len - pseudo_header_len,
+                             err, err_info))
+            return FALSE;
+    } else {
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    packet.cap_len - pseudo_header_len, err, err_info))
+            return FALSE;
+    }
+    block_read += packet.cap_len - pseudo_header_len;
 
-                g_ptr_array_add(wblock->rec->packet_verdict,
-                                g_bytes_new_with_free_func(option_content_copy,
-                                                           oh->option_length,
-                                                           g_free,
-                                                           option_content_copy));
-                pcapng_debug("pcapng_read_packet_block: verdict type %u, data len %u",
-                             option_content[0], oh->option_length - 1);
-                break;
-            default:
-                pcapng_debug("pcapng_read_packet_block: unknown option %u - ignoring %u bytes",
-                              oh->option_code, oh->option_length);
-                break;
+    /* jump over potential padding bytes at end of the packet data */
+    if (padding != 0) {
+        if (body == NULL &&
+            !wtap_read_bytes(fh, NULL, padding, err, err_info))
+            return FALSE;
+        block_read += padding;
+    }
+
+    /*
+     * Option defaults.  The comment and the verdict array from an
+     * earlier read are kept, so that their memory can be reused for
+     * this record; the comment is freed below if there isn't one.
+     */
+    got_comment = FALSE;
+    wblock->rec->rec_header.packet_header.drop_count  = -1;
+    wblock->rec->rec_header.packet_header.pack_flags  = 0;
+    wblock->rec->rec_header.packet_header.packet_id  = 0;
+    wblock->rec->rec_header.packet_header.interface_queue  = 0;
+    if (wblock->rec->packet_verdict != NULL)
+        g_ptr_array_set_size(wblock->rec->packet_verdict, 0);
+
+    /* FCS length default */
+    fcslen = iface_info.fcslen;
+
+    /* Options
+     * opt_comment    1
+     * epb_flags      2
+     * epb_hash       3
+     * epb_dropcount  4
+     * epb_packetid   5
+     * epb_queue      6
+     * epb_verdict    7
+     */
+    to_read = block_total_length -
+        (int)sizeof(pcapng_block_header_t) -
+        block_read -    /* fixed and variable part, including padding */
+        (int)sizeof(bh->block_total_length);
+
+    if (body != NULL) {
+        opt_ptr = body + block_read;
+    } else {
+        /* Ensure sufficient temporary memory to hold all options. It is
+         * not freed on return to avoid frequent reallocations. When called
+         * for sequential read (wtap_read), "wblock->rec == &wth->rec"
+         * (options_buf will be freed by wtap_sequential_close). For random
+         * access, memory is managed by the caller of wtap_seek_read. */
+        ws_buffer_assure_space(&wblock->rec->options_buf, to_read);
+        if (!wtap_read_bytes(fh, ws_buffer_start_ptr(&wblock->rec->options_buf),
+                             to_read, err, err_info)) {
+            pcapng_debug("pcapng_read_packet_block: failed to read options");
+            return FALSE;
         }
+        opt_ptr = ws_buffer_start_ptr(&wblock->rec->options_buf);
+    }
+    if (!pcapng_process_packet_block_options(wblock, section_info,
+                                             opt_ptr, to_read,
+                                             &fcslen, &got_comment,
+                                             err, err_info))
+        return FALSE;
+
+    if (!got_comment) {
+        g_free(wblock->rec->opt_comment);
+        wblock->rec->opt_comment = NULL;
     }
 
-    pcap_read_post_process(FALSE, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
-                           section_info->byte_swapped, fcslen);
+    if (!wblock->skip_packet_data)
+        pcap_read_post_process(FALSE, iface_info.wtap_encap,
+                               wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
+                               section_info->byte_swapped, fcslen);
 
     /*
      * We return these to the caller in pcapng_read().
@@ -1840,10 +2071,8 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->rec_header.packet_header.pack_flags = 0;
     wblock->rec->rec_header.packet_header.packet_id = 0;
     wblock->rec->rec_header.packet_header.interface_queue = 0;
-    if (wblock->rec->packet_verdict != NULL) {
-        g_ptr_array_free(wblock->rec->packet_verdict, TRUE);
-        wblock->rec->packet_verdict = NULL;
-    }
+    if (wblock->rec->packet_verdict != NULL)
+        g_ptr_array_set_size(wblock->rec->packet_verdict, 0);
 
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
     pseudo_header_len = pcap_process_pseudo_header(fh,
@@ -1862,9 +2091,14 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
 
     /* "Simple Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                simple_packet.cap_len, err, err_info))
-        return FALSE;
+    if (wblock->skip_packet_data) {
+        if (!wtap_read_bytes(fh, NULL, simple_packet.cap_len, err, err_info))
+            return FALSE;
+    } else {
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    simple_packet.cap_len, err, err_info))
+            return FALSE;
+    }
 
     /* jump over potential padding bytes at end of the packet data */
     if ((simple_packet.cap_len % 4) != 0) {
@@ -1872,9 +2106,10 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
             return FALSE;
     }
 
-    pcap_read_post_process(FALSE, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
-                           section_info->byte_swapped, iface_info.fcslen);
+    if (!wblock->skip_packet_data)
+        pcap_read_post_process(FALSE, iface_info.wtap_encap,
+                               wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
+                               section_info->byte_swapped, iface_info.fcslen);
 
     /*
      * We return these to the caller in pcapng_read().
@@ -2639,6 +2874,326 @@ pcapng_read_unknown_block(FILE_T fh, pcapng_block_header_t *bh,
     return TRUE;
 }
 
+/*
+ * Read the body of a record index block that starts at block_off, and,
+ * if we don't already have an index and this one is usable, keep it.
+ * A bad index is ignored rather than treated as an error, as the file's
+ * records are all still there; we only fail if we can't read the block.
+ */
+static gboolean
+pcapng_read_record_index_block(FILE_T fh, pcapng_block_header_t *bh,
+                               pcapng_t *pn,
+                               const section_info_t *section_info,
+                               gint64 block_off,
+                               int *err, gchar **err_info)
+{
+    guint32 body_len, i;
+    pcapng_record_index_header_t hdr;
+    pcapng_record_index_entry_t entry, *prev;
+    GArray *entries;
+
+    if (bh->block_total_length < MIN_BLOCK_SIZE) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = g_strdup_printf("pcapng_read_record_index_block: total block length %u is less than the minimum block size %u",
+                                    bh->block_total_length, MIN_BLOCK_SIZE);
+        return FALSE;
+    }
+    body_len = bh->block_total_length - MIN_BLOCK_SIZE;
+    if (body_len < sizeof hdr || body_len % 4 != 0) {
+        pcapng_debug("pcapng_read_record_index_block: block length %u is bad",
+                     bh->block_total_length);
+        return wtap_read_bytes(fh, NULL, (body_len + 3) & ~3U, err, err_info);
+    }
+
+    if (!wtap_read_bytes(fh, &hdr, sizeof hdr, err, err_info))
+        return FALSE;
+    body_len -= (guint32)sizeof hdr;
+    if (section_info->byte_swapped) {
+        hdr.version       = GUINT32_SWAP_LE_BE(hdr.version);
+        hdr.stride        = GUINT32_SWAP_LE_BE(hdr.stride);
+        hdr.num_entries   = GUINT32_SWAP_LE_BE(hdr.num_entries);
+        hdr.num_records   = GUINT32_SWAP_LE_BE(hdr.num_records);
+        hdr.index_offset  = GUINT64_SWAP_LE_BE(hdr.index_offset);
+    }
+    if (pn->record_index != NULL ||
+        memcmp(hdr.magic, RECORD_INDEX_MAGIC, sizeof hdr.magic) != 0 ||
+        hdr.version != RECORD_INDEX_VERSION ||
+        hdr.stride == 0 || hdr.num_entries == 0 ||
+        body_len / sizeof entry != hdr.num_entries ||
+        body_len % sizeof entry != 0 ||
+        section_info->shb_off != 0 ||
+        (gint64)hdr.index_offset != block_off) {
+        /* Already have one, not ours, or not usable; skip it. */
+        return wtap_read_bytes(fh, NULL, body_len, err, err_info);
+    }
+
+    entries = g_array_sized_new(FALSE, FALSE, sizeof entry, hdr.num_entries);
+    for (i = 0; i < hdr.num_entries; i++) {
+        if (!wtap_read_bytes(fh, &entry, sizeof entry, err, err_info)) {
+            g_array_free(entries, TRUE);
+            return FALSE;
+        }
+        if (section_info->byte_swapped) {
+            entry.offset         = GUINT64_SWAP_LE_BE(entry.offset);
+            entry.max_ts_before  = (gint64)GUINT64_SWAP_LE_BE((guint64)entry.max_ts_before);
+            entry.record_num     = GUINT32_SWAP_LE_BE(entry.record_num);
+            entry.num_interfaces = GUINT32_SWAP_LE_BE(entry.num_interfaces);
+        }
+        /* The entries must be in order and point before the index. */
+        prev = (i == 0) ? NULL :
+            &g_array_index(entries, pcapng_record_index_entry_t, i - 1);
+        if (entry.offset >= hdr.index_offset ||
+            (prev != NULL &&
+             (entry.offset <= prev->offset ||
+              entry.record_num <= prev->record_num ||
+              entry.max_ts_before < prev->max_ts_before ||
+              entry.num_interfaces < prev->num_interfaces))) {
+            pcapng_debug("pcapng_read_record_index_block: entry %u is bad", i);
+            g_array_free(entries, TRUE);
+            return wtap_read_bytes(fh, NULL,
+                                   (hdr.num_entries - i - 1) * (guint32)sizeof entry,
+                                   err, err_info);
+        }
+        g_array_append_val(entries, entry);
+    }
+    pcapng_debug("pcapng_read_record_index_block: %u entries, one every %u records",
+                 hdr.num_entries, hdr.stride);
+    pn->record_index = entries;
+    return TRUE;
+}
+
+/*
+ * If we can seek, and the file isn't compressed, so that looking at
+ * its end is cheap, see whether it ends with a record index.
+ */
+static void
+pcapng_load_record_index(wtap *wth, pcapng_t *pn,
+                         const section_info_t *section_info)
+{
+    gint64 file_size, block_off;
+    guint32 block_total_length;
+    pcapng_block_header_t bh;
+    int err;
+    gchar *err_info = NULL;
+
+    if (wth->random_fh == NULL || file_iscompressed(wth->random_fh))
+        return;
+    if ((file_size = wtap_file_size(wth, &err)) < (gint64)MIN_BLOCK_SIZE)
+        return;
+
+    if (file_seek(wth->random_fh, file_size - (gint64)sizeof block_total_length,
+                  SEEK_SET, &err) == -1 ||
+        !wtap_read_bytes(wth->random_fh, &block_total_length,
+                         sizeof block_total_length, &err, &err_info))
+        goto done;
+    if (section_info->byte_swapped)
+        block_total_length = GUINT32_SWAP_LE_BE(block_total_length);
+    if (block_total_length < MIN_BLOCK_SIZE ||
+        block_total_length > MAX_BLOCK_SIZE ||
+        (gint64)block_total_length > file_size)
+        goto done;
+
+    block_off = file_size - block_total_length;
+    if (file_seek(wth->random_fh, block_off, SEEK_SET, &err) == -1 ||
+        !wtap_read_bytes(wth->random_fh, &bh, sizeof bh, &err, &err_info))
+        goto done;
+    if (section_info->byte_swapped) {
+        bh.block_type         = GUINT32_SWAP_LE_BE(bh.block_type);
+        bh.block_total_length = GUINT32_SWAP_LE_BE(bh.block_total_length);
+    }
+    if (bh.block_type == BLOCK_TYPE_RECORD_INDEX &&
+        bh.block_total_length == block_total_length)
+        (void)pcapng_read_record_index_block(wth->random_fh, &bh, pn,
+                                             section_info, block_off,
+                                             &err, &err_info);
+done:
+    g_free(err_info);
+}
+
+/*
+ * Position the sequential stream at the latest indexed record that's at
+ * or before record frame_num or, if ts isn't NULL, that has no record
+ * at or after ts before it, and that we know the interfaces for.
+ */
+static gboolean
+pcapng_seek_to_record(wtap *wth, guint32 frame_num, const nstime_t *ts,
+                      guint32 *next_frame_num, int *err, gchar **err_info _U_)
+{
+    pcapng_t *pcapng = (pcapng_t *)wth->priv;
+    GArray *record_index = pcapng->record_index;
+    const section_info_t *section_info;
+    const pcapng_record_index_entry_t *entry;
+    guint lo, hi, mid;
+    gint64 ts_ns = 0;
+
+    if (record_index == NULL)
+        return FALSE;
+    if (ts != NULL)
+        ts_ns = (gint64)ts->secs * 1000000000 + ts->nsecs;
+
+    /* Find the first entry that's past what we want. */
+    lo = 0;
+    hi = record_index->len;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        entry = &g_array_index(record_index, pcapng_record_index_entry_t, mid);
+        if (ts != NULL ? entry->max_ts_before < ts_ns :
+                         entry->record_num <= frame_num)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* Go back to one that doesn't need IDBs we haven't read yet. */
+    section_info = &g_array_index(pcapng->sections, section_info_t, 0);
+    while (lo != 0) {
+        entry = &g_array_index(record_index, pcapng_record_index_entry_t, lo - 1);
+        if (entry->num_interfaces <= section_info->interfaces->len)
+            break;
+        lo--;
+    }
+    if (lo == 0)
+        return FALSE;
+
+    if (file_seek(wth->fh, (gint64)entry->offset, SEEK_SET, err) == -1)
+        return FALSE;
+    pcapng->current_section_number = 0;
+    *next_frame_num = entry->record_num;
+    return TRUE;
+}
+
+/*
+ * How far past the offset we're given we look for a packet block.
+ */
+#define RESYNC_WINDOW (1024*1024)
+
+/*
+ * Check that the block at block_off, which claims to be block_len bytes
+ * long, ends with the same length and is followed either by the end of
+ * the file or by a block whose header and trailer agree.
+ *
+ * Returns 1 if it does, 0 if it doesn't, and -1 on an I/O error.
+ */
+static int
+pcapng_resync_check(wtap *wth, const section_info_t *section_info,
+                    gint64 block_off, guint32 block_len,
+                    int *err, gchar **err_info)
+{
+    pcapng_block_header_t bh;
+    guint32 trailer;
+
+    if (file_seek(wth->fh, block_off + block_len - 4, SEEK_SET, err) == -1)
+        return -1;
+    if (!wtap_read_bytes(wth->fh, &trailer, sizeof trailer, err, err_info))
+        return *err == WTAP_ERR_SHORT_READ ? 0 : -1;
+    if (section_info->byte_swapped)
+        trailer = GUINT32_SWAP_LE_BE(trailer);
+    if (trailer != block_len)
+        return 0;
+
+    if (!wtap_read_bytes_or_eof(wth->fh, &bh, sizeof bh, err, err_info)) {
+        if (*err == 0)
+            return 1;
+        return *err == WTAP_ERR_SHORT_READ ? 0 : -1;
+    }
+    if (section_info->byte_swapped)
+        bh.block_total_length = GUINT32_SWAP_LE_BE(bh.block_total_length);
+    if (bh.block_total_length < MIN_BLOCK_SIZE ||
+        bh.block_total_length > MAX_BLOCK_SIZE ||
+        (bh.block_total_length % 4) != 0)
+        return 0;
+    if (file_seek(wth->fh, block_off + block_len + bh.block_total_length - 4,
+                  SEEK_SET, err) == -1)
+        return -1;
+    if (!wtap_read_bytes(wth->fh, &trailer, sizeof trailer, err, err_info))
+        return *err == WTAP_ERR_SHORT_READ ? 0 : -1;
+    if (section_info->byte_swapped)
+        trailer = GUINT32_SWAP_LE_BE(trailer);
+    return trailer == bh.block_total_length ? 1 : 0;
+}
+
+/*
+ * Find the first packet block with a time stamp, at or after off, for
+ * an interface we've already seen.  Simple Packet Blocks are skipped,
+ * as they don't have a time stamp.
+ *
+ * Blocks are 32-bit aligned, and their length is at both ends, so a
+ * candidate whose lengths agree and that's followed by another block
+ * that's consistent is very unlikely to be packet data.
+ */
+static gboolean
+pcapng_resync(wtap *wth, gint64 off, gint64 *rec_off, int *err,
+              gchar **err_info)
+{
+    pcapng_t *pcapng = (pcapng_t *)wth->priv;
+    const section_info_t *section_info;
+    guint8 *window;
+    int bytes_read, i, ret;
+    guint32 block_type, block_len, interface_id, min_len;
+
+    /* Blocks in later sections could have a different byte order. */
+    if (pcapng->sections->len != 1)
+        return FALSE;
+    section_info = &g_array_index(pcapng->sections, section_info_t, 0);
+
+    off = (off + 3) & ~(gint64)3;
+    if (file_seek(wth->fh, off, SEEK_SET, err) == -1)
+        return FALSE;
+    window = (guint8 *)g_malloc(RESYNC_WINDOW);
+    bytes_read = file_read(window, RESYNC_WINDOW, wth->fh);
+    if (bytes_read < 0) {
+        *err = file_error(wth->fh, err_info);
+        g_free(window);
+        return FALSE;
+    }
+
+    for (i = 0; i + 12 <= bytes_read; i += 4) {
+        memcpy(&block_type, window + i, 4);
+        memcpy(&block_len, window + i + 4, 4);
+        if (section_info->byte_swapped) {
+            block_type = GUINT32_SWAP_LE_BE(block_type);
+            block_len  = GUINT32_SWAP_LE_BE(block_len);
+        }
+        if (block_type == BLOCK_TYPE_EPB) {
+            memcpy(&interface_id, window + i + 8, 4);
+            if (section_info->byte_swapped)
+                interface_id = GUINT32_SWAP_LE_BE(interface_id);
+            min_len = MIN_EPB_SIZE;
+        } else if (block_type == BLOCK_TYPE_PB) {
+            guint16 pb_interface_id;
+
+            memcpy(&pb_interface_id, window + i + 8, 2);
+            if (section_info->byte_swapped)
+                pb_interface_id = GUINT16_SWAP_LE_BE(pb_interface_id);
+            interface_id = pb_interface_id;
+            min_len = MIN_PB_SIZE;
+        } else
+            continue;
+        if (block_len < min_len || block_len > MAX_BLOCK_SIZE ||
+            (block_len % 4) != 0 ||
+            interface_id >= section_info->interfaces->len)
+            continue;
+
+        ret = pcapng_resync_check(wth, section_info, off + i, block_len,
+                                  err, err_info);
+        if (ret == -1) {
+            g_free(window);
+            return FALSE;
+        }
+        if (ret == 1) {
+            g_free(window);
+            pcapng->current_section_number = 0;
+            *rec_off = off + i;
+            return TRUE;
+        }
+    }
+
+    /* Nothing that looks like a packet block; not an error. */
+    g_free(window);
+    *err = 0;
+    return FALSE;
+}
+
 static gboolean
 pcapng_read_and_check_block_trailer(FILE_T fh, pcapng_block_header_t *bh,
                            section_info_t *section_info,
@@ -2800,6 +3355,15 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
                     return FALSE;
                 break;
             default:
+                if (bh.block_type == BLOCK_TYPE_RECORD_INDEX) {
+                    /* Our own record index; see above. */
+                    if (!pcapng_read_record_index_block(fh, &bh, pn, section_info,
+                                                        file_tell(fh) - (gint64)sizeof bh,
+                                                        err, err_info))
+                        return FALSE;
+                    wblock->internal = TRUE;
+                    break;
+                }
                 pcapng_debug("pcapng_read_block: Unknown block_type: 0x%x (block ignored), block total length %d", bh.block_type, bh.block_total_length);
                 if (!pcapng_read_unknown_block(fh, &bh, section_info, wblock, err, err_info))
                     return FALSE;
@@ -2920,6 +3484,7 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
     wblock.block = NULL;
     /* we don't expect any packet blocks yet */
     wblock.frame_buffer = NULL;
+    wblock.skip_packet_data = FALSE;
     wblock.rec = NULL;
 
     switch (pcapng_read_section_header_block(wth->fh, &bh, &first_section,
@@ -3007,9 +3572,12 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
      */
     pcapng->add_new_ipv4 = NULL;
     pcapng->add_new_ipv6 = NULL;
+    pcapng->record_index = NULL;
 
     wth->subtype_read = pcapng_read;
     wth->subtype_seek_read = pcapng_seek_read;
+    wth->subtype_seek_to_record = pcapng_seek_to_record;
+    wth->subtype_resync = pcapng_resync;
     wth->subtype_close = pcapng_close;
     wth->file_type_subtype = pcapng_file_type_subtype;
 
@@ -3067,6 +3635,9 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
         pcapng_debug("pcapng_open: Read IDB number_of_interfaces %u, wtap_encap %i",
                       wth->interface_data->len, wth->file_encap);
     }
+
+    pcapng_load_record_index(wth, pcapng,
+                             &g_array_index(pcapng->sections, section_info_t, 0));
     return WTAP_OPEN_MINE;
 }
 
@@ -3085,6 +3656,7 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     wtapng_if_descr_mandatory_t *wtapng_if_descr_mand;
 
     wblock.frame_buffer  = buf;
+    wblock.skip_packet_data = wth->skip_packet_data;
     wblock.rec = rec;
 
     pcapng->add_new_ipv4 = wth->add_new_ipv4;
@@ -3274,6 +3846,7 @@ pcapng_seek_read(wtap *wth, gint64 seek_off,
     }
 
     wblock.frame_buffer = buf;
+    wblock.skip_packet_data = FALSE;
     wblock.rec = rec;
 
     /* read the block */
@@ -3315,6 +3888,8 @@ pcapng_close(wtap *wth)
         g_array_free(section_info->interfaces, TRUE);
     }
     g_array_free(pcapng->sections, TRUE);
+    if (pcapng->record_index != NULL)
+        g_array_free(pcapng->record_index, TRUE);
 }
 
 typedef struct pcapng_block_size_t
@@ -4949,6 +5524,94 @@ static gboolean pcapng_add_idb(wtap_dumper *wdh, wtap_block_t idb,
 	return pcapng_write_if_descr_block(wdh, idb_copy, err);
 }
 
+/*
+ * Note, in the record index, that the record just written starts at
+ * rec_off, if it's one that gets an entry.
+ */
+static void
+pcapng_record_index_add(wtap_dumper *wdh, const wtap_rec *rec, gint64 rec_off)
+{
+    pcapng_dump_t *pcapng_dump = (pcapng_dump_t *)wdh->priv;
+    pcapng_record_index_entry_t entry;
+    guint i;
+
+    if (pcapng_dump == NULL)
+        return;
+
+    if (pcapng_dump->num_records % pcapng_dump->stride == 0) {
+        if (pcapng_dump->entries->len == RECORD_INDEX_MAX_ENTRIES) {
+            /* Full; keep every other entry, and add half as many. */
+            for (i = 0; i < RECORD_INDEX_MAX_ENTRIES / 2; i++)
+                g_array_index(pcapng_dump->entries, pcapng_record_index_entry_t, i) =
+                    g_array_index(pcapng_dump->entries, pcapng_record_index_entry_t, 2 * i);
+            g_array_set_size(pcapng_dump->entries, RECORD_INDEX_MAX_ENTRIES / 2);
+            pcapng_dump->stride *= 2;
+        }
+        if (pcapng_dump->num_records % pcapng_dump->stride == 0) {
+            entry.offset = (guint64)rec_off;
+            entry.max_ts_before = pcapng_dump->max_ts;
+            entry.record_num = pcapng_dump->num_records + 1;
+            entry.num_interfaces = wdh->interface_data->len;
+            g_array_append_val(pcapng_dump->entries, entry);
+        }
+    }
+    pcapng_dump->num_records++;
+    if (rec->presence_flags & WTAP_HAS_TS) {
+        gint64 ts = (gint64)rec->ts.secs * 1000000000 + rec->ts.nsecs;
+
+        if (ts > pcapng_dump->max_ts)
+            pcapng_dump->max_ts = ts;
+    }
+}
+
+static gboolean
+pcapng_write_record_index_block(wtap_dumper *wdh, int *err)
+{
+    pcapng_dump_t *pcapng_dump = (pcapng_dump_t *)wdh->priv;
+    pcapng_block_header_t bh;
+    pcapng_record_index_header_t hdr;
+    guint32 entries_len;
+
+    if (pcapng_dump->entries->len == 0)
+        return TRUE;
+
+    entries_len = pcapng_dump->entries->len * (guint32)sizeof (pcapng_record_index_entry_t);
+
+    /* write block header */
+    bh.block_type = BLOCK_TYPE_RECORD_INDEX;
+    bh.block_total_length = MIN_BLOCK_SIZE + (guint32)sizeof hdr + entries_len;
+    pcapng_debug("%s: Total len %u", G_STRFUNC, bh.block_total_length);
+
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, RECORD_INDEX_MAGIC, sizeof hdr.magic);
+    hdr.version = RECORD_INDEX_VERSION;
+    hdr.stride = pcapng_dump->stride;
+    hdr.num_entries = pcapng_dump->entries->len;
+    hdr.num_records = pcapng_dump->num_records;
+    hdr.index_offset = (guint64)wdh->bytes_dumped;
+
+    if (!wtap_dump_file_write(wdh, &bh, sizeof bh, err))
+        return FALSE;
+    wdh->bytes_dumped += sizeof bh;
+
+    /* write block fixed content */
+    if (!wtap_dump_file_write(wdh, &hdr, sizeof hdr, err))
+        return FALSE;
+    wdh->bytes_dumped += sizeof hdr;
+
+    if (!wtap_dump_file_write(wdh, pcapng_dump->entries->data, entries_len, err))
+        return FALSE;
+    wdh->bytes_dumped += entries_len;
+
+    /* write block footer */
+    if (!wtap_dump_file_write(wdh, &bh.block_total_length,
+                              sizeof bh.block_total_length, err))
+        return FALSE;
+    wdh->bytes_dumped += sizeof bh.block_total_length;
+
+    return TRUE;
+}
+
 static gboolean pcapng_dump(wtap_dumper *wdh,
                             const wtap_rec *rec,
                             const guint8 *pd, int *err, gchar **err_info)
@@ -4956,6 +5619,7 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
 #ifdef HAVE_PLUGINS
     block_handler *handler;
 #endif
+    gint64 rec_off;
 
     /* Write (optional) Decryption Secrets Blocks that were collected while
      * reading packet blocks. */
@@ -4976,6 +5640,8 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
                   wtap_encap_description(rec->rec_header.packet_header.pkt_encap),
                   rec->rec_type);
 
+    rec_off = wdh->bytes_dumped;
+
     switch (rec->rec_type) {
 
         case REC_TYPE_PACKET:
@@ -5029,10 +5695,23 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
             return FALSE;
     }
 
+    pcapng_record_index_add(wdh, rec, rec_off);
+
     return TRUE;
 }
 
 
+static void
+pcapng_dump_free_record_index(wtap_dumper *wdh)
+{
+    pcapng_dump_t *pcapng_dump = (pcapng_dump_t *)wdh->priv;
+
+    if (pcapng_dump != NULL && pcapng_dump->entries != NULL) {
+        g_array_free(pcapng_dump->entries, TRUE);
+        pcapng_dump->entries = NULL;
+    }
+}
+
 /* Finish writing to a dump file.
    Returns TRUE on success, FALSE on failure. */
 static gboolean pcapng_dump_finish(wtap_dumper *wdh, int *err,
@@ -5058,11 +5737,21 @@ static gboolean pcapng_dump_finish(wtap_dumper *wdh, int *err,
             if_stats = g_array_index(int_data_mand->interface_statistics, wtap_block_t, j);
             pcapng_debug("pcapng_dump_finish: write ISB for interface %u", ((wtapng_if_stats_mandatory_t*)wtap_block_get_mandatory_data(if_stats))->interface_id);
             if (!pcapng_write_interface_statistics_block(wdh, if_stats, err)) {
+                pcapng_dump_free_record_index(wdh);
                 return FALSE;
             }
         }
     }
 
+    /* The record index has to be last, so that readers can find it. */
+    if (wdh->priv != NULL) {
+        if (!pcapng_write_record_index_block(wdh, err)) {
+            pcapng_dump_free_record_index(wdh);
+            return FALSE;
+        }
+        pcapng_dump_free_record_index(wdh);
+    }
+
     pcapng_debug("pcapng_dump_finish");
     return TRUE;
 }
@@ -5073,6 +5762,7 @@ static gboolean pcapng_dump_finish(wtap_dumper *wdh, int *err,
 gboolean
 pcapng_dump_open(wtap_dumper *wdh, int *err, gchar **err_info _U_)
 {
+    static int write_record_index = -1;
     guint i;
 
     pcapng_debug("pcapng_dump_open");
@@ -5114,6 +5804,22 @@ pcapng_dump_open(wtap_dumper *wdh, int *err, gchar **err_info _U_)
         }
     }
 
+    /*
+     * If asked to, keep a record index to write at the end.  Don't
+     * bother for compressed files, as readers would have to read all
+     * of the file to find it.
+     */
+    if (write_record_index == -1)
+        write_record_index = (getenv("WIRESHARK_WTAP_PCAPNG_INDEX") != NULL);
+    if (write_record_index && wdh->compression_type == WTAP_UNCOMPRESSED) {
+        pcapng_dump_t *pcapng_dump = g_new0(pcapng_dump_t, 1);
+
+        pcapng_dump->entries = g_array_new(FALSE, FALSE, sizeof (pcapng_record_index_entry_t));
+        pcapng_dump->stride = 1;
+        pcapng_dump->max_ts = RECORD_INDEX_NO_TIME;
+        wdh->priv = pcapng_dump;
+    }
+
     return TRUE;
 }
 
@@ -48,6 +48,7 @@ typedef struct wtapng_block_s {
     wtap_block_t block;
     wtap_rec     *rec;
     Buffer       *frame_buffer;
+    gboolean     skip_packet_data; /* TRUE if packet data can be skipped rather than read into frame_buffer */
 } wtapng_block_t;
 
 /*
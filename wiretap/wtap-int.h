@@ -32,6 +32,11 @@ typedef gboolean (*subtype_read_func)(struct wtap*, wtap_rec *,
                                       Buffer *, int *, char **, gint64 *);
 typedef gboolean (*subtype_seek_read_func)(struct wtap*, gint64, wtap_rec *,
                                            Buffer *, int *, char **);
+typedef gboolean (*subtype_seek_to_record_func)(struct wtap*, guint32,
+                                                const nstime_t *, guint32 *,
+                                                int *, char **);
+typedef gboolean (*subtype_resync_func)(struct wtap*, gint64, gint64 *,
+                                        int *, char **);
 
 /**
  * Struct holding data of the currently read file.
@@ -55,6 +60,8 @@ struct wtap {
 
     subtype_read_func           subtype_read;
     subtype_seek_read_func      subtype_seek_read;
+    subtype_seek_to_record_func subtype_seek_to_record; /**< Seek using an index of records, or NULL */
+    subtype_resync_func         subtype_resync;         /**< Find the first record header at or after an offset, or NULL */
     void                        (*subtype_sequential_close)(struct wtap*);
     void                        (*subtype_close)(struct wtap*);
     int                         file_encap;    /* per-file, for those
@@ -77,6 +84,9 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;
     wtap_new_secrets_callback_t add_new_secrets;
     GPtrArray                   *fast_seek;
+    gboolean                    fast_seek_from_index; /* fast_seek was loaded from a seek index file */
+    gboolean                    skip_packet_data;       /**< TRUE if wtap_read() needn't read packet data */
+    guint64                     rec_allocs;             /**< allocations made while reading records */
 };
 
 struct wtap_dumper;
@@ -122,6 +132,15 @@ struct wtap_dumper {
      */
     const GArray            *dsbs_growing;          /**< A reference to an array of DSBs (of type wtap_block_t) */
     guint                   dsbs_growing_written;   /**< Number of already processed DSBs in dsbs_growing. */
+
+    /*
+     * Write-combining buffer for uncompressed output to regular files,
+     * so that the many small writes of each block go out to the file
+     * together.
+     */
+    guint8                  *write_buf;
+    size_t                  write_buf_size;  /**< size of write_buf, or 0 for no buffering */
+    size_t                  write_buf_len;   /**< number of bytes in write_buf */
 };
 
 WS_DLL_PUBLIC gboolean wtap_dump_file_write(wtap_dumper *wdh, const void *buf,
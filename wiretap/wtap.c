@@ -19,6 +19,8 @@
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
 #include <wsutil/buffer.h>
+#include <wsutil/ws_probes.h>
+#include <wsutil/startup_profile.h>
 #ifdef HAVE_PLUGINS
 #include <wsutil/plugins.h>
 #endif
@@ -1401,6 +1403,12 @@ wtap_sequential_close(wtap *wth)
 		(*wth->subtype_sequential_close)(wth);
 
 	if (wth->fh != NULL) {
+		/*
+		 * If we've built the fast seek table while reading the
+		 * file, save it for the next time the file is opened.
+		 */
+		if (wth->fast_seek != NULL && !wth->fast_seek_from_index)
+			file_seek_index_save(wth->fh, wth->pathname);
 		file_close(wth->fh);
 		wth->fh = NULL;
 	}
@@ -1514,14 +1522,69 @@ wtap_init_rec(wtap *wth, wtap_rec *rec)
 	rec->tsprec = wth->file_tsprec;
 }
 
+void
+wtap_set_skip_packet_data(wtap *wth, gboolean skip)
+{
+	wth->skip_packet_data = skip;
+}
+
+/*
+ * What a record and its buffer looked like before a read, so that we
+ * can tell what the read had to allocate.
+ */
+typedef struct {
+	gsize		buf_allocated;
+	gsize		options_allocated;
+	const gchar	*opt_comment;
+	const GPtrArray	*packet_verdict;
+} rec_alloc_state_t;
+
+static void
+wtap_rec_alloc_state(const wtap_rec *rec, const Buffer *buf,
+    rec_alloc_state_t *state)
+{
+	state->buf_allocated = buf->allocated;
+	state->options_allocated = rec->options_buf.allocated;
+	state->opt_comment = rec->opt_comment;
+	state->packet_verdict = rec->packet_verdict;
+}
+
+static void
+wtap_count_rec_allocs(wtap *wth, const wtap_rec *rec, const Buffer *buf,
+    const rec_alloc_state_t *state)
+{
+	if (buf->allocated != state->buf_allocated)
+		wth->rec_allocs++;
+	if (rec->options_buf.allocated != state->options_allocated)
+		wth->rec_allocs++;
+	if (rec->opt_comment != NULL && rec->opt_comment != state->opt_comment)
+		wth->rec_allocs++;
+	if (rec->packet_verdict != NULL) {
+		if (rec->packet_verdict != state->packet_verdict)
+			wth->rec_allocs++;
+		/* Each verdict is a GBytes and a copy of the verdict. */
+		if (rec->presence_flags & WTAP_HAS_VERDICT)
+			wth->rec_allocs += 2 * (guint64)rec->packet_verdict->len;
+	}
+}
+
+guint64
+wtap_get_rec_allocation_count(wtap *wth)
+{
+	return wth->rec_allocs;
+}
+
 gboolean
 wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 	gchar **err_info, gint64 *offset)
 {
+	rec_alloc_state_t alloc_state;
+
 	/*
 	 * Initialize the record to default values.
 	 */
 	wtap_init_rec(wth, rec);
+	wtap_rec_alloc_state(rec, buf, &alloc_state);
 
 	*err = 0;
 	*err_info = NULL;
@@ -1559,10 +1622,44 @@ wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 		 */
 		g_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_PER_PACKET);
 	}
+	wtap_count_rec_allocs(wth, rec, buf, &alloc_state);
+
+	WS_PROBE3(wtap_read, rec->rec_type,
+	    rec->rec_type == REC_TYPE_PACKET ? rec->rec_header.packet_header.caplen : 0,
+	    *offset);
 
 	return TRUE;	/* success */
 }
 
+gboolean
+wtap_read_tail(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+	gchar **err_info, gint64 *offset)
+{
+	gint64 start;
+
+	wtap_cleareof(wth);
+	if ((start = file_tell(wth->fh)) == -1) {
+		*err = file_error(wth->fh, err_info);
+		return FALSE;
+	}
+	if (wtap_read(wth, rec, buf, err, err_info, offset))
+		return TRUE;
+
+	if (*err == 0 || *err == WTAP_ERR_SHORT_READ) {
+		/*
+		 * Nothing more, or only part of the next record, has
+		 * been written; go back to the start of the record, to
+		 * try again later.
+		 */
+		g_free(*err_info);
+		*err_info = NULL;
+		if (file_seek(wth->fh, start, SEEK_SET, err) == -1)
+			return FALSE;
+		*err = 0;
+	}
+	return FALSE;
+}
+
 /*
  * Read a given number of bytes from a file into a buffer or, if
  * buf is NULL, just discard them.
@@ -1652,6 +1749,17 @@ wtap_read_so_far(wtap *wth)
 	return file_tell_raw(wth->fh);
 }
 
+gboolean
+wtap_get_reader_stats(wtap *wth, gboolean random, wtap_reader_stats *stats)
+{
+	FILE_T fh = random ? wth->random_fh : wth->fh;
+
+	if (fh == NULL)
+		return FALSE;
+	file_get_stats(fh, stats);
+	return TRUE;
+}
+
 void
 wtap_rec_init(wtap_rec *rec)
 {
@@ -1675,10 +1783,13 @@ gboolean
 wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info)
 {
+	rec_alloc_state_t alloc_state;
+
 	/*
 	 * Initialize the record to default values.
 	 */
 	wtap_init_rec(wth, rec);
+	wtap_rec_alloc_state(rec, buf, &alloc_state);
 
 	*err = 0;
 	*err_info = NULL;
@@ -1704,8 +1815,147 @@ wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
 		 */
 		g_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_PER_PACKET);
 	}
+	wtap_count_rec_allocs(wth, rec, buf, &alloc_state);
+
+	return TRUE;
+}
+
+void
+wtap_set_seek_read_ahead(wtap *wth, gboolean read_ahead)
+{
+	if (wth->random_fh != NULL)
+		file_set_seek_read_ahead(wth->random_fh, read_ahead);
+}
+
+gboolean
+wtap_seek_to_frame(wtap *wth, guint32 frame_num, guint32 *next_frame_num,
+    int *err, gchar **err_info)
+{
+	*err = 0;
+	*err_info = NULL;
+	if (wth->subtype_seek_to_record == NULL)
+		return FALSE;
+	return wth->subtype_seek_to_record(wth, frame_num, NULL,
+	    next_frame_num, err, err_info);
+}
+
+gboolean
+wtap_seek_to_time(wtap *wth, const nstime_t *ts, guint32 *next_frame_num,
+    int *err, gchar **err_info)
+{
+	*err = 0;
+	*err_info = NULL;
+	if (wth->subtype_seek_to_record == NULL)
+		return FALSE;
+	return wth->subtype_seek_to_record(wth, 0, ts, next_frame_num,
+	    err, err_info);
+}
+
+/*
+ * Once the bisection has narrowed the range down to this many bytes,
+ * just read through it.
+ */
+#define SEEK_TIME_SCAN_BYTES	(64*1024)
+
+/*
+ * Read records from the current sequential position until we get a
+ * packet with a time stamp.  Return 1 if we got one, 0 on EOF, and -1
+ * on an error.
+ */
+static int
+seek_time_read_ts(wtap *wth, wtap_rec *rec, Buffer *buf, gint64 *rec_off,
+    int *err, gchar **err_info)
+{
+	for (;;) {
+		if (!wtap_read(wth, rec, buf, err, err_info, rec_off))
+			return *err == 0 ? 0 : -1;
+		if (rec->rec_type == REC_TYPE_PACKET &&
+		    (rec->presence_flags & WTAP_HAS_TS))
+			return 1;
+	}
+}
+
+gboolean
+wtap_seek_time(wtap *wth, const nstime_t *ts, int *err, gchar **err_info)
+{
+	gint64 start, lo, hi, mid, rec_off, found;
+	wtap_rec rec;
+	Buffer buf;
+	int ret;
+
+	*err = 0;
+	*err_info = NULL;
+	if (wth->subtype_resync == NULL || wth->ispipe ||
+	    file_iscompressed(wth->fh))
+		return FALSE;
+	if ((start = file_tell(wth->fh)) == -1 ||
+	    (hi = wtap_file_size(wth, err)) == -1)
+		return FALSE;
+
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+
+	/*
+	 * lo is always the offset of a record before ts, or the
+	 * position we started at; we never move backwards.
+	 */
+	lo = start;
+	while (hi - lo > SEEK_TIME_SCAN_BYTES) {
+		mid = lo + (hi - lo) / 2;
+		if (!wth->subtype_resync(wth, mid, &rec_off, err, err_info)) {
+			if (*err != 0)
+				goto fail;
+			hi = mid;
+			continue;
+		}
+		if (rec_off >= hi) {
+			hi = mid;
+			continue;
+		}
+		if (file_seek(wth->fh, rec_off, SEEK_SET, err) == -1)
+			goto fail;
+		ret = seek_time_read_ts(wth, &rec, &buf, &found, err, err_info);
+		if (ret == -1)
+			goto fail;
+		if (ret == 1 && nstime_cmp(&rec.ts, ts) < 0)
+			lo = rec_off;
+		else
+			hi = mid;
+	}
 
+	/*
+	 * Read forward from lo to the first record at or after ts, and
+	 * leave the sequential position there; if there isn't one, leave
+	 * it at the end of the file.
+	 */
+	if (file_seek(wth->fh, lo, SEEK_SET, err) == -1)
+		goto fail;
+	for (;;) {
+		ret = seek_time_read_ts(wth, &rec, &buf, &found, err, err_info);
+		if (ret == -1)
+			goto fail;
+		if (ret == 0) {
+			found = file_tell(wth->fh);
+			break;
+		}
+		if (nstime_cmp(&rec.ts, ts) >= 0)
+			break;
+	}
+	if (file_seek(wth->fh, found, SEEK_SET, err) == -1)
+		goto fail;
+
+	wtap_rec_cleanup(&rec);
+	ws_buffer_free(&buf);
 	return TRUE;
+
+fail:
+	/* Put things back where they were. */
+	if (*err == 0)
+		*err = WTAP_ERR_BAD_FILE;
+	(void)file_seek(wth->fh, start, SEEK_SET, &ret);
+	wtap_rec_cleanup(&rec);
+	ws_buffer_free(&buf);
+	return FALSE;
 }
 
 static gboolean
@@ -1804,6 +2054,8 @@ wtap_full_file_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
 void
 wtap_init(gboolean load_wiretap_plugins)
 {
+	guint profile_phase = startup_profile_begin("wtap_init");
+
 	init_open_routines();
 	wtap_opttypes_initialize();
 	wtap_init_encap_types();
@@ -1814,6 +2066,7 @@ wtap_init(gboolean load_wiretap_plugins)
 #endif
 		g_slist_foreach(wtap_plugins, call_plugin_register_wtap_module, NULL);
 	}
+	startup_profile_end(profile_phase);
 }
 
 /*
@@ -1718,6 +1718,34 @@ typedef void (*wtap_new_secrets_callback_t)(guint32 secrets_type, const void *se
 WS_DLL_PUBLIC
 void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secrets);
 
+/** Tell the file's reader that the caller of wtap_read() only wants the
+ * record metadata, such as the record type, lengths, time stamp and
+ * interface, and not the packet data, so that the data can be skipped
+ * rather than copied into the buffer.  This is only a hint; file types
+ * that can't skip the data will still read it.  When the data is
+ * skipped, the buffer's contents are undefined, and so are any
+ * pseudo-header fields that would be derived from the packet data.
+ * wtap_seek_read() always reads the packet data.
+ *
+ * @wth a wtap * returned by a call that opened a file for reading.
+ * @skip TRUE to skip packet data when possible, FALSE to read it.
+ */
+WS_DLL_PUBLIC
+void wtap_set_skip_packet_data(wtap *wth, gboolean skip);
+
+/** Get the number of times that reading a record has had to allocate
+ * memory, for the record's buffer, its options buffer, its comment or
+ * its verdicts, since the file was opened.  A loop that reuses the same
+ * wtap_rec and Buffer should see this stop growing once the largest
+ * records have been read; it's meant for checking that the read paths
+ * don't allocate for every record.
+ *
+ * @wth a wtap * returned by a call that opened a file for reading.
+ * @return the number of allocations.
+ */
+WS_DLL_PUBLIC
+guint64 wtap_get_rec_allocation_count(wtap *wth);
+
 /** Read the next record in the file, filling in *phdr and *buf.
  *
  * @wth a wtap * returned by a call that opened a file for reading.
@@ -1737,6 +1765,16 @@ WS_DLL_PUBLIC
 gboolean wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     gchar **err_info, gint64 *offset);
 
+/** Like wtap_read(), but for a file that's still being written: the
+ * EOF is cleared first and, if the next record hasn't been completely
+ * written yet, the sequential read position is left at its start, and
+ * FALSE is returned with *err set to 0, so that the call can be made
+ * again once more has been written.  This can't be used on pipes.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_read_tail(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
+    gchar **err_info, gint64 *offset);
+
 /** Read the record at a specified offset in a capture file, filling in
  * *phdr and *buf.
  *
@@ -1757,6 +1795,80 @@ WS_DLL_PUBLIC
 gboolean wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
     Buffer *buf, int *err, gchar **err_info);
 
+/** Say whether the next wtap_seek_read() calls will mostly be for
+ * records at ascending offsets, as when saving or printing a range of
+ * records.  While they are, the random access handle reads the file
+ * ahead in another thread, so that they cost about what wtap_read()
+ * would; an occasional seek backwards or far forwards still works,
+ * but stops reading ahead until the reads are sequential again.
+ *
+ * Files that are memory-mapped, or aren't regular files, aren't read
+ * ahead.
+ *
+ * @wth a wtap * returned by a call that opened a file for random-access
+ * reading.
+ * @read_ahead TRUE to start reading ahead, FALSE to stop.
+ */
+WS_DLL_PUBLIC
+void wtap_set_seek_read_ahead(wtap *wth, gboolean read_ahead);
+
+/** If the file has an index of its records, move the sequential read
+ * position to the latest indexed record that's at or before a given
+ * record, so that wtap_read() can get to that record without reading
+ * all of the ones before it.  Records are numbered from 1, in the order
+ * in which wtap_read() returns them.  Blocks before the new position
+ * that wtap_read() doesn't return, such as name resolution and
+ * decryption secrets blocks, are not read.
+ *
+ * Currently only pcapng files written with the WIRESHARK_WTAP_PCAPNG_INDEX
+ * environment variable set, and opened for random access, have an index.
+ *
+ * @wth a wtap * returned by a call that opened a file for random-access
+ * reading.
+ * @frame_num the number of the record wanted.
+ * @next_frame_num set to the number of the record the next wtap_read()
+ * will return.
+ * @param err a positive "errno" value, or a negative number indicating
+ * the type of error, if the seek failed.
+ * @param err_info for some errors, a string giving more details of
+ * the error
+ * @return TRUE on success, FALSE if there's no usable index, with *err
+ * set to 0, or if the seek failed.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_seek_to_frame(wtap *wth, guint32 frame_num,
+    guint32 *next_frame_num, int *err, gchar **err_info);
+
+/** Like wtap_seek_to_frame(), but move the sequential read position to
+ * the latest indexed record that has no records with a time stamp at or
+ * after ts before it, so that reading from there finds all the records
+ * at or after ts, even if the records aren't in time order.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_seek_to_time(wtap *wth, const nstime_t *ts,
+    guint32 *next_frame_num, int *err, gchar **err_info);
+
+/** Move the sequential read position forward to the first record with
+ * a time stamp at or after ts, without an index, by bisecting the file
+ * by offset and resynchronizing on record boundaries.
+ *
+ * This assumes the records are in time order; if they aren't, records
+ * at or after ts can be skipped.  Records are no longer numbered from
+ * the start of the file after a successful call.
+ *
+ * @param wth a wtap * returned by a call to wtap_open_offline.
+ * @param ts the time stamp to seek to.
+ * @param err a positive "errno" value, or a negative number indicating
+ * the type of error, if the seek failed.
+ * @param err_info for some errors, a string giving more details of
+ * the error
+ * @return TRUE on success, FALSE if the file type, a compressed file or
+ * a pipe doesn't allow it, with *err set to 0, or if the seek failed.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_seek_time(wtap *wth, const nstime_t *ts, int *err,
+    gchar **err_info);
+
 /*** initialize a wtap_rec structure ***/
 WS_DLL_PUBLIC
 void wtap_rec_init(wtap_rec *rec);
@@ -1770,7 +1882,9 @@ void wtap_rec_cleanup(wtap_rec *rec);
  */
 typedef enum {
     WTAP_UNCOMPRESSED,
-    WTAP_GZIP_COMPRESSED
+    WTAP_GZIP_COMPRESSED,
+    WTAP_ZSTD_COMPRESSED,   /* read-only */
+    WTAP_LZ4_COMPRESSED     /* read-only */
 } wtap_compression_type;
 
 WS_DLL_PUBLIC
@@ -1790,6 +1904,31 @@ WS_DLL_PUBLIC
 gint64 wtap_read_so_far(wtap *wth);
 WS_DLL_PUBLIC
 gint64 wtap_file_size(wtap *wth, int *err);
+
+/*
+ * How a file has been read, for measuring wiretap itself; the seeks
+ * are broken down by how the reader got to the new position.
+ */
+typedef struct {
+    guint64 raw_reads;          /* read(2) calls on the file */
+    guint64 raw_bytes;          /* bytes they returned */
+    guint64 seeks;              /* file_seek() calls that moved */
+    guint64 seeks_buffered;     /* ... that stayed within the buffer */
+    guint64 seeks_fast;         /* ... that used a fast seek point */
+    guint64 seeks_direct;       /* ... that lseek()ed an uncompressed file */
+    guint64 seeks_rewind;       /* ... that had to go back to the start */
+    guint64 seeks_forward;      /* ... that read forward to the target */
+    guint64 skipped_bytes;      /* (uncompressed) bytes read and thrown away to get there */
+    guint   fast_seek_points;   /* number of fast seek points built so far */
+    guint   buffer_size;        /* size of the input buffer */
+    gboolean mapped;            /* TRUE if the file is memory-mapped */
+} wtap_reader_stats;
+
+/** Get the read statistics of the sequential handle of the file, or of
+ * the random access one if random is TRUE.  Returns FALSE if there's no
+ * such handle.  Reading ahead in another thread isn't counted. */
+WS_DLL_PUBLIC
+gboolean wtap_get_reader_stats(wtap *wth, gboolean random, wtap_reader_stats *stats);
 WS_DLL_PUBLIC
 guint wtap_snapshot_length(wtap *wth); /* per file */
 WS_DLL_PUBLIC
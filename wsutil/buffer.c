@@ -16,6 +16,8 @@
 static GPtrArray *small_buffers = NULL; /* Guaranteed to be at least SMALL_BUFFER_SIZE */
 /* XXX - Add medium and large buffers? */
 
+#define BUFFER_MAX_GROWTH (1024 * 1024) /* Most we'll grow by beyond what's asked for */
+
 /* Initializes a buffer with a certain amount of allocated space */
 void
 ws_buffer_init(Buffer* buffer, gsize space)
@@ -92,8 +94,10 @@ ws_buffer_assure_space(Buffer* buffer, gsize space)
 		return;
 	}
 
-	/* We'll allocate more space */
-	buffer->allocated += space + 1024;
+	/* We'll allocate more space; grow by at least as much as we
+		already have, up to a point, so that a run of ever-larger
+		packets doesn't mean a reallocation for each of them. */
+	buffer->allocated += MAX(space + 1024, MIN(buffer->allocated, BUFFER_MAX_GROWTH));
 	buffer->data = (guint8*)g_realloc(buffer->data, buffer->allocated);
 }
 
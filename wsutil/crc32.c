@@ -17,6 +17,8 @@
 
 #include <glib.h>
 #include <wsutil/crc32.h>
+#include "ws_cpuid.h"
+#include "crc32_int.h"
 
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
@@ -353,6 +355,75 @@ static const guint32 crc32_5D6DCB[] =
 		0x0098206c, 0x00c54da7, 0x0022fbfa, 0x007f9631
 };
 
+/*
+ * Tables for the "slicing-by-4" method for the bit-reflected CRCs, which
+ * processes four bytes per step instead of one: slice[k][i] is the CRC
+ * register contents after running byte i followed by k + 1 zero bytes
+ * through the table, so the four per-byte lookups of a word can be done
+ * independently and XORed together.  They're derived from the byte-wise
+ * tables on first use.
+ */
+static guint32 crc32c_slice[3][256];
+static guint32 crc32_ccitt_slice[3][256];
+
+static void
+crc32_slice_tables_init(const guint32 *table, guint32 slice[3][256])
+{
+	guint i, k;
+
+	for (i = 0; i < 256; i++) {
+		guint32 crc = table[i];
+
+		for (k = 0; k < 3; k++) {
+			crc = (crc >> 8) ^ table[crc & 0xFF];
+			slice[k][i] = crc;
+		}
+	}
+}
+
+static void
+crc32_slice_init(void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter(&initialized)) {
+		crc32_slice_tables_init(crc32c_table, crc32c_slice);
+		crc32_slice_tables_init(crc32_ccitt_table, crc32_ccitt_slice);
+		g_once_init_leave(&initialized, 1);
+	}
+}
+
+static guint32
+crc32_slice4_accumulate(const guint8 *p, guint len, guint32 crc,
+			const guint32 *table, guint32 slice[3][256])
+{
+	crc32_slice_init();
+
+	for (; len >= 4; len -= 4, p += 4) {
+		crc ^= (guint32)p[0] | ((guint32)p[1] << 8) |
+		       ((guint32)p[2] << 16) | ((guint32)p[3] << 24);
+		crc = slice[2][crc & 0xFF] ^ slice[1][(crc >> 8) & 0xFF] ^
+		      slice[0][(crc >> 16) & 0xFF] ^ table[crc >> 24];
+	}
+
+	for (; len > 0; len--)
+		CRC32_ACCUMULATE(crc, *p++, table);
+
+	return crc;
+}
+
+#ifdef HAVE_SSE4_2
+static gboolean
+crc32c_use_sse42(void)
+{
+	static int use_sse42 = -1;
+
+	if (use_sse42 == -1)
+		use_sse42 = ws_cpuid_sse42() ? 1 : 0;
+	return use_sse42;
+}
+#endif
+
 guint32
 crc32c_table_lookup (guchar pos)
 {
@@ -368,23 +439,24 @@ crc32_ccitt_table_lookup (guchar pos)
 guint32
 crc32c_calculate(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
 	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	crc = crc32c_calculate_no_swap(buf, len, crc);
 	return CRC32C_SWAP(crc);
 }
 
 guint32
 crc32c_calculate_no_swap(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	if (len <= 0)
+		return crc;
 
-	return crc;
+#ifdef HAVE_SSE4_2
+	if (crc32c_use_sse42())
+		return crc32c_sse42_calculate_no_swap(buf, len, crc);
+#endif
+
+	return crc32_slice4_accumulate((const guint8 *)buf, (guint)len, crc,
+				       crc32c_table, crc32c_slice);
 }
 
 guint32
@@ -396,11 +468,10 @@ crc32_ccitt(const guint8 *buf, guint len)
 guint32
 crc32_ccitt_seed(const guint8 *buf, guint len, guint32 seed)
 {
-	guint i;
-	guint32 crc32 = seed;
+	guint32 crc32;
 
-	for (i = 0; i < len; i++)
-		CRC32_ACCUMULATE(crc32, buf[i], crc32_ccitt_table);
+	crc32 = crc32_slice4_accumulate(buf, len, seed, crc32_ccitt_table,
+					crc32_ccitt_slice);
 
 	return ( ~crc32 );
 }
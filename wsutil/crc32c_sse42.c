@@ -0,0 +1,68 @@
+/* crc32c_sse42.c
+ * CRC-32C using the SSE 4.2 CRC32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <glib.h>
+#include <string.h>
+#include <nmmintrin.h>
+
+#include "crc32_int.h"
+
+/*
+ * The CRC32 instruction computes the bit-reflected CRC-32C (Castagnoli)
+ * without pre- or post-inversion, which is exactly what the CRC32C()
+ * table step in crc32.c does for every byte.
+ */
+guint32
+crc32c_sse42_calculate_no_swap(const void *buf, int len, guint32 crc)
+{
+	const guint8 *p = (const guint8 *)buf;
+
+	for (; len > 0 && ((gintptr)p & 7) != 0; len--)
+		crc = _mm_crc32_u8(crc, *p++);
+
+#if defined(__x86_64__) || defined(_M_X64)
+	for (; len >= 8; len -= 8, p += 8) {
+		guint64 word;
+
+		memcpy(&word, p, sizeof word);
+		crc = (guint32)_mm_crc32_u64(crc, word);
+	}
+#endif
+	for (; len >= 4; len -= 4, p += 4) {
+		guint32 word;
+
+		memcpy(&word, p, sizeof word);
+		crc = _mm_crc32_u32(crc, word);
+	}
+
+	for (; len > 0; len--)
+		crc = _mm_crc32_u8(crc, *p++);
+
+	return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
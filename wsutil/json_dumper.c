@@ -14,6 +14,12 @@
 #include "json_dumper.h"
 
 #include <math.h>
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /*
  * json_dumper.state[current_depth] describes a nested element:
@@ -43,10 +49,138 @@ enum json_dumper_change {
 };
 
 static void
-json_puts_string(FILE *fp, const char *str, gboolean dot_to_underscore)
+jd_flush(json_dumper *dumper)
+{
+    if (dumper->buffer_len != 0) {
+        fwrite(dumper->buffer, 1, dumper->buffer_len, dumper->output_file);
+        dumper->buffer_len = 0;
+    }
+}
+
+static inline void
+jd_putc(json_dumper *dumper, char c)
+{
+    if (dumper->output_string) {
+        g_string_append_c(dumper->output_string, c);
+    } else {
+        if (G_UNLIKELY(dumper->buffer_len == JSON_DUMPER_BUFFER_SIZE)) {
+            jd_flush(dumper);
+        }
+        dumper->buffer[dumper->buffer_len++] = c;
+    }
+}
+
+static inline void
+jd_puts_len(json_dumper *dumper, const char *s, gsize len)
+{
+    if (dumper->output_string) {
+        g_string_append_len(dumper->output_string, s, len);
+    } else {
+        if (G_UNLIKELY(len > JSON_DUMPER_BUFFER_SIZE - dumper->buffer_len)) {
+            jd_flush(dumper);
+            if (len > JSON_DUMPER_BUFFER_SIZE / 2) {
+                /* Too big to be worth copying. */
+                fwrite(s, 1, len, dumper->output_file);
+                return;
+            }
+        }
+        memcpy(dumper->buffer + dumper->buffer_len, s, len);
+        dumper->buffer_len += len;
+    }
+}
+
+static inline void
+jd_puts(json_dumper *dumper, const char *s)
+{
+    jd_puts_len(dumper, s, strlen(s));
+}
+
+static void
+jd_vprintf(json_dumper *dumper, const char *format, va_list args)
+{
+    if (dumper->output_string) {
+        g_string_append_vprintf(dumper->output_string, format, args);
+    } else {
+        va_list args_copy;
+        int len;
+
+        /* Values are almost always short; format them in place. */
+        va_copy(args_copy, args);
+        len = vsnprintf(dumper->buffer + dumper->buffer_len,
+                JSON_DUMPER_BUFFER_SIZE - dumper->buffer_len, format, args_copy);
+        va_end(args_copy);
+        if (len >= 0 && (gsize)len < JSON_DUMPER_BUFFER_SIZE - dumper->buffer_len) {
+            dumper->buffer_len += len;
+        } else {
+            jd_flush(dumper);
+            vfprintf(dumper->output_file, format, args);
+        }
+    }
+}
+
+/*
+ * Writes out buffered output once we're back at the top level, so that
+ * output is never held back between (for instance) TShark's packets or
+ * sharkd's responses, and callers can write to output_file themselves.
+ */
+static inline void
+jd_flush_at_top_level(json_dumper *dumper)
+{
+    if (dumper->current_depth <= 1 && !dumper->output_string) {
+        jd_flush(dumper);
+    }
+}
+
+/* Nonzero for characters that json_puts_string() has to look at. */
+static const guint8 json_special_char[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    ['"'] = 1, ['\\'] = 1, ['/'] = 1, ['.'] = 2,
+};
+
+/*
+ * Returns the number of characters at the start of "str" that can be
+ * written as they are, i.e. that are not control characters, quotes,
+ * backslashes, slashes (which need a look at the previous character)
+ * or, if requested, dots.
+ */
+static inline gsize
+json_plain_run(const char *str, gsize len, gboolean dot_to_underscore)
+{
+    const guint8 *s = (const guint8 *)str;
+    guint8 special = dot_to_underscore ? 3 : 1;
+    gsize i = 0;
+
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i dot = _mm_set1_epi8(dot_to_underscore ? '.' : '"');
+    const __m128i max_cntrl = _mm_set1_epi8(0x1f);
+
+    while (i + 16 <= len) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        /* Unsigned v <= 0x1f */
+        __m128i hit = _mm_cmpeq_epi8(_mm_min_epu8(v, max_cntrl), v);
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, quote));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, backslash));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, slash));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, dot));
+        if (_mm_movemask_epi8(hit) != 0)
+            break;
+        i += 16;
+    }
+#endif
+    while (i < len && !(json_special_char[s[i]] & special))
+        i++;
+    return i;
+}
+
+static void
+json_puts_string(json_dumper *dumper, const char *str, gboolean dot_to_underscore)
 {
     if (!str) {
-        fputs("null", fp);
+        jd_puts(dumper, "null");
         return;
     }
 
@@ -55,25 +189,39 @@ json_puts_string(FILE *fp, const char *str, gboolean dot_to_underscore)
         "u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
     };
 
-    fputc('"', fp);
-    for (int i = 0; str[i]; i++) {
-        if ((guint)str[i] < 0x20) {
-            fputc('\\', fp);
-            fputs(json_cntrl[(guint)str[i]], fp);
-        } else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
-            // Convert </script> to <\/script> to avoid breaking web pages.
-            fputs("\\/", fp);
-        } else {
-            if (str[i] == '\\' || str[i] == '"') {
-                fputc('\\', fp);
+    jd_putc(dumper, '"');
+    /* Characters that need no escaping are written in runs. */
+    gsize len = strlen(str);
+    gsize run = 0;
+    gsize i = 0;
+    while ((i += json_plain_run(str + i, len - i, dot_to_underscore)) < len) {
+        guint8 ch = (guint8)str[i];
+        if (ch < 0x20) {
+            jd_puts_len(dumper, str + run, i - run);
+            jd_putc(dumper, '\\');
+            jd_puts(dumper, json_cntrl[ch]);
+            run = i + 1;
+        } else if (ch == '/') {
+            if (i > 0 && str[i - 1] == '<') {
+                // Convert </script> to <\/script> to avoid breaking web pages.
+                jd_puts_len(dumper, str + run, i - run);
+                jd_puts(dumper, "\\/");
+                run = i + 1;
             }
-            if (dot_to_underscore && str[i] == '.')
-                fputc('_', fp);
-            else
-                fputc(str[i], fp);
+        } else if (ch == '\\' || ch == '"') {
+            jd_puts_len(dumper, str + run, i - run);
+            jd_putc(dumper, '\\');
+            jd_putc(dumper, ch);
+            run = i + 1;
+        } else if (dot_to_underscore && ch == '.') {
+            jd_puts_len(dumper, str + run, i - run);
+            jd_putc(dumper, '_');
+            run = i + 1;
         }
+        i++;
     }
-    fputc('"', fp);
+    jd_puts_len(dumper, str + run, len - run);
+    jd_putc(dumper, '"');
 }
 
 /**
@@ -100,7 +248,12 @@ json_dumper_bad(json_dumper *dumper, enum json_dumper_change change,
         /* Console output can be slow, disable log calls to speed up fuzzing. */
         return;
     }
-    fflush(dumper->output_file);
+    if (dumper->output_file) {
+        if (!dumper->output_string) {
+            jd_flush(dumper);
+        }
+        fflush(dumper->output_file);
+    }
     g_error("Bad json_dumper state: %s; change=%d type=%d depth=%d prev/curr/next state=%02x %02x %02x",
             what, change, type, dumper->current_depth, states[0], states[1], states[2]);
 }
@@ -108,17 +261,20 @@ json_dumper_bad(json_dumper *dumper, enum json_dumper_change change,
 /**
  * Checks that the dumper state is valid for a new change. Any error will be
  * sticky and prevent further dumps from succeeding.
+ *
+ * This runs for every token, so it is inlined and the error paths are
+ * marked unlikely.
  */
-static gboolean
+static inline gboolean
 json_dumper_check_state(json_dumper *dumper, enum json_dumper_change change, enum json_dumper_element_type type)
 {
-    if ((dumper->flags & JSON_DUMPER_FLAGS_ERROR)) {
+    if (G_UNLIKELY(dumper->flags & JSON_DUMPER_FLAGS_ERROR)) {
         json_dumper_bad(dumper, change, type, "previous corruption detected");
         return FALSE;
     }
 
     int depth = dumper->current_depth;
-    if (depth < 0 || depth >= JSON_DUMPER_MAX_DEPTH) {
+    if (G_UNLIKELY(depth < 0 || depth >= JSON_DUMPER_MAX_DEPTH)) {
         /* Corrupted state, no point in continuing. */
         dumper->flags |= JSON_DUMPER_FLAGS_ERROR;
         json_dumper_bad(dumper, change, type, "depth corruption");
@@ -159,7 +315,7 @@ json_dumper_check_state(json_dumper *dumper, enum json_dumper_change change, enu
             ok = depth == 0;
             break;
     }
-    if (!ok) {
+    if (G_UNLIKELY(!ok)) {
         dumper->flags |= JSON_DUMPER_FLAGS_ERROR;
         json_dumper_bad(dumper, change, type, "illegal transition");
     }
@@ -167,12 +323,12 @@ json_dumper_check_state(json_dumper *dumper, enum json_dumper_change change, enu
 }
 
 static void
-print_newline_indent(const json_dumper *dumper, int depth)
+print_newline_indent(json_dumper *dumper, int depth)
 {
     if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
-        fputc('\n', dumper->output_file);
+        jd_putc(dumper, '\n');
         for (int i = 0; i < depth; i++) {
-            fputs("  ", dumper->output_file);
+            jd_puts(dumper, "  ");
         }
     }
 }
@@ -208,7 +364,7 @@ prepare_token(json_dumper *dumper)
     }
 
     if (dumper->state[dumper->current_depth]) {
-        fputc(',', dumper->output_file);
+        jd_putc(dumper, ',');
     }
     print_newline_indent(dumper, dumper->current_depth);
 }
@@ -218,13 +374,13 @@ prepare_token(json_dumper *dumper)
  * necessary, it is preceded by newline and indentation).
  */
 static void
-finish_token(const json_dumper *dumper, char close_char)
+finish_token(json_dumper *dumper, char close_char)
 {
     // if the object/array was non-empty, add a newline and indentation.
     if (dumper->state[dumper->current_depth]) {
         print_newline_indent(dumper, dumper->current_depth - 1);
     }
-    fputc(close_char, dumper->output_file);
+    jd_putc(dumper, close_char);
 }
 
 void
@@ -235,7 +391,7 @@ json_dumper_begin_object(json_dumper *dumper)
     }
 
     prepare_token(dumper);
-    fputc('{', dumper->output_file);
+    jd_putc(dumper, '{');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_OBJECT;
     ++dumper->current_depth;
@@ -250,10 +406,10 @@ json_dumper_set_member_name(json_dumper *dumper, const char *name)
     }
 
     prepare_token(dumper);
-    json_puts_string(dumper->output_file, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
-    fputc(':', dumper->output_file);
+    json_puts_string(dumper, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
+    jd_putc(dumper, ':');
     if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
-        fputc(' ', dumper->output_file);
+        jd_putc(dumper, ' ');
     }
 
     dumper->state[dumper->current_depth - 1] |= JSON_DUMPER_HAS_NAME;
@@ -269,6 +425,7 @@ json_dumper_end_object(json_dumper *dumper)
     finish_token(dumper, '}');
 
     --dumper->current_depth;
+    jd_flush_at_top_level(dumper);
 }
 
 void
@@ -279,7 +436,7 @@ json_dumper_begin_array(json_dumper *dumper)
     }
 
     prepare_token(dumper);
-    fputc('[', dumper->output_file);
+    jd_putc(dumper, '[');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_ARRAY;
     ++dumper->current_depth;
@@ -296,6 +453,7 @@ json_dumper_end_array(json_dumper *dumper)
     finish_token(dumper, ']');
 
     --dumper->current_depth;
+    jd_flush_at_top_level(dumper);
 }
 
 void
@@ -306,9 +464,10 @@ json_dumper_value_string(json_dumper *dumper, const char *value)
     }
 
     prepare_token(dumper);
-    json_puts_string(dumper->output_file, value, FALSE);
+    json_puts_string(dumper, value, FALSE);
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
+    jd_flush_at_top_level(dumper);
 }
 
 void
@@ -321,12 +480,13 @@ json_dumper_value_double(json_dumper *dumper, double value)
     prepare_token(dumper);
     gchar buffer[G_ASCII_DTOSTR_BUF_SIZE] = { 0 };
     if (isfinite(value) && g_ascii_dtostr(buffer, G_ASCII_DTOSTR_BUF_SIZE, value) && buffer[0]) {
-        fputs(buffer, dumper->output_file);
+        jd_puts(dumper, buffer);
     } else {
-        fputs("null", dumper->output_file);
+        jd_puts(dumper, "null");
     }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
+    jd_flush_at_top_level(dumper);
 }
 
 void
@@ -337,9 +497,10 @@ json_dumper_value_va_list(json_dumper *dumper, const char *format, va_list ap)
     }
 
     prepare_token(dumper);
-    vfprintf(dumper->output_file, format, ap);
+    jd_vprintf(dumper, format, ap);
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
+    jd_flush_at_top_level(dumper);
 }
 
 void
@@ -359,11 +520,20 @@ json_dumper_finish(json_dumper *dumper)
         return FALSE;
     }
 
-    fputc('\n', dumper->output_file);
+    jd_putc(dumper, '\n');
     dumper->state[0] = 0;
+    json_dumper_flush(dumper);
     return TRUE;
 }
 
+void
+json_dumper_flush(json_dumper *dumper)
+{
+    if (!dumper->output_string && dumper->output_file) {
+        jd_flush(dumper);
+    }
+}
+
 void
 json_dumper_begin_base64(json_dumper *dumper)
 {
@@ -376,7 +546,7 @@ json_dumper_begin_base64(json_dumper *dumper)
 
     prepare_token(dumper);
 
-    fputc('"', dumper->output_file);
+    jd_putc(dumper, '"');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_BASE64;
     ++dumper->current_depth;
@@ -396,7 +566,7 @@ json_dumper_write_base64(json_dumper* dumper, const guchar *data, size_t len)
     while (len > 0) {
         gsize chunk_size = len < CHUNK_SIZE ? len : CHUNK_SIZE;
         gsize output_size = g_base64_encode_step(data, chunk_size, FALSE, buf, &dumper->base64_state, &dumper->base64_save);
-        fwrite(buf, 1, output_size, dumper->output_file);
+        jd_puts_len(dumper, buf, output_size);
         data += chunk_size;
         len -= chunk_size;
     }
@@ -415,9 +585,10 @@ json_dumper_end_base64(json_dumper *dumper)
     gsize wrote;
 
     wrote = g_base64_encode_close(FALSE, buf, &dumper->base64_state, &dumper->base64_save);
-    fwrite(buf, 1, wrote, dumper->output_file);
+    jd_puts_len(dumper, buf, wrote);
 
-    fputc('"', dumper->output_file);
+    jd_putc(dumper, '"');
 
     --dumper->current_depth;
+    jd_flush_at_top_level(dumper);
 }
@@ -50,8 +50,16 @@ extern "C" {
 
 /** Maximum object/array nesting depth. */
 #define JSON_DUMPER_MAX_DEPTH   1100
+/**
+ * Size of the buffer that output to output_file is collected in. It is
+ * written out when full, when the dumper gets back to the top level (or
+ * to the first level of a top-level array or object) and by
+ * json_dumper_finish() and json_dumper_flush().
+ */
+#define JSON_DUMPER_BUFFER_SIZE (16 * 1024)
 typedef struct json_dumper {
-    FILE   *output_file;    /**< Output file, must be set. */
+    FILE   *output_file;    /**< Output file, must be set unless output_string is. */
+    GString *output_string; /**< Output string, used instead of output_file if set. */
 #define JSON_DUMPER_FLAGS_PRETTY_PRINT  (1 << 0)    /* Enable pretty printing. */
 #define JSON_DUMPER_DOT_TO_UNDERSCORE   (1 << 1)    /* Convert dots to underscores in keys */
     int     flags;
@@ -60,6 +68,8 @@ typedef struct json_dumper {
     gint    base64_state;
     gint    base64_save;
     guint8  state[JSON_DUMPER_MAX_DEPTH];
+    gsize   buffer_len;
+    char    buffer[JSON_DUMPER_BUFFER_SIZE];
 } json_dumper;
 
 WS_DLL_PUBLIC void
@@ -114,6 +124,13 @@ json_dumper_write_base64(json_dumper *dumper, const guchar *data, size_t len);
 WS_DLL_PUBLIC gboolean
 json_dumper_finish(json_dumper *dumper);
 
+/**
+ * Writes out buffered output. Only needed by callers that write to
+ * output_file themselves while in the middle of a nested object or array.
+ */
+WS_DLL_PUBLIC void
+json_dumper_flush(json_dumper *dumper);
+
 #ifdef __cplusplus
 }
 #endif
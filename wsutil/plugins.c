@@ -24,6 +24,8 @@
 #include <wsutil/privileges.h>
 #include <wsutil/file_util.h>
 #include <wsutil/report_message.h>
+#include <wsutil/startup_profile.h>
+#include <wsutil/time_util.h>
 
 #include <wsutil/plugins.h>
 #include <wsutil/ws_printf.h> /* ws_debug_printf */
@@ -134,6 +136,7 @@ scan_plugins_dir(GHashTable *plugins_module, const char *dirpath, plugin_type_e
     gpointer       symbol;
     const char    *plug_version;
     plugin        *new_plug;
+    guint64        start_ns;
 
     if (append_type)
         plugin_folder = g_build_filename(dirpath, type_to_dir(type), (gchar *)NULL);
@@ -161,6 +164,7 @@ scan_plugins_dir(GHashTable *plugins_module, const char *dirpath, plugin_type_e
             continue;
         }
 
+        start_ns = get_monotonic_ns();
         plugin_file = g_build_filename(plugin_folder, name, (gchar *)NULL);
         handle = g_module_open(plugin_file, G_MODULE_BIND_LOCAL);
         g_free(plugin_file);
@@ -204,6 +208,8 @@ DIAG_ON_PEDANTIC
 
         /* Add it to the list of plugins. */
         g_hash_table_replace(plugins_module, new_plug->name, new_plug);
+
+        startup_profile_item("plugin", name, get_monotonic_ns() - start_ns);
     }
     ws_dir_close(dir);
     g_free(plugin_folder);
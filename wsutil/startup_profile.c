@@ -0,0 +1,348 @@
+/* startup_profile.c
+ * Startup time breakdown
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/json_dumper.h>
+#include <wsutil/report_message.h>
+#include <wsutil/strtoi.h>
+#include <wsutil/time_util.h>
+
+#include "startup_profile.h"
+
+#define DEFAULT_THRESHOLD_US    500
+
+typedef struct {
+    const char *name;
+    guint       parent;         /* STARTUP_PROFILE_NONE for top level */
+    guint64     start_ns;
+    guint64     duration_ns;
+    gboolean    ended;
+} profile_phase_t;
+
+typedef struct {
+    const char *category;       /* static */
+    char       *name;
+    guint       phase;
+    guint64     ns;
+} profile_item_t;
+
+static gboolean enabled;
+static char *app_name;
+static char *output_path;
+static guint64 threshold_ns;
+static guint64 origin_ns;
+
+/* Protects the fields below; items may be recorded by the dissector
+ * registration worker thread. */
+static GMutex profile_mtx;
+static GArray *phases;          /* of profile_phase_t */
+static GArray *items;           /* of profile_item_t */
+static guint current_phase = STARTUP_PROFILE_NONE;
+
+void
+startup_profile_enable(const char *name, const char *path)
+{
+    const char *env;
+    guint threshold_us = DEFAULT_THRESHOLD_US;
+
+    if (enabled)
+        return;
+
+    env = g_getenv("WIRESHARK_STARTUP_PROFILE_THRESHOLD");
+    if (env && !ws_strtou(env, NULL, &threshold_us)) {
+        threshold_us = DEFAULT_THRESHOLD_US;
+    }
+
+    app_name = g_strdup(name);
+    output_path = g_strdup(path);
+    threshold_ns = (guint64)threshold_us * 1000;
+    phases = g_array_new(FALSE, FALSE, sizeof(profile_phase_t));
+    items = g_array_new(FALSE, FALSE, sizeof(profile_item_t));
+    origin_ns = get_monotonic_ns();
+    enabled = TRUE;
+}
+
+gboolean
+startup_profile_enabled(void)
+{
+    return enabled;
+}
+
+guint
+startup_profile_begin(const char *phase)
+{
+    profile_phase_t p;
+    guint handle;
+
+    if (!enabled)
+        return STARTUP_PROFILE_NONE;
+
+    p.name = phase;
+    p.start_ns = get_monotonic_ns();
+    p.duration_ns = 0;
+    p.ended = FALSE;
+
+    g_mutex_lock(&profile_mtx);
+    p.parent = current_phase;
+    handle = phases->len;
+    g_array_append_val(phases, p);
+    current_phase = handle;
+    g_mutex_unlock(&profile_mtx);
+
+    return handle;
+}
+
+void
+startup_profile_end(guint handle)
+{
+    profile_phase_t *p;
+
+    if (!enabled || handle == STARTUP_PROFILE_NONE)
+        return;
+
+    g_mutex_lock(&profile_mtx);
+    if (handle < phases->len) {
+        p = &g_array_index(phases, profile_phase_t, handle);
+        p->duration_ns = get_monotonic_ns() - p->start_ns;
+        p->ended = TRUE;
+        /* Tolerate phases that are ended out of order. */
+        current_phase = p->parent;
+    }
+    g_mutex_unlock(&profile_mtx);
+}
+
+void
+startup_profile_item(const char *category, const char *name, guint64 ns)
+{
+    profile_item_t item;
+
+    if (!enabled)
+        return;
+
+    item.category = category;
+    item.name = g_strdup(name);
+    item.ns = ns;
+
+    g_mutex_lock(&profile_mtx);
+    item.phase = current_phase;
+    g_array_append_val(items, item);
+    g_mutex_unlock(&profile_mtx);
+}
+
+typedef struct {
+    guint   count;
+    guint64 ns;
+} below_threshold_t;
+
+static void
+write_below_threshold(gpointer key, gpointer value, gpointer user_data)
+{
+    json_dumper *dumper = (json_dumper *)user_data;
+    below_threshold_t *bt = (below_threshold_t *)value;
+
+    json_dumper_set_member_name(dumper, (const char *)key);
+    json_dumper_begin_object(dumper);
+    json_dumper_set_member_name(dumper, "count");
+    json_dumper_value_anyf(dumper, "%u", bt->count);
+    json_dumper_set_member_name(dumper, "ns");
+    json_dumper_value_anyf(dumper, "%" G_GUINT64_FORMAT, bt->ns);
+    json_dumper_end_object(dumper);
+}
+
+static gint
+compare_items_by_time(gconstpointer a, gconstpointer b)
+{
+    const profile_item_t *ia = *(const profile_item_t * const *)a;
+    const profile_item_t *ib = *(const profile_item_t * const *)b;
+
+    if (ia->ns != ib->ns)
+        return ia->ns > ib->ns ? -1 : 1;
+    return 0;
+}
+
+/* Writes the items recorded in one phase, slowest first. */
+static void
+write_phase_items(json_dumper *dumper, guint phase)
+{
+    GPtrArray *listed = g_ptr_array_new();
+    GHashTable *below = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+    guint i;
+
+    for (i = 0; i < items->len; i++) {
+        profile_item_t *item = &g_array_index(items, profile_item_t, i);
+
+        if (item->phase != phase)
+            continue;
+        if (item->ns >= threshold_ns) {
+            g_ptr_array_add(listed, item);
+        } else {
+            below_threshold_t *bt = (below_threshold_t *)g_hash_table_lookup(below, item->category);
+            if (!bt) {
+                bt = g_new0(below_threshold_t, 1);
+                g_hash_table_insert(below, (gpointer)item->category, bt);
+            }
+            bt->count++;
+            bt->ns += item->ns;
+        }
+    }
+    g_ptr_array_sort(listed, compare_items_by_time);
+
+    if (listed->len > 0) {
+        json_dumper_set_member_name(dumper, "items");
+        json_dumper_begin_array(dumper);
+        for (i = 0; i < listed->len; i++) {
+            profile_item_t *item = (profile_item_t *)g_ptr_array_index(listed, i);
+
+            json_dumper_begin_object(dumper);
+            json_dumper_set_member_name(dumper, "category");
+            json_dumper_value_string(dumper, item->category);
+            json_dumper_set_member_name(dumper, "name");
+            json_dumper_value_string(dumper, item->name);
+            json_dumper_set_member_name(dumper, "ns");
+            json_dumper_value_anyf(dumper, "%" G_GUINT64_FORMAT, item->ns);
+            json_dumper_end_object(dumper);
+        }
+        json_dumper_end_array(dumper);
+    }
+    if (g_hash_table_size(below) > 0) {
+        json_dumper_set_member_name(dumper, "below_threshold");
+        json_dumper_begin_object(dumper);
+        g_hash_table_foreach(below, write_below_threshold, dumper);
+        json_dumper_end_object(dumper);
+    }
+
+    g_ptr_array_free(listed, TRUE);
+    g_hash_table_destroy(below);
+}
+
+static void
+write_phases(json_dumper *dumper, guint parent)
+{
+    guint i;
+
+    json_dumper_begin_array(dumper);
+    for (i = 0; i < phases->len; i++) {
+        profile_phase_t *p = &g_array_index(phases, profile_phase_t, i);
+
+        if (p->parent != parent)
+            continue;
+
+        json_dumper_begin_object(dumper);
+        json_dumper_set_member_name(dumper, "name");
+        json_dumper_value_string(dumper, p->name);
+        json_dumper_set_member_name(dumper, "start_ns");
+        json_dumper_value_anyf(dumper, "%" G_GUINT64_FORMAT, p->start_ns - origin_ns);
+        json_dumper_set_member_name(dumper, "duration_ns");
+        json_dumper_value_anyf(dumper, "%" G_GUINT64_FORMAT, p->duration_ns);
+        if (!p->ended) {
+            json_dumper_set_member_name(dumper, "incomplete");
+            json_dumper_value_anyf(dumper, "true");
+        }
+        write_phase_items(dumper, i);
+        json_dumper_set_member_name(dumper, "phases");
+        write_phases(dumper, i);
+        json_dumper_end_object(dumper);
+    }
+    json_dumper_end_array(dumper);
+}
+
+gboolean
+startup_profile_write(void)
+{
+    FILE *fp;
+    json_dumper dumper = { 0 };
+    gboolean to_stdout;
+    gboolean ok = TRUE;
+    guint64 total_ns;
+    guint i;
+
+    if (!enabled)
+        return TRUE;
+
+    total_ns = get_monotonic_ns() - origin_ns;
+
+    to_stdout = strcmp(output_path, "-") == 0;
+    if (to_stdout) {
+        fp = stdout;
+    } else {
+        fp = ws_fopen(output_path, "w");
+        if (!fp) {
+            report_open_failure(output_path, errno, TRUE);
+            ok = FALSE;
+        }
+    }
+
+    g_mutex_lock(&profile_mtx);
+    if (fp) {
+        dumper.output_file = fp;
+        dumper.flags = JSON_DUMPER_FLAGS_PRETTY_PRINT;
+
+        json_dumper_begin_object(&dumper);
+        json_dumper_set_member_name(&dumper, "application");
+        json_dumper_value_string(&dumper, app_name);
+        json_dumper_set_member_name(&dumper, "threshold_ns");
+        json_dumper_value_anyf(&dumper, "%" G_GUINT64_FORMAT, threshold_ns);
+        json_dumper_set_member_name(&dumper, "total_ns");
+        json_dumper_value_anyf(&dumper, "%" G_GUINT64_FORMAT, total_ns);
+        write_phase_items(&dumper, STARTUP_PROFILE_NONE);
+        json_dumper_set_member_name(&dumper, "phases");
+        write_phases(&dumper, STARTUP_PROFILE_NONE);
+        json_dumper_end_object(&dumper);
+        if (!json_dumper_finish(&dumper))
+            ok = FALSE;
+        fputc('\n', fp);
+
+        if (to_stdout) {
+            fflush(fp);
+        } else if (fclose(fp) == EOF) {
+            report_write_failure(output_path, errno);
+            ok = FALSE;
+        }
+    }
+
+    for (i = 0; i < items->len; i++)
+        g_free(g_array_index(items, profile_item_t, i).name);
+    g_array_free(items, TRUE);
+    g_array_free(phases, TRUE);
+    items = NULL;
+    phases = NULL;
+    current_phase = STARTUP_PROFILE_NONE;
+    enabled = FALSE;
+    g_mutex_unlock(&profile_mtx);
+
+    g_free(app_name);
+    g_free(output_path);
+    app_name = NULL;
+    output_path = NULL;
+
+    return ok;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,90 @@
+/* startup_profile.h
+ * Startup time breakdown
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __STARTUP_PROFILE_H__
+#define __STARTUP_PROFILE_H__
+
+#include "ws_symbol_export.h"
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Records how long each part of program startup takes, for the
+ * --startup-profile option of TShark, sharkd and Wireshark.
+ *
+ * Startup is split into nested phases ("epan_init", "proto_init",
+ * "register_dissectors", ...), each bracketed by startup_profile_begin()
+ * and startup_profile_end(). Within a phase, individual items (a
+ * dissector's registration routine, a plugin load, a UAT) can be recorded
+ * with startup_profile_item(); only items that took at least the
+ * threshold are listed, the rest are summed per category.
+ *
+ * All functions do nothing until startup_profile_enable() is called, so
+ * they can be left in place in normal startup.
+ */
+
+/** Marker returned by startup_profile_begin() when profiling is off. */
+#define STARTUP_PROFILE_NONE G_MAXUINT
+
+/**
+ * Turn on profiling. The report is written to "path" by
+ * startup_profile_write(); "-" means the standard output.
+ *
+ * The item threshold is 500 microseconds, or the number of microseconds
+ * in the WIRESHARK_STARTUP_PROFILE_THRESHOLD environment variable.
+ */
+WS_DLL_PUBLIC void startup_profile_enable(const char *app_name, const char *path);
+
+/** TRUE if startup_profile_enable() has been called. */
+WS_DLL_PUBLIC gboolean startup_profile_enabled(void);
+
+/**
+ * Start timing a phase. Phases begun before the current phase ends are
+ * nested in it. Returns a handle to pass to startup_profile_end().
+ */
+WS_DLL_PUBLIC guint startup_profile_begin(const char *phase);
+
+/** Stop timing a phase started with startup_profile_begin(). */
+WS_DLL_PUBLIC void startup_profile_end(guint handle);
+
+/**
+ * Record that "name" in "category" (e.g. "register", "handoff",
+ * "plugin") took "ns" nanoseconds. May be called from any thread.
+ */
+WS_DLL_PUBLIC void startup_profile_item(const char *category, const char *name, guint64 ns);
+
+/**
+ * Write the report as JSON and stop profiling. Returns FALSE, after
+ * reporting the error, if the report could not be written.
+ */
+WS_DLL_PUBLIC gboolean startup_profile_write(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __STARTUP_PROFILE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -63,6 +63,14 @@ void log_resource_usage(gboolean reset_delta, const char *format, ...);
 WS_DLL_PUBLIC
 guint64 create_timestamp(void);
 
+/**
+ * Fetch a monotonic time in nanoseconds, for measuring how long something
+ * took.  It has no fixed starting point, and the resolution depends on
+ * the platform.
+ */
+WS_DLL_PUBLIC
+guint64 get_monotonic_ns(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
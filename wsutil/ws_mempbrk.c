@@ -27,6 +27,11 @@
 #include "ws_mempbrk.h"
 #include "ws_mempbrk_int.h"
 
+#include <string.h>
+
+/* Largest number of needles for which ws_mempbrk_swar_exec() is used. */
+#define SWAR_MAX_NEEDLES    3
+
 void
 ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const gchar *needles)
 {
@@ -36,6 +41,12 @@ ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const gchar *needles)
         n++;
     }
 
+    pattern->num_needles = 0;
+    if (n - needles <= SWAR_MAX_NEEDLES) {
+        pattern->num_needles = (guint)(n - needles);
+        memcpy(pattern->needles, needles, pattern->num_needles);
+    }
+
 #ifdef HAVE_SSE4_2
     ws_mempbrk_sse42_compile(pattern, needles);
 #endif
@@ -60,6 +71,43 @@ ws_mempbrk_portable_exec(const guint8* haystack, size_t haystacklen, const ws_me
 }
 
 
+/*
+ * Scan for one of up to SWAR_MAX_NEEDLES needles eight bytes at a time
+ * ("SIMD within a register"), so that searches for short needle sets
+ * such as CR/LF are fast even where SSE 4.2 isn't available.
+ *
+ * A word contains a byte equal to the needle iff the word XORed with the
+ * needle repeated in every byte contains a zero byte, and
+ * (v - 0x01..01) & ~v & 0x80..80 is non-zero iff v contains a zero byte.
+ */
+#define SWAR_ONES   G_GUINT64_CONSTANT(0x0101010101010101)
+#define SWAR_HIGHS  G_GUINT64_CONSTANT(0x8080808080808080)
+#define SWAR_HAS_ZERO_BYTE(v) (((v) - SWAR_ONES) & ~(v) & SWAR_HIGHS)
+
+static const guint8 *
+ws_mempbrk_swar_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    const guint8 *haystack_end = haystack + haystacklen;
+    guint64 repeated[SWAR_MAX_NEEDLES];
+    guint i;
+
+    for (i = 0; i < pattern->num_needles; i++)
+        repeated[i] = SWAR_ONES * pattern->needles[i];
+
+    while (haystack_end - haystack >= 8) {
+        guint64 word, found = 0;
+
+        memcpy(&word, haystack, sizeof word);
+        for (i = 0; i < pattern->num_needles; i++)
+            found |= SWAR_HAS_ZERO_BYTE(word ^ repeated[i]);
+        if (found)
+            return ws_mempbrk_portable_exec(haystack, 8, pattern, found_needle);
+        haystack += 8;
+    }
+
+    return ws_mempbrk_portable_exec(haystack, haystack_end - haystack, pattern, found_needle);
+}
+
 WS_DLL_PUBLIC const guint8 *
 ws_mempbrk_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
 {
@@ -68,6 +116,18 @@ ws_mempbrk_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pat
         return ws_mempbrk_sse42_exec(haystack, haystacklen, pattern, found_needle);
 #endif
 
+    if (pattern->num_needles == 1) {
+        /* The C library's memchr() is usually vectorized. */
+        const guint8 *result = (const guint8 *)memchr(haystack, pattern->needles[0], haystacklen);
+
+        if (result && found_needle)
+            *found_needle = *result;
+        return result;
+    }
+
+    if (haystacklen >= 8 && pattern->num_needles != 0)
+        return ws_mempbrk_swar_exec(haystack, haystacklen, pattern, found_needle);
+
     return ws_mempbrk_portable_exec(haystack, haystacklen, pattern, found_needle);
 }
 
@@ -20,6 +20,8 @@
  */
 typedef struct {
     gchar patt[256];
+    guint num_needles;          /* number of needles, if no more than 3 */
+    guint8 needles[3];
 #ifdef HAVE_SSE4_2
     gboolean use_sse42;
     __m128i mask;
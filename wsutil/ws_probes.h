@@ -0,0 +1,67 @@
+/* ws_probes.h
+ *
+ * Statically defined tracing probes (USDT/DTrace)
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_PROBES_H__
+#define __WS_PROBES_H__
+
+/*
+ * WS_PROBEn(name, arg1, ..., argn) marks a point in a hot path that
+ * bpftrace, perf, SystemTap or DTrace can attach to, e.g.
+ *
+ *   bpftrace -e 'usdt:./run/tshark:wireshark:dissect_record_begin { @[arg0] = count(); }'
+ *
+ * All probes are in the "wireshark" provider. Arguments should be
+ * integers or pointers; they are evaluated even if nothing is attached,
+ * so keep them cheap. An unattached probe is a single nop.
+ *
+ * The probes are compiled in if <sys/sdt.h> was found and ENABLE_USDT
+ * is on (the default), and compile to nothing otherwise.
+ *
+ * Current probes:
+ *
+ *   dissect_record_begin(frame, length)   dissect_record_end(frame)
+ *   call_dissector(frame, proto_id, length)
+ *   dfvm_apply_begin(insns)                dfvm_apply_end(result)
+ *   tap_push(frame, tapped)
+ *   wtap_read(rec_type, caplen, offset)
+ *   capture_dispatch(packets)
+ *   ringbuf_switch(file_num)
+ *   wmem_block_new(size)
+ */
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define WS_PROBE0(name)                 DTRACE_PROBE(wireshark, name)
+#define WS_PROBE1(name, a1)             DTRACE_PROBE1(wireshark, name, a1)
+#define WS_PROBE2(name, a1, a2)         DTRACE_PROBE2(wireshark, name, a1, a2)
+#define WS_PROBE3(name, a1, a2, a3)     DTRACE_PROBE3(wireshark, name, a1, a2, a3)
+#else
+#define WS_PROBE0(name)                 ((void)0)
+#define WS_PROBE1(name, a1)             ((void)0)
+#define WS_PROBE2(name, a1, a2)         ((void)0)
+#define WS_PROBE3(name, a1, a2, a3)     ((void)0)
+#endif
+
+#endif /* __WS_PROBES_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,453 @@
+/* wtapbench.c
+ * Measures how fast wiretap reads capture files, sequentially and at
+ * random, without any dissection
+ *
+ * Based on captype.c
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <locale.h>
+#include <errno.h>
+
+/*
+ * If we have getopt_long() in the system library, include <getopt.h>.
+ * Otherwise, we're using our own getopt_long() (either because the
+ * system has getopt() but not getopt_long(), as with some UN*Xes,
+ * or because it doesn't even have getopt(), as with Windows), so
+ * include our getopt_long()'s header.
+ */
+#ifdef HAVE_GETOPT_LONG
+#include <getopt.h>
+#else
+#include <wsutil/wsgetopt.h>
+#endif
+
+#include <glib.h>
+
+#include <wiretap/wtap.h>
+
+#include <ui/clopts_common.h>
+#include <ui/cmdarg_err.h>
+#include <wsutil/buffer.h>
+#include <wsutil/file_util.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/privileges.h>
+#include <wsutil/time_util.h>
+#include <cli_main.h>
+#include <version_info.h>
+
+#ifdef HAVE_PLUGINS
+#include <wsutil/plugins.h>
+#endif
+
+#include <wsutil/report_message.h>
+#include <wsutil/str_util.h>
+
+#include "ui/failure_message.h"
+
+/* The result of benchmarking one file with one buffer size */
+typedef struct {
+  const char *filename;
+  const char *file_type;
+  const char *compression;
+  guint       buffer_size;
+  gint64      file_size;
+  guint64     records;
+  guint64     data_bytes;         /* sum of the records' captured lengths */
+  guint64     seq_ns;             /* fastest sequential pass */
+  guint64     random_reads;
+  guint64     random_ns;
+  wtap_reader_stats seq_stats;    /* of the fastest sequential pass */
+  wtap_reader_stats random_stats;
+} bench_result_t;
+
+static void
+print_usage(FILE *output)
+{
+  fprintf(output, "\n");
+  fprintf(output, "Usage: wtapbench [options] <infile> ...\n");
+  fprintf(output, "\n");
+  fprintf(output, "Options:\n");
+  fprintf(output, "  -b <size>   read with an input buffer of this many bytes; may be repeated\n");
+  fprintf(output, "              to compare sizes (default: the file system's block size)\n");
+  fprintf(output, "  -n <count>  number of sequential passes; the fastest is kept (default 3)\n");
+  fprintf(output, "  -r <count>  number of random reads with wtap_seek_read() (default: one\n");
+  fprintf(output, "              per record; 0 skips the random access test)\n");
+  fprintf(output, "  -s <seed>   seed for the order of the random reads (default 1)\n");
+  fprintf(output, "  -h, --help  display this help and exit\n");
+  fprintf(output, "  -v, --version  display version info and exit\n");
+}
+
+/*
+ * Report an error in command-line arguments.
+ */
+static void
+wtapbench_cmdarg_err(const char *msg_format, va_list ap)
+{
+  fprintf(stderr, "wtapbench: ");
+  vfprintf(stderr, msg_format, ap);
+  fprintf(stderr, "\n");
+}
+
+/*
+ * Report additional information for an error in command-line arguments.
+ */
+static void
+wtapbench_cmdarg_err_cont(const char *msg_format, va_list ap)
+{
+  vfprintf(stderr, msg_format, ap);
+  fprintf(stderr, "\n");
+}
+
+static double
+rate(guint64 count, guint64 ns)
+{
+  return ns ? (double)count * 1e9 / ns : 0.0;
+}
+
+static void
+print_reader_stats(const char *handle, const wtap_reader_stats *stats)
+{
+  printf("  %s reader:\n", handle);
+  printf("    Buffer size:      %u%s\n", stats->buffer_size,
+         stats->mapped ? " (memory-mapped)" : "");
+  printf("    Reads:            %" G_GUINT64_FORMAT " (%" G_GUINT64_FORMAT " bytes)\n",
+         stats->raw_reads, stats->raw_bytes);
+  printf("    Fast seek points: %u\n", stats->fast_seek_points);
+  if (stats->seeks == 0)
+    return;
+  printf("    Seeks:            %" G_GUINT64_FORMAT "\n", stats->seeks);
+  printf("      in buffer:      %" G_GUINT64_FORMAT "\n", stats->seeks_buffered);
+  printf("      fast seek:      %" G_GUINT64_FORMAT "\n", stats->seeks_fast);
+  printf("      direct:         %" G_GUINT64_FORMAT "\n", stats->seeks_direct);
+  printf("      rewind:         %" G_GUINT64_FORMAT "\n", stats->seeks_rewind);
+  printf("      read forward:   %" G_GUINT64_FORMAT "\n", stats->seeks_forward);
+  printf("    Bytes skipped:    %" G_GUINT64_FORMAT "\n", stats->skipped_bytes);
+}
+
+static void
+print_result(const bench_result_t *res)
+{
+  printf("%s: %s, %s\n", res->filename, res->file_type, res->compression);
+  printf("  File size:          %" G_GINT64_FORMAT " bytes\n", res->file_size);
+  printf("  Records:            %" G_GUINT64_FORMAT " (%" G_GUINT64_FORMAT " bytes of data)\n",
+         res->records, res->data_bytes);
+  printf("  Sequential:         %.3f s, %.1f MB/s of file, %.0f records/s\n",
+         res->seq_ns / 1e9, rate(res->file_size, res->seq_ns) / 1e6,
+         rate(res->records, res->seq_ns));
+  if (res->random_reads > 0)
+    printf("  Random:             %.3f s, %.0f reads/s, %.2f us/read\n",
+           res->random_ns / 1e9, rate(res->random_reads, res->random_ns),
+           res->random_ns / 1e3 / res->random_reads);
+  print_reader_stats("Sequential", &res->seq_stats);
+  if (res->random_reads > 0)
+    print_reader_stats("Random access", &res->random_stats);
+  printf("\n");
+}
+
+/* Shuffles the record offsets with a Fisher-Yates shuffle */
+static void
+shuffle_offsets(GArray *offsets, guint32 seed)
+{
+  GRand *rand = g_rand_new_with_seed(seed);
+  guint i;
+
+  for (i = offsets->len; i > 1; i--) {
+    guint j = (guint)g_rand_int_range(rand, 0, (gint32)i);
+    gint64 tmp = g_array_index(offsets, gint64, i - 1);
+
+    g_array_index(offsets, gint64, i - 1) = g_array_index(offsets, gint64, j);
+    g_array_index(offsets, gint64, j) = tmp;
+  }
+  g_rand_free(rand);
+}
+
+/*
+ * Reads the file sequentially passes times, and then at random from the
+ * last pass's handle, which has the fast seek points built by that pass.
+ */
+static gboolean
+bench_file(const char *filename, int passes, gint64 random_count,
+           guint32 seed, bench_result_t *res)
+{
+  wtap     *wth = NULL;
+  wtap_rec  rec;
+  Buffer    buf;
+  int       err = 0;
+  gchar    *err_info = NULL;
+  gint64    data_offset;
+  GArray   *offsets;
+  guint64   start;
+  guint64   elapsed;
+  int       pass;
+  gint64    i;
+  gboolean  ok = TRUE;
+
+  res->filename = filename;
+  offsets = g_array_new(FALSE, FALSE, sizeof(gint64));
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+
+  for (pass = 0; pass < passes && ok; pass++) {
+    if (wth != NULL)
+      wtap_close(wth);
+    wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (wth == NULL) {
+      cfile_open_failure_message(filename, err, err_info);
+      ok = FALSE;
+      break;
+    }
+
+    res->records = 0;
+    res->data_bytes = 0;
+    g_array_set_size(offsets, 0);
+    start = get_monotonic_ns();
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+      res->records++;
+      if (rec.rec_type == REC_TYPE_PACKET)
+        res->data_bytes += rec.rec_header.packet_header.caplen;
+      g_array_append_val(offsets, data_offset);
+    }
+    elapsed = get_monotonic_ns() - start;
+    if (err != 0) {
+      cfile_read_failure_message(filename, err, err_info);
+      ok = FALSE;
+      break;
+    }
+    if (pass == 0 || elapsed < res->seq_ns) {
+      res->seq_ns = elapsed;
+      wtap_get_reader_stats(wth, FALSE, &res->seq_stats);
+    }
+  }
+
+  if (ok) {
+    res->file_type = wtap_file_type_subtype_name(wtap_file_type_subtype(wth));
+    res->compression = wtap_compression_type_description(wtap_get_compression_type(wth));
+    res->file_size = wtap_file_size(wth, &err);
+    res->buffer_size = res->seq_stats.buffer_size;
+
+    if (random_count < 0 || random_count > (gint64)offsets->len)
+      random_count = offsets->len;
+    shuffle_offsets(offsets, seed);
+    start = get_monotonic_ns();
+    for (i = 0; i < random_count; i++) {
+      if (!wtap_seek_read(wth, g_array_index(offsets, gint64, i), &rec, &buf,
+                          &err, &err_info)) {
+        cfile_read_failure_message(filename, err, err_info);
+        ok = FALSE;
+        break;
+      }
+    }
+    res->random_ns = get_monotonic_ns() - start;
+    res->random_reads = i;
+    wtap_get_reader_stats(wth, TRUE, &res->random_stats);
+  }
+
+  if (wth != NULL)
+    wtap_close(wth);
+  ws_buffer_free(&buf);
+  wtap_rec_cleanup(&rec);
+  g_array_free(offsets, TRUE);
+  return ok;
+}
+
+int
+main(int argc, char *argv[])
+{
+  char  *init_progfile_dir_error;
+  static const struct report_message_routines wtapbench_report_routines = {
+      failure_message,
+      failure_message,
+      open_failure_message,
+      read_failure_message,
+      write_failure_message,
+      cfile_open_failure_message,
+      cfile_dump_open_failure_message,
+      cfile_read_failure_message,
+      cfile_write_failure_message,
+      cfile_close_failure_message
+  };
+  int      opt;
+  int      passes = 3;
+  gint64   random_count = -1;
+  guint32  seed = 1;
+  GArray  *buffer_sizes;
+  GArray  *results;
+  guint    b, r;
+  int      i;
+  int      overall_error_status = 0;
+  static const struct option long_options[] = {
+      {"help", no_argument, NULL, 'h'},
+      {"version", no_argument, NULL, 'v'},
+      {0, 0, 0, 0 }
+  };
+
+  /*
+   * Set the C-language locale to the native environment and set the
+   * code page to UTF-8 on Windows.
+   */
+#ifdef _WIN32
+  setlocale(LC_ALL, ".UTF-8");
+#else
+  setlocale(LC_ALL, "");
+#endif
+
+  cmdarg_err_init(wtapbench_cmdarg_err, wtapbench_cmdarg_err_cont);
+
+  /* Initialize the version information. */
+  ws_init_version_info("Wtapbench (Wireshark)", NULL, NULL, NULL);
+
+  /*
+   * Get credential information for later use.
+   */
+  init_process_policies();
+
+  /*
+   * Attempt to get the pathname of the directory containing the
+   * executable file.
+   */
+  init_progfile_dir_error = init_progfile_dir(argv[0]);
+  if (init_progfile_dir_error != NULL) {
+    fprintf(stderr,
+            "wtapbench: Can't get pathname of directory containing the wtapbench program: %s.\n",
+            init_progfile_dir_error);
+    g_free(init_progfile_dir_error);
+  }
+
+  init_report_message("wtapbench", &wtapbench_report_routines);
+
+  wtap_init(TRUE);
+
+  buffer_sizes = g_array_new(FALSE, FALSE, sizeof(guint));
+
+  /* Process the options */
+  while ((opt = getopt_long(argc, argv, "b:hn:r:s:v", long_options, NULL)) !=-1) {
+
+    switch (opt) {
+
+      case 'b':
+        {
+          guint size = get_positive_int(optarg, "buffer size");
+
+          g_array_append_val(buffer_sizes, size);
+        }
+        break;
+
+      case 'h':
+        show_help_header("Measure how fast capture files are read.");
+        print_usage(stdout);
+        exit(0);
+        break;
+
+      case 'n':
+        passes = get_positive_int(optarg, "number of passes");
+        break;
+
+      case 'r':
+        random_count = get_natural_int(optarg, "number of random reads");
+        break;
+
+      case 's':
+        seed = get_natural_int(optarg, "seed");
+        break;
+
+      case 'v':
+        show_version();
+        exit(0);
+        break;
+
+      case '?':              /* Bad flag - print usage message */
+        print_usage(stderr);
+        exit(1);
+        break;
+    }
+  }
+
+  if (optind >= argc) {
+    print_usage(stderr);
+    return 1;
+  }
+
+  /* 0 means "whatever the file wrappers pick" */
+  if (buffer_sizes->len == 0) {
+    guint size = 0;
+
+    g_array_append_val(buffer_sizes, size);
+  }
+
+  results = g_array_new(FALSE, TRUE, sizeof(bench_result_t));
+  for (i = optind; i < argc; i++) {
+    for (b = 0; b < buffer_sizes->len; b++) {
+      guint size = g_array_index(buffer_sizes, guint, b);
+      bench_result_t res;
+
+      if (size != 0) {
+        char *size_str = g_strdup_printf("%u", size);
+
+        g_setenv("WIRESHARK_WTAP_READ_BUFFER", size_str, TRUE);
+        g_free(size_str);
+      } else {
+        g_unsetenv("WIRESHARK_WTAP_READ_BUFFER");
+      }
+
+      memset(&res, 0, sizeof res);
+      if (!bench_file(argv[i], passes, random_count, seed, &res)) {
+        overall_error_status = 2;
+        continue;
+      }
+      print_result(&res);
+      g_array_append_val(results, res);
+    }
+  }
+
+  /*
+   * With more than one run, line them up for comparison; "Cheap %" is
+   * the share of random seeks that didn't have to read their way to the
+   * record.
+   */
+  if (results->len > 1) {
+    printf("%-30s %-12s %8s %10s %12s %10s %7s\n",
+           "File", "Compression", "Buffer", "Seq MB/s", "Records/s", "us/random", "Cheap %");
+    for (r = 0; r < results->len; r++) {
+      const bench_result_t *res = &g_array_index(results, bench_result_t, r);
+      const wtap_reader_stats *rnd = &res->random_stats;
+
+      printf("%-30s %-12s %8u %10.1f %12.0f %10.2f %7.1f\n",
+             res->filename, res->compression, res->buffer_size,
+             rate(res->file_size, res->seq_ns) / 1e6,
+             rate(res->records, res->seq_ns),
+             res->random_reads ? res->random_ns / 1e3 / res->random_reads : 0.0,
+             rnd->seeks ? 100.0 * (rnd->seeks_buffered + rnd->seeks_fast + rnd->seeks_direct) / rnd->seeks : 0.0);
+    }
+  }
+
+  g_array_free(results, TRUE);
+  g_array_free(buffer_sizes, TRUE);
+  wtap_cleanup();
+  free_progdirs();
+  return overall_error_status;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 2
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=2 tabstop=8 expandtab:
+ * :indentSize=2:tabSize=8:noTabs=true:
+ */